@@ -4,11 +4,22 @@ import random
 import enum
 
 CURRENT_REQUEST_VERSION = 1
-MAX_REQUEST_DATA_SIZE = 32
+MAX_REQUEST_DATA_SIZE = 0x8000
 
 class RequestType(enum.IntEnum):
     ReadMemory = 1,
-    WriteMemory = 2
+    WriteMemory = 2,
+    ReadFrameCounters = 3,
+    ReadFrameCounterName = 4,
+    ReadMemoryBatch = 5,
+    WriteMemoryBatch = 6,
+    AdvanceFrames = 7,
+    SetInput = 8,
+    ReadFramebufferInfo = 9,
+    ReadFramebuffer = 10,
+    ReadMemoryUsage = 11,
+    ReadMemoryCategoryName = 12
+    SetFastForward = 13
 
 CITRA_PORT = "45987"
 
@@ -90,6 +101,197 @@ class Citra:
                 return False
         return True
 
+    def _send_batch(self, request_type, request_data):
+        request, request_id = self._generate_header(request_type, len(request_data))
+        request += request_data
+        self.socket.send(request)
+
+        raw_reply = self.socket.recv()
+        return self._read_and_validate_header(raw_reply, request_id, request_type)
+
+    def read_memory_batch(self, ranges):
+        """
+        Reads a list of (address, size) ranges with as few requests as possible, such as once per
+        frame, and returns the content of each range
+        >>> c.read_memory_batch([(0x100000, 4), (0x100000, 2)])
+        [b'\x07\x00\x00\xeb', b'\x07\x00']
+        """
+        result = []
+        pending = []
+        pending_size = 0
+
+        def flush():
+            request_data = b"".join(struct.pack("II", address, size) for address, size in pending)
+            reply_data = self._send_batch(RequestType.ReadMemoryBatch, request_data)
+            if reply_data is None:
+                return False
+            offset = 0
+            for _, size in pending:
+                result.append(reply_data[offset:offset + size])
+                offset += size
+            return True
+
+        for address, size in ranges:
+            if size > MAX_REQUEST_DATA_SIZE:
+                if pending and not flush():
+                    return None
+                pending, pending_size = [], 0
+                contents = self.read_memory(address, size)
+                if contents is None:
+                    return None
+                result.append(contents)
+                continue
+            if (pending_size + size > MAX_REQUEST_DATA_SIZE or
+                (len(pending) + 1) * 8 > MAX_REQUEST_DATA_SIZE):
+                if not flush():
+                    return None
+                pending, pending_size = [], 0
+            pending.append((address, size))
+            pending_size += size
+        if pending and not flush():
+            return None
+        return result
+
+    def write_memory_batch(self, writes):
+        """
+        Writes a list of (address, contents) pairs with as few requests as possible
+        >>> c.write_memory_batch([(0x100000, b"\xff\xff"), (0x100002, b"\xff\xff")])
+        True
+        >>> c.read_memory(0x100000, 4)
+        b'\xff\xff\xff\xff'
+        >>> c.write_memory_batch([(0x100000, b"\x07\x00\x00\xeb")])
+        True
+        """
+        request_data = b""
+        for address, contents in writes:
+            if len(contents) + 8 > MAX_REQUEST_DATA_SIZE:
+                if not self.write_memory(address, contents):
+                    return False
+                continue
+            if len(request_data) + len(contents) + 8 > MAX_REQUEST_DATA_SIZE:
+                if self._send_batch(RequestType.WriteMemoryBatch, request_data) is None:
+                    return False
+                request_data = b""
+            request_data += struct.pack("II", address, len(contents)) + contents
+        if request_data:
+            return self._send_batch(RequestType.WriteMemoryBatch, request_data) is not None
+        return True
+
+    def _request(self, request_type, address, size):
+        request_data = struct.pack("II", address, size)
+        request, request_id = self._generate_header(request_type, len(request_data))
+        request += request_data
+        self.socket.send(request)
+
+        raw_reply = self.socket.recv()
+        return self._read_and_validate_header(raw_reply, request_id, request_type)
+
+    def read_frame_counters(self):
+        """
+        Returns the counts of the last emulated frame, such as draws or SVC calls, by counter name
+        >>> "OpenGL/Draws" in c.read_frame_counters()
+        True
+        """
+        names = []
+        while True:
+            name = self._request(RequestType.ReadFrameCounterName, len(names),
+                                 MAX_REQUEST_DATA_SIZE)
+            if not name:
+                break
+            names.append(name.decode("utf-8"))
+
+        values = []
+        while len(values) < len(names):
+            reply_data = self._request(RequestType.ReadFrameCounters, len(values),
+                                       MAX_REQUEST_DATA_SIZE)
+            if not reply_data:
+                break
+            values += struct.unpack("%dQ" % (len(reply_data) // 8), reply_data)
+
+        return dict(zip(names, values))
+
+    def advance_frames(self, frame_count=1):
+        """
+        Emulates frame_count frames and holds emulation, or resumes it when frame_count is 0.
+        Returns the number of frames done.
+        >>> c.advance_frames(2)
+        2
+        >>> c.advance_frames(0)
+        0
+        """
+        reply_data = self._request(RequestType.AdvanceFrames, frame_count, 0)
+        return struct.unpack("I", reply_data)[0] if reply_data else 0
+
+    def set_input(self, buttons=0, circle_pad=(0, 0), touch=None):
+        """
+        Replaces the console input until called with None as buttons. buttons is a HID PadState
+        bit mask, touch the pressed (x, y) position on the bottom screen.
+        >>> c.set_input(0x1)
+        True
+        >>> c.set_input(None)
+        True
+        """
+        flags = 0 if buttons is None else 1
+        touch_x, touch_y = (0, 0)
+        if touch is not None:
+            flags |= 2
+            touch_x, touch_y = touch
+        request_data = struct.pack("IIhhHH", flags, buttons or 0, circle_pad[0], circle_pad[1],
+                                   touch_x, touch_y)
+        return self._send_batch(RequestType.SetInput, request_data) is not None
+
+    def set_fast_forward(self, enabled):
+        """
+        Runs emulation as fast as the host allows while enabled, presenting fewer frames and
+        dropping the audio
+        >>> c.set_fast_forward(True)
+        True
+        >>> c.set_fast_forward(False)
+        True
+        """
+        return self._request(RequestType.SetFastForward, 1 if enabled else 0, 0) is not None
+
+    def read_framebuffer(self, screen=0):
+        """
+        Returns the (format, width, height, stride, data) of the framebuffer displayed on the top
+        (0) or bottom (1) screen. The data is current while frames are advanced.
+        >>> c.read_framebuffer(0)[1:3]
+        (240, 400)
+        """
+        info = self._request(RequestType.ReadFramebufferInfo, screen, 0)
+        if not info:
+            return None
+        _, pixel_format, width, height, stride = struct.unpack("5I", info)
+        data = bytes()
+        while len(data) < stride * height:
+            size = min(stride * height - len(data), MAX_REQUEST_DATA_SIZE)
+            request_data = struct.pack("III", screen, size, len(data))
+            reply_data = self._send_batch(RequestType.ReadFramebuffer, request_data)
+            if not reply_data:
+                return None
+            data += reply_data
+        return (pixel_format, width, height, stride, data)
+
+    def read_memory_usage(self):
+        """
+        Returns the host memory used by the emulator, in bytes by category
+        >>> c.read_memory_usage()["Guest memory"] > 0
+        True
+        """
+        names = []
+        while True:
+            name = self._request(RequestType.ReadMemoryCategoryName, len(names),
+                                 MAX_REQUEST_DATA_SIZE)
+            if not name:
+                break
+            names.append(name.decode("utf-8"))
+
+        reply_data = self._request(RequestType.ReadMemoryUsage, 0, MAX_REQUEST_DATA_SIZE)
+        if not reply_data:
+            return None
+        values = struct.unpack("%dQ" % (len(reply_data) // 8), reply_data)
+        return dict(zip(names, values))
+
 if "__main__" == __name__:
     import doctest
     doctest.testmod(extraglobs={'c': Citra()})
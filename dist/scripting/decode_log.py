@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Converts a binary log written with log_binary enabled back to the text log format.
+# Usage: decode_log.py citra_log.bin [output.txt]
+
+import struct
+import sys
+
+BINARY_LOG_MAGIC = 0x474F4C43
+BINARY_LOG_VERSION = 1
+
+RECORD_CLASS_NAME = 1
+RECORD_LOCATION = 2
+RECORD_MESSAGE = 3
+
+LEVEL_NAMES = ["Trace", "Debug", "Info", "Warning", "Error", "Critical"]
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def at_end(self):
+        return self.offset >= len(self.data)
+
+    def read(self, fmt):
+        values = struct.unpack_from("<" + fmt, self.data, self.offset)
+        self.offset += struct.calcsize("<" + fmt)
+        return values[0] if len(values) == 1 else values
+
+    def read_string(self, size_fmt):
+        size = self.read(size_fmt)
+        string = self.data[self.offset:self.offset + size]
+        self.offset += size
+        return string.decode("utf-8", errors="replace")
+
+
+def decode(data, out):
+    reader = Reader(data)
+    magic, version = reader.read("II")
+    if magic != BINARY_LOG_MAGIC or version != BINARY_LOG_VERSION:
+        raise ValueError("not a binary log, or an unsupported version")
+
+    class_names = {}
+    locations = {}
+    while not reader.at_end():
+        try:
+            record = reader.read("B")
+            if record == RECORD_CLASS_NAME:
+                log_class = reader.read("B")
+                class_names[log_class] = reader.read_string("B")
+            elif record == RECORD_LOCATION:
+                location_id, line = reader.read("II")
+                filename = reader.read_string("H")
+                function = reader.read_string("H")
+                reader.read_string("H")  # format string, only useful for tools grouping messages
+                locations[location_id] = (filename, function, line)
+            elif record == RECORD_MESSAGE:
+                timestamp, log_class, level, location_id = reader.read("QBBI")
+                message = reader.read_string("I")
+                filename, function, line = locations[location_id]
+                out.write("[{:4d}.{:06d}] {} <{}> {}:{}:{}: {}\n".format(
+                    timestamp // 1000000, timestamp % 1000000,
+                    class_names.get(log_class, "Unknown"),
+                    LEVEL_NAMES[level] if level < len(LEVEL_NAMES) else "Invalid",
+                    filename, function, line, message))
+            else:
+                raise ValueError("invalid record type {}".format(record))
+        except struct.error:
+            # The log was cut off in the middle of a record, e.g. because of a crash
+            break
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit("Usage: {} citra_log.bin [output.txt]".format(sys.argv[0]))
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as out:
+            decode(data, out)
+    else:
+        decode(data, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
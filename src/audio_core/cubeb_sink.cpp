@@ -9,11 +9,14 @@
 #include "audio_core/audio_types.h"
 #include "audio_core/cubeb_sink.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
 struct CubebSink::Impl {
     unsigned int sample_rate = 0;
+    u32 latency = 0;
 
     cubeb* ctx = nullptr;
     cubeb_stream* stream = nullptr;
@@ -66,9 +69,13 @@ CubebSink::CubebSink(std::string_view target_device_name) : impl(std::make_uniqu
         }
     }
 
+    // The low latency mode goes as low as the backend allows
+    const u32 latency_frames = Settings::values.enable_low_latency_audio
+                                   ? minimum_latency
+                                   : std::max(512u, minimum_latency);
     int stream_err = cubeb_stream_init(impl->ctx, &impl->stream, "CitraAudio", nullptr, nullptr,
-                                       output_device, &params, std::max(512u, minimum_latency),
-                                       &Impl::DataCallback, &Impl::StateCallback, impl.get());
+                                       output_device, &params, latency_frames, &Impl::DataCallback,
+                                       &Impl::StateCallback, impl.get());
     if (stream_err != CUBEB_OK) {
         switch (stream_err) {
         case CUBEB_ERROR:
@@ -89,6 +96,11 @@ CubebSink::CubebSink(std::string_view target_device_name) : impl(std::make_uniqu
         LOG_CRITICAL(Audio_Sink, "Error starting cubeb stream");
         return;
     }
+
+    if (cubeb_stream_get_latency(impl->stream, &impl->latency) != CUBEB_OK) {
+        impl->latency = latency_frames;
+    }
+    LOG_INFO(Audio_Sink, "Cubeb stream latency: {} frames", impl->latency);
 }
 
 CubebSink::~CubebSink() {
@@ -117,8 +129,15 @@ void CubebSink::SetCallback(std::function<void(s16*, std::size_t)> cb) {
     impl->cb = cb;
 }
 
+std::size_t CubebSink::GetBufferedSamples() const {
+    return impl->latency;
+}
+
 long CubebSink::Impl::DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
                                    void* output_buffer, long num_frames) {
+    // cubeb calls back on a thread of its own
+    thread_local Common::ScopedThreadRole thread_role{Common::ThreadRole::Audio};
+
     Impl* impl = static_cast<Impl*>(user_data);
     s16* buffer = reinterpret_cast<s16*>(output_buffer);
 
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/sink.h"
@@ -36,21 +37,66 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+void DspInterface::EnableLowLatency(bool enable) {
+    low_latency = enable;
+}
+
+void DspInterface::EnableDropping(bool enable) {
+    dropping = enable;
+}
+
 void DspInterface::OutputFrame(StereoFrame16& frame) {
-    if (!sink)
+    if (!sink || dropping)
         return;
 
     fifo.Push(frame.data(), frame.size());
 }
 
 void DspInterface::OutputSample(std::array<s16, 2> sample) {
-    if (!sink)
+    if (!sink || dropping)
         return;
 
     fifo.Push(&sample, 1);
 }
 
+void DspInterface::TrimFifo(std::size_t num_frames) {
+    // Dropping samples is audible, so the FIFO may exceed the target a little before it happens
+    const std::size_t sample_rate = sink->GetNativeSampleRate();
+    const std::size_t slack = sample_rate * 5 / 1000;
+    const std::size_t target = static_cast<std::size_t>(fifo_target) + num_frames;
+    const std::size_t size = fifo.Size();
+    if (size > target + slack) {
+        fifo.Pop(size - target);
+    }
+}
+
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
+    // Total latency the low latency mode aims for, and the bounds of its FIFO target
+    constexpr double low_latency_target_ms = 20.0;
+    constexpr double min_fifo_target_ms = 2.0;
+    constexpr double max_fifo_target_ms = 50.0;
+
+    const bool use_low_latency = low_latency;
+    time_stretcher.SetLowLatency(use_low_latency);
+    const double sample_rate = sink->GetNativeSampleRate();
+
+    if (dropping) {
+        // Plays silence instead of the samples queued before dropping started, so that the output
+        // resumes without a backlog
+        fifo.Pop();
+        time_stretcher.Clear();
+        last_frame = {};
+        std::fill_n(buffer, num_frames * 2, s16{0});
+        output_latency_ms.store(sink->GetBufferedSamples() * 1000.0 / sample_rate,
+                                std::memory_order_relaxed);
+        return;
+    }
+    if (use_low_latency && fifo_target == 0.0) {
+        const double sink_ms = sink->GetBufferedSamples() * 1000.0 / sample_rate;
+        fifo_target = std::max(low_latency_target_ms - sink_ms, min_fifo_target_ms) *
+                      sample_rate / 1000.0;
+    }
+
     std::size_t frames_written;
     if (perform_time_stretching) {
         const std::vector<s16> in{fifo.Pop()};
@@ -62,9 +108,30 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
         frames_written += fifo.Pop(buffer, num_frames - frames_written);
         flushing_time_stretcher = false;
     } else {
+        if (use_low_latency) {
+            TrimFifo(num_frames);
+        }
         frames_written = fifo.Pop(buffer, num_frames);
     }
 
+    if (use_low_latency) {
+        if (frames_written < num_frames) {
+            // Underrun, leave more room for the next frames
+            fifo_target += num_frames / 2.0;
+        } else {
+            // Lose 1 ms of target per second of output
+            fifo_target -= num_frames / 1000.0;
+        }
+        fifo_target = std::clamp(fifo_target, min_fifo_target_ms * sample_rate / 1000.0,
+                                 max_fifo_target_ms * sample_rate / 1000.0);
+    } else {
+        fifo_target = 0.0;
+    }
+
+    const std::size_t buffered = fifo.Size() + time_stretcher.GetBacklog() +
+                                 sink->GetBufferedSamples();
+    output_latency_ms.store(buffered * 1000.0 / sample_rate, std::memory_order_relaxed);
+
     if (frames_written > 0) {
         std::memcpy(&last_frame[0], buffer + 2 * (frames_written - 1), 2 * sizeof(s16));
     }
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "audio_core/audio_types.h"
 #include "audio_core/time_stretch.h"
 #include "common/common_types.h"
+#include "common/memory_usage.h"
 #include "common/ring_buffer.h"
 #include "core/memory.h"
 
@@ -100,6 +102,16 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Enable/Disable the low latency output mode.
+    void EnableLowLatency(bool enable);
+    /// Enable/Disable dropping the output, used while fast-forwarding as the audio is produced
+    /// faster than it can be played
+    void EnableDropping(bool enable);
+    /// Latency between the emulated DSP output and the speakers measured by the last sink
+    /// callback (Units: milliseconds)
+    double GetOutputLatency() const {
+        return output_latency_ms.load(std::memory_order_relaxed);
+    }
 
 protected:
     void OutputFrame(StereoFrame16& frame);
@@ -108,11 +120,21 @@ protected:
 private:
     void FlushResidualStretcherAudio();
     void OutputCallback(s16* buffer, std::size_t num_frames);
+    /// Drops the oldest samples of the FIFO that exceed the latency target of the low latency mode
+    void TrimFifo(std::size_t num_frames);
 
     std::unique_ptr<Sink> sink;
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
+    std::atomic<bool> low_latency = false;
+    std::atomic<bool> dropping = false;
+    std::atomic<double> output_latency_ms = 0.0;
+    /// Samples the low latency mode keeps in the FIFO, grows after underruns and slowly shrinks
+    /// back otherwise. Only used by the sink callback.
+    double fifo_target = 0.0;
     Common::RingBuffer<s16, 0x2000, 2> fifo;
+    Common::ScopedMemoryUsage fifo_memory_usage{Common::MemoryCategory::AudioBuffers,
+                                                sizeof(fifo)};
     std::array<s16, 2> last_frame{};
     TimeStretcher time_stretcher;
 };
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "audio_core/audio_types.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/hle.h"
@@ -11,8 +14,10 @@
 #include "audio_core/sink.h"
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/frame_counters.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 
@@ -23,9 +28,11 @@ namespace AudioCore {
 
 static constexpr u64 audio_frame_ticks = 1310252ull; ///< Units: ARM11 cycles
 
+static const Common::FrameCounter audio_frame_counter("DSP/Audio Frames");
+
 struct DspHle::Impl final {
 public:
-    explicit Impl(DspHle& parent, Memory::MemorySystem& memory);
+    Impl(DspHle& parent, Memory::MemorySystem& memory, bool multithread);
     ~Impl();
 
     DspState GetDspState() const;
@@ -49,10 +56,16 @@ private:
     HLE::SharedMemory& ReadRegion();
     HLE::SharedMemory& WriteRegion();
 
+    template <typename ReadRegionType, typename WriteRegionType>
+    StereoFrame16 GenerateFrame(ReadRegionType& read, WriteRegionType& write);
     StereoFrame16 GenerateCurrentFrame();
     bool Tick();
     void AudioTickCallback(s64 cycles_late);
 
+    /// Hands the current frame over to audio_thread, see Impl::Tick
+    void QueueFrame();
+    void AudioThreadLoop();
+
     DspState dsp_state = DspState::Off;
     std::array<std::vector<u8>, num_dsp_pipe> pipe_data;
 
@@ -70,9 +83,37 @@ private:
     Core::TimingEventType* tick_event;
 
     std::weak_ptr<DSP_DSP> dsp_dsp;
+
+    /// The parts of the shared memory that generating a frame reads
+    struct FrameInput {
+        HLE::SourceConfiguration source_configurations;
+        HLE::AdpcmCoefficients adpcm_coefficients;
+        HLE::DspConfiguration dsp_configuration;
+        HLE::IntermediateMixSamples intermediate_mix_samples;
+    };
+
+    /// The parts of the shared memory that generating a frame writes
+    struct FrameOutput {
+        HLE::SourceStatus source_statuses;
+        HLE::DspStatus dsp_status;
+        HLE::IntermediateMixSamples intermediate_mix_samples;
+        HLE::FinalMixSamples final_samples;
+    };
+
+    const bool multithread;
+    std::thread audio_thread;
+    std::mutex frame_mutex;
+    std::condition_variable frame_queued;
+    std::condition_variable frame_done;
+    bool frame_pending = false;
+    bool has_frame_output = false;
+    bool stopping = false;
+    FrameInput frame_input;
+    FrameOutput frame_output;
 };
 
-DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(parent_) {
+DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory, bool multithread)
+    : parent(parent_), multithread(multithread) {
     dsp_memory.raw_memory.fill(0);
 
     for (auto& source : sources) {
@@ -85,11 +126,24 @@ DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(paren
             this->AudioTickCallback(cycles_late);
         });
     timing.ScheduleEvent(audio_frame_ticks, tick_event);
+
+    if (multithread) {
+        audio_thread = std::thread([this] { AudioThreadLoop(); });
+    }
 }
 
 DspHle::Impl::~Impl() {
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     timing.UnscheduleEvent(tick_event, 0);
+
+    if (multithread) {
+        {
+            std::lock_guard<std::mutex> lock(frame_mutex);
+            stopping = true;
+        }
+        frame_queued.notify_one();
+        audio_thread.join();
+    }
 }
 
 DspState DspHle::Impl::GetDspState() const {
@@ -307,10 +361,8 @@ HLE::SharedMemory& DspHle::Impl::WriteRegion() {
     return CurrentRegionIndex() != 0 ? dsp_memory.region_0 : dsp_memory.region_1;
 }
 
-StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
-    HLE::SharedMemory& read = ReadRegion();
-    HLE::SharedMemory& write = WriteRegion();
-
+template <typename ReadRegionType, typename WriteRegionType>
+StereoFrame16 DspHle::Impl::GenerateFrame(ReadRegionType& read, WriteRegionType& write) {
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
     // Generate intermediate mixes
@@ -338,12 +390,80 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
     return output_frame;
 }
 
+StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
+    return GenerateFrame(ReadRegion(), WriteRegion());
+}
+
+void DspHle::Impl::QueueFrame() {
+    std::unique_lock<std::mutex> lock(frame_mutex);
+    frame_done.wait(lock, [this] { return !frame_pending; });
+
+    // The application gets the results of the previous frame
+    if (has_frame_output) {
+        HLE::SharedMemory& write = WriteRegion();
+        write.source_statuses = frame_output.source_statuses;
+        write.dsp_status = frame_output.dsp_status;
+        write.intermediate_mix_samples = frame_output.intermediate_mix_samples;
+        write.final_samples = frame_output.final_samples;
+    }
+
+    HLE::SharedMemory& read = ReadRegion();
+    frame_input.source_configurations = read.source_configurations;
+    frame_input.adpcm_coefficients = read.adpcm_coefficients;
+    frame_input.dsp_configuration = read.dsp_configuration;
+    frame_input.intermediate_mix_samples = read.intermediate_mix_samples;
+
+    // Acknowledge the configuration changes like Source::ParseConfig and Mixers::ParseConfig
+    // would, since they only get to see the copy
+    for (auto& config : read.source_configurations.config) {
+        if (config.buffer_queue_dirty) {
+            config.buffers_dirty = 0;
+        }
+        config.dirty_raw = 0;
+    }
+    read.dsp_configuration.dirty_raw = 0;
+
+    frame_pending = true;
+    has_frame_output = true;
+    lock.unlock();
+    frame_queued.notify_one();
+}
+
+void DspHle::Impl::AudioThreadLoop() {
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::Audio};
+    std::unique_lock<std::mutex> lock(frame_mutex);
+    while (true) {
+        frame_queued.wait(lock, [this] { return frame_pending || stopping; });
+        if (stopping) {
+            return;
+        }
+
+        // frame_input and frame_output are left alone by QueueFrame while a frame is pending
+        lock.unlock();
+        StereoFrame16 current_frame = GenerateFrame(frame_input, frame_output);
+        audio_frame_counter.Add();
+        parent.OutputFrame(current_frame);
+        lock.lock();
+
+        frame_pending = false;
+        frame_done.notify_one();
+    }
+}
+
 bool DspHle::Impl::Tick() {
+    // Source decoding, mixing and the output to the sink happen on audio_thread, in parallel with
+    // the emulation of the next frame
+    if (multithread) {
+        QueueFrame();
+        return true;
+    }
+
     StereoFrame16 current_frame = {};
 
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
     // shared memory region)
     current_frame = GenerateCurrentFrame();
+    audio_frame_counter.Add();
 
     parent.OutputFrame(current_frame);
 
@@ -365,7 +485,8 @@ void DspHle::Impl::AudioTickCallback(s64 cycles_late) {
     timing.ScheduleEvent(audio_frame_ticks - cycles_late, tick_event);
 }
 
-DspHle::DspHle(Memory::MemorySystem& memory) : impl(std::make_unique<Impl>(*this, memory)) {}
+DspHle::DspHle(Memory::MemorySystem& memory, bool multithread)
+    : impl(std::make_unique<Impl>(*this, memory, multithread)) {}
 DspHle::~DspHle() = default;
 
 u16 DspHle::RecvData(u32 register_number) {
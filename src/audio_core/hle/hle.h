@@ -21,7 +21,11 @@ namespace AudioCore {
 
 class DspHle final : public DspInterface {
 public:
-    explicit DspHle(Memory::MemorySystem& memory);
+    /**
+     * @param multithread whether audio frames are generated on a separate thread, which delays
+     * the source statuses the application sees by one frame
+     */
+    DspHle(Memory::MemorySystem& memory, bool multithread);
     ~DspHle();
 
     u16 RecvData(u32 register_number) override;
@@ -4,6 +4,11 @@
 
 #include <algorithm>
 #include <cstddef>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -85,6 +90,68 @@ void Mixers::ParseConfig(DspConfiguration& config) {
     config.dirty_raw = 0;
 }
 
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+/**
+ * Vectorized downmix of four samples at a time, producing the same results as the scalar version
+ * below: the additions happen in the same order and the conversions truncate and saturate alike.
+ */
+static void DownmixAndMixFrameSimd(bool mono, float gain, const QuadFrame32& samples,
+                                   StereoFrame16& frame) {
+    static_assert(samples_per_frame % 4 == 0);
+
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+#if defined(ARCHITECTURE_x86_64)
+        const auto load = [&](std::size_t sample) {
+            const auto* quad = reinterpret_cast<const __m128i*>(samples[sample].data());
+            return _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(quad)), _mm_set1_ps(gain));
+        };
+        __m128 channel0 = load(i);
+        __m128 channel1 = load(i + 1);
+        __m128 channel2 = load(i + 2);
+        __m128 channel3 = load(i + 3);
+        // Each register now holds one channel of the four samples
+        _MM_TRANSPOSE4_PS(channel0, channel1, channel2, channel3);
+
+        __m128i left, right;
+        if (mono) {
+            const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(channel0, channel1), channel2),
+                                          channel3);
+            left = right = _mm_cvttps_epi32(_mm_mul_ps(sum, _mm_set1_ps(0.5f)));
+        } else {
+            left = _mm_cvttps_epi32(_mm_add_ps(channel0, channel2));
+            right = _mm_cvttps_epi32(_mm_add_ps(channel1, channel3));
+        }
+        const __m128i mixed =
+            _mm_packs_epi32(_mm_unpacklo_epi32(left, right), _mm_unpackhi_epi32(left, right));
+
+        auto* const dest = reinterpret_cast<__m128i*>(&frame[i]);
+        _mm_storeu_si128(dest, _mm_adds_epi16(_mm_loadu_si128(dest), mixed));
+#elif defined(ARCHITECTURE_ARM64)
+        // Loads each channel of the four samples into its own register
+        const int32x4x4_t quad = vld4q_s32(samples[i].data());
+        const float32x4_t channel0 = vmulq_n_f32(vcvtq_f32_s32(quad.val[0]), gain);
+        const float32x4_t channel1 = vmulq_n_f32(vcvtq_f32_s32(quad.val[1]), gain);
+        const float32x4_t channel2 = vmulq_n_f32(vcvtq_f32_s32(quad.val[2]), gain);
+        const float32x4_t channel3 = vmulq_n_f32(vcvtq_f32_s32(quad.val[3]), gain);
+
+        int16x4_t left, right;
+        if (mono) {
+            const float32x4_t sum =
+                vaddq_f32(vaddq_f32(vaddq_f32(channel0, channel1), channel2), channel3);
+            left = right = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(sum, 0.5f)));
+        } else {
+            left = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(channel0, channel2)));
+            right = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(channel1, channel3)));
+        }
+
+        int16x4x2_t stereo = vld2_s16(frame[i].data());
+        stereo.val[0] = vqadd_s16(stereo.val[0], left);
+        stereo.val[1] = vqadd_s16(stereo.val[1], right);
+        vst2_s16(frame[i].data(), stereo);
+#endif
+    }
+}
+#else
 static s16 ClampToS16(s32 value) {
     return static_cast<s16>(std::clamp(value, -32768, 32767));
 }
@@ -94,12 +161,16 @@ static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
     return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
             ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
 }
+#endif
 
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
     switch (state.output_format) {
     case OutputFormat::Mono:
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+        DownmixAndMixFrameSimd(true, gain, samples, current_frame);
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -111,6 +182,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 // Mix into current frame
                 return AddAndClampToS16(accumulator, {mono, mono});
             });
+#endif
         return;
 
     case OutputFormat::Surround:
@@ -118,6 +190,9 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+        DownmixAndMixFrameSimd(false, gain, samples, current_frame);
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -128,6 +203,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 // Mix into current frame
                 return AddAndClampToS16(accumulator, {left, right});
             });
+#endif
         return;
     }
 
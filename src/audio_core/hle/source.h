@@ -5,14 +5,19 @@
 #pragma once
 
 #include <array>
-#include <vector>
+#include <future>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <utility>
+#include <vector>
 #include "audio_core/audio_types.h"
 #include "audio_core/codec.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/filter.h"
 #include "audio_core/interpolate.h"
 #include "common/common_types.h"
+#include "common/thread_pool.h"
 
 namespace Memory {
 class MemorySystem;
@@ -95,6 +100,22 @@ private:
         }
     };
 
+    /// Buffers shorter than this are cheap enough to decode when they start playing
+    static constexpr u32 predecode_min_samples = 2048;
+
+    /// The next buffer of the queue, decoded on the thread pool while the current one plays
+    struct PredecodedBuffer {
+        Buffer buffer;
+        /// Copy of the guest memory the buffer was decoded from
+        std::shared_ptr<const std::vector<u8>> encoded;
+        std::array<s16, 16> adpcm_coeffs;
+        Codec::ADPCMState adpcm_state;
+        /// The decoded samples and the ADPCM state after them
+        std::future<std::pair<AudioInterp::StereoBuffer16, Codec::ADPCMState>> decoded;
+        /// The task decoding the buffer, waited for before taking the result
+        Common::ThreadPool::TaskHandle decode_task;
+    };
+
     struct {
 
         // State variables
@@ -117,6 +138,7 @@ private:
         u32 current_sample_number = 0;
         u32 next_sample_number = 0;
         AudioInterp::StereoBuffer16 current_buffer;
+        std::optional<PredecodedBuffer> predecoded;
 
         // buffer_id state
 
@@ -149,6 +171,11 @@ private:
     /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it
     /// into current_buffer.
     bool DequeueBuffer();
+    /// INTERNAL: Starts decoding the next buffer of the queue on another thread, if worthwhile.
+    void StartPredecode();
+    /// INTERNAL: Moves the predecoded buffer into current_buffer if it was decoded from buf and
+    /// memory still holds the same data. Otherwise the buffer has to be decoded again.
+    bool TakePredecodedBuffer(const Buffer& buf, const u8* memory);
     /// INTERNAL: Generates a SourceStatus::Status based on our internal state.
     SourceStatus::Status GetCurrentStatus();
 };
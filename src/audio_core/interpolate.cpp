@@ -3,6 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cmath>
+#include <vector>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 
@@ -74,5 +81,160 @@ void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& outp
                     });
 }
 
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+/// std::sin is not constexpr, this is precise enough for generating the tables below.
+constexpr double ConstexprSin(double x) {
+    while (x > pi)
+        x -= 2 * pi;
+    while (x < -pi)
+        x += 2 * pi;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 20; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstexprCos(double x) {
+    return ConstexprSin(x + pi / 2);
+}
+
+constexpr std::size_t polyphase_phase_bits = 7;
+constexpr std::size_t polyphase_phases = std::size_t(1) << polyphase_phase_bits;
+/// Cutoff frequency relative to the Nyquist frequency of the input. At the full Nyquist frequency
+/// every kernel zero falls on an integer offset, so a rate of 1 passes samples through unchanged.
+constexpr double polyphase_cutoff = 1.0;
+
+/// Coefficients of one fractional position, each repeated for the left and right channels so
+/// that they can be multiplied with interleaved stereo samples directly.
+struct alignas(16) PolyphaseCoefficients {
+    std::array<float, polyphase_taps * 2> values;
+};
+
+/// Has an extra entry for the positions that round up to the next input sample.
+constexpr std::array<PolyphaseCoefficients, polyphase_phases + 1> GeneratePolyphaseTable() {
+    std::array<PolyphaseCoefficients, polyphase_phases + 1> table{};
+    constexpr double half_width = polyphase_taps / 2;
+    for (std::size_t phase = 0; phase <= polyphase_phases; ++phase) {
+        const double fraction = static_cast<double>(phase) / polyphase_phases;
+        std::array<double, polyphase_taps> kernel{};
+        double sum = 0;
+        for (std::size_t tap = 0; tap < polyphase_taps; ++tap) {
+            // Distance of the tap from the output position, which lies between taps 3 and 4
+            const double t = static_cast<double>(tap) - (half_width - 1) - fraction;
+            const double x = pi * polyphase_cutoff * t;
+            const double sinc = t == 0 ? 1 : ConstexprSin(x) / x;
+            const double window = 0.42 + 0.5 * ConstexprCos(pi * t / half_width) +
+                                  0.08 * ConstexprCos(2 * pi * t / half_width);
+            kernel[tap] = sinc * window;
+            sum += kernel[tap];
+        }
+        // Normalize for unity gain at DC
+        for (std::size_t tap = 0; tap < polyphase_taps; ++tap) {
+            table[phase].values[tap * 2] = static_cast<float>(kernel[tap] / sum);
+            table[phase].values[tap * 2 + 1] = static_cast<float>(kernel[tap] / sum);
+        }
+    }
+    return table;
+}
+
+constexpr auto polyphase_table = GeneratePolyphaseTable();
+
+/// Filters polyphase_taps interleaved stereo samples starting at window
+std::array<s16, 2> PolyphaseConvolve(const s16* window, const PolyphaseCoefficients& coeffs) {
+    const float* c = coeffs.values.data();
+#if defined(ARCHITECTURE_x86_64)
+    const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(window));
+    const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(window + 8));
+    // Sign extension of the s16 samples to s32, then conversion to float
+    const auto widen_low = [](__m128i v) {
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    };
+    const auto widen_high = [](__m128i v) {
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+    };
+    __m128 sum = _mm_mul_ps(widen_low(first), _mm_load_ps(c));
+    sum = _mm_add_ps(sum, _mm_mul_ps(widen_high(first), _mm_load_ps(c + 4)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(widen_low(second), _mm_load_ps(c + 8)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(widen_high(second), _mm_load_ps(c + 12)));
+    // (left even taps, right even taps, left odd taps, right odd taps) -> (left, right)
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(sum), _mm_setzero_si128());
+    const u32 result = static_cast<u32>(_mm_cvtsi128_si32(packed));
+    return {static_cast<s16>(result & 0xFFFF), static_cast<s16>(result >> 16)};
+#elif defined(ARCHITECTURE_ARM64)
+    const int16x8_t first = vld1q_s16(window);
+    const int16x8_t second = vld1q_s16(window + 8);
+    float32x4_t sum = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(first))), vld1q_f32(c));
+    sum = vmlaq_f32(sum, vcvtq_f32_s32(vmovl_s16(vget_high_s16(first))), vld1q_f32(c + 4));
+    sum = vmlaq_f32(sum, vcvtq_f32_s32(vmovl_s16(vget_low_s16(second))), vld1q_f32(c + 8));
+    sum = vmlaq_f32(sum, vcvtq_f32_s32(vmovl_s16(vget_high_s16(second))), vld1q_f32(c + 12));
+    // (left even taps, right even taps, left odd taps, right odd taps) -> (left, right)
+    const float32x2_t stereo = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    const int32x2_t rounded = vcvtn_s32_f32(stereo);
+    const int16x4_t packed = vqmovn_s32(vcombine_s32(rounded, rounded));
+    return {vget_lane_s16(packed, 0), vget_lane_s16(packed, 1)};
+#else
+    std::array<float, 2> sum{};
+    for (std::size_t i = 0; i < polyphase_taps * 2; ++i) {
+        sum[i % 2] += window[i] * c[i];
+    }
+    return {static_cast<s16>(std::clamp<long>(std::lrint(sum[0]), -32768, 32767)),
+            static_cast<s16>(std::clamp<long>(std::lrint(sum[1]), -32768, 32767))};
+#endif
+}
+
+} // Anonymous namespace
+
+void Polyphase(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
+               std::size_t& outputi) {
+    ASSERT(rate > 0);
+
+    if (input.empty() || outputi >= output.size())
+        return;
+
+    constexpr std::size_t history_size = polyphase_taps - 1;
+    const u64 step_size = static_cast<u64>(rate * scale_factor);
+    u64 fposition = state.fposition;
+
+    // The filter reads the samples through a pointer, so the history and the part of the input
+    // that the rest of the frame can reach are copied to contiguous storage.
+    const u64 last_position = fposition + (output.size() - outputi - 1) * step_size;
+    const std::size_t needed = static_cast<std::size_t>(last_position / scale_factor) + 1;
+    const std::size_t count = std::min(input.size(), needed);
+    static thread_local std::vector<std::array<s16, 2>> samples;
+    samples.assign(state.polyphase_history.begin(), state.polyphase_history.end());
+    samples.insert(samples.end(), input.begin(), std::next(input.begin(), count));
+
+    std::size_t window = 0;
+    while (outputi < output.size()) {
+        window = static_cast<std::size_t>(fposition / scale_factor);
+
+        if (window + polyphase_taps > samples.size()) {
+            window = samples.size() - history_size;
+            break;
+        }
+
+        // Rounded to the nearest tabulated position
+        constexpr u64 phase_shift = 24 - polyphase_phase_bits;
+        const std::size_t phase = static_cast<std::size_t>(
+            ((fposition & scale_mask) + (u64(1) << (phase_shift - 1))) >> phase_shift);
+        output[outputi++] = PolyphaseConvolve(samples[window].data(), polyphase_table[phase]);
+
+        fposition += step_size;
+    }
+
+    std::copy_n(std::next(samples.begin(), window), history_size,
+                state.polyphase_history.begin());
+    state.fposition = fposition - window * scale_factor;
+
+    input.erase(input.begin(), std::next(input.begin(), window));
+}
+
 } // namespace AudioInterp
 } // namespace AudioCore
@@ -15,10 +15,15 @@ namespace AudioInterp {
 /// A variable length buffer of signed PCM16 stereo samples.
 using StereoBuffer16 = std::deque<std::array<s16, 2>>;
 
+/// Number of input samples each output sample of the polyphase interpolator is computed from.
+constexpr std::size_t polyphase_taps = 8;
+
 struct State {
     /// Two historical samples.
     std::array<s16, 2> xn1 = {}; ///< x[n-1]
     std::array<s16, 2> xn2 = {}; ///< x[n-2]
+    /// Historical samples of the polyphase interpolator, oldest first.
+    std::array<std::array<s16, 2>, polyphase_taps - 1> polyphase_history = {};
     /// Current fractional position.
     u64 fposition = 0;
 };
@@ -47,5 +52,18 @@ void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output
 void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
             std::size_t& outputi);
 
+/**
+ * Polyphase interpolation with an 8-tap Blackman-windowed sinc filter. The filter coefficients
+ * are tabulated at compile time for 128 fractional positions. There is a four-sample predelay.
+ * @param state Interpolation state.
+ * @param input Input buffer.
+ * @param rate Stretch factor. Must be a positive non-zero value.
+ *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
+ * @param output The resampled audio buffer.
+ * @param outputi The index of output to start writing to.
+ */
+void Polyphase(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
+               std::size_t& outputi);
+
 } // namespace AudioInterp
 } // namespace AudioCore
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <thread>
@@ -141,44 +142,77 @@ struct DspLle::Impl final {
 
     const bool multithread;
     std::thread teakra_thread;
-    Common::Barrier teakra_slice_barrier{2};
     std::atomic<bool> stop_signal = false;
-    std::size_t stop_generation;
+    /// DSP cycles granted to teakra_thread that it has not run yet
+    std::atomic<u64> pending_cycles = 0;
+    /// Set when cycles are granted to an idle teakra_thread
+    Common::Event cycles_granted;
+    /// Set by teakra_thread each time it finishes a batch
+    Common::Event cycles_run;
 
     static constexpr u32 DspDataOffset = 0x40000;
     static constexpr u32 TeakraSlice = 20000;
+    /// Most cycles teakra_thread may lag behind the CPU thread, and the most it runs at once.
+    /// The CPU thread only blocks on the DSP when this is exceeded or when it polls a register.
+    static constexpr u64 TeakraBatch = TeakraSlice * 8;
 
     void TeakraThread() {
-        while (true) {
-            teakra.Run(TeakraSlice);
-            teakra_slice_barrier.Sync();
-            if (stop_signal) {
-                if (stop_generation == teakra_slice_barrier.Generation())
-                    break;
+        Common::SetCurrentThreadName("DspLle");
+        Common::ScopedThreadRole thread_role{Common::ThreadRole::Audio};
+        while (!stop_signal) {
+            const u64 cycles = std::min(pending_cycles.load(), TeakraBatch);
+            if (cycles == 0) {
+                cycles_granted.Wait();
+                continue;
             }
+            teakra.Run(static_cast<unsigned>(cycles));
+            pending_cycles -= cycles;
+            cycles_run.Set();
         }
-        stop_signal = false;
     }
 
     void StopTeakraThread() {
         if (teakra_thread.joinable()) {
-            stop_generation = teakra_slice_barrier.Generation() + 1;
             stop_signal = true;
-            teakra_slice_barrier.Sync();
+            cycles_granted.Set();
             teakra_thread.join();
+            stop_signal = false;
+            pending_cycles = 0;
+            cycles_granted.Reset();
+            cycles_run.Reset();
+        }
+    }
+
+    void GrantCycles(u64 cycles) {
+        if (pending_cycles.fetch_add(cycles) == 0) {
+            cycles_granted.Set();
         }
     }
 
+    /// Blocks until teakra_thread has at most max_pending cycles left to run
+    void WaitForTeakra(u64 max_pending) {
+        while (pending_cycles.load() > max_pending) {
+            cycles_run.Wait();
+        }
+    }
+
+    /// Runs a slice to completion, used when the CPU thread polls the DSP for a result
     void RunTeakraSlice() {
         if (multithread) {
-            teakra_slice_barrier.Sync();
+            GrantCycles(TeakraSlice);
+            WaitForTeakra(0);
         } else {
             teakra.Run(TeakraSlice);
         }
     }
 
     void TeakraSliceEvent(u64 late) {
-        RunTeakraSlice();
+        if (multithread) {
+            GrantCycles(TeakraSlice);
+            WaitForTeakra(TeakraBatch);
+        } else {
+            teakra.Run(TeakraSlice);
+        }
         u64 next = TeakraSlice * 2; // DSP runs at clock rate half of the CPU rate
         if (next < late)
             next = 0;
@@ -9,11 +9,14 @@
 #include "audio_core/sdl2_sink.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
 struct SDL2Sink::Impl {
     unsigned int sample_rate = 0;
+    u16 buffer_samples = 0;
 
     SDL_AudioDeviceID audio_device_id = 0;
 
@@ -34,7 +37,7 @@ SDL2Sink::SDL2Sink(std::string device_name) : impl(std::make_unique<Impl>()) {
     desired_audiospec.format = AUDIO_S16;
     desired_audiospec.channels = 2;
     desired_audiospec.freq = native_sample_rate;
-    desired_audiospec.samples = 512;
+    desired_audiospec.samples = Settings::values.enable_low_latency_audio ? 256 : 512;
     desired_audiospec.userdata = impl.get();
     desired_audiospec.callback = &Impl::Callback;
 
@@ -55,6 +58,7 @@ SDL2Sink::SDL2Sink(std::string device_name) : impl(std::make_unique<Impl>()) {
     }
 
     impl->sample_rate = obtained_audiospec.freq;
+    impl->buffer_samples = obtained_audiospec.samples;
 
     // SDL2 audio devices start out paused, unpause it:
     SDL_PauseAudioDevice(impl->audio_device_id, 0);
@@ -78,7 +82,14 @@ void SDL2Sink::SetCallback(std::function<void(s16*, std::size_t)> cb) {
     impl->cb = cb;
 }
 
+std::size_t SDL2Sink::GetBufferedSamples() const {
+    return impl->buffer_samples;
+}
+
 void SDL2Sink::Impl::Callback(void* impl_, u8* buffer, int buffer_size_in_bytes) {
+    // SDL calls back on a thread of its own
+    thread_local Common::ScopedThreadRole thread_role{Common::ThreadRole::Audio};
+
     Impl* impl = reinterpret_cast<Impl*>(impl_);
     if (!impl || !impl->cb)
         return;
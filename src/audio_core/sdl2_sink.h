@@ -19,6 +19,8 @@ public:
 
     void SetCallback(std::function<void(s16*, std::size_t)> cb) override;
 
+    std::size_t GetBufferedSamples() const override;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -30,6 +30,12 @@ public:
      * @param sample_count Number of samples.
      */
     virtual void SetCallback(std::function<void(s16*, std::size_t)> cb) = 0;
+
+    /// Number of samples the sink buffers between the callback and the output device, or 0 if
+    /// unknown.
+    virtual std::size_t GetBufferedSamples() const {
+        return 0;
+    }
 };
 
 } // namespace AudioCore
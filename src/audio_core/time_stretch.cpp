@@ -33,9 +33,11 @@ std::size_t TimeStretcher::Process(const s16* in, std::size_t num_in, s16* out,
     const double time_delta = static_cast<double>(num_out) / sample_rate; // seconds
     double current_ratio = static_cast<double>(num_in) / static_cast<double>(num_out);
 
-    const double max_latency = 0.25; // seconds
+    const double max_latency = low_latency ? 0.02 : 0.25; // seconds
     const double max_backlog = sample_rate * max_latency;
-    const double backlog_fullness = sound_touch->numSamples() / max_backlog;
+    const std::size_t backlog = GetBacklog();
+    const double backlog_fullness = backlog / max_backlog;
+    memory_usage.Set(backlog * 2 * sizeof(s16));
     if (backlog_fullness > 4.0) {
         // Too many samples in backlog: Don't push anymore on
         num_in = 0;
@@ -57,20 +59,85 @@ std::size_t TimeStretcher::Process(const s16* in, std::size_t num_in, s16* out,
     // Place a lower limit of 5% speed. When a game boots up, there will be
     // many silence samples. These do not need to be timestretched.
     stretch_ratio = std::max(stretch_ratio, 0.05);
-    sound_touch->setTempo(stretch_ratio);
 
     LOG_TRACE(Audio, "{:5}/{:5} ratio:{:0.6f} backlog:{:0.6f}", num_in, num_out, stretch_ratio,
               backlog_fullness);
 
+    if (low_latency) {
+        // The thresholds differ to avoid toggling when the speed hovers around 100%
+        const double deviation = std::abs(stretch_ratio - 1.0);
+        if (bypassing && deviation > 0.05) {
+            LeaveBypass();
+        } else if (!bypassing && deviation < 0.02 && sound_touch->numSamples() == 0) {
+            bypassing = true;
+        }
+    }
+    if (bypassing) {
+        return ProcessBypass(in, num_in, out, num_out, static_cast<std::size_t>(max_backlog));
+    }
+
+    sound_touch->setTempo(stretch_ratio);
+
     sound_touch->putSamples(in, static_cast<u32>(num_in));
     return sound_touch->receiveSamples(out, static_cast<u32>(num_out));
 }
 
+std::size_t TimeStretcher::ProcessBypass(const s16* in, std::size_t num_in, s16* out,
+                                         std::size_t num_out, std::size_t max_backlog) {
+    bypass_buffer.insert(bypass_buffer.end(), in, in + num_in * 2);
+
+    const std::size_t max_frames = max_backlog + num_out;
+    if (bypass_buffer.size() / 2 > max_frames) {
+        const std::size_t dropped = bypass_buffer.size() / 2 - max_frames;
+        bypass_buffer.erase(bypass_buffer.begin(), bypass_buffer.begin() + dropped * 2);
+    }
+
+    const std::size_t count = std::min(num_out, bypass_buffer.size() / 2);
+    std::copy_n(bypass_buffer.begin(), count * 2, out);
+    bypass_buffer.erase(bypass_buffer.begin(), bypass_buffer.begin() + count * 2);
+    return count;
+}
+
+void TimeStretcher::SetLowLatency(bool enable) {
+    if (low_latency == enable)
+        return;
+
+    low_latency = enable;
+    if (enable) {
+        // Shorter processing windows than the automatic defaults of SoundTouch
+        sound_touch->setSetting(SETTING_SEQUENCE_MS, 20);
+        sound_touch->setSetting(SETTING_SEEKWINDOW_MS, 10);
+        sound_touch->setSetting(SETTING_OVERLAP_MS, 4);
+    } else {
+        sound_touch->setSetting(SETTING_SEQUENCE_MS, 0);
+        sound_touch->setSetting(SETTING_SEEKWINDOW_MS, 0);
+        sound_touch->setSetting(SETTING_OVERLAP_MS, 8);
+        LeaveBypass();
+    }
+}
+
+void TimeStretcher::LeaveBypass() {
+    if (!bypassing)
+        return;
+
+    // Hand the pending samples over to SoundTouch so that none are lost
+    bypassing = false;
+    sound_touch->putSamples(bypass_buffer.data(), static_cast<u32>(bypass_buffer.size() / 2));
+    bypass_buffer.clear();
+}
+
+std::size_t TimeStretcher::GetBacklog() const {
+    return sound_touch->numSamples() + bypass_buffer.size() / 2;
+}
+
 void TimeStretcher::Clear() {
     sound_touch->clear();
+    bypass_buffer.clear();
+    memory_usage.Set(0);
 }
 
 void TimeStretcher::Flush() {
+    LeaveBypass();
     sound_touch->flush();
 }
 
@@ -7,7 +7,9 @@
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <vector>
 #include "common/common_types.h"
+#include "common/memory_usage.h"
 
 namespace soundtouch {
 class SoundTouch;
@@ -33,10 +35,33 @@ public:
 
     void Flush();
 
+    /**
+     * Switches to a shorter backlog target and a SoundTouch configuration with less processing
+     * latency. While the emulation runs at full speed the samples then skip SoundTouch entirely.
+     */
+    void SetLowLatency(bool enable);
+
+    /// Number of frames held by the stretcher that have not been output yet
+    std::size_t GetBacklog() const;
+
 private:
+    /// Copies the samples to out unprocessed, dropping the oldest ones above max_backlog frames
+    std::size_t ProcessBypass(const s16* in, std::size_t num_in, s16* out, std::size_t num_out,
+                              std::size_t max_backlog);
+    /// Moves the samples of the bypass buffer into SoundTouch and stops bypassing it
+    void LeaveBypass();
+
     unsigned int sample_rate;
     std::unique_ptr<soundtouch::SoundTouch> sound_touch;
     double stretch_ratio = 1.0;
+
+    bool low_latency = false;
+    bool bypassing = false;
+    /// Interleaved stereo samples waiting to be output while bypassing SoundTouch
+    std::vector<s16> bypass_buffer;
+
+    /// Accounts the backlog as of the previous call to Process
+    Common::ScopedMemoryUsage memory_usage{Common::MemoryCategory::AudioBuffers};
 };
 
 } // namespace AudioCore
@@ -0,0 +1,64 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "audio_core/hle/shared_memory.h"
+#include "audio_core/hle/source.h"
+#include "core/memory.h"
+
+namespace AudioCore::HLE {
+
+using Configuration = SourceConfiguration::Configuration;
+
+/// Plays a looping 16-bit stereo buffer with the given interpolation, mixing it into one output
+static void BenchmarkSource(Memory::MemorySystem& memory, Configuration::InterpolationMode mode) {
+    constexpr u32 num_samples = 0x8000;
+    s16* samples = reinterpret_cast<s16*>(memory.GetFCRAMPointer(0));
+    for (u32 i = 0; i < 2 * num_samples; ++i) {
+        samples[i] = static_cast<s16>(i * 31);
+    }
+
+    Source source(0);
+    source.SetMemory(memory);
+
+    Configuration config{};
+    config.enable = 1;
+    config.enable_dirty.Assign(1);
+    // Resampled, as most sounds are
+    config.rate_multiplier = 0.75f;
+    config.rate_multiplier_dirty.Assign(1);
+    config.interpolation_mode = mode;
+    config.interpolation_dirty.Assign(1);
+    config.gain[0][0] = 1.0f;
+    config.gain[0][1] = 1.0f;
+    config.gain_0_dirty.Assign(1);
+    config.physical_address = Memory::FCRAM_PADDR;
+    config.length = num_samples;
+    config.mono_or_stereo.Assign(Configuration::MonoOrStereo::Stereo);
+    config.format.Assign(Configuration::Format::PCM16);
+    config.is_looping.Assign(1);
+    config.embedded_buffer_dirty.Assign(1);
+    const s16_le adpcm_coeffs[16]{};
+
+    QuadFrame32 mix{};
+    BENCHMARK("Tick and MixInto of one frame") {
+        source.Tick(config, adpcm_coeffs);
+        source.MixInto(mix, 0);
+        return mix[0][0];
+    };
+}
+
+TEST_CASE("Source", "[audio_core][hle]") {
+    Memory::MemorySystem memory;
+
+    SECTION("Linear interpolation") {
+        BenchmarkSource(memory, Configuration::InterpolationMode::Linear);
+    }
+
+    SECTION("Polyphase interpolation") {
+        BenchmarkSource(memory, Configuration::InterpolationMode::Polyphase);
+    }
+}
+
+} // namespace AudioCore::HLE
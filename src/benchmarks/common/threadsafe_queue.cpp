@@ -0,0 +1,55 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+constexpr int COUNT = 100000;
+
+/// Pushes COUNT elements from the given number of threads while this thread pops them
+template <typename Queue>
+static int Transfer(Queue& queue, int num_producers) {
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < num_producers; ++producer) {
+        producers.emplace_back([&queue, num_producers] {
+            for (int i = 0; i < COUNT / num_producers; ++i) {
+                queue.Push(i);
+            }
+        });
+    }
+    int sum = 0;
+    for (int i = 0; i < COUNT / num_producers * num_producers; ++i) {
+        sum += queue.PopWait();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    return sum;
+}
+
+TEST_CASE("Thread safe queues", "[common]") {
+    SPSCQueue<int> spsc_queue;
+    BENCHMARK("SPSCQueue, 100000 elements") {
+        return Transfer(spsc_queue, 1);
+    };
+
+    BoundedSPSCQueue<int, 1024> bounded_spsc_queue;
+    BENCHMARK("BoundedSPSCQueue, 100000 elements") {
+        return Transfer(bounded_spsc_queue, 1);
+    };
+
+    MPSCQueue<int> mpsc_queue;
+    BENCHMARK("MPSCQueue, 100000 elements from 1 thread") {
+        return Transfer(mpsc_queue, 1);
+    };
+    BENCHMARK("MPSCQueue, 100000 elements from 4 threads") {
+        return Transfer(mpsc_queue, 4);
+    };
+}
+
+} // namespace Common
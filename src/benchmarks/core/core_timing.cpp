@@ -0,0 +1,26 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+
+static void EmptyCallback(u64 userdata, s64 cycles_late) {}
+
+TEST_CASE("Timing", "[core]") {
+    Core::Timing timing;
+    Core::TimingEventType* event = timing.RegisterEvent("benchmark", EmptyCallback);
+    timing.Advance();
+
+    BENCHMARK("ScheduleEvent of 64 events, then Advance through them") {
+        for (s64 i = 0; i < 64; ++i) {
+            // Out of order, so that the queue has to sort them
+            timing.ScheduleEvent(1000 + (i * 37) % 64 * 100, event, i);
+        }
+        for (int i = 0; i < 64; ++i) {
+            timing.AddTicks(timing.GetDowncount());
+            timing.Advance();
+        }
+        return timing.GetTicks();
+    };
+}
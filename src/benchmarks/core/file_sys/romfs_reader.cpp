@@ -0,0 +1,50 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/romfs_reader.h"
+
+namespace FileSys {
+
+TEST_CASE("RomFSReader::ReadFile", "[core][file_sys]") {
+    const std::string path = "./romfs_reader_benchmark.bin";
+    std::vector<u8> data(16 * 1024 * 1024);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 13);
+    }
+    {
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(data.data(), data.size()) == data.size());
+    }
+
+    {
+        RomFSReader plain(ROMFile(path), 0, data.size());
+        RomFSReader encrypted(ROMFile(path), 0, data.size(), {}, {}, 0);
+        std::vector<u8> buffer(64 * 1024);
+
+        // Games mostly issue small reads, often of neighbouring data
+        BENCHMARK("256 reads of 1 KiB spread over the file") {
+            std::size_t read = 0;
+            for (std::size_t i = 0; i < 256; ++i) {
+                read += plain.ReadFile((i * 65537) % (data.size() - 1024), 1024, buffer.data());
+            }
+            return read;
+        };
+
+        BENCHMARK("Read of 64 KiB") {
+            return plain.ReadFile(4096, buffer.size(), buffer.data());
+        };
+
+        BENCHMARK("Encrypted read of 64 KiB") {
+            return encrypted.ReadFile(4096, buffer.size(), buffer.data());
+        };
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
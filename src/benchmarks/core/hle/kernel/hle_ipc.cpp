@@ -0,0 +1,68 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/ipc.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/server_session.h"
+
+namespace Kernel {
+
+TEST_CASE("HLERequestContext", "[core][kernel]") {
+    // HACK: see comments of member timing
+    Core::System::GetInstance().timing = std::make_unique<Core::Timing>();
+    auto memory = std::make_unique<Memory::MemorySystem>();
+    Kernel::KernelSystem kernel(*memory, 0);
+    auto session = std::get<SharedPtr<ServerSession>>(kernel.CreateSessionPair());
+    HLERequestContext context(std::move(session));
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    std::vector<u8> buffer(Memory::PAGE_SIZE);
+    constexpr VAddr buffer_address = 0x10000000;
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(buffer_address, buffer.data(),
+                                  static_cast<u32>(buffer.size()), MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    const auto event = kernel.CreateEvent(ResetType::OneShot);
+    const Handle handle = process->handle_table.Create(event).Unwrap();
+
+    BENCHMARK("Translation of a request with parameters, a handle and a static buffer") {
+        const u32_le input[]{
+            IPC::MakeHeader(0x1234, 3, 4),
+            0x12345678,
+            0x21122112,
+            0xAABBCCDD,
+            IPC::CopyHandleDesc(1),
+            handle,
+            IPC::StaticBufferDesc(static_cast<u32>(buffer.size()), 0),
+            buffer_address,
+        };
+        return context.PopulateFromIncomingCommandBuffer(input, *process).raw;
+    };
+
+    BENCHMARK("Translation of a reply with parameters and a handle") {
+        context.CommandBuffer()[0] = IPC::MakeHeader(0x1234, 2, 2);
+        context.CommandBuffer()[1] = RESULT_SUCCESS.raw;
+        context.CommandBuffer()[2] = 0x12345678;
+        context.CommandBuffer()[3] = IPC::CopyHandleDesc(1);
+        context.ClearIncomingObjects();
+        context.CommandBuffer()[4] = context.AddOutgoingHandle(event);
+
+        std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH> output;
+        const ResultCode result = context.WriteToOutgoingCommandBuffer(output.data(), *process);
+        process->handle_table.Close(output[4]);
+        return result.raw;
+    };
+}
+
+} // namespace Kernel
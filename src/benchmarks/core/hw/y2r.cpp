@@ -0,0 +1,67 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+
+TEST_CASE("Y2R::PerformConversion", "[core][y2r]") {
+    // HACK: see comments of member timing
+    Core::System::GetInstance().timing = std::make_unique<Core::Timing>();
+    Core::System::GetInstance().memory = std::make_unique<Memory::MemorySystem>();
+    auto& memory = Core::System::GetInstance().Memory();
+    Kernel::KernelSystem kernel(memory, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    std::vector<u8> block(0x100000);
+    for (std::size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<u8>(i * 7);
+    }
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, block.data(),
+                                  static_cast<u32>(block.size()), Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    // A 320x240 camera frame, converted 8 lines at a time like the camera module does
+    constexpr u16 width = 320;
+    constexpr u16 height = 240;
+    Service::Y2R::ConversionConfiguration config{};
+    config.input_format = Service::Y2R::InputFormat::YUV422_Indiv8;
+    config.output_format = Service::Y2R::OutputFormat::RGBA8;
+    config.rotation = Service::Y2R::Rotation::None;
+    config.block_alignment = Service::Y2R::BlockAlignment::Linear;
+    REQUIRE(config.SetInputLineWidth(width) == RESULT_SUCCESS);
+    REQUIRE(config.SetInputLines(height) == RESULT_SUCCESS);
+    REQUIRE(config.SetStandardCoefficient(Service::Y2R::StandardCoefficient::ITU_Rec601) ==
+            RESULT_SUCCESS);
+    config.alpha = 0xFF;
+
+    VAddr address = Memory::HEAP_VADDR;
+    const auto setup_buffer = [&address](Service::Y2R::ConversionBuffer& buffer, u32 line_size,
+                                         u32 lines) {
+        buffer.address = address;
+        buffer.image_size = line_size * lines;
+        buffer.transfer_unit = static_cast<u16>(line_size * 8);
+        buffer.gap = 0;
+        address += buffer.image_size;
+    };
+    setup_buffer(config.src_Y, width, height);
+    setup_buffer(config.src_U, width / 2, height);
+    setup_buffer(config.src_V, width / 2, height);
+    setup_buffer(config.dst, width * 4, height);
+
+    BENCHMARK("YUV422 to RGBA8, 320x240") {
+        // The conversion advances the buffers
+        Service::Y2R::ConversionConfiguration cvt = config;
+        HW::Y2R::PerformConversion(cvt);
+        return cvt.dst.address;
+    };
+}
@@ -0,0 +1,47 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+
+TEST_CASE("MemorySystem", "[core][memory]") {
+    // HACK: see comments of member timing
+    Core::System::GetInstance().timing = std::make_unique<Core::Timing>();
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    constexpr u32 size = 0x100000;
+    std::vector<u8> block(size);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, block.data(), size,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    BENCHMARK("Read32 of 4096 sequential words") {
+        u32 sum = 0;
+        for (VAddr addr = Memory::HEAP_VADDR; addr < Memory::HEAP_VADDR + 0x4000; addr += 4) {
+            sum += memory.Read32(addr);
+        }
+        return sum;
+    };
+
+    BENCHMARK("Write32 of 4096 sequential words") {
+        for (VAddr addr = Memory::HEAP_VADDR; addr < Memory::HEAP_VADDR + 0x4000; addr += 4) {
+            memory.Write32(addr, addr);
+        }
+    };
+
+    std::vector<u8> dest(size);
+    BENCHMARK("ReadBlock of 1 MiB") {
+        memory.ReadBlock(*process, Memory::HEAP_VADDR, dest.data(), size);
+        return dest[0];
+    };
+}
@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_x64.h"
+#endif
+
+using float24 = Pica::float24;
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+/// Runs a short vertex shader doing the kind of arithmetic a transform does on 64 vertices
+static void BenchmarkEngine(Pica::Shader::ShaderEngine& engine) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary({
+        // clang-format off
+        {OpCode::Id::MUL, DestRegister::MakeTemporary(0), SourceRegister::MakeInput(0),
+                          SourceRegister::MakeFloat(0)},
+        {OpCode::Id::ADD, DestRegister::MakeTemporary(0), SourceRegister::MakeTemporary(0),
+                          SourceRegister::MakeFloat(1)},
+        {OpCode::Id::DP4, DestRegister::MakeTemporary(1), SourceRegister::MakeTemporary(0),
+                          SourceRegister::MakeFloat(2)},
+        {OpCode::Id::MUL, DestRegister::MakeOutput(0), SourceRegister::MakeTemporary(0),
+                          SourceRegister::MakeTemporary(1)},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(1), SourceRegister::MakeInput(1)},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    std::transform(shbin.program.begin(), shbin.program.end(), setup->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    for (auto& uniform : setup->uniforms.f) {
+        uniform = {float24::FromFloat32(0.5f), float24::FromFloat32(1.0f),
+                   float24::FromFloat32(1.5f), float24::FromFloat32(2.0f)};
+    }
+    engine.SetupBatch(*setup, 0);
+
+    std::array<Pica::Shader::UnitState, 64> units;
+    BENCHMARK("Run of 64 vertices") {
+        for (std::size_t i = 0; i < units.size(); ++i) {
+            units[i].registers.input[0].x = float24::FromFloat32(static_cast<float>(i));
+            engine.Run(*setup, units[i]);
+        }
+        return units[0].registers.output[0].x.ToFloat32();
+    };
+
+    BENCHMARK("RunBatch of 64 vertices") {
+        engine.RunBatch(*setup, units.data(), units.size());
+        return units[0].registers.output[0].x.ToFloat32();
+    };
+}
+
+TEST_CASE("ShaderEngine", "[video_core][shader]") {
+    SECTION("Interpreter") {
+        Pica::Shader::InterpreterEngine engine;
+        BenchmarkEngine(engine);
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    SECTION("JIT") {
+        Pica::Shader::JitX64Engine engine;
+        BenchmarkEngine(engine);
+    }
+#endif
+}
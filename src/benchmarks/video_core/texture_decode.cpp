@@ -0,0 +1,50 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/math_util.h"
+#include "video_core/texture/texture_decode.h"
+
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+TEST_CASE("Texture decoding", "[video_core][texture]") {
+    constexpr unsigned width = 256;
+    constexpr unsigned height = 256;
+    std::vector<u8> source(width * height * 4);
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<u8>(i * 29);
+    }
+    std::vector<u8> dest(width * height * 4);
+
+    for (const auto& [format, format_name] :
+         {std::pair{TextureFormat::RGBA8, "RGBA8"}, std::pair{TextureFormat::RGB565, "RGB565"},
+          std::pair{TextureFormat::ETC1A4, "ETC1A4"}}) {
+        Pica::Texture::TextureInfo info{};
+        info.width = width;
+        info.height = height;
+        info.format = format;
+        info.SetDefaultStride();
+
+        const std::string name = std::string(" of a 256x256 ") + format_name + " texture";
+
+        BENCHMARK("LookupTexture of every texel" + name) {
+            u32 sum = 0;
+            for (unsigned y = 0; y < height; ++y) {
+                for (unsigned x = 0; x < width; ++x) {
+                    sum += Pica::Texture::LookupTexture(source.data(), x, y, info).r();
+                }
+            }
+            return sum;
+        };
+
+        BENCHMARK("DecodeTexture" + name) {
+            Pica::Texture::DecodeTexture(source.data(), info, dest.data(),
+                                         MathUtil::Rectangle<u32>{0, height, width, 0});
+            return dest[0];
+        };
+    }
+}
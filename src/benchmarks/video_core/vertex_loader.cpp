@@ -0,0 +1,56 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+using VertexAttributeFormat = Pica::PipelineRegs::VertexAttributeFormat;
+
+TEST_CASE("VertexLoader::LoadVertex", "[video_core]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+
+    // A position of 3 floats, a color of 4 bytes and texture coordinates of 2 shorts in one array
+    constexpr u32 stride = 3 * 4 + 4 + 2 * 2;
+    u8* vertices = memory.GetFCRAMPointer(0);
+    for (u32 i = 0; i < 1024 * stride; ++i) {
+        vertices[i] = static_cast<u8>(i * 3);
+    }
+
+    Pica::PipelineRegs regs{};
+    auto& attributes = regs.vertex_attributes;
+    attributes.base_address.Assign(Memory::FCRAM_PADDR / 16);
+    attributes.format0.Assign(VertexAttributeFormat::FLOAT);
+    attributes.size0.Assign(2);
+    attributes.format1.Assign(VertexAttributeFormat::UBYTE);
+    attributes.size1.Assign(3);
+    attributes.format2.Assign(VertexAttributeFormat::SHORT);
+    attributes.size2.Assign(1);
+    attributes.max_attribute_index.Assign(2);
+    auto& loader_config = attributes.attribute_loaders[0];
+    loader_config.comp0.Assign(0);
+    loader_config.comp1.Assign(1);
+    loader_config.comp2.Assign(2);
+    loader_config.component_count.Assign(3);
+    loader_config.byte_count.Assign(stride);
+
+    Pica::VertexLoader loader(regs);
+    Pica::DebugUtils::MemoryAccessTracker memory_accesses;
+    Pica::Shader::AttributeBuffer input;
+
+    BENCHMARK("LoadVertex of 1024 vertices") {
+        for (int i = 0; i < 1024; ++i) {
+            loader.LoadVertex(attributes.GetPhysicalBaseAddress(), i, i, input, memory_accesses);
+        }
+        return input.attr[0].x.ToFloat32();
+    };
+
+    VideoCore::g_memory = nullptr;
+}
@@ -0,0 +1,170 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <fmt/format.h>
+#include "citra/benchmark.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scm_rev.h"
+#include "core/core.h"
+
+namespace {
+
+struct ProfileScope {
+    const char* group;
+    const char* name;
+};
+
+/// Microprofile scopes whose time is reported for every frame
+constexpr ProfileScope profile_scopes[] = {
+    {"ARM JIT", "ARM JIT"},
+    {"DynCom", "Execute"},
+    {"Kernel", "SVC"},
+    {"GPU", "Cmdlist Processing"},
+    {"GPU", "Drawing"},
+    {"GPU", "Shader"},
+    {"OpenGL", "Drawing"},
+    {"OpenGL", "Surface Load"},
+    {"OpenGL", "Surface Flush"},
+};
+
+/// Gets the value below which the given fraction of the sorted values fall
+double Percentile(const std::vector<double>& sorted_values, double fraction) {
+    if (sorted_values.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(
+        std::ceil(fraction * static_cast<double>(sorted_values.size())) - 1.0);
+    return sorted_values[std::min(index, sorted_values.size() - 1)];
+}
+
+} // Anonymous namespace
+
+std::string FormatDistribution(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    const double mean = values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+    return fmt::format("{{\"mean\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p99\": {:.4f}, "
+                       "\"max\": {:.4f}}}",
+                       mean, Percentile(values, 0.5), Percentile(values, 0.9),
+                       Percentile(values, 0.99), values.empty() ? 0.0 : values.back());
+}
+
+Benchmark::Benchmark(std::string output_path, u64 max_frames)
+    : output_path(std::move(output_path)), max_frames(max_frames) {
+    // The scope times are only recorded while their groups are enabled
+    MicroProfileSetEnableAllGroups(true);
+    MicroProfileSetForceEnable(true);
+}
+
+void Benchmark::Update(Core::System& system) {
+    const u64 frame_count = system.perf_stats.GetTotalSystemFrames();
+    if (frame_count == last_frame_count) {
+        return;
+    }
+    // The first frame is skipped, it includes the time taken to boot
+    const bool first_frame = last_frame_count == 0;
+    last_frame_count = frame_count;
+
+    const auto results = system.GetAndResetPerfStats();
+    if (first_frame) {
+        return;
+    }
+
+    FrameSample sample;
+    sample.frametime_ms = results.frametime * 1000.0;
+    sample.emulation_speed = results.emulation_speed;
+    for (const auto& scope : profile_scopes) {
+        sample.scope_times_ms.push_back(MicroProfileGetTime(scope.group, scope.name));
+    }
+    // A single frame is sampled at a time, so the maximum is the time of that frame
+    for (const auto& phase : results.phase_distributions) {
+        sample.phase_times_ms.push_back(phase.max);
+    }
+    samples.push_back(std::move(sample));
+
+    if (max_frames != 0 && samples.size() >= max_frames) {
+        finished = true;
+    }
+}
+
+double Benchmark::GetMeanSpeed() const {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (const auto& sample : samples) {
+        sum += sample.emulation_speed;
+    }
+    return sum / samples.size();
+}
+
+bool Benchmark::WriteResults() const {
+    const double wall_time_s = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start_time)
+                                   .count();
+
+    std::vector<double> frametimes;
+    std::vector<double> speeds;
+    for (const auto& sample : samples) {
+        frametimes.push_back(sample.frametime_ms);
+        speeds.push_back(sample.emulation_speed);
+    }
+
+    std::string json = "{\n";
+    json += fmt::format("  \"build\": \"{} {}\",\n", Common::g_scm_branch, Common::g_scm_desc);
+    json += fmt::format("  \"frames\": {},\n", samples.size());
+    json += fmt::format("  \"wall_time_s\": {:.3f},\n", wall_time_s);
+    json += fmt::format("  \"frametime_ms\": {},\n", FormatDistribution(frametimes));
+    json += fmt::format("  \"emulation_speed\": {},\n", FormatDistribution(speeds));
+
+    json += "  \"scope_time_ms\": {\n";
+    for (std::size_t i = 0; i < std::size(profile_scopes); ++i) {
+        std::vector<double> times;
+        for (const auto& sample : samples) {
+            times.push_back(sample.scope_times_ms[i]);
+        }
+        json += fmt::format("    \"{}/{}\": {}{}\n", profile_scopes[i].group,
+                            profile_scopes[i].name, FormatDistribution(std::move(times)),
+                            i + 1 < std::size(profile_scopes) ? "," : "");
+    }
+    json += "  },\n";
+
+    json += "  \"phase_time_ms\": {\n";
+    constexpr auto phase_count = static_cast<std::size_t>(Core::FramePhase::Count);
+    for (std::size_t i = 0; i < phase_count; ++i) {
+        std::vector<double> times;
+        for (const auto& sample : samples) {
+            times.push_back(sample.phase_times_ms[i]);
+        }
+        json += fmt::format("    \"{}\": {}{}\n",
+                            Core::GetFramePhaseName(static_cast<Core::FramePhase>(i)),
+                            FormatDistribution(std::move(times)), i + 1 < phase_count ? "," : "");
+    }
+    json += "  },\n";
+
+    json += "  \"per_frame\": [\n";
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        json += fmt::format("    {{\"frametime_ms\": {:.4f}, \"emulation_speed\": {:.4f}}}{}\n",
+                            samples[i].frametime_ms, samples[i].emulation_speed,
+                            i + 1 < samples.size() ? "," : "");
+    }
+    json += "  ]\n}\n";
+
+    FileUtil::IOFile file(output_path, "w");
+    if (!file.IsOpen() || file.WriteString(json) != json.size()) {
+        LOG_ERROR(Frontend, "Failed to write the benchmark results to {}", output_path);
+        return false;
+    }
+    LOG_INFO(Frontend, "Wrote the results of {} benchmark frames to {}", samples.size(),
+             output_path);
+    return true;
+}
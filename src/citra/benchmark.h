@@ -0,0 +1,67 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+class System;
+}
+
+/// Formats the mean, the 50th, 90th and 99th percentiles and the maximum of values as JSON
+std::string FormatDistribution(std::vector<double> values);
+
+/**
+ * Collects performance statistics for every frame of a headless benchmark run and writes them as
+ * JSON once the run is over.
+ */
+class Benchmark {
+public:
+    /**
+     * @param output_path file the JSON results are written to
+     * @param max_frames number of system frames to run, or 0 to run until the movie ends
+     */
+    Benchmark(std::string output_path, u64 max_frames);
+
+    /// Samples the statistics of the frames presented since the previous call
+    void Update(Core::System& system);
+
+    /// Ends the run early, for example when the movie that drives it is over
+    void Finish() {
+        finished = true;
+    }
+
+    bool IsFinished() const {
+        return finished;
+    }
+
+    /// Writes the collected results to the output file
+    bool WriteResults() const;
+
+    /// Returns the mean emulation speed of the sampled frames
+    double GetMeanSpeed() const;
+
+private:
+    struct FrameSample {
+        /// Walltime spent emulating the frame, in milliseconds
+        double frametime_ms;
+        double emulation_speed;
+        /// Time of each scope of profile_scopes during the frame, in milliseconds
+        std::vector<float> scope_times_ms;
+        /// Time of each Core::FramePhase during the frame, in milliseconds
+        std::vector<double> phase_times_ms;
+    };
+
+    std::string output_path;
+    u64 max_frames;
+    bool finished = false;
+
+    u64 last_frame_count = 0;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::vector<FrameSample> samples;
+};
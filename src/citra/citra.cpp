@@ -23,6 +23,7 @@
 #include <shellapi.h>
 #endif
 
+#include "citra/benchmark.h"
 #include "citra/config.h"
 #include "citra/emu_window/emu_window_sdl2.h"
 #include "common/common_paths.h"
@@ -34,15 +35,18 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/file_sys/cia_container.h"
 #include "core/frontend/applets/default_applets.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
+#include "core/hw/gpu.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
 #include "core/settings.h"
+#include "core/title_settings.h"
 #include "network/network.h"
 
 #ifdef _WIN32
@@ -61,6 +65,16 @@ static void PrintHelp(const char* argv0) {
                  " Nickname, password, address and port for multiplayer\n"
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
+                 "-b, --benchmark=[file] Run without frame limit and write performance results as "
+                 "JSON to the given file. Stops when the movie ends or after --frames frames\n"
+                 "-n, --frames=NUMBER  Number of frames to run in benchmark mode\n"
+                 "-S, --save-title-settings Ignore the settings stored for the title, and store "
+                 "the renderer and CPU settings used instead if the benchmark ran faster with "
+                 "them than with the stored ones\n"
+                 "-t, --trace=[file]   Write the profiler scopes of the first --frames frames, or "
+                 "300 by default, to the given file as a Chrome trace\n"
+                 "-H, --frame-hashes=[file] Run in deterministic mode and write a hash of the "
+                 "displayed framebuffers to the given file every frame\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -171,7 +185,11 @@ static void InitializeLogging() {
 
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
-    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.log_binary) {
+        Log::AddBackend(std::make_unique<Log::BinaryFileBackend>(log_dir + BINARY_LOG_FILE));
+    } else {
+        Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    }
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -186,6 +204,11 @@ int main(int argc, char** argv) {
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
     std::string movie_record;
     std::string movie_play;
+    std::string benchmark_output;
+    u64 benchmark_frames = 0;
+    bool save_title_settings = false;
+    std::string trace_output;
+    std::string frame_hashes_output;
 
     InitializeLogging();
 
@@ -214,6 +237,11 @@ int main(int argc, char** argv) {
         {"multiplayer", required_argument, 0, 'm'},
         {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},
+        {"benchmark", required_argument, 0, 'b'},
+        {"frames", required_argument, 0, 'n'},
+        {"save-title-settings", no_argument, 0, 'S'},
+        {"trace", required_argument, 0, 't'},
+        {"frame-hashes", required_argument, 0, 'H'},
         {"fullscreen", no_argument, 0, 'f'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
@@ -221,7 +249,7 @@ int main(int argc, char** argv) {
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "g:i:m:r:p:b:n:St:H:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -284,6 +312,28 @@ int main(int argc, char** argv) {
             case 'p':
                 movie_play = optarg;
                 break;
+            case 'b':
+                benchmark_output = optarg;
+                break;
+            case 'n':
+                errno = 0;
+                benchmark_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 'S':
+                save_title_settings = true;
+                break;
+            case 't':
+                trace_output = optarg;
+                break;
+            case 'H':
+                frame_hashes_output = optarg;
+                break;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -322,6 +372,16 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    if (!benchmark_output.empty() && movie_play.empty() && benchmark_frames == 0) {
+        LOG_CRITICAL(Frontend, "Benchmark mode needs a movie to play or a number of frames");
+        return -1;
+    }
+
+    if (save_title_settings && benchmark_output.empty()) {
+        LOG_CRITICAL(Frontend, "Saving the title settings needs benchmark mode");
+        return -1;
+    }
+
     if (!movie_record.empty()) {
         Core::Movie::GetInstance().PrepareForRecording();
     }
@@ -332,6 +392,17 @@ int main(int argc, char** argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (!benchmark_output.empty()) {
+        // Measure how fast the emulation can run, not how well it keeps up with real time
+        Settings::values.use_frame_limit = false;
+    }
+    if (save_title_settings) {
+        // The settings being measured are the ones of the configuration
+        Settings::values.use_title_settings = false;
+    }
+    if (!frame_hashes_output.empty()) {
+        Settings::values.deterministic = true;
+    }
     Settings::Apply();
 
     // Register frontend applets
@@ -392,15 +463,75 @@ int main(int argc, char** argv) {
         }
     }
 
+    FileUtil::IOFile frame_hashes;
+    if (!frame_hashes_output.empty()) {
+        frame_hashes.Open(frame_hashes_output, "w");
+        if (!frame_hashes.IsOpen()) {
+            LOG_CRITICAL(Frontend, "Failed to open the frame hash file {}", frame_hashes_output);
+            return -1;
+        }
+        GPU::SetFrameHashCallback([&frame_hashes](u64 hash) {
+            frame_hashes.WriteString(fmt::format("{:016X}\n", hash));
+        });
+    }
+
+    std::unique_ptr<Benchmark> benchmark;
+    if (!benchmark_output.empty()) {
+        benchmark = std::make_unique<Benchmark>(benchmark_output, benchmark_frames);
+    }
+
     if (!movie_play.empty()) {
-        Core::Movie::GetInstance().StartPlayback(movie_play);
+        if (benchmark) {
+            Core::Movie::GetInstance().StartPlayback(movie_play,
+                                                     [&benchmark] { benchmark->Finish(); });
+        } else {
+            Core::Movie::GetInstance().StartPlayback(movie_play);
+        }
     }
     if (!movie_record.empty()) {
         Core::Movie::GetInstance().StartRecording(movie_record);
     }
 
-    while (emu_window->IsOpen()) {
+    if (!trace_output.empty()) {
+        constexpr u64 DEFAULT_TRACE_FRAMES = 300;
+        const u64 trace_frames = benchmark_frames != 0 ? benchmark_frames : DEFAULT_TRACE_FRAMES;
+        if (!Common::Profiling::StartTraceCapture(trace_output, static_cast<u32>(trace_frames))) {
+            return -1;
+        }
+    }
+
+    // The SDL frontend runs the emulated CPU on its main thread
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::CPU};
+    while (emu_window->IsOpen() && !(benchmark && benchmark->IsFinished())) {
         system.RunLoop();
+        if (benchmark) {
+            benchmark->Update(system);
+        }
+    }
+
+    Common::Profiling::StopTraceCapture();
+
+    if (benchmark && !benchmark->WriteResults()) {
+        return -1;
+    }
+
+    if (save_title_settings) {
+        // Which of the measured configurations render the title correctly, for example going by
+        // --frame-hashes, is for the caller to decide
+        u64 title_id{0};
+        system.GetAppLoader().ReadProgramId(title_id);
+        const double speed = benchmark->GetMeanSpeed();
+        const auto stored = Settings::LoadTitleSettings(title_id);
+        // Settings written by hand, without a benchmark speed, are never replaced
+        if (!stored || (stored->benchmark_speed && *stored->benchmark_speed < speed)) {
+            Settings::TitleSettings settings = Settings::GetCurrentTitleSettings();
+            settings.benchmark_speed = speed;
+            if (!Settings::SaveTitleSettings(title_id, settings)) {
+                return -1;
+            }
+            LOG_INFO(Frontend, "Stored the settings of {:016X}, mean speed {:.3f}", title_id,
+                     speed);
+        }
     }
 
     Core::Movie::GetInstance().Shutdown();
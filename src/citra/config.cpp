@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <iomanip>
 #include <memory>
 #include <sstream>
@@ -103,6 +104,15 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.cpu_clock_percentage = std::clamp(
+        static_cast<int>(sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100)), 25, 400);
+    Settings::values.skip_idle_loops = sdl2_config->GetBoolean("Core", "skip_idle_loops", true);
+    Settings::values.skip_idle_loops_exclusions =
+        sdl2_config->GetString("Core", "skip_idle_loops_exclusions", "");
+    Settings::values.deterministic = sdl2_config->GetBoolean("Core", "deterministic", false);
+    Settings::values.use_large_pages = sdl2_config->GetBoolean("Core", "use_large_pages", false);
+    Settings::values.use_title_settings =
+        sdl2_config->GetBoolean("Core", "use_title_settings", true);
 
     // Renderer
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
@@ -119,12 +129,42 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.use_async_shader_compilation =
+        sdl2_config->GetBoolean("Renderer", "use_async_shader_compilation", false);
+    Settings::values.use_fragment_ubershader =
+        sdl2_config->GetBoolean("Renderer", "use_fragment_ubershader", true);
+    Settings::values.use_shadow_depth_buffer =
+        sdl2_config->GetBoolean("Renderer", "use_shadow_depth_buffer", true);
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "sw_rasterizer_threads", 1));
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "vertex_shader_threads", 1));
+    Settings::values.use_gpu_thread =
+        sdl2_config->GetBoolean("Renderer", "use_gpu_thread", false);
+    Settings::values.use_async_present =
+        sdl2_config->GetBoolean("Renderer", "use_async_present", true);
+    Settings::values.use_compute_texture_decoding =
+        sdl2_config->GetBoolean("Renderer", "use_compute_texture_decoding", false);
+    Settings::values.texture_cache_budget =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "texture_cache_budget", 0));
+    Settings::values.custom_textures =
+        sdl2_config->GetBoolean("Renderer", "custom_textures", false);
+    Settings::values.dump_textures = sdl2_config->GetBoolean("Renderer", "dump_textures", false);
+    Settings::values.texture_filter = static_cast<Settings::TextureFilter>(
+        sdl2_config->GetInteger("Renderer", "texture_filter", 0));
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
+    Settings::values.resolution_fill_budget =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_fill_budget", 0));
     Settings::values.vsync_enabled = sdl2_config->GetBoolean("Renderer", "vsync_enabled", false);
     Settings::values.use_frame_limit = sdl2_config->GetBoolean("Renderer", "use_frame_limit", true);
     Settings::values.frame_limit =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit", 100));
+    Settings::values.max_frame_skip =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "max_frame_skip", 0));
+    Settings::values.low_power_mode = sdl2_config->GetBoolean("Renderer", "low_power_mode", false);
 
     Settings::values.toggle_3d = sdl2_config->GetBoolean("Renderer", "toggle_3d", false);
     Settings::values.factor_3d =
@@ -134,6 +174,9 @@ void Config::ReadValues() {
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 0.0);
     Settings::values.bg_blue = (float)sdl2_config->GetReal("Renderer", "bg_blue", 0.0);
 
+    Settings::values.show_perf_overlay =
+        sdl2_config->GetBoolean("Renderer", "show_perf_overlay", false);
+
     // Layout
     Settings::values.layout_option =
         static_cast<Settings::LayoutOption>(sdl2_config->GetInteger("Layout", "layout_option", 0));
@@ -160,15 +203,21 @@ void Config::ReadValues() {
     Settings::values.enable_dsp_lle = sdl2_config->GetBoolean("Audio", "enable_dsp_lle", false);
     Settings::values.enable_dsp_lle_multithread =
         sdl2_config->GetBoolean("Audio", "enable_dsp_lle_multithread", false);
+    Settings::values.enable_dsp_hle_multithread =
+        sdl2_config->GetBoolean("Audio", "enable_dsp_hle_multithread", false);
     Settings::values.sink_id = sdl2_config->GetString("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.enable_low_latency_audio =
+        sdl2_config->GetBoolean("Audio", "enable_low_latency_audio", false);
     Settings::values.audio_device_id = sdl2_config->GetString("Audio", "output_device", "auto");
     Settings::values.volume = sdl2_config->GetReal("Audio", "volume", 1);
 
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.romfs_access_trace =
+        sdl2_config->GetBoolean("Data Storage", "romfs_access_trace", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -220,6 +269,18 @@ void Config::ReadValues() {
 
     // Miscellaneous
     Settings::values.log_filter = sdl2_config->GetString("Miscellaneous", "log_filter", "*:Info");
+    Settings::values.log_binary = sdl2_config->GetBoolean("Miscellaneous", "log_binary", false);
+
+    // Threads
+    for (std::size_t i = 0; i < Common::NUM_THREAD_ROLES; ++i) {
+        const std::string name = Settings::thread_role_names[i];
+        auto& role = Settings::values.thread_roles[i];
+        role.affinity_mask =
+            static_cast<u32>(sdl2_config->GetInteger("Threads", name + "_thread_affinity", 0));
+        role.priority = static_cast<Common::ThreadPriority>(std::clamp(
+            static_cast<int>(sdl2_config->GetInteger("Threads", name + "_thread_priority", 1)), 0,
+            3));
+    }
 
     // Debugging
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
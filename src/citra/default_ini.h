@@ -91,6 +91,34 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Speed of the emulated CPU relative to the 3DS, in percent. Higher values fit more CPU work in
+# each frame at the cost of host performance, lower values make lighter titles cheaper to run.
+# 25 - 400 (default: 100)
+cpu_clock_percentage =
+
+# Whether to fast-forward to the next event when the CPU spins in a loop that only polls memory
+# 0: No, 1 (default): Yes
+skip_idle_loops =
+
+# Comma separated list of title IDs, in hex, for which idle loops are never skipped
+skip_idle_loops_exclusions =
+
+# Whether runs of the same inputs give the same result, for comparing frame hashes between builds.
+# The clock starts at init_time and the GPU thread, asynchronous shader compilation, custom
+# textures and multithreaded DSP are disabled.
+# 0 (default): Off, 1: On
+deterministic =
+
+# Whether to back the emulated RAM with 2 MiB pages, reducing TLB misses of the emulated CPU.
+# Needs huge pages enabled on Linux, or the "Lock pages in memory" privilege on Windows.
+# 0 (default): Off, 1: On
+use_large_pages =
+
+# Whether to apply the settings stored for the running title in the title_settings directory of
+# the configuration, which override the ones of this file. See --save-title-settings.
+# 0: No, 1 (default): Yes
+use_title_settings =
+
 [Renderer]
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
@@ -112,11 +140,72 @@ shaders_accurate_gs =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to store generated OpenGL shaders on disk and preload them when a title boots
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# Whether to compile new shaders in the background instead of stalling the emulation.
+# Draws are skipped or fall back to software vertex processing until the shader is ready.
+# 0 (default): Off, 1: On
+use_async_shader_compilation =
+
+# Whether draws waiting for their fragment shader use a slower shader that handles most states,
+# instead of being skipped. Fragment lighting, procedural textures and shadows aren't handled.
+# Only used with use_async_shader_compilation. 0: Off, 1 (default): On
+use_fragment_ubershader =
+
+# Whether shadow rendering draws use the depth test instead of image atomics where they can.
+# Needs compute shader support. 0: Off, 1 (default): On
+use_shadow_depth_buffer =
+
+# Number of threads shading triangles when the software renderer is used
+# 0: One per CPU core, 1 (default): Rasterize on the emulation thread, Otherwise the number of threads
+sw_rasterizer_threads =
+
+# Number of threads shading the vertices of large draws that aren't processed by the GPU
+# 0: One per CPU core, 1 (default): Shade on the emulation thread, Otherwise the number of threads
+vertex_shader_threads =
+
+# Whether to process GPU command lists on a separate thread, overlapping them with CPU emulation
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
+# Whether the GPU thread presents frames without the emulation thread waiting for it, so that
+# emulation can run up to two frames ahead of the screen. Only used with use_gpu_thread.
+# 0: Off, 1 (default): On
+use_async_present =
+
+# Whether to decode tiled textures and encode flushed surfaces on the GPU with compute shaders.
+# Requires OpenGL 4.3 (compute shaders), falls back to the CPU otherwise.
+# 0 (default): Off, 1: On
+use_compute_texture_decoding =
+
+# Video memory in MiB the cached surfaces may use before the least recently used ones are evicted
+# 0 (default): No limit, Otherwise the budget in MiB
+texture_cache_budget =
+
+# Whether to replace textures with the DDS or KTX files in load/textures/<title id>/
+# 0 (default): Off, 1: On
+custom_textures =
+
+# Whether to write every texture the title uses to dump/textures/<title id>/, as DDS files named
+# like the replacements in load/textures/. 0 (default): Off, 1: On
+dump_textures =
+
+# Filter upscaling the textures to the resolution scale factor, on the GPU once per texture load.
+# Requires compute shader support. 0 (default): None, 1: Scale2x
+texture_filter =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
 resolution_factor =
 
+# Millions of scaled pixels the render targets may be drawn with per frame. The resolution factor
+# of render targets is lowered while frames draw more than this, down to native.
+# 0 (default): No limit, Otherwise the budget in millions of pixels
+resolution_fill_budget =
+
 # Whether to enable V-Sync (caps the framerate at 60FPS) or not.
 # 0 (default): Off, 1: On
 vsync_enabled =
@@ -129,6 +218,16 @@ use_frame_limit =
 # 1 - 9999: Speed limit as a percentage of target game speed. 100 (default)
 frame_limit =
 
+# Skips presenting frames while emulation runs behind the frame limiter's target speed. Games still
+# render every frame, only drawing the screens to the window is skipped.
+# 0 (default): Off, 1 - 10: Maximum number of frames skipped in a row
+max_frame_skip =
+
+# Saves power on battery powered devices: the frame limiter never lets emulation run faster than
+# the target game speed, neither above 100% nor to catch up after slow frames.
+# 0 (default): Off, 1: On
+low_power_mode =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 0.0 for all.
 bg_red =
@@ -143,6 +242,14 @@ toggle_3d =
 # 0 - 100: Intensity. 0 (default)
 factor_3d =
 
+# Whether to draw a performance overlay in the top left corner of the window. Each column of the
+# graph is a frame, stacking the time spent emulating the CPU (green), the GPU (blue) and
+# presenting (yellow). The line marks 16.7 ms, a red tick marks frames that compiled shaders.
+# The bars on the right are the surface cache size (purple, full at its budget or 1 GiB) and the
+# audio latency (cyan, full at 100 ms).
+# 0 (default): Off, 1: On
+show_perf_overlay =
+
 [Layout]
 # Layout for the screen inside the render window.
 # 0 (default): Default Top Bottom Screen, 1: Single Screen Only, 2: Large Screen Small Screen, 3: Side by Side
@@ -177,6 +284,11 @@ enable_dsp_lle =
 # 0 (default): No, 1: Yes
 enable_dsp_lle_thread =
 
+# Whether or not to generate the audio frames of DSP HLE on a different thread. Faster, but the
+# application sees the status of its audio buffers one frame (about 5 ms) later.
+# 0 (default): No, 1: Yes
+enable_dsp_hle_multithread =
+
 
 # Which audio output engine to use.
 # auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available)
@@ -188,6 +300,12 @@ output_engine =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether or not to keep the audio output latency low (about 20 ms), for rhythm games. Asks the
+# audio backend for small buffers and bypasses audio stretching while at full speed, at the cost of
+# more audio stutter when the emulation speed varies.
+# 0 (default): No, 1: Yes
+enable_low_latency_audio =
+
 # Which audio device to use.
 # auto (default): Auto-select
 output_device =
@@ -201,6 +319,11 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to record the RomFS reads of a title while it boots, and to read that data ahead of time
+# on its next launch
+# 0 (default): No, 1: Yes
+romfs_access_trace =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -246,6 +369,30 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Writes the log file in a compact binary format instead of text, which is much faster to write and
+# allows for longer logs. Convert it back to text with dist/scripting/decode_log.py.
+# 0 (default): Text, 1: Binary
+log_binary =
+
+[Threads]
+# Cores that each kind of thread may run on, as a bitmask of core numbers, e.g. 0x3 for the first
+# two cores: cpu for the emulated CPU, gpu for GPU command processing, audio for audio processing,
+# io for logging and input polling, ui for the main thread of the frontend
+# 0 (default): Any core
+cpu_thread_affinity =
+gpu_thread_affinity =
+audio_thread_affinity =
+io_thread_affinity =
+ui_thread_affinity =
+
+# Scheduling priority of each kind of thread. Very high usually needs extra privileges.
+# 0: Low, 1 (default): Normal, 2: High, 3: Very high
+cpu_thread_priority =
+gpu_thread_priority =
+audio_thread_priority =
+io_thread_priority =
+ui_thread_priority =
+
 [Debugging]
 # Port for listening to GDB connections.
 use_gdbstub=false
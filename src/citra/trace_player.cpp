@@ -0,0 +1,277 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include <getopt.h>
+#include <fmt/format.h>
+#include <glad/glad.h>
+#include "citra/benchmark.h"
+#include "citra/config.h"
+#include "citra/emu_window/emu_window_sdl2.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "core/hw/hw.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/player.h"
+#include "video_core/video_core.h"
+
+#ifdef _WIN32
+extern "C" {
+// tells Nvidia drivers to use the dedicated GPU by default on laptops with switchable graphics
+__declspec(dllexport) unsigned long NvOptimusEnablement = 0x00000001;
+}
+#endif
+
+namespace {
+
+void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <trace.ctf>\n"
+                 "Replays a CiTrace and reports the time taken by every frame\n"
+                 "-o, --output=[file]  Write the results as JSON to the given file\n"
+                 "-l, --loops=NUMBER   Number of times the trace is replayed, 1 by default\n"
+                 "-s, --software       Use the software rasterizer\n"
+                 "-h, --help           Display this help and exit\n"
+                 "-v, --version        Output version information and exit\n";
+}
+
+struct FrameSample {
+    /// Walltime spent replaying and presenting the frame, in milliseconds
+    double cpu_time_ms;
+    /// Time the GPU spent on the commands of the frame, in milliseconds
+    double gpu_time_ms = 0.0;
+};
+
+/// Measures the GPU time of frames with timer queries, whose results are read a few frames later
+class GPUTimer {
+public:
+    ~GPUTimer() {
+        ReadResults(0);
+        glDeleteQueries(static_cast<GLsizei>(free_queries.size()), free_queries.data());
+    }
+
+    void Begin() {
+        if (free_queries.empty()) {
+            free_queries.emplace_back();
+            glGenQueries(1, &free_queries.back());
+        }
+        current = free_queries.back();
+        free_queries.pop_back();
+        glBeginQuery(GL_TIME_ELAPSED, current);
+    }
+
+    /// @param sample where the GPU time is stored, or nullptr to drop it
+    void End(FrameSample* sample) {
+        glEndQuery(GL_TIME_ELAPSED);
+        pending.push_back({current, sample});
+        ReadResults(MAX_PENDING_QUERIES);
+    }
+
+private:
+    static constexpr std::size_t MAX_PENDING_QUERIES = 4;
+
+    struct PendingQuery {
+        GLuint query;
+        FrameSample* sample;
+    };
+
+    void ReadResults(std::size_t max_pending) {
+        while (pending.size() > max_pending) {
+            const PendingQuery& query = pending.front();
+            GLuint64 time_ns = 0;
+            glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &time_ns);
+            if (query.sample) {
+                query.sample->gpu_time_ms = static_cast<double>(time_ns) / 1000000.0;
+            }
+            free_queries.push_back(query.query);
+            pending.pop_front();
+        }
+    }
+
+    GLuint current = 0;
+    std::vector<GLuint> free_queries;
+    std::deque<PendingQuery> pending;
+};
+
+bool WriteResults(const std::string& output_path, const std::string& trace_path,
+                  const std::deque<FrameSample>& samples, const std::string& cpu_distribution,
+                  const std::string& gpu_distribution, double wall_time_s) {
+    std::string json = "{\n";
+    json += fmt::format("  \"build\": \"{} {}\",\n", Common::g_scm_branch, Common::g_scm_desc);
+    json += fmt::format("  \"trace\": \"{}\",\n", trace_path);
+    json += fmt::format("  \"rasterizer\": \"{}\",\n",
+                        Settings::values.use_hw_renderer ? "opengl" : "software");
+    json += fmt::format("  \"frames\": {},\n", samples.size());
+    json += fmt::format("  \"wall_time_s\": {:.3f},\n", wall_time_s);
+    json += fmt::format("  \"cpu_time_ms\": {},\n", cpu_distribution);
+    json += fmt::format("  \"gpu_time_ms\": {},\n", gpu_distribution);
+    json += "  \"per_frame\": [\n";
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        json += fmt::format("    {{\"cpu_time_ms\": {:.4f}, \"gpu_time_ms\": {:.4f}}}{}\n",
+                            samples[i].cpu_time_ms, samples[i].gpu_time_ms,
+                            i + 1 < samples.size() ? "," : "");
+    }
+    json += "  ]\n}\n";
+
+    FileUtil::IOFile file(output_path, "w");
+    if (!file.IsOpen() || file.WriteString(json) != json.size()) {
+        LOG_ERROR(Frontend, "Failed to write the replay results to {}", output_path);
+        return false;
+    }
+    return true;
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Config config;
+    std::string output_path;
+    u64 loops = 1;
+    bool software = false;
+    std::string trace_path;
+
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"loops", required_argument, 0, 'l'},
+        {"software", no_argument, 0, 's'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    char* endarg;
+    int option_index = 0;
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "o:l:shv", long_options, &option_index);
+        if (arg != -1) {
+            switch (arg) {
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'l':
+                errno = 0;
+                loops = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg || loops == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--loops");
+                    exit(1);
+                }
+                break;
+            case 's':
+                software = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc
+                          << std::endl;
+                return 0;
+            }
+        } else {
+            trace_path = argv[optind];
+            optind++;
+        }
+    }
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (trace_path.empty()) {
+        LOG_CRITICAL(Frontend, "No CiTrace specified");
+        return -1;
+    }
+
+    // Everything is rendered on this thread, as fast as it can, so that the timings only depend on
+    // the trace
+    if (software) {
+        Settings::values.use_hw_renderer = false;
+    }
+    Settings::values.use_gpu_thread = false;
+    Settings::values.vsync_enabled = false;
+    Settings::Apply();
+
+    EmuWindow_SDL2 emu_window{false};
+    Memory::MemorySystem memory;
+    HW::Init(memory);
+    SCOPE_EXIT({ HW::Shutdown(); });
+    if (VideoCore::Init(emu_window, memory) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to initialize the video core");
+        return -1;
+    }
+    SCOPE_EXIT({ VideoCore::Shutdown(); });
+
+    CiTrace::Player player{memory};
+    if (!player.Load(trace_path)) {
+        return -1;
+    }
+
+    // A deque keeps the samples in place while their GPU times are pending
+    std::deque<FrameSample> samples;
+    const auto start_time = std::chrono::steady_clock::now();
+    {
+        GPUTimer gpu_timer;
+        for (u64 loop = 0; loop < loops && emu_window.IsOpen(); ++loop) {
+            player.Reset();
+            while (emu_window.IsOpen()) {
+                gpu_timer.Begin();
+                const auto frame_start = std::chrono::steady_clock::now();
+                const bool presented = player.ReplayFrame();
+                const std::chrono::duration<double, std::milli> cpu_time =
+                    std::chrono::steady_clock::now() - frame_start;
+
+                // What follows the last frame marker is never displayed
+                if (!presented) {
+                    gpu_timer.End(nullptr);
+                    break;
+                }
+                samples.push_back({cpu_time.count()});
+                gpu_timer.End(&samples.back());
+            }
+        }
+    }
+    const double wall_time_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    for (const auto& sample : samples) {
+        cpu_times.push_back(sample.cpu_time_ms);
+        gpu_times.push_back(sample.gpu_time_ms);
+    }
+    const std::string cpu_distribution = FormatDistribution(std::move(cpu_times));
+    const std::string gpu_distribution = FormatDistribution(std::move(gpu_times));
+    LOG_INFO(Frontend, "Replayed {} frames in {:.3f} s", samples.size(), wall_time_s);
+    LOG_INFO(Frontend, "CPU time per frame (ms): {}", cpu_distribution);
+    LOG_INFO(Frontend, "GPU time per frame (ms): {}", gpu_distribution);
+
+    if (!output_path.empty() && !WriteResults(output_path, trace_path, samples, cpu_distribution,
+                                              gpu_distribution, wall_time_s)) {
+        return -1;
+    }
+    return 0;
+}
@@ -1,13 +1,19 @@
+#include <array>
+#include <optional>
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QKeyEvent>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
 #include <QScreen>
 #include <QWindow>
 #include <fmt/format.h>
 
 #include "citra_qt/bootmanager.h"
+#include "citra_qt/ui_settings.h"
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
+#include "common/thread.h"
 #include "core/3ds.h"
 #include "core/core.h"
 #include "core/settings.h"
@@ -19,50 +25,94 @@
 
 EmuThread::EmuThread(GRenderWindow* render_window) : render_window(render_window) {}
 
+void EmuThread::PostCommand(Command command) {
+    {
+        std::lock_guard lock{command_mutex};
+        commands.push_back({command, std::chrono::steady_clock::now()});
+    }
+    command_cv.notify_one();
+}
+
+void EmuThread::RequestStop() {
+    running = false;
+    PostCommand(Command::Stop);
+    // The thread only returns to its loop once frame advancing lets it finish the frame
+    Core::System::GetInstance().frame_limiter.SetFrameAdvancing(false);
+}
+
 void EmuThread::run() {
+    static constexpr std::array<const char*, 4> command_names{"Resume", "Pause", "Step", "Stop"};
+
     render_window->MakeCurrent();
 
     MicroProfileOnThreadCreate("EmuThread");
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::CPU};
 
-    stop_run = false;
-
+    // Whether emulation runs between commands, only changed by the commands and errors
+    bool active = false;
     // Holds whether the cpu was running during the last iteration,
     // so that the DebugModeLeft signal can be emitted before the
     // next execution step.
     bool was_active = false;
-    while (!stop_run) {
-        if (running) {
-            if (!was_active)
-                emit DebugModeLeft();
-
-            Core::System::ResultStatus result = Core::System::GetInstance().RunLoop();
-            if (result == Core::System::ResultStatus::ShutdownRequested) {
-                // Notify frontend we shutdown
-                emit ErrorThrown(result, "");
-                // End emulation execution
-                break;
+    while (true) {
+        // Handles the commands one at a time between slices of emulation, which are much shorter
+        // than a frame, and sleeps until the next command while paused
+        std::optional<PendingCommand> pending;
+        {
+            std::unique_lock lock{command_mutex};
+            if (!active) {
+                command_cv.wait(lock, [this] { return !commands.empty(); });
             }
-            if (result != Core::System::ResultStatus::Success) {
-                this->SetRunning(false);
-                emit ErrorThrown(result, Core::System::GetInstance().GetStatusDetails());
+            if (!commands.empty()) {
+                pending = commands.front();
+                commands.pop_front();
             }
+        }
 
-            was_active = running || exec_step;
-            if (!was_active && !stop_run)
-                emit DebugModeEntered();
-        } else if (exec_step) {
-            if (!was_active)
+        if (pending) {
+            LOG_DEBUG(Frontend, "{} took effect after {} us",
+                      command_names[static_cast<std::size_t>(pending->command)],
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - pending->posted)
+                          .count());
+
+            if (pending->command == Command::Stop) {
+                break;
+            }
+            if (pending->command == Command::Resume) {
+                active = true;
+            } else if (pending->command == Command::Pause) {
+                active = false;
+                if (was_active) {
+                    emit DebugModeEntered();
+                    was_active = false;
+                }
+            } else if (!active) {
                 emit DebugModeLeft();
+                Core::System::GetInstance().SingleStep();
+                emit DebugModeEntered();
+            }
+            continue;
+        }
 
-            exec_step = false;
-            Core::System::GetInstance().SingleStep();
-            emit DebugModeEntered();
-            yieldCurrentThread();
+        if (!was_active) {
+            emit DebugModeLeft();
+            was_active = true;
+        }
 
+        Core::System::ResultStatus result = Core::System::GetInstance().RunLoop();
+        if (result == Core::System::ResultStatus::ShutdownRequested) {
+            // Notify frontend we shutdown
+            emit ErrorThrown(result, "");
+            // End emulation execution
+            break;
+        }
+        if (result != Core::System::ResultStatus::Success) {
+            running = false;
+            active = false;
             was_active = false;
-        } else {
-            std::unique_lock<std::mutex> lock(running_mutex);
-            running_cv.wait(lock, [this] { return IsRunning() || exec_step || stop_run; });
+            emit DebugModeEntered();
+            emit ErrorThrown(result, Core::System::GetInstance().GetStatusDetails());
         }
     }
 
@@ -87,6 +137,9 @@ public:
     void paintEvent(QPaintEvent* ev) override {
         if (do_painting) {
             QPainter painter(this);
+        } else if (parent->IsPresentationDecoupled()) {
+            // This context is only used to present, show the last frame again
+            parent->PresentFrame();
         }
     }
 
@@ -115,9 +168,13 @@ GRenderWindow::GRenderWindow(QWidget* parent, EmuThread* emu_thread)
     setAttribute(Qt::WA_AcceptTouchEvents);
 
     InputCommon::Init();
+
+    connect(this, &GRenderWindow::FrameReady, this, &GRenderWindow::PresentFrame,
+            Qt::QueuedConnection);
 }
 
 GRenderWindow::~GRenderWindow() {
+    ReleaseEmuContext();
     InputCommon::Shutdown();
 }
 
@@ -129,7 +186,11 @@ void GRenderWindow::moveContext() {
     auto thread = (QThread::currentThread() == qApp->thread() && emu_thread != nullptr)
                       ? emu_thread
                       : qApp->thread();
-    child->context()->moveToThread(thread);
+    if (emu_context) {
+        emu_context->moveToThread(thread);
+    } else {
+        child->context()->moveToThread(thread);
+    }
 }
 
 void GRenderWindow::SwapBuffers() {
@@ -145,15 +206,64 @@ void GRenderWindow::SwapBuffers() {
 }
 
 void GRenderWindow::MakeCurrent() {
-    child->makeCurrent();
+    if (emu_context) {
+        emu_context->makeCurrent(emu_surface.get());
+    } else {
+        child->makeCurrent();
+    }
 }
 
 void GRenderWindow::DoneCurrent() {
-    child->doneCurrent();
+    if (emu_context) {
+        emu_context->doneCurrent();
+    } else {
+        child->doneCurrent();
+    }
 }
 
 void GRenderWindow::PollEvents() {}
 
+bool GRenderWindow::IsPresentationDecoupled() const {
+    return emu_context != nullptr;
+}
+
+void GRenderWindow::OnFrameReady() {
+    if (!present_pending.exchange(true)) {
+        emit FrameReady();
+    }
+}
+
+void GRenderWindow::PresentFrame() {
+    // Cleared first, so that a frame arriving while this one is presented queues another present
+    present_pending = false;
+
+    Frontend::FrameMailbox* mailbox = GetFrameMailbox();
+    if (!mailbox) {
+        return;
+    }
+
+    // Waiting for v-sync here blocks the UI thread, but never the emulation
+    child->makeCurrent();
+    if (mailbox->TryPresent()) {
+        child->swapBuffers();
+    }
+}
+
+void GRenderWindow::ReleaseEmuContext() {
+    if (!child) {
+        return;
+    }
+
+    if (GetFrameMailbox()) {
+        // The mailbox deletes its presentation objects, it needs the widget's context
+        child->makeCurrent();
+        SetFrameMailbox(nullptr);
+        child->doneCurrent();
+    }
+    emu_context.reset();
+    emu_surface.reset();
+}
+
 // On Qt 5.0+, this correctly gets the size of the framebuffer (pixels).
 //
 // Older versions get the window size (density independent pixels),
@@ -302,6 +412,8 @@ void GRenderWindow::OnClientAreaResized(unsigned width, unsigned height) {
 }
 
 void GRenderWindow::InitRenderTarget() {
+    ReleaseEmuContext();
+
     if (child) {
         delete child;
     }
@@ -328,6 +440,22 @@ void GRenderWindow::InitRenderTarget() {
     layout->setMargin(0);
     setLayout(layout);
 
+    if (UISettings::values.decoupled_presentation) {
+        // Emulation renders offscreen on a context of its own, this widget's context presents
+        QOpenGLContext* present_context = child->context()->contextHandle();
+        emu_context = std::make_unique<QOpenGLContext>();
+        emu_context->setFormat(present_context->format());
+        emu_context->setShareContext(present_context);
+        emu_surface = std::make_unique<QOffscreenSurface>();
+        emu_surface->setFormat(present_context->format());
+        emu_surface->create();
+        if (!emu_context->create()) {
+            LOG_ERROR(Frontend, "Failed to create a shared context, presenting from emulation");
+            emu_context.reset();
+            emu_surface.reset();
+        }
+    }
+
     OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
 
     OnFramebufferSizeChanged();
@@ -5,7 +5,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <QGLWidget>
 #include <QImage>
@@ -15,6 +18,8 @@
 #include "core/frontend/emu_window.h"
 
 class QKeyEvent;
+class QOffscreenSurface;
+class QOpenGLContext;
 class QScreen;
 class QTouchEvent;
 
@@ -39,8 +44,7 @@ public:
      * @note This function is thread-safe
      */
     void ExecStep() {
-        exec_step = true;
-        running_cv.notify_all();
+        PostCommand(Command::Step);
     }
 
     /**
@@ -49,10 +53,8 @@ public:
      * @note This function is thread-safe
      */
     void SetRunning(bool running) {
-        std::unique_lock<std::mutex> lock(running_mutex);
         this->running = running;
-        lock.unlock();
-        running_cv.notify_all();
+        PostCommand(running ? Command::Resume : Command::Pause);
     }
 
     /**
@@ -65,19 +67,28 @@ public:
     }
 
     /**
-     * Requests for the emulation thread to stop running
+     * Requests for the emulation thread to stop running, releasing it if it is held by frame
+     * advancing
      */
-    void RequestStop() {
-        stop_run = true;
-        SetRunning(false);
-    };
+    void RequestStop();
 
 private:
-    bool exec_step = false;
-    bool running = false;
-    std::atomic<bool> stop_run{false};
-    std::mutex running_mutex;
-    std::condition_variable running_cv;
+    /// Commands handled by the emulation thread between two slices of emulation
+    enum class Command { Resume, Pause, Step, Stop };
+
+    struct PendingCommand {
+        Command command;
+        std::chrono::steady_clock::time_point posted;
+    };
+
+    /// Queues a command and wakes the emulation thread if it is paused
+    void PostCommand(Command command);
+
+    /// Whether emulation was last requested to run
+    std::atomic<bool> running{false};
+    std::mutex command_mutex;
+    std::condition_variable command_cv;
+    std::deque<PendingCommand> commands;
 
     GRenderWindow* render_window;
 
@@ -115,6 +126,8 @@ public:
     void MakeCurrent() override;
     void DoneCurrent() override;
     void PollEvents() override;
+    bool IsPresentationDecoupled() const override;
+    void OnFrameReady() override;
 
     void BackupGeometry();
     void RestoreGeometry();
@@ -149,10 +162,16 @@ public slots:
     void OnEmulationStopping();
     void OnFramebufferSizeChanged();
 
+    /// Presents the most recent frame of the frame mailbox, when presentation is decoupled
+    void PresentFrame();
+
 signals:
     /// Emitted when the window is closed
     void Closed();
 
+    /// Emitted from the renderer's thread when a frame can be presented with PresentFrame
+    void FrameReady();
+
 private:
     std::pair<unsigned, unsigned> ScaleTouch(const QPointF pos) const;
     void TouchBeginEvent(const QTouchEvent* event);
@@ -162,8 +181,20 @@ private:
     void OnMinimalClientAreaChangeRequest(
         const std::pair<unsigned, unsigned>& minimal_size) override;
 
+    /// Deletes the frame mailbox and the emulation's context, if presentation is decoupled
+    void ReleaseEmuContext();
+
     GGLWidgetInternal* child;
 
+    /**
+     * When presentation is decoupled, the context emulation renders with. It shares objects with
+     * the widget's context, which stays on the UI thread to present the frames.
+     */
+    std::unique_ptr<QOpenGLContext> emu_context;
+    std::unique_ptr<QOffscreenSurface> emu_surface;
+    /// Set while a FrameReady signal is queued, so that the UI thread gets at most one
+    std::atomic<bool> present_pending{false};
+
     QByteArray geometry;
 
     EmuThread* emu_thread;
@@ -3,7 +3,6 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <cstring>
 #include <QImage>
 #include "citra_qt/camera/camera_util.h"
 #include "core/frontend/camera/factory.h"
@@ -171,18 +170,30 @@ static constexpr int V(int r, int g, int b) {
 }
 } // namespace YuvTable
 
-std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height) {
-    auto buffer = std::vector<u16>(width * height);
+/**
+ * Converts an image to the output format, applying the flips while reading it.
+ * @param source image of width x height pixels in QImage::Format_RGB32
+ */
+static std::vector<u16> ConvertImage(const QImage& source, int width, int height, bool output_rgb,
+                                     bool flip_horizontal, bool flip_vertical) {
+    std::vector<u16> buffer(width * height);
     auto dest = buffer.begin();
     bool write = false;
     int py, pu, pv;
     for (int y = 0; y < height; ++y) {
+        const QRgb* line =
+            reinterpret_cast<const QRgb*>(source.constScanLine(flip_vertical ? height - 1 - y : y));
         for (int x = 0; x < width; ++x) {
-            QRgb rgb = source.pixel(x, y);
+            const QRgb rgb = line[flip_horizontal ? width - 1 - x : x];
             int r = qRed(rgb);
             int g = qGreen(rgb);
             int b = qBlue(rgb);
 
+            if (output_rgb) {
+                *(dest++) = static_cast<u16>((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+                continue;
+            }
+
             // The following transformation is a reverse of the one in Y2R using ITU_Rec601
             int y = YuvTable::Y(r, g, b);
             int u = YuvTable::U(r, g, b);
@@ -206,24 +217,29 @@ std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height) {
     return buffer;
 }
 
+std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height) {
+    return ConvertImage(source.convertToFormat(QImage::Format_RGB32), width, height, false, false,
+                        false);
+}
+
 std::vector<u16> ProcessImage(const QImage& image, int width, int height, bool output_rgb = false,
                               bool flip_horizontal = false, bool flip_vertical = false) {
-    std::vector<u16> buffer(width * height);
     if (image.isNull()) {
-        return buffer;
+        return std::vector<u16>(width * height);
     }
-    QImage scaled =
-        image.scaled(width, height, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-    QImage transformed =
-        scaled.copy((scaled.width() - width) / 2, (scaled.height() - height) / 2, width, height)
-            .mirrored(flip_horizontal, flip_vertical);
-    if (output_rgb) {
-        QImage converted = transformed.convertToFormat(QImage::Format_RGB16);
-        std::memcpy(buffer.data(), converted.bits(), width * height * sizeof(u16));
-    } else {
-        return CameraUtil::Rgb2Yuv(transformed, width, height);
+    // Crop to the aspect ratio of the output first, so that only the pixels kept are scaled
+    const QSize cropped_size = QSize(width, height).scaled(image.size(), Qt::KeepAspectRatio);
+    const QImage cropped =
+        image.copy((image.width() - cropped_size.width()) / 2,
+                   (image.height() - cropped_size.height()) / 2, cropped_size.width(),
+                   cropped_size.height());
+    const QImage scaled =
+        cropped.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_RGB32);
+    if (scaled.isNull()) {
+        return std::vector<u16>(width * height);
     }
-    return buffer;
+    return ConvertImage(scaled, width, height, output_rgb, flip_horizontal, flip_vertical);
 }
 
 } // namespace CameraUtil
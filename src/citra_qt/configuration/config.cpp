@@ -9,6 +9,7 @@
 #include "citra_qt/ui_settings.h"
 #include "common/file_util.h"
 #include "core/hle/service/service.h"
+#include "core/title_settings.h"
 #include "input_common/main.h"
 #include "input_common/udp/client.h"
 #include "network/network.h"
@@ -120,6 +121,14 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = ReadSetting("use_cpu_jit", true).toBool();
+    Settings::values.cpu_clock_percentage =
+        std::clamp(ReadSetting("cpu_clock_percentage", 100).toInt(), 25, 400);
+    Settings::values.skip_idle_loops = ReadSetting("skip_idle_loops", true).toBool();
+    Settings::values.skip_idle_loops_exclusions =
+        ReadSetting("skip_idle_loops_exclusions", "").toString().toStdString();
+    Settings::values.deterministic = ReadSetting("deterministic", false).toBool();
+    Settings::values.use_large_pages = ReadSetting("use_large_pages", false).toBool();
+    Settings::values.use_title_settings = ReadSetting("use_title_settings", true).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -135,11 +144,34 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_gs = ReadSetting("shaders_accurate_gs", true).toBool();
     Settings::values.shaders_accurate_mul = ReadSetting("shaders_accurate_mul", false).toBool();
     Settings::values.use_shader_jit = ReadSetting("use_shader_jit", true).toBool();
+    Settings::values.use_disk_shader_cache = ReadSetting("use_disk_shader_cache", true).toBool();
+    Settings::values.use_async_shader_compilation =
+        ReadSetting("use_async_shader_compilation", false).toBool();
+    Settings::values.use_fragment_ubershader =
+        ReadSetting("use_fragment_ubershader", true).toBool();
+    Settings::values.use_shadow_depth_buffer =
+        ReadSetting("use_shadow_depth_buffer", true).toBool();
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(ReadSetting("sw_rasterizer_threads", 1).toUInt());
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(ReadSetting("vertex_shader_threads", 1).toUInt());
+    Settings::values.use_compute_texture_decoding =
+        ReadSetting("use_compute_texture_decoding", false).toBool();
+    Settings::values.texture_cache_budget =
+        static_cast<u16>(ReadSetting("texture_cache_budget", 0).toUInt());
+    Settings::values.custom_textures = ReadSetting("custom_textures", false).toBool();
+    Settings::values.dump_textures = ReadSetting("dump_textures", false).toBool();
+    Settings::values.texture_filter =
+        static_cast<Settings::TextureFilter>(ReadSetting("texture_filter", 0).toInt());
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting("resolution_factor", 1).toInt());
+    Settings::values.resolution_fill_budget =
+        static_cast<u16>(ReadSetting("resolution_fill_budget", 0).toUInt());
     Settings::values.vsync_enabled = ReadSetting("vsync_enabled", false).toBool();
     Settings::values.use_frame_limit = ReadSetting("use_frame_limit", true).toBool();
     Settings::values.frame_limit = ReadSetting("frame_limit", 100).toInt();
+    Settings::values.max_frame_skip = ReadSetting("max_frame_skip", 0).toInt();
+    Settings::values.low_power_mode = ReadSetting("low_power_mode", false).toBool();
 
     Settings::values.bg_red = ReadSetting("bg_red", 0.0).toFloat();
     Settings::values.bg_green = ReadSetting("bg_green", 0.0).toFloat();
@@ -148,6 +180,7 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Layout");
     Settings::values.toggle_3d = ReadSetting("toggle_3d", false).toBool();
+    Settings::values.show_perf_overlay = ReadSetting("show_perf_overlay", false).toBool();
     Settings::values.factor_3d = ReadSetting("factor_3d", 0).toInt();
     Settings::values.layout_option =
         static_cast<Settings::LayoutOption>(ReadSetting("layout_option").toInt());
@@ -167,9 +200,13 @@ void Config::ReadValues() {
     Settings::values.enable_dsp_lle = ReadSetting("enable_dsp_lle", false).toBool();
     Settings::values.enable_dsp_lle_multithread =
         ReadSetting("enable_dsp_lle_multithread", false).toBool();
+    Settings::values.enable_dsp_hle_multithread =
+        ReadSetting("enable_dsp_hle_multithread", false).toBool();
     Settings::values.sink_id = ReadSetting("output_engine", "auto").toString().toStdString();
     Settings::values.enable_audio_stretching =
         ReadSetting("enable_audio_stretching", true).toBool();
+    Settings::values.enable_low_latency_audio =
+        ReadSetting("enable_low_latency_audio", false).toBool();
     Settings::values.audio_device_id =
         ReadSetting("output_device", "auto").toString().toStdString();
     Settings::values.volume = ReadSetting("volume", 1).toFloat();
@@ -198,6 +235,7 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = ReadSetting("use_virtual_sd", true).toBool();
+    Settings::values.romfs_access_trace = ReadSetting("romfs_access_trace", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -211,6 +249,17 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Miscellaneous");
     Settings::values.log_filter = ReadSetting("log_filter", "*:Info").toString().toStdString();
+    Settings::values.log_binary = ReadSetting("log_binary", false).toBool();
+    qt_config->endGroup();
+
+    qt_config->beginGroup("Threads");
+    for (std::size_t i = 0; i < Common::NUM_THREAD_ROLES; ++i) {
+        const QString name = QString::fromUtf8(Settings::thread_role_names[i]);
+        auto& role = Settings::values.thread_roles[i];
+        role.affinity_mask = ReadSetting(name + "_thread_affinity", 0).toUInt();
+        role.priority = static_cast<Common::ThreadPriority>(
+            std::clamp(ReadSetting(name + "_thread_priority", 1).toInt(), 0, 3));
+    }
     qt_config->endGroup();
 
     qt_config->beginGroup("Debugging");
@@ -345,6 +394,8 @@ void Config::ReadValues() {
     UISettings::values.first_start = ReadSetting("firstStart", true).toBool();
     UISettings::values.callout_flags = ReadSetting("calloutFlags", 0).toUInt();
     UISettings::values.show_console = ReadSetting("showConsole", false).toBool();
+    UISettings::values.decoupled_presentation =
+        ReadSetting("decoupledPresentation", false).toBool();
 
     qt_config->beginGroup("Multiplayer");
     UISettings::values.nickname = ReadSetting("nickname", "").toString();
@@ -417,6 +468,13 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     WriteSetting("use_cpu_jit", Settings::values.use_cpu_jit, true);
+    WriteSetting("cpu_clock_percentage", Settings::values.cpu_clock_percentage, 100);
+    WriteSetting("skip_idle_loops", Settings::values.skip_idle_loops, true);
+    WriteSetting("skip_idle_loops_exclusions",
+                 QString::fromStdString(Settings::values.skip_idle_loops_exclusions), "");
+    WriteSetting("deterministic", Settings::values.deterministic, false);
+    WriteSetting("use_large_pages", Settings::values.use_large_pages, false);
+    WriteSetting("use_title_settings", Settings::values.use_title_settings, true);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -425,10 +483,26 @@ void Config::SaveValues() {
     WriteSetting("shaders_accurate_gs", Settings::values.shaders_accurate_gs, true);
     WriteSetting("shaders_accurate_mul", Settings::values.shaders_accurate_mul, false);
     WriteSetting("use_shader_jit", Settings::values.use_shader_jit, true);
+    WriteSetting("use_disk_shader_cache", Settings::values.use_disk_shader_cache, true);
+    WriteSetting("use_async_shader_compilation", Settings::values.use_async_shader_compilation,
+                 false);
+    WriteSetting("use_fragment_ubershader", Settings::values.use_fragment_ubershader, true);
+    WriteSetting("use_shadow_depth_buffer", Settings::values.use_shadow_depth_buffer, true);
+    WriteSetting("sw_rasterizer_threads", Settings::values.sw_rasterizer_threads, 1);
+    WriteSetting("vertex_shader_threads", Settings::values.vertex_shader_threads, 1);
+    WriteSetting("use_compute_texture_decoding", Settings::values.use_compute_texture_decoding,
+                 false);
+    WriteSetting("texture_cache_budget", Settings::values.texture_cache_budget, 0);
+    WriteSetting("custom_textures", Settings::values.custom_textures, false);
+    WriteSetting("dump_textures", Settings::values.dump_textures, false);
+    WriteSetting("texture_filter", static_cast<int>(Settings::values.texture_filter), 0);
     WriteSetting("resolution_factor", Settings::values.resolution_factor, 1);
+    WriteSetting("resolution_fill_budget", Settings::values.resolution_fill_budget, 0);
     WriteSetting("vsync_enabled", Settings::values.vsync_enabled, false);
     WriteSetting("use_frame_limit", Settings::values.use_frame_limit, true);
     WriteSetting("frame_limit", Settings::values.frame_limit, 100);
+    WriteSetting("max_frame_skip", Settings::values.max_frame_skip, 0);
+    WriteSetting("low_power_mode", Settings::values.low_power_mode, false);
 
     // Cast to double because Qt's written float values are not human-readable
     WriteSetting("bg_red", (double)Settings::values.bg_red, 0.0);
@@ -438,6 +512,7 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Layout");
     WriteSetting("toggle_3d", Settings::values.toggle_3d, false);
+    WriteSetting("show_perf_overlay", Settings::values.show_perf_overlay, false);
     WriteSetting("factor_3d", Settings::values.factor_3d.load(), 0);
     WriteSetting("layout_option", static_cast<int>(Settings::values.layout_option));
     WriteSetting("swap_screen", Settings::values.swap_screen, false);
@@ -455,8 +530,10 @@ void Config::SaveValues() {
     qt_config->beginGroup("Audio");
     WriteSetting("enable_dsp_lle", Settings::values.enable_dsp_lle, false);
     WriteSetting("enable_dsp_lle_multithread", Settings::values.enable_dsp_lle_multithread, false);
+    WriteSetting("enable_dsp_hle_multithread", Settings::values.enable_dsp_hle_multithread, false);
     WriteSetting("output_engine", QString::fromStdString(Settings::values.sink_id), "auto");
     WriteSetting("enable_audio_stretching", Settings::values.enable_audio_stretching, true);
+    WriteSetting("enable_low_latency_audio", Settings::values.enable_low_latency_audio, false);
     WriteSetting("output_device", QString::fromStdString(Settings::values.audio_device_id), "auto");
     WriteSetting("volume", Settings::values.volume, 1.0f);
     qt_config->endGroup();
@@ -482,6 +559,7 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     WriteSetting("use_virtual_sd", Settings::values.use_virtual_sd, true);
+    WriteSetting("romfs_access_trace", Settings::values.romfs_access_trace, false);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -495,6 +573,16 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Miscellaneous");
     WriteSetting("log_filter", QString::fromStdString(Settings::values.log_filter), "*:Info");
+    WriteSetting("log_binary", Settings::values.log_binary, false);
+    qt_config->endGroup();
+
+    qt_config->beginGroup("Threads");
+    for (std::size_t i = 0; i < Common::NUM_THREAD_ROLES; ++i) {
+        const QString name = QString::fromUtf8(Settings::thread_role_names[i]);
+        const auto& role = Settings::values.thread_roles[i];
+        WriteSetting(name + "_thread_affinity", role.affinity_mask, 0);
+        WriteSetting(name + "_thread_priority", static_cast<u32>(role.priority), 1);
+    }
     qt_config->endGroup();
 
     qt_config->beginGroup("Debugging");
@@ -578,6 +666,7 @@ void Config::SaveValues() {
     WriteSetting("firstStart", UISettings::values.first_start, true);
     WriteSetting("calloutFlags", UISettings::values.callout_flags, 0);
     WriteSetting("showConsole", UISettings::values.show_console, false);
+    WriteSetting("decoupledPresentation", UISettings::values.decoupled_presentation, false);
 
     qt_config->beginGroup("Multiplayer");
     WriteSetting("nickname", UISettings::values.nickname, "");
@@ -640,5 +729,6 @@ void Config::Reload() {
 }
 
 void Config::Save() {
-    SaveValues();
+    // The settings of the running title aren't part of the configuration
+    Settings::WithoutTitleSettings([this] { SaveValues(); });
 }
@@ -21,6 +21,7 @@ ConfigureAudio::ConfigureAudio(QWidget* parent)
     }
 
     ui->emulation_combo_box->addItem(tr("HLE (fast)"));
+    ui->emulation_combo_box->addItem(tr("HLE multi-core"));
     ui->emulation_combo_box->addItem(tr("LLE (accurate)"));
     ui->emulation_combo_box->addItem(tr("LLE multi-core"));
     ui->emulation_combo_box->setEnabled(!Core::System::GetInstance().IsPoweredOn());
@@ -45,18 +46,23 @@ void ConfigureAudio::setConfiguration() {
     setAudioDeviceFromDeviceID();
 
     ui->toggle_audio_stretching->setChecked(Settings::values.enable_audio_stretching);
+    ui->toggle_low_latency_audio->setChecked(Settings::values.enable_low_latency_audio);
     ui->volume_slider->setValue(Settings::values.volume * ui->volume_slider->maximum());
     setVolumeIndicatorText(ui->volume_slider->sliderPosition());
 
     int selection;
     if (Settings::values.enable_dsp_lle) {
         if (Settings::values.enable_dsp_lle_multithread) {
-            selection = 2;
+            selection = 3;
         } else {
-            selection = 1;
+            selection = 2;
         }
     } else {
-        selection = 0;
+        if (Settings::values.enable_dsp_hle_multithread) {
+            selection = 1;
+        } else {
+            selection = 0;
+        }
     }
     ui->emulation_combo_box->setCurrentIndex(selection);
 }
@@ -98,13 +104,15 @@ void ConfigureAudio::applyConfiguration() {
         ui->output_sink_combo_box->itemText(ui->output_sink_combo_box->currentIndex())
             .toStdString();
     Settings::values.enable_audio_stretching = ui->toggle_audio_stretching->isChecked();
+    Settings::values.enable_low_latency_audio = ui->toggle_low_latency_audio->isChecked();
     Settings::values.audio_device_id =
         ui->audio_device_combo_box->itemText(ui->audio_device_combo_box->currentIndex())
             .toStdString();
     Settings::values.volume =
         static_cast<float>(ui->volume_slider->sliderPosition()) / ui->volume_slider->maximum();
-    Settings::values.enable_dsp_lle = ui->emulation_combo_box->currentIndex() != 0;
-    Settings::values.enable_dsp_lle_multithread = ui->emulation_combo_box->currentIndex() == 2;
+    Settings::values.enable_dsp_lle = ui->emulation_combo_box->currentIndex() >= 2;
+    Settings::values.enable_dsp_lle_multithread = ui->emulation_combo_box->currentIndex() == 3;
+    Settings::values.enable_dsp_hle_multithread = ui->emulation_combo_box->currentIndex() == 1;
 }
 
 void ConfigureAudio::updateAudioDevices(int sink_index) {
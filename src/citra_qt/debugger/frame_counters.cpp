@@ -0,0 +1,58 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QHeaderView>
+#include <QTreeWidget>
+#include "citra_qt/debugger/frame_counters.h"
+#include "common/frame_counters.h"
+
+FrameCountersWidget::FrameCountersWidget(QWidget* parent)
+    : QDockWidget(tr("Frame Counters"), parent) {
+    setObjectName("FrameCountersWidget");
+
+    tree = new QTreeWidget(this);
+    tree->setColumnCount(2);
+    tree->setHeaderLabels({tr("Counter"), tr("Last Frame")});
+    tree->setRootIsDecorated(false);
+    tree->setSortingEnabled(true);
+    tree->sortByColumn(0, Qt::AscendingOrder);
+    tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    setWidget(tree);
+
+    // Counts change every frame, refreshing at a fixed rate keeps them readable
+    update_timer.setInterval(500);
+    connect(&update_timer, &QTimer::timeout, this, &FrameCountersWidget::UpdateCounters);
+}
+
+FrameCountersWidget::~FrameCountersWidget() = default;
+
+void FrameCountersWidget::showEvent(QShowEvent* event) {
+    UpdateCounters();
+    update_timer.start();
+    QDockWidget::showEvent(event);
+}
+
+void FrameCountersWidget::hideEvent(QHideEvent* event) {
+    update_timer.stop();
+    QDockWidget::hideEvent(event);
+}
+
+void FrameCountersWidget::UpdateCounters() {
+    const auto counters = Common::GetLastFrameCounters();
+
+    // Counters are never removed, so the existing rows keep their position in the list
+    for (std::size_t i = static_cast<std::size_t>(tree->topLevelItemCount()); i < counters.size();
+         ++i) {
+        auto* item = new QTreeWidgetItem();
+        item->setText(0, QString::fromStdString(counters[i].name));
+        item->setData(0, Qt::UserRole, static_cast<int>(i));
+        tree->addTopLevelItem(item);
+    }
+
+    for (int row = 0; row < tree->topLevelItemCount(); ++row) {
+        QTreeWidgetItem* item = tree->topLevelItem(row);
+        const auto index = static_cast<std::size_t>(item->data(0, Qt::UserRole).toInt());
+        item->setData(1, Qt::DisplayRole, QVariant::fromValue<qulonglong>(counters[index].value));
+    }
+}
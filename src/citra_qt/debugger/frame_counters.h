@@ -0,0 +1,29 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QTreeWidget;
+
+/// Shows the values of the Common::FrameCounter counters during the last emulated frame
+class FrameCountersWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit FrameCountersWidget(QWidget* parent = nullptr);
+    ~FrameCountersWidget();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    void UpdateCounters();
+
+    QTreeWidget* tree;
+    QTimer update_timer;
+};
@@ -8,6 +8,7 @@
 #include "common/assert.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/semaphore.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
@@ -50,14 +51,16 @@ std::size_t WaitTreeItem::Row() const {
     return row;
 }
 
-std::vector<std::unique_ptr<WaitTreeThread>> WaitTreeItem::MakeThreadItemList() {
+std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeItem::MakeItemList() {
     const auto& threads = Core::System::GetInstance().Kernel().GetThreadManager().GetThreadList();
-    std::vector<std::unique_ptr<WaitTreeThread>> item_list;
-    item_list.reserve(threads.size());
+    std::vector<std::unique_ptr<WaitTreeItem>> item_list;
+    item_list.reserve(threads.size() + 1);
     for (std::size_t i = 0; i < threads.size(); ++i) {
         item_list.push_back(std::make_unique<WaitTreeThread>(*threads[i]));
         item_list.back()->row = i;
     }
+    item_list.push_back(std::make_unique<WaitTreeObjectPools>());
+    item_list.back()->row = threads.size();
     return item_list;
 }
 
@@ -339,6 +342,24 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThreadList::GetChildren() con
     return list;
 }
 
+QString WaitTreeObjectPools::GetText() const {
+    return tr("kernel objects");
+}
+
+std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeObjectPools::GetChildren() const {
+    std::vector<std::unique_ptr<WaitTreeItem>> list;
+    for (const Kernel::ObjectPool* pool : Kernel::ObjectPool::GetPools()) {
+        const Kernel::ObjectPool::Stats stats = pool->GetStats();
+        list.push_back(std::make_unique<WaitTreeText>(
+            tr("%1: %2 live, %3 created, room for %4")
+                .arg(QString::fromUtf8(pool->GetName()))
+                .arg(stats.live)
+                .arg(stats.created)
+                .arg(stats.capacity)));
+    }
+    return list;
+}
+
 WaitTreeModel::WaitTreeModel(QObject* parent) : QAbstractItemModel(parent) {}
 
 QModelIndex WaitTreeModel::index(int row, int column, const QModelIndex& parent) const {
@@ -351,7 +372,7 @@ QModelIndex WaitTreeModel::index(int row, int column, const QModelIndex& parent)
         return createIndex(row, column, parent_item->Children()[row].get());
     }
 
-    return createIndex(row, column, thread_items[row].get());
+    return createIndex(row, column, items[row].get());
 }
 
 QModelIndex WaitTreeModel::parent(const QModelIndex& index) const {
@@ -367,7 +388,7 @@ QModelIndex WaitTreeModel::parent(const QModelIndex& index) const {
 
 int WaitTreeModel::rowCount(const QModelIndex& parent) const {
     if (!parent.isValid())
-        return static_cast<int>(thread_items.size());
+        return static_cast<int>(items.size());
 
     WaitTreeItem* parent_item = static_cast<WaitTreeItem*>(parent.internalPointer());
     parent_item->Expand();
@@ -393,11 +414,11 @@ QVariant WaitTreeModel::data(const QModelIndex& index, int role) const {
 }
 
 void WaitTreeModel::ClearItems() {
-    thread_items.clear();
+    items.clear();
 }
 
 void WaitTreeModel::InitItems() {
-    thread_items = WaitTreeItem::MakeThreadItemList();
+    items = WaitTreeItem::MakeItemList();
 }
 
 WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), parent) {
@@ -38,7 +38,8 @@ public:
     WaitTreeItem* Parent() const;
     const std::vector<std::unique_ptr<WaitTreeItem>>& Children() const;
     std::size_t Row() const;
-    static std::vector<std::unique_ptr<WaitTreeThread>> MakeThreadItemList();
+    /// Makes the top level items: the threads followed by the kernel object pools
+    static std::vector<std::unique_ptr<WaitTreeItem>> MakeItemList();
 
 private:
     std::size_t row;
@@ -153,6 +154,13 @@ private:
     const std::vector<Kernel::SharedPtr<Kernel::Thread>>& thread_list;
 };
 
+class WaitTreeObjectPools : public WaitTreeExpandableItem {
+    Q_OBJECT
+public:
+    QString GetText() const override;
+    std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
+};
+
 class WaitTreeModel : public QAbstractItemModel {
     Q_OBJECT
 
@@ -169,7 +177,7 @@ public:
     void InitItems();
 
 private:
-    std::vector<std::unique_ptr<WaitTreeThread>> thread_items;
+    std::vector<std::unique_ptr<WaitTreeItem>> items;
 };
 
 class WaitTreeWidget : public QDockWidget {
@@ -2,12 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QFuture>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
 #include "citra_qt/compatibility_list.h"
 #include "citra_qt/game_list.h"
 #include "citra_qt/game_list_p.h"
@@ -15,8 +24,10 @@
 #include "citra_qt/ui_settings.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
 
 namespace {
@@ -26,95 +37,247 @@ bool HasSupportedFileExtension(const std::string& file_name) {
 }
 } // Anonymous namespace
 
+/**
+ * Index of the metadata of the scanned files, persisted in the cache directory so that a scan only
+ * runs the loader on the files that changed since the previous one. An entry is stale once the size
+ * or the modification time of its file changed. Thread-safe.
+ */
+class GameListWorker::MetadataCache {
+public:
+    /// What the game list needs from the loader of a file
+    struct GameMetadata {
+        /// False if no loader supports the file
+        bool is_game = false;
+        u64 program_id = 0;
+        u64 extdata_id = 0;
+        Loader::FileType file_type = Loader::FileType::Unknown;
+        std::vector<u8> smdh;
+    };
+
+    MetadataCache() {
+        QFile file(GetPath());
+        if (!file.open(QIODevice::ReadOnly))
+            return;
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_6);
+        quint32 magic, version, count;
+        stream >> magic >> version >> count;
+        if (magic != Magic || version != Version)
+            return;
+
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            QString path;
+            Entry entry;
+            quint64 program_id, extdata_id;
+            quint32 file_type;
+            QByteArray smdh;
+            stream >> path >> entry.size >> entry.modified >> entry.metadata.is_game >>
+                program_id >> extdata_id >> file_type >> smdh;
+            entry.metadata.program_id = program_id;
+            entry.metadata.extdata_id = extdata_id;
+            entry.metadata.file_type = static_cast<Loader::FileType>(file_type);
+            entry.metadata.smdh.assign(smdh.begin(), smdh.end());
+            entries.emplace(std::move(path), std::move(entry));
+        }
+        if (stream.status() != QDataStream::Ok) {
+            LOG_WARNING(Frontend, "Game list cache is corrupted, rescanning all files");
+            entries.clear();
+        }
+    }
+
+    /// Returns the metadata of the file, running its loader only if the cached entry is stale
+    GameMetadata Get(const std::string& physical_name) {
+        const QString path = QString::fromStdString(physical_name);
+        const QFileInfo info(path);
+        const qint64 size = info.size();
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        {
+            std::lock_guard lock(mutex);
+            const auto it = entries.find(path);
+            if (it != entries.end() && it->second.size == size &&
+                it->second.modified == modified) {
+                it->second.used = true;
+                return it->second.metadata;
+            }
+        }
+
+        Entry entry{size, modified, ReadGameMetadata(physical_name), true};
+        GameMetadata metadata = entry.metadata;
+        std::lock_guard lock(mutex);
+        entries.insert_or_assign(path, std::move(entry));
+        return metadata;
+    }
+
+    /// Writes the entries used since the cache was loaded, dropping those of removed files
+    void Save() const {
+        FileUtil::CreateFullPath(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir));
+        QSaveFile file(GetPath());
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+
+        std::lock_guard lock(mutex);
+        const auto count = std::count_if(entries.begin(), entries.end(),
+                                         [](const auto& entry) { return entry.second.used; });
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_6);
+        stream << Magic << Version << static_cast<quint32>(count);
+        for (const auto& [path, entry] : entries) {
+            if (!entry.used)
+                continue;
+            const auto& smdh = entry.metadata.smdh;
+            stream << path << entry.size << entry.modified << entry.metadata.is_game
+                   << static_cast<quint64>(entry.metadata.program_id)
+                   << static_cast<quint64>(entry.metadata.extdata_id)
+                   << static_cast<quint32>(entry.metadata.file_type)
+                   << QByteArray(reinterpret_cast<const char*>(smdh.data()),
+                                 static_cast<int>(smdh.size()));
+        }
+        if (!file.commit()) {
+            LOG_WARNING(Frontend, "Failed to write the game list cache");
+        }
+    }
+
+private:
+    // "CGLC" - Citra Game List Cache
+    static constexpr quint32 Magic = 0x434C4743;
+    static constexpr quint32 Version = 1;
+
+    struct Entry {
+        qint64 size;
+        qint64 modified;
+        GameMetadata metadata;
+        /// Whether the file was part of the current scan
+        bool used = false;
+    };
+
+    static GameMetadata ReadGameMetadata(const std::string& path) {
+        GameMetadata metadata;
+        std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(path);
+        if (!loader)
+            return metadata;
+
+        metadata.is_game = true;
+        loader->ReadProgramId(metadata.program_id);
+        loader->ReadExtdataId(metadata.extdata_id);
+        loader->ReadIcon(metadata.smdh);
+        metadata.file_type = loader->GetFileType();
+        return metadata;
+    }
+
+    static QString GetPath() {
+        return QString::fromStdString(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir)) +
+               QStringLiteral("game_list.bin");
+    }
+
+    mutable std::mutex mutex;
+    std::map<QString, Entry> entries;
+};
+
 GameListWorker::GameListWorker(QList<UISettings::GameDir>& game_dirs,
                                const CompatibilityList& compatibility_list)
     : game_dirs(game_dirs), compatibility_list(compatibility_list) {}
 
 GameListWorker::~GameListWorker() = default;
 
-void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
-                                             GameListDir* parent_dir) {
-    const auto callback = [this, recursion, parent_dir](u64* num_entries_out,
-                                                        const std::string& directory,
-                                                        const std::string& virtual_name) -> bool {
+void GameListWorker::FindGameFiles(const std::string& dir_path, unsigned int recursion,
+                                   std::vector<std::string>& files) {
+    const auto callback = [this, recursion, &files](
+                              u64* num_entries_out, const std::string& directory,
+                              const std::string& virtual_name, bool is_dir) -> bool {
         if (stop_processing) {
             // Breaks the callback loop.
             return false;
         }
 
         const std::string physical_name = directory + DIR_SEP + virtual_name;
-        const bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            u64 extdata_id = 0;
-            loader->ReadExtdataId(extdata_id);
+            files.push_back(physical_name);
+        } else if (is_dir && recursion > 0) {
+            watch_list.append(QString::fromStdString(physical_name));
+            FindGameFiles(physical_name, recursion - 1, files);
+        }
 
-            std::vector<u8> smdh = [program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
+        return true;
+    };
 
-                if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
-                    return original_smdh;
+    FileUtil::ForeachTypedDirectoryEntry(nullptr, dir_path, callback);
+}
 
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
+void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
+                                             GameListDir* parent_dir) {
+    std::vector<std::string> files;
+    FindGameFiles(dir_path, recursion, files);
 
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
+    const auto get_metadata = [this](const std::string& physical_name) {
+        if (stop_processing)
+            return MetadataCache::GameMetadata{};
 
-                std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+        MetadataCache::GameMetadata metadata = cache->Get(physical_name);
+        const u64 program_id = metadata.program_id;
+        if (!metadata.is_game || program_id < 0x0004000000000000 ||
+            program_id > 0x00040000FFFFFFFF)
+            return metadata;
 
-                if (!update_loader)
-                    return original_smdh;
+        // Show the icon of the installed update, if there is one
+        std::string update_path = Service::AM::GetTitleContentPath(
+            Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
+        if (!FileUtil::Exists(update_path))
+            return metadata;
 
-                std::vector<u8> update_smdh;
-                update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }();
+        MetadataCache::GameMetadata update = cache->Get(update_path);
+        if (update.is_game) {
+            metadata.smdh = std::move(update.smdh);
+        }
+        return metadata;
+    };
 
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
-                // Skip this invalid entry
-                return true;
-            }
+    // The files are parsed in parallel, but added to the list in the order they were found
+    std::vector<QFuture<MetadataCache::GameMetadata>> results;
+    results.reserve(files.size());
+    for (const std::string& physical_name : files) {
+        results.push_back(QtConcurrent::run(
+            [&get_metadata, physical_name] { return get_metadata(physical_name); }));
+    }
 
-            auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
-
-            // The game list uses this as compatibility number for untested games
-            QString compatibility("99");
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
-
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                         extdata_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const MetadataCache::GameMetadata metadata = results[i].result();
+        if (stop_processing || !metadata.is_game)
+            continue;
 
-        } else if (is_dir && recursion > 0) {
-            watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+        const std::string& physical_name = files[i];
+        const std::vector<u8>& smdh = metadata.smdh;
+        if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
+            // Skip this invalid entry
+            continue;
         }
 
-        return true;
-    };
+        auto it = FindMatchingCompatibilityEntry(compatibility_list, metadata.program_id);
+
+        // The game list uses this as compatibility number for untested games
+        QString compatibility("99");
+        if (it != compatibility_list.end())
+            compatibility = it->second.first;
 
-    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+        emit EntryReady(
+            {
+                new GameListItemPath(QString::fromStdString(physical_name), smdh,
+                                     metadata.program_id, metadata.extdata_id),
+                new GameListItemCompat(compatibility),
+                new GameListItemRegion(smdh),
+                new GameListItem(
+                    QString::fromStdString(Loader::GetFileTypeString(metadata.file_type))),
+                new GameListItemSize(FileUtil::GetSize(physical_name)),
+            },
+            parent_dir);
+    }
 }
 
 void GameListWorker::run() {
     stop_processing = false;
+    // The loaders of different files run in parallel, so the keys must be loaded beforehand
+    HW::AES::InitKeys();
+    cache = std::make_unique<MetadataCache>();
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == "INSTALLED") {
             QString path =
@@ -142,6 +305,9 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+    if (!stop_processing) {
+        cache->Save();
+    }
     emit Finished(watch_list);
 }
 
@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <QList>
 #include <QObject>
 #include <QRunnable>
@@ -52,6 +53,11 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
+    class MetadataCache;
+
+    /// Collects the files with a supported extension, and adds the directories to watch_list
+    void FindGameFiles(const std::string& dir_path, unsigned int recursion,
+                       std::vector<std::string>& files);
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                  GameListDir* parent_dir);
 
@@ -59,4 +65,5 @@ private:
     const CompatibilityList& compatibility_list;
     QList<UISettings::GameDir>& game_dirs;
     std::atomic_bool stop_processing;
+    std::unique_ptr<MetadataCache> cache;
 };
@@ -2,9 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <atomic>
 #include <clocale>
 #include <memory>
 #include <thread>
+#include <vector>
 #include <glad/glad.h>
 #define QT_NO_OPENGL
 #include <QDesktopWidget>
@@ -15,6 +17,7 @@
 #include <QtGui>
 #include <QtWidgets>
 #include <fmt/format.h>
+#include "audio_core/dsp_interface.h"
 #include "citra_qt/aboutdialog.h"
 #include "citra_qt/applets/swkbd.h"
 #include "citra_qt/bootmanager.h"
@@ -26,6 +29,7 @@
 #include "citra_qt/configuration/config.h"
 #include "citra_qt/configuration/configure_dialog.h"
 #include "citra_qt/debugger/console.h"
+#include "citra_qt/debugger/frame_counters.h"
 #include "citra_qt/debugger/graphics/graphics.h"
 #include "citra_qt/debugger/graphics/graphics_breakpoints.h"
 #include "citra_qt/debugger/graphics/graphics_cmdlists.h"
@@ -54,6 +58,7 @@
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
@@ -115,7 +120,11 @@ static void InitializeLogging() {
 
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
-    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.log_binary) {
+        Log::AddBackend(std::make_unique<Log::BinaryFileBackend>(log_dir + BINARY_LOG_FILE));
+    } else {
+        Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    }
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -321,6 +330,11 @@ void GMainWindow::InitializeDebugWidgets() {
             [this] { lleServiceModulesWidget->setDisabled(true); });
     connect(this, &GMainWindow::EmulationStopping, waitTreeWidget,
             [this] { lleServiceModulesWidget->setDisabled(false); });
+
+    frameCountersWidget = new FrameCountersWidget(this);
+    addDockWidget(Qt::RightDockWidgetArea, frameCountersWidget);
+    frameCountersWidget->hide();
+    debug_menu->addAction(frameCountersWidget->toggleViewAction());
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -360,6 +374,8 @@ void GMainWindow::InitializeHotkeys() {
                                    Qt::ApplicationShortcut);
     hotkey_registry.RegisterHotkey("Main Window", "Decrease Speed Limit", QKeySequence("-"),
                                    Qt::ApplicationShortcut);
+    hotkey_registry.RegisterHotkey("Main Window", "Toggle Fast Forward", QKeySequence("CTRL+T"),
+                                   Qt::ApplicationShortcut);
     hotkey_registry.RegisterHotkey("Main Window", "Toggle Frame Advancing", QKeySequence("CTRL+A"),
                                    Qt::ApplicationShortcut);
     hotkey_registry.RegisterHotkey("Main Window", "Advance Frame", QKeySequence(Qt::Key_Backslash),
@@ -427,6 +443,14 @@ void GMainWindow::InitializeHotkeys() {
                     UpdateStatusBar();
                 }
             });
+    connect(hotkey_registry.GetHotkey("Main Window", "Toggle Fast Forward", this),
+            &QShortcut::activated, this, [&] {
+                auto& system = Core::System::GetInstance();
+                if (system.IsPoweredOn()) {
+                    system.SetFastForward(!system.IsFastForwarding());
+                    UpdateStatusBar();
+                }
+            });
     connect(hotkey_registry.GetHotkey("Main Window", "Toggle Frame Advancing", this),
             &QShortcut::activated, ui.action_Enable_Frame_Advancing, &QAction::trigger);
     connect(hotkey_registry.GetHotkey("Main Window", "Advance Frame", this), &QShortcut::activated,
@@ -600,6 +624,8 @@ void GMainWindow::ConnectMenuEvents() {
     });
     connect(ui.action_Capture_Screenshot, &QAction::triggered, this,
             &GMainWindow::OnCaptureScreenshot);
+    connect(ui.action_Capture_Profile_Trace, &QAction::triggered, this,
+            &GMainWindow::OnCaptureProfileTrace);
 
     // Help
     connect(ui.action_Open_Citra_Folder, &QAction::triggered, this,
@@ -865,9 +891,6 @@ void GMainWindow::ShutdownGame() {
     // TODO(bunnei): This function is not thread safe, but it's being used as if it were
     Pica::g_debug_context->ClearBreakpoints();
 
-    // Frame advancing must be cancelled in order to release the emu thread from waiting
-    Core::System::GetInstance().frame_limiter.SetFrameAdvancing(false);
-
     emit EmulationStopping();
 
     // Wait for emulation thread to complete and delete it
@@ -895,6 +918,8 @@ void GMainWindow::ShutdownGame() {
     ui.action_Enable_Frame_Advancing->setChecked(false);
     ui.action_Advance_Frame->setEnabled(false);
     ui.action_Capture_Screenshot->setEnabled(false);
+    ui.action_Capture_Profile_Trace->setEnabled(false);
+    Common::Profiling::StopTraceCapture();
     render_window->hide();
     if (game_list->isEmpty())
         game_list_placeholder->show();
@@ -1087,14 +1112,29 @@ void GMainWindow::OnMenuInstallCIA() {
     progress_bar->setMaximum(INT_MAX);
 
     QtConcurrent::run([&, filepaths] {
-        QString current_path;
-        Service::AM::InstallStatus status;
-        const auto cia_progress = [&](std::size_t written, std::size_t total) {
-            emit UpdateProgress(written, total);
-        };
-        for (const auto current_path : filepaths) {
-            status = Service::AM::InstallCIA(current_path.toStdString(), cia_progress);
-            emit CIAInstallReport(status, current_path);
+        // The files are installed in parallel, the progress covers all of them
+        std::size_t total_size = 0;
+        for (const auto& current_path : filepaths) {
+            total_size += static_cast<std::size_t>(QFileInfo(current_path).size());
+        }
+        std::atomic<std::size_t> total_written = 0;
+
+        std::vector<QFuture<void>> installs;
+        for (const auto& current_path : filepaths) {
+            installs.push_back(QtConcurrent::run([&, current_path] {
+                std::size_t file_written = 0;
+                const auto cia_progress = [&](std::size_t written, std::size_t) {
+                    total_written += written - file_written;
+                    file_written = written;
+                    emit UpdateProgress(total_written, total_size);
+                };
+                const auto status =
+                    Service::AM::InstallCIA(current_path.toStdString(), cia_progress);
+                emit CIAInstallReport(status, current_path);
+            }));
+        }
+        for (auto& install : installs) {
+            install.waitForFinished();
         }
         emit CIAInstallFinished();
     });
@@ -1183,6 +1223,7 @@ void GMainWindow::OnStartGame() {
     ui.action_Report_Compatibility->setEnabled(true);
     ui.action_Enable_Frame_Advancing->setEnabled(true);
     ui.action_Capture_Screenshot->setEnabled(true);
+    ui.action_Capture_Profile_Trace->setEnabled(true);
 
     discord_rpc->Update();
 }
@@ -1194,6 +1235,7 @@ void GMainWindow::OnPauseGame() {
     ui.action_Pause->setEnabled(false);
     ui.action_Stop->setEnabled(true);
     ui.action_Capture_Screenshot->setEnabled(false);
+    ui.action_Capture_Profile_Trace->setEnabled(false);
 }
 
 void GMainWindow::OnStopGame() {
@@ -1571,6 +1613,24 @@ void GMainWindow::OnCaptureScreenshot() {
     OnStartGame();
 }
 
+void GMainWindow::OnCaptureProfileTrace() {
+    OnPauseGame();
+    const QString path = QFileDialog::getSaveFileName(this, tr("Capture Profile Trace"), QString(),
+                                                      tr("Chrome Trace (*.json)"));
+    if (!path.isEmpty()) {
+        bool ok = false;
+        const int frames = QInputDialog::getInt(this, tr("Capture Profile Trace"),
+                                                tr("Number of frames to capture:"), 300, 1,
+                                                100000, 1, &ok);
+        if (ok && !Common::Profiling::StartTraceCapture(path.toStdString(),
+                                                        static_cast<u32>(frames))) {
+            QMessageBox::critical(this, tr("Capture Profile Trace"),
+                                  tr("Could not start capturing a profile trace to %1").arg(path));
+        }
+    }
+    OnStartGame();
+}
+
 void GMainWindow::UpdateStatusBar() {
     if (emu_thread == nullptr) {
         status_bar_update_timer.stop();
@@ -1579,7 +1639,10 @@ void GMainWindow::UpdateStatusBar() {
 
     auto results = Core::System::GetInstance().GetAndResetPerfStats();
 
-    if (Settings::values.use_frame_limit) {
+    if (Core::System::GetInstance().IsFastForwarding()) {
+        emu_speed_label->setText(
+            tr("Speed: %1% (fast-forward)").arg(results.emulation_speed * 100.0, 0, 'f', 0));
+    } else if (Settings::values.use_frame_limit) {
         emu_speed_label->setText(tr("Speed: %1% / %2%")
                                      .arg(results.emulation_speed * 100.0, 0, 'f', 0)
                                      .arg(Settings::values.frame_limit));
@@ -1589,6 +1652,41 @@ void GMainWindow::UpdateStatusBar() {
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
 
+    const auto format_distribution = [this](const Core::DurationDistribution& distribution) {
+        return tr("p50 %1 ms, p95 %2 ms, p99 %3 ms, max %4 ms")
+            .arg(distribution.p50, 0, 'f', 2)
+            .arg(distribution.p95, 0, 'f', 2)
+            .arg(distribution.p99, 0, 'f', 2)
+            .arg(distribution.max, 0, 'f', 2);
+    };
+    QString frametime_tooltip =
+        tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
+           "full-speed emulation this should be at most 16.67 ms.");
+    frametime_tooltip += QStringLiteral("\n\n");
+    frametime_tooltip += tr("Frame: %1").arg(format_distribution(results.frametime_distribution));
+    for (std::size_t i = 0; i < results.phase_distributions.size(); ++i) {
+        const auto phase = static_cast<Core::FramePhase>(i);
+        frametime_tooltip += QStringLiteral("\n");
+        frametime_tooltip += tr("%1: %2").arg(QString::fromUtf8(Core::GetFramePhaseName(phase)),
+                                              format_distribution(results.phase_distributions[i]));
+    }
+    frametime_tooltip += QStringLiteral("\n\n");
+    frametime_tooltip += tr("Present interval: %1, jitter %2 ms")
+                             .arg(format_distribution(results.present_interval_distribution))
+                             .arg(results.present_jitter, 0, 'f', 2);
+    if (Settings::values.max_frame_skip != 0) {
+        frametime_tooltip += QStringLiteral("\n");
+        frametime_tooltip += tr("Skipped frames: %1").arg(results.skipped_frames);
+    }
+    emu_frametime_label->setToolTip(frametime_tooltip);
+
+    emu_speed_label->setToolTip(
+        tr("Current emulation speed. Values higher or lower than 100% "
+           "indicate emulation is running faster or slower than a 3DS.") +
+        QStringLiteral("\n\n") +
+        tr("Audio output latency: %1 ms")
+            .arg(Core::System::GetInstance().DSP().GetOutputLatency(), 0, 'f', 1));
+
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
@@ -1870,7 +1968,9 @@ int main(int argc, char* argv[]) {
     // generating shaders
     setlocale(LC_ALL, "C");
 
+    // The configuration is loaded by now
     GMainWindow main_window;
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::UI};
 
     // Register CameraFactory
     Camera::RegisterFactory("image", std::make_unique<Camera::StillImageCameraFactory>());
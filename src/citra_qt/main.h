@@ -20,6 +20,7 @@ class AboutDialog;
 class Config;
 class ClickableLabel;
 class EmuThread;
+class FrameCountersWidget;
 class GameList;
 enum class GameListOpenTarget;
 class GameListPlaceholder;
@@ -184,6 +185,7 @@ private slots:
     void OnPlayMovie();
     void OnStopRecordingPlayback();
     void OnCaptureScreenshot();
+    void OnCaptureProfileTrace();
     void OnCoreError(Core::System::ResultStatus, std::string);
     /// Called whenever a user selects Help->About Citra
     void OnMenuAboutCitra();
@@ -239,6 +241,7 @@ private:
     GraphicsVertexShaderWidget* graphicsVertexShaderWidget;
     GraphicsTracingWidget* graphicsTracingWidget;
     LLEServiceModulesWidget* lleServiceModulesWidget;
+    FrameCountersWidget* frameCountersWidget;
     WaitTreeWidget* waitTreeWidget;
     Updater* updater;
 
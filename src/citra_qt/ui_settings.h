@@ -116,6 +116,10 @@ struct Values {
 
     // logging
     bool show_console;
+
+    // rendering
+    /// Present frames on the UI thread from a context shared with the emulation's
+    bool decoupled_presentation;
 };
 
 extern Values values;
@@ -38,10 +38,14 @@
 #define SYSDATA_DIR "sysdata"
 #define LOG_DIR "log"
 #define CHEATS_DIR "cheats"
+#define SHADER_DIR "shaders"
+#define LOAD_DIR "load"
+#define DUMP_DIR "dump"
 
 // Filenames
 // Files in the directory returned by GetUserPath(UserPath::LogDir)
 #define LOG_FILE "citra_log.txt"
+#define BINARY_LOG_FILE "citra_log.bin"
 
 // Files in the directory returned by GetUserPath(UserPath::ConfigDir)
 #define EMU_CONFIG "emu.ini"
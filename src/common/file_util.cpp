@@ -41,7 +41,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -350,6 +352,22 @@ u64 GetSize(const std::string& filename) {
     return 0;
 }
 
+s64 GetModificationTime(const std::string& path) {
+    std::string copy(path);
+    StripTailDirSlashes(copy);
+
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(copy).c_str(), &buf) != 0)
+#else
+    if (stat(copy.c_str(), &buf) != 0)
+#endif
+    {
+        return 0;
+    }
+    return static_cast<s64>(buf.st_mtime);
+}
+
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd) {
     struct stat buf;
@@ -388,8 +406,13 @@ bool CreateEmptyFile(const std::string& filename) {
     return true;
 }
 
-bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
-                           DirectoryEntryCallable callback) {
+namespace {
+
+/// Calls callback(virtual_name, is_directory) for each entry of a directory. is_directory is only
+/// looked up when resolve_type is set.
+template <typename Func>
+bool ForeachEntry(u64* num_entries_out, const std::string& directory, bool resolve_type,
+                  Func&& callback) {
     LOG_TRACE(Common_Filesystem, "directory {}", directory);
 
     // How many files + directories we found
@@ -399,17 +422,20 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
     bool callback_error = false;
 
 #ifdef _WIN32
-    // Find the first file in the directory.
+    // Find the first file in the directory. The basic info level skips the short 8.3 names, and
+    // large fetches read more entries per call.
     WIN32_FIND_DATAW ffd;
 
-    HANDLE handle_find = FindFirstFileW(Common::UTF8ToUTF16W(directory + "\\*").c_str(), &ffd);
+    HANDLE handle_find =
+        FindFirstFileExW(Common::UTF8ToUTF16W(directory + "\\*").c_str(), FindExInfoBasic, &ffd,
+                         FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
     if (handle_find == INVALID_HANDLE_VALUE) {
-        FindClose(handle_find);
         return false;
     }
     // windows loop
     do {
         const std::string virtual_name(Common::UTF16ToUTF8(ffd.cFileName));
+        const bool is_directory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
 #else
     DIR* dirp = opendir(directory.c_str());
     if (!dirp)
@@ -423,8 +449,24 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
         if (virtual_name == "." || virtual_name == "..")
             continue;
 
+#ifndef _WIN32
+        bool is_directory = false;
+        if (resolve_type) {
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__) || defined(__FreeBSD__)
+            // Symbolic links and file systems that don't report types need a stat call
+            if (result->d_type == DT_DIR) {
+                is_directory = true;
+            } else if (result->d_type == DT_UNKNOWN || result->d_type == DT_LNK) {
+                is_directory = IsDirectory(directory + DIR_SEP_CHR + virtual_name);
+            }
+#else
+            is_directory = IsDirectory(directory + DIR_SEP_CHR + virtual_name);
+#endif
+        }
+#endif
+
         u64 ret_entries = 0;
-        if (!callback(&ret_entries, directory, virtual_name)) {
+        if (!callback(&ret_entries, directory, virtual_name, is_directory)) {
             callback_error = true;
             break;
         }
@@ -447,16 +489,49 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
     return true;
 }
 
+/// Size of a file known to exist, with a single stat call
+u64 GetFileSize(const std::string& path) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(path).c_str(), &buf) == 0)
+#else
+    if (stat(path.c_str(), &buf) == 0)
+#endif
+    {
+        return buf.st_size;
+    }
+
+    LOG_ERROR(Common_Filesystem, "Stat failed {}: {}", path, GetLastErrorMsg());
+    return 0;
+}
+
+} // Anonymous namespace
+
+bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
+                           DirectoryEntryCallable callback) {
+    return ForeachEntry(num_entries_out, directory, false,
+                        [&callback](u64* num_entries_out, const std::string& directory,
+                                    const std::string& virtual_name, bool) {
+                            return callback(num_entries_out, directory, virtual_name);
+                        });
+}
+
+bool ForeachTypedDirectoryEntry(u64* num_entries_out, const std::string& directory,
+                                TypedDirectoryEntryCallable callback) {
+    return ForeachEntry(num_entries_out, directory, true, callback);
+}
+
 u64 ScanDirectoryTree(const std::string& directory, FSTEntry& parent_entry,
                       unsigned int recursion) {
-    const auto callback = [recursion, &parent_entry](u64* num_entries_out,
-                                                     const std::string& directory,
-                                                     const std::string& virtual_name) -> bool {
-        FSTEntry entry;
+    const auto callback = [recursion, &parent_entry](
+                              u64* num_entries_out, const std::string& directory,
+                              const std::string& virtual_name, bool is_directory) -> bool {
+        FSTEntry& entry = parent_entry.children.emplace_back();
         entry.virtualName = virtual_name;
-        entry.physicalName = directory + DIR_SEP + virtual_name;
+        entry.physicalName.reserve(directory.size() + 1 + virtual_name.size());
+        entry.physicalName.append(directory).append(DIR_SEP).append(virtual_name);
 
-        if (IsDirectory(entry.physicalName)) {
+        if (is_directory) {
             entry.isDirectory = true;
             // is a directory, lets go inside if we didn't recurse to often
             if (recursion > 0) {
@@ -467,25 +542,22 @@ u64 ScanDirectoryTree(const std::string& directory, FSTEntry& parent_entry,
             }
         } else { // is a file
             entry.isDirectory = false;
-            entry.size = GetSize(entry.physicalName);
+            entry.size = GetFileSize(entry.physicalName);
         }
         (*num_entries_out)++;
-
-        // Push into the tree
-        parent_entry.children.push_back(std::move(entry));
         return true;
     };
 
     u64 num_entries;
-    return ForeachDirectoryEntry(&num_entries, directory, callback) ? num_entries : 0;
+    return ForeachTypedDirectoryEntry(&num_entries, directory, callback) ? num_entries : 0;
 }
 
 bool DeleteDirRecursively(const std::string& directory, unsigned int recursion) {
     const auto callback = [recursion](u64* num_entries_out, const std::string& directory,
-                                      const std::string& virtual_name) -> bool {
+                                      const std::string& virtual_name, bool is_directory) -> bool {
         std::string new_path = directory + DIR_SEP_CHR + virtual_name;
 
-        if (IsDirectory(new_path)) {
+        if (is_directory) {
             if (recursion == 0)
                 return false;
             return DeleteDirRecursively(new_path, recursion - 1);
@@ -493,7 +565,7 @@ bool DeleteDirRecursively(const std::string& directory, unsigned int recursion)
         return Delete(new_path);
     };
 
-    if (!ForeachDirectoryEntry(nullptr, directory, callback))
+    if (!ForeachTypedDirectoryEntry(nullptr, directory, callback))
         return false;
 
     // Delete the outermost directory
@@ -511,30 +583,23 @@ void CopyDir(const std::string& source_path, const std::string& dest_path) {
     if (!FileUtil::Exists(dest_path))
         FileUtil::CreateFullPath(dest_path);
 
-    DIR* dirp = opendir(source_path.c_str());
-    if (!dirp)
-        return;
-
-    while (struct dirent* result = readdir(dirp)) {
-        const std::string virtualName(result->d_name);
-        // check for "." and ".."
-        if (((virtualName[0] == '.') && (virtualName[1] == '\0')) ||
-            ((virtualName[0] == '.') && (virtualName[1] == '.') && (virtualName[2] == '\0')))
-            continue;
-
-        std::string source, dest;
-        source = source_path + virtualName;
-        dest = dest_path + virtualName;
-        if (IsDirectory(source)) {
-            source += '/';
-            dest += '/';
-            if (!FileUtil::Exists(dest))
-                FileUtil::CreateFullPath(dest);
-            CopyDir(source, dest);
-        } else if (!FileUtil::Exists(dest))
-            FileUtil::Copy(source, dest);
-    }
-    closedir(dirp);
+    ForeachTypedDirectoryEntry(
+        nullptr, source_path,
+        [&source_path, &dest_path](u64*, const std::string&, const std::string& virtual_name,
+                                   bool is_directory) {
+            std::string source = source_path + virtual_name;
+            std::string dest = dest_path + virtual_name;
+            if (is_directory) {
+                source += '/';
+                dest += '/';
+                if (!FileUtil::Exists(dest))
+                    FileUtil::CreateFullPath(dest);
+                CopyDir(source, dest);
+            } else if (!FileUtil::Exists(dest)) {
+                FileUtil::Copy(source, dest);
+            }
+            return true;
+        });
 #endif
 }
 
@@ -711,6 +776,9 @@ const std::string& GetUserPath(UserPath path, const std::string& new_path) {
         // TODO: Put the logs in a better location for each OS
         paths.emplace(UserPath::LogDir, user_path + LOG_DIR DIR_SEP);
         paths.emplace(UserPath::CheatsDir, user_path + CHEATS_DIR DIR_SEP);
+        paths.emplace(UserPath::ShaderDir, user_path + SHADER_DIR DIR_SEP);
+        paths.emplace(UserPath::LoadDir, user_path + LOAD_DIR DIR_SEP);
+        paths.emplace(UserPath::DumpDir, user_path + DUMP_DIR DIR_SEP);
     }
 
     if (!new_path.empty()) {
@@ -732,6 +800,9 @@ const std::string& GetUserPath(UserPath path, const std::string& new_path) {
             paths[UserPath::CacheDir] = user_path + CACHE_DIR DIR_SEP;
             paths[UserPath::SDMCDir] = user_path + SDMC_DIR DIR_SEP;
             paths[UserPath::NANDDir] = user_path + NAND_DIR DIR_SEP;
+            paths[UserPath::ShaderDir] = user_path + SHADER_DIR DIR_SEP;
+            paths[UserPath::LoadDir] = user_path + LOAD_DIR DIR_SEP;
+            paths[UserPath::DumpDir] = user_path + DUMP_DIR DIR_SEP;
             break;
         }
     }
@@ -873,6 +944,77 @@ bool IOFile::Flush() {
     return m_good;
 }
 
+std::size_t IOFile::ReadAt(void* data, std::size_t length, u64 offset) const {
+    if (!IsOpen())
+        return 0;
+
+    u8* dest = static_cast<u8*>(data);
+    std::size_t read_length = 0;
+#ifdef _WIN32
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    while (read_length < length) {
+        const u64 position = offset + read_length;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(length - read_length, 1 << 30));
+        DWORD chunk_read = 0;
+        if (!ReadFile(handle, dest + read_length, chunk, &chunk_read, &overlapped) ||
+            chunk_read == 0) {
+            break;
+        }
+        read_length += chunk_read;
+    }
+#else
+    const int fd = fileno(m_file);
+    while (read_length < length) {
+        const ssize_t result =
+            pread(fd, dest + read_length, length - read_length, offset + read_length);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            break;
+        read_length += static_cast<std::size_t>(result);
+    }
+#endif
+    return read_length;
+}
+
+std::size_t IOFile::WriteAt(const void* data, std::size_t length, u64 offset) {
+    if (!IsOpen())
+        return 0;
+
+    const u8* src = static_cast<const u8*>(data);
+    std::size_t written = 0;
+#ifdef _WIN32
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    while (written < length) {
+        const u64 position = offset + written;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(length - written, 1 << 30));
+        DWORD chunk_written = 0;
+        if (!WriteFile(handle, src + written, chunk, &chunk_written, &overlapped) ||
+            chunk_written == 0) {
+            break;
+        }
+        written += chunk_written;
+    }
+#else
+    const int fd = fileno(m_file);
+    while (written < length) {
+        const ssize_t result = pwrite(fd, src + written, length - written, offset + written);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            break;
+        written += static_cast<std::size_t>(result);
+    }
+#endif
+    return written;
+}
+
 bool IOFile::Resize(u64 size) {
     if (!IsOpen() || 0 !=
 #ifdef _WIN32
@@ -889,4 +1031,91 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() = default;
+
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+#ifdef _WIN32
+    const HANDLE file =
+        CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the mapping and the file alive
+    const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", filename, GetLastErrorMsg());
+        return false;
+    }
+    size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat buf;
+    if (fstat(fd, &buf) != 0 || buf.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file alive
+    void* view = mmap(nullptr, static_cast<std::size_t>(buf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", filename, GetLastErrorMsg());
+        return false;
+    }
+    size = static_cast<std::size_t>(buf.st_size);
+#endif
+
+    data = static_cast<u8*>(view);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
 } // namespace FileUtil
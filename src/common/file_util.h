@@ -24,10 +24,13 @@ enum class UserPath {
     CacheDir,
     CheatsDir,
     ConfigDir,
+    DumpDir,
+    LoadDir,
     LogDir,
     NANDDir,
     RootDir,
     SDMCDir,
+    ShaderDir,
     SysDataDir,
     UserDir,
 };
@@ -56,6 +59,10 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of a file or directory in seconds since the epoch, or 0 if
+// it doesn't exist
+s64 GetModificationTime(const std::string& path);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -100,6 +107,22 @@ using DirectoryEntryCallable = std::function<bool(
 bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
                            DirectoryEntryCallable callback);
 
+/**
+ * Same as DirectoryEntryCallable, but also told whether the entry is a directory
+ * @param is_directory whether the entry is a directory, following symbolic links
+ */
+using TypedDirectoryEntryCallable =
+    std::function<bool(u64* num_entries_out, const std::string& directory,
+                       const std::string& virtual_name, bool is_directory)>;
+
+/**
+ * Same as ForeachDirectoryEntry, but also tells the callback whether each entry is a directory.
+ * This comes from the directory listing on hosts that report entry types in it (Windows, and most
+ * file systems on Linux and macOS), which saves a stat call per entry.
+ */
+bool ForeachTypedDirectoryEntry(u64* num_entries_out, const std::string& directory,
+                                TypedDirectoryEntryCallable callback);
+
 /**
  * Scans the directory tree, storing the results.
  * @param directory the parent directory to start scanning from
@@ -241,6 +264,18 @@ public:
         return IsGood();
     }
 
+    /**
+     * Reads from an offset with a single positional read, bypassing the stream's buffer and
+     * position. Several threads may read at once. The stream position is unspecified afterwards,
+     * and data written through the stream must be flushed before it can be read this way.
+     * Failures don't change the error state.
+     * @return the number of bytes read
+     */
+    std::size_t ReadAt(void* data, std::size_t length, u64 offset) const;
+
+    /// Writes to an offset like ReadAt reads, data buffered by the stream may be overwritten
+    std::size_t WriteAt(const void* data, std::size_t length, u64 offset);
+
     bool Seek(s64 off, int origin);
     u64 Tell() const;
     u64 GetSize() const;
@@ -258,6 +293,39 @@ private:
     bool m_good = true;
 };
 
+/**
+ * Read-only memory mapping of a whole file, which avoids copying it when it is only read once or
+ * read at random. Empty files can't be mapped.
+ */
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    const u8* Data() const {
+        return data;
+    }
+
+    std::size_t Size() const {
+        return size;
+    }
+
+private:
+    u8* data = nullptr;
+    std::size_t size = 0;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
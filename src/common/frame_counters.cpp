@@ -0,0 +1,109 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/frame_counters.h"
+
+namespace Common {
+
+namespace {
+
+constexpr std::size_t MAX_COUNTERS = 1024;
+
+/// The counts of a single thread. Only the owning thread writes them, the atomics only make them
+/// safe to read from EndCountersFrame.
+struct ThreadCounts {
+    ThreadCounts();
+    ~ThreadCounts();
+
+    std::array<std::atomic<u64>, MAX_COUNTERS> counts{};
+};
+
+struct CounterRegistry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::size_t> indices;
+    std::vector<ThreadCounts*> threads;
+    /// Counts of the threads that exited
+    std::array<u64, MAX_COUNTERS> exited_counts{};
+    /// Totals when the previous frame ended
+    std::array<u64, MAX_COUNTERS> previous_totals{};
+    std::vector<u64> last_frame_counts;
+};
+
+CounterRegistry& GetRegistry() {
+    static CounterRegistry registry;
+    return registry;
+}
+
+ThreadCounts::ThreadCounts() {
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+ThreadCounts::~ThreadCounts() {
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (std::size_t i = 0; i < MAX_COUNTERS; ++i) {
+        registry.exited_counts[i] += counts[i].load(std::memory_order_relaxed);
+    }
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+thread_local ThreadCounts thread_counts;
+
+} // Anonymous namespace
+
+FrameCounter::FrameCounter(const std::string& name) {
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    const auto [it, inserted] = registry.indices.emplace(name, registry.names.size());
+    if (inserted) {
+        ASSERT_MSG(registry.names.size() < MAX_COUNTERS, "Too many frame counters");
+        registry.names.push_back(name);
+    }
+    index = it->second;
+}
+
+void FrameCounter::Add(u64 amount) const {
+    auto& count = thread_counts.counts[index];
+    count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void EndCountersFrame() {
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    const std::size_t num_counters = registry.names.size();
+    registry.last_frame_counts.resize(num_counters);
+    for (std::size_t i = 0; i < num_counters; ++i) {
+        u64 total = registry.exited_counts[i];
+        for (const ThreadCounts* thread : registry.threads) {
+            total += thread->counts[i].load(std::memory_order_relaxed);
+        }
+        registry.last_frame_counts[i] = total - registry.previous_totals[i];
+        registry.previous_totals[i] = total;
+    }
+}
+
+std::vector<FrameCounterValue> GetLastFrameCounters() {
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    std::vector<FrameCounterValue> values;
+    values.reserve(registry.names.size());
+    for (std::size_t i = 0; i < registry.names.size(); ++i) {
+        const u64 value = i < registry.last_frame_counts.size() ? registry.last_frame_counts[i] : 0;
+        values.push_back({registry.names[i], value});
+    }
+    return values;
+}
+
+} // namespace Common
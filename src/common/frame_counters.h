@@ -0,0 +1,43 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A named count of events, such as draw calls or SVCs, that is reported once per frame. Each
+ * thread counts in its own slot, so adding to a counter is a plain increment without any
+ * synchronization. The slots of all threads are only merged by EndCountersFrame.
+ * Counters with the same name share their counts.
+ */
+class FrameCounter {
+public:
+    explicit FrameCounter(const std::string& name);
+
+    void Add(u64 amount = 1) const;
+
+private:
+    std::size_t index;
+};
+
+struct FrameCounterValue {
+    std::string name;
+    u64 value;
+};
+
+/// Merges the counts of all threads and computes how much was counted since the previous call.
+/// Meant to be called once per emulated frame.
+void EndCountersFrame();
+
+/// Gets the counts of every counter during the frame last ended by EndCountersFrame, in the order
+/// the counters were created
+std::vector<FrameCounterValue> GetLastFrameCounters();
+
+} // namespace Common
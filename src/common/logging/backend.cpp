@@ -3,7 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <limits>
 #include <chrono>
 #include <condition_variable>
 #include <memory>
@@ -21,10 +25,12 @@
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/string_util.h"
-#include "common/threadsafe_queue.h"
+#include "common/thread.h"
 
 namespace Log {
 
+std::atomic<Level> global_class_levels[static_cast<std::size_t>(Class::Count)];
+
 /**
  * Static state as a singleton.
  */
@@ -38,8 +44,25 @@ public:
     Impl(Impl const&) = delete;
     const Impl& operator=(Impl const&) = delete;
 
-    void PushEntry(Entry e) {
-        message_queue.Push(std::move(e));
+    /**
+     * Formats a message straight into a free slot of the entry ring. The slots keep the storage of
+     * their messages, so after a few messages logging does not allocate anymore.
+     */
+    void PushEntry(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                   const char* function, const char* format, const fmt::format_args& args) {
+        Slot& slot = AcquireSlot();
+        Entry& entry = slot.entry;
+        entry.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - time_origin);
+        entry.log_class = log_class;
+        entry.log_level = log_level;
+        entry.filename = Common::TrimSourcePath(filename);
+        entry.line_num = line_num;
+        entry.function = function;
+        entry.format = format;
+        entry.message.clear();
+        fmt::vformat_to(std::back_inserter(entry.message), format, args);
+        PublishSlot(slot);
     }
 
     void AddBackend(std::unique_ptr<Backend> backend) {
@@ -61,6 +84,10 @@ public:
 
     void SetGlobalFilter(const Filter& f) {
         filter = f;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Class::Count); ++i) {
+            global_class_levels[i].store(filter.GetClassLevel(static_cast<Class>(i)),
+                                         std::memory_order_relaxed);
+        }
     }
 
     Backend* GetBackend(std::string_view backend_name) {
@@ -73,9 +100,28 @@ public:
     }
 
 private:
+    /// Number of entries that can be waiting to be written, must be a power of two
+    static constexpr std::size_t RING_SIZE = 4096;
+
+    /**
+     * A slot of the entry ring. The sequence tells the state of the slot for the position of the
+     * ring it is used at: it is equal to the position while the slot is free, and to the position
+     * plus one once its entry is ready to be written.
+     */
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        Entry entry;
+    };
+
     Impl() {
+        for (std::size_t i = 0; i < RING_SIZE; ++i) {
+            ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        SetGlobalFilter(filter);
+
         backend_thread = std::thread([&] {
-            Entry entry;
+            // Started before the configuration is loaded, which is then applied to the thread
+            Common::ScopedThreadRole thread_role{Common::ThreadRole::IO};
             auto write_logs = [&](Entry& e) {
                 std::lock_guard<std::mutex> lock(writing_mutex);
                 for (const auto& backend : backends) {
@@ -83,35 +129,116 @@ private:
                 }
             };
             while (true) {
-                entry = message_queue.PopWait();
-                if (entry.final_entry) {
+                Slot* slot = WaitForSlot();
+                if (slot == nullptr) {
                     break;
                 }
-                write_logs(entry);
+                write_logs(slot->entry);
+                ReleaseSlot(*slot);
             }
 
             // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
             // where a system is repeatedly spamming logs even on close.
             constexpr int MAX_LOGS_TO_WRITE = 100;
             int logs_written = 0;
-            while (logs_written++ < MAX_LOGS_TO_WRITE && message_queue.Pop(entry)) {
-                write_logs(entry);
+            Slot* slot;
+            while (logs_written++ < MAX_LOGS_TO_WRITE && (slot = PeekSlot()) != nullptr) {
+                write_logs(slot->entry);
+                ReleaseSlot(*slot);
             }
         });
     }
 
     ~Impl() {
-        Entry entry;
-        entry.final_entry = true;
-        message_queue.Push(entry);
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
         backend_thread.join();
     }
 
+    /// Claims the next free slot of the ring, waiting for the backend thread if the ring is full
+    Slot& AcquireSlot() {
+        std::size_t position = write_position.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = ring[position % RING_SIZE];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (write_position.compare_exchange_weak(position, position + 1,
+                                                         std::memory_order_relaxed)) {
+                    return slot;
+                }
+            } else if (difference < 0) {
+                // The backend thread has not written the entry that used this slot last yet
+                std::this_thread::yield();
+                position = write_position.load(std::memory_order_relaxed);
+            } else {
+                position = write_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void PublishSlot(Slot& slot) {
+        const std::size_t position = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(position + 1, std::memory_order_release);
+        if (backend_waiting.load(std::memory_order_acquire)) {
+            wakeup.notify_one();
+        }
+    }
+
+    /// Returns the next entry to write if it is ready, only called by the backend thread
+    Slot* PeekSlot() {
+        Slot& slot = ring[read_position % RING_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != read_position + 1) {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    /// Waits for the next entry to write, or returns nullptr once the logger is being destroyed
+    Slot* WaitForSlot() {
+        while (true) {
+            if (Slot* slot = PeekSlot()) {
+                return slot;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeup_mutex);
+            if (stopping) {
+                return nullptr;
+            }
+            backend_waiting.store(true, std::memory_order_seq_cst);
+            // A producer can publish between the check above and the flag being set without
+            // waking this thread up, the timeout bounds how late its entry is written then
+            wakeup.wait_for(lock, std::chrono::milliseconds(10),
+                            [this] { return stopping || PeekSlot() != nullptr; });
+            backend_waiting.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void ReleaseSlot(Slot& slot) {
+        slot.sequence.store(read_position + RING_SIZE, std::memory_order_release);
+        ++read_position;
+    }
+
     std::mutex writing_mutex;
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
-    Common::MPSCQueue<Log::Entry> message_queue;
     Filter filter;
+
+    std::array<Slot, RING_SIZE> ring;
+    std::atomic<std::size_t> write_position{0};
+    /// Only used by the backend thread
+    std::size_t read_position = 0;
+
+    std::mutex wakeup_mutex;
+    std::condition_variable wakeup;
+    std::atomic<bool> backend_waiting{false};
+    bool stopping = false;
+
+    const std::chrono::steady_clock::time_point time_origin = std::chrono::steady_clock::now();
 };
 
 void ConsoleBackend::Write(const Entry& entry) {
@@ -140,6 +267,98 @@ void FileBackend::Write(const Entry& entry) {
     }
 }
 
+namespace {
+
+// "CLOG" - Citra LOG
+constexpr u32 BINARY_LOG_MAGIC = 0x474F4C43;
+constexpr u32 BINARY_LOG_VERSION = 1;
+
+/// Kinds of records in a binary log file, each starts with one of them as an u8
+enum class BinaryLogRecord : u8 {
+    /// u8 class, u8 name size, name
+    ClassName = 1,
+    /// u32 id, u32 line, u16 size + the file, function and format strings
+    Location = 2,
+    /// u64 timestamp in us, u8 class, u8 level, u32 location id, u32 size, message
+    Message = 3,
+};
+
+template <typename T>
+void AppendValue(std::vector<u8>& record, T value) {
+    const auto* bytes = reinterpret_cast<const u8*>(&value);
+    record.insert(record.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename SizeType>
+void AppendString(std::vector<u8>& record, std::string_view string) {
+    const auto size = static_cast<SizeType>(
+        std::min<std::size_t>(string.size(), std::numeric_limits<SizeType>::max()));
+    AppendValue(record, size);
+    record.insert(record.end(), string.begin(), string.begin() + size);
+}
+
+} // Anonymous namespace
+
+std::size_t BinaryFileBackend::LocationHash::operator()(const Location& location) const {
+    const auto& [filename, line_num, function, format] = location;
+    std::size_t hash = std::hash<const char*>()(filename);
+    hash = hash * 31 + line_num;
+    hash = hash * 31 + std::hash<const char*>()(function);
+    return hash * 31 + std::hash<const char*>()(format);
+}
+
+BinaryFileBackend::BinaryFileBackend(const std::string& filename)
+    : file(filename, "wb", _SH_DENYWR) {
+    AppendValue(record, BINARY_LOG_MAGIC);
+    AppendValue(record, BINARY_LOG_VERSION);
+    bytes_written += file.WriteBytes(record.data(), record.size());
+}
+
+u32 BinaryFileBackend::GetLocationId(const Entry& entry) {
+    const Location location{entry.filename, entry.line_num, entry.function, entry.format};
+    const auto [it, inserted] =
+        location_ids.emplace(location, static_cast<u32>(location_ids.size()));
+    if (inserted) {
+        AppendValue(record, BinaryLogRecord::Location);
+        AppendValue(record, it->second);
+        AppendValue(record, static_cast<u32>(entry.line_num));
+        AppendString<u16>(record, entry.filename);
+        AppendString<u16>(record, entry.function);
+        AppendString<u16>(record, entry.format != nullptr ? entry.format : "");
+    }
+    return it->second;
+}
+
+void BinaryFileBackend::Write(const Entry& entry) {
+    // Binary logs are several times smaller than text ones, so they get a larger limit
+    constexpr std::size_t MAX_BYTES_WRITTEN = 512 * 1024L * 1024L;
+    if (!file.IsOpen() || bytes_written > MAX_BYTES_WRITTEN) {
+        return;
+    }
+
+    record.clear();
+    const auto class_index = static_cast<std::size_t>(entry.log_class);
+    if (!class_written[class_index]) {
+        AppendValue(record, BinaryLogRecord::ClassName);
+        AppendValue(record, static_cast<u8>(entry.log_class));
+        AppendString<u8>(record, GetLogClassName(entry.log_class));
+        class_written[class_index] = true;
+    }
+    const u32 location_id = GetLocationId(entry);
+
+    AppendValue(record, BinaryLogRecord::Message);
+    AppendValue(record, static_cast<u64>(entry.timestamp.count()));
+    AppendValue(record, static_cast<u8>(entry.log_class));
+    AppendValue(record, static_cast<u8>(entry.log_level));
+    AppendValue(record, location_id);
+    AppendString<u32>(record, entry.message);
+
+    bytes_written += file.WriteBytes(record.data(), record.size());
+    if (entry.log_level >= Level::Error) {
+        file.Flush();
+    }
+}
+
 void DebuggerBackend::Write(const Entry& entry) {
 #ifdef _WIN32
     ::OutputDebugStringW(Common::UTF8ToUTF16W(FormatLogMessage(entry).append(1, '\n')).c_str());
@@ -291,9 +510,6 @@ void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
     if (!filter.CheckMessage(log_class, log_level))
         return;
 
-    Entry entry =
-        CreateEntry(log_class, log_level, filename, line_num, function, fmt::vformat(format, args));
-
-    instance.PushEntry(std::move(entry));
+    instance.PushEntry(log_class, log_level, filename, line_num, function, format, args);
 }
 } // namespace Log
@@ -4,10 +4,14 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 #include "common/file_util.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -24,11 +28,14 @@ struct Entry {
     std::chrono::microseconds timestamp;
     Class log_class;
     Level log_level;
-    std::string filename;
+    /// Source file, relative to the source directory. Points to a string literal.
+    const char* filename;
     unsigned int line_num;
-    std::string function;
+    /// Points to the __func__ string of the function that logged the message.
+    const char* function;
+    /// Format string the message was created from, if any. Points to a string literal.
+    const char* format = nullptr;
     std::string message;
-    bool final_entry = false;
 
     Entry() = default;
     Entry(Entry&& o) = default;
@@ -105,6 +112,42 @@ private:
     std::size_t bytes_written;
 };
 
+/**
+ * Backend that writes to a file in a compact binary format, which can be converted back to text
+ * with dist/scripting/decode_log.py. Each source location is written to the file once; messages
+ * only refer to it by an ID, which avoids formatting and writing the same prefix for every line.
+ */
+class BinaryFileBackend : public Backend {
+public:
+    explicit BinaryFileBackend(const std::string& filename);
+
+    static const char* Name() {
+        return "binary_file";
+    }
+
+    const char* GetName() const override {
+        return Name();
+    }
+
+    void Write(const Entry& entry) override;
+
+private:
+    using Location = std::tuple<const char*, unsigned int, const char*, const char*>;
+
+    struct LocationHash {
+        std::size_t operator()(const Location& location) const;
+    };
+
+    u32 GetLocationId(const Entry& entry);
+
+    FileUtil::IOFile file;
+    std::size_t bytes_written = 0;
+    std::unordered_map<Location, u32, LocationHash> location_ids;
+    std::array<bool, static_cast<std::size_t>(Class::Count)> class_written{};
+    /// Holds each record before it is written, to keep its storage between records
+    std::vector<u8> record;
+};
+
 /**
  * Backend that writes to Visual Studio's output window
  */
@@ -45,6 +45,11 @@ public:
     /// Matches class/level combination against the filter, returning true if it passed.
     bool CheckMessage(Class log_class, Level level) const;
 
+    /// Returns the minimum level of messages of `log_class` that pass the filter.
+    Level GetClassLevel(Class log_class) const {
+        return class_levels[static_cast<std::size_t>(log_class)];
+    }
+
 private:
     std::array<Level, static_cast<std::size_t>(Class::Count)> class_levels;
 };
@@ -0,0 +1,159 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/lz4_compression.h"
+
+namespace Common::LZ4 {
+
+namespace {
+
+constexpr std::size_t MIN_MATCH = 4;
+/// The last bytes of a block are always literals
+constexpr std::size_t LAST_LITERALS = 5;
+/// No match starts in the last bytes of a block
+constexpr std::size_t MF_LIMIT = 12;
+constexpr std::size_t MAX_OFFSET = 0xFFFF;
+constexpr u32 HASH_LOG = 14;
+
+u32 Read32(const u8* data) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+u32 Hash(u32 sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+void WriteLength(std::vector<u8>& out, std::size_t length) {
+    for (; length >= 0xFF; length -= 0xFF) {
+        out.push_back(0xFF);
+    }
+    out.push_back(static_cast<u8>(length));
+}
+
+void WriteLiterals(std::vector<u8>& out, const u8* literals, std::size_t literal_length,
+                   std::size_t match_code) {
+    out.push_back(static_cast<u8>((std::min<std::size_t>(literal_length, 15) << 4) |
+                                  std::min<std::size_t>(match_code, 15)));
+    if (literal_length >= 15) {
+        WriteLength(out, literal_length - 15);
+    }
+    out.insert(out.end(), literals, literals + literal_length);
+}
+
+bool ReadLength(const u8* source, std::size_t source_size, std::size_t& in, std::size_t& length) {
+    u8 byte;
+    do {
+        if (in >= source_size) {
+            return false;
+        }
+        byte = source[in++];
+        length += byte;
+    } while (byte == 0xFF);
+    return true;
+}
+
+} // Anonymous namespace
+
+std::vector<u8> CompressBlock(const u8* source, std::size_t source_size) {
+    std::vector<u8> out;
+    out.reserve(source_size + source_size / 0xFF + 16);
+
+    // Last position each hashed sequence was seen at, plus one so that zero means none
+    std::vector<u32> table(std::size_t{1} << HASH_LOG, 0);
+
+    std::size_t anchor = 0;
+    if (source_size > MF_LIMIT) {
+        const std::size_t match_limit = source_size - LAST_LITERALS;
+        std::size_t pos = 0;
+        while (pos + MF_LIMIT <= source_size) {
+            const u32 sequence = Read32(source + pos);
+            u32& entry = table[Hash(sequence)];
+            const std::size_t candidate = entry;
+            entry = static_cast<u32>(pos + 1);
+            if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET ||
+                Read32(source + candidate - 1) != sequence) {
+                ++pos;
+                continue;
+            }
+
+            const std::size_t match = candidate - 1;
+            std::size_t length = MIN_MATCH;
+            while (pos + length < match_limit && source[match + length] == source[pos + length]) {
+                ++length;
+            }
+
+            const std::size_t offset = pos - match;
+            WriteLiterals(out, source + anchor, pos - anchor, length - MIN_MATCH);
+            out.push_back(static_cast<u8>(offset & 0xFF));
+            out.push_back(static_cast<u8>(offset >> 8));
+            if (length - MIN_MATCH >= 15) {
+                WriteLength(out, length - MIN_MATCH - 15);
+            }
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    WriteLiterals(out, source + anchor, source_size - anchor, 0);
+    return out;
+}
+
+bool DecompressBlock(const u8* source, std::size_t source_size, u8* dest, std::size_t dest_size) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < source_size) {
+        const u8 token = source[in++];
+
+        std::size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLength(source, source_size, in, literal_length)) {
+            return false;
+        }
+        if (literal_length > source_size - in || literal_length > dest_size - out) {
+            return false;
+        }
+        std::memcpy(dest + out, source + in, literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        // The last sequence has no match
+        if (in == source_size) {
+            break;
+        }
+
+        if (source_size - in < 2) {
+            return false;
+        }
+        const std::size_t offset = source[in] | (source[in + 1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out) {
+            return false;
+        }
+
+        std::size_t length = token & 0xF;
+        if (length == 15 && !ReadLength(source, source_size, in, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (length > dest_size - out) {
+            return false;
+        }
+
+        // Matches may overlap the bytes they produce, which repeats the last offset bytes
+        if (offset >= length) {
+            std::memcpy(dest + out, dest + out - offset, length);
+            out += length;
+        } else {
+            for (const std::size_t end = out + length; out < end; ++out) {
+                dest[out] = dest[out - offset];
+            }
+        }
+    }
+    return out == dest_size;
+}
+
+} // namespace Common::LZ4
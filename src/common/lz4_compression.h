@@ -0,0 +1,36 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Compression of data in the LZ4 block format, which decompresses at several GB/s and leaves the
+ * size of the data to the caller. The compressor is a plain greedy one, trading some ratio for
+ * being simple and fast.
+ */
+namespace Common::LZ4 {
+
+/**
+ * Compresses a block of data
+ * @param source Data to compress
+ * @param source_size Size of the data, in bytes
+ * @returns the compressed data, which may be larger than the source for incompressible data
+ */
+std::vector<u8> CompressBlock(const u8* source, std::size_t source_size);
+
+/**
+ * Decompresses a block of data
+ * @param source Compressed data
+ * @param source_size Size of the compressed data, in bytes
+ * @param dest Buffer receiving the decompressed data
+ * @param dest_size Size of the decompressed data, in bytes, it has to be known beforehand
+ * @returns false if the compressed data is malformed or doesn't decompress to dest_size bytes
+ */
+bool DecompressBlock(const u8* source, std::size_t source_size, u8* dest, std::size_t dest_size);
+
+} // namespace Common::LZ4
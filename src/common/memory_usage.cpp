@@ -0,0 +1,80 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <utility>
+#include "common/memory_usage.h"
+
+namespace Common {
+
+namespace {
+
+std::array<std::atomic<s64>, NumMemoryCategories> usage{};
+
+} // Anonymous namespace
+
+const char* GetMemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+    case MemoryCategory::GuestMemory:
+        return "Guest memory";
+    case MemoryCategory::SurfaceStaging:
+        return "Surface staging";
+    case MemoryCategory::SurfaceVRAM:
+        return "Surface VRAM";
+    case MemoryCategory::ShaderCache:
+        return "Shader cache";
+    case MemoryCategory::JitCodeCache:
+        return "JIT code cache";
+    case MemoryCategory::TraceBuffers:
+        return "Trace buffers";
+    case MemoryCategory::AudioBuffers:
+        return "Audio buffers";
+    case MemoryCategory::KernelObjects:
+        return "Kernel objects";
+    default:
+        return "Unknown";
+    }
+}
+
+void AddMemoryUsage(MemoryCategory category, s64 bytes) {
+    usage[static_cast<std::size_t>(category)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MemoryUsage GetMemoryUsage() {
+    MemoryUsage result;
+    for (std::size_t i = 0; i < NumMemoryCategories; ++i) {
+        // Sizes are accounted by several threads, so a category may briefly look negative
+        const s64 bytes = usage[i].load(std::memory_order_relaxed);
+        result[i] = bytes > 0 ? static_cast<u64>(bytes) : 0;
+    }
+    return result;
+}
+
+ScopedMemoryUsage::ScopedMemoryUsage(MemoryCategory category, u64 bytes)
+    : category(category), bytes(bytes) {
+    AddMemoryUsage(category, static_cast<s64>(bytes));
+}
+
+ScopedMemoryUsage::~ScopedMemoryUsage() {
+    AddMemoryUsage(category, -static_cast<s64>(bytes));
+}
+
+ScopedMemoryUsage::ScopedMemoryUsage(ScopedMemoryUsage&& other) noexcept
+    : category(other.category), bytes(std::exchange(other.bytes, 0)) {}
+
+ScopedMemoryUsage& ScopedMemoryUsage::operator=(ScopedMemoryUsage&& other) noexcept {
+    if (this != &other) {
+        Set(0);
+        category = other.category;
+        bytes = std::exchange(other.bytes, 0);
+    }
+    return *this;
+}
+
+void ScopedMemoryUsage::Set(u64 new_bytes) {
+    AddMemoryUsage(category, static_cast<s64>(new_bytes) - static_cast<s64>(bytes));
+    bytes = new_bytes;
+}
+
+} // namespace Common
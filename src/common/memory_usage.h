@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Subsystems whose host memory use is accounted
+enum class MemoryCategory : std::size_t {
+    /// Emulated FCRAM, VRAM and the New 3DS extra RAM
+    GuestMemory,
+    /// Host buffers staging the pixels the renderer loads into and flushes from its surfaces
+    SurfaceStaging,
+    /// Estimated video memory of the textures of the renderer's surfaces
+    SurfaceVRAM,
+    /// Generated source of the cached host shaders
+    ShaderCache,
+    /// Code emitted by the CPU and shader JITs
+    JitCodeCache,
+    /// Command lists and memory captured by the CiTrace recorder
+    TraceBuffers,
+    /// Samples queued for the audio output
+    AudioBuffers,
+    /// Kernel objects created by the guest
+    KernelObjects,
+
+    Count,
+};
+
+constexpr std::size_t NumMemoryCategories = static_cast<std::size_t>(MemoryCategory::Count);
+
+using MemoryUsage = std::array<u64, NumMemoryCategories>;
+
+/// Gets a human readable name of a memory category
+const char* GetMemoryCategoryName(MemoryCategory category);
+
+/// Adds to (or with a negative size, subtracts from) the bytes used by a category. Lock-free.
+void AddMemoryUsage(MemoryCategory category, s64 bytes);
+
+/// Gets the bytes currently used by each category
+MemoryUsage GetMemoryUsage();
+
+/**
+ * Accounts a size to a category for as long as it exists, for allocations owned by an object.
+ * The size can be changed as the allocation grows or shrinks.
+ */
+class ScopedMemoryUsage {
+public:
+    explicit ScopedMemoryUsage(MemoryCategory category, u64 bytes = 0);
+    ~ScopedMemoryUsage();
+
+    ScopedMemoryUsage(ScopedMemoryUsage&& other) noexcept;
+    ScopedMemoryUsage& operator=(ScopedMemoryUsage&& other) noexcept;
+
+    ScopedMemoryUsage(const ScopedMemoryUsage&) = delete;
+    ScopedMemoryUsage& operator=(const ScopedMemoryUsage&) = delete;
+
+    void Set(u64 new_bytes);
+    void Add(s64 delta) {
+        Set(static_cast<u64>(static_cast<s64>(bytes) + delta));
+    }
+
+    u64 Get() const {
+        return bytes;
+    }
+
+private:
+    MemoryCategory category;
+    u64 bytes;
+};
+
+} // namespace Common
@@ -0,0 +1,122 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdint>
+#include <new>
+#include "common/alignment.h"
+#include "common/logging/log.h"
+#include "common/memory_util.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Common {
+
+#ifdef _WIN32
+
+/// Large pages need SeLockMemoryPrivilege, which has to be granted to the user and enabled
+static bool EnableLockMemoryPrivilege() {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+    TOKEN_PRIVILEGES privileges{};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    const bool enabled =
+        LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege",
+                              &privileges.Privileges[0].Luid) &&
+        AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+        GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return enabled;
+}
+
+void MemoryPagesDeleter::operator()(u8* pointer) const {
+    VirtualFree(pointer, 0, MEM_RELEASE);
+}
+
+MemoryPages AllocateMemoryPages(std::size_t size, bool large_pages) {
+    if (large_pages) {
+        static const bool privilege_enabled = EnableLockMemoryPrivilege();
+        const std::size_t large_page_size = GetLargePageMinimum();
+        if (privilege_enabled && large_page_size != 0) {
+            // Large pages are committed and locked immediately
+            const std::size_t large_size = AlignUp(size, large_page_size);
+            void* pointer = VirtualAlloc(nullptr, large_size,
+                                         MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                         PAGE_READWRITE);
+            if (pointer) {
+                return MemoryPages(static_cast<u8*>(pointer), MemoryPagesDeleter(large_size));
+            }
+        }
+        LOG_WARNING(Common_Memory, "Large pages unavailable, using regular pages");
+    }
+
+    void* pointer = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return MemoryPages(static_cast<u8*>(pointer), MemoryPagesDeleter(size));
+}
+
+#else
+
+void MemoryPagesDeleter::operator()(u8* pointer) const {
+    munmap(pointer, size);
+}
+
+MemoryPages AllocateMemoryPages(std::size_t size, bool large_pages) {
+    constexpr std::size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    if (large_pages) {
+#ifdef MAP_HUGETLB
+        // Pages reserved by the administrator, guaranteed to be large
+        const std::size_t large_size = AlignUp(size, LARGE_PAGE_SIZE);
+        void* pointer = mmap(nullptr, large_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pointer != MAP_FAILED) {
+            return MemoryPages(static_cast<u8*>(pointer), MemoryPagesDeleter(large_size));
+        }
+#endif
+#ifdef MADV_HUGEPAGE
+        // Otherwise transparent huge pages, which need the area to be aligned to them
+        const std::size_t mapped_size = size + LARGE_PAGE_SIZE;
+        void* mapping = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        u8* const start = static_cast<u8*>(mapping);
+        u8* const aligned = reinterpret_cast<u8*>(
+            AlignUp(reinterpret_cast<std::uintptr_t>(start), LARGE_PAGE_SIZE));
+        u8* const end = start + mapped_size;
+        if (aligned != start) {
+            munmap(start, aligned - start);
+        }
+        if (aligned + size != end) {
+            munmap(aligned + size, end - (aligned + size));
+        }
+        if (madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+            LOG_WARNING(Common_Memory, "Transparent huge pages unavailable");
+        }
+        return MemoryPages(aligned, MemoryPagesDeleter(size));
+#else
+        LOG_WARNING(Common_Memory, "Large pages unavailable, using regular pages");
+#endif
+    }
+
+    void* pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pointer == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    return MemoryPages(static_cast<u8*>(pointer), MemoryPagesDeleter(size));
+}
+
+#endif
+
+} // namespace Common
@@ -0,0 +1,36 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Frees memory from AllocateMemoryPages
+class MemoryPagesDeleter {
+public:
+    MemoryPagesDeleter() = default;
+    explicit MemoryPagesDeleter(std::size_t size) : size(size) {}
+
+    void operator()(u8* pointer) const;
+
+private:
+    std::size_t size = 0;
+};
+
+using MemoryPages = std::unique_ptr<u8[], MemoryPagesDeleter>;
+
+/**
+ * Allocates zeroed memory directly from the OS. Except for large pages on Windows, the pages are
+ * only backed when first touched, so they are placed on the NUMA node of the thread using them
+ * first.
+ * @param large_pages whether to back the memory with 2 MiB pages, which reduces TLB misses when
+ *     accessing a large area at random. It falls back to regular pages when the OS refuses.
+ */
+MemoryPages AllocateMemoryPages(std::size_t size, bool large_pages);
+
+} // namespace Common
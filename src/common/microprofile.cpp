@@ -5,3 +5,203 @@
 // Includes the MicroProfile implementation in this file for compilation
 #define MICROPROFILE_IMPL 1
 #include "common/microprofile.h"
+
+#include <memory>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+namespace Common::Profiling {
+
+#if MICROPROFILE_ENABLED
+
+// The trace is built from the per-thread logs of MicroProfile, so it has to live in the same file
+// as its implementation.
+
+namespace {
+
+struct TraceCapture {
+    FileUtil::IOFile file;
+    u32 frames_left;
+    /// Tick that the timestamps of the trace are relative to
+    MicroProfileLogEntry start_tick;
+    bool has_events = false;
+    /// Whether the name of the thread of each log was written already
+    bool thread_named[MICROPROFILE_MAX_THREADS] = {};
+    bool gpu_track_named = false;
+    /// Groups that were enabled before the capture started
+    bool previous_all_groups;
+    bool previous_force_enable;
+};
+
+std::unique_ptr<TraceCapture> capture;
+
+void WriteEvent(TraceCapture& trace, const std::string& event) {
+    trace.file.WriteString(trace.has_events ? ",\n" : "\n");
+    trace.file.WriteString(event);
+    trace.has_events = true;
+}
+
+void WriteThreadEvents(TraceCapture& trace, u32 thread_index, const MicroProfileThreadLog& log,
+                       u32 get, u32 put) {
+    const double ticks_to_us = 1000000.0 / MicroProfileTicksPerSecondCpu();
+
+    if (!trace.thread_named[thread_index]) {
+        WriteEvent(trace, fmt::format("{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+                                      "\"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+                                      thread_index, log.ThreadName));
+        trace.thread_named[thread_index] = true;
+    }
+
+    u32 range[2][2];
+    MicroProfileGetRange(put, get, range);
+    for (const auto& [begin, end] : range) {
+        for (u32 i = begin; i < end; ++i) {
+            const MicroProfileLogEntry entry = log.Log[i];
+            const int type = MicroProfileLogType(entry);
+            if (type != MP_LOG_ENTER && type != MP_LOG_LEAVE) {
+                continue;
+            }
+
+            const auto timer_index = MicroProfileLogTimerIndex(entry);
+            const auto& timer = g_MicroProfile.TimerInfo[timer_index];
+            const char* group = g_MicroProfile.GroupInfo[timer.nGroupIndex].pName;
+            const double timestamp =
+                MicroProfileLogTickDifference(trace.start_tick, entry) * ticks_to_us;
+            WriteEvent(trace, fmt::format("{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"{}\", "
+                                          "\"ts\": {:.3f}, \"pid\": 0, \"tid\": {}}}",
+                                          timer.pName, group, type == MP_LOG_ENTER ? "B" : "E",
+                                          timestamp, thread_index));
+        }
+    }
+}
+
+/// Track of the GPU scopes, after the ones of the threads
+constexpr u32 GPU_TRACK_ID = MICROPROFILE_MAX_THREADS;
+
+} // Anonymous namespace
+
+bool StartTraceCapture(const std::string& path, u32 num_frames) {
+    std::lock_guard lock(MicroProfileMutex());
+    StopTraceCapture();
+
+    auto trace = std::make_unique<TraceCapture>();
+    trace->file = FileUtil::IOFile(path, "w");
+    if (!trace->file.IsOpen()) {
+        LOG_ERROR(Common, "Failed to open trace file {}", path);
+        return false;
+    }
+    trace->file.WriteString("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    trace->frames_left = num_frames;
+    trace->start_tick = MP_LOG_TICK_MASK & MP_TICK();
+    trace->previous_all_groups = g_MicroProfile.nAllGroupsWanted != 0;
+    trace->previous_force_enable = MicroProfileGetForceEnable();
+
+    // Scopes are only logged while their group is enabled
+    MicroProfileSetEnableAllGroups(true);
+    MicroProfileSetForceEnable(true);
+
+    LOG_INFO(Common, "Capturing {} frames of profile trace to {}", num_frames, path);
+    capture = std::move(trace);
+    return true;
+}
+
+void StopTraceCapture() {
+    std::lock_guard lock(MicroProfileMutex());
+    if (!capture) {
+        return;
+    }
+
+    capture->file.WriteString("\n]}\n");
+    capture->file.Close();
+    MicroProfileSetEnableAllGroups(capture->previous_all_groups);
+    MicroProfileSetForceEnable(capture->previous_force_enable);
+    capture.reset();
+    LOG_INFO(Common, "Finished profile trace capture");
+}
+
+bool IsTraceCaptureActive() {
+    std::lock_guard lock(MicroProfileMutex());
+    return capture != nullptr;
+}
+
+void OnFrameFlipped() {
+    std::lock_guard lock(MicroProfileMutex());
+    if (!capture || !g_MicroProfile.nRunning) {
+        return;
+    }
+
+    // MicroProfileFlip has just finished processing this frame, its logs are complete
+    const MicroProfileFrameState& frame = g_MicroProfile.Frames[g_MicroProfile.nFrameCurrent];
+    const MicroProfileFrameState& next_frame =
+        g_MicroProfile.Frames[(g_MicroProfile.nFrameCurrent + 1) % MICROPROFILE_MAX_FRAME_HISTORY];
+    if (MicroProfileLogTickDifference(capture->start_tick, frame.nFrameStartCpu) < 0) {
+        // The frame started before the capture did
+        return;
+    }
+
+    for (u32 i = 0; i < MICROPROFILE_MAX_THREADS; ++i) {
+        const MicroProfileThreadLog* log = g_MicroProfile.Pool[i];
+        if (log != nullptr && !log->nGpu) {
+            WriteThreadEvents(*capture, i, *log, frame.nLogStart[i], next_frame.nLogStart[i]);
+        }
+    }
+
+    if (--capture->frames_left == 0) {
+        StopTraceCapture();
+    }
+}
+
+void AddGPUScopes(const std::vector<GPUScope>& scopes, s64 gpu_now_ns) {
+    std::lock_guard lock(MicroProfileMutex());
+    if (!capture) {
+        return;
+    }
+
+    const double ticks_to_us = 1000000.0 / MicroProfileTicksPerSecondCpu();
+    const double now_us =
+        MicroProfileLogTickDifference(capture->start_tick, MP_LOG_TICK_MASK & MP_TICK()) *
+        ticks_to_us;
+
+    if (!capture->gpu_track_named) {
+        WriteEvent(*capture, fmt::format("{{\"name\": \"thread_name\", \"ph\": \"M\", "
+                                         "\"pid\": 0, \"tid\": {}, \"args\": {{\"name\": "
+                                         "\"GPU\"}}}}",
+                                         GPU_TRACK_ID));
+        capture->gpu_track_named = true;
+    }
+
+    for (const GPUScope& scope : scopes) {
+        const double begin_us = now_us - (gpu_now_ns - scope.begin_ns) / 1000.0;
+        if (begin_us < 0.0) {
+            // Measured before the capture started
+            continue;
+        }
+        WriteEvent(*capture, fmt::format("{{\"name\": \"{}\", \"cat\": \"GPU\", \"ph\": "
+                                         "\"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": "
+                                         "0, \"tid\": {}}}",
+                                         scope.name, begin_us,
+                                         (scope.end_ns - scope.begin_ns) / 1000.0, GPU_TRACK_ID));
+    }
+}
+
+#else
+
+bool StartTraceCapture(const std::string& path, u32 num_frames) {
+    LOG_ERROR(Common, "Profile traces can't be captured, MicroProfile is disabled");
+    return false;
+}
+
+void StopTraceCapture() {}
+
+bool IsTraceCaptureActive() {
+    return false;
+}
+
+void OnFrameFlipped() {}
+
+void AddGPUScopes(const std::vector<GPUScope>& scopes, s64 gpu_now_ns) {}
+
+#endif
+
+} // namespace Common::Profiling
@@ -11,7 +11,9 @@
 // Customized Citra settings.
 // This file wraps the MicroProfile header so that these are consistent everywhere.
 #define MICROPROFILE_WEBSERVER 0
-#define MICROPROFILE_GPU_TIMERS 0 // TODO: Implement timer queries when we upgrade to OpenGL 3.3
+// GPU timings are written to trace captures by OpenGL::GPUTimer instead, MicroProfile reads its
+// timer queries back synchronously
+#define MICROPROFILE_GPU_TIMERS 0
 #define MICROPROFILE_CONTEXT_SWITCH_TRACE 0
 #define MICROPROFILE_PER_THREAD_BUFFER_SIZE (2048 << 13) // 16 MB
 
@@ -20,10 +22,49 @@
 typedef void* HANDLE;
 #endif
 
+#include <string>
+#include <vector>
 #include <microprofile.h>
+#include "common/common_types.h"
 
 #define MP_RGB(r, g, b) ((r) << 16 | (g) << 8 | (b) << 0)
 
+namespace Common::Profiling {
+
+/**
+ * Starts streaming the CPU scopes entered and left on every thread to a Chrome trace event JSON
+ * file, which can be opened in chrome://tracing or the Perfetto UI. All profiler groups are
+ * enabled while the capture is running.
+ * @param path the file to write
+ * @param num_frames number of frames to capture before the file is closed
+ * @returns false if the file could not be opened or the profiler is disabled
+ */
+bool StartTraceCapture(const std::string& path, u32 num_frames);
+
+/// Stops the running capture, if any, and finishes writing its file
+void StopTraceCapture();
+
+bool IsTraceCaptureActive();
+
+/// Writes the scopes of the last frame completed by MicroProfileFlip to the running capture
+void OnFrameFlipped();
+
+/// A scope measured by GPU timestamps
+struct GPUScope {
+    const char* name;
+    s64 begin_ns;
+    s64 end_ns;
+};
+
+/**
+ * Writes scopes measured on the GPU to the running capture, on a track of their own.
+ * @param gpu_now_ns a GPU timestamp taken right before the call, which aligns the GPU timestamps
+ * with the CPU scopes
+ */
+void AddGPUScopes(const std::vector<GPUScope>& scopes, s64 gpu_now_ns);
+
+} // namespace Common::Profiling
+
 // On OS X, some Mach header included by MicroProfile defines these as macros, conflicting with
 // identifiers we use.
 #ifdef PAGE_SIZE
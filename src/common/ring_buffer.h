@@ -89,6 +89,34 @@ public:
         return out;
     }
 
+    /// Hands the filled slots to a function without copying them out, in at most two contiguous
+    /// runs, and pops the slots it used
+    /// @param max_slots  Maximum number of slots to hand over
+    /// @param func       Called as func(const T* data, std::size_t slot_count) and returns the number
+    ///                   of slots it used. The second run is skipped unless it used the whole first.
+    /// @returns The number of slots actually popped
+    template <typename Func>
+    std::size_t Consume(std::size_t max_slots, Func&& func) {
+        const std::size_t read_index = m_read_index.load();
+        const std::size_t slots_filled = m_write_index.load() - read_index;
+        const std::size_t consume_count = std::min(slots_filled, max_slots);
+        if (consume_count == 0)
+            return 0;
+
+        const std::size_t pos = read_index % capacity;
+        const std::size_t first_run = std::min(capacity - pos, consume_count);
+        const std::size_t second_run = consume_count - first_run;
+
+        std::size_t consumed = func(m_data.data() + pos * granularity, first_run);
+        if (consumed == first_run && second_run != 0) {
+            consumed += func(m_data.data(), second_run);
+        }
+
+        m_read_index.store(read_index + consumed);
+
+        return consumed;
+    }
+
     /// @returns Number of slots used
     std::size_t Size() const {
         return m_write_index.load() - m_read_index.load();
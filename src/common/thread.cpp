@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <vector>
 #include "common/thread.h"
 #ifdef __APPLE__
 #include <mach/mach.h>
@@ -18,6 +21,10 @@
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 
 #ifdef __FreeBSD__
 #define cpu_set_t cpuset_t
@@ -112,4 +119,159 @@ void SetCurrentThreadName(const char* name) {
 
 #endif
 
+namespace {
+
+#ifdef _WIN32
+
+int GetNativePriority(ThreadPriority priority) {
+    switch (priority) {
+    case ThreadPriority::Low:
+        return THREAD_PRIORITY_BELOW_NORMAL;
+    case ThreadPriority::High:
+        return THREAD_PRIORITY_ABOVE_NORMAL;
+    case ThreadPriority::VeryHigh:
+        return THREAD_PRIORITY_HIGHEST;
+    default:
+        return THREAD_PRIORITY_NORMAL;
+    }
+}
+
+std::uintptr_t GetCurrentNativeId() {
+    // GetCurrentThread() only returns a handle that refers to whichever thread uses it
+    return reinterpret_cast<std::uintptr_t>(OpenThread(
+        THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId()));
+}
+
+void ReleaseNativeId(std::uintptr_t id) {
+    CloseHandle(reinterpret_cast<HANDLE>(id));
+}
+
+void SetNativeAffinity(std::uintptr_t id, u32 mask) {
+    DWORD_PTR thread_mask = mask;
+    if (mask == 0) {
+        // The cores the process may run on
+        DWORD_PTR system_mask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &thread_mask, &system_mask))
+            return;
+    }
+    SetThreadAffinityMask(reinterpret_cast<HANDLE>(id), thread_mask);
+}
+
+void SetNativePriority(std::uintptr_t id, ThreadPriority priority) {
+    SetThreadPriority(reinterpret_cast<HANDLE>(id), GetNativePriority(priority));
+}
+
+#elif defined(__linux__)
+
+// Threads are scheduled on their own on Linux, so the nice value and the affinity of a thread id
+// only apply to that thread. This works on Android as well, which lacks pthread_setaffinity_np.
+std::uintptr_t GetCurrentNativeId() {
+    return static_cast<std::uintptr_t>(syscall(SYS_gettid));
+}
+
+void ReleaseNativeId(std::uintptr_t) {}
+
+/// The cores the process was started on, before any thread got a role
+const cpu_set_t initial_cpu_set = [] {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+    return cpu_set;
+}();
+
+void SetNativeAffinity(std::uintptr_t id, u32 mask) {
+    cpu_set_t cpu_set = initial_cpu_set;
+    if (mask != 0) {
+        CPU_ZERO(&cpu_set);
+        for (int i = 0; i != sizeof(mask) * 8; ++i)
+            if ((mask >> i) & 1)
+                CPU_SET(i, &cpu_set);
+    }
+    sched_setaffinity(static_cast<pid_t>(id), sizeof(cpu_set), &cpu_set);
+}
+
+void SetNativePriority(std::uintptr_t id, ThreadPriority priority) {
+    static constexpr std::array<int, 4> nice_values{10, 0, -5, -10};
+    setpriority(PRIO_PROCESS, static_cast<id_t>(id),
+                nice_values[static_cast<std::size_t>(priority)]);
+}
+
+#else
+
+std::uintptr_t GetCurrentNativeId() {
+    return reinterpret_cast<std::uintptr_t>(pthread_self());
+}
+
+void ReleaseNativeId(std::uintptr_t) {}
+
+void SetNativeAffinity(std::uintptr_t id, u32 mask) {
+    // An affinity tag of 0 doesn't tie the thread to other threads on macOS
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    SetThreadAffinity(reinterpret_cast<pthread_t>(id), mask);
+#endif
+}
+
+void SetNativePriority(std::uintptr_t id, ThreadPriority priority) {
+    // Spread the levels over the range of the default policy, whose middle is the usual priority
+    const int min = sched_get_priority_min(SCHED_OTHER);
+    const int max = sched_get_priority_max(SCHED_OTHER);
+    const int middle = (min + max) / 2;
+    const std::array<int, 4> priorities{min, middle, (middle + max) / 2, max};
+    sched_param param{};
+    param.sched_priority = priorities[static_cast<std::size_t>(priority)];
+    pthread_setschedparam(reinterpret_cast<pthread_t>(id), SCHED_OTHER, &param);
+}
+
+#endif
+
+std::mutex role_mutex;
+std::array<ThreadRoleConfig, NUM_THREAD_ROLES> role_configs;
+/// Threads that currently have a role, guarded by role_mutex
+std::vector<const ScopedThreadRole*> role_threads;
+
+} // Anonymous namespace
+
+void SetCurrentThreadPriority(ThreadPriority priority) {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), GetNativePriority(priority));
+#else
+    SetNativePriority(GetCurrentNativeId(), priority);
+#endif
+}
+
+void SetThreadRoleConfig(ThreadRole role, const ThreadRoleConfig& config) {
+    std::lock_guard lock{role_mutex};
+    ThreadRoleConfig& current = role_configs[static_cast<std::size_t>(role)];
+    const bool affinity_changed = current.affinity_mask != config.affinity_mask;
+    const bool priority_changed = current.priority != config.priority;
+    current = config;
+
+    for (const ScopedThreadRole* thread : role_threads) {
+        if (thread->role != role)
+            continue;
+        if (affinity_changed)
+            SetNativeAffinity(thread->native_id, config.affinity_mask);
+        if (priority_changed)
+            SetNativePriority(thread->native_id, config.priority);
+    }
+}
+
+ScopedThreadRole::ScopedThreadRole(ThreadRole role) : role(role), native_id(GetCurrentNativeId()) {
+    std::lock_guard lock{role_mutex};
+    role_threads.push_back(this);
+
+    // The defaults leave the thread as the system set it up
+    const ThreadRoleConfig& config = role_configs[static_cast<std::size_t>(role)];
+    if (config.affinity_mask != 0)
+        SetNativeAffinity(native_id, config.affinity_mask);
+    if (config.priority != ThreadPriority::Normal)
+        SetNativePriority(native_id, config.priority);
+}
+
+ScopedThreadRole::~ScopedThreadRole() {
+    std::lock_guard lock{role_mutex};
+    role_threads.erase(std::find(role_threads.begin(), role_threads.end(), this));
+    ReleaseNativeId(native_id);
+}
+
 } // namespace Common
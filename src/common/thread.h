@@ -7,6 +7,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <thread>
 #include "common/common_types.h"
@@ -97,4 +98,60 @@ void SetCurrentThreadAffinity(u32 mask);
 void SwitchCurrentThread(); // On Linux, this is equal to sleep 1ms
 void SetCurrentThreadName(const char* name);
 
+enum class ThreadPriority : u32 {
+    Low,
+    Normal,
+    High,
+    /// Usually needs extra privileges, the priority is left unchanged without them
+    VeryHigh,
+};
+
+void SetCurrentThreadPriority(ThreadPriority priority);
+
+/// What a thread is used for. Each role can be given its own cores and scheduling priority.
+enum class ThreadRole : u32 {
+    /// The thread running the emulated CPU
+    CPU,
+    /// GPU command processing and presentation
+    GPU,
+    /// Audio processing and the sink callbacks
+    Audio,
+    /// Logging, input polling and reading ahead from files
+    IO,
+    /// The frontend's main thread
+    UI,
+};
+
+constexpr std::size_t NUM_THREAD_ROLES = 5;
+
+struct ThreadRoleConfig {
+    /// Cores the threads may run on, as for SetThreadAffinity, 0 for any core
+    u32 affinity_mask = 0;
+    ThreadPriority priority = ThreadPriority::Normal;
+};
+
+/// Sets the configuration of a role, and applies it to the threads that currently have that role
+void SetThreadRoleConfig(ThreadRole role, const ThreadRoleConfig& config);
+
+/**
+ * Gives the calling thread the affinity and priority configured for a role for as long as the
+ * object lives, including configuration changes made in the meantime. Threads the frontend or a
+ * library creates can use a thread_local instance.
+ */
+class ScopedThreadRole {
+public:
+    explicit ScopedThreadRole(ThreadRole role);
+    ~ScopedThreadRole();
+
+    ScopedThreadRole(const ScopedThreadRole&) = delete;
+    ScopedThreadRole& operator=(const ScopedThreadRole&) = delete;
+
+private:
+    friend void SetThreadRoleConfig(ThreadRole role, const ThreadRoleConfig& config);
+
+    ThreadRole role;
+    /// Platform identifier of the thread that other threads can change the scheduling of
+    std::uintptr_t native_id;
+};
+
 } // namespace Common
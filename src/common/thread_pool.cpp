@@ -0,0 +1,235 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/assert.h"
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+class ThreadPool::Task {
+public:
+    enum class State {
+        /// Some dependencies haven't finished yet
+        Blocked,
+        Queued,
+        Running,
+        Finished,
+    };
+
+    std::function<void()> function;
+    Priority priority;
+    std::atomic<State> state{State::Blocked};
+    /// Unfinished dependencies, plus one while the task is being submitted
+    std::atomic<std::size_t> remaining_dependencies{1};
+
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    /// Tasks depending on this one, guarded by mutex until the task finishes
+    std::vector<TaskHandle> dependents;
+};
+
+namespace {
+/// Pool of the worker running on this thread, if any
+thread_local ThreadPool* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+} // Anonymous namespace
+
+ThreadPool::ThreadPool(std::size_t num_threads, u32 affinity_mask) {
+    ASSERT(num_threads != 0);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+        if (affinity_mask != 0) {
+            SetThreadAffinity(workers[i]->thread.native_handle(), affinity_mask);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    // The workers finish the queued tasks before exiting
+    {
+        std::lock_guard lock{sleep_mutex};
+        stop = true;
+    }
+    sleep_cv.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+ThreadPool::TaskHandle ThreadPool::Submit(std::function<void()> function, Priority priority,
+                                          const std::vector<TaskHandle>& dependencies) {
+    auto task = std::make_shared<Task>();
+    task->function = std::move(function);
+    task->priority = priority;
+
+    for (const TaskHandle& dependency : dependencies) {
+        std::lock_guard lock{dependency->mutex};
+        if (dependency->state != Task::State::Finished) {
+            dependency->dependents.push_back(task);
+            ++task->remaining_dependencies;
+        }
+    }
+    if (--task->remaining_dependencies == 0) {
+        Enqueue(task);
+    }
+    return task;
+}
+
+void ThreadPool::Wait(const TaskHandle& task) {
+    auto state = Task::State::Queued;
+    if (task->state.compare_exchange_strong(state, Task::State::Running)) {
+        Run(*task);
+        return;
+    }
+
+    if (current_pool == this) {
+        // Blocking would take a worker away from the tasks this one may depend on
+        while (task->state != Task::State::Finished) {
+            if (TaskHandle other = TakeTask(current_worker)) {
+                Run(*other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+
+    std::unique_lock lock{task->mutex};
+    task->finished_cv.wait(lock, [&task] { return task->state == Task::State::Finished; });
+}
+
+void ThreadPool::ParallelFor(std::size_t num_tasks, std::size_t max_threads,
+                             const std::function<void(std::size_t)>& task, Priority priority) {
+    const std::size_t num_threads = std::min({max_threads, workers.size() + 1, num_tasks});
+    if (num_threads <= 1) {
+        for (std::size_t i = 0; i < num_tasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next_task{0};
+    const auto run_tasks = [&] {
+        for (std::size_t i = next_task++; i < num_tasks; i = next_task++) {
+            task(i);
+        }
+    };
+
+    std::vector<TaskHandle> helpers;
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        helpers.push_back(Submit(run_tasks, priority));
+    }
+    run_tasks();
+    // Helpers no worker got to yet find nothing left to do
+    for (const TaskHandle& helper : helpers) {
+        Wait(helper);
+    }
+}
+
+void ThreadPool::Enqueue(TaskHandle task) {
+    task->state = Task::State::Queued;
+    const std::size_t worker_index =
+        current_pool == this ? current_worker : next_worker++ % workers.size();
+    Worker& worker = *workers[worker_index];
+    {
+        std::lock_guard lock{worker.mutex};
+        worker.queues[static_cast<std::size_t>(task->priority)].push_back(std::move(task));
+    }
+
+    ++num_queued;
+    {
+        std::lock_guard lock{sleep_mutex};
+    }
+    sleep_cv.notify_one();
+}
+
+ThreadPool::TaskHandle ThreadPool::TakeTask(std::size_t worker_index) {
+    while (num_queued != 0) {
+        bool found = false;
+        for (std::size_t priority = 0; priority < NUM_PRIORITIES; ++priority) {
+            // The newest task of the worker itself, or the oldest one of another worker
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                Worker& worker = *workers[(worker_index + i) % workers.size()];
+                TaskHandle task;
+                {
+                    std::lock_guard lock{worker.mutex};
+                    auto& queue = worker.queues[priority];
+                    if (queue.empty())
+                        continue;
+                    if (i == 0) {
+                        task = std::move(queue.back());
+                        queue.pop_back();
+                    } else {
+                        task = std::move(queue.front());
+                        queue.pop_front();
+                    }
+                }
+                --num_queued;
+                found = true;
+
+                // Wait may have run the task already
+                auto state = Task::State::Queued;
+                if (task->state.compare_exchange_strong(state, Task::State::Running)) {
+                    return task;
+                }
+                break;
+            }
+            if (found)
+                break;
+        }
+        if (!found)
+            return nullptr;
+    }
+    return nullptr;
+}
+
+void ThreadPool::Run(Task& task) {
+    task.function();
+    task.function = nullptr;
+
+    std::vector<TaskHandle> dependents;
+    {
+        std::lock_guard lock{task.mutex};
+        task.state = Task::State::Finished;
+        dependents = std::move(task.dependents);
+    }
+    task.finished_cv.notify_all();
+
+    for (TaskHandle& dependent : dependents) {
+        if (--dependent->remaining_dependencies == 0) {
+            Enqueue(std::move(dependent));
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(std::size_t worker_index) {
+    SetCurrentThreadName("ThreadPool");
+    current_pool = this;
+    current_worker = worker_index;
+
+    while (true) {
+        if (TaskHandle task = TakeTask(worker_index)) {
+            Run(*task);
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex};
+        sleep_cv.wait(lock, [this] { return stop || num_queued != 0; });
+        if (stop && num_queued == 0)
+            return;
+    }
+}
+
+ThreadPool& GetThreadPool() {
+    static ThreadPool pool{std::max(2u, std::thread::hardware_concurrency()) - 1};
+    return pool;
+}
+
+} // namespace Common
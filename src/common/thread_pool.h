@@ -0,0 +1,97 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Worker threads running tasks, with priorities and dependencies between tasks. Each worker has
+ * its own queues, tasks submitted by a worker are queued on it, and a worker without tasks of a
+ * priority steals them from the others before looking at lower priorities.
+ */
+class ThreadPool {
+public:
+    enum class Priority {
+        /// Work a thread is waiting for, e.g. the chunks of ParallelFor
+        High,
+        Normal,
+        /// Work done ahead of time, e.g. precompiling shaders
+        Low,
+    };
+
+    class Task;
+    using TaskHandle = std::shared_ptr<Task>;
+
+    /**
+     * @param num_threads number of workers, at least one
+     * @param affinity_mask cores the workers may run on, as for SetThreadAffinity, 0 for any core
+     */
+    explicit ThreadPool(std::size_t num_threads, u32 affinity_mask = 0);
+    ~ThreadPool();
+
+    std::size_t GetNumThreads() const {
+        return workers.size();
+    }
+
+    /// Queues a task, which starts once every task of dependencies has finished
+    TaskHandle Submit(std::function<void()> function, Priority priority = Priority::Normal,
+                      const std::vector<TaskHandle>& dependencies = {});
+
+    /**
+     * Waits for a task to finish. A queued task that no worker has started yet is run by the
+     * calling thread, and a worker waiting for a task runs other tasks meanwhile.
+     */
+    void Wait(const TaskHandle& task);
+
+    /**
+     * Runs task(0) to task(num_tasks - 1) and waits until all of them have returned. They are run
+     * in no particular order by at most max_threads threads, including the calling one.
+     */
+    void ParallelFor(std::size_t num_tasks, std::size_t max_threads,
+                     const std::function<void(std::size_t)>& task,
+                     Priority priority = Priority::High);
+
+private:
+    static constexpr std::size_t NUM_PRIORITIES = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<TaskHandle>, NUM_PRIORITIES> queues;
+        std::thread thread;
+    };
+
+    void Enqueue(TaskHandle task);
+    /// Takes a queued task, from the queues of the given worker first
+    TaskHandle TakeTask(std::size_t worker_index);
+    void Run(Task& task);
+    void WorkerLoop(std::size_t worker_index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    /// Worker the next task submitted from another thread is queued on
+    std::atomic<std::size_t> next_worker{0};
+    /// Entries in the queues, including the ones of tasks Wait has already run
+    std::atomic<std::size_t> num_queued{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool stop = false;
+};
+
+/// The pool shared by the subsystems, with a worker per core but one, created on first use
+ThreadPool& GetThreadPool();
+
+} // namespace Common
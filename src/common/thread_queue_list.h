@@ -4,32 +4,33 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <deque>
-#include <boost/range/algorithm_ext/erase.hpp>
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
+/**
+ * Queue of ready threads sorted by priority, where 0 is the highest priority. A bitmap of the
+ * non-empty priority levels is kept alongside the queues, so that finding the highest priority
+ * thread is a single bit scan instead of a walk over the levels.
+ */
 template <class T, unsigned int N>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
+    static_assert(N <= 64, "The priority bitmap only has room for 64 levels");
 
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
-
     // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
+    Priority contains(const T& uid) const {
         for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
+            const Queue& cur = queues[i];
+            if (std::find(cur.cbegin(), cur.cend(), uid) != cur.cend()) {
                 return i;
             }
         }
@@ -37,123 +38,86 @@ struct ThreadQueueList {
         return -1;
     }
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
+    T get_first() const {
+        if (nonempty == 0) {
+            return T();
         }
-
-        return T();
+        return queues[LeastSignificantSetBit(nonempty)].front();
     }
 
     T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+        if (nonempty == 0) {
+            return T();
         }
-
-        return T();
+        return pop_from(static_cast<Priority>(LeastSignificantSetBit(nonempty)));
     }
 
     T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+        // Only the levels strictly above the given priority are candidates
+        const u64 better = nonempty & ((u64(1) << priority) - 1);
+        if (better == 0) {
+            return T();
         }
-
-        return T();
+        return pop_from(static_cast<Priority>(LeastSignificantSetBit(better)));
     }
 
     void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+        queues[priority].push_front(thread_id);
+        nonempty |= u64(1) << priority;
     }
 
     void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+        queues[priority].push_back(thread_id);
+        nonempty |= u64(1) << priority;
     }
 
     void move(const T& thread_id, Priority old_priority, Priority new_priority) {
         remove(old_priority, thread_id);
-        prepare(new_priority);
         push_back(new_priority, thread_id);
     }
 
     void remove(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        boost::remove_erase(cur->data, thread_id);
+        Queue& cur = queues[priority];
+        cur.erase(std::remove(cur.begin(), cur.end(), thread_id), cur.end());
+        if (cur.empty()) {
+            nonempty &= ~(u64(1) << priority);
+        }
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
+        Queue& cur = queues[priority];
 
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+        if (cur.size() > 1) {
+            cur.push_back(std::move(cur.front()));
+            cur.pop_front();
         }
     }
 
     void clear() {
         queues.fill(Queue());
-        first = nullptr;
+        nonempty = 0;
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return queues[priority].empty();
     }
 
 private:
-    struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
-    };
-
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
-    }
-
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
+    // Double-ended queue of threads in a priority level
+    using Queue = std::deque<T>;
+
+    T pop_from(Priority priority) {
+        Queue& cur = queues[priority];
+        auto tmp = std::move(cur.front());
+        cur.pop_front();
+        if (cur.empty()) {
+            nonempty &= ~(u64(1) << priority);
         }
-
-        cur->next_nonempty = first;
-        first = cur;
+        return tmp;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
+    // Bit N is set when the queue of priority N holds at least one thread.
+    u64 nonempty = 0;
     // The priority level queues of thread ids.
     std::array<Queue, NUM_QUEUES> queues;
 };
@@ -8,10 +8,13 @@
 // single reader, single writer queue
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
+#include <thread>
+#include <utility>
 #include "common/common_types.h"
 
 namespace Common {
@@ -120,49 +123,228 @@ private:
     std::condition_variable cv;
 };
 
-// a simple thread-safe,
-// single reader, multiple writer queue
+/// Size of a cache line, the indices of the queues below are kept on separate ones
+constexpr std::size_t CACHE_LINE_SIZE = 64;
 
+namespace detail {
+
+/// Lets the consumer of a lock-free queue sleep until an element is published
+class ConsumerWakeup {
+public:
+    /// Called by the producers after publishing an element
+    void Notify() {
+        // Pairs with the fence in Wait, either the consumer sees the element or this sees it
+        // waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard lock{mutex};
+            cv.notify_one();
+        }
+    }
+
+    /// Blocks the consumer until ready returns true
+    template <typename Predicate>
+    void Wait(Predicate ready) {
+        // Sleeping and waking up costs much more than the usual time between two elements
+        for (int i = 0; i < SPIN_COUNT; ++i) {
+            if (ready())
+                return;
+            std::this_thread::yield();
+        }
+        std::unique_lock lock{mutex};
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lock, ready);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int SPIN_COUNT = 16;
+
+    std::atomic<bool> waiting{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+} // namespace detail
+
+/**
+ * A lock-free single reader, single writer queue of at most Capacity elements, stored in a ring
+ * buffer so that pushing never allocates. Each side caches the index of the other one, so the
+ * cache line the other side writes to is only read when the queue looks full or empty.
+ */
+template <typename T, std::size_t Capacity>
+class BoundedSPSCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    std::size_t Size() const {
+        return producer.index.load(std::memory_order_acquire) -
+               consumer.index.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const {
+        return consumer.index.load(std::memory_order_relaxed) ==
+               producer.index.load(std::memory_order_acquire);
+    }
+
+    /// @returns false, leaving t untouched, if the queue is full
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        const std::size_t index = producer.index.load(std::memory_order_relaxed);
+        if (index - producer.other_index == Capacity) {
+            producer.other_index = consumer.index.load(std::memory_order_acquire);
+            if (index - producer.other_index == Capacity)
+                return false;
+        }
+        slots[index & (Capacity - 1)] = std::forward<Arg>(t);
+        producer.index.store(index + 1, std::memory_order_release);
+        wakeup.Notify();
+        return true;
+    }
+
+    /// Pushes an element, yielding while the queue is full
+    template <typename Arg>
+    void Push(Arg&& t) {
+        while (!TryPush(std::forward<Arg>(t))) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool Pop(T& t) {
+        const std::size_t index = consumer.index.load(std::memory_order_relaxed);
+        if (index == consumer.other_index) {
+            consumer.other_index = producer.index.load(std::memory_order_acquire);
+            if (index == consumer.other_index)
+                return false;
+        }
+        t = std::move(slots[index & (Capacity - 1)]);
+        consumer.index.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+    T PopWait() {
+        T t;
+        if (!Pop(t)) {
+            wakeup.Wait([this] { return !Empty(); });
+            Pop(t);
+        }
+        return t;
+    }
+
+    /// Drops every element, only called by the reader
+    void Clear() {
+        T t;
+        while (Pop(t)) {
+        }
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Side {
+        /// Index of the next element this side pushes or pops
+        std::atomic<std::size_t> index{0};
+        /// Last index of the other side this side has read
+        std::size_t other_index = 0;
+    };
+
+    Side producer;
+    Side consumer;
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots{};
+    detail::ConsumerWakeup wakeup;
+};
+
+/**
+ * A lock-free single reader, multiple writer queue (Dmitry Vyukov's node based MPSC queue).
+ * A writer only does an exchange and a store, so writers never wait for each other. An element
+ * becomes visible once the writer that pushed it and the ones before it are done pushing.
+ */
 template <typename T, bool NeedSize = true>
 class MPSCQueue {
 public:
+    MPSCQueue() : size(0) {
+        read_ptr = new Node();
+        write_ptr.store(read_ptr, std::memory_order_relaxed);
+    }
+    ~MPSCQueue() {
+        while (read_ptr) {
+            Node* next = read_ptr->next.load(std::memory_order_relaxed);
+            delete read_ptr;
+            read_ptr = next;
+        }
+    }
+
     u32 Size() const {
-        return spsc_queue.Size();
+        static_assert(NeedSize, "using Size() on MPSCQueue without NeedSize");
+        return size.load();
     }
 
     bool Empty() const {
-        return spsc_queue.Empty();
+        return !read_ptr->next.load(std::memory_order_acquire);
     }
 
     T& Front() const {
-        return spsc_queue.Front();
+        return read_ptr->next.load(std::memory_order_acquire)->current;
     }
 
     template <typename Arg>
     void Push(Arg&& t) {
-        std::lock_guard<std::mutex> lock(write_lock);
-        spsc_queue.Push(t);
+        Node* node = new Node();
+        node->current = std::forward<Arg>(t);
+        if (NeedSize)
+            size++;
+        Node* previous = write_ptr.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+        wakeup.Notify();
     }
 
     void Pop() {
-        return spsc_queue.Pop();
+        T t;
+        Pop(t);
     }
 
     bool Pop(T& t) {
-        return spsc_queue.Pop(t);
+        Node* next = read_ptr->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        if (NeedSize)
+            size--;
+
+        // The popped node becomes the new head, its element is moved out of it
+        t = std::move(next->current);
+        delete read_ptr;
+        read_ptr = next;
+        return true;
     }
 
     T PopWait() {
-        return spsc_queue.PopWait();
+        T t;
+        if (!Pop(t)) {
+            wakeup.Wait([this] { return !Empty(); });
+            Pop(t);
+        }
+        return t;
     }
 
     // not thread-safe
     void Clear() {
-        spsc_queue.Clear();
+        T t;
+        while (Pop(t)) {
+        }
     }
 
 private:
-    SPSCQueue<T, NeedSize> spsc_queue;
-    std::mutex write_lock;
+    struct Node {
+        T current{};
+        std::atomic<Node*> next{nullptr};
+    };
+
+    /// Last node pushed, written by every writer
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> write_ptr;
+    /// Node before the next element to pop, only used by the reader
+    alignas(CACHE_LINE_SIZE) Node* read_ptr;
+    std::atomic<u32> size;
+    detail::ConsumerWakeup wakeup;
 };
 } // namespace Common
@@ -20,28 +20,53 @@ namespace Core {
 static constexpr std::chrono::seconds announce_time_interval(15);
 
 AnnounceMultiplayerSession::AnnounceMultiplayerSession() {
+    announced_rooms.emplace_back().backend = CreateBackend();
+}
+
+AnnounceMultiplayerSession::AnnounceMultiplayerSession(
+    const std::vector<std::shared_ptr<Network::Room>>& rooms) {
+    ASSERT(!rooms.empty());
+    for (const auto& room : rooms) {
+        AnnouncedRoom& announced_room = announced_rooms.emplace_back();
+        announced_room.room = room;
+        announced_room.backend = CreateBackend();
+    }
+}
+
+std::unique_ptr<AnnounceMultiplayerRoom::Backend> AnnounceMultiplayerSession::CreateBackend() {
 #ifdef ENABLE_WEB_SERVICE
-    backend = std::make_unique<WebService::RoomJson>(Settings::values.web_api_url,
-                                                     Settings::values.citra_username,
-                                                     Settings::values.citra_token);
+    return std::make_unique<WebService::RoomJson>(Settings::values.web_api_url,
+                                                  Settings::values.citra_username,
+                                                  Settings::values.citra_token);
 #else
-    backend = std::make_unique<AnnounceMultiplayerRoom::NullBackend>();
+    return std::make_unique<AnnounceMultiplayerRoom::NullBackend>();
 #endif
 }
 
+std::shared_ptr<Network::Room> AnnounceMultiplayerSession::GetRoom(
+    const AnnouncedRoom& announced_room) {
+    return announced_room.room ? announced_room.room : Network::GetRoom().lock();
+}
+
 void AnnounceMultiplayerSession::Register() {
-    std::shared_ptr<Network::Room> room = Network::GetRoom().lock();
+    for (auto& announced_room : announced_rooms) {
+        Register(announced_room);
+    }
+}
+
+void AnnounceMultiplayerSession::Register(AnnouncedRoom& announced_room) {
+    std::shared_ptr<Network::Room> room = GetRoom(announced_room);
     if (!room) {
         return;
     }
     if (room->GetState() != Network::Room::State::Open) {
         return;
     }
-    UpdateBackendData(room);
-    std::string result = backend->Register();
+    UpdateBackendData(*announced_room.backend, room);
+    std::string result = announced_room.backend->Register();
     LOG_INFO(WebService, "Room has been registered");
     room->SetVerifyUID(result);
-    registered = true;
+    announced_room.registered = true;
 }
 
 void AnnounceMultiplayerSession::Start() {
@@ -58,8 +83,10 @@ void AnnounceMultiplayerSession::Stop() {
         shutdown_event.Set();
         announce_multiplayer_thread->join();
         announce_multiplayer_thread.reset();
-        backend->Delete();
-        registered = false;
+        for (auto& announced_room : announced_rooms) {
+            announced_room.backend->Delete();
+            announced_room.registered = false;
+        }
     }
 }
 
@@ -80,53 +107,60 @@ AnnounceMultiplayerSession::~AnnounceMultiplayerSession() {
     Stop();
 }
 
-void AnnounceMultiplayerSession::UpdateBackendData(std::shared_ptr<Network::Room> room) {
+void AnnounceMultiplayerSession::UpdateBackendData(AnnounceMultiplayerRoom::Backend& backend,
+                                                   std::shared_ptr<Network::Room> room) {
     Network::RoomInformation room_information = room->GetRoomInformation();
     std::vector<Network::Room::Member> memberlist = room->GetRoomMemberList();
-    backend->SetRoomInformation(
+    backend.SetRoomInformation(
         room_information.name, room_information.description, room_information.port,
         room_information.member_slots, Network::network_version, room->HasPassword(),
         room_information.preferred_game, room_information.preferred_game_id);
-    backend->ClearPlayers();
+    backend.ClearPlayers();
     for (const auto& member : memberlist) {
-        backend->AddPlayer(member.username, member.nickname, member.avatar_url, member.mac_address,
+        backend.AddPlayer(member.username, member.nickname, member.avatar_url, member.mac_address,
                            member.game_info.id, member.game_info.name);
     }
 }
 
 void AnnounceMultiplayerSession::AnnounceMultiplayerLoop() {
-    if (!registered) {
-        Register();
+    for (auto& announced_room : announced_rooms) {
+        if (!announced_room.registered) {
+            Register(announced_room);
+        }
     }
     auto update_time = std::chrono::steady_clock::now();
     std::future<Common::WebResult> future;
     while (!shutdown_event.WaitUntil(update_time)) {
         update_time += announce_time_interval;
-        std::shared_ptr<Network::Room> room = Network::GetRoom().lock();
-        if (!room) {
-            break;
-        }
-        if (room->GetState() != Network::Room::State::Open) {
-            break;
-        }
-        UpdateBackendData(room);
-        Common::WebResult result = backend->Update();
-        if (result.result_code != Common::WebResult::Code::Success) {
-            std::lock_guard<std::mutex> lock(callback_mutex);
-            for (auto callback : error_callbacks) {
-                (*callback)(result);
+        bool any_room_open = false;
+        for (auto& announced_room : announced_rooms) {
+            std::shared_ptr<Network::Room> room = GetRoom(announced_room);
+            if (!room || room->GetState() != Network::Room::State::Open) {
+                continue;
+            }
+            any_room_open = true;
+            UpdateBackendData(*announced_room.backend, room);
+            Common::WebResult result = announced_room.backend->Update();
+            if (result.result_code != Common::WebResult::Code::Success) {
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                for (auto callback : error_callbacks) {
+                    (*callback)(result);
+                }
+            }
+            if (result.result_string == "404") {
+                announced_room.registered = false;
+                // Needs to register the room again
+                Register(announced_room);
             }
         }
-        if (result.result_string == "404") {
-            registered = false;
-            // Needs to register the room again
-            Register();
+        if (!any_room_open) {
+            break;
         }
     }
 }
 
 AnnounceMultiplayerRoom::RoomList AnnounceMultiplayerSession::GetRoomList() {
-    return backend->GetRoomList();
+    return announced_rooms.front().backend->GetRoomList();
 }
 
 } // namespace Core
@@ -6,10 +6,12 @@
 
 #include <atomic>
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <vector>
 #include "common/announce_multiplayer_room.h"
 #include "common/common_types.h"
 #include "common/thread.h"
@@ -24,11 +26,15 @@ namespace Core {
  * Instruments AnnounceMultiplayerRoom::Backend.
  * Creates a thread that regularly updates the room information and submits them
  * An async get of room information is also possible
+ * A single session can announce several rooms, which then share its thread
  */
 class AnnounceMultiplayerSession : NonCopyable {
 public:
     using CallbackHandle = std::shared_ptr<std::function<void(const Common::WebResult&)>>;
+    /// Announces the room of Network::GetRoom
     AnnounceMultiplayerSession();
+    /// Announces the given rooms, each registered on its own
+    explicit AnnounceMultiplayerSession(const std::vector<std::shared_ptr<Network::Room>>& rooms);
     ~AnnounceMultiplayerSession();
 
     /**
@@ -44,7 +50,7 @@ public:
      */
     void UnbindErrorCallback(CallbackHandle handle);
 
-    /// Registers a room to web services
+    /// Registers the rooms to web services
     void Register();
 
     /**
@@ -70,12 +76,21 @@ private:
     std::set<CallbackHandle> error_callbacks;
     std::unique_ptr<std::thread> announce_multiplayer_thread;
 
-    /// Backend interface that logs fields
-    std::unique_ptr<AnnounceMultiplayerRoom::Backend> backend;
-
-    std::atomic_bool registered = false; ///< Whether the room has been registered
-
-    void UpdateBackendData(std::shared_ptr<Network::Room> room);
+    struct AnnouncedRoom {
+        /// The announced room, Network::GetRoom when null
+        std::shared_ptr<Network::Room> room;
+        /// Backend interface that logs fields
+        std::unique_ptr<AnnounceMultiplayerRoom::Backend> backend;
+        std::atomic_bool registered = false; ///< Whether the room has been registered
+    };
+    /// A list, as the entries can't be moved
+    std::list<AnnouncedRoom> announced_rooms;
+
+    static std::unique_ptr<AnnounceMultiplayerRoom::Backend> CreateBackend();
+    static std::shared_ptr<Network::Room> GetRoom(const AnnouncedRoom& announced_room);
+    void Register(AnnouncedRoom& announced_room);
+    void UpdateBackendData(AnnounceMultiplayerRoom::Backend& backend,
+                           std::shared_ptr<Network::Room> room);
     void AnnounceMultiplayerLoop();
 };
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <memory>
 #include "common/common_types.h"
@@ -98,6 +99,12 @@ public:
      */
     virtual void SetReg(int index, u32 value) = 0;
 
+    /**
+     * Gets the ARM registers, for callers accessing several of them at once
+     * @return The register file, valid until the next call to PageTableChanged
+     */
+    virtual std::array<u32, 16>& GetRegisters() = 0;
+
     /**
      * Gets the value of a VFP register
      * @param index Register index (0-31)
@@ -172,4 +179,10 @@ public:
 
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
+
+    /**
+     * Sets whether Run may fast-forward to the next Core::Timing event when the guest is spinning
+     * in an idle loop (see IsIdleLoop)
+     */
+    virtual void SetIdleLoopSkipping(bool enabled) = 0;
 };
@@ -6,9 +6,11 @@
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
+#include "core/arm/idle_loop.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -16,6 +18,9 @@
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
 
+/// Size of the code cache dynarmic reserves for each JIT, which its interface doesn't expose
+constexpr s64 DYNARMIC_CODE_CACHE_SIZE = 128 * 1024 * 1024;
+
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
 public:
     DynarmicThreadContext() {
@@ -124,6 +129,15 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
+        // Titles poll svcGetSystemTick in tight loops and it only reads the clock, so it skips
+        // the kernel lock and the SVC table. This must stay in sync with SVC::GetSystemTick.
+        if (swi == GET_SYSTEM_TICK_SVC) {
+            const u64 ticks = timing.GetTicks();
+            timing.AddTicks(150);
+            parent.jit->Regs()[0] = static_cast<u32>(ticks);
+            parent.jit->Regs()[1] = static_cast<u32>(ticks >> 32);
+            return;
+        }
         svc_context.CallSVC(swi);
     }
 
@@ -149,14 +163,18 @@ public:
                    static_cast<std::size_t>(exception), pc, MemoryReadCode(pc));
     }
 
+    // Dynarmic counts one tick per instruction, so only the CPU clock is applied to it and not
+    // the cycle costs that dyncom uses for each class of instructions
     void AddTicks(std::uint64_t ticks) override {
-        timing.AddTicks(ticks);
+        timing.AddCPUCycles(ticks);
     }
     std::uint64_t GetTicksRemaining() override {
-        s64 ticks = timing.GetDowncount();
+        s64 ticks = timing.GetCPUCyclesRemaining();
         return static_cast<u64>(ticks <= 0 ? 0 : ticks);
     }
 
+    static constexpr std::uint32_t GET_SYSTEM_TICK_SVC = 0x28;
+
     ARM_Dynarmic& parent;
     Core::Timing& timing;
     Kernel::SVCContext svc_context;
@@ -178,6 +196,14 @@ void ARM_Dynarmic::Run() {
     MICROPROFILE_SCOPE(ARM_Jit);
 
     jit->Run();
+
+    // The JIT doesn't tell us about loops, but a slice that ends inside an idle loop would have
+    // kept spinning until the next event
+    const u32 pc = jit->Regs()[15];
+    const bool thumb = (jit->Cpsr() & (1 << 5)) != 0;
+    if (skip_idle_loops && IsIdleLoop(system.Memory(), pc, thumb)) {
+        system.perf_stats.AddIdleLoopCycles(system.CoreTiming().IdleUntilNextEvent());
+    }
 }
 
 void ARM_Dynarmic::Step() {
@@ -200,6 +226,10 @@ void ARM_Dynarmic::SetReg(int index, u32 value) {
     jit->Regs()[index] = value;
 }
 
+std::array<u32, 16>& ARM_Dynarmic::GetRegisters() {
+    return jit->Regs();
+}
+
 u32 ARM_Dynarmic::GetVFPReg(int index) const {
     return jit->ExtRegs()[index];
 }
@@ -273,11 +303,20 @@ void ARM_Dynarmic::ClearInstructionCache() {
     for (const auto& j : jits) {
         j.second->ClearCache();
     }
-    interpreter_state->instruction_cache.clear();
+    interpreter_state->instruction_cache.Clear();
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
     jit->InvalidateCacheRange(start_address, length);
+    // Blocks decoded for interpreter fallbacks would otherwise run the old code
+    const std::size_t count =
+        interpreter_state->instruction_cache.InvalidateRange(start_address, length);
+    LOG_TRACE(Core_ARM11, "Invalidated {:08X}-{:08X}, {} interpreter blocks", start_address,
+              start_address + length, count);
+}
+
+void ARM_Dynarmic::SetIdleLoopSkipping(bool enabled) {
+    skip_idle_loops = enabled;
 }
 
 void ARM_Dynarmic::PageTableChanged() {
@@ -292,6 +331,7 @@ void ARM_Dynarmic::PageTableChanged() {
     auto new_jit = MakeJit();
     jit = new_jit.get();
     jits.emplace(current_page_table, std::move(new_jit));
+    jit_memory_usage.Add(DYNARMIC_CODE_CACHE_SIZE);
 }
 
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
@@ -8,6 +8,7 @@
 #include <memory>
 #include <dynarmic/A32/a32.h>
 #include "common/common_types.h"
+#include "common/memory_usage.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/skyeye_common/armstate.h"
 
@@ -33,6 +34,7 @@ public:
     u32 GetPC() const override;
     u32 GetReg(int index) const override;
     void SetReg(int index, u32 value) override;
+    std::array<u32, 16>& GetRegisters() override;
     u32 GetVFPReg(int index) const override;
     void SetVFPReg(int index, u32 value) override;
     u32 GetVFPSystemReg(VFPSystemRegister reg) const override;
@@ -52,6 +54,8 @@ public:
     void InvalidateCacheRange(u32 start_address, std::size_t length) override;
     void PageTableChanged() override;
 
+    void SetIdleLoopSkipping(bool enabled) override;
+
 private:
     friend class DynarmicUserCallbacks;
     Core::System& system;
@@ -61,5 +65,8 @@ private:
     Dynarmic::A32::Jit* jit = nullptr;
     Memory::PageTable* current_page_table = nullptr;
     std::map<Memory::PageTable*, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+    /// Accounts the code cache reserved by each of the JITs
+    Common::ScopedMemoryUsage jit_memory_usage{Common::MemoryCategory::JitCodeCache};
     std::shared_ptr<ARMul_State> interpreter_state;
+    bool skip_idle_loops = false;
 };
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include "common/logging/log.h"
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
@@ -75,7 +76,7 @@ ARM_DynCom::ARM_DynCom(Core::System& system, PrivilegeMode initial_mode) : syste
 ARM_DynCom::~ARM_DynCom() {}
 
 void ARM_DynCom::Run() {
-    ExecuteInstructions(std::max<s64>(system.CoreTiming().GetDowncount(), 0));
+    ExecuteInstructions(std::max<s64>(system.CoreTiming().GetCPUCyclesRemaining(), 0));
 }
 
 void ARM_DynCom::Step() {
@@ -83,18 +84,33 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
+    state->instruction_cache.Clear();
     trans_cache_buf_top = 0;
 }
 
-void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
-    ClearInstructionCache();
+void ARM_DynCom::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    // The translation buffer is only reclaimed by a full clear, so the blocks left behind by
+    // invalidated ranges must not fill it up
+    if (trans_cache_buf_top > TRANS_CACHE_SIZE / 2) {
+        ClearInstructionCache();
+        return;
+    }
+
+    const std::size_t count = state->instruction_cache.InvalidateRange(start_address, length);
+    LOG_TRACE(Core_ARM11, "Invalidated {} blocks in {:08X}-{:08X}", count, start_address,
+              start_address + length);
 }
 
 void ARM_DynCom::PageTableChanged() {
     ClearInstructionCache();
 }
 
+void ARM_DynCom::SetIdleLoopSkipping(bool enabled) {
+    state->skip_idle_loops = enabled;
+    // Blocks are only flagged when they are translated
+    ClearInstructionCache();
+}
+
 void ARM_DynCom::SetPC(u32 pc) {
     state->Reg[15] = pc;
 }
@@ -111,6 +127,10 @@ void ARM_DynCom::SetReg(int index, u32 value) {
     state->Reg[index] = value;
 }
 
+std::array<u32, 16>& ARM_DynCom::GetRegisters() {
+    return state->Reg;
+}
+
 u32 ARM_DynCom::GetVFPReg(int index) const {
     return state->ExtReg[index];
 }
@@ -145,8 +165,12 @@ void ARM_DynCom::SetCP15Register(CP15Register reg, u32 value) {
 
 void ARM_DynCom::ExecuteInstructions(u64 num_instructions) {
     state->NumInstrsToExecute = num_instructions;
-    unsigned ticks_executed = InterpreterMainLoop(state.get());
-    system.CoreTiming().AddTicks(ticks_executed);
+    unsigned cycles_executed = InterpreterMainLoop(state.get());
+    system.CoreTiming().AddCPUCycles(cycles_executed);
+    if (state->idle_loop_reached) {
+        state->idle_loop_reached = false;
+        system.perf_stats.AddIdleLoopCycles(system.CoreTiming().IdleUntilNextEvent());
+    }
     state->ServeBreak();
 }
 
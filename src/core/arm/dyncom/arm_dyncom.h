@@ -30,6 +30,7 @@ public:
     u32 GetPC() const override;
     u32 GetReg(int index) const override;
     void SetReg(int index, u32 value) override;
+    std::array<u32, 16>& GetRegisters() override;
     u32 GetVFPReg(int index) const override;
     void SetVFPReg(int index, u32 value) override;
     u32 GetVFPSystemReg(VFPSystemRegister reg) const override;
@@ -45,6 +46,8 @@ public:
 
     void PrepareReschedule() override;
 
+    void SetIdleLoopSkipping(bool enabled) override;
+
 private:
     void ExecuteInstructions(u64 num_instructions);
 
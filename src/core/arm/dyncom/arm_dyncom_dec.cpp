@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
 #include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/skyeye_common/armsupp.h"
 
@@ -501,3 +503,78 @@ ARMDecodeStatus DecodeARMInstruction(u32 instr, int* idx) {
     }
     return ret;
 }
+
+namespace {
+
+// Approximate issue costs on the ARM11 MPCore. Loads and stores wait on the memory system,
+// multiplies and VFP operations occupy their pipelines for more than a cycle and taken branches
+// refill the pipeline.
+constexpr std::array<u32, 5> INSTRUCTION_CLASS_CYCLES{{
+    1, // ALU
+    2, // Memory
+    2, // Multiply
+    2, // VFP
+    2, // Branch
+}};
+
+bool StartsWith(const char* name, const char* prefix) {
+    return std::strncmp(name, prefix, std::strlen(prefix)) == 0;
+}
+
+InstructionClass ClassifyInstruction(const char* name) {
+    // All VFP instructions, vldr, vstm etc. included, are grouped with the arithmetic
+    if (name[0] == 'v') {
+        return InstructionClass::VFP;
+    }
+
+    static constexpr std::array<const char*, 6> branches{{"b", "bl", "blx", "bx", "bxj", "bbl"}};
+    for (const char* branch : branches) {
+        if (std::strcmp(name, branch) == 0) {
+            return InstructionClass::Branch;
+        }
+    }
+
+    static constexpr std::array<const char*, 8> multiplies{
+        {"mul", "mla", "smu", "sml", "smm", "umu", "uml", "umaal"}};
+    for (const char* multiply : multiplies) {
+        if (StartsWith(name, multiply)) {
+            return InstructionClass::Multiply;
+        }
+    }
+
+    static constexpr std::array<const char*, 8> memory{
+        {"ldr", "str", "ldm", "stm", "swp", "srs", "rfe", "ldc"}};
+    for (const char* access : memory) {
+        if (StartsWith(name, access)) {
+            return InstructionClass::Memory;
+        }
+    }
+    if (std::strcmp(name, "stc") == 0) {
+        return InstructionClass::Memory;
+    }
+
+    return InstructionClass::ALU;
+}
+
+} // Anonymous namespace
+
+InstructionClass GetInstructionClass(int idx) {
+    constexpr int instr_slots = sizeof(arm_instruction) / sizeof(InstructionSetEncodingItem);
+    static const auto classes = [] {
+        std::array<InstructionClass, instr_slots> classes{};
+        for (int i = 0; i < instr_slots; ++i) {
+            classes[i] = ClassifyInstruction(arm_instruction[i].name);
+        }
+        return classes;
+    }();
+
+    // The Thumb-only instructions following the ARM ones are all branches
+    if (idx >= instr_slots) {
+        return InstructionClass::Branch;
+    }
+    return classes[idx];
+}
+
+u32 GetInstructionCycles(int idx) {
+    return INSTRUCTION_CLASS_CYCLES[static_cast<std::size_t>(GetInstructionClass(idx))];
+}
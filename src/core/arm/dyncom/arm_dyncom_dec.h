@@ -9,3 +9,12 @@
 enum class ARMDecodeStatus { SUCCESS, FAILURE };
 
 ARMDecodeStatus DecodeARMInstruction(u32 instr, int* idx);
+
+/// Groups of instructions that take a similar number of cycles on the ARM11
+enum class InstructionClass { ALU, Memory, Multiply, VFP, Branch };
+
+/// Gets the class of the instruction decoded to idx, including the Thumb-only instructions
+InstructionClass GetInstructionClass(int idx);
+
+/// Gets the number of cycles charged for executing the instruction decoded to idx
+u32 GetInstructionCycles(int idx);
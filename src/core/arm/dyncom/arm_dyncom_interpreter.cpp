@@ -10,6 +10,7 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/arm/idle_loop.h"
 #include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_run.h"
@@ -822,6 +823,7 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
 
         // We have translated the Thumb branch instruction in the Thumb decoder
         if (state == ThumbDecodeStatus::BRANCH) {
+            inst_base->cycles = GetInstructionCycles(static_cast<int>(inst_base->idx));
             return inst_size;
         }
         inst = arm_inst;
@@ -836,10 +838,23 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
         CITRA_IGNORE_EXIT(-1);
     }
     inst_base = arm_instruction_trans[idx](inst, idx);
+    inst_base->cycles = GetInstructionCycles(idx);
 
     return inst_size;
 }
 
+// Flags the branch that closes an idle loop, so that taking it ends the main loop
+static void MarkIdleLoop(ARM_INST_PTR branch, bool thumb) {
+    const int table_length = static_cast<int>(arm_instruction_trans_len);
+    if (!thumb) {
+        reinterpret_cast<bbl_inst*>(branch->component)->idle_loop = true;
+    } else if (static_cast<int>(branch->idx) == table_length - 5) {
+        reinterpret_cast<b_2_thumb*>(branch->component)->idle_loop = true;
+    } else if (static_cast<int>(branch->idx) == table_length - 4) {
+        reinterpret_cast<b_cond_thumb*>(branch->component)->idle_loop = true;
+    }
+}
+
 static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
@@ -868,7 +883,15 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    // The loop analysis only accepts loads and compares before the branch, which never end a
+    // block, so a block that isn't cut by a page boundary ends with the branch it found
+    if (cpu->skip_idle_loops && ret == TransExtData::DIRECT_BRANCH &&
+        size <= static_cast<int>(MAX_IDLE_LOOP_INSTRUCTIONS) &&
+        IsIdleLoop(cpu->system.Memory(), pc_start, cpu->TFlag != 0)) {
+        MarkIdleLoop(inst_base, cpu->TFlag != 0);
+    }
+
+    cpu->instruction_cache.Insert(pc_start, static_cast<u32>(bb_start));
 
     return KEEP_GOING;
 }
@@ -888,7 +911,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->instruction_cache.Insert(pc_start, static_cast<u32>(bb_start));
 
     return KEEP_GOING;
 }
@@ -969,14 +992,14 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     GDB_BP_CHECK;                                                                                  \
     if (num_instrs >= cpu->NumInstrsToExecute)                                                     \
         goto END;                                                                                  \
-    num_instrs++;                                                                                  \
+    num_instrs += inst_base->cycles;                                                               \
     goto* InstLabel[inst_base->idx]
 #else
 #define GOTO_NEXT_INST                                                                             \
     GDB_BP_CHECK;                                                                                  \
     if (num_instrs >= cpu->NumInstrsToExecute)                                                     \
         goto END;                                                                                  \
-    num_instrs++;                                                                                  \
+    num_instrs += inst_base->cycles;                                                               \
     switch (inst_base->idx) {                                                                      \
     case 0:                                                                                        \
         goto VMLA_INST;                                                                            \
@@ -1622,6 +1645,8 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int num_instrs = 0;
 
     std::size_t ptr;
+    // Branch that jumped to DISPATCH and can be linked to the block of its target
+    u32* link_block = nullptr;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1636,17 +1661,27 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    // Direct branches go straight to their target once it has been looked up
+    if (link_block != nullptr && *link_block != UNLINKED_BLOCK) {
+        ptr = *link_block;
     } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+        // Find the cached instruction cream, otherwise translate it...
+        const u32 block = cpu->instruction_cache.Find(cpu->Reg[15]);
+        if (block != InstructionCache::INVALID_BLOCK) {
+            ptr = block;
+        } else if (cpu->NumInstrsToExecute != 1) {
+            if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        } else {
+            if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        }
+
+        if (link_block != nullptr) {
+            *link_block = static_cast<u32>(ptr);
+        }
     }
+    link_block = nullptr;
 
     // Find breakpoint if one exists within the block
     if (GDBStub::IsConnected()) {
@@ -1764,6 +1799,11 @@ BBL_INST : {
         }
         SET_PC;
         INC_PC(sizeof(bbl_inst));
+        if (inst_cream->idle_loop) {
+            cpu->idle_loop_reached = true;
+            goto END;
+        }
+        link_block = &inst_cream->linked_block;
         goto DISPATCH;
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
@@ -3860,7 +3900,7 @@ SUB_INST : {
 SWI_INST : {
     if (inst_base->cond == ConditionCode::AL || CondPassed(cpu, inst_base->cond)) {
         swi_inst* const inst_cream = (swi_inst*)inst_base->component;
-        cpu->system.CoreTiming().AddTicks(num_instrs);
+        cpu->system.CoreTiming().AddCPUCycles(num_instrs);
         cpu->NumInstrsToExecute =
             num_instrs >= cpu->NumInstrsToExecute ? 0 : cpu->NumInstrsToExecute - num_instrs;
         num_instrs = 0;
@@ -4318,15 +4358,27 @@ B_2_THUMB : {
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
     cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
     INC_PC(sizeof(b_2_thumb));
+    if (inst_cream->idle_loop) {
+        cpu->idle_loop_reached = true;
+        goto END;
+    }
+    link_block = &inst_cream->linked_block;
     goto DISPATCH;
 }
 B_COND_THUMB : {
     b_cond_thumb* inst_cream = (b_cond_thumb*)inst_base->component;
 
-    if (CondPassed(cpu, inst_cream->cond))
+    if (CondPassed(cpu, inst_cream->cond)) {
         cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
-    else
+        if (inst_cream->idle_loop) {
+            cpu->idle_loop_reached = true;
+            INC_PC(sizeof(b_cond_thumb));
+            goto END;
+        }
+        link_block = &inst_cream->linked_block;
+    } else {
         cpu->Reg[15] += 2;
+    }
 
     INC_PC(sizeof(b_cond_thumb));
     goto DISPATCH;
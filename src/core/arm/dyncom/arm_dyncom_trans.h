@@ -8,6 +8,11 @@
 #include "common/common_types.h"
 
 struct ARMul_State;
+
+/// Value of the linked_block of a direct branch whose target hasn't been dispatched to yet. Once
+/// it has, the branch jumps straight to the block without looking it up again.
+constexpr u32 UNLINKED_BLOCK = 0xFFFFFFFF;
+
 typedef unsigned int (*shtop_fp_t)(ARMul_State* cpu, unsigned int sht_oper);
 
 enum class TransExtData {
@@ -26,6 +31,8 @@ struct arm_inst {
     unsigned int idx;
     unsigned int cond;
     TransExtData br;
+    // Charged to Core::Timing when the instruction is executed
+    unsigned int cycles;
     char component[0];
 };
 
@@ -88,6 +95,8 @@ struct bbl_inst {
     int signed_immed_24;
     unsigned int next_addr;
     unsigned int jmp_addr;
+    u32 linked_block;
+    bool idle_loop;
 };
 
 struct bx_inst {
@@ -451,10 +460,14 @@ struct setend_inst {
 
 struct b_2_thumb {
     unsigned int imm;
+    u32 linked_block;
+    bool idle_loop;
 };
 struct b_cond_thumb {
     unsigned int imm;
     unsigned int cond;
+    u32 linked_block;
+    bool idle_loop;
 };
 
 struct bl_1_thumb {
@@ -0,0 +1,177 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/arm/idle_loop.h"
+#include "core/memory.h"
+
+namespace {
+
+enum class InstructionKind {
+    /// Anything that may have side effects or isn't understood
+    Other,
+    /// Loads into `written` from an address computed from `address_regs`
+    Load,
+    /// Only updates the flags
+    Compare,
+    /// Direct branch to `target`
+    Branch,
+};
+
+struct DecodedInstruction {
+    InstructionKind kind = InstructionKind::Other;
+    u32 size;
+    u32 written = 0;
+    u32 address_regs = 0;
+    VAddr target = 0;
+};
+
+constexpr u32 Bit(u32 reg) {
+    return 1u << reg;
+}
+
+constexpr s32 SignExtend(u32 value, u32 bits) {
+    const u32 shift = 32 - bits;
+    return static_cast<s32>(value << shift) >> shift;
+}
+
+DecodedInstruction DecodeARM(u32 inst, VAddr addr) {
+    DecodedInstruction result;
+    result.size = 4;
+
+    const u32 cond = inst >> 28;
+    const u32 rn = (inst >> 16) & 0xF;
+    const u32 rd = (inst >> 12) & 0xF;
+    const u32 rm = inst & 0xF;
+    const bool load = (inst >> 20) & 1;
+    const bool pre_indexed = (inst >> 24) & 1;
+    const bool writeback = (inst >> 21) & 1;
+    if (cond == 0xF) {
+        return result;
+    }
+
+    if ((inst & 0x0F000000) == 0x0A000000) {
+        // B
+        result.kind = InstructionKind::Branch;
+        result.target = addr + 8 + (SignExtend(inst & 0xFFFFFF, 24) << 2);
+    } else if ((inst & 0x0C000000) == 0x04000000) {
+        // LDR/LDRB, register offsets with bit 4 set are media instructions
+        const bool register_offset = (inst >> 25) & 1;
+        if (load && pre_indexed && !writeback && rd != 15 && !(register_offset && (inst & 0x10))) {
+            result.kind = InstructionKind::Load;
+            result.written = Bit(rd);
+            result.address_regs = Bit(rn) | (register_offset ? Bit(rm) : 0);
+        }
+    } else if ((inst & 0x0E000090) == 0x00000090 && (inst & 0x60) != 0) {
+        // LDRH/LDRSH/LDRSB
+        const bool immediate_offset = (inst >> 22) & 1;
+        if (load && pre_indexed && !writeback && rd != 15) {
+            result.kind = InstructionKind::Load;
+            result.written = Bit(rd);
+            result.address_regs = Bit(rn) | (immediate_offset ? 0 : Bit(rm));
+        }
+    } else if ((inst & 0x0C000000) == 0) {
+        // TST/TEQ/CMP/CMN, register forms with bits 7 and 4 set are extension instructions
+        const u32 opcode = (inst >> 21) & 0xF;
+        const bool immediate = (inst >> 25) & 1;
+        if (load && opcode >= 8 && opcode <= 11 && (immediate || (inst & 0x90) != 0x90)) {
+            result.kind = InstructionKind::Compare;
+        }
+    }
+    return result;
+}
+
+DecodedInstruction DecodeThumb(u16 inst, VAddr addr) {
+    DecodedInstruction result;
+    result.size = 2;
+
+    const u32 low_rd = inst & 7;
+    const u32 low_rn = (inst >> 3) & 7;
+
+    if ((inst & 0xF000) == 0xD000 && ((inst >> 8) & 0xF) < 0xE) {
+        // B<cond>
+        result.kind = InstructionKind::Branch;
+        result.target = addr + 4 + (SignExtend(inst & 0xFF, 8) << 1);
+    } else if ((inst & 0xF800) == 0xE000) {
+        // B
+        result.kind = InstructionKind::Branch;
+        result.target = addr + 4 + (SignExtend(inst & 0x7FF, 11) << 1);
+    } else if ((inst & 0xF800) == 0x6800 || (inst & 0xF800) == 0x7800 ||
+               (inst & 0xF800) == 0x8800) {
+        // LDR/LDRB/LDRH with an immediate offset
+        result.kind = InstructionKind::Load;
+        result.written = Bit(low_rd);
+        result.address_regs = Bit(low_rn);
+    } else if ((inst & 0xF000) == 0x5000 && ((inst >> 9) & 7) >= 3) {
+        // LDRSB/LDR/LDRH/LDRB/LDRSH with a register offset
+        result.kind = InstructionKind::Load;
+        result.written = Bit(low_rd);
+        result.address_regs = Bit(low_rn) | Bit((inst >> 6) & 7);
+    } else if ((inst & 0xF800) == 0x4800 || (inst & 0xF800) == 0x9800) {
+        // LDR relative to PC or SP
+        result.kind = InstructionKind::Load;
+        result.written = Bit((inst >> 8) & 7);
+        result.address_regs = (inst & 0x8000) ? Bit(13) : Bit(15);
+    } else if ((inst & 0xF800) == 0x2800) {
+        // CMP with an immediate
+        result.kind = InstructionKind::Compare;
+    } else if ((inst & 0xFC00) == 0x4000) {
+        // TST/CMP/CMN between low registers
+        const u32 opcode = (inst >> 6) & 0xF;
+        if (opcode == 8 || opcode == 10 || opcode == 11) {
+            result.kind = InstructionKind::Compare;
+        }
+    } else if ((inst & 0xFF00) == 0x4500) {
+        // CMP with high registers
+        result.kind = InstructionKind::Compare;
+    }
+    return result;
+}
+
+DecodedInstruction Decode(Memory::MemorySystem& memory, VAddr addr, bool thumb) {
+    if (thumb) {
+        return DecodeThumb(memory.Read16(addr), addr);
+    }
+    return DecodeARM(memory.Read32(addr), addr);
+}
+
+} // Anonymous namespace
+
+bool IsIdleLoop(Memory::MemorySystem& memory, VAddr addr, bool thumb) {
+    // Find the branch that closes the loop
+    VAddr branch_addr = addr;
+    DecodedInstruction branch;
+    for (u32 i = 0;; ++i) {
+        if (i == MAX_IDLE_LOOP_INSTRUCTIONS) {
+            return false;
+        }
+        branch = Decode(memory, branch_addr, thumb);
+        if (branch.kind == InstructionKind::Other) {
+            return false;
+        }
+        if (branch.kind == InstructionKind::Branch) {
+            break;
+        }
+        branch_addr += branch.size;
+    }
+
+    if (branch.target > addr || branch_addr - branch.target >= MAX_IDLE_LOOP_INSTRUCTIONS * 4) {
+        return false;
+    }
+
+    // Then check the whole body, which may begin before addr
+    u32 written = 0;
+    u32 address_regs = 0;
+    for (VAddr pc = branch.target; pc != branch_addr;) {
+        const DecodedInstruction inst = Decode(memory, pc, thumb);
+        if (inst.kind != InstructionKind::Load && inst.kind != InstructionKind::Compare) {
+            return false;
+        }
+        written |= inst.written;
+        address_regs |= inst.address_regs;
+        pc += inst.size;
+    }
+
+    // Loads whose address depends on an earlier load, like walking a linked list, make progress
+    return (written & address_regs) == 0;
+}
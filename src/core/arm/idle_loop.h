@@ -0,0 +1,28 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+/// Longest loop, in instructions including the branch, that is considered for idle loop skipping
+constexpr u32 MAX_IDLE_LOOP_INSTRUCTIONS = 8;
+
+/**
+ * Checks whether the instruction at addr is part of a short loop that only polls memory, such as
+ * LDR/CMP/BNE waiting on a shared memory flag. Nothing but a Core::Timing event can end such a
+ * loop, so the CPU can skip straight to the next event once it is spinning in one.
+ *
+ * A loop qualifies if it ends with a direct branch back to or before addr and the other
+ * instructions are loads without writeback or comparisons, where no loaded register is used to
+ * compute an address. Every iteration then does exactly the same thing until memory changes.
+ * @param memory memory of the current process to read the code from
+ * @param addr address of any instruction of the loop
+ * @param thumb whether the code is Thumb code
+ */
+bool IsIdleLoop(Memory::MemorySystem& memory, VAddr addr, bool thumb);
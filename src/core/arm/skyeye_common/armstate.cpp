@@ -10,6 +10,48 @@
 #include "core/core.h"
 #include "core/memory.h"
 
+void InstructionCache::Insert(u32 address, u32 block) {
+    if (pages.empty()) {
+        // Allocated on first use, most ARMul_States never translate anything
+        pages.resize(std::size_t{1} << (32 - PAGE_BITS));
+    }
+
+    const u32 page_index = address >> PAGE_BITS;
+    auto& page = pages[page_index];
+    if (!page) {
+        page = std::make_unique<Page>();
+        page->fill(INVALID_BLOCK);
+        used_pages.push_back(page_index);
+    }
+    (*page)[(address & PAGE_MASK) >> 1] = block;
+}
+
+void InstructionCache::Clear() {
+    for (const u32 page_index : used_pages) {
+        pages[page_index]->fill(INVALID_BLOCK);
+    }
+}
+
+std::size_t InstructionCache::InvalidateRange(u32 start_address, std::size_t length) {
+    if (pages.empty() || length == 0) {
+        return 0;
+    }
+
+    const u64 end_address = std::min<u64>(u64{start_address} + length, u64{1} << 32);
+    const u64 last_page = (end_address - 1) >> PAGE_BITS;
+    std::size_t count = 0;
+    for (u64 page_index = start_address >> PAGE_BITS; page_index <= last_page; ++page_index) {
+        auto& page = pages[page_index];
+        if (!page) {
+            continue;
+        }
+        count += static_cast<std::size_t>(std::count_if(
+            page->begin(), page->end(), [](u32 block) { return block != INVALID_BLOCK; }));
+        page->fill(INVALID_BLOCK);
+    }
+    return count;
+}
+
 ARMul_State::ARMul_State(Core::System& system, PrivilegeMode initial_mode) : system(system) {
     Reset();
     ChangePrivilegeMode(initial_mode);
@@ -18,7 +18,8 @@
 #pragma once
 
 #include <array>
-#include <unordered_map>
+#include <memory>
+#include <vector>
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/gdbstub/gdbstub.h"
@@ -27,6 +28,47 @@ namespace Core {
 class System;
 }
 
+/**
+ * Offsets in the translation buffer of the blocks decoded by the dyncom interpreter, indexed by
+ * their start address. The lookup goes through a flat table of 4KiB guest pages, the tables of
+ * the pages are only allocated once a block is translated there.
+ */
+class InstructionCache {
+public:
+    static constexpr u32 INVALID_BLOCK = 0xFFFFFFFF;
+
+    u32 Find(u32 address) const {
+        if (pages.empty()) {
+            return INVALID_BLOCK;
+        }
+        const auto& page = pages[address >> PAGE_BITS];
+        return page ? (*page)[(address & PAGE_MASK) >> 1] : INVALID_BLOCK;
+    }
+
+    void Insert(u32 address, u32 block);
+
+    /// Forgets all the blocks, the page tables are kept for reuse
+    void Clear();
+
+    /**
+     * Forgets the blocks of the pages overlapping a range. Blocks end at page boundaries, so no
+     * other block can hold code from the range.
+     * @returns the number of blocks forgotten
+     */
+    std::size_t InvalidateRange(u32 start_address, std::size_t length);
+
+private:
+    static constexpr u32 PAGE_BITS = 12;
+    static constexpr u32 PAGE_MASK = (1 << PAGE_BITS) - 1;
+
+    /// One entry per halfword, blocks start at any Thumb instruction
+    using Page = std::array<u32, (1 << PAGE_BITS) / 2>;
+
+    std::vector<std::unique_ptr<Page>> pages;
+    /// Indices of the allocated pages, so that Clear doesn't walk the whole table
+    std::vector<u32> used_pages;
+};
+
 // Signal levels
 enum { LOW = 0, HIGH = 1, LOWHIGH = 1, HIGHLOW = 2 };
 
@@ -248,7 +290,12 @@ public:
 
     // TODO(bunnei): Move this cache to a better place - it should be per codeset (likely per
     // process for our purposes), not per ARMul_State (which tracks CPU core state).
-    std::unordered_map<u32, std::size_t> instruction_cache;
+    InstructionCache instruction_cache;
+
+    // Whether translated blocks may be flagged as idle loops, and whether the main loop stopped
+    // because it reached one
+    bool skip_idle_loops = false;
+    bool idle_loop_reached = false;
 
 private:
     void ResetMPCoreCP15Registers();
@@ -52,6 +52,9 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "common/logging/log.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -1004,6 +1007,46 @@ static u32 vfp_double_fnmul(ARMul_State* state, int dd, int dn, int dm, u32 fpsc
     return vfp_double_normaliseround(state, dd, &vdd, fpscr, exceptions, "fnmul");
 }
 
+/*
+ * Fast path of fadd and fsub. When both operands are normal or zero, the host sum is correctly
+ * rounded to nearest and its exact error gives the rounding towards zero. Other rounding modes,
+ * overflows and results too small to be normal are left to the emulated arithmetic, which also
+ * raises the flags of those cases.
+ */
+static bool vfp_double_fast_add(ARMul_State* state, int dd, u64 n, u64 m, u32 fpscr,
+                                u32* exceptions) {
+    const u32 rmode = fpscr & FPSCR_RMODE_MASK;
+    if (rmode != FPSCR_ROUND_NEAREST && rmode != FPSCR_ROUND_TOZERO)
+        return false;
+
+    const auto is_normal_or_zero = [](u64 value) {
+        const u64 exponent = (value >> 52) & 0x7FF;
+        return exponent != 0x7FF && (exponent != 0 || (value << 1) == 0);
+    };
+    if (!is_normal_or_zero(n) || !is_normal_or_zero(m))
+        return false;
+
+    double a;
+    double b;
+    std::memcpy(&a, &n, sizeof(a));
+    std::memcpy(&b, &m, sizeof(b));
+    double sum = a + b;
+    if (std::isinf(sum) || (sum != 0.0 && std::fabs(sum) <= std::numeric_limits<double>::min()))
+        return false;
+
+    // The error of the sum, exact as it doesn't overflow (TwoSum)
+    const double b_virtual = sum - a;
+    const double error = (a - (sum - b_virtual)) + (b - b_virtual);
+    if (error != 0.0 && rmode == FPSCR_ROUND_TOZERO && (error < 0.0) != (sum < 0.0))
+        sum = std::nextafter(sum, 0.0);
+
+    u64 d;
+    std::memcpy(&d, &sum, sizeof(d));
+    vfp_put_double(state, d, dd);
+    *exceptions = error != 0.0 ? FPSCR_IXC : 0;
+    return true;
+}
+
 /*
  * sd = sn + sm
  */
@@ -1012,6 +1055,11 @@ static u32 vfp_double_fadd(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     u32 exceptions = 0;
 
     LOG_TRACE(Core_ARM11, "In {}", __FUNCTION__);
+    if (vfp_double_fast_add(state, dd, vfp_get_double(state, dn), vfp_get_double(state, dm),
+                            fpscr, &exceptions)) {
+        return exceptions;
+    }
+
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
         vfp_double_normalise_denormal(&vdn);
@@ -1033,6 +1081,11 @@ static u32 vfp_double_fsub(ARMul_State* state, int dd, int dn, int dm, u32 fpscr
     u32 exceptions = 0;
 
     LOG_TRACE(Core_ARM11, "In {}", __FUNCTION__);
+    if (vfp_double_fast_add(state, dd, vfp_get_double(state, dn),
+                            vfp_get_double(state, dm) ^ (u64{1} << 63), fpscr, &exceptions)) {
+        return exceptions;
+    }
+
     exceptions |= vfp_double_unpack(&vdn, vfp_get_double(state, dn), fpscr);
     if (vdn.exponent == 0 && vdn.significand)
         vfp_double_normalise_denormal(&vdn);
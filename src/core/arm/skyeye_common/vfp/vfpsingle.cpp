@@ -52,6 +52,9 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -986,6 +989,78 @@ static u32 vfp_single_fnmsc(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr
                                           "fnmsc");
 }
 
+/*
+ * Fast paths of fadd, fsub, fmul and fnmul. When both operands are normal or zero, the host
+ * computes the exact result in double precision, which then only needs rounding to single
+ * precision. Rounding towards an infinity, results that aren't exact in double precision and
+ * results that overflow or are too small to be normal are left to the emulated arithmetic, which
+ * also raises the flags of those cases.
+ */
+static bool vfp_single_fast_operands(s32 n, s32 m, u32 fpscr) {
+    const u32 rmode = fpscr & FPSCR_RMODE_MASK;
+    if (rmode != FPSCR_ROUND_NEAREST && rmode != FPSCR_ROUND_TOZERO)
+        return false;
+
+    const auto is_normal_or_zero = [](s32 value) {
+        const u32 exponent = (static_cast<u32>(value) >> 23) & 0xFF;
+        return exponent != 0xFF && (exponent != 0 || (value & 0x7FFFFFFF) == 0);
+    };
+    return is_normal_or_zero(n) && is_normal_or_zero(m);
+}
+
+static double vfp_single_to_host(s32 value) {
+    float result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+static bool vfp_single_fast_round(ARMul_State* state, int sd, double exact, u32 fpscr,
+                                  u32* exceptions) {
+    if (exact != 0.0 && std::fabs(exact) < std::numeric_limits<float>::min())
+        return false;
+
+    float result = static_cast<float>(exact);
+    if (std::isinf(result))
+        return false;
+
+    const bool inexact = static_cast<double>(result) != exact;
+    if (inexact && (fpscr & FPSCR_RMODE_MASK) == FPSCR_ROUND_TOZERO &&
+        std::fabs(result) > std::fabs(exact)) {
+        result = std::nextafter(result, 0.0f);
+    }
+
+    s32 d;
+    std::memcpy(&d, &result, sizeof(d));
+    vfp_put_float(state, d, sd);
+    *exceptions = inexact ? FPSCR_IXC : 0;
+    return true;
+}
+
+static bool vfp_single_fast_multiply(ARMul_State* state, int sd, s32 n, s32 m, u32 fpscr,
+                                     bool negate, u32* exceptions) {
+    if (!vfp_single_fast_operands(n, m, fpscr))
+        return false;
+
+    // 24 bit significands, so the product is exact in double precision
+    const double product = vfp_single_to_host(n) * vfp_single_to_host(m);
+    return vfp_single_fast_round(state, sd, negate ? -product : product, fpscr, exceptions);
+}
+
+static bool vfp_single_fast_add(ARMul_State* state, int sd, s32 n, s32 m, u32 fpscr,
+                                u32* exceptions) {
+    if (!vfp_single_fast_operands(n, m, fpscr))
+        return false;
+
+    // The error of the double precision sum, exact as long as it doesn't overflow (TwoSum)
+    const double a = vfp_single_to_host(n);
+    const double b = vfp_single_to_host(m);
+    const double sum = a + b;
+    const double b_virtual = sum - a;
+    if ((a - (sum - b_virtual)) + (b - b_virtual) != 0.0)
+        return false;
+    return vfp_single_fast_round(state, sd, sum, fpscr, exceptions);
+}
+
 /*
  * sd = sn * sm
  */
@@ -996,6 +1071,9 @@ static u32 vfp_single_fmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_fast_multiply(state, sd, n, m, fpscr, false, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
     if (vsn.exponent == 0 && vsn.significand)
         vfp_single_normalise_denormal(&vsn);
@@ -1018,6 +1096,9 @@ static u32 vfp_single_fnmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_fast_multiply(state, sd, n, m, fpscr, true, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
     if (vsn.exponent == 0 && vsn.significand)
         vfp_single_normalise_denormal(&vsn);
@@ -1041,6 +1122,9 @@ static u32 vfp_single_fadd(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_fast_add(state, sd, n, m, fpscr, &exceptions))
+        return exceptions;
+
     /*
      * Unpack and normalise denormals.
      */
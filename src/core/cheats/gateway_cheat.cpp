@@ -3,7 +3,6 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <cmath>
 #include <fstream>
 #include <functional>
 #include <string>
@@ -23,42 +22,58 @@ struct State {
     u32 offset = 0;
     u32 if_flag = 0;
     u32 loop_count = 0;
-    std::size_t loop_back_line = 0;
-    std::size_t current_line_nr = 0;
+    std::size_t loop_back_op = 0;
+    std::size_t current_op = 0;
     bool loop_flag = false;
 };
 
-template <typename T, typename WriteFunction>
-static inline std::enable_if_t<std::is_integral_v<T>> WriteOp(const GatewayCheat::CheatLine& line,
+/**
+ * Writes a value unless memory already holds it. Most cheats keep writing the same values every
+ * time they run, and invalidating the JIT cache for each of those writes costs far more than the
+ * read.
+ * @returns whether memory was written
+ */
+template <typename T, typename ReadFunction, typename WriteFunction>
+static inline bool WriteIfChanged(VAddr addr, T value, ReadFunction read_func,
+                                  WriteFunction write_func) {
+    if (static_cast<T>(read_func(addr)) == value)
+        return false;
+    write_func(addr, value);
+    return true;
+}
+
+template <typename T, typename ReadFunction, typename WriteFunction>
+static inline std::enable_if_t<std::is_integral_v<T>> WriteOp(const GatewayCheat::Op& op,
                                                               const State& state,
+                                                              ReadFunction read_func,
                                                               WriteFunction write_func,
                                                               Core::System& system) {
-    u32 addr = line.address + state.offset;
-    write_func(addr, static_cast<T>(line.value));
-    system.CPU().InvalidateCacheRange(addr, sizeof(T));
+    u32 addr = op.address + state.offset;
+    if (WriteIfChanged<T>(addr, static_cast<T>(op.value), read_func, write_func))
+        system.CPU().InvalidateCacheRange(addr, sizeof(T));
 }
 
 template <typename T, typename ReadFunction, typename CompareFunc>
-static inline std::enable_if_t<std::is_integral_v<T>> CompOp(const GatewayCheat::CheatLine& line,
+static inline std::enable_if_t<std::is_integral_v<T>> CompOp(const GatewayCheat::Op& op,
                                                              State& state, ReadFunction read_func,
                                                              CompareFunc comp) {
-    u32 addr = line.address + state.offset;
+    u32 addr = op.address + state.offset;
     T val = read_func(addr);
     if (!comp(val)) {
         state.if_flag++;
     }
 }
 
-static inline void LoadOffsetOp(Memory::MemorySystem& memory, const GatewayCheat::CheatLine& line,
+static inline void LoadOffsetOp(Memory::MemorySystem& memory, const GatewayCheat::Op& op,
                                 State& state) {
-    u32 addr = line.address + state.offset;
+    u32 addr = op.address + state.offset;
     state.offset = memory.Read32(addr);
 }
 
-static inline void LoopOp(const GatewayCheat::CheatLine& line, State& state) {
-    state.loop_flag = state.loop_count < line.value;
+static inline void LoopOp(const GatewayCheat::Op& op, State& state) {
+    state.loop_flag = state.loop_count < op.value;
     state.loop_count++;
-    state.loop_back_line = state.current_line_nr;
+    state.loop_back_op = state.current_op;
 }
 
 static inline void TerminateOp(State& state) {
@@ -69,7 +84,7 @@ static inline void TerminateOp(State& state) {
 
 static inline void LoopExecuteVariantOp(State& state) {
     if (state.loop_flag) {
-        state.current_line_nr = state.loop_back_line - 1;
+        state.current_op = state.loop_back_op - 1;
     } else {
         state.loop_count = 0;
     }
@@ -77,7 +92,7 @@ static inline void LoopExecuteVariantOp(State& state) {
 
 static inline void FullTerminateOp(State& state) {
     if (state.loop_flag) {
-        state.current_line_nr = state.loop_back_line - 1;
+        state.current_op = state.loop_back_op - 1;
     } else {
         state.offset = 0;
         state.reg = 0;
@@ -87,86 +102,70 @@ static inline void FullTerminateOp(State& state) {
     }
 }
 
-static inline void SetOffsetOp(const GatewayCheat::CheatLine& line, State& state) {
-    state.offset = line.value;
+static inline void SetOffsetOp(const GatewayCheat::Op& op, State& state) {
+    state.offset = op.value;
 }
 
-static inline void AddValueOp(const GatewayCheat::CheatLine& line, State& state) {
-    state.reg += line.value;
+static inline void AddValueOp(const GatewayCheat::Op& op, State& state) {
+    state.reg += op.value;
 }
 
-static inline void SetValueOp(const GatewayCheat::CheatLine& line, State& state) {
-    state.reg = line.value;
+static inline void SetValueOp(const GatewayCheat::Op& op, State& state) {
+    state.reg = op.value;
 }
 
-template <typename T, typename WriteFunction>
+template <typename T, typename ReadFunction, typename WriteFunction>
 static inline std::enable_if_t<std::is_integral_v<T>> IncrementiveWriteOp(
-    const GatewayCheat::CheatLine& line, State& state, WriteFunction write_func,
+    const GatewayCheat::Op& op, State& state, ReadFunction read_func, WriteFunction write_func,
     Core::System& system) {
-    u32 addr = line.value + state.offset;
-    write_func(addr, static_cast<T>(state.reg));
-    system.CPU().InvalidateCacheRange(addr, sizeof(T));
+    u32 addr = op.value + state.offset;
+    if (WriteIfChanged<T>(addr, static_cast<T>(state.reg), read_func, write_func))
+        system.CPU().InvalidateCacheRange(addr, sizeof(T));
     state.offset += sizeof(T);
 }
 
 template <typename T, typename ReadFunction>
-static inline std::enable_if_t<std::is_integral_v<T>> LoadOp(const GatewayCheat::CheatLine& line,
+static inline std::enable_if_t<std::is_integral_v<T>> LoadOp(const GatewayCheat::Op& op,
                                                              State& state, ReadFunction read_func) {
 
-    u32 addr = line.value + state.offset;
+    u32 addr = op.value + state.offset;
     state.reg = read_func(addr);
 }
 
-static inline void AddOffsetOp(const GatewayCheat::CheatLine& line, State& state) {
-    state.offset += line.value;
+static inline void AddOffsetOp(const GatewayCheat::Op& op, State& state) {
+    state.offset += op.value;
 }
 
-static inline void JokerOp(const GatewayCheat::CheatLine& line, State& state,
-                           const Core::System& system) {
+static inline void JokerOp(const GatewayCheat::Op& op, State& state, const Core::System& system) {
     u32 pad_state = system.ServiceManager()
                         .GetService<Service::HID::Module::Interface>("hid:USER")
                         ->GetModule()
                         ->GetState()
                         .hex;
-    bool pressed = (pad_state & line.value) == line.value;
+    bool pressed = (pad_state & op.value) == op.value;
     if (!pressed) {
         state.if_flag++;
     }
 }
 
-static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Core::System& system,
-                           const std::vector<GatewayCheat::CheatLine>& cheat_lines) {
-    if (state.if_flag > 0) {
-        // Skip over the additional patch lines
-        state.current_line_nr += static_cast<int>(std::ceil(line.value / 8.0));
-        return;
+template <typename Read8Function, typename Read32Function, typename Write8Function,
+          typename Write32Function>
+static inline void PatchOp(const GatewayCheat::Op& op, const State& state, Core::System& system,
+                           const std::vector<u32>& patch_words, Read8Function read8,
+                           Read32Function read32, Write8Function write8, Write32Function write32) {
+    u32 num_bytes = op.value;
+    u32 addr = op.address + state.offset;
+    const u32* word = patch_words.data() + op.data;
+    bool changed = false;
+    for (; num_bytes >= 4; num_bytes -= 4, addr += 4) {
+        changed |= WriteIfChanged<u32>(addr, *word++, read32, write32);
     }
-    u32 num_bytes = line.value;
-    u32 addr = line.address + state.offset;
-    system.CPU().InvalidateCacheRange(addr, num_bytes);
-    bool first = true;
-    u32 bit_offset = 0;
-    if (num_bytes > 0)
-        state.current_line_nr++; // skip over the current code
-    while (num_bytes >= 4) {
-        u32 tmp = first ? cheat_lines[state.current_line_nr].first
-                        : cheat_lines[state.current_line_nr].value;
-        if (!first && num_bytes > 4) {
-            state.current_line_nr++;
-        }
-        first = !first;
-        system.Memory().Write32(addr, tmp);
-        addr += 4;
-        num_bytes -= 4;
+    // The remaining bytes come from the next word, lowest byte first
+    for (u32 bit_offset = 0; num_bytes > 0; num_bytes--, addr++, bit_offset += 8) {
+        changed |= WriteIfChanged<u8>(addr, static_cast<u8>(*word >> bit_offset), read8, write8);
     }
-    while (num_bytes > 0) {
-        u32 tmp = (first ? cheat_lines[state.current_line_nr].first
-                         : cheat_lines[state.current_line_nr].value) >>
-                  bit_offset;
-        system.Memory().Write8(addr, tmp);
-        addr += 1;
-        num_bytes -= 1;
-        bit_offset += 8;
+    if (changed) {
+        system.CPU().InvalidateCacheRange(op.address + state.offset, op.value);
     }
 }
 
@@ -199,10 +198,36 @@ GatewayCheat::CheatLine::CheatLine(const std::string& line) {
 GatewayCheat::GatewayCheat(std::string name_, std::vector<CheatLine> cheat_lines_,
                            std::string comments_)
     : name(std::move(name_)), cheat_lines(std::move(cheat_lines_)), comments(std::move(comments_)) {
+    Compile();
 }
 
 GatewayCheat::~GatewayCheat() = default;
 
+void GatewayCheat::Compile() {
+    for (std::size_t line_nr = 0; line_nr < cheat_lines.size(); ++line_nr) {
+        const CheatLine& line = cheat_lines[line_nr];
+        Op& op = ops.emplace_back();
+        op.type = line.type;
+        op.address = line.address;
+        op.value = line.value;
+        op.data = 0;
+        if (line.type != CheatType::Patch)
+            continue;
+
+        // EXXXXXXX YYYYYYYY is followed by ceil(YYYYYYYY / 8) lines of data, a patch running
+        // past the end of the cheat is cut short
+        const std::size_t data_lines = std::min<std::size_t>(
+            (static_cast<u64>(line.value) + 7) / 8, cheat_lines.size() - line_nr - 1);
+        op.value = std::min<u32>(line.value, static_cast<u32>(data_lines * 8));
+        op.data = static_cast<u32>(patch_words.size());
+        for (std::size_t i = 0; i < data_lines; ++i) {
+            patch_words.push_back(cheat_lines[line_nr + 1 + i].first);
+            patch_words.push_back(cheat_lines[line_nr + 1 + i].value);
+        }
+        line_nr += data_lines;
+    }
+}
+
 void GatewayCheat::Execute(Core::System& system) {
     State state;
 
@@ -214,11 +239,10 @@ void GatewayCheat::Execute(Core::System& system) {
     auto Write16 = [&memory](VAddr addr, u16 value) { memory.Write16(addr, value); };
     auto Write32 = [&memory](VAddr addr, u32 value) { memory.Write32(addr, value); };
 
-    for (state.current_line_nr = 0; state.current_line_nr < cheat_lines.size();
-         state.current_line_nr++) {
-        auto line = cheat_lines[state.current_line_nr];
+    for (state.current_op = 0; state.current_op < ops.size(); state.current_op++) {
+        const Op& op = ops[state.current_op];
         if (state.if_flag > 0) {
-            switch (line.type) {
+            switch (op.type) {
             case CheatType::GreaterThan32:
             case CheatType::LessThan32:
             case CheatType::EqualTo32:
@@ -231,12 +255,6 @@ void GatewayCheat::Execute(Core::System& system) {
                 // Increment the if_flag to handle the end if correctly
                 state.if_flag++;
                 break;
-            case CheatType::Patch:
-                // EXXXXXXX YYYYYYYY
-                // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
-                // We need to call this here to skip the additional patch lines
-                PatchOp(line, state, system, cheat_lines);
-                break;
             case CheatType::Terminator:
                 // D0000000 00000000 - ENDIF
                 TerminateOp(state);
@@ -251,71 +269,71 @@ void GatewayCheat::Execute(Core::System& system) {
             // Do not execute any other op code
             continue;
         }
-        switch (line.type) {
+        switch (op.type) {
         case CheatType::Null:
             break;
         case CheatType::Write32:
             // 0XXXXXXX YYYYYYYY - word[XXXXXXX+offset] = YYYYYYYY
-            WriteOp<u32>(line, state, Write32, system);
+            WriteOp<u32>(op, state, Read32, Write32, system);
             break;
         case CheatType::Write16:
             // 1XXXXXXX 0000YYYY - half[XXXXXXX+offset] = YYYY
-            WriteOp<u16>(line, state, Write16, system);
+            WriteOp<u16>(op, state, Read16, Write16, system);
             break;
         case CheatType::Write8:
             // 2XXXXXXX 000000YY - byte[XXXXXXX+offset] = YY
-            WriteOp<u8>(line, state, Write8, system);
+            WriteOp<u8>(op, state, Read8, Write8, system);
             break;
         case CheatType::GreaterThan32:
             // 3XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY > word[XXXXXXX]   ;unsigned
-            CompOp<u32>(line, state, Read32, [&line](u32 val) -> bool { return line.value > val; });
+            CompOp<u32>(op, state, Read32, [&op](u32 val) -> bool { return op.value > val; });
             break;
         case CheatType::LessThan32:
             // 4XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY < word[XXXXXXX]   ;unsigned
-            CompOp<u32>(line, state, Read32, [&line](u32 val) -> bool { return line.value < val; });
+            CompOp<u32>(op, state, Read32, [&op](u32 val) -> bool { return op.value < val; });
             break;
         case CheatType::EqualTo32:
             // 5XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY == word[XXXXXXX]   ;unsigned
-            CompOp<u32>(line, state, Read32,
-                        [&line](u32 val) -> bool { return line.value == val; });
+            CompOp<u32>(op, state, Read32,
+                        [&op](u32 val) -> bool { return op.value == val; });
             break;
         case CheatType::NotEqualTo32:
             // 6XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY != word[XXXXXXX]   ;unsigned
-            CompOp<u32>(line, state, Read32,
-                        [&line](u32 val) -> bool { return line.value != val; });
+            CompOp<u32>(op, state, Read32,
+                        [&op](u32 val) -> bool { return op.value != val; });
             break;
         case CheatType::GreaterThan16WithMask:
             // 7XXXXXXX ZZZZYYYY - Execute next block IF YYYY > ((not ZZZZ) AND half[XXXXXXX])
-            CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) > (static_cast<u16>(~line.value >> 16) & val);
+            CompOp<u16>(op, state, Read16, [&op](u16 val) -> bool {
+                return static_cast<u16>(op.value) > (static_cast<u16>(~op.value >> 16) & val);
             });
             break;
         case CheatType::LessThan16WithMask:
             // 8XXXXXXX ZZZZYYYY - Execute next block IF YYYY < ((not ZZZZ) AND half[XXXXXXX])
-            CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) < (static_cast<u16>(~line.value >> 16) & val);
+            CompOp<u16>(op, state, Read16, [&op](u16 val) -> bool {
+                return static_cast<u16>(op.value) < (static_cast<u16>(~op.value >> 16) & val);
             });
             break;
         case CheatType::EqualTo16WithMask:
             // 9XXXXXXX ZZZZYYYY - Execute next block IF YYYY = ((not ZZZZ) AND half[XXXXXXX])
-            CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) == (static_cast<u16>(~line.value >> 16) & val);
+            CompOp<u16>(op, state, Read16, [&op](u16 val) -> bool {
+                return static_cast<u16>(op.value) == (static_cast<u16>(~op.value >> 16) & val);
             });
             break;
         case CheatType::NotEqualTo16WithMask:
             // AXXXXXXX ZZZZYYYY - Execute next block IF YYYY <> ((not ZZZZ) AND half[XXXXXXX])
-            CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) != (static_cast<u16>(~line.value >> 16) & val);
+            CompOp<u16>(op, state, Read16, [&op](u16 val) -> bool {
+                return static_cast<u16>(op.value) != (static_cast<u16>(~op.value >> 16) & val);
             });
             break;
         case CheatType::LoadOffset:
             // BXXXXXXX 00000000 - offset = word[XXXXXXX+offset]
-            LoadOffsetOp(system.Memory(), line, state);
+            LoadOffsetOp(system.Memory(), op, state);
             break;
         case CheatType::Loop: {
             // C0000000 YYYYYYYY - LOOP next block YYYYYYYY times
             // TODO(B3N30): Support nested loops if necessary
-            LoopOp(line, state);
+            LoopOp(op, state);
             break;
         }
         case CheatType::Terminator: {
@@ -335,63 +353,63 @@ void GatewayCheat::Execute(Core::System& system) {
         }
         case CheatType::SetOffset: {
             // D3000000 XXXXXXXX – Sets the offset to XXXXXXXX
-            SetOffsetOp(line, state);
+            SetOffsetOp(op, state);
             break;
         }
         case CheatType::AddValue: {
             // D4000000 XXXXXXXX – reg += XXXXXXXX
-            AddValueOp(line, state);
+            AddValueOp(op, state);
             break;
         }
         case CheatType::SetValue: {
             // D5000000 XXXXXXXX – reg = XXXXXXXX
-            SetValueOp(line, state);
+            SetValueOp(op, state);
             break;
         }
         case CheatType::IncrementiveWrite32: {
             // D6000000 XXXXXXXX – (32bit) [XXXXXXXX+offset] = reg ; offset += 4
-            IncrementiveWriteOp<u32>(line, state, Write32, system);
+            IncrementiveWriteOp<u32>(op, state, Read32, Write32, system);
             break;
         }
         case CheatType::IncrementiveWrite16: {
             // D7000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xffff ; offset += 2
-            IncrementiveWriteOp<u16>(line, state, Write16, system);
+            IncrementiveWriteOp<u16>(op, state, Read16, Write16, system);
             break;
         }
         case CheatType::IncrementiveWrite8: {
             // D8000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xff ; offset++
-            IncrementiveWriteOp<u8>(line, state, Write8, system);
+            IncrementiveWriteOp<u8>(op, state, Read8, Write8, system);
             break;
         }
         case CheatType::Load32: {
             // D9000000 XXXXXXXX – reg = [XXXXXXXX+offset]
-            LoadOp<u32>(line, state, Read32);
+            LoadOp<u32>(op, state, Read32);
             break;
         }
         case CheatType::Load16: {
             // DA000000 XXXXXXXX – reg = [XXXXXXXX+offset] & 0xFFFF
-            LoadOp<u16>(line, state, Read16);
+            LoadOp<u16>(op, state, Read16);
             break;
         }
         case CheatType::Load8: {
             // DB000000 XXXXXXXX – reg = [XXXXXXXX+offset] & 0xFF
-            LoadOp<u8>(line, state, Read8);
+            LoadOp<u8>(op, state, Read8);
             break;
         }
         case CheatType::AddOffset: {
             // DC000000 XXXXXXXX – offset + XXXXXXXX
-            AddOffsetOp(line, state);
+            AddOffsetOp(op, state);
             break;
         }
         case CheatType::Joker: {
             // DD000000 XXXXXXXX – if KEYPAD has value XXXXXXXX execute next block
-            JokerOp(line, state, system);
+            JokerOp(op, state, system);
             break;
         }
         case CheatType::Patch: {
             // EXXXXXXX YYYYYYYY
             // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
-            PatchOp(line, state, system, cheat_lines);
+            PatchOp(op, state, system, patch_words, Read8, Read32, Write8, Write32);
             break;
         }
         }
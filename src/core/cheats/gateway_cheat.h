@@ -6,6 +6,9 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
 #include "core/cheats/cheat_base.h"
 
 namespace Cheats {
@@ -45,11 +48,20 @@ public:
 
     struct CheatLine {
         explicit CheatLine(const std::string& line);
+        CheatType type;
+        u32 address = 0;
+        u32 value = 0;
+        u32 first = 0;
+        std::string cheat_line;
+    };
+
+    /// A cheat line lowered for execution, the data lines of patches are folded into their op
+    struct Op {
         CheatType type;
         u32 address;
         u32 value;
-        u32 first;
-        std::string cheat_line;
+        /// Index of the first data word in patch_words for patches
+        u32 data;
     };
 
     GatewayCheat(std::string name, std::vector<CheatLine> cheat_lines, std::string comments);
@@ -75,9 +87,16 @@ public:
     static std::vector<std::unique_ptr<CheatBase>> LoadFile(const std::string& filepath);
 
 private:
+    /// Lowers cheat_lines into ops and patch_words
+    void Compile();
+
     std::atomic<bool> enabled = false;
     const std::string name;
     const std::vector<CheatLine> cheat_lines;
     const std::string comments;
+
+    std::vector<Op> ops;
+    /// Data of the patches, in the order they are written
+    std::vector<u32> patch_words;
 };
 } // namespace Cheats
@@ -2,12 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <memory>
+#include <string>
 #include <utility>
+#include <fmt/format.h>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
 #include "audio_core/lle/lle.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/arm/arm_interface.h"
 #ifdef ARCHITECTURE_x86_64
 #include "core/arm/dynarmic/arm_dynarmic.h"
@@ -31,11 +37,44 @@
 #include "core/rpc/rpc_server.h"
 #endif
 #include "core/settings.h"
+#include "core/title_settings.h"
 #include "network/network.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
 namespace Core {
 
+/// Times the consecutive phases of a boot, to log how long each of them took once it is over
+class BootPhaseTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Ends the current phase, which started when the previous one ended
+    void EndPhase(const char* name) {
+        const Clock::time_point now = Clock::now();
+        AddPhase(name, now - phase_start);
+        phase_start = now;
+    }
+
+    /// Adds a phase that ran in parallel with the others
+    void AddPhase(const char* name, Clock::duration duration) {
+        const double ms = std::chrono::duration<double, std::milli>(duration).count();
+        report += fmt::format("{}{} {:.1f} ms", report.empty() ? "" : ", ", name, ms);
+    }
+
+    void Log() const {
+        const double total_ms =
+            std::chrono::duration<double, std::milli>(Clock::now() - boot_start).count();
+        LOG_INFO(Core, "Booted in {:.1f} ms ({})", total_ms, report);
+    }
+
+private:
+    Clock::time_point boot_start = Clock::now();
+    Clock::time_point phase_start = boot_start;
+    std::string report;
+};
+
 /*static*/ System System::s_instance;
 
 System::ResultStatus System::RunLoop(bool tight_loop) {
@@ -58,15 +97,18 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         }
     }
 
-    // If we don't have a currently active thread then don't execute instructions,
-    // instead advance to the next event and try to yield to the next thread
+    // If we don't have a currently active thread then don't execute instructions, instead jump
+    // straight to the next event and try to yield to the next thread. Only events can wake the
+    // threads up, so running the loop for the slices in between would just spin the host. The host
+    // then waits in the frame limiter at the next VBlank instead.
     if (kernel->GetThreadManager().GetCurrentThread() == nullptr) {
         LOG_TRACE(Core_ARM11, "Idling");
-        timing->Idle();
+        timing->IdleUntilNextEvent();
         timing->Advance();
         PrepareReschedule();
     } else {
         timing->Advance();
+        PerfStats::ScopedPhase phase(perf_stats, FramePhase::CPU);
         if (tight_loop) {
             cpu_core->Run();
         } else {
@@ -95,6 +137,7 @@ System::ResultStatus System::SingleStep() {
 }
 
 System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& filepath) {
+    BootPhaseTimer boot_timer;
     app_loader = Loader::GetLoader(filepath);
 
     if (!app_loader) {
@@ -119,7 +162,16 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
     }
 
     ASSERT(system_mode.first);
-    ResultStatus init_result{Init(emu_window, *system_mode.first)};
+
+    // The settings stored for the title have to be in place before the system is initialized
+    u64 title_id{0};
+    const bool has_title_id = app_loader->ReadProgramId(title_id) == Loader::ResultStatus::Success;
+    if (has_title_id) {
+        Settings::ApplyTitleSettings(title_id);
+        Settings::Apply();
+    }
+    boot_timer.EndPhase("loader");
+    ResultStatus init_result{Init(emu_window, *system_mode.first, boot_timer)};
     if (init_result != ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to initialize system (Error {})!",
                      static_cast<u32>(init_result));
@@ -127,6 +179,11 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
         return init_result;
     }
 
+    // The disk caches of the renderer are loaded while the title is, when the GPU thread is enabled
+    if (has_title_id) {
+        VideoCore::RunOnGPUThread([title_id] { VideoCore::LoadDiskResources(title_id); });
+    }
+
     Kernel::SharedPtr<Kernel::Process> process;
     const Loader::ResultStatus load_result{app_loader->Load(process)};
     kernel->SetCurrentProcess(process);
@@ -145,6 +202,14 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
     }
     memory->SetCurrentPageTable(&kernel->GetCurrentProcess()->vm_manager.page_table);
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
+    boot_timer.EndPhase("title");
+
+    // Waits for what is left of loading the disk caches, so that the report covers it
+    VideoCore::RunOnGPUThreadSync([] {});
+    boot_timer.EndPhase("disk caches");
+    boot_timer.Log();
+
+    cpu_core->SetIdleLoopSkipping(Settings::ShouldSkipIdleLoops(title_id));
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
     m_filepath = filepath;
@@ -160,6 +225,22 @@ PerfStats::Results System::GetAndResetPerfStats() {
     return perf_stats.GetAndResetStats(timing->GetGlobalTimeUs());
 }
 
+void System::SetFastForward(bool enable) {
+    frame_limiter.SetFastForward(enable);
+    if (dsp_core) {
+        dsp_core->EnableDropping(enable);
+    }
+
+    for (const auto role : {Common::ThreadRole::CPU, Common::ThreadRole::GPU}) {
+        Common::ThreadRoleConfig config =
+            Settings::values.thread_roles[static_cast<std::size_t>(role)];
+        if (enable) {
+            config.priority = std::max(config.priority, Common::ThreadPriority::High);
+        }
+        Common::SetThreadRoleConfig(role, config);
+    }
+}
+
 void System::Reschedule() {
     if (!reschedule_pending) {
         return;
@@ -169,12 +250,14 @@ void System::Reschedule() {
     kernel->GetThreadManager().Reschedule();
 }
 
-System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
+System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode,
+                                  BootPhaseTimer& boot_timer) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
     memory = std::make_unique<Memory::MemorySystem>();
 
     timing = std::make_unique<Timing>();
+    timing->SetCPUClockPercentage(static_cast<u32>(Settings::values.cpu_clock_percentage));
 
     kernel = std::make_unique<Kernel::KernelSystem>(*memory, system_mode);
 
@@ -189,15 +272,25 @@ System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
         cpu_core = std::make_unique<ARM_DynCom>(*this, USER32MODE);
     }
 
+    const bool deterministic = Settings::values.deterministic;
     if (Settings::values.enable_dsp_lle) {
-        dsp_core = std::make_unique<AudioCore::DspLle>(*memory,
-                                                       Settings::values.enable_dsp_lle_multithread);
+        dsp_core = std::make_unique<AudioCore::DspLle>(
+            *memory, Settings::values.enable_dsp_lle_multithread && !deterministic);
     } else {
-        dsp_core = std::make_unique<AudioCore::DspHle>(*memory);
+        dsp_core = std::make_unique<AudioCore::DspHle>(
+            *memory, Settings::values.enable_dsp_hle_multithread && !deterministic);
     }
 
-    dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
-    dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    // Opening the audio device can take a while, it is done while the services and the renderer are
+    // initialized. Nothing uses the sink before the emulation starts.
+    auto sink_open = std::async(std::launch::async, [this] {
+        const BootPhaseTimer::Clock::time_point start = BootPhaseTimer::Clock::now();
+        dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
+        dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+        dsp_core->EnableLowLatency(Settings::values.enable_low_latency_audio);
+        return BootPhaseTimer::Clock::now() - start;
+    });
+    boot_timer.EndPhase("core");
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
 
@@ -211,8 +304,12 @@ System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
     HW::Init(*memory);
     Service::Init(*this);
     GDBStub::Init();
+    boot_timer.EndPhase("services");
 
     ResultStatus result = VideoCore::Init(emu_window, *memory);
+    boot_timer.EndPhase("renderer");
+    // The sink is opened before returning, even on failure
+    boot_timer.AddPhase("audio sink (in parallel)", sink_open.get());
     if (result != ResultStatus::Success) {
         return result;
     }
@@ -278,6 +375,10 @@ void System::RegisterSoftwareKeyboard(std::shared_ptr<Frontend::SoftwareKeyboard
     registered_swkbd = std::move(swkbd);
 }
 
+void System::RegisterMic(std::shared_ptr<Frontend::Mic::Interface> mic) {
+    registered_mic = std::move(mic);
+}
+
 void System::Shutdown() {
     // Log last frame performance stats
     auto perf_results = GetAndResetPerfStats();
@@ -288,6 +389,10 @@ void System::Shutdown() {
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
 
+    if (IsFastForwarding()) {
+        SetFastForward(false);
+    }
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     VideoCore::Shutdown();
@@ -309,6 +414,10 @@ void System::Shutdown() {
         room_member->SendGameInfo(game_info);
     }
 
+    if (Settings::RestoreTitleSettings()) {
+        Settings::Apply();
+    }
+
     LOG_DEBUG(Core, "Shutdown OK");
 }
 
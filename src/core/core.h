@@ -8,6 +8,7 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/frontend/applets/swkbd.h"
+#include "core/frontend/mic.h"
 #include "core/loader/loader.h"
 #include "core/memory.h"
 #include "core/perf_stats.h"
@@ -49,6 +50,7 @@ class CheatEngine;
 
 namespace Core {
 
+class BootPhaseTimer;
 class Timing;
 
 class System {
@@ -146,6 +148,18 @@ public:
 
     PerfStats::Results GetAndResetPerfStats();
 
+    /**
+     * Sets whether to run emulation as fast as the host allows, e.g. for grinding or long
+     * automated runs. The frame limit is ignored and frames are only presented up to a display
+     * rate, the audio output is dropped instead of stretched, and the CPU and GPU threads get at
+     * least a high priority.
+     */
+    void SetFastForward(bool enable);
+
+    bool IsFastForwarding() const {
+        return frame_limiter.IsFastForwarding();
+    }
+
     /**
      * Gets a reference to the emulated CPU.
      * @returns A reference to the emulated CPU.
@@ -230,15 +244,24 @@ public:
         return registered_swkbd;
     }
 
+    /// Frontend Microphone
+
+    void RegisterMic(std::shared_ptr<Frontend::Mic::Interface> mic);
+
+    std::shared_ptr<Frontend::Mic::Interface> GetMic() const {
+        return registered_mic;
+    }
+
 private:
     /**
      * Initialize the emulated system.
      * @param emu_window Reference to the host-system window used for video output and keyboard
      *                   input.
      * @param system_mode The system mode.
+     * @param boot_timer Timer of the boot the initialization is part of.
      * @return ResultStatus code, indicating if the operation succeeded.
      */
-    ResultStatus Init(EmuWindow& emu_window, u32 system_mode);
+    ResultStatus Init(EmuWindow& emu_window, u32 system_mode, BootPhaseTimer& boot_timer);
 
     /// Reschedule the core emulation
     void Reschedule();
@@ -263,6 +286,7 @@ private:
 
     /// Frontend applets
     std::shared_ptr<Frontend::SoftwareKeyboard> registered_swkbd;
+    std::shared_ptr<Frontend::Mic::Interface> registered_mic;
 
     /// Cheats manager
     std::unique_ptr<Cheats::CheatEngine> cheat_engine;
@@ -50,6 +50,23 @@ void Timing::AddTicks(u64 ticks) {
     downcount -= ticks;
 }
 
+void Timing::SetCPUClockPercentage(u32 percentage) {
+    ASSERT(percentage != 0);
+    cpu_clock_percentage = percentage;
+    cpu_cycle_remainder = 0;
+}
+
+void Timing::AddCPUCycles(u64 cycles) {
+    // Carry the remainder over so that no cycles get lost to rounding
+    const u64 scaled = cycles * 100 + cpu_cycle_remainder;
+    cpu_cycle_remainder = scaled % cpu_clock_percentage;
+    AddTicks(scaled / cpu_clock_percentage);
+}
+
+s64 Timing::GetCPUCyclesRemaining() const {
+    return downcount * static_cast<s64>(cpu_clock_percentage) / 100;
+}
+
 u64 Timing::GetIdleTicks() const {
     return static_cast<u64>(idled_cycles);
 }
@@ -63,35 +80,44 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    PushEvent(timeout, userdata, event_type);
 }
 
 void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
                                      u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    auto* event = new ThreadsafeEvent{global_timer + cycles_into_future, userdata, event_type,
+                                      ts_events.load(std::memory_order_relaxed)};
+    while (!ts_events.compare_exchange_weak(event->next, event, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
 }
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
+    auto itr = scheduled_events.find(event_type);
+    if (itr == scheduled_events.end()) {
+        return;
+    }
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    // Removing an event moves the last handle of the list into its place, walking the list
+    // backwards makes sure that every handle is still looked at exactly once
+    std::vector<EventHandle>& handles = itr->second;
+    for (std::size_t i = handles.size(); i-- > 0;) {
+        const std::size_t heap_index = handle_slots[handles[i]].heap_index;
+        if (event_queue[heap_index].userdata == userdata) {
+            RemoveEventAt(heap_index);
+        }
     }
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
+    auto itr = scheduled_events.find(event_type);
+    if (itr == scheduled_events.end()) {
+        return;
+    }
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    std::vector<EventHandle>& handles = itr->second;
+    while (!handles.empty()) {
+        RemoveEventAt(handle_slots[handles.back()].heap_index);
     }
 }
 
@@ -109,11 +135,107 @@ void Timing::ForceExceptionCheck(s64 cycles) {
 }
 
 void Timing::MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    ThreadsafeEvent* event = ts_events.exchange(nullptr, std::memory_order_acquire);
+
+    // The list is newest first, reverse it so that the events keep the order they were pushed in
+    ThreadsafeEvent* oldest = nullptr;
+    while (event) {
+        ThreadsafeEvent* next = event->next;
+        event->next = oldest;
+        oldest = event;
+        event = next;
+    }
+
+    while (oldest) {
+        PushEvent(oldest->time, oldest->userdata, oldest->type);
+        ThreadsafeEvent* next = oldest->next;
+        delete oldest;
+        oldest = next;
+    }
+}
+
+void Timing::PushEvent(s64 time, u64 userdata, const TimingEventType* event_type) {
+    EventHandle handle;
+    if (free_handles.empty()) {
+        handle = static_cast<EventHandle>(handle_slots.size());
+        handle_slots.emplace_back();
+    } else {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    }
+
+    std::vector<EventHandle>& handles = scheduled_events[event_type];
+    handle_slots[handle].type_index = handles.size();
+    handles.push_back(handle);
+
+    event_queue.emplace_back(Event{time, event_fifo_id++, userdata, event_type, handle});
+    handle_slots[handle].heap_index = event_queue.size() - 1;
+    SiftUp(event_queue.size() - 1);
+}
+
+void Timing::RemoveEventAt(std::size_t heap_index) {
+    const EventHandle handle = event_queue[heap_index].handle;
+
+    // Swap the handle out of the list of its type
+    std::vector<EventHandle>& handles = scheduled_events[event_queue[heap_index].type];
+    const std::size_t type_index = handle_slots[handle].type_index;
+    handles[type_index] = handles.back();
+    handle_slots[handles[type_index]].type_index = type_index;
+    handles.pop_back();
+    free_handles.push_back(handle);
+
+    const std::size_t last_index = event_queue.size() - 1;
+    if (heap_index == last_index) {
+        event_queue.pop_back();
+        return;
+    }
+
+    // Fill the hole with the last event, which can belong either above or below it
+    PlaceEvent(heap_index, std::move(event_queue[last_index]));
+    event_queue.pop_back();
+    if (heap_index > 0 && event_queue[heap_index] < event_queue[(heap_index - 1) / 2]) {
+        SiftUp(heap_index);
+    } else {
+        SiftDown(heap_index);
+    }
+}
+
+void Timing::PlaceEvent(std::size_t heap_index, Event&& event) {
+    handle_slots[event.handle].heap_index = heap_index;
+    event_queue[heap_index] = std::move(event);
+}
+
+void Timing::SiftUp(std::size_t heap_index) {
+    Event event = std::move(event_queue[heap_index]);
+    while (heap_index > 0) {
+        const std::size_t parent = (heap_index - 1) / 2;
+        if (!(event < event_queue[parent])) {
+            break;
+        }
+        PlaceEvent(heap_index, std::move(event_queue[parent]));
+        heap_index = parent;
+    }
+    PlaceEvent(heap_index, std::move(event));
+}
+
+void Timing::SiftDown(std::size_t heap_index) {
+    Event event = std::move(event_queue[heap_index]);
+    const std::size_t size = event_queue.size();
+    while (true) {
+        std::size_t child = heap_index * 2 + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && event_queue[child + 1] < event_queue[child]) {
+            ++child;
+        }
+        if (!(event_queue[child] < event)) {
+            break;
+        }
+        PlaceEvent(heap_index, std::move(event_queue[child]));
+        heap_index = child;
     }
+    PlaceEvent(heap_index, std::move(event));
 }
 
 void Timing::Advance() {
@@ -126,9 +248,8 @@ void Timing::Advance() {
     is_global_timer_sane = true;
 
     while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+        const Event evt = event_queue.front();
+        RemoveEventAt(0);
         evt.type->callback(evt.userdata, global_timer - evt.time);
     }
 
@@ -148,6 +269,24 @@ void Timing::Idle() {
     downcount = 0;
 }
 
+s64 Timing::IdleUntilNextEvent() {
+    MoveEvents();
+
+    // Stretch the slice so that the next Advance lands right on the event
+    s64 skipped = std::max<s64>(downcount, 0);
+    if (!event_queue.empty()) {
+        const s64 slice_end = global_timer + slice_length;
+        if (event_queue.front().time > slice_end) {
+            slice_length += event_queue.front().time - slice_end;
+            skipped += event_queue.front().time - slice_end;
+        }
+    }
+
+    idled_cycles += skipped;
+    downcount = std::min<s64>(downcount, 0);
+    return skipped;
+}
+
 std::chrono::microseconds Timing::GetGlobalTimeUs() const {
     return std::chrono::microseconds{GetTicks() * 1000000 / BASE_CLOCK_RATE_ARM11};
 }
@@ -17,6 +17,7 @@
  *   ScheduleEvent(periodInCycles - cyclesLate, callback, "whatever")
  */
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <limits>
@@ -25,7 +26,6 @@
 #include <vector>
 #include "common/common_types.h"
 #include "common/logging/log.h"
-#include "common/threadsafe_queue.h"
 
 // The timing we get from the assembly is 268,111,855.956 Hz
 // It is possible that this number isn't just an integer because the compiler could have
@@ -144,6 +144,18 @@ public:
     u64 GetIdleTicks() const;
     void AddTicks(u64 ticks);
 
+    /**
+     * Sets the speed of the emulated CPU relative to the base clock, in percent. Above 100 the CPU
+     * is overclocked and runs more cycles between two events, below 100 it runs fewer.
+     */
+    void SetCPUClockPercentage(u32 percentage);
+
+    /// Charges cycles executed by the CPU, converted to ticks at the current CPU clock
+    void AddCPUCycles(u64 cycles);
+
+    /// Gets how many cycles the CPU can execute before the end of the slice
+    s64 GetCPUCyclesRemaining() const;
+
     /**
      * Returns the event_type identifier. if name is not unique, it will assert.
      */
@@ -183,6 +195,13 @@ public:
     /// Pretend that the main CPU has executed enough cycles to reach the next event.
     void Idle();
 
+    /**
+     * Like Idle, but also skips the slices between the current one and the next event, for a CPU
+     * that is known to be waiting for that event.
+     * @returns the number of cycles skipped
+     */
+    s64 IdleUntilNextEvent();
+
     void ForceExceptionCheck(s64 cycles);
 
     std::chrono::microseconds GetGlobalTimeUs() const;
@@ -190,18 +209,43 @@ public:
     s64 GetDowncount() const;
 
 private:
+    /// Stays the same for an event while it moves around in the heap
+    using EventHandle = u32;
+
     struct Event {
         s64 time;
         u64 fifo_order;
         u64 userdata;
         const TimingEventType* type;
+        EventHandle handle;
 
         bool operator>(const Event& right) const;
         bool operator<(const Event& right) const;
     };
 
+    struct HandleSlot {
+        /// Index of the event in event_queue
+        std::size_t heap_index;
+        /// Index of the handle in the list of scheduled events of its type
+        std::size_t type_index;
+    };
+
+    /// Node of the list of events pushed by other threads
+    struct ThreadsafeEvent {
+        s64 time;
+        u64 userdata;
+        const TimingEventType* type;
+        ThreadsafeEvent* next;
+    };
+
     static constexpr int MAX_SLICE_LENGTH = 20000;
 
+    void PushEvent(s64 time, u64 userdata, const TimingEventType* event_type);
+    void RemoveEventAt(std::size_t heap_index);
+    void PlaceEvent(std::size_t heap_index, Event&& event);
+    void SiftUp(std::size_t heap_index);
+    void SiftDown(std::size_t heap_index);
+
     s64 global_timer = 0;
     s64 slice_length = MAX_SLICE_LENGTH;
     s64 downcount = MAX_SLICE_LENGTH;
@@ -210,17 +254,24 @@ private:
     // elements remain stable regardless of rehashes/resizing.
     std::unordered_map<std::string, TimingEventType> event_types;
 
-    // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-    // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-    // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-    // accomodated by the standard adaptor class.
+    // The queue is an indexed binary min-heap. Every event has a handle that keeps track of where
+    // the event currently is in the heap, and the handles of each event type are listed in
+    // scheduled_events, so that UnscheduleEvent and RemoveEvent can take events out of the middle
+    // of the heap in O(log n) without scanning or rebuilding it.
     std::vector<Event> event_queue;
+    std::vector<HandleSlot> handle_slots;
+    std::vector<EventHandle> free_handles;
+    std::unordered_map<const TimingEventType*, std::vector<EventHandle>> scheduled_events;
     u64 event_fifo_id = 0;
-    // the queue for storing the events from other threads threadsafe until they will be added
-    // to the event_queue by the emu thread
-    Common::MPSCQueue<Event, false> ts_queue;
+    // Events from other threads are pushed onto this lock-free list, newest first, until they
+    // are added to the event_queue by the emu thread
+    std::atomic<ThreadsafeEvent*> ts_events{nullptr};
     s64 idled_cycles = 0;
 
+    u32 cpu_clock_percentage = 100;
+    // Part of a tick left over by the conversion of CPU cycles, in units of 1/100 cycle
+    u64 cpu_cycle_remainder = 0;
+
     // Are we in a function that has been called from Advance()
     // If events are sheduled from a function that gets called from Advance(),
     // don't change slice_length and downcount.
@@ -10,8 +10,10 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/archive_extsavedata.h"
+#include "core/file_sys/blob_archive.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 #include "core/file_sys/savedata_archive.h"
 #include "core/hle/service/fs/archive.h"
@@ -109,7 +111,7 @@ public:
 
         const auto full_path = path_parser.BuildHostPath(mount_point);
 
-        switch (path_parser.GetHostStatus(mount_point)) {
+        switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
         case PathParser::InvalidMountPoint:
             LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
             return ERROR_FILE_NOT_FOUND;
@@ -140,6 +142,7 @@ public:
             std::make_unique<ExtSaveDataDelayGenerator>();
         auto disk_file =
             std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+        disk_file->SetMetadataCache(metadata_cache, full_path);
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -231,6 +234,16 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_ExtSaveData::Open(cons
             return ERR_NOT_FORMATTED;
         }
     }
+    if (BlobArchive::IsBlobArchive(fullpath)) {
+        BlobArchive::Options options;
+        options.fixed_size_files = true;
+        auto archive = BlobArchive::Open(fullpath, options);
+        if (archive == nullptr) {
+            return ERROR_NOT_FOUND;
+        }
+        return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
+    }
+
     auto archive = std::make_unique<ExtSaveDataArchive>(fullpath);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
@@ -242,6 +255,7 @@ ResultCode ArchiveFactory_ExtSaveData::Format(const Path& path,
     // These folders are always created with the ExtSaveData
     std::string user_path = GetExtSaveDataPath(mount_point, corrected_path) + "user/";
     std::string boss_path = GetExtSaveDataPath(mount_point, corrected_path) + "boss/";
+    HostMetadataCache::GetInstance().Clear();
     FileUtil::CreateFullPath(user_path);
     FileUtil::CreateFullPath(boss_path);
 
@@ -276,6 +290,7 @@ ResultVal<ArchiveFormatInfo> ArchiveFactory_ExtSaveData::GetFormatInfo(const Pat
 void ArchiveFactory_ExtSaveData::WriteIcon(const Path& path, const u8* icon_data,
                                            std::size_t icon_size) {
     std::string game_path = FileSys::GetExtSaveDataPath(GetMountPoint(), path);
+    HostMetadataCache::GetInstance().Invalidate(game_path + "icon");
     FileUtil::IOFile icon_file(game_path + "icon", "wb");
     icon_file.WriteBytes(icon_data, icon_size);
 }
@@ -65,7 +65,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -83,6 +83,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
             return ERROR_NOT_FOUND;
         } else {
             // Create the file
+            metadata_cache.Invalidate(full_path);
             FileUtil::CreateEmptyFile(full_path);
         }
         break;
@@ -98,6 +99,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SDMCDelayGenerator>();
     auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    disk_file->SetMetadataCache(metadata_cache, full_path);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -111,7 +113,7 @@ ResultCode SDMCArchive::DeleteFile(const Path& path) const {
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -127,6 +129,7 @@ ResultCode SDMCArchive::DeleteFile(const Path& path) const {
         break; // Expected 'success' case
     }
 
+    metadata_cache.Invalidate(full_path);
     if (FileUtil::Delete(full_path)) {
         return RESULT_SUCCESS;
     }
@@ -154,6 +157,8 @@ ResultCode SDMCArchive::RenameFile(const Path& src_path, const Path& dest_path)
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    metadata_cache.Invalidate(src_path_full);
+    metadata_cache.Invalidate(dest_path_full);
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
         return RESULT_SUCCESS;
     }
@@ -166,7 +171,7 @@ ResultCode SDMCArchive::RenameFile(const Path& src_path, const Path& dest_path)
 
 template <typename T>
 static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mount_point,
-                                        T deleter) {
+                                        HostMetadataCache& metadata_cache, T deleter) {
     const PathParser path_parser(path);
 
     if (!path_parser.IsValid()) {
@@ -179,7 +184,7 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -195,6 +200,7 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
         break; // Expected 'success' case
     }
 
+    metadata_cache.Invalidate(full_path);
     if (deleter(full_path)) {
         return RESULT_SUCCESS;
     }
@@ -204,12 +210,13 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 }
 
 ResultCode SDMCArchive::DeleteDirectory(const Path& path) const {
-    return DeleteDirectoryHelper(path, mount_point, FileUtil::DeleteDir);
+    return DeleteDirectoryHelper(path, mount_point, metadata_cache, FileUtil::DeleteDir);
 }
 
 ResultCode SDMCArchive::DeleteDirectoryRecursively(const Path& path) const {
-    return DeleteDirectoryHelper(
-        path, mount_point, [](const std::string& p) { return FileUtil::DeleteDirRecursively(p); });
+    return DeleteDirectoryHelper(path, mount_point, metadata_cache, [](const std::string& p) {
+        return FileUtil::DeleteDirRecursively(p);
+    });
 }
 
 ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
@@ -222,7 +229,7 @@ ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -241,10 +248,12 @@ ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
     }
 
     if (size == 0) {
+        metadata_cache.Invalidate(full_path);
         FileUtil::CreateEmptyFile(full_path);
         return RESULT_SUCCESS;
     }
 
+    metadata_cache.Invalidate(full_path);
     FileUtil::IOFile file(full_path, "wb");
     // Creates a sparse file (or a normal file on filesystems without the concept of sparse files)
     // We do this by seeking to the right size, then writing a single null byte.
@@ -267,7 +276,7 @@ ResultCode SDMCArchive::CreateDirectory(const Path& path) const {
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -283,6 +292,7 @@ ResultCode SDMCArchive::CreateDirectory(const Path& path) const {
         break; // Expected 'success' case
     }
 
+    metadata_cache.Invalidate(full_path);
     if (FileUtil::CreateDir(mount_point + path.AsString())) {
         return RESULT_SUCCESS;
     }
@@ -311,6 +321,8 @@ ResultCode SDMCArchive::RenameDirectory(const Path& src_path, const Path& dest_p
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    metadata_cache.Invalidate(src_path_full);
+    metadata_cache.Invalidate(dest_path_full);
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
         return RESULT_SUCCESS;
     }
@@ -331,7 +343,7 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SDMCArchive::OpenDirectory(const Pa
 
     const auto full_path = path_parser.BuildHostPath(mount_point);
 
-    switch (path_parser.GetHostStatus(mount_point)) {
+    switch (path_parser.GetHostStatus(mount_point, metadata_cache)) {
     case PathParser::InvalidMountPoint:
         LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
         return ERROR_NOT_FOUND;
@@ -347,7 +359,7 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SDMCArchive::OpenDirectory(const Pa
         break; // Expected 'success' case
     }
 
-    auto directory = std::make_unique<DiskDirectory>(full_path);
+    auto directory = std::make_unique<DiskDirectory>(metadata_cache.GetDirectory(full_path));
     return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(directory));
 }
 
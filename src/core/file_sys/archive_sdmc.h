@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +39,7 @@ public:
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
     std::string mount_point;
+    HostMetadataCache& metadata_cache = HostMetadataCache::GetInstance();
 };
 
 /// File system interface to the SDMC archive
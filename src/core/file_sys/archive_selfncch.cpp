@@ -4,7 +4,9 @@
 
 #include <array>
 #include <cinttypes>
+#include <fmt/format.h>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
 #include "core/core.h"
@@ -12,6 +14,7 @@
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ivfc_archive.h"
 #include "core/hle/kernel/process.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -254,7 +257,13 @@ void ArchiveFactory_SelfNCCH::Register(Loader::AppLoader& app_loader) {
 
     std::shared_ptr<RomFSReader> romfs_file_;
     if (Loader::ResultStatus::Success == app_loader.ReadRomFS(romfs_file_)) {
-
+        if (Settings::values.romfs_access_trace) {
+            // The size tells apart the RomFS of different versions of the title
+            romfs_file_->UseAccessTrace(fmt::format(
+                "{}romfs_trace/{:016X}_{:X}.bin",
+                FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id,
+                romfs_file_->GetSize()));
+        }
         data.romfs_file = std::move(romfs_file_);
     }
 
@@ -6,7 +6,9 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
+#include "core/file_sys/blob_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/savedata_archive.h"
 #include "core/hle/service/fs/archive.h"
 
@@ -50,6 +52,14 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveSource_SDSaveData::Open(u64 pr
         return ERR_NOT_FORMATTED;
     }
 
+    if (BlobArchive::IsBlobArchive(concrete_mount_point)) {
+        auto archive = BlobArchive::Open(concrete_mount_point, {});
+        if (archive == nullptr) {
+            return ERROR_NOT_FOUND;
+        }
+        return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
+    }
+
     auto archive = std::make_unique<SaveDataArchive>(std::move(concrete_mount_point));
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
@@ -57,6 +67,7 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveSource_SDSaveData::Open(u64 pr
 ResultCode ArchiveSource_SDSaveData::Format(u64 program_id,
                                             const FileSys::ArchiveFormatInfo& format_info) {
     std::string concrete_mount_point = GetSaveDataPath(mount_point, program_id);
+    HostMetadataCache::GetInstance().Clear();
     FileUtil::DeleteDirRecursively(concrete_mount_point);
     FileUtil::CreateFullPath(concrete_mount_point);
 
@@ -0,0 +1,897 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+#include <cryptopp/sha.h>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/file_sys/blob_archive.h"
+#include "core/file_sys/disk_archive.h"
+#include "core/file_sys/errors.h"
+#include "core/file_sys/path_parser.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+
+class BlobArchiveDelayGenerator : public DelayGenerator {
+public:
+    u64 GetReadDelayNs(std::size_t length) override {
+        // Blob archives stand in for SaveData and ExtSaveData, which use the delay measured for
+        // SaveData reads
+        static constexpr u64 slope(183);
+        static constexpr u64 offset(524879);
+        static constexpr u64 minimum(631826);
+        return std::max<u64>(static_cast<u64>(length) * slope + offset, minimum);
+    }
+};
+
+// "CBAM" - Citra Blob Archive Manifest
+constexpr u32 MANIFEST_MAGIC = 0x4D414243;
+constexpr u32 MANIFEST_VERSION = 1;
+
+struct ManifestHeader {
+    u32_le magic;
+    u32_le version;
+    u32_le node_count;
+    u32_le store_root_size;
+    u64_le next_local_id;
+};
+static_assert(sizeof(ManifestHeader) == 24, "ManifestHeader has incorrect size");
+
+/// Followed by the path of the node
+struct ManifestNode {
+    u32_le path_size;
+    u32_le type;
+    u64_le blob_size;
+    u64_le local_id;
+    BlobStore::Hash hash;
+};
+static_assert(sizeof(ManifestNode) == 56, "ManifestNode has incorrect size");
+
+struct Node {
+    enum class Type : u32 {
+        Directory = 0,
+        /// Unmodified file, stored in the blob store
+        Blob = 1,
+        /// File created or modified through the archive, stored in the mount point
+        Local = 2,
+    };
+
+    Type type = Type::Directory;
+    u64 blob_size = 0;
+    BlobStore::Hash hash{};
+    u64 local_id = 0;
+};
+
+/// Equivalent of PathParser::HostStatus for the paths of a manifest
+enum class Status {
+    PathNotFound,
+    FileInPath,
+    FileFound,
+    DirectoryFound,
+    NotFound,
+};
+
+constexpr char ROOT_PATH[] = "/";
+constexpr char LOCAL_FILES_DIRECTORY[] = ".blob_files/";
+constexpr std::size_t HASH_CHUNK_SIZE = 64 * 1024;
+
+/// Path of the node of a manifest, "/a/b" for the archive path "/a/b" and "/" for the root
+std::string GetNodePath(const PathParser& path_parser) {
+    return path_parser.BuildHostPath(ROOT_PATH);
+}
+
+std::string GetParentPath(const std::string& path) {
+    const std::size_t pos = path.rfind('/');
+    return pos == 0 ? ROOT_PATH : path.substr(0, pos);
+}
+
+/// Whether the node at path is a descendant of the directory node
+bool IsInDirectory(const std::string& path, const std::string& directory) {
+    if (directory == ROOT_PATH) {
+        return path != ROOT_PATH;
+    }
+    return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+           path[directory.size()] == '/';
+}
+
+/// Writes data through a temporary file, so that an interrupted write never leaves a partial file
+bool ReplaceFile(const std::string& path, const std::vector<u8>& data) {
+    const std::string temp_path = path + ".tmp";
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        if (!file.IsOpen() || file.WriteBytes(data.data(), data.size()) != data.size()) {
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+    if (FileUtil::Rename(temp_path, path)) {
+        return true;
+    }
+    // Renaming over an existing file fails on Windows
+    FileUtil::Delete(path);
+    return FileUtil::Rename(temp_path, path);
+}
+
+} // Anonymous namespace
+
+BlobStore::BlobStore(std::string root_) : root(std::move(root_)) {
+    if (!root.empty() && root.back() != '/') {
+        root += '/';
+    }
+}
+
+std::string BlobStore::GetBlobPath(const Hash& hash) const {
+    std::string name;
+    for (u8 byte : hash) {
+        name += fmt::format("{:02x}", byte);
+    }
+    return fmt::format("{}{}/{}", root, name.substr(0, 2), name);
+}
+
+std::optional<BlobStore::Hash> BlobStore::AddFile(const std::string& host_path) {
+    FileUtil::IOFile file(host_path, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Service_FS, "Could not open {}", host_path);
+        return std::nullopt;
+    }
+
+    CryptoPP::SHA256 sha;
+    std::vector<u8> buffer(HASH_CHUNK_SIZE);
+    const u64 size = file.GetSize();
+    for (u64 offset = 0; offset < size;) {
+        const std::size_t read = file.ReadBytes(buffer.data(), buffer.size());
+        if (read == 0) {
+            LOG_ERROR(Service_FS, "Could not read {}", host_path);
+            return std::nullopt;
+        }
+        sha.Update(buffer.data(), read);
+        offset += read;
+    }
+    file.Close();
+
+    Hash hash;
+    sha.Final(hash.data());
+    const std::string blob_path = GetBlobPath(hash);
+    if (FileUtil::Exists(blob_path)) {
+        return hash;
+    }
+
+    // Another process sharing the store might be adding the same blob, each copy gets its own
+    // temporary file and the rename makes the blob appear complete
+    FileUtil::CreateFullPath(blob_path);
+    const std::string temp_path = fmt::format("{}.{:08x}.tmp", blob_path, std::random_device{}());
+    if (!FileUtil::Copy(host_path, temp_path)) {
+        FileUtil::Delete(temp_path);
+        return std::nullopt;
+    }
+    if (!FileUtil::Rename(temp_path, blob_path)) {
+        FileUtil::Delete(temp_path);
+        if (!FileUtil::Exists(blob_path)) {
+            return std::nullopt;
+        }
+    }
+    return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct BlobArchive::State {
+    explicit State(std::string mount_point_) : mount_point(std::move(mount_point_)), store("") {}
+
+    Status GetStatus(const std::string& path) const {
+        // Check the directories leading to the node first, "/a" and "/a/b" for "/a/b/c"
+        for (std::size_t pos = path.find('/', 1); pos != std::string::npos;
+             pos = path.find('/', pos + 1)) {
+            const auto parent = nodes.find(path.substr(0, pos));
+            if (parent == nodes.end()) {
+                return Status::PathNotFound;
+            }
+            if (parent->second.type != Node::Type::Directory) {
+                return Status::FileInPath;
+            }
+        }
+
+        const auto node = nodes.find(path);
+        if (node == nodes.end()) {
+            return Status::NotFound;
+        }
+        return node->second.type == Node::Type::Directory ? Status::DirectoryFound
+                                                          : Status::FileFound;
+    }
+
+    std::string GetLocalPath(u64 local_id) const {
+        return fmt::format("{}{}{:016X}", mount_point, LOCAL_FILES_DIRECTORY, local_id);
+    }
+
+    std::string GetHostPath(const Node& node) const {
+        return node.type == Node::Type::Blob ? store.GetBlobPath(node.hash)
+                                             : GetLocalPath(node.local_id);
+    }
+
+    u64 GetFileSize(const Node& node) const {
+        return node.type == Node::Type::Blob ? node.blob_size
+                                             : FileUtil::GetSize(GetLocalPath(node.local_id));
+    }
+
+    /// Creates an empty local file for a new node
+    std::optional<Node> CreateLocalFile() {
+        Node node;
+        node.type = Node::Type::Local;
+        node.local_id = next_local_id++;
+        const std::string local_path = GetLocalPath(node.local_id);
+        FileUtil::CreateFullPath(local_path);
+        if (!FileUtil::CreateEmptyFile(local_path)) {
+            return std::nullopt;
+        }
+        return node;
+    }
+
+    /**
+     * Copies the blob of a file out of the store before it gets modified.
+     * @returns the host path of the local copy, or std::nullopt if copying failed
+     */
+    std::optional<std::string> CopyOut(const std::string& path, const BlobStore::Hash& hash) {
+        const auto node = nodes.find(path);
+        if (node != nodes.end() && node->second.type == Node::Type::Local) {
+            // Another handle of the same file was written to first
+            return GetLocalPath(node->second.local_id);
+        }
+
+        const u64 local_id = next_local_id++;
+        const std::string local_path = GetLocalPath(local_id);
+        FileUtil::CreateFullPath(local_path);
+        if (!FileUtil::Copy(store.GetBlobPath(hash), local_path)) {
+            return std::nullopt;
+        }
+
+        // If the file was deleted or replaced while it was open, the copy stays out of the
+        // manifest and only the handle sees it, as with a deleted host file
+        if (node != nodes.end() && node->second.type == Node::Type::Blob &&
+            node->second.hash == hash) {
+            node->second.type = Node::Type::Local;
+            node->second.local_id = local_id;
+            Save();
+        }
+        return local_path;
+    }
+
+    /// Calls func(path, node) for each node directly or indirectly inside the directory
+    template <typename Func>
+    void ForEachDescendant(const std::string& directory, Func&& func) const {
+        // Paths sort by prefix, but "/a.bin" comes between "/a" and "/a/b", so the descendants
+        // are looked up from "/a/"
+        const std::string prefix = directory == ROOT_PATH ? ROOT_PATH : directory + '/';
+        for (auto it = nodes.lower_bound(prefix);
+             it != nodes.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->first != ROOT_PATH) {
+                func(it->first, it->second);
+            }
+        }
+    }
+
+    /// Removes the node and its children, along with their local files
+    void RemoveTree(const std::string& path) {
+        for (auto it = nodes.begin(); it != nodes.end();) {
+            if (it->first != path && !IsInDirectory(it->first, path)) {
+                ++it;
+                continue;
+            }
+            if (it->second.type == Node::Type::Local) {
+                FileUtil::Delete(GetLocalPath(it->second.local_id));
+            }
+            it = nodes.erase(it);
+        }
+    }
+
+    /// Changes the path of the node and its children
+    void MoveTree(const std::string& src_path, const std::string& dest_path) {
+        std::vector<std::pair<std::string, Node>> moved;
+        for (auto it = nodes.begin(); it != nodes.end();) {
+            if (it->first != src_path && !IsInDirectory(it->first, src_path)) {
+                ++it;
+                continue;
+            }
+            moved.emplace_back(dest_path + it->first.substr(src_path.size()), it->second);
+            it = nodes.erase(it);
+        }
+        nodes.insert(moved.begin(), moved.end());
+    }
+
+    bool Load() {
+        FileUtil::IOFile file(mount_point + MANIFEST_NAME, "rb");
+        ManifestHeader header{};
+        if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+            header.magic != MANIFEST_MAGIC || header.version != MANIFEST_VERSION) {
+            LOG_ERROR(Service_FS, "Invalid blob archive manifest in {}", mount_point);
+            return false;
+        }
+
+        std::string store_root(header.store_root_size, '\0');
+        if (file.ReadBytes(store_root.data(), store_root.size()) != store_root.size()) {
+            return false;
+        }
+        store = BlobStore(std::move(store_root));
+        next_local_id = header.next_local_id;
+
+        nodes.clear();
+        for (u32 i = 0; i < header.node_count; ++i) {
+            ManifestNode entry;
+            if (file.ReadBytes(&entry, sizeof(entry)) != sizeof(entry)) {
+                return false;
+            }
+            std::string path(entry.path_size, '\0');
+            if (file.ReadBytes(path.data(), path.size()) != path.size()) {
+                return false;
+            }
+
+            Node node;
+            node.type = static_cast<Node::Type>(static_cast<u32>(entry.type));
+            node.blob_size = entry.blob_size;
+            node.local_id = entry.local_id;
+            node.hash = entry.hash;
+            nodes.emplace(std::move(path), node);
+        }
+
+        if (GetStatus(ROOT_PATH) != Status::DirectoryFound) {
+            LOG_ERROR(Service_FS, "Blob archive manifest in {} has no root", mount_point);
+            return false;
+        }
+        return true;
+    }
+
+    bool Save() const {
+        const std::string& store_root = store.GetRoot();
+        ManifestHeader header{};
+        header.magic = MANIFEST_MAGIC;
+        header.version = MANIFEST_VERSION;
+        header.node_count = static_cast<u32>(nodes.size());
+        header.store_root_size = static_cast<u32>(store_root.size());
+        header.next_local_id = next_local_id;
+
+        std::vector<u8> data(sizeof(header));
+        std::memcpy(data.data(), &header, sizeof(header));
+        data.insert(data.end(), store_root.begin(), store_root.end());
+        for (const auto& [path, node] : nodes) {
+            ManifestNode entry{};
+            entry.path_size = static_cast<u32>(path.size());
+            entry.type = static_cast<u32>(node.type);
+            entry.blob_size = node.blob_size;
+            entry.local_id = node.local_id;
+            entry.hash = node.hash;
+
+            const std::size_t offset = data.size();
+            data.resize(offset + sizeof(entry));
+            std::memcpy(data.data() + offset, &entry, sizeof(entry));
+            data.insert(data.end(), path.begin(), path.end());
+        }
+
+        if (!ReplaceFile(mount_point + MANIFEST_NAME, data)) {
+            LOG_ERROR(Service_FS, "Could not write the blob archive manifest in {}", mount_point);
+            return false;
+        }
+        return true;
+    }
+
+    std::string mount_point;
+    BlobStore store;
+    std::map<std::string, Node> nodes;
+    u64 next_local_id = 0;
+};
+
+namespace {
+
+/**
+ * File of a blob archive. Files still stored as a blob are opened read-only from the store and
+ * only copied out of it when they are first modified.
+ */
+class BlobFile : public FileBackend {
+public:
+    BlobFile(std::shared_ptr<BlobArchive::State> state, std::string path, const Node& node,
+             FileUtil::IOFile&& file, const Mode& mode, bool fixed_size)
+        : state(std::move(state)), path(std::move(path)), is_blob(node.type == Node::Type::Blob),
+          hash(node.hash), file(std::move(file)), fixed_size(fixed_size) {
+        delay_generator = std::make_unique<BlobArchiveDelayGenerator>();
+        this->mode.hex = mode.hex;
+        size = this->file.GetSize();
+    }
+
+    ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override {
+        if (!mode.read_flag)
+            return ERROR_INVALID_OPEN_FLAGS;
+
+        file.Seek(offset, SEEK_SET);
+        return MakeResult<std::size_t>(file.ReadBytes(buffer, length));
+    }
+
+    ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
+                                 const u8* buffer) override {
+        if (!mode.write_flag)
+            return ERROR_INVALID_OPEN_FLAGS;
+
+        if (fixed_size) {
+            if (offset > size) {
+                return ERR_WRITE_BEYOND_END;
+            } else if (offset == size) {
+                return MakeResult<std::size_t>(0);
+            }
+            length = std::min<std::size_t>(length, size - offset);
+        }
+
+        if (!CopyOut()) {
+            return ERROR_INSUFFICIENT_SPACE;
+        }
+        file.Seek(offset, SEEK_SET);
+        const std::size_t written = file.WriteBytes(buffer, length);
+        if (flush)
+            file.Flush();
+        return MakeResult<std::size_t>(written);
+    }
+
+    u64 GetSize() const override {
+        return file.GetSize();
+    }
+
+    bool SetSize(u64 new_size) const override {
+        if (fixed_size || !CopyOut()) {
+            return false;
+        }
+        file.Resize(new_size);
+        file.Flush();
+        return true;
+    }
+
+    bool Close() const override {
+        return file.Close();
+    }
+
+    void Flush() const override {
+        file.Flush();
+    }
+
+private:
+    /// Switches the file to a local copy of its blob, if it still is a blob
+    bool CopyOut() const {
+        if (!is_blob) {
+            return true;
+        }
+        const auto local_path = state->CopyOut(path, hash);
+        if (!local_path) {
+            LOG_ERROR(Service_FS, "Could not copy {} out of the blob store", path);
+            return false;
+        }
+        const u64 position = file.Tell();
+        if (!file.Open(*local_path, "r+b")) {
+            return false;
+        }
+        file.Seek(position, SEEK_SET);
+        is_blob = false;
+        return true;
+    }
+
+    std::shared_ptr<BlobArchive::State> state;
+    std::string path;
+    mutable bool is_blob;
+    BlobStore::Hash hash;
+    Mode mode;
+    // The backend interface is const, but the file switches to a local copy on the first write
+    mutable FileUtil::IOFile file;
+    bool fixed_size;
+    u64 size;
+};
+
+} // Anonymous namespace
+
+BlobArchive::BlobArchive(std::shared_ptr<State> state, const Options& options)
+    : state(std::move(state)), options(options) {}
+
+bool BlobArchive::IsBlobArchive(const std::string& mount_point) {
+    return FileUtil::Exists(mount_point + MANIFEST_NAME);
+}
+
+std::unique_ptr<BlobArchive> BlobArchive::Open(const std::string& mount_point,
+                                               const Options& options) {
+    auto state = std::make_shared<State>(mount_point);
+    if (!state->Load()) {
+        return nullptr;
+    }
+    LOG_DEBUG(Service_FS, "Opened blob archive {} with {} nodes, store {}", mount_point,
+              state->nodes.size(), state->store.GetRoot());
+    return std::unique_ptr<BlobArchive>(new BlobArchive(std::move(state), options));
+}
+
+bool BlobArchive::Import(const std::string& source_directory, const std::string& store_root,
+                         const std::string& mount_point) {
+    State state(mount_point);
+    state.store = BlobStore(store_root);
+    state.nodes.emplace(ROOT_PATH, Node{});
+
+    FileUtil::FSTEntry root;
+    FileUtil::ScanDirectoryTree(source_directory, root, 256);
+
+    // Walks the scanned tree depth first, with the archive path of each entry
+    std::vector<std::pair<const FileUtil::FSTEntry*, std::string>> pending;
+    for (const auto& child : root.children) {
+        pending.emplace_back(&child, std::string(ROOT_PATH) + child.virtualName);
+    }
+    while (!pending.empty()) {
+        const auto [entry, path] = pending.back();
+        pending.pop_back();
+
+        Node node;
+        if (entry->isDirectory) {
+            for (const auto& child : entry->children) {
+                pending.emplace_back(&child, path + '/' + child.virtualName);
+            }
+        } else {
+            const auto hash = state.store.AddFile(entry->physicalName);
+            if (!hash) {
+                return false;
+            }
+            node.type = Node::Type::Blob;
+            node.blob_size = entry->size;
+            node.hash = *hash;
+        }
+        state.nodes.emplace(path, node);
+    }
+
+    FileUtil::CreateFullPath(mount_point);
+    return state.Save();
+}
+
+std::string BlobArchive::GetName() const {
+    return "BlobArchive: " + state->mount_point;
+}
+
+ResultVal<std::unique_ptr<FileBackend>> BlobArchive::OpenFile(const Path& path,
+                                                              const Mode& mode) const {
+    LOG_DEBUG(Service_FS, "called path={} mode={:01X}", path.DebugStr(), mode.hex);
+
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    if (mode.hex == 0) {
+        LOG_ERROR(Service_FS, "Empty open mode");
+        return ERROR_UNSUPPORTED_OPEN_FLAGS;
+    }
+
+    if (mode.create_flag && (!mode.write_flag || options.fixed_size_files)) {
+        LOG_ERROR(Service_FS, "Unsupported create flag");
+        return ERROR_UNSUPPORTED_OPEN_FLAGS;
+    }
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state->GetStatus(node_path)) {
+    case Status::PathNotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+    case Status::DirectoryFound:
+        LOG_ERROR(Service_FS, "Unexpected file or directory in {}", node_path);
+        return ERROR_UNEXPECTED_FILE_OR_DIRECTORY;
+    case Status::NotFound: {
+        if (!mode.create_flag) {
+            LOG_ERROR(Service_FS, "Non-existing file {} can't be open without mode create.",
+                      node_path);
+            return ERROR_FILE_NOT_FOUND;
+        }
+        const auto node = state->CreateLocalFile();
+        if (!node) {
+            LOG_ERROR(Service_FS, "Could not create {}", node_path);
+            return ERROR_FILE_NOT_FOUND;
+        }
+        state->nodes.emplace(node_path, *node);
+        state->Save();
+        break;
+    }
+    case Status::FileFound:
+        break; // Expected 'success' case
+    }
+
+    // Like ExtSaveData, archives with fixed size files always open them with read+write access
+    Mode file_mode;
+    file_mode.hex = mode.hex;
+    if (options.fixed_size_files) {
+        file_mode.hex = 0;
+        file_mode.read_flag.Assign(1);
+        file_mode.write_flag.Assign(1);
+    }
+
+    // Blobs are never modified, the file is copied out of the store once it gets written to
+    const Node& node = state->nodes.at(node_path);
+    const bool writable = file_mode.write_flag && node.type != Node::Type::Blob;
+    const auto host_path = state->GetHostPath(node);
+    FileUtil::IOFile file(host_path, writable ? "r+b" : "rb");
+    if (!file.IsOpen()) {
+        LOG_CRITICAL(Service_FS, "Could not open {} of {}", host_path, node_path);
+        return ERROR_FILE_NOT_FOUND;
+    }
+
+    auto blob_file = std::make_unique<BlobFile>(state, node_path, node, std::move(file), file_mode,
+                                                options.fixed_size_files);
+    return MakeResult<std::unique_ptr<FileBackend>>(std::move(blob_file));
+}
+
+ResultCode BlobArchive::DeleteFile(const Path& path) const {
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state->GetStatus(node_path)) {
+    case Status::PathNotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+    case Status::DirectoryFound:
+    case Status::NotFound:
+        LOG_ERROR(Service_FS, "File not found {}", node_path);
+        return ERROR_FILE_NOT_FOUND;
+    case Status::FileFound:
+        break; // Expected 'success' case
+    }
+
+    state->RemoveTree(node_path);
+    state->Save();
+    return RESULT_SUCCESS;
+}
+
+/// Shared by RenameFile and RenameDirectory, the source must be of the expected type
+static ResultCode RenameHelper(BlobArchive::State& state, const Path& src_path,
+                               const Path& dest_path, Status expected_status) {
+    const PathParser path_parser_src(src_path);
+
+    // TODO: Verify these return codes with HW
+    if (!path_parser_src.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid src path {}", src_path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    const PathParser path_parser_dest(dest_path);
+
+    if (!path_parser_dest.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid dest path {}", dest_path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    const auto src_node_path = GetNodePath(path_parser_src);
+    const auto dest_node_path = GetNodePath(path_parser_dest);
+
+    // Same result as the host rename of SaveDataArchive when it fails
+    const ResultCode failed(ErrorDescription::NoData, ErrorModule::FS,
+                            ErrorSummary::NothingHappened, ErrorLevel::Status);
+    if (state.GetStatus(src_node_path) != expected_status ||
+        state.GetStatus(GetParentPath(dest_node_path)) != Status::DirectoryFound ||
+        IsInDirectory(dest_node_path, src_node_path)) {
+        return failed;
+    }
+
+    const Status dest_status = state.GetStatus(dest_node_path);
+    if (dest_status == Status::DirectoryFound) {
+        return failed;
+    }
+    if (dest_status == Status::FileFound) {
+        // Renaming a file over another one replaces it, as on the host
+        if (expected_status != Status::FileFound) {
+            return failed;
+        }
+        state.RemoveTree(dest_node_path);
+    }
+
+    state.MoveTree(src_node_path, dest_node_path);
+    state.Save();
+    return RESULT_SUCCESS;
+}
+
+ResultCode BlobArchive::RenameFile(const Path& src_path, const Path& dest_path) const {
+    return RenameHelper(*state, src_path, dest_path, Status::FileFound);
+}
+
+static ResultCode DeleteDirectoryHelper(BlobArchive::State& state, const Path& path,
+                                        bool recursive) {
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    if (path_parser.IsRootDirectory())
+        return ERROR_DIRECTORY_NOT_EMPTY;
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state.GetStatus(node_path)) {
+    case Status::PathNotFound:
+    case Status::NotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+    case Status::FileFound:
+        LOG_ERROR(Service_FS, "Unexpected file or directory {}", node_path);
+        return ERROR_UNEXPECTED_FILE_OR_DIRECTORY;
+    case Status::DirectoryFound:
+        break; // Expected 'success' case
+    }
+
+    if (!recursive) {
+        bool empty = true;
+        state.ForEachDescendant(node_path, [&empty](const std::string&, const Node&) {
+            empty = false;
+        });
+        if (!empty) {
+            LOG_ERROR(Service_FS, "Directory not empty {}", node_path);
+            return ERROR_DIRECTORY_NOT_EMPTY;
+        }
+    }
+
+    state.RemoveTree(node_path);
+    state.Save();
+    return RESULT_SUCCESS;
+}
+
+ResultCode BlobArchive::DeleteDirectory(const Path& path) const {
+    return DeleteDirectoryHelper(*state, path, false);
+}
+
+ResultCode BlobArchive::DeleteDirectoryRecursively(const Path& path) const {
+    return DeleteDirectoryHelper(*state, path, true);
+}
+
+ResultCode BlobArchive::CreateFile(const FileSys::Path& path, u64 size) const {
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    if (size == 0 && options.fixed_size_files) {
+        LOG_ERROR(Service_FS, "Zero-size file is not supported");
+        return ERROR_UNSUPPORTED_OPEN_FLAGS;
+    }
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state->GetStatus(node_path)) {
+    case Status::PathNotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+        LOG_ERROR(Service_FS, "Unexpected file in path {}", node_path);
+        return ERROR_UNEXPECTED_FILE_OR_DIRECTORY;
+    case Status::DirectoryFound:
+    case Status::FileFound:
+        LOG_ERROR(Service_FS, "{} already exists", node_path);
+        return ERROR_FILE_ALREADY_EXISTS;
+    case Status::NotFound:
+        break; // Expected 'success' case
+    }
+
+    const auto node = state->CreateLocalFile();
+    if (!node) {
+        LOG_ERROR(Service_FS, "Could not create {}", node_path);
+        return ERROR_INSUFFICIENT_SPACE;
+    }
+
+    if (size != 0) {
+        // Creates a sparse file (or a normal file on filesystems without the concept of sparse
+        // files), in the same way as SaveDataArchive
+        FileUtil::IOFile file(state->GetLocalPath(node->local_id), "wb");
+        if (!file.Seek(size - 1, SEEK_SET) || file.WriteBytes("", 1) != 1) {
+            file.Close();
+            FileUtil::Delete(state->GetLocalPath(node->local_id));
+            LOG_ERROR(Service_FS, "Too large file");
+            return ResultCode(ErrorDescription::TooLarge, ErrorModule::FS,
+                              ErrorSummary::OutOfResource, ErrorLevel::Info);
+        }
+    }
+
+    state->nodes.emplace(node_path, *node);
+    state->Save();
+    return RESULT_SUCCESS;
+}
+
+ResultCode BlobArchive::CreateDirectory(const Path& path) const {
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state->GetStatus(node_path)) {
+    case Status::PathNotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+        LOG_ERROR(Service_FS, "Unexpected file in path {}", node_path);
+        return ERROR_UNEXPECTED_FILE_OR_DIRECTORY;
+    case Status::DirectoryFound:
+    case Status::FileFound:
+        LOG_ERROR(Service_FS, "{} already exists", node_path);
+        return ERROR_DIRECTORY_ALREADY_EXISTS;
+    case Status::NotFound:
+        break; // Expected 'success' case
+    }
+
+    state->nodes.emplace(node_path, Node{});
+    state->Save();
+    return RESULT_SUCCESS;
+}
+
+ResultCode BlobArchive::RenameDirectory(const Path& src_path, const Path& dest_path) const {
+    return RenameHelper(*state, src_path, dest_path, Status::DirectoryFound);
+}
+
+ResultVal<std::unique_ptr<DirectoryBackend>> BlobArchive::OpenDirectory(const Path& path) const {
+    const PathParser path_parser(path);
+
+    if (!path_parser.IsValid()) {
+        LOG_ERROR(Service_FS, "Invalid path {}", path.DebugStr());
+        return ERROR_INVALID_PATH;
+    }
+
+    const auto node_path = GetNodePath(path_parser);
+
+    switch (state->GetStatus(node_path)) {
+    case Status::PathNotFound:
+    case Status::NotFound:
+        LOG_ERROR(Service_FS, "Path not found {}", node_path);
+        return ERROR_PATH_NOT_FOUND;
+    case Status::FileInPath:
+    case Status::FileFound:
+        LOG_ERROR(Service_FS, "Unexpected file in path {}", node_path);
+        return ERROR_UNEXPECTED_FILE_OR_DIRECTORY;
+    case Status::DirectoryFound:
+        break; // Expected 'success' case
+    }
+
+    FileUtil::FSTEntry directory{};
+    directory.isDirectory = true;
+    state->ForEachDescendant(node_path, [&](const std::string& child_path, const Node& node) {
+        if (GetParentPath(child_path) != node_path) {
+            return;
+        }
+        FileUtil::FSTEntry entry{};
+        entry.isDirectory = node.type == Node::Type::Directory;
+        entry.size = entry.isDirectory ? 0 : state->GetFileSize(node);
+        entry.physicalName = state->GetHostPath(node);
+        entry.virtualName = child_path.substr(child_path.rfind('/') + 1);
+        directory.children.push_back(std::move(entry));
+    });
+    directory.size = directory.children.size();
+
+    auto blob_directory = std::make_unique<DiskDirectory>(std::move(directory));
+    return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(blob_directory));
+}
+
+u64 BlobArchive::GetFreeBytes() const {
+    // TODO: Stubbed to return 1GiB, like SaveDataArchive
+    return 1024 * 1024 * 1024;
+}
+
+} // namespace FileSys
@@ -0,0 +1,112 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include "common/common_types.h"
+#include "core/file_sys/archive_backend.h"
+#include "core/file_sys/directory_backend.h"
+#include "core/file_sys/file_backend.h"
+#include "core/hle/result.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * A directory of immutable files named after the SHA-256 of their contents. A store can be shared
+ * by any number of BlobArchives, even from several processes at once, as blobs are never modified
+ * once they are written and identical files are only stored once.
+ */
+class BlobStore {
+public:
+    using Hash = std::array<u8, 32>;
+
+    explicit BlobStore(std::string root);
+
+    const std::string& GetRoot() const {
+        return root;
+    }
+
+    /// Returns the host path of the blob with the given hash
+    std::string GetBlobPath(const Hash& hash) const;
+
+    /**
+     * Adds a copy of a host file to the store, unless a blob with the same contents exists.
+     * @returns the hash of the file, or std::nullopt if it could not be read or stored
+     */
+    std::optional<Hash> AddFile(const std::string& host_path);
+
+private:
+    std::string root;
+};
+
+/**
+ * Archive backend keeping the files of an archive in a BlobStore. A manifest in the mount point
+ * maps the archive paths to blobs, so setting up another copy of an archive only takes a copy of
+ * the manifest. Files are only copied out of the store when they are first written to, and
+ * their modified version stays local to the mount point (copy-on-write).
+ *
+ * The mount point of a blob archive contains the manifest file (MANIFEST_NAME) and a directory
+ * with the modified files, its other contents are ignored.
+ */
+class BlobArchive : public ArchiveBackend {
+public:
+    static constexpr char MANIFEST_NAME[] = ".blob_manifest";
+
+    /// Options of the archive type the blob archive stands in for
+    struct Options {
+        /// Files keep the size they were created with, as in ExtSaveData
+        bool fixed_size_files = false;
+    };
+
+    /// Whether the mount point contains a blob archive manifest
+    static bool IsBlobArchive(const std::string& mount_point);
+
+    /**
+     * Opens the blob archive in a mount point.
+     * @returns the archive, or nullptr if its manifest is missing or invalid
+     */
+    static std::unique_ptr<BlobArchive> Open(const std::string& mount_point,
+                                             const Options& options);
+
+    /**
+     * Copies the contents of a host directory into a blob store and writes the manifest of a blob
+     * archive holding them into a mount point. The manifest can then be copied to set up more
+     * archives with the same contents.
+     * @returns false if a file could not be stored or the manifest could not be written
+     */
+    static bool Import(const std::string& source_directory, const std::string& store_root,
+                       const std::string& mount_point);
+
+    std::string GetName() const override;
+
+    ResultVal<std::unique_ptr<FileBackend>> OpenFile(const Path& path,
+                                                     const Mode& mode) const override;
+    ResultCode DeleteFile(const Path& path) const override;
+    ResultCode RenameFile(const Path& src_path, const Path& dest_path) const override;
+    ResultCode DeleteDirectory(const Path& path) const override;
+    ResultCode DeleteDirectoryRecursively(const Path& path) const override;
+    ResultCode CreateFile(const Path& path, u64 size) const override;
+    ResultCode CreateDirectory(const Path& path) const override;
+    ResultCode RenameDirectory(const Path& src_path, const Path& dest_path) const override;
+    ResultVal<std::unique_ptr<DirectoryBackend>> OpenDirectory(const Path& path) const override;
+    u64 GetFreeBytes() const override;
+
+    /// Manifest and location of the archive, shared with the files opened from it
+    struct State;
+
+private:
+    BlobArchive(std::shared_ptr<State> state, const Options& options);
+
+    std::shared_ptr<State> state;
+    Options options;
+};
+
+} // namespace FileSys
@@ -0,0 +1,335 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "common/logging/log.h"
+#include "common/lz4_compression.h"
+#include "common/swap.h"
+#include "core/file_sys/compressed_rom.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+
+// "CCRM" - Citra Compressed ROM
+constexpr u32 COMPRESSED_ROM_MAGIC = 0x4D524343;
+constexpr u32 COMPRESSED_ROM_VERSION = 1;
+
+/// Followed by the index, block_count + 1 offsets in the file
+struct Header {
+    u32_le magic;
+    u32_le version;
+    u32_le block_size;
+    u32_le block_count;
+    u64_le size;
+};
+static_assert(sizeof(Header) == 24, "Header has incorrect size");
+
+std::size_t ComputeBlockLength(u64 size, u32 block_size, std::size_t index) {
+    return static_cast<std::size_t>(
+        std::min<u64>(block_size, size - static_cast<u64>(index) * block_size));
+}
+
+bool ReadHeader(FileUtil::IOFile& file, Header& header) {
+    if (!file.Seek(0, SEEK_SET) || file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    return header.magic == COMPRESSED_ROM_MAGIC && header.version == COMPRESSED_ROM_VERSION &&
+           header.block_size != 0 &&
+           header.block_count == (header.size + header.block_size - 1) / header.block_size;
+}
+
+/**
+ * Reads the block stored at [begin, end) of a file into a buffer of its uncompressed length.
+ * Blocks that LZ4 can't shrink are stored as they are, which is when both lengths are equal.
+ */
+bool DecodeBlock(FileUtil::IOFile& file, u64 begin, u64 end, std::vector<u8>& stored, u8* dest,
+                 std::size_t length) {
+    if (end < begin || end - begin > length) {
+        return false;
+    }
+    const std::size_t stored_length = static_cast<std::size_t>(end - begin);
+    if (stored_length == length) {
+        return file.ReadAt(dest, length, begin) == length;
+    }
+    stored.resize(stored_length);
+    return file.ReadAt(stored.data(), stored_length, begin) == stored_length &&
+           Common::LZ4::DecompressBlock(stored.data(), stored_length, dest, length);
+}
+
+} // Anonymous namespace
+
+bool CompressedROM::IsCompressedROM(FileUtil::IOFile& file) {
+    Header header;
+    return ReadHeader(file, header);
+}
+
+std::unique_ptr<CompressedROM> CompressedROM::Open(FileUtil::IOFile&& file) {
+    Header header;
+    if (!ReadHeader(file, header)) {
+        LOG_ERROR(Service_FS, "Invalid compressed ROM header");
+        return nullptr;
+    }
+
+    std::vector<u64_le> stored_index(header.block_count + 1);
+    const std::size_t index_size = stored_index.size() * sizeof(u64_le);
+    if (file.ReadBytes(stored_index.data(), index_size) != index_size) {
+        LOG_ERROR(Service_FS, "Could not read the compressed ROM index");
+        return nullptr;
+    }
+
+    // Checked once here so that reads can trust the index
+    const u64 file_size = file.GetSize();
+    std::vector<u64> index(stored_index.begin(), stored_index.end());
+    for (std::size_t i = 0; i < header.block_count; ++i) {
+        if (index[i + 1] < index[i] || index[i + 1] > file_size ||
+            index[i + 1] - index[i] > ComputeBlockLength(header.size, header.block_size, i)) {
+            LOG_ERROR(Service_FS, "Invalid compressed ROM index entry {}", i);
+            return nullptr;
+        }
+    }
+
+    return std::unique_ptr<CompressedROM>(
+        new CompressedROM(std::move(file), header.size, header.block_size, std::move(index)));
+}
+
+std::size_t CompressedROM::Peek(FileUtil::IOFile& file, u64 offset, std::size_t length,
+                                u8* buffer) {
+    Header header;
+    if (!ReadHeader(file, header) || offset >= header.size) {
+        return 0;
+    }
+    length = static_cast<std::size_t>(std::min<u64>(length, header.size - offset));
+
+    std::vector<u8> stored;
+    std::vector<u8> block;
+    std::size_t read_length = 0;
+    while (read_length < length) {
+        const u64 current = offset + read_length;
+        const std::size_t index = static_cast<std::size_t>(current / header.block_size);
+        const std::size_t block_offset = static_cast<std::size_t>(current % header.block_size);
+
+        std::array<u64_le, 2> bounds;
+        if (file.ReadAt(bounds.data(), sizeof(bounds), sizeof(Header) + index * sizeof(u64_le)) !=
+            sizeof(bounds)) {
+            break;
+        }
+        block.resize(ComputeBlockLength(header.size, header.block_size, index));
+        if (!DecodeBlock(file, bounds[0], bounds[1], stored, block.data(), block.size())) {
+            break;
+        }
+
+        const std::size_t copy_length = std::min(length - read_length, block.size() - block_offset);
+        std::memcpy(buffer + read_length, block.data() + block_offset, copy_length);
+        read_length += copy_length;
+    }
+    return read_length;
+}
+
+bool CompressedROM::Create(const std::string& source_path, const std::string& dest_path,
+                           u32 block_size) {
+    FileUtil::IOFile source(source_path, "rb");
+    if (!source.IsOpen() || block_size == 0) {
+        LOG_ERROR(Service_FS, "Could not open {}", source_path);
+        return false;
+    }
+    FileUtil::IOFile dest(dest_path, "wb");
+    if (!dest.IsOpen()) {
+        LOG_ERROR(Service_FS, "Could not create {}", dest_path);
+        return false;
+    }
+
+    Header header{};
+    header.magic = COMPRESSED_ROM_MAGIC;
+    header.version = COMPRESSED_ROM_VERSION;
+    header.block_size = block_size;
+    header.size = source.GetSize();
+    header.block_count = static_cast<u32>((header.size + block_size - 1) / block_size);
+
+    // The index is written last, once the location of every block is known
+    std::vector<u64_le> index(header.block_count + 1);
+    const std::size_t index_size = index.size() * sizeof(u64_le);
+    u64 offset = sizeof(Header) + index_size;
+    bool success = dest.Seek(offset, SEEK_SET);
+
+    std::vector<u8> block(block_size);
+    for (std::size_t i = 0; success && i < header.block_count; ++i) {
+        const std::size_t length = ComputeBlockLength(header.size, block_size, i);
+        if (source.ReadBytes(block.data(), length) != length) {
+            success = false;
+            break;
+        }
+
+        const std::vector<u8> compressed = Common::LZ4::CompressBlock(block.data(), length);
+        const bool store_raw = compressed.size() >= length;
+        const u8* data = store_raw ? block.data() : compressed.data();
+        const std::size_t stored_length = store_raw ? length : compressed.size();
+        index[i] = offset;
+        success = dest.WriteBytes(data, stored_length) == stored_length;
+        offset += stored_length;
+    }
+    index[header.block_count] = offset;
+
+    success = success && dest.Seek(0, SEEK_SET) &&
+              dest.WriteBytes(&header, sizeof(header)) == sizeof(header) &&
+              dest.WriteBytes(index.data(), index_size) == index_size;
+    dest.Close();
+    if (!success) {
+        LOG_ERROR(Service_FS, "Could not compress {} into {}", source_path, dest_path);
+        FileUtil::Delete(dest_path);
+        return false;
+    }
+
+    LOG_INFO(Service_FS, "Compressed {} from {} to {} bytes", source_path, header.size, offset);
+    return true;
+}
+
+CompressedROM::CompressedROM(FileUtil::IOFile&& file, u64 size, u32 block_size,
+                             std::vector<u64>&& index)
+    : file(std::move(file)), size(size), block_size(block_size), index(std::move(index)) {}
+
+CompressedROM::~CompressedROM() = default;
+
+std::size_t CompressedROM::GetBlockLength(std::size_t index) const {
+    return ComputeBlockLength(size, block_size, index);
+}
+
+bool CompressedROM::LoadBlock(std::size_t index, u8* dest) {
+    return DecodeBlock(file, this->index[index], this->index[index + 1], stored, dest,
+                       GetBlockLength(index));
+}
+
+const CompressedROM::CachedBlock* CompressedROM::GetBlock(std::size_t index) {
+    const auto it = std::find_if(cache.begin(), cache.end(), [index](const CachedBlock& block) {
+        return block.index == index;
+    });
+    if (it != cache.end()) {
+        cache.splice(cache.begin(), cache, it);
+        return &cache.front();
+    }
+
+    // Reuse the storage of the least recently used block once the cache is full
+    if (cache.size() < MAX_CACHED_BLOCKS) {
+        cache.emplace_front();
+    } else {
+        cache.splice(cache.begin(), cache, std::prev(cache.end()));
+    }
+    CachedBlock& block = cache.front();
+    block.index = index;
+    block.data.resize(GetBlockLength(index));
+    if (!LoadBlock(index, block.data.data())) {
+        LOG_ERROR(Service_FS, "Could not decompress block {} of a compressed ROM", index);
+        cache.pop_front();
+        return nullptr;
+    }
+    return &block;
+}
+
+std::size_t CompressedROM::Read(u64 offset, std::size_t length, u8* buffer) {
+    if (offset >= size) {
+        return 0;
+    }
+    length = static_cast<std::size_t>(std::min<u64>(length, size - offset));
+
+    std::size_t read_length = 0;
+    while (read_length < length) {
+        const u64 current = offset + read_length;
+        const std::size_t index = static_cast<std::size_t>(current / block_size);
+        const std::size_t block_offset = static_cast<std::size_t>(current % block_size);
+        const std::size_t block_length = GetBlockLength(index);
+        const std::size_t copy_length = std::min(length - read_length, block_length - block_offset);
+
+        // Blocks read whole are mostly streamed once, they skip the cache unless already in it
+        const bool whole_block = block_offset == 0 && copy_length == block_length;
+        const bool cached = std::any_of(cache.begin(), cache.end(), [index](const CachedBlock& b) {
+            return b.index == index;
+        });
+        if (whole_block && !cached) {
+            if (!LoadBlock(index, buffer + read_length)) {
+                LOG_ERROR(Service_FS, "Could not decompress block {} of a compressed ROM", index);
+                break;
+            }
+        } else {
+            const CachedBlock* block = GetBlock(index);
+            if (!block) {
+                break;
+            }
+            std::memcpy(buffer + read_length, block->data.data() + block_offset, copy_length);
+        }
+        read_length += copy_length;
+    }
+    return read_length;
+}
+
+ROMFile::ROMFile() = default;
+
+ROMFile::ROMFile(const std::string& path) : ROMFile(FileUtil::IOFile(path, "rb")) {}
+
+ROMFile::ROMFile(FileUtil::IOFile&& file) {
+    if (!file.IsOpen()) {
+        return;
+    }
+    const u64 file_position = file.Tell();
+    if (CompressedROM::IsCompressedROM(file)) {
+        compressed = CompressedROM::Open(std::move(file));
+        return;
+    }
+    file.Seek(file_position, SEEK_SET);
+    this->file = std::move(file);
+}
+
+ROMFile::~ROMFile() = default;
+
+ROMFile::ROMFile(ROMFile&& other) = default;
+
+ROMFile& ROMFile::operator=(ROMFile&& other) = default;
+
+u64 ROMFile::GetSize() const {
+    return compressed ? compressed->GetSize() : file.GetSize();
+}
+
+bool ROMFile::Seek(s64 offset, int origin) {
+    if (!compressed) {
+        return file.Seek(offset, origin);
+    }
+
+    s64 base = 0;
+    if (origin == SEEK_CUR) {
+        base = static_cast<s64>(position);
+    } else if (origin == SEEK_END) {
+        base = static_cast<s64>(compressed->GetSize());
+    }
+    if (base + offset < 0) {
+        return false;
+    }
+    position = static_cast<u64>(base + offset);
+    return true;
+}
+
+u64 ROMFile::Tell() const {
+    return compressed ? position : file.Tell();
+}
+
+std::size_t ROMFile::ReadAt(void* data, std::size_t length, u64 offset) {
+    if (!compressed) {
+        return file.ReadAt(data, length, offset);
+    }
+    return compressed->Read(offset, length, static_cast<u8*>(data));
+}
+
+std::size_t ROMFile::ReadBytes(void* data, std::size_t length) {
+    if (!compressed) {
+        return file.ReadBytes(static_cast<u8*>(data), length);
+    }
+    const std::size_t read_length = compressed->Read(position, length, static_cast<u8*>(data));
+    position += read_length;
+    return read_length;
+}
+
+} // namespace FileSys
@@ -0,0 +1,130 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * A ROM dump (CCI or CXI) split into fixed-size blocks that are compressed independently with LZ4,
+ * followed by an index of where each block is stored. Any range of the dump can be read by only
+ * decompressing the blocks it covers, and recently used blocks are kept decompressed, as titles
+ * tend to read the same regions of their RomFS many times.
+ */
+class CompressedROM {
+public:
+    /// Large enough to compress well, small enough for random reads not to decompress much extra
+    static constexpr u32 DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    /// Whether a file is a compressed ROM, this leaves the file position undefined
+    static bool IsCompressedROM(FileUtil::IOFile& file);
+
+    /**
+     * Opens a compressed ROM.
+     * @returns the compressed ROM, or nullptr if the file isn't a valid one
+     */
+    static std::unique_ptr<CompressedROM> Open(FileUtil::IOFile&& file);
+
+    /**
+     * Reads from a compressed ROM without opening it, which is enough to identify its contents.
+     * @returns the number of bytes read, 0 if the file isn't a valid compressed ROM
+     */
+    static std::size_t Peek(FileUtil::IOFile& file, u64 offset, std::size_t length, u8* buffer);
+
+    /**
+     * Compresses a ROM dump into a new file.
+     * @returns false if the dump could not be read or the compressed ROM could not be written
+     */
+    static bool Create(const std::string& source_path, const std::string& dest_path,
+                       u32 block_size = DEFAULT_BLOCK_SIZE);
+
+    ~CompressedROM();
+
+    /// Size of the uncompressed dump
+    u64 GetSize() const {
+        return size;
+    }
+
+    /// Reads from the uncompressed dump, returns the number of bytes read
+    std::size_t Read(u64 offset, std::size_t length, u8* buffer);
+
+private:
+    /// Maximum number of blocks kept decompressed
+    static constexpr std::size_t MAX_CACHED_BLOCKS = 16;
+
+    struct CachedBlock {
+        std::size_t index;
+        std::vector<u8> data;
+    };
+
+    CompressedROM(FileUtil::IOFile&& file, u64 size, u32 block_size, std::vector<u64>&& index);
+
+    std::size_t GetBlockLength(std::size_t index) const;
+
+    /// Decompresses a block into a buffer of GetBlockLength(index) bytes
+    bool LoadBlock(std::size_t index, u8* dest);
+
+    /// Returns the block with the given index, decompressing it into the cache if needed
+    const CachedBlock* GetBlock(std::size_t index);
+
+    FileUtil::IOFile file;
+    u64 size;
+    u32 block_size;
+    /// Offsets in the file where each block starts, followed by where the last one ends
+    std::vector<u64> index;
+    /// Compressed data of the block being loaded, kept to save allocations
+    std::vector<u8> stored;
+    /// Most recently used block first
+    std::list<CachedBlock> cache;
+};
+
+/**
+ * A ROM dump opened for reading, which may be a plain file or a CompressedROM. This has the subset
+ * of the FileUtil::IOFile interface the loaders use, so that they read both transparently.
+ */
+class ROMFile {
+public:
+    ROMFile();
+    explicit ROMFile(const std::string& path);
+    explicit ROMFile(FileUtil::IOFile&& file);
+    ~ROMFile();
+
+    ROMFile(ROMFile&& other);
+    ROMFile& operator=(ROMFile&& other);
+
+    bool IsOpen() const {
+        return file.IsOpen() || compressed != nullptr;
+    }
+
+    bool IsCompressed() const {
+        return compressed != nullptr;
+    }
+
+    u64 GetSize() const;
+    bool Seek(s64 offset, int origin);
+    u64 Tell() const;
+    std::size_t ReadBytes(void* data, std::size_t length);
+
+    /// Reads from an offset without using the read position, see FileUtil::IOFile::ReadAt
+    std::size_t ReadAt(void* data, std::size_t length, u64 offset);
+
+private:
+    /// The plain file, unused when the ROM is compressed
+    FileUtil::IOFile file;
+    std::unique_ptr<CompressedROM> compressed;
+    /// Read position in the uncompressed dump
+    u64 position = 0;
+};
+
+} // namespace FileSys
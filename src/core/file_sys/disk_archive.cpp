@@ -10,6 +10,7 @@
 #include "common/logging/log.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -21,8 +22,7 @@ ResultVal<std::size_t> DiskFile::Read(const u64 offset, const std::size_t length
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    return MakeResult<std::size_t>(file->ReadBytes(buffer, length));
+    return MakeResult<std::size_t>(file->ReadAt(buffer, length, offset));
 }
 
 ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t length, const bool flush,
@@ -30,10 +30,10 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    std::size_t written = file->WriteBytes(buffer, length);
+    std::size_t written = file->WriteAt(buffer, length, offset);
     if (flush)
         file->Flush();
+    InvalidateMetadata();
     return MakeResult<std::size_t>(written);
 }
 
@@ -44,9 +44,16 @@ u64 DiskFile::GetSize() const {
 bool DiskFile::SetSize(const u64 size) const {
     file->Resize(size);
     file->Flush();
+    InvalidateMetadata();
     return true;
 }
 
+void DiskFile::InvalidateMetadata() const {
+    if (metadata_cache != nullptr) {
+        metadata_cache->InvalidateParentListing(host_path);
+    }
+}
+
 bool DiskFile::Close() const {
     return file->Close();
 }
@@ -60,6 +67,10 @@ DiskDirectory::DiskDirectory(const std::string& path) {
     children_iterator = directory.children.begin();
 }
 
+DiskDirectory::DiskDirectory(FileUtil::FSTEntry&& directory_) : directory(std::move(directory_)) {
+    children_iterator = directory.children.begin();
+}
+
 u32 DiskDirectory::Read(const u32 count, Entry* entries) {
     u32 entries_read = 0;
 
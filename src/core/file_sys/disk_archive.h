@@ -20,6 +20,8 @@
 
 namespace FileSys {
 
+class HostMetadataCache;
+
 class DiskFile : public FileBackend {
 public:
     DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
@@ -40,15 +42,28 @@ public:
         file->Flush();
     }
 
+    /// Keeps the listing of the directory of the file in the cache up to date with its size
+    void SetMetadataCache(HostMetadataCache& cache, std::string host_path) {
+        metadata_cache = &cache;
+        this->host_path = std::move(host_path);
+    }
+
 protected:
+    void InvalidateMetadata() const;
+
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+    HostMetadataCache* metadata_cache = nullptr;
+    std::string host_path;
 };
 
 class DiskDirectory : public DirectoryBackend {
 public:
     explicit DiskDirectory(const std::string& path);
 
+    /// Lists the children of an already scanned directory
+    explicit DiskDirectory(FileUtil::FSTEntry&& directory);
+
     ~DiskDirectory() override {
         Close();
     }
@@ -41,6 +41,14 @@ public:
     virtual ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                          const u8* buffer) = 0;
 
+    /**
+     * Hints that data is likely to be read soon, so that backends able to load it in the
+     * background can do so. Does nothing by default.
+     * @param offset Offset in bytes of the data
+     * @param length Length in bytes of the data
+     */
+    virtual void ReadAhead(u64 offset, std::size_t length) const {}
+
     /**
      * Get the amount of time a 3ds needs to read those data
      * @param length Length in bytes of data read from file
@@ -0,0 +1,120 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include "common/string_util.h"
+#include "core/file_sys/host_metadata_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+
+std::string GetParentPath(const std::string& path) {
+    const std::size_t pos = path.rfind('/');
+    return pos == std::string::npos ? std::string{} : path.substr(0, pos);
+}
+
+/// Erases the entry of path and the entries of everything under it
+template <typename Map>
+void EraseTree(Map& map, const std::string& path) {
+    map.erase(path);
+    const std::string prefix = path + '/';
+    auto it = map.lower_bound(prefix);
+    while (it != map.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        it = map.erase(it);
+    }
+}
+
+} // Anonymous namespace
+
+HostMetadataCache& HostMetadataCache::GetInstance() {
+    static HostMetadataCache cache;
+    return cache;
+}
+
+std::string HostMetadataCache::Normalize(const std::string& path) {
+    // ".." is resolved as well, so that "a/b/../c" and "a/c" invalidate each other
+    std::vector<std::string> components;
+    Common::SplitString(path, '/', components);
+    std::vector<std::string> resolved;
+    for (auto& component : components) {
+        if (component.empty() || component == ".") {
+            continue;
+        }
+        if (component == ".." && !resolved.empty() && resolved.back() != "..") {
+            resolved.pop_back();
+        } else {
+            resolved.push_back(std::move(component));
+        }
+    }
+
+    std::string normalized = !path.empty() && path[0] == '/' ? "/" : "";
+    for (std::size_t i = 0; i < resolved.size(); ++i) {
+        normalized += i == 0 ? resolved[i] : '/' + resolved[i];
+    }
+    return normalized.empty() ? "." : normalized;
+}
+
+HostMetadataCache::Kind HostMetadataCache::GetKind(const std::string& path) {
+    const std::string key = Normalize(path);
+    std::lock_guard lock{mutex};
+    const auto it = kinds.find(key);
+    if (it != kinds.end()) {
+        return it->second;
+    }
+
+    // The host is still given the original path, the key only identifies it
+    Kind kind = Kind::Missing;
+    if (FileUtil::IsDirectory(path)) {
+        kind = Kind::Directory;
+    } else if (FileUtil::Exists(path)) {
+        kind = Kind::File;
+    }
+    kinds.emplace(key, kind);
+    return kind;
+}
+
+FileUtil::FSTEntry HostMetadataCache::GetDirectory(const std::string& path) {
+    const std::string key = Normalize(path);
+    std::lock_guard lock{mutex};
+    const auto it = listings.find(key);
+    if (it != listings.end()) {
+        return it->second;
+    }
+
+    FileUtil::FSTEntry directory{};
+    directory.size = FileUtil::ScanDirectoryTree(path, directory);
+    directory.isDirectory = true;
+
+    // The scan also tells what the children are, which saves their lookups
+    for (const auto& child : directory.children) {
+        kinds[key + '/' + child.virtualName] = child.isDirectory ? Kind::Directory : Kind::File;
+    }
+    return listings.emplace(key, std::move(directory)).first->second;
+}
+
+void HostMetadataCache::Invalidate(const std::string& path) {
+    const std::string key = Normalize(path);
+    std::lock_guard lock{mutex};
+    EraseTree(kinds, key);
+    EraseTree(listings, key);
+    listings.erase(GetParentPath(key));
+}
+
+void HostMetadataCache::InvalidateParentListing(const std::string& path) {
+    const std::string key = Normalize(path);
+    std::lock_guard lock{mutex};
+    listings.erase(GetParentPath(key));
+}
+
+void HostMetadataCache::Clear() {
+    std::lock_guard lock{mutex};
+    kinds.clear();
+    listings.clear();
+}
+
+} // namespace FileSys
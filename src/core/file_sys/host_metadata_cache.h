@@ -0,0 +1,62 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * Cache of the host file system state seen by the archives backed by host directories (SDMC,
+ * SaveData, ExtSaveData and SystemSaveData): whether paths exist and are directories, and the
+ * listings of directories. Titles tend to look up and list the same paths many times in a row,
+ * each of which would otherwise cost a few stat calls or a directory scan.
+ *
+ * The cache is shared by all these archives since their mount points overlap (the SDMC archive
+ * contains the SaveData and ExtSaveData ones). They invalidate the paths they modify; code that
+ * modifies these host directories in other ways must invalidate them as well, or call Clear.
+ */
+class HostMetadataCache {
+public:
+    enum class Kind {
+        Missing,
+        File,
+        Directory,
+    };
+
+    static HostMetadataCache& GetInstance();
+
+    /// Returns what is at a host path
+    Kind GetKind(const std::string& path);
+
+    /// Returns the listing of a directory, as scanned by FileUtil::ScanDirectoryTree
+    FileUtil::FSTEntry GetDirectory(const std::string& path);
+
+    /// Forgets about a host path, everything under it and the listing of its parent directory
+    void Invalidate(const std::string& path);
+
+    /// Forgets the listing of the directory containing a file, after the size of the file changed
+    void InvalidateParentListing(const std::string& path);
+
+    /// Forgets everything
+    void Clear();
+
+private:
+    /// Cached host paths have no duplicate or trailing separators
+    static std::string Normalize(const std::string& path);
+
+    std::mutex mutex;
+    std::map<std::string, Kind> kinds;
+    std::map<std::string, FileUtil::FSTEntry> listings;
+};
+
+} // namespace FileSys
@@ -103,6 +103,10 @@ ResultVal<std::size_t> IVFCFile::Write(const u64 offset, const std::size_t lengt
     return MakeResult<std::size_t>(0);
 }
 
+void IVFCFile::ReadAhead(const u64 offset, const std::size_t length) const {
+    romfs_file->ReadAhead(offset, length);
+}
+
 u64 IVFCFile::GetSize() const {
     return romfs_file->GetSize();
 }
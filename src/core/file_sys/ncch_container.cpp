@@ -2,18 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 #include <memory>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
+#include <fmt/format.h>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/seed_db.h"
 #include "core/hw/aes/key.h"
+#include "core/hw/aes/stream.h"
 #include "core/loader/loader.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,15 +153,64 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
     return true;
 }
 
+/**
+ * Gets the path of the cached decompressed .code section of a title. The name includes the SHA-256
+ * of the compressed section from the ExeFS header, so that another version of the title never
+ * picks up a stale cache.
+ * @param program_id Program ID of the title
+ * @param section_hash Hash of the compressed section
+ * @return the path, or an empty string if the section has no hash
+ */
+static std::string GetCodeCachePath(u64 program_id, const u8* section_hash) {
+    constexpr std::size_t hash_size = 0x20;
+    if (std::all_of(section_hash, section_hash + hash_size, [](u8 b) { return b == 0; }))
+        return "";
+
+    std::string hash_string;
+    for (std::size_t i = 0; i < hash_size; ++i) {
+        hash_string += fmt::format("{:02x}", section_hash[i]);
+    }
+    return fmt::format("{}code/{:016X}_{}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id,
+                       hash_string);
+}
+
+static bool ReadCodeCache(const std::string& path, std::vector<u8>& buffer) {
+    FileUtil::IOFile cache_file(path, "rb");
+    if (!cache_file.IsOpen())
+        return false;
+
+    const std::size_t size = cache_file.GetSize();
+    buffer.resize(size);
+    return size != 0 && cache_file.ReadBytes(buffer.data(), size) == size;
+}
+
+static void WriteCodeCache(const std::string& path, const std::vector<u8>& buffer) {
+    // Written to a temporary file first, so that an interrupted write never leaves a short cache
+    const std::string temp_path = path + ".tmp";
+    FileUtil::CreateFullPath(temp_path);
+    {
+        FileUtil::IOFile cache_file(temp_path, "wb");
+        if (!cache_file.IsOpen())
+            return;
+        if (cache_file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
+            cache_file.Close();
+            FileUtil::Delete(temp_path);
+            return;
+        }
+    }
+    FileUtil::Rename(temp_path, path);
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset(ncch_offset), filepath(filepath) {
-    file = FileUtil::IOFile(filepath, "rb");
+    file = ROMFile(filepath);
 }
 
 Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 ncch_offset) {
     this->filepath = filepath;
     this->ncch_offset = ncch_offset;
-    file = FileUtil::IOFile(filepath, "rb");
+    file = ROMFile(filepath);
 
     if (!file.IsOpen()) {
         LOG_WARNING(Service_FS, "Failed to open {}", filepath);
@@ -170,156 +221,168 @@ Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 nc
     return Loader::ResultStatus::Success;
 }
 
-Loader::ResultStatus NCCHContainer::Load() {
-    LOG_INFO(Service_FS, "Loading NCCH from file {}", filepath);
-    if (is_loaded)
+Loader::ResultStatus NCCHContainer::LoadHeader() {
+    if (has_header || !file.IsOpen())
         return Loader::ResultStatus::Success;
 
-    if (file.IsOpen()) {
-        // Reset read pointer in case this file has been read before.
-        file.Seek(ncch_offset, SEEK_SET);
+    // Reset read pointer in case this file has been read before.
+    file.Seek(ncch_offset, SEEK_SET);
 
-        if (file.ReadBytes(&ncch_header, sizeof(NCCH_Header)) != sizeof(NCCH_Header))
-            return Loader::ResultStatus::Error;
+    if (file.ReadBytes(&ncch_header, sizeof(NCCH_Header)) != sizeof(NCCH_Header))
+        return Loader::ResultStatus::Error;
 
-        // Skip NCSD header and load first NCCH (NCSD is just a container of NCCH files)...
-        if (Loader::MakeMagic('N', 'C', 'S', 'D') == ncch_header.magic) {
-            LOG_DEBUG(Service_FS, "Only loading the first (bootable) NCCH within the NCSD file!");
-            ncch_offset += 0x4000;
-            file.Seek(ncch_offset, SEEK_SET);
-            file.ReadBytes(&ncch_header, sizeof(NCCH_Header));
-        }
+    // Skip NCSD header and load first NCCH (NCSD is just a container of NCCH files)...
+    if (Loader::MakeMagic('N', 'C', 'S', 'D') == ncch_header.magic) {
+        LOG_DEBUG(Service_FS, "Only loading the first (bootable) NCCH within the NCSD file!");
+        ncch_offset += 0x4000;
+        file.Seek(ncch_offset, SEEK_SET);
+        file.ReadBytes(&ncch_header, sizeof(NCCH_Header));
+    }
 
-        // Verify we are loading the correct file type...
-        if (Loader::MakeMagic('N', 'C', 'C', 'H') != ncch_header.magic)
-            return Loader::ResultStatus::ErrorInvalidFormat;
+    // Verify we are loading the correct file type...
+    if (Loader::MakeMagic('N', 'C', 'C', 'H') != ncch_header.magic)
+        return Loader::ResultStatus::ErrorInvalidFormat;
 
-        has_header = true;
-        bool failed_to_decrypt = false;
-        if (!ncch_header.no_crypto) {
-            is_encrypted = true;
+    if (!ncch_header.no_crypto) {
+        is_encrypted = true;
 
-            // Find primary and secondary keys
-            if (ncch_header.fixed_key) {
-                LOG_DEBUG(Service_FS, "Fixed-key crypto");
-                primary_key.fill(0);
-                secondary_key.fill(0);
-            } else {
-                using namespace HW::AES;
-                InitKeys();
-                std::array<u8, 16> key_y_primary, key_y_secondary;
+        // Find primary and secondary keys
+        if (ncch_header.fixed_key) {
+            LOG_DEBUG(Service_FS, "Fixed-key crypto");
+            primary_key.fill(0);
+            secondary_key.fill(0);
+        } else {
+            using namespace HW::AES;
+            InitKeys();
+            std::array<u8, 16> key_y_primary, key_y_secondary;
 
-                std::copy(ncch_header.signature, ncch_header.signature + key_y_primary.size(),
-                          key_y_primary.begin());
+            std::copy(ncch_header.signature, ncch_header.signature + key_y_primary.size(),
+                      key_y_primary.begin());
 
-                if (!ncch_header.seed_crypto) {
-                    key_y_secondary = key_y_primary;
+            if (!ncch_header.seed_crypto) {
+                key_y_secondary = key_y_primary;
+            } else {
+                auto opt{FileSys::GetSeed(ncch_header.program_id)};
+                if (!opt.has_value()) {
+                    LOG_ERROR(Service_FS, "Seed for program {:016X} not found",
+                              ncch_header.program_id);
+                    failed_to_decrypt = true;
                 } else {
-                    auto opt{FileSys::GetSeed(ncch_header.program_id)};
-                    if (!opt.has_value()) {
-                        LOG_ERROR(Service_FS, "Seed for program {:016X} not found",
-                                  ncch_header.program_id);
-                        failed_to_decrypt = true;
-                    } else {
-                        auto seed{*opt};
-                        std::array<u8, 32> input;
-                        std::memcpy(input.data(), key_y_primary.data(), key_y_primary.size());
-                        std::memcpy(input.data() + key_y_primary.size(), seed.data(), seed.size());
-                        CryptoPP::SHA256 sha;
-                        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
-                        sha.CalculateDigest(hash.data(), input.data(), input.size());
-                        std::memcpy(key_y_secondary.data(), hash.data(), key_y_secondary.size());
-                    }
+                    auto seed{*opt};
+                    std::array<u8, 32> input;
+                    std::memcpy(input.data(), key_y_primary.data(), key_y_primary.size());
+                    std::memcpy(input.data() + key_y_primary.size(), seed.data(), seed.size());
+                    CryptoPP::SHA256 sha;
+                    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+                    sha.CalculateDigest(hash.data(), input.data(), input.size());
+                    std::memcpy(key_y_secondary.data(), hash.data(), key_y_secondary.size());
                 }
+            }
 
-                SetKeyY(KeySlotID::NCCHSecure1, key_y_primary);
-                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure1)) {
-                    LOG_ERROR(Service_FS, "Secure1 KeyX missing");
+            SetKeyY(KeySlotID::NCCHSecure1, key_y_primary);
+            if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure1)) {
+                LOG_ERROR(Service_FS, "Secure1 KeyX missing");
+                failed_to_decrypt = true;
+            }
+            primary_key = GetNormalKey(KeySlotID::NCCHSecure1);
+
+            switch (ncch_header.secondary_key_slot) {
+            case 0:
+                LOG_DEBUG(Service_FS, "Secure1 crypto");
+                secondary_key = primary_key;
+                break;
+            case 1:
+                LOG_DEBUG(Service_FS, "Secure2 crypto");
+                SetKeyY(KeySlotID::NCCHSecure2, key_y_secondary);
+                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure2)) {
+                    LOG_ERROR(Service_FS, "Secure2 KeyX missing");
                     failed_to_decrypt = true;
                 }
-                primary_key = GetNormalKey(KeySlotID::NCCHSecure1);
-
-                switch (ncch_header.secondary_key_slot) {
-                case 0:
-                    LOG_DEBUG(Service_FS, "Secure1 crypto");
-                    secondary_key = primary_key;
-                    break;
-                case 1:
-                    LOG_DEBUG(Service_FS, "Secure2 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure2, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure2)) {
-                        LOG_ERROR(Service_FS, "Secure2 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure2);
-                    break;
-                case 10:
-                    LOG_DEBUG(Service_FS, "Secure3 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure3, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure3)) {
-                        LOG_ERROR(Service_FS, "Secure3 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure3);
-                    break;
-                case 11:
-                    LOG_DEBUG(Service_FS, "Secure4 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure4, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure4)) {
-                        LOG_ERROR(Service_FS, "Secure4 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure4);
-                    break;
+                secondary_key = GetNormalKey(KeySlotID::NCCHSecure2);
+                break;
+            case 10:
+                LOG_DEBUG(Service_FS, "Secure3 crypto");
+                SetKeyY(KeySlotID::NCCHSecure3, key_y_secondary);
+                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure3)) {
+                    LOG_ERROR(Service_FS, "Secure3 KeyX missing");
+                    failed_to_decrypt = true;
+                }
+                secondary_key = GetNormalKey(KeySlotID::NCCHSecure3);
+                break;
+            case 11:
+                LOG_DEBUG(Service_FS, "Secure4 crypto");
+                SetKeyY(KeySlotID::NCCHSecure4, key_y_secondary);
+                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure4)) {
+                    LOG_ERROR(Service_FS, "Secure4 KeyX missing");
+                    failed_to_decrypt = true;
                 }
+                secondary_key = GetNormalKey(KeySlotID::NCCHSecure4);
+                break;
             }
+        }
 
-            // Find CTR for each section
-            // Written with reference to
-            // https://github.com/d0k3/GodMode9/blob/99af6a73be48fa7872649aaa7456136da0df7938/arm9/source/game/ncch.c#L34-L52
-            if (ncch_header.version == 0 || ncch_header.version == 2) {
-                LOG_DEBUG(Loader, "NCCH version 0/2");
-                // In this version, CTR for each section is a magic number prefixed by partition ID
-                // (reverse order)
-                std::reverse_copy(ncch_header.partition_id, ncch_header.partition_id + 8,
-                                  exheader_ctr.begin());
-                exefs_ctr = romfs_ctr = exheader_ctr;
-                exheader_ctr[8] = 1;
-                exefs_ctr[8] = 2;
-                romfs_ctr[8] = 3;
-            } else if (ncch_header.version == 1) {
-                LOG_DEBUG(Loader, "NCCH version 1");
-                // In this version, CTR for each section is the section offset prefixed by partition
-                // ID, as if the entire NCCH image is encrypted using a single CTR stream.
-                std::copy(ncch_header.partition_id, ncch_header.partition_id + 8,
-                          exheader_ctr.begin());
-                exefs_ctr = romfs_ctr = exheader_ctr;
-                auto u32ToBEArray = [](u32 value) -> std::array<u8, 4> {
-                    return std::array<u8, 4>{
-                        static_cast<u8>(value >> 24),
-                        static_cast<u8>((value >> 16) & 0xFF),
-                        static_cast<u8>((value >> 8) & 0xFF),
-                        static_cast<u8>(value & 0xFF),
-                    };
+        // Find CTR for each section
+        // Written with reference to
+        // https://github.com/d0k3/GodMode9/blob/99af6a73be48fa7872649aaa7456136da0df7938/arm9/source/game/ncch.c#L34-L52
+        if (ncch_header.version == 0 || ncch_header.version == 2) {
+            LOG_DEBUG(Loader, "NCCH version 0/2");
+            // In this version, CTR for each section is a magic number prefixed by partition ID
+            // (reverse order)
+            std::reverse_copy(ncch_header.partition_id, ncch_header.partition_id + 8,
+                              exheader_ctr.begin());
+            exefs_ctr = romfs_ctr = exheader_ctr;
+            exheader_ctr[8] = 1;
+            exefs_ctr[8] = 2;
+            romfs_ctr[8] = 3;
+        } else if (ncch_header.version == 1) {
+            LOG_DEBUG(Loader, "NCCH version 1");
+            // In this version, CTR for each section is the section offset prefixed by partition
+            // ID, as if the entire NCCH image is encrypted using a single CTR stream.
+            std::copy(ncch_header.partition_id, ncch_header.partition_id + 8,
+                      exheader_ctr.begin());
+            exefs_ctr = romfs_ctr = exheader_ctr;
+            auto u32ToBEArray = [](u32 value) -> std::array<u8, 4> {
+                return std::array<u8, 4>{
+                    static_cast<u8>(value >> 24),
+                    static_cast<u8>((value >> 16) & 0xFF),
+                    static_cast<u8>((value >> 8) & 0xFF),
+                    static_cast<u8>(value & 0xFF),
                 };
-                auto offset_exheader = u32ToBEArray(0x200); // exheader offset
-                auto offset_exefs = u32ToBEArray(ncch_header.exefs_offset * kBlockSize);
-                auto offset_romfs = u32ToBEArray(ncch_header.romfs_offset * kBlockSize);
-                std::copy(offset_exheader.begin(), offset_exheader.end(),
-                          exheader_ctr.begin() + 12);
-                std::copy(offset_exefs.begin(), offset_exefs.end(), exefs_ctr.begin() + 12);
-                std::copy(offset_romfs.begin(), offset_romfs.end(), romfs_ctr.begin() + 12);
-            } else {
-                LOG_ERROR(Service_FS, "Unknown NCCH version {}", ncch_header.version);
-                failed_to_decrypt = true;
-            }
+            };
+            auto offset_exheader = u32ToBEArray(0x200); // exheader offset
+            auto offset_exefs = u32ToBEArray(ncch_header.exefs_offset * kBlockSize);
+            auto offset_romfs = u32ToBEArray(ncch_header.romfs_offset * kBlockSize);
+            std::copy(offset_exheader.begin(), offset_exheader.end(),
+                      exheader_ctr.begin() + 12);
+            std::copy(offset_exefs.begin(), offset_exefs.end(), exefs_ctr.begin() + 12);
+            std::copy(offset_romfs.begin(), offset_romfs.end(), romfs_ctr.begin() + 12);
         } else {
-            LOG_DEBUG(Service_FS, "No crypto");
-            is_encrypted = false;
+            LOG_ERROR(Service_FS, "Unknown NCCH version {}", ncch_header.version);
+            failed_to_decrypt = true;
         }
+    } else {
+        LOG_DEBUG(Service_FS, "No crypto");
+        is_encrypted = false;
+    }
+
+    has_header = true;
+    return Loader::ResultStatus::Success;
+}
+
+Loader::ResultStatus NCCHContainer::Load() {
+    LOG_INFO(Service_FS, "Loading NCCH from file {}", filepath);
+    if (is_loaded)
+        return Loader::ResultStatus::Success;
+
+    if (file.IsOpen()) {
+        Loader::ResultStatus result = LoadHeader();
+        if (result != Loader::ResultStatus::Success)
+            return result;
 
         // System archives and DLC don't have an extended header but have RomFS
         if (ncch_header.extended_header_size) {
+            // The header may have been loaded on its own earlier, and the file read since
+            file.Seek(ncch_offset + sizeof(NCCH_Header), SEEK_SET);
             if (file.ReadBytes(&exheader_header, sizeof(ExHeader_Header)) !=
                 sizeof(ExHeader_Header))
                 return Loader::ResultStatus::Error;
@@ -337,10 +400,8 @@ Loader::ResultStatus NCCHContainer::Load() {
                         LOG_ERROR(Service_FS, "Failed to decrypt");
                         return Loader::ResultStatus::ErrorEncrypted;
                     }
-                    CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exheader_header);
-                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(
-                        primary_key.data(), primary_key.size(), exheader_ctr.data())
-                        .ProcessData(data, data, sizeof(exheader_header));
+                    HW::AES::CTRDecryptor(primary_key, exheader_ctr)
+                        .Process(reinterpret_cast<u8*>(&exheader_header), sizeof(exheader_header));
                 }
             }
 
@@ -384,13 +445,11 @@ Loader::ResultStatus NCCHContainer::Load() {
                 return Loader::ResultStatus::Error;
 
             if (is_encrypted) {
-                CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exefs_header);
-                CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(primary_key.data(),
-                                                              primary_key.size(), exefs_ctr.data())
-                    .ProcessData(data, data, sizeof(exefs_header));
+                HW::AES::CTRDecryptor(primary_key, exefs_ctr)
+                    .Process(reinterpret_cast<u8*>(&exefs_header), sizeof(exefs_header));
             }
 
-            exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_file = ROMFile(filepath);
             has_exefs = true;
         }
 
@@ -419,7 +478,7 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
     std::string exefs_override = filepath + ".exefs";
     std::string exefsdir_override = filepath + ".exefsdir/";
     if (FileUtil::Exists(exefs_override)) {
-        exefs_file = FileUtil::IOFile(exefs_override, "rb");
+        exefs_file = ROMFile(exefs_override);
 
         if (exefs_file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) == sizeof(ExeFs_Header)) {
             LOG_DEBUG(Service_FS, "Loading ExeFS section from {}", exefs_override);
@@ -427,7 +486,7 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
             is_tainted = true;
             has_exefs = true;
         } else {
-            exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_file = ROMFile(filepath);
         }
     } else if (FileUtil::Exists(exefsdir_override) && FileUtil::IsDirectory(exefsdir_override)) {
         is_tainted = true;
@@ -496,11 +555,19 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 key = secondary_key;
             }
 
-            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
-                                                              exefs_ctr.data());
+            HW::AES::CTRDecryptor dec(key, exefs_ctr);
             dec.Seek(section.offset + sizeof(ExeFs_Header));
 
-            if (strcmp(section.name, ".code") == 0 && is_compressed) {
+            const bool is_code = strcmp(section.name, ".code") == 0;
+            // The hashes are stored in the reverse order of the sections
+            const u8* section_hash = exefs_header.hashes[kMaxSections - 1 - section_number];
+            const std::string code_cache_path =
+                is_code && is_compressed ? GetCodeCachePath(ncch_header.program_id, section_hash)
+                                         : "";
+
+            if (!code_cache_path.empty() && ReadCodeCache(code_cache_path, buffer)) {
+                LOG_DEBUG(Service_FS, "Loaded decompressed .code from {}", code_cache_path);
+            } else if (is_code && is_compressed) {
                 // Section is compressed, read compressed .code section...
                 std::unique_ptr<u8[]> temp_buffer;
                 try {
@@ -513,7 +580,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                     return Loader::ResultStatus::Error;
 
                 if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    dec.Process(&temp_buffer[0], section.size);
                 }
 
                 // Decompress .code section...
@@ -521,13 +588,17 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 buffer.resize(decompressed_size);
                 if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+
+                if (!code_cache_path.empty()) {
+                    WriteCodeCache(code_cache_path, buffer);
+                }
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
                 if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
                     return Loader::ResultStatus::Error;
                 if (is_encrypted) {
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
+                    dec.Process(&buffer[0], section.size);
                 }
             }
 
@@ -609,7 +680,7 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
         return Loader::ResultStatus::Error;
 
     // We reopen the file, to allow its position to be independent from file's
-    FileUtil::IOFile romfs_file_inner(filepath, "rb");
+    ROMFile romfs_file_inner(filepath);
     if (!romfs_file_inner.IsOpen())
         return Loader::ResultStatus::Error;
 
@@ -628,7 +699,7 @@ Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReade
     // Check for RomFS overrides
     std::string split_filepath = filepath + ".romfs";
     if (FileUtil::Exists(split_filepath)) {
-        FileUtil::IOFile romfs_file_inner(split_filepath, "rb");
+        ROMFile romfs_file_inner(split_filepath);
         if (romfs_file_inner.IsOpen()) {
             LOG_WARNING(Service_FS, "File {} overriding built-in RomFS", split_filepath);
             romfs_file = std::make_shared<RomFSReader>(std::move(romfs_file_inner), 0,
@@ -641,7 +712,7 @@ Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReade
 }
 
 Loader::ResultStatus NCCHContainer::ReadProgramId(u64_le& program_id) {
-    Loader::ResultStatus result = Load();
+    Loader::ResultStatus result = LoadHeader();
     if (result != Loader::ResultStatus::Success)
         return result;
 
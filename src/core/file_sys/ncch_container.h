@@ -209,6 +209,13 @@ public:
 
     Loader::ResultStatus OpenFile(const std::string& filepath, u32 ncch_offset = 0);
 
+    /**
+     * Ensure the NCCH header is loaded and the keys of the sections are known, without reading
+     * anything else. Enough for the queries that only need the header, like the program ID.
+     * @return ResultStatus result of function
+     */
+    Loader::ResultStatus LoadHeader();
+
     /**
      * Ensure ExeFS and exheader is loaded and ready for reading sections
      * @return ResultStatus result of function
@@ -304,6 +311,7 @@ private:
     bool is_compressed = false;
 
     bool is_encrypted = false;
+    bool failed_to_decrypt = false;
     // for decrypting exheader, exefs header and icon/banner section
     std::array<u8, 16> primary_key{};
     std::array<u8, 16> secondary_key{}; // for decrypting romfs and .code section
@@ -315,8 +323,8 @@ private:
     u32 exefs_offset = 0;
 
     std::string filepath;
-    FileUtil::IOFile file;
-    FileUtil::IOFile exefs_file;
+    ROMFile file;
+    ROMFile exefs_file;
 };
 
 } // namespace FileSys
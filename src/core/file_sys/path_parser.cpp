@@ -4,8 +4,10 @@
 
 #include <algorithm>
 #include <set>
+#include "common/assert.h"
 #include "common/file_util.h"
 #include "common/string_util.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 
 namespace FileSys {
@@ -85,6 +87,46 @@ PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point)
     return FileFound;
 }
 
+PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point,
+                                                HostMetadataCache& cache) const {
+    using Kind = HostMetadataCache::Kind;
+
+    // The host resolves ".." after the components before it, which have to be looked up as is
+    if (std::find(path_sequence.begin(), path_sequence.end(), "..") != path_sequence.end())
+        return GetHostStatus(mount_point);
+
+    auto path = mount_point;
+    if (cache.GetKind(path) != Kind::Directory)
+        return InvalidMountPoint;
+    if (path_sequence.empty()) {
+        return DirectoryFound;
+    }
+
+    for (auto iter = path_sequence.begin(); iter != path_sequence.end() - 1; iter++) {
+        if (path.back() != '/')
+            path += '/';
+        path += *iter;
+
+        const Kind kind = cache.GetKind(path);
+        if (kind == Kind::Missing)
+            return PathNotFound;
+        if (kind == Kind::Directory)
+            continue;
+        return FileInPath;
+    }
+
+    path += "/" + path_sequence.back();
+    switch (cache.GetKind(path)) {
+    case Kind::Missing:
+        return NotFound;
+    case Kind::Directory:
+        return DirectoryFound;
+    case Kind::File:
+        return FileFound;
+    }
+    UNREACHABLE();
+}
+
 std::string PathParser::BuildHostPath(const std::string& mount_point) const {
     std::string path = mount_point;
     for (auto& node : path_sequence) {
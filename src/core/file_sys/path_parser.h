@@ -10,6 +10,8 @@
 
 namespace FileSys {
 
+class HostMetadataCache;
+
 /**
  * A helper class parsing and verifying a string-type Path.
  * Every archives with a sub file system should use this class to parse the path argument and check
@@ -49,6 +51,9 @@ public:
     /// Checks the status of the specified file / directory by the Path on the host file system.
     HostStatus GetHostStatus(const std::string& mount_point) const;
 
+    /// Same as GetHostStatus, with the state of the host file system looked up in a cache
+    HostStatus GetHostStatus(const std::string& mount_point, HostMetadataCache& cache) const;
+
     /// Builds a full path on the host file system.
     std::string BuildHostPath(const std::string& mount_point) const;
 
@@ -1,22 +1,219 @@
 #include <algorithm>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread.h"
 #include "core/file_sys/romfs_reader.h"
 
 namespace FileSys {
 
+RomFSReader::RomFSReader(ROMFile&& file, std::size_t file_offset, std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size) {}
+
+RomFSReader::RomFSReader(ROMFile&& file, std::size_t file_offset, std::size_t data_size,
+                         const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
+                         std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size), decryptor(std::in_place, key, ctr) {}
+
+RomFSReader::~RomFSReader() {
+    {
+        std::lock_guard lock{mutex};
+        stop_read_ahead = true;
+        SaveTrace();
+    }
+    read_ahead_cv.notify_one();
+    if (read_ahead_thread.joinable()) {
+        read_ahead_thread.join();
+    }
+}
+
+std::size_t RomFSReader::ReadUncached(std::size_t offset, std::size_t length, u8* buffer) {
+    const std::size_t read_length = file.ReadAt(buffer, length, file_offset + offset);
+    if (is_encrypted && read_length != 0) {
+        decryptor->Seek(crypto_offset + offset);
+        decryptor->Process(buffer, read_length);
+    }
+    return read_length;
+}
+
+const RomFSReader::CachedBlock& RomFSReader::GetBlock(std::size_t index) {
+    const auto it = std::find_if(cache.begin(), cache.end(), [index](const CachedBlock& block) {
+        return block.index == index;
+    });
+    if (it != cache.end()) {
+        cache.splice(cache.begin(), cache, it);
+        return cache.front();
+    }
+
+    // Reuse the storage of the least recently used block once the cache is full
+    if (cache.size() < MAX_CACHED_BLOCKS) {
+        cache.emplace_front();
+    } else {
+        cache.splice(cache.begin(), cache, std::prev(cache.end()));
+    }
+    CachedBlock& block = cache.front();
+    const std::size_t offset = index * BLOCK_SIZE;
+    block.index = index;
+    block.data.resize(std::min(BLOCK_SIZE, data_size - offset));
+    block.data.resize(ReadUncached(offset, block.data.size(), block.data.data()));
+    return block;
+}
+
 std::size_t RomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
+    if (offset >= data_size)
+        return 0;
+    length = std::min(length, data_size - offset);
     if (length == 0)
         return 0; // Crypto++ does not like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
-    if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+
+    std::lock_guard lock{mutex};
+
+    if (!trace_path.empty()) {
+        TraceRead(offset / BLOCK_SIZE, (offset + length - 1) / BLOCK_SIZE);
+    }
+
+    // Large reads are mostly streamed once, caching them would only evict the useful blocks
+    if (length >= BLOCK_SIZE * 2) {
+        return ReadUncached(offset, length, buffer);
+    }
+
+    std::size_t read_length = 0;
+    while (read_length < length) {
+        const std::size_t current = offset + read_length;
+        const CachedBlock& block = GetBlock(current / BLOCK_SIZE);
+        const std::size_t block_offset = current % BLOCK_SIZE;
+        if (block_offset >= block.data.size()) {
+            break; // The file is shorter than expected
+        }
+        const std::size_t copy_length =
+            std::min(length - read_length, block.data.size() - block_offset);
+        std::memcpy(buffer + read_length, block.data.data() + block_offset, copy_length);
+        read_length += copy_length;
     }
     return read_length;
 }
 
+void RomFSReader::ReadAhead(std::size_t offset, std::size_t length) {
+    if (offset >= data_size || length == 0)
+        return;
+    length = std::min(length, data_size - offset);
+
+    std::lock_guard lock{mutex};
+    const std::size_t first_block = offset / BLOCK_SIZE;
+    const std::size_t last_block =
+        std::min((offset + length - 1) / BLOCK_SIZE, first_block + MAX_READ_AHEAD_BLOCKS - 1);
+    for (std::size_t index = first_block; index <= last_block; ++index) {
+        QueueReadAhead(index);
+    }
+}
+
+void RomFSReader::UseAccessTrace(std::string path) {
+    std::vector<u32_le> stored_trace;
+    FileUtil::IOFile trace_file(path, "rb");
+    if (trace_file.IsOpen()) {
+        stored_trace.resize(static_cast<std::size_t>(trace_file.GetSize() / sizeof(u32_le)));
+        const std::size_t size = stored_trace.size() * sizeof(u32_le);
+        if (trace_file.ReadBytes(stored_trace.data(), size) != size) {
+            stored_trace.clear();
+        }
+        trace_file.Close();
+    }
+
+    std::lock_guard lock{mutex};
+    previous_trace.assign(stored_trace.begin(), stored_trace.end());
+    previous_trace_positions.clear();
+    for (std::size_t i = 0; i < previous_trace.size(); ++i) {
+        previous_trace_positions.emplace(previous_trace[i], i);
+    }
+    LOG_DEBUG(Service_FS, "Reading ahead {} blocks from {}", previous_trace.size(), path);
+
+    trace_path = std::move(path);
+    trace.clear();
+    traced_blocks.clear();
+    for (std::size_t i = 0; i < std::min(previous_trace.size(), MAX_READ_AHEAD_BLOCKS); ++i) {
+        QueueReadAhead(previous_trace[i]);
+    }
+}
+
+bool RomFSReader::IsCached(std::size_t index) const {
+    return std::any_of(cache.begin(), cache.end(),
+                       [index](const CachedBlock& block) { return block.index == index; });
+}
+
+void RomFSReader::QueueReadAhead(std::size_t index) {
+    if (index * BLOCK_SIZE >= data_size || IsCached(index) ||
+        std::find(read_ahead_queue.begin(), read_ahead_queue.end(), index) !=
+            read_ahead_queue.end()) {
+        return;
+    }
+
+    // The oldest requests are the most likely to be stale, or read by now
+    if (read_ahead_queue.size() >= MAX_READ_AHEAD_BLOCKS) {
+        read_ahead_queue.pop_front();
+    }
+    read_ahead_queue.push_back(index);
+
+    if (!read_ahead_thread.joinable()) {
+        read_ahead_thread = std::thread([this] { ReadAheadLoop(); });
+    }
+    read_ahead_cv.notify_one();
+}
+
+void RomFSReader::TraceRead(std::size_t first_block, std::size_t last_block) {
+    for (std::size_t index = first_block; index <= last_block; ++index) {
+        if (!traced_blocks.insert(static_cast<u32>(index)).second)
+            continue;
+        trace.push_back(static_cast<u32>(index));
+
+        const auto it = previous_trace_positions.find(static_cast<u32>(index));
+        if (it == previous_trace_positions.end())
+            continue;
+        const std::size_t end =
+            std::min(previous_trace.size(), it->second + 1 + MAX_READ_AHEAD_BLOCKS);
+        for (std::size_t i = it->second + 1; i < end; ++i) {
+            QueueReadAhead(previous_trace[i]);
+        }
+    }
+
+    // The boot is over by then, later reads depend too much on what the player does
+    if (trace.size() >= MAX_TRACE_BLOCKS) {
+        SaveTrace();
+        trace_path.clear();
+        trace = {};
+        traced_blocks = {};
+        previous_trace = {};
+        previous_trace_positions = {};
+    }
+}
+
+void RomFSReader::SaveTrace() {
+    if (trace_path.empty() || trace.empty())
+        return;
+
+    const std::vector<u32_le> stored_trace(trace.begin(), trace.end());
+    const std::size_t size = stored_trace.size() * sizeof(u32_le);
+    FileUtil::CreateFullPath(trace_path);
+    FileUtil::IOFile trace_file(trace_path, "wb");
+    if (!trace_file.IsOpen() || trace_file.WriteBytes(stored_trace.data(), size) != size) {
+        LOG_WARNING(Service_FS, "Could not save the RomFS access trace to {}", trace_path);
+    }
+}
+
+void RomFSReader::ReadAheadLoop() {
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::IO};
+    std::unique_lock lock{mutex};
+    while (true) {
+        read_ahead_cv.wait(lock, [this] { return stop_read_ahead || !read_ahead_queue.empty(); });
+        if (stop_read_ahead)
+            return;
+
+        // The mutex stays held while the block loads, so reads wait for at most one block
+        const std::size_t index = read_ahead_queue.front();
+        read_ahead_queue.pop_front();
+        GetBlock(index);
+    }
+}
+
 } // namespace FileSys
@@ -1,22 +1,39 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "common/common_types.h"
-#include "common/file_util.h"
+#include "core/file_sys/compressed_rom.h"
+#include "core/hw/aes/stream.h"
 
 namespace FileSys {
 
+/**
+ * Reads (and decrypts, if needed) the RomFS of a title. Reads are served from a small LRU cache of
+ * decrypted blocks, since games tend to issue many small reads of the same region in a row that
+ * would otherwise each cost a seek, a read and a new cipher setup.
+ *
+ * Blocks can also be loaded into the cache ahead of time on a background thread, either when told
+ * that they are about to be read or as predicted by the access trace of a previous run.
+ */
 class RomFSReader {
 public:
-    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
+    RomFSReader(ROMFile&& file, std::size_t file_offset, std::size_t data_size);
 
-    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
+    RomFSReader(ROMFile&& file, std::size_t file_offset, std::size_t data_size,
                 const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                std::size_t crypto_offset);
+
+    ~RomFSReader();
 
     std::size_t GetSize() const {
         return data_size;
@@ -24,14 +41,77 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer);
 
+    /// Loads the blocks of [offset, offset + length) into the cache in the background
+    void ReadAhead(std::size_t offset, std::size_t length);
+
+    /**
+     * Reads ahead the blocks that the trace in a file saw being read, in the order they were read,
+     * and replaces that trace with the first blocks read from now on. Meant to be called when a
+     * title boots, as it reads mostly the same data in the same order every time.
+     */
+    void UseAccessTrace(std::string path);
+
 private:
+    /// Size of the blocks kept in the cache, reads are aligned to it
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+    /// Maximum number of blocks kept in the cache
+    static constexpr std::size_t MAX_CACHED_BLOCKS = 32;
+    /// Maximum number of blocks waiting to be read ahead, a quarter of the cache so that reading
+    /// ahead never evicts most of the blocks in use
+    static constexpr std::size_t MAX_READ_AHEAD_BLOCKS = MAX_CACHED_BLOCKS / 4;
+    /// Number of blocks recorded in an access trace, which covers the boot of most titles
+    static constexpr std::size_t MAX_TRACE_BLOCKS = 4096;
+
+    struct CachedBlock {
+        std::size_t index;
+        std::vector<u8> data;
+    };
+
+    /// Reads and decrypts the data at [offset, offset + length) straight from the file
+    std::size_t ReadUncached(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Returns the block with the given index, loading it into the cache if needed
+    const CachedBlock& GetBlock(std::size_t index);
+
+    bool IsCached(std::size_t index) const;
+
+    /// Queues a block to be read ahead, the mutex must be held
+    void QueueReadAhead(std::size_t index);
+
+    /// Records the blocks of a read into the trace, and reads ahead what the previous trace read
+    /// after them. The mutex must be held.
+    void TraceRead(std::size_t first_block, std::size_t last_block);
+
+    void SaveTrace();
+
+    void ReadAheadLoop();
+
     bool is_encrypted;
-    FileUtil::IOFile file;
-    std::array<u8, 16> key;
-    std::array<u8, 16> ctr;
+    ROMFile file;
     std::size_t file_offset;
-    std::size_t crypto_offset;
+    std::size_t crypto_offset = 0;
     std::size_t data_size;
+    /// Kept across reads, as setting up the cipher is more expensive than seeking it
+    std::optional<HW::AES::CTRDecryptor> decryptor;
+    /// Most recently used block first
+    std::list<CachedBlock> cache;
+    /// Files of the RomFS are read from the FS I/O thread as well as from the emulation thread
+    std::mutex mutex;
+
+    /// Started on the first read ahead, as most RomFS are never read from much
+    std::thread read_ahead_thread;
+    std::condition_variable read_ahead_cv;
+    std::deque<std::size_t> read_ahead_queue;
+    bool stop_read_ahead = false;
+
+    /// File the trace is saved to, empty when not tracing
+    std::string trace_path;
+    /// Blocks in the order they were first read
+    std::vector<u32> trace;
+    std::unordered_set<u32> traced_blocks;
+    /// Position of each block in the trace of the previous run
+    std::vector<u32> previous_trace;
+    std::unordered_map<u32, std::size_t> previous_trace_positions;
 };
 
 } // namespace FileSys
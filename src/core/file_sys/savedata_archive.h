@@ -8,6 +8,7 @@
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +39,7 @@ public:
 
 protected:
     std::string mount_point;
+    HostMetadataCache& metadata_cache = HostMetadataCache::GetInstance();
 };
 
 } // namespace FileSys
@@ -10,6 +10,26 @@
 #include "common/common_types.h"
 #include "core/frontend/framebuffer_layout.h"
 
+namespace Frontend {
+
+/**
+ * Hands the frames the renderer draws offscreen over to the frontend thread presenting them, when
+ * the frontend presents on a context of its own (see EmuWindow::IsPresentationDecoupled).
+ */
+class FrameMailbox {
+public:
+    virtual ~FrameMailbox() = default;
+
+    /**
+     * Draws the most recent frame to the framebuffer bound on the calling thread, which must have
+     * a context sharing objects with the renderer's current. Never waits for the renderer.
+     * @returns false if no frame has been rendered yet, in which case nothing was drawn
+     */
+    virtual bool TryPresent() = 0;
+};
+
+} // namespace Frontend
+
 /**
  * Abstraction class used to provide an interface between emulation code and the frontend
  * (e.g. SDL, QGLWidget, GLFW, etc...).
@@ -50,6 +70,32 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Whether the frontend presents frames itself, on a context sharing objects with the one
+     * MakeCurrent binds. The renderer then draws each frame into an offscreen framebuffer that it
+     * puts in the frame mailbox, and never calls SwapBuffers, so that the emulation thread can't
+     * block on the window system.
+     */
+    virtual bool IsPresentationDecoupled() const {
+        return false;
+    }
+
+    /**
+     * Called by the renderer on its thread when a new frame was put in the frame mailbox. Only
+     * used when presentation is decoupled.
+     */
+    virtual void OnFrameReady() {}
+
+    /// Sets the mailbox the renderer puts its frames in, the window owns it from then on
+    void SetFrameMailbox(std::unique_ptr<Frontend::FrameMailbox> mailbox) {
+        frame_mailbox = std::move(mailbox);
+    }
+
+    /// Returns the frame mailbox, or nullptr if presentation isn't decoupled
+    Frontend::FrameMailbox* GetFrameMailbox() const {
+        return frame_mailbox.get();
+    }
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
@@ -161,6 +207,8 @@ private:
     class TouchState;
     std::shared_ptr<TouchState> touch_state;
 
+    std::unique_ptr<Frontend::FrameMailbox> frame_mailbox;
+
     /**
      * Clip the provided coordinates to be inside the touchscreen area.
      */
@@ -20,6 +20,20 @@ u16 FramebufferLayout::GetScalingRatio() const {
     return static_cast<u16>(((top_screen.GetWidth() - 1) / Core::kScreenTopWidth) + 1);
 }
 
+static bool IsScreenVisible(const MathUtil::Rectangle<unsigned>& screen, unsigned width,
+                            unsigned height) {
+    return screen.left < screen.right && screen.top < screen.bottom && screen.left < width &&
+           screen.top < height;
+}
+
+bool FramebufferLayout::IsTopScreenVisible() const {
+    return top_screen_enabled && IsScreenVisible(top_screen, width, height);
+}
+
+bool FramebufferLayout::IsBottomScreenVisible() const {
+    return bottom_screen_enabled && IsScreenVisible(bottom_screen, width, height);
+}
+
 // Finds the largest size subrectangle contained in window area that is confined to the aspect ratio
 template <class T>
 static MathUtil::Rectangle<T> maxRectangle(MathUtil::Rectangle<T> window_area,
@@ -22,6 +22,12 @@ struct FramebufferLayout {
      * screen.
      */
     u16 GetScalingRatio() const;
+
+    /// Returns whether the top screen is enabled and has pixels inside the window
+    bool IsTopScreenVisible() const;
+
+    /// Returns whether the bottom screen is enabled and has pixels inside the window
+    bool IsBottomScreenVisible() const;
 };
 
 /**
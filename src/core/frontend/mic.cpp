@@ -0,0 +1,11 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/frontend/mic.h"
+
+namespace Frontend::Mic {
+
+Interface::~Interface() = default;
+
+} // namespace Frontend::Mic
@@ -0,0 +1,69 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include "common/common_types.h"
+#include "common/ring_buffer.h"
+
+namespace Frontend::Mic {
+
+/**
+ * A host microphone. The backend's capture thread pushes 16-bit mono samples into a lock-free
+ * ring, which MIC_U drains on the emulation thread, converting the samples right into the
+ * guest's shared memory.
+ */
+class Interface {
+public:
+    /// Number of samples the ring holds, about a third of a second at 48 kHz
+    static constexpr std::size_t RING_SIZE = 0x4000;
+
+    virtual ~Interface();
+
+    /**
+     * Starts capturing.
+     * @param sample_rate Rate requested by the guest, in Hz
+     * @returns The rate the samples will be pushed at, in Hz
+     */
+    virtual u32 StartSampling(u32 sample_rate) = 0;
+
+    /// Stops capturing
+    virtual void StopSampling() = 0;
+
+    /// Pushes captured samples, the ones that don't fit are dropped. Capture thread only.
+    std::size_t PushSamples(const s16* samples, std::size_t count) {
+        return ring.Push(samples, count);
+    }
+
+    /**
+     * Hands the captured samples to a function without copying them, see RingBuffer::Consume.
+     * Emulation thread only.
+     */
+    template <typename Func>
+    std::size_t ConsumeSamples(std::size_t max_count, Func&& func) {
+        return ring.Consume(max_count, std::forward<Func>(func));
+    }
+
+    /// Returns the number of captured samples waiting to be consumed
+    std::size_t GetSampleCount() const {
+        return ring.Size();
+    }
+
+private:
+    Common::RingBuffer<s16, RING_SIZE> ring;
+};
+
+/// A microphone that doesn't capture anything, MIC_U records silence from it
+class NullMic final : public Interface {
+public:
+    u32 StartSampling(u32 sample_rate) override {
+        return sample_rate;
+    }
+
+    void StopSampling() override {}
+};
+
+} // namespace Frontend::Mic
@@ -7,12 +7,15 @@
 #include <algorithm>
 #include <atomic>
 #include <climits>
+#include <condition_variable>
 #include <csignal>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <fcntl.h>
 #include <fmt/format.h>
 
@@ -122,6 +125,18 @@ constexpr char target_xml[] =
 
 int gdbserver_socket = -1;
 
+/// How long the socket watcher waits for data before checking whether it should stop
+constexpr long SOCKET_WATCH_TIMEOUT_US = 100000;
+
+// The socket is watched by a thread while a client is connected, so that the emulation thread only
+// checks a flag between its slices instead of polling the socket
+std::thread socket_watcher;
+std::mutex socket_watcher_mutex;
+std::condition_variable socket_watcher_cv;
+bool stop_socket_watcher = false;
+/// Set by the socket watcher when the client sent data, until the emulation thread reads a command
+std::atomic<bool> data_available{false};
+
 u8 command_buffer[GDB_BUFFER_SIZE];
 u32 command_length;
 
@@ -412,7 +427,7 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
     Core::System::GetInstance().Memory().WriteBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), bp->second.addr,
         bp->second.inst.data(), bp->second.inst.size());
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(bp->second.addr, bp->second.inst.size());
     p.erase(addr);
 }
 
@@ -679,27 +694,49 @@ static void ReadCommand() {
     SendPacket(GDB_STUB_ACK);
 }
 
-/// Check if there is data to be read from the gdb client.
-static bool IsDataAvailable() {
-    if (!IsConnected()) {
-        return false;
-    }
-
-    fd_set fd_socket;
+/// Waits for data from the gdb client and sets data_available, until stop_socket_watcher is set.
+static void WatchSocket(int client_socket) {
+    while (true) {
+        {
+            // The socket stays readable until the emulation thread reads the command
+            std::unique_lock lock{socket_watcher_mutex};
+            socket_watcher_cv.wait(lock, [] { return stop_socket_watcher || !data_available; });
+            if (stop_socket_watcher) {
+                return;
+            }
+        }
 
-    FD_ZERO(&fd_socket);
-    FD_SET(gdbserver_socket, &fd_socket);
+        fd_set fd_socket;
+        FD_ZERO(&fd_socket);
+        FD_SET(client_socket, &fd_socket);
 
-    struct timeval t;
-    t.tv_sec = 0;
-    t.tv_usec = 0;
+        struct timeval t;
+        t.tv_sec = 0;
+        t.tv_usec = SOCKET_WATCH_TIMEOUT_US;
 
-    if (select(gdbserver_socket + 1, &fd_socket, nullptr, nullptr, &t) < 0) {
-        LOG_ERROR(Debug_GDBStub, "select failed");
-        return false;
+        const int result = select(client_socket + 1, &fd_socket, nullptr, nullptr, &t);
+        if (result < 0) {
+            // Let the emulation thread read from the socket, which fails and shuts the stub down
+            LOG_ERROR(Debug_GDBStub, "select failed");
+            data_available = true;
+            return;
+        }
+        if (result > 0) {
+            data_available = true;
+        }
     }
+}
 
-    return FD_ISSET(gdbserver_socket, &fd_socket) != 0;
+static void StopSocketWatcher() {
+    if (!socket_watcher.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard lock{socket_watcher_mutex};
+        stop_socket_watcher = true;
+    }
+    socket_watcher_cv.notify_one();
+    socket_watcher.join();
 }
 
 /// Send requested register to gdb client.
@@ -866,7 +903,7 @@ static void WriteMemory() {
     GdbHexToMem(data.data(), len_pos + 1, len);
     Core::System::GetInstance().Memory().WriteBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), addr, data.data(), len);
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(addr, len);
     SendReply("OK");
 }
 
@@ -901,7 +938,6 @@ static void Continue() {
     memory_break = false;
     step_loop = false;
     halt_loop = false;
-    Core::CPU().ClearInstructionCache();
 }
 
 /**
@@ -925,7 +961,7 @@ static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len) {
     Core::System::GetInstance().Memory().WriteBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), addr, btrap.data(),
         btrap.size());
-    Core::CPU().ClearInstructionCache();
+    Core::CPU().InvalidateCacheRange(addr, btrap.size());
     p.insert({addr, breakpoint});
 
     LOG_DEBUG(Debug_GDBStub, "gdb: added {} breakpoint: {:08x} bytes at {:08x}\n",
@@ -1027,11 +1063,16 @@ void HandlePacket() {
         return;
     }
 
-    if (!IsDataAvailable()) {
+    if (!data_available.load(std::memory_order_acquire)) {
         return;
     }
 
     ReadCommand();
+    {
+        std::lock_guard lock{socket_watcher_mutex};
+        data_available = false;
+    }
+    socket_watcher_cv.notify_one();
     if (command_length == 0) {
         return;
     }
@@ -1181,6 +1222,10 @@ static void Init(u16 port) {
     } else {
         LOG_INFO(Debug_GDBStub, "Client connected.\n");
         saddr_client.sin_addr.s_addr = ntohl(saddr_client.sin_addr.s_addr);
+
+        stop_socket_watcher = false;
+        data_available = false;
+        socket_watcher = std::thread(WatchSocket, gdbserver_socket);
     }
 
     // Clean up temporary socket if it's still alive at this point.
@@ -1199,6 +1244,7 @@ void Shutdown() {
     }
 
     LOG_INFO(Debug_GDBStub, "Stopping GDB ...");
+    StopSocketWatcher();
     if (gdbserver_socket != -1) {
         shutdown(gdbserver_socket, SHUT_RDWR);
         gdbserver_socket = -1;
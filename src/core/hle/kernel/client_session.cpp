@@ -7,12 +7,24 @@
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/kernel/session.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
 
+static ObjectPool& client_session_pool =
+    *new ObjectPool{"ClientSession", sizeof(ClientSession), alignof(ClientSession)};
+
+void* ClientSession::operator new(std::size_t size) {
+    return client_session_pool.Allocate(size);
+}
+
+void ClientSession::operator delete(void* object) {
+    client_session_pool.Free(object);
+}
+
 ClientSession::ClientSession(KernelSystem& kernel) : Object(kernel) {}
 ClientSession::~ClientSession() {
     // This destructor will be called automatically when the last ClientSession handle is closed by
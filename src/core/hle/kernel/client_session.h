@@ -47,6 +47,9 @@ public:
 private:
     explicit ClientSession(KernelSystem& kernel);
     ~ClientSession() override;
+
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
 };
 
 } // namespace Kernel
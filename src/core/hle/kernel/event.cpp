@@ -8,10 +8,21 @@
 #include "common/assert.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
 
+static ObjectPool& event_pool = *new ObjectPool{"Event", sizeof(Event), alignof(Event)};
+
+void* Event::operator new(std::size_t size) {
+    return event_pool.Allocate(size);
+}
+
+void Event::operator delete(void* object) {
+    event_pool.Free(object);
+}
+
 Event::Event(KernelSystem& kernel) : WaitObject(kernel) {}
 Event::~Event() {}
 
@@ -43,6 +43,9 @@ private:
     explicit Event(KernelSystem& kernel);
     ~Event() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     ResetType reset_type; ///< Current ResetType
 
     bool signaled;    ///< Whether the event has already been signaled
@@ -32,11 +32,11 @@ ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     DEBUG_ASSERT(obj != nullptr);
 
     u16 slot = next_free_slot;
-    if (slot >= generations.size()) {
+    if (slot >= slots.size()) {
         LOG_ERROR(Kernel, "Unable to allocate Handle, too many slots in use.");
         return ERR_OUT_OF_HANDLES;
     }
-    next_free_slot = generations[slot];
+    next_free_slot = slots[slot].generation;
 
     u16 generation = next_generation++;
 
@@ -45,8 +45,8 @@ ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     if (next_generation >= (1 << 15))
         next_generation = 1;
 
-    generations[slot] = generation;
-    objects[slot] = std::move(obj);
+    slots[slot].generation = generation;
+    slots[slot].object = std::move(obj);
 
     Handle handle = generation | (slot << 15);
     return MakeResult<Handle>(handle);
@@ -67,9 +67,9 @@ ResultCode HandleTable::Close(Handle handle) {
 
     u16 slot = GetSlot(handle);
 
-    objects[slot] = nullptr;
+    slots[slot].object = nullptr;
 
-    generations[slot] = next_free_slot;
+    slots[slot].generation = next_free_slot;
     next_free_slot = slot;
     return RESULT_SUCCESS;
 }
@@ -78,7 +78,8 @@ bool HandleTable::IsValid(Handle handle) const {
     std::size_t slot = GetSlot(handle);
     u16 generation = GetGeneration(handle);
 
-    return slot < MAX_COUNT && objects[slot] != nullptr && generations[slot] == generation;
+    return slot < MAX_COUNT && slots[slot].object != nullptr &&
+           slots[slot].generation == generation;
 }
 
 SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
@@ -91,13 +92,26 @@ SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
     if (!IsValid(handle)) {
         return nullptr;
     }
-    return objects[GetSlot(handle)];
+    return slots[GetSlot(handle)].object;
+}
+
+Object* HandleTable::GetGenericPointer(Handle handle) const {
+    if (handle == CurrentThread) {
+        return kernel.GetThreadManager().GetCurrentThread();
+    } else if (handle == CurrentProcess) {
+        return kernel.GetCurrentProcess().get();
+    }
+
+    if (!IsValid(handle)) {
+        return nullptr;
+    }
+    return slots[GetSlot(handle)].object.get();
 }
 
 void HandleTable::Clear() {
     for (u16 i = 0; i < MAX_COUNT; ++i) {
-        generations[i] = i + 1;
-        objects[i] = nullptr;
+        slots[i].generation = i + 1;
+        slots[i].object = nullptr;
     }
     next_free_slot = 0;
 }
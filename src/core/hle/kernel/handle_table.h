@@ -24,13 +24,13 @@ enum KernelHandle : Handle {
  * approximately the same restrictions as the handle manager in the CTR-OS.
  *
  * Handles contain two sub-fields: a slot index (bits 31:15) and a generation value (bits 14:0).
- * The slot index is used to index into the arrays in this class to access the data corresponding
- * to the Handle.
+ * The slot index is used to index into the slot array of this class to access the data
+ * corresponding to the Handle.
  *
  * To prevent accidental use of a freed Handle whose slot has already been reused, a global counter
  * is kept and incremented every time a Handle is created. This is the Handle's "generation". The
  * value of the counter is stored into the Handle as well as in the handle table (in the
- * "generations" array). When looking up a handle, the Handle's generation must match with the
+ * generation field of the slot). When looking up a handle, the Handle's generation must match with the
  * value stored on the class, otherwise the Handle is considered invalid.
  *
  * To find free slots when allocating a Handle without needing to scan the entire object array, the
@@ -86,6 +86,29 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference to the object. The object is only guaranteed
+     * to stay alive while the handle is open, so the pointer must not outlive the SVC that looked
+     * it up. Use this for SVCs that don't store the object anywhere.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* GetGenericPointer(Handle handle) const;
+
+    /**
+     * Looks up a handle without taking a reference to the object, while verifying its type. See
+     * GetGenericPointer for the lifetime of the returned pointer.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid or its
+     *         type differs from the requested one.
+     */
+    template <class T>
+    T* GetPointer(Handle handle) const {
+        Object* object = GetGenericPointer(handle);
+        if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+            return static_cast<T*>(object);
+        }
+        return nullptr;
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
@@ -96,14 +119,18 @@ private:
      */
     static const std::size_t MAX_COUNT = 4096;
 
-    /// Stores the Object referenced by the handle or null if the slot is empty.
-    std::array<SharedPtr<Object>, MAX_COUNT> objects;
-
-    /**
-     * The value of `next_generation` when the handle was created, used to check for validity. For
-     * empty slots, contains the index of the next free slot in the list.
-     */
-    std::array<u16, MAX_COUNT> generations;
+    struct Slot {
+        /// The Object referenced by the handle or null if the slot is empty.
+        SharedPtr<Object> object;
+        /**
+         * The value of `next_generation` when the handle was created, used to check for
+         * validity. For empty slots, contains the index of the next free slot in the list.
+         */
+        u16 generation;
+    };
+
+    /// Kept in a single array so that a lookup only touches the memory of one slot.
+    std::array<Slot, MAX_COUNT> slots;
 
     /**
      * Global counter of the number of created handles. Stored in `generations` when a handle is
@@ -12,6 +12,7 @@
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/memory.h"
 
 namespace Kernel {
 
@@ -76,6 +77,16 @@ HLERequestContext::HLERequestContext(SharedPtr<ServerSession> session)
 
 HLERequestContext::~HLERequestContext() = default;
 
+void HLERequestContext::Reset(SharedPtr<ServerSession> session) {
+    this->session = std::move(session);
+    cmd_buf[0] = 0;
+    request_handles.clear();
+    for (auto& buffer : static_buffers) {
+        buffer.clear();
+    }
+    request_mapped_buffers.clear();
+}
+
 SharedPtr<Object> HLERequestContext::GetIncomingHandle(u32 id_from_cmdbuf) const {
     ASSERT(id_from_cmdbuf < request_handles.size());
     return request_handles[id_from_cmdbuf];
@@ -141,12 +152,13 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
             VAddr source_address = src_cmdbuf[i];
             IPC::StaticBufferDescInfo buffer_info{descriptor};
 
-            // Copy the input buffer into our own vector and store it.
-            std::vector<u8> data(buffer_info.size);
+            // Copy the input buffer into our own vector, reusing its storage if the context has
+            // already served a request.
+            std::vector<u8>& data = static_buffers[buffer_info.buffer_id];
+            data.resize(buffer_info.size);
             Core::System::GetInstance().Memory().ReadBlock(src_process, source_address, data.data(),
                                                            data.size());
 
-            AddStaticBuffer(buffer_info.buffer_id, std::move(data));
             cmd_buf[i++] = source_address;
             break;
         }
@@ -256,4 +268,34 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
                                                     src_buffer, size);
 }
 
+u8* MappedBuffer::GetContiguousPointer(std::size_t offset, std::size_t size) {
+    ASSERT(offset + size <= this->size);
+    return Core::System::GetInstance().Memory().GetContiguousPointer(
+        *process, address + static_cast<VAddr>(offset), size);
+}
+
+std::vector<MappedBuffer::HostSpan> MappedBuffer::GetHostSpans(std::size_t offset,
+                                                               std::size_t size) {
+    ASSERT(offset + size <= this->size);
+    auto& memory = Core::System::GetInstance().Memory();
+    std::vector<HostSpan> spans;
+    VAddr current = address + static_cast<VAddr>(offset);
+    while (size > 0) {
+        const std::size_t page_size =
+            std::min<std::size_t>(Memory::PAGE_SIZE - (current & Memory::PAGE_MASK), size);
+        u8* const pointer = memory.GetContiguousPointer(*process, current, page_size);
+        if (!pointer) {
+            return {};
+        }
+        if (!spans.empty() && spans.back().pointer + spans.back().size == pointer) {
+            spans.back().size += page_size;
+        } else {
+            spans.push_back({pointer, page_size});
+        }
+        current += static_cast<VAddr>(page_size);
+        size -= page_size;
+    }
+    return spans;
+}
+
 } // namespace Kernel
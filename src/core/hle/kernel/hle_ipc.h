@@ -100,6 +100,24 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+    /**
+     * Gets a host pointer to a range of the buffer for zero-copy access.
+     * @returns nullptr if the range isn't contiguous on the host, use Read/Write then
+     */
+    u8* GetContiguousPointer(std::size_t offset, std::size_t size);
+
+    /// A run of the buffer that is contiguous on the host
+    struct HostSpan {
+        u8* pointer;
+        std::size_t size;
+    };
+    /**
+     * Gets the host memory backing a range of the buffer, split where it isn't contiguous. Unlike
+     * GetContiguousPointer, this works for buffers spanning pages scattered in FCRAM.
+     * @returns the spans in buffer order, or nothing if part of the range isn't plain memory
+     */
+    std::vector<HostSpan> GetHostSpans(std::size_t offset, std::size_t size);
+
     std::size_t GetSize() const {
         return size;
     }
@@ -156,6 +174,13 @@ public:
     HLERequestContext(SharedPtr<ServerSession> session);
     ~HLERequestContext();
 
+    /**
+     * Prepares the context for a new request made through the specified session. All objects and
+     * buffers of the previous request are released, but the memory backing them is kept so that
+     * a reused context does not have to allocate again.
+     */
+    void Reset(SharedPtr<ServerSession> session);
+
     /// Returns a pointer to the IPC command buffer for this request.
     u32* CommandBuffer() {
         return cmd_buf.data();
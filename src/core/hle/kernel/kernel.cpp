@@ -39,7 +39,7 @@ u32 KernelSystem::GenerateObjectID() {
     return next_object_id++;
 }
 
-SharedPtr<Process> KernelSystem::GetCurrentProcess() const {
+const SharedPtr<Process>& KernelSystem::GetCurrentProcess() const {
     return current_process;
 }
 
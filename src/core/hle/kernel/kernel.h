@@ -201,7 +201,7 @@ public:
     /// Retrieves a process from the current list of processes.
     SharedPtr<Process> GetProcessById(u32 process_id) const;
 
-    SharedPtr<Process> GetCurrentProcess() const;
+    const SharedPtr<Process>& GetCurrentProcess() const;
     void SetCurrentProcess(SharedPtr<Process> process);
 
     ThreadManager& GetThreadManager();
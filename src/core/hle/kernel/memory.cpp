@@ -157,74 +157,205 @@ void KernelSystem::MapSharedPages(VMManager& address_space) {
     address_space.Reprotect(shared_page_vma, VMAPermission::Read);
 }
 
+FreePageTree::Node FreePageTree::Uniform(u32 length, bool free) {
+    const u32 run = free ? length : 0;
+    return {run, run, run};
+}
+
+FreePageTree::Node FreePageTree::Combine(const Node& left, u32 left_length, const Node& right,
+                                         u32 right_length) {
+    Node node;
+    node.prefix = left.prefix == left_length ? left_length + right.prefix : left.prefix;
+    node.suffix = right.suffix == right_length ? right_length + left.suffix : right.suffix;
+    node.longest = std::max({left.longest, right.longest, left.suffix + right.prefix});
+    return node;
+}
+
+void FreePageTree::Reset(u32 num_pages) {
+    leaves = 1;
+    while (leaves < num_pages) {
+        leaves *= 2;
+    }
+    nodes.assign(2 * leaves, Node{});
+    if (num_pages != 0) {
+        Assign(0, num_pages, true);
+    }
+}
+
+void FreePageTree::Assign(u32 first, u32 count, bool free) {
+    ASSERT(first + count <= leaves);
+    Assign(1, 0, leaves, first, first + count, free);
+}
+
+void FreePageTree::Assign(std::size_t node, u32 lo, u32 length, u32 first, u32 end, bool free) {
+    if (end <= lo || lo + length <= first) {
+        return;
+    }
+    if (first <= lo && lo + length <= end) {
+        nodes[node] = Uniform(length, free);
+        return;
+    }
+
+    // Hands the state of a uniform node down before splitting it
+    const u32 half = length / 2;
+    const u32 longest = nodes[node].longest;
+    if (longest == 0 || longest == length) {
+        nodes[2 * node] = nodes[2 * node + 1] = Uniform(half, longest != 0);
+    }
+    Assign(2 * node, lo, half, first, end, free);
+    Assign(2 * node + 1, lo + half, half, first, end, free);
+    nodes[node] = Combine(nodes[2 * node], half, nodes[2 * node + 1], half);
+}
+
+FreePageTree::Node FreePageTree::Query(std::size_t node, u32 lo, u32 length, u32 first,
+                                       u32 end) const {
+    const u32 overlap_lo = std::max(lo, first);
+    const u32 overlap_end = std::min(lo + length, end);
+    const u32 longest = nodes[node].longest;
+    if (longest == 0 || longest == length) {
+        return Uniform(overlap_end - overlap_lo, longest != 0);
+    }
+    if (overlap_lo == lo && overlap_end == lo + length) {
+        return nodes[node];
+    }
+
+    const u32 half = length / 2;
+    if (end <= lo + half) {
+        return Query(2 * node, lo, half, first, end);
+    }
+    if (lo + half <= first) {
+        return Query(2 * node + 1, lo + half, half, first, end);
+    }
+    return Combine(Query(2 * node, lo, half, first, end), lo + half - overlap_lo,
+                   Query(2 * node + 1, lo + half, half, first, end), overlap_end - lo - half);
+}
+
+bool FreePageTree::IsFree(u32 first, u32 count) const {
+    return count == 0 || Query(1, 0, leaves, first, first + count).longest == count;
+}
+
+bool FreePageTree::IsUsed(u32 first, u32 count) const {
+    return count == 0 || Query(1, 0, leaves, first, first + count).longest == 0;
+}
+
+std::optional<u32> FreePageTree::FindFirstRun(u32 count) const {
+    if (nodes[1].longest < count) {
+        return {};
+    }
+
+    std::size_t node = 1;
+    u32 lo = 0;
+    u32 length = leaves;
+    while (nodes[node].longest != length) {
+        const u32 half = length / 2;
+        const Node& left = nodes[2 * node];
+        const Node& right = nodes[2 * node + 1];
+        if (left.longest >= count) {
+            node = 2 * node;
+        } else if (left.suffix + right.prefix >= count) {
+            return lo + half - left.suffix;
+        } else {
+            node = 2 * node + 1;
+            lo += half;
+        }
+        length = half;
+    }
+    return lo;
+}
+
+std::optional<u32> FreePageTree::FindLast(u32 end, bool free) const {
+    return FindLast(1, 0, leaves, end, free);
+}
+
+std::optional<u32> FreePageTree::FindLast(std::size_t node, u32 lo, u32 length, u32 end,
+                                          bool free) const {
+    if (end <= lo) {
+        return {};
+    }
+    const u32 longest = nodes[node].longest;
+    if (longest == (free ? 0 : length)) {
+        return {};
+    }
+    if (longest == (free ? length : 0)) {
+        return std::min(end, lo + length) - 1;
+    }
+
+    const u32 half = length / 2;
+    if (auto page = FindLast(2 * node + 1, lo + half, half, end, free)) {
+        return page;
+    }
+    return FindLast(2 * node, lo, half, end, free);
+}
+
 void MemoryRegionInfo::Reset(u32 base, u32 size) {
+    ASSERT((base & Memory::PAGE_MASK) == 0 && (size & Memory::PAGE_MASK) == 0);
     this->base = base;
     this->size = size;
     used = 0;
-    free_blocks.clear();
 
     // mark the entire region as free
-    free_blocks.insert(Interval::right_open(base, base + size));
+    free_pages.Reset(size >> Memory::PAGE_BITS);
 }
 
 MemoryRegionInfo::IntervalSet MemoryRegionInfo::HeapAllocate(u32 size) {
-    IntervalSet result;
-    u32 rest = size;
-
-    // Try allocating from the higher address
-    for (auto iter = free_blocks.rbegin(); iter != free_blocks.rend(); ++iter) {
-        ASSERT(iter->bounds() == boost::icl::interval_bounds::right_open());
-        if (iter->upper() - iter->lower() >= rest) {
-            // Requested size is fulfilled with this block
-            result += Interval(iter->upper() - rest, iter->upper());
-            rest = 0;
-            break;
-        }
-        result += *iter;
-        rest -= iter->upper() - iter->lower();
-    }
-
-    if (rest != 0) {
+    ASSERT((size & Memory::PAGE_MASK) == 0);
+    if (size == 0 || size > this->size - used) {
         // There is no enough free space
         return {};
     }
 
-    free_blocks -= result;
+    // Takes the free blocks from the higher address, the last one only partially
+    IntervalSet result;
+    u32 rest = size >> Memory::PAGE_BITS;
+    u32 end = this->size >> Memory::PAGE_BITS;
+    while (rest != 0) {
+        const u32 top = *free_pages.FindLast(end, true) + 1;
+        const auto last_used = free_pages.FindLast(top, false);
+        const u32 block_bottom = last_used ? *last_used + 1 : 0;
+        const u32 bottom = top - std::min(rest, top - block_bottom);
+        free_pages.Assign(bottom, top - bottom, false);
+        result += Interval(base + (bottom << Memory::PAGE_BITS), base + (top << Memory::PAGE_BITS));
+        rest -= top - bottom;
+        end = bottom;
+    }
+
     used += size;
     return result;
 }
 
 bool MemoryRegionInfo::LinearAllocate(u32 offset, u32 size) {
-    Interval interval(offset, offset + size);
-    if (!boost::icl::contains(free_blocks, interval)) {
+    ASSERT((offset & Memory::PAGE_MASK) == 0 && (size & Memory::PAGE_MASK) == 0);
+    if (offset < base || offset + size < offset || offset + size > base + this->size ||
+        !free_pages.IsFree((offset - base) >> Memory::PAGE_BITS, size >> Memory::PAGE_BITS)) {
         // The requested range is already allocated
         return false;
     }
-    free_blocks -= interval;
+    free_pages.Assign((offset - base) >> Memory::PAGE_BITS, size >> Memory::PAGE_BITS, false);
     used += size;
     return true;
 }
 
 std::optional<u32> MemoryRegionInfo::LinearAllocate(u32 size) {
+    ASSERT((size & Memory::PAGE_MASK) == 0);
     // Find the first sufficient continuous block from the lower address
-    for (const auto& interval : free_blocks) {
-        ASSERT(interval.bounds() == boost::icl::interval_bounds::right_open());
-        if (interval.upper() - interval.lower() >= size) {
-            Interval allocated(interval.lower(), interval.lower() + size);
-            free_blocks -= allocated;
-            used += size;
-            return allocated.lower();
-        }
+    const u32 count = size >> Memory::PAGE_BITS;
+    const auto first = free_pages.FindFirstRun(std::max(count, 1u));
+    if (!first) {
+        // No sufficient block found
+        return {};
     }
-
-    // No sufficient block found
-    return {};
+    free_pages.Assign(*first, count, false);
+    used += size;
+    return base + (*first << Memory::PAGE_BITS);
 }
 
 void MemoryRegionInfo::Free(u32 offset, u32 size) {
-    Interval interval(offset, offset + size);
-    ASSERT(!boost::icl::intersects(free_blocks, interval)); // must be allocated blocks
-    free_blocks += interval;
+    ASSERT((offset & Memory::PAGE_MASK) == 0 && (size & Memory::PAGE_MASK) == 0);
+    ASSERT(offset >= base && offset + size <= base + this->size);
+    const u32 first = (offset - base) >> Memory::PAGE_BITS;
+    const u32 count = size >> Memory::PAGE_BITS;
+    ASSERT(free_pages.IsUsed(first, count)); // must be allocated blocks
+    free_pages.Assign(first, count, true);
     used -= size;
 }
 
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <optional>
+#include <vector>
 #include <boost/icl/interval_set.hpp>
 #include "common/common_types.h"
 
@@ -13,6 +15,52 @@ namespace Kernel {
 struct AddressMapping;
 class VMManager;
 
+/**
+ * Tracks which pages of a memory region are free. Each node of the segment tree keeps the length of
+ * the longest run of free pages in its range and of the runs touching either end, so finding the
+ * lowest run of a given length, and allocating or freeing a range, take logarithmic time in the
+ * number of pages instead of a walk over all the free blocks. A node whose pages are all free or
+ * all used stands for its whole subtree, whose nodes are only updated once it is split again.
+ */
+class FreePageTree {
+public:
+    /// Marks all the pages free
+    void Reset(u32 num_pages);
+
+    /// Marks a range of pages as free or used
+    void Assign(u32 first, u32 count, bool free);
+
+    /// Returns whether all the pages of a range are free
+    bool IsFree(u32 first, u32 count) const;
+
+    /// Returns whether all the pages of a range are used
+    bool IsUsed(u32 first, u32 count) const;
+
+    /// Returns the first page of the lowest run of at least `count` free pages
+    std::optional<u32> FindFirstRun(u32 count) const;
+
+    /// Returns the highest page below `end` that is free, or used if `free` is false
+    std::optional<u32> FindLast(u32 end, bool free) const;
+
+private:
+    struct Node {
+        u32 prefix = 0;
+        u32 suffix = 0;
+        u32 longest = 0;
+    };
+
+    static Node Uniform(u32 length, bool free);
+    static Node Combine(const Node& left, u32 left_length, const Node& right, u32 right_length);
+
+    void Assign(std::size_t node, u32 lo, u32 length, u32 first, u32 end, bool free);
+    Node Query(std::size_t node, u32 lo, u32 length, u32 first, u32 end) const;
+    std::optional<u32> FindLast(std::size_t node, u32 lo, u32 length, u32 end, bool free) const;
+
+    /// Number of leaves, a power of two. The pages past the end of the region are always used.
+    u32 leaves = 0;
+    std::vector<Node> nodes;
+};
+
 struct MemoryRegionInfo {
     u32 base; // Not an address, but offset from start of FCRAM
     u32 size;
@@ -22,7 +70,7 @@ struct MemoryRegionInfo {
     using IntervalSet = boost::icl::interval_set<u32>;
     using Interval = IntervalSet::interval_type;
 
-    IntervalSet free_blocks;
+    FreePageTree free_pages;
 
     /**
      * Reset the allocator state
@@ -11,6 +11,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
@@ -24,6 +25,16 @@ void ReleaseThreadMutexes(Thread* thread) {
     thread->held_mutexes.clear();
 }
 
+static ObjectPool& mutex_pool = *new ObjectPool{"Mutex", sizeof(Mutex), alignof(Mutex)};
+
+void* Mutex::operator new(std::size_t size) {
+    return mutex_pool.Allocate(size);
+}
+
+void Mutex::operator delete(void* object) {
+    mutex_pool.Free(object);
+}
+
 Mutex::Mutex(KernelSystem& kernel) : WaitObject(kernel) {}
 Mutex::~Mutex() {}
 
@@ -56,6 +56,9 @@ private:
     explicit Mutex(KernelSystem& kernel);
     ~Mutex() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     friend class KernelSystem;
 };
 
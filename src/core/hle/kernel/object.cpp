@@ -3,14 +3,22 @@
 // Refer to the license.txt file included.
 
 #include "common/assert.h"
+#include "common/memory_usage.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/object.h"
 
 namespace Kernel {
 
-Object::Object(KernelSystem& kernel) : object_id{kernel.GenerateObjectID()} {}
+/// The size of the derived objects isn't known here, they are accounted with a typical size
+constexpr s64 OBJECT_MEMORY_ESTIMATE = 256;
 
-Object::~Object() = default;
+Object::Object(KernelSystem& kernel) : object_id{kernel.GenerateObjectID()} {
+    Common::AddMemoryUsage(Common::MemoryCategory::KernelObjects, OBJECT_MEMORY_ESTIMATE);
+}
+
+Object::~Object() {
+    Common::AddMemoryUsage(Common::MemoryCategory::KernelObjects, -OBJECT_MEMORY_ESTIMATE);
+}
 
 bool Object::IsWaitable() const {
     switch (GetHandleType()) {
@@ -0,0 +1,82 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "core/hle/kernel/object_pool.h"
+
+namespace Kernel {
+
+namespace {
+
+struct PoolRegistry {
+    std::mutex mutex;
+    std::vector<const ObjectPool*> pools;
+};
+
+// Pools are created during static initialization, in any order with this
+PoolRegistry& GetRegistry() {
+    static PoolRegistry registry;
+    return registry;
+}
+
+} // Anonymous namespace
+
+ObjectPool::ObjectPool(const char* name, std::size_t object_size, std::size_t object_alignment)
+    : name(name), slot_size(Common::AlignUp(std::max(object_size, sizeof(void*)),
+                                            alignof(std::max_align_t))) {
+    // Blocks come from new[], which only aligns to std::max_align_t
+    ASSERT(object_alignment <= alignof(std::max_align_t));
+
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    registry.pools.push_back(this);
+}
+
+void* ObjectPool::Allocate(std::size_t size) {
+    ASSERT(size <= slot_size);
+
+    std::lock_guard lock{mutex};
+    if (!free_list) {
+        blocks.push_back(std::make_unique<u8[]>(slot_size * OBJECTS_PER_BLOCK));
+        u8* block = blocks.back().get();
+        for (std::size_t i = OBJECTS_PER_BLOCK; i-- > 0;) {
+            void* slot = block + i * slot_size;
+            std::memcpy(slot, &free_list, sizeof(free_list));
+            free_list = slot;
+        }
+        stats.capacity += OBJECTS_PER_BLOCK;
+    }
+
+    void* object = free_list;
+    std::memcpy(&free_list, object, sizeof(free_list));
+    ++stats.live;
+    ++stats.created;
+    return object;
+}
+
+void ObjectPool::Free(void* object) {
+    if (!object)
+        return;
+
+    std::lock_guard lock{mutex};
+    std::memcpy(object, &free_list, sizeof(free_list));
+    free_list = object;
+    --stats.live;
+}
+
+ObjectPool::Stats ObjectPool::GetStats() const {
+    std::lock_guard lock{mutex};
+    return stats;
+}
+
+std::vector<const ObjectPool*> ObjectPool::GetPools() {
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    return registry.pools;
+}
+
+} // namespace Kernel
@@ -0,0 +1,56 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Memory of the kernel objects of one type. Titles create and destroy events, sessions and threads
+ * all the time, so objects are allocated in blocks and freed ones are reused instead of going back
+ * to the heap. The pools also count the objects for the debugger. They are never destroyed, as
+ * objects held by static variables can be freed at exit after any other static object.
+ */
+class ObjectPool : NonCopyable {
+public:
+    struct Stats {
+        std::size_t live;     ///< Objects currently allocated
+        std::size_t created;  ///< Objects allocated since the start
+        std::size_t capacity; ///< Objects the allocated blocks can hold
+    };
+
+    ObjectPool(const char* name, std::size_t object_size, std::size_t object_alignment);
+
+    void* Allocate(std::size_t size);
+    void Free(void* object);
+
+    const char* GetName() const {
+        return name;
+    }
+
+    Stats GetStats() const;
+
+    /// Gets all the pools, in the order they were created
+    static std::vector<const ObjectPool*> GetPools();
+
+private:
+    static constexpr std::size_t OBJECTS_PER_BLOCK = 64;
+
+    const char* name;
+    std::size_t slot_size;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<u8[]>> blocks;
+    /// Freed slots, each starting with a pointer to the next one
+    void* free_list = nullptr;
+    Stats stats{};
+};
+
+} // namespace Kernel
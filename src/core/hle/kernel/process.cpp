@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include "common/assert.h"
 #include "common/common_funcs.h"
@@ -120,14 +121,22 @@ void Process::Run(s32 main_thread_priority, u32 stack_size) {
     auto MapSegment = [&](CodeSet::Segment& segment, VMAPermission permissions,
                           MemoryState memory_state) {
         HeapAllocate(segment.addr, segment.size, permissions, memory_state, true);
-        kernel.memory.WriteBlock(*this, segment.addr, codeset->memory->data() + segment.offset,
-                                 segment.size);
+        // The segment was just allocated, so it is copied straight to its FCRAM blocks
+        const u8* source = codeset->memory->data() + segment.offset;
+        auto backing_blocks = vm_manager.GetBackingBlocksForRange(segment.addr, segment.size);
+        ASSERT(backing_blocks.Succeeded());
+        for (const auto& [backing_memory, block_size] : backing_blocks.Unwrap()) {
+            std::memcpy(backing_memory, source, block_size);
+            source += block_size;
+        }
     };
 
     // Map CodeSet segments
     MapSegment(codeset->CodeSegment(), VMAPermission::ReadExecute, MemoryState::Code);
     MapSegment(codeset->RODataSegment(), VMAPermission::Read, MemoryState::Code);
     MapSegment(codeset->DataSegment(), VMAPermission::ReadWrite, MemoryState::Private);
+    // The image lives in FCRAM from now on, the loader's copy is no longer needed
+    codeset->memory.reset();
 
     // Allocate and map stack
     HeapAllocate(Memory::HEAP_VADDR_END - stack_size, stack_size, VMAPermission::ReadWrite,
@@ -192,9 +201,8 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
                   kernel.memory.GetFCRAMPointer(interval.upper()), 0);
         auto vma = vm_manager.MapBackingMemory(interval_target,
                                                kernel.memory.GetFCRAMPointer(interval.lower()),
-                                               interval_size, memory_state);
+                                               interval_size, memory_state, perms);
         ASSERT(vma.Succeeded());
-        vm_manager.Reprotect(vma.Unwrap(), perms);
         interval_target += interval_size;
     }
 
@@ -266,9 +274,9 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
     u8* backing_memory = kernel.memory.GetFCRAMPointer(physical_offset);
 
     std::fill(backing_memory, backing_memory + size, 0);
-    auto vma = vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous);
+    auto vma =
+        vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous, perms);
     ASSERT(vma.Succeeded());
-    vm_manager.Reprotect(vma.Unwrap(), perms);
 
     memory_used += size;
     resource_limit->current_commit += size;
@@ -350,10 +358,9 @@ ResultCode Process::Map(VAddr target, VAddr source, u32 size, VMAPermission perm
     CASCADE_RESULT(auto backing_blocks, vm_manager.GetBackingBlocksForRange(source, size));
     VAddr interval_target = target;
     for (const auto [backing_memory, block_size] : backing_blocks) {
-        auto target_vma =
-            vm_manager.MapBackingMemory(interval_target, backing_memory, block_size, target_state);
+        auto target_vma = vm_manager.MapBackingMemory(interval_target, backing_memory,
+                                                      block_size, target_state, perms);
         ASSERT(target_vma.Succeeded());
-        vm_manager.Reprotect(target_vma.Unwrap(), perms);
         interval_target += block_size;
     }
 
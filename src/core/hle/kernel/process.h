@@ -94,6 +94,7 @@ public:
         return segments[2];
     }
 
+    /// Image the segments are loaded from, released once Process::Run copied it to FCRAM
     std::shared_ptr<std::vector<u8>> memory;
 
     std::array<Segment, 3> segments;
@@ -5,11 +5,23 @@
 #include "common/assert.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/semaphore.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
 
+static ObjectPool& semaphore_pool =
+    *new ObjectPool{"Semaphore", sizeof(Semaphore), alignof(Semaphore)};
+
+void* Semaphore::operator new(std::size_t size) {
+    return semaphore_pool.Allocate(size);
+}
+
+void Semaphore::operator delete(void* object) {
+    semaphore_pool.Free(object);
+}
+
 Semaphore::Semaphore(KernelSystem& kernel) : WaitObject(kernel) {}
 Semaphore::~Semaphore() {}
 
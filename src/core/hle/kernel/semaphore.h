@@ -45,6 +45,9 @@ private:
     explicit Semaphore(KernelSystem& kernel);
     ~Semaphore() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     friend class KernelSystem;
 };
 
@@ -7,12 +7,24 @@
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/kernel/session.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
 
+static ObjectPool& server_session_pool =
+    *new ObjectPool{"ServerSession", sizeof(ServerSession), alignof(ServerSession)};
+
+void* ServerSession::operator new(std::size_t size) {
+    return server_session_pool.Allocate(size);
+}
+
+void ServerSession::operator delete(void* object) {
+    server_session_pool.Free(object);
+}
+
 ServerSession::ServerSession(KernelSystem& kernel) : WaitObject(kernel) {}
 ServerSession::~ServerSession() {
     // This destructor will be called automatically when the last ServerSession handle is closed by
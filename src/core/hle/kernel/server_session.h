@@ -91,6 +91,9 @@ private:
     explicit ServerSession(KernelSystem& kernel);
     ~ServerSession() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     /**
      * Creates a server session. The server session can have an optional HLE handler,
      * which will be invoked to handle the IPC requests that this session receives.
@@ -167,10 +167,10 @@ ResultCode SharedMemory::Map(Process& target_process, VAddr address, MemoryPermi
     // Map the memory block into the target process
     VAddr interval_target = target_address;
     for (const auto& interval : backing_blocks) {
-        auto vma = target_process.vm_manager.MapBackingMemory(interval_target, interval.first,
-                                                              interval.second, MemoryState::Shared);
+        auto vma = target_process.vm_manager.MapBackingMemory(
+            interval_target, interval.first, interval.second, MemoryState::Shared,
+            ConvertPermissions(permissions));
         ASSERT(vma.Succeeded());
-        target_process.vm_manager.Reprotect(vma.Unwrap(), ConvertPermissions(permissions));
         interval_target += interval.second;
     }
 
@@ -22,6 +22,10 @@ static std::chrono::seconds GetInitTime() {
         return std::chrono::seconds(override_init_time);
     }
 
+    if (Settings::values.deterministic) {
+        return std::chrono::seconds(Settings::values.init_time);
+    }
+
     switch (Settings::values.init_clock) {
     case Settings::InitClock::SystemTime: {
         auto now = std::chrono::system_clock::now();
@@ -3,9 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cinttypes>
 #include <map>
+#include <vector>
 #include <fmt/format.h>
+#include "common/frame_counters.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
@@ -106,13 +109,20 @@ private:
     Core::System& system;
     Kernel::KernelSystem& kernel;
     Memory::MemorySystem& memory;
+    /// Registers of the CPU for the call in progress, threads are only switched after it
+    std::array<u32, 16>* registers = nullptr;
 
     friend class SVCWrapper<SVC>;
 
     // ARM interfaces
 
-    u32 GetReg(std::size_t n);
-    void SetReg(std::size_t n, u32 value);
+    u32 GetReg(std::size_t n) {
+        return (*registers)[n];
+    }
+
+    void SetReg(std::size_t n, u32 value) {
+        (*registers)[n] = value;
+    }
 
     // SVC interfaces
 
@@ -308,8 +318,8 @@ ResultCode SVC::MapMemoryBlock(Handle handle, u32 addr, u32 permissions, u32 oth
               "otherpermission={}",
               handle, addr, permissions, other_permissions);
 
-    SharedPtr<SharedMemory> shared_memory =
-        kernel.GetCurrentProcess()->handle_table.Get<SharedMemory>(handle);
+    SharedMemory* shared_memory =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<SharedMemory>(handle);
     if (shared_memory == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -338,7 +348,7 @@ ResultCode SVC::UnmapMemoryBlock(Handle handle, u32 addr) {
     // TODO(Subv): Return E0A01BF5 if the address is not in the application's heap
 
     SharedPtr<Process> current_process = kernel.GetCurrentProcess();
-    SharedPtr<SharedMemory> shared_memory = current_process->handle_table.Get<SharedMemory>(handle);
+    SharedMemory* shared_memory = current_process->handle_table.GetPointer<SharedMemory>(handle);
     if (shared_memory == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -760,8 +770,8 @@ ResultCode SVC::ArbitrateAddress(Handle handle, u32 address, u32 type, u32 value
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}, address=0x{:08X}, type=0x{:08X}, value=0x{:08X}",
               handle, address, type, value);
 
-    SharedPtr<AddressArbiter> arbiter =
-        kernel.GetCurrentProcess()->handle_table.Get<AddressArbiter>(handle);
+    AddressArbiter* arbiter =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<AddressArbiter>(handle);
     if (arbiter == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -811,7 +821,7 @@ ResultCode SVC::GetResourceLimit(Handle* resource_limit, Handle process_handle)
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X}", process_handle);
 
     SharedPtr<Process> current_process = kernel.GetCurrentProcess();
-    SharedPtr<Process> process = current_process->handle_table.Get<Process>(process_handle);
+    Process* process = current_process->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -826,8 +836,8 @@ ResultCode SVC::GetResourceLimitCurrentValues(VAddr values, Handle resource_limi
     LOG_TRACE(Kernel_SVC, "called resource_limit={:08X}, names={:08X}, name_count={}",
               resource_limit_handle, names, name_count);
 
-    SharedPtr<ResourceLimit> resource_limit =
-        kernel.GetCurrentProcess()->handle_table.Get<ResourceLimit>(resource_limit_handle);
+    ResourceLimit* resource_limit =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<ResourceLimit>(resource_limit_handle);
     if (resource_limit == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -846,8 +856,8 @@ ResultCode SVC::GetResourceLimitLimitValues(VAddr values, Handle resource_limit_
     LOG_TRACE(Kernel_SVC, "called resource_limit={:08X}, names={:08X}, name_count={}",
               resource_limit_handle, names, name_count);
 
-    SharedPtr<ResourceLimit> resource_limit =
-        kernel.GetCurrentProcess()->handle_table.Get<ResourceLimit>(resource_limit_handle);
+    ResourceLimit* resource_limit =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<ResourceLimit>(resource_limit_handle);
     if (resource_limit == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -928,7 +938,7 @@ void SVC::ExitThread() {
 
 /// Gets the priority for the specified thread
 ResultCode SVC::GetThreadPriority(u32* priority, Handle handle) {
-    const SharedPtr<Thread> thread = kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -942,7 +952,7 @@ ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
         return ERR_OUT_OF_RANGE;
     }
 
-    SharedPtr<Thread> thread = kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -980,7 +990,7 @@ ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
 ResultCode SVC::ReleaseMutex(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}", handle);
 
-    SharedPtr<Mutex> mutex = kernel.GetCurrentProcess()->handle_table.Get<Mutex>(handle);
+    Mutex* mutex = kernel.GetCurrentProcess()->handle_table.GetPointer<Mutex>(handle);
     if (mutex == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -991,8 +1001,7 @@ ResultCode SVC::ReleaseMutex(Handle handle) {
 ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X}", process_handle);
 
-    const SharedPtr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1004,8 +1013,7 @@ ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
 ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x{:08X}", thread_handle);
 
-    const SharedPtr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(thread_handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(thread_handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1021,7 +1029,7 @@ ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
 ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x{:08X}", handle);
 
-    const SharedPtr<Thread> thread = kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1046,8 +1054,7 @@ ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_c
 ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
     LOG_TRACE(Kernel_SVC, "called release_count={}, handle=0x{:08X}", release_count, handle);
 
-    SharedPtr<Semaphore> semaphore =
-        kernel.GetCurrentProcess()->handle_table.Get<Semaphore>(handle);
+    Semaphore* semaphore = kernel.GetCurrentProcess()->handle_table.GetPointer<Semaphore>(handle);
     if (semaphore == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1059,8 +1066,7 @@ ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
 /// Query process memory
 ResultCode SVC::QueryProcessMemory(MemoryInfo* memory_info, PageInfo* page_info,
                                    Handle process_handle, u32 addr) {
-    SharedPtr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1123,7 +1129,7 @@ ResultCode SVC::DuplicateHandle(Handle* out, Handle handle) {
 ResultCode SVC::SignalEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    SharedPtr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1136,7 +1142,7 @@ ResultCode SVC::SignalEvent(Handle handle) {
 ResultCode SVC::ClearEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    SharedPtr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1159,7 +1165,7 @@ ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
 ResultCode SVC::ClearTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    SharedPtr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1175,7 +1181,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
         return ERR_OUT_OF_RANGE_KERNEL;
     }
 
-    SharedPtr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1188,7 +1194,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
 ResultCode SVC::CancelTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    SharedPtr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1218,6 +1224,7 @@ void SVC::SleepThread(s64 nanoseconds) {
 }
 
 /// This returns the total CPU ticks elapsed since the CPU was powered-on
+/// ARM_Dynarmic answers this without entering the kernel, keep both in sync
 s64 SVC::GetSystemTick() {
     s64 result = system.CoreTiming().GetTicks();
     // Advance time to defeat dumb games (like Cubic Ninja) that busy-wait for the frame to end.
@@ -1384,8 +1391,7 @@ ResultCode SVC::GetSystemInfo(s64* out, u32 type, s32 param) {
 ResultCode SVC::GetProcessInfo(s64* out, Handle process_handle, u32 type) {
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X} type={}", process_handle, type);
 
-    SharedPtr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1575,9 +1581,22 @@ void SVC::CallSVC(u32 immediate) {
     DEBUG_ASSERT_MSG(kernel.GetCurrentProcess()->status == ProcessStatus::Running,
                      "Running threads from exiting processes is unimplemented");
 
+    // Calls are counted per SVC, in the order of SVC_Table
+    static const auto svc_counters = [] {
+        std::vector<Common::FrameCounter> counters;
+        counters.reserve(ARRAY_SIZE(SVC_Table));
+        for (const auto& function : SVC_Table) {
+            counters.emplace_back(fmt::format("SVC/{}", function.name));
+        }
+        return counters;
+    }();
+
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
+        svc_counters[immediate].Add();
         if (info->func) {
+            // The wrapper reads the arguments and writes the results straight to the registers
+            registers = &system.CPU().GetRegisters();
             (this->*(info->func))();
         } else {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
@@ -1587,14 +1606,6 @@ void SVC::CallSVC(u32 immediate) {
 
 SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
 
-u32 SVC::GetReg(std::size_t n) {
-    return system.CPU().GetReg(static_cast<int>(n));
-}
-
-void SVC::SetReg(std::size_t n, u32 value) {
-    system.CPU().SetReg(static_cast<int>(n), value);
-}
-
 SVCContext::SVCContext(Core::System& system) : impl(std::make_unique<SVC>(system)) {}
 SVCContext::~SVCContext() = default;
 
@@ -18,6 +18,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
@@ -37,6 +38,16 @@ u32 ThreadManager::NewThreadId() {
     return next_thread_id++;
 }
 
+static ObjectPool& thread_pool = *new ObjectPool{"Thread", sizeof(Thread), alignof(Thread)};
+
+void* Thread::operator new(std::size_t size) {
+    return thread_pool.Allocate(size);
+}
+
+void Thread::operator delete(void* object) {
+    thread_pool.Free(object);
+}
+
 Thread::Thread(KernelSystem& kernel)
     : WaitObject(kernel), context(Core::CPU().NewContext()),
       thread_manager(kernel.GetThreadManager()) {}
@@ -313,7 +324,6 @@ ResultVal<SharedPtr<Thread>> KernelSystem::CreateThread(std::string name, VAddr
     SharedPtr<Thread> thread(new Thread(*this));
 
     thread_manager->thread_list.push_back(thread);
-    thread_manager->ready_queue.prepare(priority);
 
     thread->thread_id = thread_manager->NewThreadId();
     thread->status = ThreadStatus::Dormant;
@@ -382,10 +392,12 @@ void Thread::SetPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
 
     nominal_priority = current_priority = priority;
+
+    // Keep the waiting lists of the objects the thread is waiting on sorted
+    for (auto& wait_object : wait_objects)
+        wait_object->UpdateWaitingThreadPriority(this);
 }
 
 void Thread::UpdatePriority() {
@@ -401,9 +413,10 @@ void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
     current_priority = priority;
+
+    for (auto& wait_object : wait_objects)
+        wait_object->UpdateWaitingThreadPriority(this);
 }
 
 SharedPtr<Thread> SetupMainThread(KernelSystem& kernel, u32 entry_point, u32 priority,
@@ -295,6 +295,9 @@ private:
     explicit Thread(KernelSystem&);
     ~Thread() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     ThreadManager& thread_manager;
 
     friend class KernelSystem;
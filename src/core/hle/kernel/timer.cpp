@@ -9,11 +9,22 @@
 #include "core/core.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 
 namespace Kernel {
 
+static ObjectPool& timer_pool = *new ObjectPool{"Timer", sizeof(Timer), alignof(Timer)};
+
+void* Timer::operator new(std::size_t size) {
+    return timer_pool.Allocate(size);
+}
+
+void Timer::operator delete(void* object) {
+    timer_pool.Free(object);
+}
+
 Timer::Timer(KernelSystem& kernel) : WaitObject(kernel), timer_manager(kernel.GetTimerManager()) {}
 Timer::~Timer() {
     Cancel();
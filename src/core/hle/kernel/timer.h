@@ -82,6 +82,9 @@ private:
     explicit Timer(KernelSystem& kernel);
     ~Timer() override;
 
+    static void* operator new(std::size_t size);
+    static void operator delete(void* object);
+
     ResetType reset_type; ///< The ResetType of this timer
 
     u64 initial_delay;  ///< The delay until the timer fires for the first time
@@ -96,7 +96,8 @@ ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size,
 }
 
 ResultVal<VMManager::VMAHandle> VMManager::MapBackingMemory(VAddr target, u8* memory, u32 size,
-                                                            MemoryState state) {
+                                                            MemoryState state,
+                                                            VMAPermission perms) {
     ASSERT(memory != nullptr);
 
     // This is the appropriately sized VMA that will turn into our allocation.
@@ -105,7 +106,7 @@ ResultVal<VMManager::VMAHandle> VMManager::MapBackingMemory(VAddr target, u8* me
     ASSERT(final_vma.size == size);
 
     final_vma.type = VMAType::BackingMemory;
-    final_vma.permissions = VMAPermission::ReadWrite;
+    final_vma.permissions = perms;
     final_vma.meminfo_state = state;
     final_vma.backing_memory = memory;
     UpdatePageTableForVMA(final_vma);
@@ -143,8 +143,11 @@ public:
      * @param memory The memory to be mapped.
      * @param size Size of the mapping.
      * @param state MemoryState tag to attach to the VMA.
+     * @param perms Permissions of the mapping, set along with it so that the page table is only
+     *     updated once.
      */
-    ResultVal<VMAHandle> MapBackingMemory(VAddr target, u8* memory, u32 size, MemoryState state);
+    ResultVal<VMAHandle> MapBackingMemory(VAddr target, u8* memory, u32 size, MemoryState state,
+                                          VMAPermission perms = VMAPermission::ReadWrite);
 
     /**
      * Maps a memory-mapped IO region at a given address.
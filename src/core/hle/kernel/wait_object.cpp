@@ -16,10 +16,21 @@
 
 namespace Kernel {
 
+static bool HasHigherPriority(u32 priority, const SharedPtr<Thread>& thread) {
+    return priority < thread->current_priority;
+}
+
 void WaitObject::AddWaitingThread(SharedPtr<Thread> thread) {
     auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+    if (itr != waiting_threads.end())
+        return;
+
+    // Insert after all the threads of the same or higher priority
+    const u32 priority = thread->current_priority;
+    waiting_threads.insert(std::upper_bound(waiting_threads.begin(), waiting_threads.end(),
+                                            priority, HasHigherPriority),
+                           std::move(thread));
+    ++waiting_threads_changes;
 }
 
 void WaitObject::RemoveWaitingThread(Thread* thread) {
@@ -27,24 +38,27 @@ void WaitObject::RemoveWaitingThread(Thread* thread) {
     // If a thread passed multiple handles to the same object,
     // the kernel might attempt to remove the thread from the object's
     // waiting threads list multiple times.
-    if (itr != waiting_threads.end())
+    if (itr != waiting_threads.end()) {
         waiting_threads.erase(itr);
+        ++waiting_threads_changes;
+    }
 }
 
 SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
-    Thread* candidate = nullptr;
-    u32 candidate_priority = ThreadPrioLowest + 1;
+    std::size_t index = 0;
+    return GetHighestPriorityReadyThread(index);
+}
 
-    for (const auto& thread : waiting_threads) {
+SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread(std::size_t& index) {
+    // The waiting list is sorted by priority, so the first thread that can run is the candidate
+    for (; index < waiting_threads.size(); ++index) {
+        const SharedPtr<Thread>& thread = waiting_threads[index];
         // The list of waiting threads must not contain threads that are not waiting to be awakened.
         ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
                        thread->status == ThreadStatus::WaitSynchAll ||
                        thread->status == ThreadStatus::WaitHleEvent,
                    "Inconsistent thread statuses in waiting_threads");
 
-        if (thread->current_priority >= candidate_priority)
-            continue;
-
         if (ShouldWait(thread.get()))
             continue;
 
@@ -58,17 +72,35 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
                                         });
         }
 
-        if (ready_to_run) {
-            candidate = thread.get();
-            candidate_priority = thread->current_priority;
-        }
+        if (ready_to_run)
+            return thread;
     }
 
-    return candidate;
+    return nullptr;
+}
+
+void WaitObject::UpdateWaitingThreadPriority(Thread* thread) {
+    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
+    if (itr == waiting_threads.end())
+        return;
+
+    SharedPtr<Thread> waiting_thread = std::move(*itr);
+    waiting_threads.erase(itr);
+    const u32 priority = waiting_thread->current_priority;
+    waiting_threads.insert(std::upper_bound(waiting_threads.begin(), waiting_threads.end(),
+                                            priority, HasHigherPriority),
+                           std::move(waiting_thread));
+    ++waiting_threads_changes;
 }
 
 void WaitObject::WakeupAllWaitingThreads() {
-    while (auto thread = GetHighestPriorityReadyThread()) {
+    // The threads before the one woken up weren't ready. Objects only become available through
+    // their own wakeups, which remove the threads they wake from this list, so the search resumes
+    // where it stopped unless the list changed more than by removing the woken thread.
+    std::size_t index = 0;
+    while (auto thread = GetHighestPriorityReadyThread(index)) {
+        const u64 changes = waiting_threads_changes;
+
         if (!thread->IsSleepingOnWaitAll()) {
             Acquire(thread.get());
         } else {
@@ -86,6 +118,9 @@ void WaitObject::WakeupAllWaitingThreads() {
         thread->wait_objects.clear();
 
         thread->ResumeFromWait();
+
+        if (waiting_threads_changes != changes + 1)
+            index = 0;
     }
 
     if (hle_notifier)
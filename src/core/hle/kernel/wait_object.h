@@ -50,6 +50,12 @@ public:
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
     SharedPtr<Thread> GetHighestPriorityReadyThread();
 
+    /**
+     * Moves a waiting thread to its place in the waiting list after its priority has changed
+     * @param thread Pointer to the thread whose priority changed
+     */
+    void UpdateWaitingThreadPriority(Thread* thread);
+
     /// Get a const reference to the waiting threads list for debug use
     const std::vector<SharedPtr<Thread>>& GetWaitingThreads() const;
 
@@ -57,8 +63,16 @@ public:
     void SetHLENotifier(std::function<void()> callback);
 
 private:
-    /// Threads waiting for this object to become available
+    /// Searches the waiting list from index, which is set to the position of the thread found
+    SharedPtr<Thread> GetHighestPriorityReadyThread(std::size_t& index);
+
+    /**
+     * Threads waiting for this object to become available, sorted by priority. Threads of the same
+     * priority are kept in the order they started waiting.
+     */
     std::vector<SharedPtr<Thread>> waiting_threads;
+    /// Incremented whenever waiting_threads is modified
+    u64 waiting_threads_changes = 0;
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
@@ -3,17 +3,26 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/title_metadata.h"
 #include "core/hle/ipc.h"
@@ -29,7 +38,9 @@
 #include "core/hle/service/am/am_net.h"
 #include "core/hle/service/am/am_sys.h"
 #include "core/hle/service/am/am_u.h"
+#include "core/hle/service/am/title_index.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/stream.h"
 #include "core/loader/loader.h"
 #include "core/loader/smdh.h"
 
@@ -76,13 +87,140 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
-class CIAFile::DecryptionState {
+/**
+ * Decrypts, verifies and writes the contents of a CIA on a worker thread, so that this overlaps
+ * with the caller reading the next part of the CIA. The chunks waiting for the worker are bounded,
+ * which blocks the caller when it gets too far ahead.
+ */
+class CIAFile::ContentPipeline {
 public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    explicit ContentPipeline(const FileSys::TitleMetadata& tmd,
+                             const std::optional<std::array<u8, 16>>& title_key)
+        : contents(tmd.GetContentCount()) {
+        for (std::size_t i = 0; i < contents.size(); ++i) {
+            const u16 index = static_cast<u16>(i);
+            if ((tmd.GetContentTypeByIndex(index) & FileSys::TMDContentTypeFlag::Encrypted) &&
+                title_key) {
+                contents[i].decryptor.emplace(*title_key, tmd.GetContentCTRByIndex(index));
+            }
+            contents[i].expected_hash = tmd.GetContentHashByIndex(index);
+        }
+        worker = std::thread(&ContentPipeline::WorkerLoop, this);
+    }
+
+    ~ContentPipeline() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        work_available.notify_one();
+        worker.join();
+    }
+
+    /// Hands the file of a content over to the worker, must be called before its first chunk
+    void BeginContent(std::size_t index, FileUtil::IOFile&& file) {
+        contents[index].file = std::move(file);
+    }
+
+    /**
+     * Queues the next chunk of a content
+     * @param last whether the chunk ends the content, which verifies the hash of what was written
+     */
+    void Push(std::size_t index, const u8* data, std::size_t size, bool last) {
+        Job job{index, std::vector<u8>(data, data + size), last};
+        std::unique_lock lock(mutex);
+        space_available.wait(lock, [this] { return jobs.size() < MaxQueuedJobs; });
+        jobs.push_back(std::move(job));
+        lock.unlock();
+        work_available.notify_one();
+    }
+
+    /// Blocks until all the queued chunks have been written
+    void Finish() {
+        std::unique_lock lock(mutex);
+        space_available.wait(lock, [this] { return jobs.empty() && !busy; });
+    }
+
+    /// Whether writing any content failed so far
+    bool HasFailed() const {
+        return failed;
+    }
+
+private:
+    static constexpr std::size_t MaxQueuedJobs = 8;
+
+    struct Content {
+        FileUtil::IOFile file;
+        std::optional<HW::AES::CBCDecryptor> decryptor;
+        CryptoPP::SHA256 hash;
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> expected_hash;
+    };
+
+    struct Job {
+        std::size_t index;
+        std::vector<u8> data;
+        bool last;
+    };
+
+    void WorkerLoop() {
+        Common::SetCurrentThreadName("CIAInstall");
+        while (true) {
+            std::unique_lock lock(mutex);
+            work_available.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            Job job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+            lock.unlock();
+            space_available.notify_one();
+
+            Process(job);
+
+            lock.lock();
+            busy = false;
+            lock.unlock();
+            space_available.notify_all();
+        }
+    }
+
+    void Process(Job& job) {
+        Content& content = contents[job.index];
+        if (content.decryptor) {
+            // A block split between two chunks is decrypted and written with the second one
+            const std::size_t size = job.data.size();
+            job.data.resize(size + HW::AES::AES_BLOCK_SIZE - 1);
+            job.data.resize(content.decryptor->Process(job.data.data(), job.data.data(), size));
+        }
+        content.hash.Update(job.data.data(), job.data.size());
+        if (content.file.WriteBytes(job.data.data(), job.data.size()) != job.data.size()) {
+            LOG_ERROR(Service_AM, "Failed to write content {}", job.index);
+            failed = true;
+        }
+        if (!job.last)
+            return;
+
+        content.file.Close();
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+        content.hash.Final(hash.data());
+        if (hash != content.expected_hash) {
+            LOG_WARNING(Service_AM, "Content {} does not match the hash of its TMD", job.index);
+        }
+    }
+
+    std::vector<Content> contents;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable space_available;
+    std::deque<Job> jobs;
+    bool busy = false;
+    bool stop = false;
+    std::atomic<bool> failed = false;
 };
 
-CIAFile::CIAFile(Service::FS::MediaType media_type)
-    : media_type(media_type), decryption_state(std::make_unique<DecryptionState>()) {}
+CIAFile::CIAFile(Service::FS::MediaType media_type) : media_type(media_type) {}
 
 CIAFile::~CIAFile() {
     Close();
@@ -132,14 +270,8 @@ ResultCode CIAFile::WriteTitleMetadata() {
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
 
-    if (auto title_key = container.GetTicket().GetTitleKey()) {
-        decryption_state->content.resize(content_count);
-        for (std::size_t i = 0; i < content_count; ++i) {
-            auto ctr = tmd.GetContentCTRByIndex(i);
-            decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                      ctr.data());
-        }
-    }
+    content_pipeline =
+        std::make_unique<ContentPipeline>(tmd, container.GetTicket().GetTitleKey());
 
     install_state = CIAInstallState::TMDLoaded;
 
@@ -166,24 +298,21 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Figure out how much of this content ID we have just recieved/can write out
             u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
-            // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
-
-            if (!file.IsOpen())
-                return FileSys::ERROR_INSUFFICIENT_SPACE;
-
-            std::vector<u8> temp(buffer + (range_min - offset),
-                                 buffer + (range_min - offset) + available_to_write);
-
-            if (tmd.GetContentTypeByIndex(static_cast<u16>(i)) &
-                FileSys::TMDContentTypeFlag::Encrypted) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
+            if (content_written[i] == 0) {
+                // Since the incoming TMD has already been written, we can use GetTitleContentPath
+                // to get the content paths to write to.
+                const u64 title_id = container.GetTitleMetadata().GetTitleID();
+                FileUtil::IOFile file(GetTitleContentPath(media_type, title_id, i, is_update),
+                                      "wb");
+                if (!file.IsOpen())
+                    return FileSys::ERROR_INSUFFICIENT_SPACE;
+                content_pipeline->BeginContent(i, std::move(file));
             }
 
-            file.WriteBytes(temp.data(), temp.size());
+            // The content is decrypted and written by the pipeline while the caller moves on
+            content_pipeline->Push(i, buffer + (range_min - offset),
+                                   static_cast<std::size_t>(available_to_write),
+                                   content_written[i] + available_to_write == size);
 
             // Keep tabs on how much of this content ID has been written so new range_min
             // values can be calculated.
@@ -259,6 +388,9 @@ ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush
     if (install_state != CIAInstallState::TMDLoaded)
         return MakeResult<std::size_t>(length);
 
+    if (content_pipeline->HasFailed())
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
     // From this point forward, data will no longer be buffered in data
     auto result = WriteContentData(offset, length, buffer);
     if (result.Failed())
@@ -276,7 +408,14 @@ bool CIAFile::SetSize(u64 size) const {
 }
 
 bool CIAFile::Close() const {
-    bool complete = true;
+    if (content_pipeline) {
+        content_pipeline->Finish();
+    }
+    // The title directories are visible through the SDMC and NAND archives
+    FileSys::HostMetadataCache::GetInstance().Clear();
+
+    const bool write_failed = content_pipeline != nullptr && content_pipeline->HasFailed();
+    bool complete = !write_failed;
     for (std::size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(static_cast<u16>(i)))
             complete = false;
@@ -286,7 +425,7 @@ bool CIAFile::Close() const {
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
         FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
-        return true;
+        return !write_failed;
     }
 
     // Clean up older content data if we installed newer content on top
@@ -320,11 +459,20 @@ bool CIAFile::Close() const {
 
         FileUtil::Delete(old_tmd_path);
     }
+
+    TitleIndex::GetInstance().Update(media_type, container.GetTitleMetadata().GetTitleID());
     return true;
 }
 
 void CIAFile::Flush() const {}
 
+namespace {
+/// Title IDs InstallCIA is currently installing
+std::mutex installing_titles_mutex;
+std::condition_variable installing_titles_changed;
+std::set<u64> installing_titles;
+} // Anonymous namespace
+
 InstallStatus InstallCIA(const std::string& path,
                          std::function<ProgressCallback>&& update_callback) {
     LOG_INFO(Service_AM, "Installing {}...", path);
@@ -336,6 +484,23 @@ InstallStatus InstallCIA(const std::string& path,
 
     FileSys::CIAContainer container;
     if (container.Load(path) == Loader::ResultStatus::Success) {
+        // Several CIAs may be installed at once, but two installs of the same title would write
+        // to the same files
+        const u64 title_id = container.GetTitleMetadata().GetTitleID();
+        {
+            std::unique_lock lock(installing_titles_mutex);
+            installing_titles_changed.wait(
+                lock, [title_id] { return installing_titles.count(title_id) == 0; });
+            installing_titles.insert(title_id);
+        }
+        SCOPE_EXIT({
+            {
+                std::lock_guard lock(installing_titles_mutex);
+                installing_titles.erase(title_id);
+            }
+            installing_titles_changed.notify_all();
+        });
+
         Service::AM::CIAFile installFile(
             Service::AM::GetTitleMediaType(container.GetTitleMetadata().GetTitleID()));
 
@@ -354,7 +519,8 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
+        // Large reads, as the decryption and writing of each one overlaps with reading the next
+        std::vector<u8> buffer(0x100000);
         std::size_t total_bytes_read = 0;
         while (total_bytes_read != file.GetSize()) {
             std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
@@ -370,7 +536,10 @@ InstallStatus InstallCIA(const std::string& path,
             }
             total_bytes_read += bytes_read;
         }
-        installFile.Close();
+        if (!installFile.Close()) {
+            LOG_ERROR(Service_AM, "CIA file installation failed to write the contents");
+            return InstallStatus::ErrorAborted;
+        }
 
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
         return InstallStatus::Success;
@@ -505,25 +674,8 @@ std::string GetMediaTitlePath(Service::FS::MediaType media_type) {
 }
 
 void Module::ScanForTitles(Service::FS::MediaType media_type) {
-    am_title_list[static_cast<u32>(media_type)].clear();
-
-    std::string title_path = GetMediaTitlePath(media_type);
-
-    FileUtil::FSTEntry entries;
-    FileUtil::ScanDirectoryTree(title_path, entries, 1);
-    for (const FileUtil::FSTEntry& tid_high : entries.children) {
-        for (const FileUtil::FSTEntry& tid_low : tid_high.children) {
-            std::string tid_string = tid_high.virtualName + tid_low.virtualName;
-
-            if (tid_string.length() == TITLE_ID_VALID_LENGTH) {
-                u64 tid = std::stoull(tid_string.c_str(), nullptr, 16);
-
-                FileSys::NCCHContainer container(GetTitleContentPath(media_type, tid));
-                if (container.Load() == Loader::ResultStatus::Success)
-                    am_title_list[static_cast<u32>(media_type)].push_back(tid);
-            }
-        }
-    }
+    const std::vector<u64> titles = TitleIndex::GetInstance().Scan(media_type);
+    am_title_list[static_cast<u32>(media_type)].assign(titles.begin(), titles.end());
 }
 
 void Module::ScanForAllTitles() {
@@ -779,6 +931,7 @@ void Module::Interface::DeleteUserProgram(Kernel::HLERequestContext& ctx) {
         LOG_ERROR(Service_AM, "Title not found");
         return;
     }
+    FileSys::HostMetadataCache::GetInstance().Invalidate(path);
     bool success = FileUtil::DeleteDirRecursively(path);
     am->ScanForAllTitles();
     rb.Push(RESULT_SUCCESS);
@@ -805,7 +958,7 @@ void Module::Interface::GetProductCode(Kernel::HLERequestContext& ctx) {
 
         IPC::RequestBuilder rb = rp.MakeBuilder(6, 0);
         FileSys::NCCHContainer ncch(path);
-        ncch.Load();
+        ncch.LoadHeader();
         std::memcpy(&product_code.code, &ncch.ncch_header.product_code, 0x10);
         rb.Push(RESULT_SUCCESS);
         rb.PushRaw(product_code);
@@ -1372,6 +1525,7 @@ void Module::Interface::DeleteProgram(Kernel::HLERequestContext& ctx) {
         LOG_ERROR(Service_AM, "Title not found");
         return;
     }
+    FileSys::HostMetadataCache::GetInstance().Invalidate(path);
     bool success = FileUtil::DeleteDirRecursively(path);
     am->ScanForAllTitles();
     rb.Push(RESULT_SUCCESS);
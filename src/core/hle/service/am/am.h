@@ -92,8 +92,8 @@ private:
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
 
-    class DecryptionState;
-    std::unique_ptr<DecryptionState> decryption_state;
+    class ContentPipeline;
+    std::unique_ptr<ContentPipeline> content_pipeline;
 };
 
 /**
@@ -563,7 +563,8 @@ public:
 
 private:
     /**
-     * Scans the for titles in a storage medium for listing.
+     * Scans the for titles in a storage medium for listing. Only the titles whose directory
+     * changed since the last scan are checked again, see TitleIndex.
      * @param media_type the storage medium to scan
      */
     void ScanForTitles(Service::FS::MediaType media_type);
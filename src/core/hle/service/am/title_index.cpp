@@ -0,0 +1,170 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <ctime>
+#include <set>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/ncch_container.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/am/title_index.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/loader/loader.h"
+
+namespace Service::AM {
+
+namespace {
+
+constexpr u32 INDEX_MAGIC = 0x58495443; // "CTIX"
+constexpr u32 INDEX_VERSION = 1;
+
+std::string GetIndexPath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "am_title_index.bin";
+}
+
+std::string GetContentDirectory(Service::FS::MediaType media_type, u64 title_id) {
+    return GetTitlePath(media_type, title_id) + "content/";
+}
+
+} // Anonymous namespace
+
+TitleIndex& TitleIndex::GetInstance() {
+    static TitleIndex index;
+    return index;
+}
+
+std::vector<u64> TitleIndex::Scan(Service::FS::MediaType media_type) {
+    std::lock_guard lock{mutex};
+    Load();
+
+    std::vector<u64> titles;
+    std::set<std::string> seen;
+    const std::string title_path = GetMediaTitlePath(media_type);
+
+    FileUtil::FSTEntry tree;
+    FileUtil::ScanDirectoryTree(title_path, tree, 1);
+    for (const FileUtil::FSTEntry& tid_high : tree.children) {
+        for (const FileUtil::FSTEntry& tid_low : tid_high.children) {
+            const std::string tid_string = tid_high.virtualName + tid_low.virtualName;
+            if (tid_string.length() != TITLE_ID_VALID_LENGTH)
+                continue;
+
+            const u64 tid = std::stoull(tid_string, nullptr, 16);
+            seen.insert(GetContentDirectory(media_type, tid));
+            if (IsInstalled(media_type, tid))
+                titles.push_back(tid);
+        }
+    }
+
+    // Forgets the titles of this medium whose directory was deleted
+    for (auto it = entries.lower_bound(title_path);
+         it != entries.end() && it->first.compare(0, title_path.size(), title_path) == 0;) {
+        if (seen.count(it->first) == 0) {
+            it = entries.erase(it);
+            dirty = true;
+        } else {
+            ++it;
+        }
+    }
+
+    Save();
+    return titles;
+}
+
+void TitleIndex::Update(Service::FS::MediaType media_type, u64 title_id) {
+    std::lock_guard lock{mutex};
+    Load();
+    entries.erase(GetContentDirectory(media_type, title_id));
+    dirty = true;
+    IsInstalled(media_type, title_id);
+    Save();
+}
+
+bool TitleIndex::IsInstalled(Service::FS::MediaType media_type, u64 title_id) {
+    const std::string content_path = GetContentDirectory(media_type, title_id);
+    const s64 mtime = FileUtil::GetModificationTime(content_path);
+
+    // A directory modified during the second in which it was checked may have changed again after
+    // the check without its modification time changing, so such entries aren't trusted
+    const auto it = entries.find(content_path);
+    if (it != entries.end() && it->second.mtime == mtime && mtime < it->second.checked_time) {
+        return it->second.installed;
+    }
+
+    FileSys::NCCHContainer container(GetTitleContentPath(media_type, title_id));
+    const bool installed = container.LoadHeader() == Loader::ResultStatus::Success;
+    entries[content_path] = {mtime, static_cast<s64>(std::time(nullptr)), installed};
+    dirty = true;
+    return installed;
+}
+
+void TitleIndex::Load() {
+    if (loaded)
+        return;
+    loaded = true;
+
+    FileUtil::IOFile file(GetIndexPath(), "rb");
+    if (!file.IsOpen())
+        return;
+
+    u32 header[3];
+    if (file.ReadBytes(header, sizeof(header)) != sizeof(header) || header[0] != INDEX_MAGIC ||
+        header[1] != INDEX_VERSION) {
+        LOG_WARNING(Service_AM, "Ignoring invalid title index");
+        return;
+    }
+
+    for (u32 i = 0; i < header[2]; ++i) {
+        u32 path_size;
+        Entry entry;
+        u8 installed;
+        if (file.ReadBytes(&path_size, sizeof(path_size)) != sizeof(path_size)) {
+            entries.clear();
+            return;
+        }
+        std::string path(path_size, '\0');
+        if (file.ReadBytes(path.data(), path_size) != path_size ||
+            file.ReadBytes(&entry.mtime, sizeof(entry.mtime)) != sizeof(entry.mtime) ||
+            file.ReadBytes(&entry.checked_time, sizeof(entry.checked_time)) !=
+                sizeof(entry.checked_time) ||
+            file.ReadBytes(&installed, sizeof(installed)) != sizeof(installed)) {
+            LOG_WARNING(Service_AM, "Ignoring truncated title index");
+            entries.clear();
+            return;
+        }
+        entry.installed = installed != 0;
+        entries.emplace(std::move(path), entry);
+    }
+}
+
+void TitleIndex::Save() {
+    if (!dirty)
+        return;
+    dirty = false;
+
+    const std::string path = GetIndexPath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Service_AM, "Failed to create the title index directory");
+        return;
+    }
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Service_AM, "Failed to save the title index");
+        return;
+    }
+
+    const u32 header[3] = {INDEX_MAGIC, INDEX_VERSION, static_cast<u32>(entries.size())};
+    file.WriteBytes(header, sizeof(header));
+    for (const auto& [content_path, entry] : entries) {
+        const u32 path_size = static_cast<u32>(content_path.size());
+        const u8 installed = entry.installed ? 1 : 0;
+        file.WriteBytes(&path_size, sizeof(path_size));
+        file.WriteBytes(content_path.data(), path_size);
+        file.WriteBytes(&entry.mtime, sizeof(entry.mtime));
+        file.WriteBytes(&entry.checked_time, sizeof(entry.checked_time));
+        file.WriteBytes(&installed, sizeof(installed));
+    }
+}
+
+} // namespace Service::AM
@@ -0,0 +1,62 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::FS {
+enum class MediaType : u32;
+}
+
+namespace Service::AM {
+
+/**
+ * Index of the titles installed on NAND and the SD card. Whether a title directory holds an
+ * installed title takes reading its TMD and the NCCH header of its main content, which adds up to
+ * seconds with hundreds of titles. The index remembers the result for each title along with the
+ * modification time of its content directory, which changes whenever a content or TMD file is
+ * added or removed, so a scan only has to look at the titles whose directory changed.
+ *
+ * The index is saved in the cache directory, so that boots skip the installed titles as well. It
+ * is shared by the AM module and CIAFile, which updates it when an install completes.
+ */
+class TitleIndex {
+public:
+    static TitleIndex& GetInstance();
+
+    /// Returns the IDs of the titles installed on a storage medium
+    std::vector<u64> Scan(Service::FS::MediaType media_type);
+
+    /// Checks a title again after it was installed or deleted
+    void Update(Service::FS::MediaType media_type, u64 title_id);
+
+private:
+    struct Entry {
+        /// Modification time of the content directory
+        s64 mtime;
+        /// Time at which the title was checked
+        s64 checked_time;
+        bool installed;
+    };
+
+    TitleIndex() = default;
+
+    bool IsInstalled(Service::FS::MediaType media_type, u64 title_id);
+
+    void Load();
+    void Save();
+
+    std::mutex mutex;
+    /// Entries by content directory path
+    std::map<std::string, Entry> entries;
+    bool loaded = false;
+    bool dirty = false;
+};
+
+} // namespace Service::AM
@@ -2,6 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -12,6 +18,7 @@
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/romfs.h"
+#include "core/hle/service/am/am.h"
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/apt/apt_a.h"
@@ -101,27 +108,84 @@ static u32 DecompressLZ11(const u8* in, u8* out) {
     return decompressed_size;
 }
 
-bool Module::LoadSharedFont() {
-    u8 font_region_code;
-    auto cfg = Service::CFG::GetModule(Core::System::GetInstance());
-    ASSERT_MSG(cfg, "CFG Module missing!");
-    switch (cfg->GetRegionValue()) {
-    case 4: // CHN
-        font_region_code = 2;
-        break;
-    case 5: // KOR
-        font_region_code = 3;
-        break;
-    case 6: // TWN
-        font_region_code = 4;
-        break;
-    default: // JPN/EUR/USA
-        font_region_code = 1;
-        break;
+namespace {
+
+/// Size of the header APT writes before the decompressed font
+constexpr std::size_t SHARED_FONT_HEADER_SIZE = 0x80;
+
+/// Shared font images by font region, as written to the shared memory before relocation. They
+/// never change once read, and are kept for the whole process so that the systems booted after the
+/// first one copy them instead of reading and decompressing the system archive again.
+std::mutex shared_font_cache_mutex;
+std::array<std::shared_ptr<const std::vector<u8>>, 4> shared_font_cache;
+
+/**
+ * Path of the on-disk copy of a shared font image, named after the size of the system archive so
+ * that installing another one doesn't reuse the old image.
+ * @returns the path, or an empty string when the archive isn't installed
+ */
+std::string GetSharedFontCachePath(u64 archive_id) {
+    const std::string content_path =
+        Service::AM::GetTitleContentPath(Service::FS::MediaType::NAND, archive_id);
+    if (!FileUtil::Exists(content_path))
+        return "";
+    return fmt::format("{}shared_font" DIR_SEP "{:016X}_{:X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), archive_id,
+                       FileUtil::GetSize(content_path));
+}
+
+std::shared_ptr<const std::vector<u8>> ReadSharedFontCache(const std::string& path) {
+    FileUtil::IOFile cache_file(path, "rb");
+    if (!cache_file.IsOpen())
+        return nullptr;
+
+    auto image = std::make_shared<std::vector<u8>>(cache_file.GetSize());
+    if (image->size() <= SHARED_FONT_HEADER_SIZE ||
+        cache_file.ReadBytes(image->data(), image->size()) != image->size())
+        return nullptr;
+
+    // Only complete images are ever renamed to the cache path, this guards against other files
+    u32_le decompressed_size;
+    std::memcpy(&decompressed_size, image->data() + 8, sizeof(u32));
+    if (decompressed_size != image->size() - SHARED_FONT_HEADER_SIZE ||
+        std::memcmp(image->data() + SHARED_FONT_HEADER_SIZE, "CFNU", 4) != 0)
+        return nullptr;
+    return image;
+}
+
+void WriteSharedFontCache(const std::string& path, const std::vector<u8>& image) {
+    // Written to a temporary file first, so that an interrupted write never leaves a short image
+    const std::string temp_path = path + ".tmp";
+    FileUtil::CreateFullPath(temp_path);
+    {
+        FileUtil::IOFile cache_file(temp_path, "wb");
+        if (!cache_file.IsOpen())
+            return;
+        if (cache_file.WriteBytes(image.data(), image.size()) != image.size()) {
+            cache_file.Close();
+            FileUtil::Delete(temp_path);
+            return;
+        }
     }
+    FileUtil::Rename(temp_path, path);
+}
 
+/**
+ * Reads the shared font of a region from the disk cache, or else from its system archive, adding
+ * it to the disk cache. The image is then read from a single file instead of being decrypted and
+ * decompressed from the archive at every boot.
+ */
+std::shared_ptr<const std::vector<u8>> ReadSharedFont(u8 font_region_code) {
     const u64_le shared_font_archive_id_low = 0x0004009b00014002 | ((font_region_code - 1) << 8);
 
+    const std::string cache_path = GetSharedFontCachePath(shared_font_archive_id_low);
+    if (!cache_path.empty()) {
+        if (auto image = ReadSharedFontCache(cache_path)) {
+            LOG_DEBUG(Service_APT, "Loaded the shared font from {}", cache_path);
+            return image;
+        }
+    }
+
     FileSys::NCCHArchive archive(shared_font_archive_id_low, Service::FS::MediaType::NAND);
     std::vector<u8> romfs_path(20, 0); // 20-byte all zero path for opening RomFS
     FileSys::Path file_path(romfs_path);
@@ -129,7 +193,7 @@ bool Module::LoadSharedFont() {
     open_mode.read_flag.Assign(1);
     auto file_result = archive.OpenFile(file_path, open_mode);
     if (file_result.Failed())
-        return false;
+        return nullptr;
 
     auto romfs = std::move(file_result).Unwrap();
     std::vector<u8> romfs_buffer(romfs->GetSize());
@@ -140,8 +204,11 @@ bool Module::LoadSharedFont() {
                                     u"cbf_ko-Hang-KR.bcfnt.lz", u"cbf_zh-Hant-TW.bcfnt.lz"};
     const RomFS::RomFSFile font_file =
         RomFS::GetFile(romfs_buffer.data(), {file_name[font_region_code - 1]});
-    if (font_file.Data() == nullptr)
-        return false;
+    if (font_file.Data() == nullptr || font_file.Length() < sizeof(u32))
+        return nullptr;
+
+    u32_le compression_header;
+    std::memcpy(&compression_header, font_file.Data(), sizeof(u32));
 
     struct {
         u32_le status;
@@ -149,15 +216,64 @@ bool Module::LoadSharedFont() {
         u32_le decompressed_size;
         INSERT_PADDING_WORDS(0x1D);
     } shared_font_header{};
-    static_assert(sizeof(shared_font_header) == 0x80, "shared_font_header has incorrect size");
+    static_assert(sizeof(shared_font_header) == SHARED_FONT_HEADER_SIZE,
+                  "shared_font_header has incorrect size");
 
+    auto image = std::make_shared<std::vector<u8>>(SHARED_FONT_HEADER_SIZE +
+                                                   (compression_header >> 8));
     shared_font_header.status = 2; // successfully loaded
     shared_font_header.region = font_region_code;
     shared_font_header.decompressed_size =
-        DecompressLZ11(font_file.Data(), shared_font_mem->GetPointer(0x80));
-    std::memcpy(shared_font_mem->GetPointer(), &shared_font_header, sizeof(shared_font_header));
-    *shared_font_mem->GetPointer(0x83) = 'U'; // Change the magic from "CFNT" to "CFNU"
+        DecompressLZ11(font_file.Data(), image->data() + SHARED_FONT_HEADER_SIZE);
+    std::memcpy(image->data(), &shared_font_header, sizeof(shared_font_header));
+    (*image)[0x83] = 'U'; // Change the magic from "CFNT" to "CFNU"
+
+    if (!cache_path.empty()) {
+        WriteSharedFontCache(cache_path, *image);
+    }
+    return image;
+}
 
+} // Anonymous namespace
+
+bool Module::LoadSharedFont() {
+    u8 font_region_code;
+    auto cfg = Service::CFG::GetModule(Core::System::GetInstance());
+    ASSERT_MSG(cfg, "CFG Module missing!");
+    switch (cfg->GetRegionValue()) {
+    case 4: // CHN
+        font_region_code = 2;
+        break;
+    case 5: // KOR
+        font_region_code = 3;
+        break;
+    case 6: // TWN
+        font_region_code = 4;
+        break;
+    default: // JPN/EUR/USA
+        font_region_code = 1;
+        break;
+    }
+
+    std::shared_ptr<const std::vector<u8>> image;
+    {
+        std::lock_guard lock{shared_font_cache_mutex};
+        image = shared_font_cache[font_region_code - 1];
+    }
+    if (!image) {
+        image = ReadSharedFont(font_region_code);
+        if (!image)
+            return false;
+        std::lock_guard lock{shared_font_cache_mutex};
+        shared_font_cache[font_region_code - 1] = image;
+    }
+
+    if (image->size() > shared_font_mem->GetSize()) {
+        LOG_ERROR(Service_APT, "Shared font of {} bytes doesn't fit the shared memory",
+                  image->size());
+        return false;
+    }
+    std::memcpy(shared_font_mem->GetPointer(), image->data(), image->size());
     return true;
 }
 
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cryptopp/base64.h>
 #include <cryptopp/hmac.h>
 #include <cryptopp/sha.h>
@@ -357,6 +358,10 @@ void Module::Interface::Write(Kernel::HLERequestContext& ctx) {
             session_data->file->Write(0, buffer.size(), true, buffer.data()).Unwrap();
         session_data->file->Close();
 
+        if (session_data->data_path_type == CecDataPathType::OutboxMsg) {
+            cecd->outbox_message_headers.erase(session_data->ncch_program_id);
+        }
+
         rb.Push(RESULT_SUCCESS);
     }
     rb.PushMappedBuffer(read_buffer);
@@ -418,6 +423,11 @@ void Module::Interface::WriteMessage(Kernel::HLERequestContext& ctx) {
         const u32 bytes_written = message->Write(0, buffer_size, true, buffer.data()).Unwrap();
         message->Close();
 
+        if (is_outbox) {
+            cecd->outbox_message_headers[ncch_program_id][cecd->GetMessageFileName(id_buffer)] =
+                msg_header;
+        }
+
         rb.Push(RESULT_SUCCESS);
     } else {
         rb.Push(ResultCode(ErrorDescription::NoData, ErrorModule::CEC, ErrorSummary::NotFound,
@@ -504,6 +514,11 @@ void Module::Interface::WriteMessageWithHMAC(Kernel::HLERequestContext& ctx) {
         const u32 bytes_written = message->Write(0, buffer_size, true, buffer.data()).Unwrap();
         message->Close();
 
+        if (is_outbox) {
+            cecd->outbox_message_headers[ncch_program_id][cecd->GetMessageFileName(id_buffer)] =
+                msg_header;
+        }
+
         rb.Push(RESULT_SUCCESS);
     } else {
         rb.Push(ResultCode(ErrorDescription::NoData, ErrorModule::CEC, ErrorSummary::NotFound,
@@ -538,10 +553,18 @@ void Module::Interface::Delete(Kernel::HLERequestContext& ctx) {
     case CecDataPathType::MboxDir:
     case CecDataPathType::InboxDir:
     case CecDataPathType::OutboxDir:
+        if (path_type == CecDataPathType::RootDir) {
+            cecd->outbox_message_headers.clear();
+        } else {
+            cecd->outbox_message_headers.erase(ncch_program_id);
+        }
         rb.Push(cecd->cecd_system_save_data_archive->DeleteDirectoryRecursively(path));
         break;
     default: // If not directory, then it is a file
         if (message_id_size == 0) {
+            if (path_type == CecDataPathType::OutboxMsg) {
+                cecd->outbox_message_headers.erase(ncch_program_id);
+            }
             rb.Push(cecd->cecd_system_save_data_archive->DeleteFile(path));
         } else {
             std::vector<u8> id_buffer(message_id_size);
@@ -552,6 +575,10 @@ void Module::Interface::Delete(Kernel::HLERequestContext& ctx) {
                                                            : CecDataPathType::InboxMsg,
                                                  ncch_program_id, id_buffer)
                     .data();
+            if (is_outbox) {
+                cecd->outbox_message_headers[ncch_program_id].erase(
+                    cecd->GetMessageFileName(id_buffer));
+            }
             rb.Push(cecd->cecd_system_save_data_archive->DeleteFile(message_path));
         }
     }
@@ -744,6 +771,10 @@ void Module::Interface::OpenAndWrite(Kernel::HLERequestContext& ctx) {
             const u32 bytes_written = file->Write(0, buffer.size(), true, buffer.data()).Unwrap();
             file->Close();
 
+            if (path_type == CecDataPathType::OutboxMsg) {
+                cecd->outbox_message_headers.erase(ncch_program_id);
+            }
+
             rb.Push(RESULT_SUCCESS);
         } else {
             rb.Push(ResultCode(ErrorDescription::NoData, ErrorModule::CEC, ErrorSummary::NotFound,
@@ -1202,26 +1233,8 @@ void Module::CheckAndUpdateFile(const CecDataPathType path_type, const u32 ncch_
 
             if (boxinfo_name.compare(file_name) != 0 && obindex_name.compare(file_name) != 0) {
                 LOG_DEBUG(Service_CECD, "Adding message to BoxInfo_____: {}", file_name);
-
-                FileSys::Path message_path(
-                    (GetCecDataPathTypeAsString(CecDataPathType::OutboxDir, ncch_program_id) + "/" +
-                     file_name)
-                        .data());
-
-                FileSys::Mode mode;
-                mode.read_flag.Assign(1);
-
-                auto message_result = cecd_system_save_data_archive->OpenFile(message_path, mode);
-
-                auto message = std::move(message_result).Unwrap();
-                const u32 message_size = message->GetSize();
-                std::vector<u8> buffer(message_size);
-
-                message->Read(0, message_size, buffer.data()).Unwrap();
-                message->Close();
-
-                std::memcpy(&message_headers[outbox_info_header.message_num++], buffer.data(),
-                            sizeof(CecMessageHeader));
+                message_headers[outbox_info_header.message_num++] =
+                    GetOutboxMessageHeader(ncch_program_id, file_name);
             }
         }
 
@@ -1293,25 +1306,8 @@ void Module::CheckAndUpdateFile(const CecDataPathType path_type, const u32 ncch_
             file_name = Common::UTF16ToUTF8(u16_filename);
 
             if (boxinfo_name.compare(file_name) != 0 && obindex_name.compare(file_name) != 0) {
-                FileSys::Path message_path(
-                    (GetCecDataPathTypeAsString(CecDataPathType::OutboxDir, ncch_program_id) + "/" +
-                     file_name)
-                        .data());
-
-                FileSys::Mode mode;
-                mode.read_flag.Assign(1);
-
-                auto message_result = cecd_system_save_data_archive->OpenFile(message_path, mode);
-
-                auto message = std::move(message_result).Unwrap();
-                const u32 message_size = message->GetSize();
-                std::vector<u8> buffer(message_size);
-
-                message->Read(0, message_size, buffer.data()).Unwrap();
-                message->Close();
-
-                // Message id is at offset 0x20, and is 8 bytes
-                std::memcpy(&message_ids[obindex_header.message_num++], buffer.data() + 0x20, 8);
+                message_ids[obindex_header.message_num++] =
+                    GetOutboxMessageHeader(ncch_program_id, file_name).message_id;
             }
         }
 
@@ -1341,6 +1337,38 @@ void Module::CheckAndUpdateFile(const CecDataPathType path_type, const u32 ncch_
     }
 }
 
+Module::CecMessageHeader Module::GetOutboxMessageHeader(u32 ncch_program_id,
+                                                        const std::string& file_name) {
+    auto& headers = outbox_message_headers[ncch_program_id];
+    const auto it = headers.find(file_name);
+    if (it != headers.end()) {
+        return it->second;
+    }
+
+    FileSys::Path message_path(
+        (GetCecDataPathTypeAsString(CecDataPathType::OutboxDir, ncch_program_id) + "/" + file_name)
+            .data());
+
+    FileSys::Mode mode;
+    mode.read_flag.Assign(1);
+
+    auto message_result = cecd_system_save_data_archive->OpenFile(message_path, mode);
+
+    // Only the header is needed, not the whole message
+    auto message = std::move(message_result).Unwrap();
+    CecMessageHeader header{};
+    const u64 header_size = std::min<u64>(message->GetSize(), sizeof(CecMessageHeader));
+    message->Read(0, header_size, reinterpret_cast<u8*>(&header)).Unwrap();
+    message->Close();
+
+    headers.emplace(file_name, header);
+    return header;
+}
+
+std::string Module::GetMessageFileName(const std::vector<u8>& msg_id) const {
+    return "_" + EncodeBase64(msg_id);
+}
+
 Module::SessionData::SessionData() {}
 
 Module::SessionData::~SessionData() {
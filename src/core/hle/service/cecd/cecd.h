@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <map>
 #include "common/bit_field.h"
 #include "common/common_funcs.h"
 #include "core/hle/kernel/event.h"
@@ -606,6 +607,20 @@ private:
     void CheckAndUpdateFile(const CecDataPathType path_type, const u32 ncch_program_id,
                             std::vector<u8>& file_buffer);
 
+    /// Returns the header of a message in a title's outbox, only reading it if it isn't cached
+    CecMessageHeader GetOutboxMessageHeader(u32 ncch_program_id, const std::string& file_name);
+
+    /// Returns the file name of a message in a box
+    std::string GetMessageFileName(const std::vector<u8>& msg_id) const;
+
+    /**
+     * Headers of the messages in the outbox of each title, by file name. Rebuilding BoxInfo_____
+     * and OBIndex_____ needs the header of every outbox message, which would otherwise be read
+     * from its file each time. The outbox of a title is forgotten whenever it is modified in a way
+     * that doesn't provide the new headers.
+     */
+    std::map<u32, std::map<std::string, CecMessageHeader>> outbox_message_headers;
+
     std::unique_ptr<FileSys::ArchiveBackend> cecd_system_save_data_archive;
 
     Kernel::SharedPtr<Kernel::Event> cecinfo_event;
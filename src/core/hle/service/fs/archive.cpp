@@ -25,6 +25,7 @@
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/hle/result.h"
 #include "core/hle/service/fs/archive.h"
 
@@ -255,6 +256,7 @@ ResultCode ArchiveManager::DeleteExtSaveData(MediaType media_type, u32 high, u32
     std::string base_path =
         FileSys::GetExtDataContainerPath(media_type_directory, media_type == MediaType::NAND);
     std::string extsavedata_path = FileSys::GetExtSaveDataPath(base_path, path);
+    FileSys::HostMetadataCache::GetInstance().Invalidate(extsavedata_path);
     if (FileUtil::Exists(extsavedata_path) && !FileUtil::DeleteDirRecursively(extsavedata_path))
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
@@ -267,6 +269,7 @@ ResultCode ArchiveManager::DeleteSystemSaveData(u32 high, u32 low) {
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
     std::string base_path = FileSys::GetSystemSaveDataContainerPath(nand_directory);
     std::string systemsavedata_path = FileSys::GetSystemSaveDataPath(base_path, path);
+    FileSys::HostMetadataCache::GetInstance().Invalidate(systemsavedata_path);
     if (!FileUtil::DeleteDirRecursively(systemsavedata_path))
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
@@ -279,6 +282,7 @@ ResultCode ArchiveManager::CreateSystemSaveData(u32 high, u32 low) {
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
     std::string base_path = FileSys::GetSystemSaveDataContainerPath(nand_directory);
     std::string systemsavedata_path = FileSys::GetSystemSaveDataPath(base_path, path);
+    FileSys::HostMetadataCache::GetInstance().Clear();
     if (!FileUtil::CreateFullPath(systemsavedata_path))
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
@@ -349,6 +353,8 @@ void ArchiveManager::RegisterSelfNCCH(Loader::AppLoader& app_loader) {
 }
 
 ArchiveManager::ArchiveManager(Core::System& system) : system(system) {
+    // The host directories may have changed since the last session
+    FileSys::HostMetadataCache::GetInstance().Clear();
     RegisterArchiveTypes();
 }
 
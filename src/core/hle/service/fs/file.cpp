@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
@@ -15,6 +19,73 @@
 
 namespace Service::FS {
 
+namespace {
+
+/**
+ * Runs the host side of file reads in the order they were issued. A single thread is used on
+ * purpose: backends such as the RomFS of a title are shared by several files and are not safe to
+ * read from concurrently.
+ */
+class FileIOThread {
+public:
+    using Task = std::packaged_task<ResultVal<std::size_t>()>;
+
+    FileIOThread() : thread([this] { Loop(); }) {}
+
+    ~FileIOThread() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    template <typename Func>
+    std::future<ResultVal<std::size_t>> Run(Func&& func) {
+        Task task{std::forward<Func>(func)};
+        auto future = task.get_future();
+        {
+            std::lock_guard lock{mutex};
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+        return future;
+    }
+
+private:
+    void Loop() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            cv.wait(lock, [this] { return stop || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            Task task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Task> tasks;
+    bool stop = false;
+    std::thread thread;
+};
+
+/// How far ahead of a file streamed in small chunks the backend is asked to read
+constexpr std::size_t READ_AHEAD_SIZE = 256 * 1024;
+
+FileIOThread& GetFileIOThread() {
+    static FileIOThread io_thread;
+    return io_thread;
+}
+
+} // Anonymous namespace
+
 File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend,
            const FileSys::Path& path)
     : ServiceFramework("", 1), path(path), backend(std::move(backend)), system(system) {
@@ -33,6 +104,17 @@ File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend
     RegisterHandlers(functions);
 }
 
+File::~File() {
+    WaitForPendingRead();
+}
+
+void File::WaitForPendingRead() {
+    if (pending_read.valid()) {
+        pending_read.wait();
+        pending_read = {};
+    }
+}
+
 void File::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0802, 3, 2);
     u64 offset = rp.Pop<u64>();
@@ -40,6 +122,8 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     auto& buffer = rp.PopMappedBuffer();
     LOG_TRACE(Service_FS, "Read {}: offset=0x{:x} length=0x{:08X}", GetName(), offset, length);
 
+    WaitForPendingRead();
+
     const FileSessionSlot* file = GetSessionData(ctx.Session());
 
     if (file->subfile && length > file->size) {
@@ -56,26 +140,66 @@ void File::Read(Kernel::HLERequestContext& ctx) {
                   offset, length, backend->GetSize());
     }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
+    // The host read happens on the I/O thread while the guest thread waits for the emulated
+    // delay, the reply is only built once both are done. When the buffer is plain guest memory the
+    // data is read (and for RomFS, decrypted) straight into it, otherwise into a host copy.
+    const std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
-        rb.Push<u32>(0);
-    } else {
-        buffer.Write(data.data(), 0, *read);
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*read));
+    // Titles tend to stream files in small chunks, which is worth reading ahead of
+    sequential_reads = offset == next_sequential_offset ? sequential_reads + 1 : 0;
+    next_sequential_offset = offset + length;
+    const bool read_ahead = sequential_reads >= 2;
+
+    auto spans = std::make_shared<std::vector<Kernel::MappedBuffer::HostSpan>>();
+    if (buffer.GetSize() >= length) {
+        *spans = buffer.GetHostSpans(0, length);
     }
-    rb.PushMappedBuffer(buffer);
+    std::shared_ptr<std::vector<u8>> data;
+    if (spans->empty()) {
+        data = std::make_shared<std::vector<u8>>(length);
+        spans->push_back({data->data(), length});
+    }
+    pending_read = GetFileIOThread()
+                       .Run([backend = backend.get(), spans, offset,
+                             read_ahead]() -> ResultVal<std::size_t> {
+                           std::size_t total = 0;
+                           for (const auto& span : *spans) {
+                               auto read = backend->Read(offset + total, span.size, span.pointer);
+                               if (read.Failed()) {
+                                   return read.Code();
+                               }
+                               total += *read;
+                               if (*read < span.size) {
+                                   break;
+                               }
+                           }
+                           if (read_ahead) {
+                               backend->ReadAhead(offset + total, READ_AHEAD_SIZE);
+                           }
+                           return MakeResult(total);
+                       })
+                       .share();
 
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
     ctx.SleepClientThread(system.Kernel().GetThreadManager().GetCurrentThread(), "file::read",
                           read_timeout_ns,
-                          [](Kernel::SharedPtr<Kernel::Thread> thread,
-                             Kernel::HLERequestContext& ctx, Kernel::ThreadWakeupReason reason) {
-                              // Nothing to do here
+                          [read_result = pending_read, data, buffer](
+                              Kernel::SharedPtr<Kernel::Thread> thread,
+                              Kernel::HLERequestContext& ctx,
+                              Kernel::ThreadWakeupReason reason) mutable {
+                              // Only blocks if the host is slower than the emulated storage
+                              const ResultVal<std::size_t> read = read_result.get();
+                              IPC::RequestBuilder rb(ctx, 0x0802, 2, 2);
+                              if (read.Failed()) {
+                                  rb.Push(read.Code());
+                                  rb.Push<u32>(0);
+                              } else {
+                                  if (data) {
+                                      buffer.Write(data->data(), 0, *read);
+                                  }
+                                  rb.Push(RESULT_SUCCESS);
+                                  rb.Push<u32>(static_cast<u32>(*read));
+                              }
+                              rb.PushMappedBuffer(buffer);
                           });
 }
 
@@ -88,6 +212,7 @@ void File::Write(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(Service_FS, "Write {}: offset=0x{:x} length={}, flush=0x{:x}", GetName(), offset,
               length, flush);
 
+    WaitForPendingRead();
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
     const FileSessionSlot* file = GetSessionData(ctx.Session());
@@ -100,9 +225,14 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    std::vector<u8> data;
+    const u8* src = (buffer.GetSize() >= length) ? buffer.GetContiguousPointer(0, length) : nullptr;
+    if (!src) {
+        data.resize(length);
+        buffer.Read(data.data(), 0, data.size());
+        src = data.data();
+    }
+    ResultVal<std::size_t> written = backend->Write(offset, length, flush != 0, src);
     if (written.Failed()) {
         rb.Push(written.Code());
         rb.Push<u32>(0);
@@ -137,6 +267,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForPendingRead();
     file->size = size;
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
@@ -150,6 +281,7 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
+    WaitForPendingRead();
     backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -168,6 +300,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForPendingRead();
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -207,6 +340,7 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
 
@@ -268,6 +402,7 @@ Kernel::SharedPtr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot = GetSessionData(server);
     slot->priority = 0;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
 
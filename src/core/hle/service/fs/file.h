@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <future>
 #include "core/file_sys/archive_backend.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/service/service.h"
@@ -27,7 +28,7 @@ class File final : public ServiceFramework<File, FileSessionSlot> {
 public:
     File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend,
          const FileSys::Path& path);
-    ~File() = default;
+    ~File();
 
     std::string GetName() const {
         return "Path: " + path.DebugStr();
@@ -59,7 +60,17 @@ private:
     void OpenLinkFile(Kernel::HLERequestContext& ctx);
     void OpenSubFile(Kernel::HLERequestContext& ctx);
 
+    /// Waits for the host side of the last Read to finish, must be called before using backend
+    void WaitForPendingRead();
+
     Core::System& system;
+
+    /// Host read of the last Read request, completed by the I/O thread
+    std::shared_future<ResultVal<std::size_t>> pending_read;
+
+    /// Where a read continuing the last one would start, to tell when the file is streamed
+    u64 next_sequential_offset = 0;
+    u32 sequential_reads = 0;
 };
 
 } // namespace Service::FS
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
@@ -11,6 +12,8 @@
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
+static Core::TimingEventType* interrupt_event;
+static Core::Timing* timing;
 
 FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index) {
     auto gpu = gsp_gpu.lock();
@@ -24,7 +27,17 @@ void SignalInterrupt(InterruptId interrupt_id) {
     return gpu->SignalInterrupt(interrupt_id);
 }
 
+void SignalInterruptThreadsafe(InterruptId interrupt_id) {
+    timing->ScheduleEventThreadsafe(0, interrupt_event, static_cast<u64>(interrupt_id));
+}
+
 void InstallInterfaces(Core::System& system) {
+    timing = &system.CoreTiming();
+    interrupt_event =
+        timing->RegisterEvent("GSP::SignalInterrupt", [](u64 userdata, s64 cycles_late) {
+            SignalInterrupt(static_cast<InterruptId>(userdata));
+        });
+
     auto& service_manager = system.ServiceManager();
     auto gpu = std::make_shared<GSP_GPU>(system);
     gpu->InstallAsService(service_manager);
@@ -31,5 +31,12 @@ FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index);
  */
 void SignalInterrupt(InterruptId interrupt_id);
 
+/**
+ * Signals an interrupt from a thread other than the emulation thread, such as the GPU thread. The
+ * interrupt is delivered on the emulation thread the next time the timing events are processed.
+ * @param interrupt_id ID of interrupt that is being signalled
+ */
+void SignalInterruptThreadsafe(InterruptId interrupt_id);
+
 void InstallInterfaces(Core::System& system);
 } // namespace Service::GSP
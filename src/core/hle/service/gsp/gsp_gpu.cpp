@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
 #include <vector>
 #include "common/bit_field.h"
 #include "common/microprofile.h"
@@ -20,6 +23,10 @@
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/gpu_debugger.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 // Main graphics debugger object - TODO: Here is probably not the best place for this
 GraphicsDebugger g_debugger;
@@ -313,6 +320,7 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info) {
 
     if (screen_id == 0) {
         MicroProfileFlip();
+        Common::Profiling::OnFrameFlipped();
         Core::System::GetInstance().perf_stats.EndGameFrame();
     }
 
@@ -479,8 +487,91 @@ void GSP_GPU::SignalInterrupt(InterruptId interrupt_id) {
 
 MICROPROFILE_DEFINE(GPU_GSP_DMA, "GPU", "GSP DMA", MP_RGB(100, 0, 255));
 
-/// Executes the next GSP command
-static void ExecuteCommand(const Command& command, u32 thread_id) {
+/// Address ranges, as [start, end) pairs
+using DmaRegions = std::vector<std::pair<VAddr, VAddr>>;
+
+/// Sorts ranges and merges the ones that are adjacent or overlap
+static void MergeDmaRegions(DmaRegions& regions) {
+    std::sort(regions.begin(), regions.end());
+    std::size_t count = 0;
+    for (const auto& region : regions) {
+        if (count != 0 && region.first <= regions[count - 1].second) {
+            regions[count - 1].second = std::max(regions[count - 1].second, region.second);
+        } else {
+            regions[count++] = region;
+        }
+    }
+    regions.resize(count);
+}
+
+/**
+ * Prepares the rasterizer cache for a run of consecutive DMA requests, so that each of them doesn't
+ * have to wait for the GPU thread on its own. All sources are written back before any destination
+ * is invalidated, which leaves the same data in memory as handling the requests one at a time:
+ * a source that an earlier request overwrites gets flushed first and then overwritten anyway.
+ */
+static void FlushDmaRegions(const Command* commands, std::size_t count) {
+    DmaRegions sources;
+    DmaRegions dests;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& dma = commands[i].dma_request;
+        if (dma.size == 0) {
+            continue;
+        }
+        sources.emplace_back(dma.source_address, dma.source_address + dma.size);
+        dests.emplace_back(dma.dest_address, dma.dest_address + dma.size);
+    }
+    MergeDmaRegions(sources);
+    MergeDmaRegions(dests);
+
+    for (const auto& [start, end] : sources) {
+        Memory::RasterizerFlushVirtualRegion(start, end - start, Memory::FlushMode::Flush);
+    }
+    for (const auto& [start, end] : dests) {
+        Memory::RasterizerFlushVirtualRegion(start, end - start, Memory::FlushMode::Invalidate);
+    }
+}
+
+/**
+ * Performs DMA requests between surfaces of the rasterizer cache as copies on the GPU, so that
+ * render targets copied every frame are neither read back nor uploaded again. Requests are done
+ * in order, stopping at the first one that can't be accelerated.
+ * @returns the number of requests performed
+ */
+static std::size_t AccelerateDmaRequests(const Command* commands, std::size_t count) {
+    std::size_t accelerated = 0;
+    if (VideoCore::g_renderer == nullptr || count == 0) {
+        return accelerated;
+    }
+
+    VideoCore::RunOnGPUThreadSync([commands, count, &accelerated] {
+        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+        while (accelerated < count) {
+            const auto& dma = commands[accelerated].dma_request;
+            if (!rasterizer->AccelerateDma(dma.source_address, dma.dest_address, dma.size)) {
+                break;
+            }
+            ++accelerated;
+        }
+    });
+    return accelerated;
+}
+
+/// What was already done for a DMA request before ExecuteCommand
+enum class DmaProgress {
+    None,
+    /// FlushDmaRegions was called for it
+    Flushed,
+    /// AccelerateDmaRequests copied it
+    Copied,
+};
+
+/**
+ * Executes the next GSP command
+ * @param dma_progress What was already done if the command is a DMA request
+ */
+static void ExecuteCommand(const Command& command, u32 thread_id,
+                           DmaProgress dma_progress = DmaProgress::None) {
     // Utility function to convert register ID to address
     static auto WriteGPURegister = [](u32 id, u32 data) {
         GPU::Write<u32>(0x1EF00000 + 4 * id, data);
@@ -492,20 +583,29 @@ static void ExecuteCommand(const Command& command, u32 thread_id) {
     case CommandId::REQUEST_DMA: {
         MICROPROFILE_SCOPE(GPU_GSP_DMA);
         Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
+        const auto& dma = command.dma_request;
 
         // TODO: Consider attempting rasterizer-accelerated surface blit if that usage is ever
         // possible/likely
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.source_address,
-                                             command.dma_request.size, Memory::FlushMode::Flush);
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.dest_address,
-                                             command.dma_request.size,
-                                             Memory::FlushMode::Invalidate);
+        if (dma_progress == DmaProgress::Copied) {
+            SignalInterrupt(InterruptId::DMA);
+            break;
+        }
+        if (dma_progress == DmaProgress::None) {
+            FlushDmaRegions(&command, 1);
+        }
 
         // TODO(Subv): These memory accesses should not go through the application's memory mapping.
         // They should go through the GSP module's memory mapping.
-        memory.CopyBlock(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
-                         command.dma_request.dest_address, command.dma_request.source_address,
-                         command.dma_request.size);
+        const auto& process = *Core::System::GetInstance().Kernel().GetCurrentProcess();
+        const u8* source =
+            memory.GetFlushedContiguousPointer(process, dma.source_address, dma.size);
+        u8* dest = memory.GetFlushedContiguousPointer(process, dma.dest_address, dma.size);
+        if (source && dest) {
+            std::memmove(dest, source, dma.size);
+        } else {
+            memory.CopyBlock(process, dma.dest_address, dma.source_address, dma.size);
+        }
         SignalInterrupt(InterruptId::DMA);
         break;
     }
@@ -637,12 +737,42 @@ void GSP_GPU::TriggerCmdReqQueue(Kernel::HLERequestContext& ctx) {
     for (unsigned thread_id = 0; thread_id < 0x4; ++thread_id) {
         CommandBuffer* command_buffer = (CommandBuffer*)GetCommandBuffer(shared_memory, thread_id);
 
+        // Ends of the DMA requests that were already copied on the GPU, and of the run of DMA
+        // requests whose other members had their regions flushed
+        unsigned dma_copied_end = 0;
+        unsigned dma_end = 0;
+
         // Iterate through each command...
         for (unsigned i = 0; i < command_buffer->number_commands; ++i) {
             g_debugger.GXCommandProcessed((u8*)&command_buffer->commands[i]);
 
+            // Consecutive DMA requests share their flushes, which are all done before the next
+            // other command. The run stops where this loop would, since the count decreases.
+            // Those at its start that the rasterizer copies need no flushes at all.
+            if (command_buffer->commands[i].id == CommandId::REQUEST_DMA && i >= dma_end) {
+                unsigned remaining = command_buffer->number_commands;
+                dma_end = i;
+                while (dma_end < remaining &&
+                       command_buffer->commands[dma_end].id == CommandId::REQUEST_DMA) {
+                    ++dma_end;
+                    --remaining;
+                }
+                const std::size_t copied =
+                    AccelerateDmaRequests(&command_buffer->commands[i], dma_end - i);
+                dma_copied_end = i + static_cast<unsigned>(copied);
+                FlushDmaRegions(&command_buffer->commands[dma_copied_end],
+                                dma_end - dma_copied_end);
+            }
+
+            DmaProgress dma_progress = DmaProgress::None;
+            if (i < dma_copied_end) {
+                dma_progress = DmaProgress::Copied;
+            } else if (i < dma_end) {
+                dma_progress = DmaProgress::Flushed;
+            }
+
             // Decode and execute command
-            ExecuteCommand(command_buffer->commands[i], thread_id);
+            ExecuteCommand(command_buffer->commands[i], thread_id, dma_progress);
 
             // Indicates that command has completed
             command_buffer->number_commands.Assign(command_buffer->number_commands - 1);
@@ -73,9 +73,7 @@ void Module::LoadInputDevices() {
         Settings::values.current_input_profile.touch_device);
 }
 
-void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
-    SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
-
+void Module::ReadPadInput(s16& circle_pad_x, s16& circle_pad_y, TouchDataEntry& touch_entry) {
     if (is_device_reload_pending.exchange(false))
         LoadInputDevices();
 
@@ -95,15 +93,39 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
     state.debug.Assign(buttons[Debug - BUTTON_HID_BEGIN]->GetStatus());
     state.gpio14.Assign(buttons[Gpio14 - BUTTON_HID_BEGIN]->GetStatus());
 
-    // Get current circle pad position and update circle pad direction
+    // Get current circle pad position
     float circle_pad_x_f, circle_pad_y_f;
     std::tie(circle_pad_x_f, circle_pad_y_f) = circle_pad->GetStatus();
     constexpr int MAX_CIRCLEPAD_POS = 0x9C; // Max value for a circle pad position
-    s16 circle_pad_x = static_cast<s16>(circle_pad_x_f * MAX_CIRCLEPAD_POS);
-    s16 circle_pad_y = static_cast<s16>(circle_pad_y_f * MAX_CIRCLEPAD_POS);
+    circle_pad_x = static_cast<s16>(circle_pad_x_f * MAX_CIRCLEPAD_POS);
+    circle_pad_y = static_cast<s16>(circle_pad_y_f * MAX_CIRCLEPAD_POS);
 
-    Core::Movie::GetInstance().HandlePadAndCircleStatus(state, circle_pad_x, circle_pad_y);
+    bool pressed = false;
+    float x, y;
+    std::tie(x, y, pressed) = touch_device->GetStatus();
+    touch_entry.x = static_cast<u16>(x * Core::kScreenBottomWidth);
+    touch_entry.y = static_cast<u16>(y * Core::kScreenBottomHeight);
+    touch_entry.valid.Assign(pressed ? 1 : 0);
 
+    std::optional<InputOverride> input;
+    {
+        std::lock_guard lock{input_override_mutex};
+        input = input_override;
+    }
+    if (input) {
+        state.hex = input->pad.hex;
+        circle_pad_x = input->circle_pad_x;
+        circle_pad_y = input->circle_pad_y;
+        touch_entry.x = input->touch_x;
+        touch_entry.y = input->touch_y;
+        touch_entry.valid.Assign(input->touch_pressed ? 1 : 0);
+    }
+}
+
+void Module::WritePadEntry(s16 circle_pad_x, s16 circle_pad_y) {
+    SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
+
+    // Update circle pad direction
     const DirectionState direction = GetStickDirectionState(circle_pad_x, circle_pad_y);
     state.circle_up.Assign(direction.up);
     state.circle_down.Assign(direction.down);
@@ -111,8 +133,6 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
     state.circle_right.Assign(direction.right);
 
     mem->pad.current_state.hex = state.hex;
-    mem->pad.index = next_pad_index;
-    next_pad_index = (next_pad_index + 1) % mem->pad.entries.size();
 
     // Get the previous Pad state
     u32 last_entry_index = (mem->pad.index - 1) % mem->pad.entries.size();
@@ -130,6 +150,21 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
     pad_entry.delta_removals.hex = changed.hex & old_state.hex;
     pad_entry.circle_pad_x = circle_pad_x;
     pad_entry.circle_pad_y = circle_pad_y;
+}
+
+void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
+    SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
+
+    s16 circle_pad_x;
+    s16 circle_pad_y;
+    TouchDataEntry touch{};
+    ReadPadInput(circle_pad_x, circle_pad_y, touch);
+
+    Core::Movie::GetInstance().HandlePadAndCircleStatus(state, circle_pad_x, circle_pad_y);
+
+    mem->pad.index = next_pad_index;
+    next_pad_index = (next_pad_index + 1) % mem->pad.entries.size();
+    WritePadEntry(circle_pad_x, circle_pad_y);
 
     // If we just updated index 0, provide a new timestamp
     if (mem->pad.index == 0) {
@@ -142,12 +177,7 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
 
     // Get the current touch entry
     TouchDataEntry& touch_entry = mem->touch.entries[mem->touch.index];
-    bool pressed = false;
-    float x, y;
-    std::tie(x, y, pressed) = touch_device->GetStatus();
-    touch_entry.x = static_cast<u16>(x * Core::kScreenBottomWidth);
-    touch_entry.y = static_cast<u16>(y * Core::kScreenBottomHeight);
-    touch_entry.valid.Assign(pressed ? 1 : 0);
+    touch_entry = touch;
 
     Core::Movie::GetInstance().HandleTouchStatus(touch_entry);
 
@@ -406,6 +436,29 @@ void Module::ReloadInputDevices() {
     is_device_reload_pending.store(true);
 }
 
+void Module::LatchInput() {
+    // Movies hold the input of each pad update, latching would consume or record an extra one
+    const auto& movie = Core::Movie::GetInstance();
+    if (movie.IsPlayingInput() || movie.IsRecordingInput())
+        return;
+
+    SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
+
+    s16 circle_pad_x;
+    s16 circle_pad_y;
+    TouchDataEntry touch{};
+    ReadPadInput(circle_pad_x, circle_pad_y, touch);
+
+    // The latest entries are rewritten, the guest keeps seeing one entry per pad update
+    WritePadEntry(circle_pad_x, circle_pad_y);
+    mem->touch.entries[mem->touch.index] = touch;
+}
+
+void Module::SetInputOverride(std::optional<InputOverride> input) {
+    std::lock_guard lock{input_override_mutex};
+    input_override = input;
+}
+
 const PadState& Module::GetState() const {
     return state;
 }
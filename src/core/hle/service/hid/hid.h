@@ -10,6 +10,8 @@
 #include <cstddef>
 #endif
 #include <memory>
+#include <mutex>
+#include <optional>
 #include "common/bit_field.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
@@ -299,12 +301,39 @@ public:
         std::shared_ptr<Module> hid;
     };
 
+    /// Input replacing the one of the input devices, used to drive the emulator through RPC
+    struct InputOverride {
+        PadState pad;
+        s16 circle_pad_x;
+        s16 circle_pad_y;
+        bool touch_pressed;
+        u16 touch_x;
+        u16 touch_y;
+    };
+
     void ReloadInputDevices();
 
+    /**
+     * Samples the input devices again and rewrites the latest pad and touch entries with it. This
+     * is done when a frame is about to be emulated, after the frame limiter slept, so that the
+     * guest reads recent input instead of the input of the last pad update before the sleep.
+     */
+    void LatchInput();
+
+    /**
+     * Replaces the input of the input devices until called with std::nullopt. Movies record the
+     * replaced input, and their playback still takes precedence.
+     */
+    void SetInputOverride(std::optional<InputOverride> input);
+
     const PadState& GetState() const;
 
 private:
     void LoadInputDevices();
+    /// Reads the buttons into state, and the circle pad and touch screen
+    void ReadPadInput(s16& circle_pad_x, s16& circle_pad_y, TouchDataEntry& touch_entry);
+    /// Writes state and the circle pad to the current pad entry of the shared memory
+    void WritePadEntry(s16 circle_pad_x, s16 circle_pad_y);
     void UpdatePadCallback(u64 userdata, s64 cycles_late);
     void UpdateAccelerometerCallback(u64 userdata, s64 cycles_late);
     void UpdateGyroscopeCallback(u64 userdata, s64 cycles_late);
@@ -343,6 +372,9 @@ private:
     std::unique_ptr<Input::AnalogDevice> circle_pad;
     std::unique_ptr<Input::MotionDevice> motion_device;
     std::unique_ptr<Input::TouchDevice> touch_device;
+
+    std::mutex input_override_mutex;
+    std::optional<InputOverride> input_override;
 };
 
 std::shared_ptr<Module> GetModule(Core::System& system);
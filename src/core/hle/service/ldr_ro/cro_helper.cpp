@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <limits>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -21,6 +23,32 @@ static ResultCode CROFormatError(u32 description) {
                       ErrorSummary::WrongArgument, ErrorLevel::Permanent);
 }
 
+namespace {
+
+/**
+ * Span of the words relocated by a loop, whose JIT cache is invalidated once when it goes out of
+ * scope instead of once per relocation.
+ */
+class RelocatedRange {
+public:
+    ~RelocatedRange() {
+        if (begin < end) {
+            Core::CPU().InvalidateCacheRange(begin, end - begin);
+        }
+    }
+
+    void Add(VAddr address) {
+        begin = std::min(begin, address);
+        end = std::max(end, address + static_cast<VAddr>(sizeof(u32)));
+    }
+
+private:
+    VAddr begin = std::numeric_limits<VAddr>::max();
+    VAddr end = 0;
+};
+
+} // Anonymous namespace
+
 const std::array<int, 17> CROHelper::ENTRY_SIZE{{
     1, // code
     1, // data
@@ -72,11 +100,9 @@ ResultCode CROHelper::ApplyRelocation(VAddr target_address, RelocationType reloc
     case RelocationType::AbsoluteAddress:
     case RelocationType::AbsoluteAddress2:
         memory.Write32(target_address, symbol_address + addend);
-        Core::CPU().InvalidateCacheRange(target_address, sizeof(u32));
         break;
     case RelocationType::RelativeAddress:
         memory.Write32(target_address, symbol_address + addend - target_future_address);
-        Core::CPU().InvalidateCacheRange(target_address, sizeof(u32));
         break;
     case RelocationType::ThumbBranch:
     case RelocationType::ArmBranch:
@@ -99,7 +125,6 @@ ResultCode CROHelper::ClearRelocation(VAddr target_address, RelocationType reloc
     case RelocationType::AbsoluteAddress2:
     case RelocationType::RelativeAddress:
         memory.Write32(target_address, 0);
-        Core::CPU().InvalidateCacheRange(target_address, sizeof(u32));
         break;
     case RelocationType::ThumbBranch:
     case RelocationType::ArmBranch:
@@ -118,6 +143,7 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
     if (symbol_address == 0 && !reset)
         return CROFormatError(0x10);
 
+    RelocatedRange relocated;
     VAddr relocation_address = batch;
     while (true) {
         RelocationEntry relocation;
@@ -134,6 +160,7 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
             LOG_ERROR(Service_LDR, "Error applying relocation {:08X}", result.raw);
             return result;
         }
+        relocated.Add(relocation_target);
 
         if (relocation.is_batch_end)
             break;
@@ -481,6 +508,7 @@ ResultCode CROHelper::ResetExternalRelocations() {
         return CROFormatError(0x12);
     }
 
+    RelocatedRange relocated;
     bool batch_begin = true;
     for (u32 i = 0; i < external_relocation_num; ++i) {
         GetEntry(memory, i, relocation);
@@ -496,6 +524,7 @@ ResultCode CROHelper::ResetExternalRelocations() {
             LOG_ERROR(Service_LDR, "Error applying relocation {:08X}", result.raw);
             return result;
         }
+        relocated.Add(relocation_target);
 
         if (batch_begin) {
             // resets to unresolved state
@@ -514,6 +543,7 @@ ResultCode CROHelper::ClearExternalRelocations() {
     u32 external_relocation_num = GetField(ExternalRelocationNum);
     ExternalRelocationEntry relocation;
 
+    RelocatedRange relocated;
     bool batch_begin = true;
     for (u32 i = 0; i < external_relocation_num; ++i) {
         GetEntry(memory, i, relocation);
@@ -528,6 +558,7 @@ ResultCode CROHelper::ClearExternalRelocations() {
             LOG_ERROR(Service_LDR, "Error clearing relocation {:08X}", result.raw);
             return result;
         }
+        relocated.Add(relocation_target);
 
         if (batch_begin) {
             // resets to unresolved state
@@ -577,6 +608,7 @@ ResultCode CROHelper::ApplyStaticAnonymousSymbolToCRS(VAddr crs_address) {
 ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
     u32 segment_num = GetField(SegmentNum);
     u32 internal_relocation_num = GetField(InternalRelocationNum);
+    RelocatedRange relocated;
     for (u32 i = 0; i < internal_relocation_num; ++i) {
         InternalRelocationEntry relocation;
         GetEntry(memory, i, relocation);
@@ -611,12 +643,17 @@ ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
             LOG_ERROR(Service_LDR, "Error applying relocation {:08X}", result.raw);
             return result;
         }
+        // The old .data buffer can be far from the module and is never executed
+        if (target_segment.type != SegmentType::Data) {
+            relocated.Add(target_address);
+        }
     }
     return RESULT_SUCCESS;
 }
 
 ResultCode CROHelper::ClearInternalRelocations() {
     u32 internal_relocation_num = GetField(InternalRelocationNum);
+    RelocatedRange relocated;
     for (u32 i = 0; i < internal_relocation_num; ++i) {
         InternalRelocationEntry relocation;
         GetEntry(memory, i, relocation);
@@ -631,6 +668,7 @@ ResultCode CROHelper::ClearInternalRelocations() {
             LOG_ERROR(Service_LDR, "Error clearing relocation {:08X}", result.raw);
             return result;
         }
+        relocated.Add(target_address);
     }
     return RESULT_SUCCESS;
 }
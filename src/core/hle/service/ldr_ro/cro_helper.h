@@ -493,7 +493,7 @@ private:
     }
 
     /**
-     * Applies a relocation
+     * Applies a relocation. The caller invalidates the JIT cache of the target.
      * @param target_address where to apply the relocation
      * @param relocation_type the type of the relocation
      * @param addend address addend applied to the relocated symbol
@@ -506,7 +506,7 @@ private:
                                u32 symbol_address, u32 target_future_address);
 
     /**
-     * Clears a relocation to zero
+     * Clears a relocation to zero. The caller invalidates the JIT cache of the target.
      * @param target_address where to apply the relocation
      * @param relocation_type the type of the relocation
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
@@ -2,8 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
 #include "common/logging/log.h"
+#include "common/swap.h"
 #include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/mic.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
@@ -28,10 +33,128 @@ enum class SampleRate : u8 {
     SampleRate8180 = 3
 };
 
+/// Sample rates in Hz, by SampleRate
+constexpr std::array<u32, 4> SAMPLE_RATES = {32728, 16364, 10909, 8182};
+
+/// Number of samples written to the shared memory by each update
+constexpr u32 SAMPLES_PER_UPDATE = 128;
+
+/// Resampling positions are in 16.16 fixed point
+constexpr u32 PHASE_ONE = 1 << 16;
+
+static u32 GetSampleRateInHz(SampleRate sample_rate) {
+    return SAMPLE_RATES[static_cast<u8>(sample_rate) & 3];
+}
+
+static s64 GetUpdatePeriod(SampleRate sample_rate) {
+    return static_cast<s64>(BASE_CLOCK_RATE_ARM11 * SAMPLES_PER_UPDATE /
+                            GetSampleRateInHz(sample_rate));
+}
+
 struct MIC_U::Impl {
-    explicit Impl(Core::System& system) {
+    explicit Impl(Core::System& system) : system(system), timing(system.CoreTiming()) {
         buffer_full_event =
             system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "MIC_U::buffer_full_event");
+        buffer_write_event =
+            timing.RegisterEvent("MIC_U::UpdateBuffer", [this](u64 userdata, s64 cycles_late) {
+                UpdateBuffer(cycles_late);
+            });
+    }
+
+    void UpdateBuffer(s64 cycles_late) {
+        if (!is_sampling)
+            return;
+
+        switch (encoding) {
+        case Encoding::PCM8:
+            WriteSamples<u8>([](s16 sample) { return static_cast<u8>((sample >> 8) + 0x80); });
+            break;
+        case Encoding::PCM16:
+            WriteSamples<u16_le>([](s16 sample) { return static_cast<u16>(sample + 0x8000); });
+            break;
+        case Encoding::PCM8Signed:
+            WriteSamples<s8>([](s16 sample) { return static_cast<s8>(sample >> 8); });
+            break;
+        case Encoding::PCM16Signed:
+            WriteSamples<s16_le>([](s16 sample) { return sample; });
+            break;
+        }
+
+        if (is_sampling) {
+            timing.ScheduleEvent(GetUpdatePeriod(sample_rate) - cycles_late, buffer_write_event);
+        }
+    }
+
+    /**
+     * Writes an update's worth of samples to the guest's buffer, resampling them from the
+     * microphone's rate and converting them as they are read from its ring. Records silence for
+     * the samples the microphone didn't capture in time.
+     */
+    template <typename T, typename Convert>
+    void WriteSamples(Convert convert) {
+        if (!shared_memory || audio_buffer_offset < 0 || audio_buffer_size < sizeof(T) ||
+            audio_buffer_offset + u64{audio_buffer_size} + sizeof(u32) > shared_memory->GetSize()) {
+            return;
+        }
+        u8* const buffer = shared_memory->GetPointer(static_cast<u32>(audio_buffer_offset));
+
+        // Keeps the latency bounded when the microphone captures faster than the guest records
+        const std::size_t needed = (u64{SAMPLES_PER_UPDATE} * step >> 16) + 1;
+        const std::size_t captured = mic->GetSampleCount();
+        if (captured > needed * 2) {
+            mic->ConsumeSamples(captured - needed,
+                                [](const s16* samples, std::size_t count) { return count; });
+        }
+
+        u32 remaining = SAMPLES_PER_UPDATE;
+        const auto emit = [&](s16 sample) {
+            const T value = convert(sample);
+            std::memcpy(buffer + write_offset, &value, sizeof(T));
+            write_offset += sizeof(T);
+            --remaining;
+            if (write_offset + sizeof(T) > audio_buffer_size) {
+                buffer_full_event->Signal();
+                if (audio_buffer_loop) {
+                    write_offset = 0;
+                } else {
+                    mic->StopSampling();
+                    is_sampling = false;
+                    remaining = 0;
+                }
+            }
+        };
+
+        mic->ConsumeSamples(~std::size_t(0), [&](const s16* samples, std::size_t count) {
+            std::size_t used = 0;
+            for (; used < count && remaining != 0; ++used) {
+                const s16 sample = samples[used];
+                while (phase < PHASE_ONE && remaining != 0) {
+                    const s64 delta = sample - previous_sample;
+                    emit(static_cast<s16>(previous_sample + (delta * phase >> 16)));
+                    phase += step;
+                }
+                // The buffer filled up before this sample was used up, it's kept for the next
+                // update
+                if (phase < PHASE_ONE)
+                    break;
+                phase -= PHASE_ONE;
+                previous_sample = sample;
+            }
+            return used;
+        });
+        while (remaining != 0) {
+            emit(0);
+        }
+
+        // The last word of the shared memory holds the offset of the next sample in the buffer
+        const u32_le offset = write_offset;
+        std::memcpy(shared_memory->GetPointer(static_cast<u32>(shared_memory->GetSize()) -
+                                              sizeof(u32)),
+                    &offset, sizeof(offset));
+    }
+
+    void UpdateResampler() {
+        step = static_cast<u32>((u64{host_sample_rate} << 16) / GetSampleRateInHz(sample_rate));
     }
 
     void MapSharedMem(Kernel::HLERequestContext& ctx) {
@@ -66,31 +189,54 @@ struct MIC_U::Impl {
         audio_buffer_size = rp.Pop<u32>();
         audio_buffer_loop = rp.Pop<bool>();
 
+        if (is_sampling) {
+            timing.UnscheduleEvent(buffer_write_event, 0);
+        }
+        mic = system.GetMic();
+        if (!mic) {
+            mic = std::make_shared<Frontend::Mic::NullMic>();
+        }
+        host_sample_rate = mic->StartSampling(GetSampleRateInHz(sample_rate));
+        // Drops what was captured before, the recording starts now
+        mic->ConsumeSamples(~std::size_t(0),
+                            [](const s16* samples, std::size_t count) { return count; });
+        UpdateResampler();
+        phase = 0;
+        previous_sample = 0;
+        write_offset = 0;
+        is_sampling = true;
+        timing.ScheduleEvent(GetUpdatePeriod(sample_rate), buffer_write_event);
+
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
         rb.Push(RESULT_SUCCESS);
-        is_sampling = true;
-        LOG_WARNING(Service_MIC,
-                    "(STUBBED) called, encoding={}, sample_rate={}, "
-                    "audio_buffer_offset={}, audio_buffer_size={}, audio_buffer_loop={}",
-                    static_cast<u32>(encoding), static_cast<u32>(sample_rate), audio_buffer_offset,
-                    audio_buffer_size, audio_buffer_loop);
+        LOG_DEBUG(Service_MIC,
+                  "called, encoding={}, sample_rate={}, "
+                  "audio_buffer_offset={}, audio_buffer_size={}, audio_buffer_loop={}",
+                  static_cast<u32>(encoding), static_cast<u32>(sample_rate), audio_buffer_offset,
+                  audio_buffer_size, audio_buffer_loop);
     }
 
     void AdjustSampling(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx, 0x04, 1, 0};
         sample_rate = rp.PopEnum<SampleRate>();
+        UpdateResampler();
 
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
         rb.Push(RESULT_SUCCESS);
-        LOG_WARNING(Service_MIC, "(STUBBED) called, sample_rate={}", static_cast<u32>(sample_rate));
+        LOG_DEBUG(Service_MIC, "called, sample_rate={}", static_cast<u32>(sample_rate));
     }
 
     void StopSampling(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx, 0x05, 0, 0};
+        if (is_sampling) {
+            timing.UnscheduleEvent(buffer_write_event, 0);
+            mic->StopSampling();
+            is_sampling = false;
+        }
+
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
         rb.Push(RESULT_SUCCESS);
-        is_sampling = false;
-        LOG_WARNING(Service_MIC, "(STUBBED) called");
+        LOG_DEBUG(Service_MIC, "called");
     }
 
     void IsSampling(Kernel::HLERequestContext& ctx) {
@@ -192,6 +338,19 @@ struct MIC_U::Impl {
         rb.Push(RESULT_SUCCESS);
     }
 
+    Core::System& system;
+    Core::Timing& timing;
+    Core::TimingEventType* buffer_write_event;
+    std::shared_ptr<Frontend::Mic::Interface> mic;
+    u32 host_sample_rate = 0;
+    /// Microphone samples per guest sample, in 16.16 fixed point
+    u32 step = PHASE_ONE;
+    /// Position of the next guest sample between previous_sample and the next microphone sample
+    u32 phase = 0;
+    s16 previous_sample = 0;
+    /// Offset of the next sample in the guest's buffer, in bytes
+    u32 write_offset = 0;
+
     u32 client_version = 0;
     Kernel::SharedPtr<Kernel::Event> buffer_full_event;
     Kernel::SharedPtr<Kernel::SharedMemory> shared_memory;
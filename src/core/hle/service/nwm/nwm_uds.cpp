@@ -90,6 +90,13 @@ static std::map<MacAddress, Node> node_map;
 // Event that will generate and send the 802.11 beacon frames.
 static Core::TimingEventType* beacon_broadcast_event;
 
+// The last beacon frame sent, only generated again once the network changes.
+static BeaconFrameCache beacon_frame_cache;
+
+// Packets reused for the beacon and data frames sent, keeping the capacity of their buffers.
+static Network::WifiPacket beacon_packet;
+static Network::WifiPacket data_packet;
+
 // Callback identifier for the OnWifiPacketReceived event.
 static Network::RoomMember::CallbackHandle<Network::WifiPacket> wifi_packet_received;
 
@@ -979,6 +986,7 @@ void NWM_UDS::DestroyNetwork(Kernel::HLERequestContext& ctx) {
 
     // Unschedule the beacon broadcast event.
     system.CoreTiming().UnscheduleEvent(beacon_broadcast_event, 0);
+    beacon_frame_cache.Clear();
 
     // Only a host can destroy
     std::lock_guard<std::mutex> lock(connection_status_mutex);
@@ -1110,21 +1118,18 @@ void NWM_UDS::SendTo(Kernel::HLERequestContext& ctx) {
 
     // TODO(B3N30): Increment the sequence number after each sent packet.
     u16 sequence_number = 0;
-    std::vector<u8> data_payload =
-        GenerateDataPayload(input_buffer, data_channel, dest_node_id,
-                            connection_status.network_node_id, sequence_number);
+    // The frame is built in the buffer of the last one, as games send many of them
+    GenerateDataPayload(input_buffer, data_channel, dest_node_id,
+                        connection_status.network_node_id, sequence_number, data_packet.data);
 
     // TODO(B3N30): Use the MAC address of the dest_node_id and our own to encrypt
     // and encapsulate the payload.
 
-    Network::WifiPacket packet;
+    data_packet.destination_address = *dest_address;
+    data_packet.channel = network_channel;
+    data_packet.type = Network::WifiPacket::PacketType::Data;
 
-    packet.destination_address = *dest_address;
-    packet.channel = network_channel;
-    packet.data = std::move(data_payload);
-    packet.type = Network::WifiPacket::PacketType::Data;
-
-    SendPacket(packet);
+    SendPacket(data_packet);
 
     rb.Push(RESULT_SUCCESS);
 }
@@ -1343,12 +1348,10 @@ void NWM_UDS::BeaconBroadcastCallback(u64 userdata, s64 cycles_late) {
     if (connection_status.status != static_cast<u32>(NetworkStatus::ConnectedAsHost))
         return;
 
-    std::vector<u8> frame = GenerateBeaconFrame(network_info, node_info);
-
     using Network::WifiPacket;
-    WifiPacket packet;
+    WifiPacket& packet = beacon_packet;
     packet.type = WifiPacket::PacketType::Beacon;
-    packet.data = std::move(frame);
+    packet.data = beacon_frame_cache.GetFrame(network_info, node_info);
     packet.destination_address = Network::BroadcastMac;
     packet.channel = network_channel;
 
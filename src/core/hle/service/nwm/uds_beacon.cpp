@@ -238,8 +238,8 @@ void DecryptBeacon(const NetworkInfo& network_info, std::vector<u8>& buffer) {
  * The encrypted payload contains information about the nodes currently connected to the network.
  * @returns A buffer with the first Nintendo encrypted data parameters of the beacon frame.
  */
-std::vector<u8> GenerateNintendoFirstEncryptedDataTag(const NetworkInfo& network_info,
-                                                      const NodeList& nodes) {
+std::vector<u8> GenerateNintendoFirstEncryptedDataTag(const NodeList& nodes,
+                                                      const std::vector<u8>& encrypted_data) {
     const std::size_t payload_size =
         std::min<std::size_t>(EncryptedDataSizeCutoff, nodes.size() * sizeof(NodeInfo));
 
@@ -251,8 +251,6 @@ std::vector<u8> GenerateNintendoFirstEncryptedDataTag(const NetworkInfo& network
 
     std::vector<u8> buffer(sizeof(tag) + payload_size);
     std::memcpy(buffer.data(), &tag, sizeof(tag));
-
-    std::vector<u8> encrypted_data = GeneratedEncryptedData(network_info, nodes);
     std::memcpy(buffer.data() + sizeof(tag), encrypted_data.data(), payload_size);
 
     return buffer;
@@ -266,8 +264,8 @@ std::vector<u8> GenerateNintendoFirstEncryptedDataTag(const NetworkInfo& network
  * bytes.
  * @returns A buffer with the second Nintendo encrypted data parameters of the beacon frame.
  */
-std::vector<u8> GenerateNintendoSecondEncryptedDataTag(const NetworkInfo& network_info,
-                                                       const NodeList& nodes) {
+std::vector<u8> GenerateNintendoSecondEncryptedDataTag(const NodeList& nodes,
+                                                       const std::vector<u8>& encrypted_data) {
     // This tag is only present if the payload is larger than EncryptedDataSizeCutoff (0xFA).
     if (nodes.size() * sizeof(NodeInfo) <= EncryptedDataSizeCutoff)
         return {};
@@ -287,8 +285,6 @@ std::vector<u8> GenerateNintendoSecondEncryptedDataTag(const NetworkInfo& networ
 
     std::vector<u8> buffer(sizeof(tag) + payload_size);
     std::memcpy(buffer.data(), &tag, sizeof(tag));
-
-    std::vector<u8> encrypted_data = GeneratedEncryptedData(network_info, nodes);
     std::memcpy(buffer.data() + sizeof(tag), encrypted_data.data() + EncryptedDataSizeCutoff,
                 payload_size);
 
@@ -306,8 +302,11 @@ std::vector<u8> GenerateNintendoTaggedParameters(const NetworkInfo& network_info
 
     std::vector<u8> buffer = GenerateNintendoDummyTag();
     std::vector<u8> network_info_tag = GenerateNintendoNetworkInfoTag(network_info);
-    std::vector<u8> first_data_tag = GenerateNintendoFirstEncryptedDataTag(network_info, nodes);
-    std::vector<u8> second_data_tag = GenerateNintendoSecondEncryptedDataTag(network_info, nodes);
+    // Both data tags hold parts of the same payload, which is only encrypted once
+    std::vector<u8> encrypted_data = GeneratedEncryptedData(network_info, nodes);
+    std::vector<u8> first_data_tag = GenerateNintendoFirstEncryptedDataTag(nodes, encrypted_data);
+    std::vector<u8> second_data_tag =
+        GenerateNintendoSecondEncryptedDataTag(nodes, encrypted_data);
 
     buffer.insert(buffer.end(), network_info_tag.begin(), network_info_tag.end());
     buffer.insert(buffer.end(), first_data_tag.begin(), first_data_tag.end());
@@ -327,4 +326,25 @@ std::vector<u8> GenerateBeaconFrame(const NetworkInfo& network_info, const NodeL
     return buffer;
 }
 
+const std::vector<u8>& BeaconFrameCache::GetFrame(const NetworkInfo& network_info,
+                                                  const NodeList& nodes) {
+    const bool changed =
+        !valid || std::memcmp(&this->network_info, &network_info, sizeof(NetworkInfo)) != 0 ||
+        this->nodes.size() != nodes.size() ||
+        std::memcmp(this->nodes.data(), nodes.data(), nodes.size() * sizeof(NodeInfo)) != 0;
+    if (changed) {
+        frame = GenerateBeaconFrame(network_info, nodes);
+        this->network_info = network_info;
+        this->nodes = nodes;
+        valid = true;
+    }
+    return frame;
+}
+
+void BeaconFrameCache::Clear() {
+    valid = false;
+    nodes.clear();
+    frame.clear();
+}
+
 } // namespace Service::NWM
@@ -9,6 +9,7 @@
 #include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
+#include "core/hle/service/nwm/nwm_uds.h"
 #include "core/hle/service/service.h"
 
 namespace Service::NWM {
@@ -135,4 +136,26 @@ void DecryptBeacon(const NetworkInfo& network_info, std::vector<u8>& buffer);
  */
 std::vector<u8> GenerateBeaconFrame(const NetworkInfo& network_info, const NodeList& nodes);
 
+/**
+ * Keeps the last generated beacon frame. Generating one hashes and encrypts its whole payload,
+ * while the network rarely changes between two beacons.
+ */
+class BeaconFrameCache {
+public:
+    /**
+     * Returns the beacon frame of a network, which is only generated again if the network
+     * information or the nodes changed since the last call.
+     */
+    const std::vector<u8>& GetFrame(const NetworkInfo& network_info, const NodeList& nodes);
+
+    /// Drops the cached frame
+    void Clear();
+
+private:
+    bool valid = false;
+    NetworkInfo network_info{};
+    NodeList nodes;
+    std::vector<u8> frame;
+};
+
 } // namespace Service::NWM
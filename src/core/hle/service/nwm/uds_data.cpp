@@ -35,10 +35,10 @@ static std::vector<u8> GenerateLLCHeader(EtherType protocol) {
 
 /*
  * Generates a Nintendo UDS SecureData header with the specified parameters.
- * @returns a buffer with the bytes of the generated header.
+ * @returns the generated header.
  */
-static std::vector<u8> GenerateSecureDataHeader(u16 data_size, u8 channel, u16 dest_node_id,
-                                                u16 src_node_id, u16 sequence_number) {
+static SecureDataHeader GenerateSecureDataHeader(u16 data_size, u8 channel, u16 dest_node_id,
+                                                 u16 src_node_id, u16 sequence_number) {
     SecureDataHeader header{};
     header.protocol_size = data_size + sizeof(SecureDataHeader);
     // Note: This size includes everything except the first 4 bytes of the structure,
@@ -52,10 +52,7 @@ static std::vector<u8> GenerateSecureDataHeader(u16 data_size, u8 channel, u16 d
     header.dest_node_id = dest_node_id;
     header.src_node_id = src_node_id;
 
-    std::vector<u8> buffer(sizeof(header));
-    memcpy(buffer.data(), &header, sizeof(header));
-
-    return buffer;
+    return header;
 }
 
 /*
@@ -270,13 +267,27 @@ static std::vector<u8> EncryptDataFrame(const std::vector<u8>& payload,
 
 std::vector<u8> GenerateDataPayload(const std::vector<u8>& data, u8 channel, u16 dest_node,
                                     u16 src_node, u16 sequence_number) {
-    std::vector<u8> buffer = GenerateLLCHeader(EtherType::SecureData);
-    std::vector<u8> securedata_header = GenerateSecureDataHeader(
+    std::vector<u8> buffer;
+    GenerateDataPayload(data, channel, dest_node, src_node, sequence_number, buffer);
+    return buffer;
+}
+
+void GenerateDataPayload(const std::vector<u8>& data, u8 channel, u16 dest_node, u16 src_node,
+                         u16 sequence_number, std::vector<u8>& buffer) {
+    LLCHeader llc_header{};
+    llc_header.protocol = EtherType::SecureData;
+    const SecureDataHeader securedata_header = GenerateSecureDataHeader(
         static_cast<u16>(data.size()), channel, dest_node, src_node, sequence_number);
 
-    buffer.insert(buffer.end(), securedata_header.begin(), securedata_header.end());
-    buffer.insert(buffer.end(), data.begin(), data.end());
-    return buffer;
+    // Written in place, so that a buffer reused across frames doesn't allocate
+    buffer.resize(sizeof(llc_header) + sizeof(securedata_header) + data.size());
+    std::memcpy(buffer.data(), &llc_header, sizeof(llc_header));
+    std::memcpy(buffer.data() + sizeof(llc_header), &securedata_header,
+                sizeof(securedata_header));
+    if (!data.empty()) {
+        std::memcpy(buffer.data() + sizeof(llc_header) + sizeof(securedata_header), data.data(),
+                    data.size());
+    }
 }
 
 SecureDataHeader ParseSecureDataHeader(const std::vector<u8>& data) {
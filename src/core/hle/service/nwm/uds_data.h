@@ -121,6 +121,13 @@ static_assert(sizeof(EAPoLLogoffPacket) == 0x298, "EAPoLLogoffPacket has the wro
 std::vector<u8> GenerateDataPayload(const std::vector<u8>& data, u8 channel, u16 dest_node,
                                     u16 src_node, u16 sequence_number);
 
+/**
+ * Generates an unencrypted 802.11 data payload into an existing buffer, which is resized to fit.
+ * Reusing the buffer for every frame avoids allocating one each time.
+ */
+void GenerateDataPayload(const std::vector<u8>& data, u8 channel, u16 dest_node, u16 src_node,
+                         u16 sequence_number, std::vector<u8>& buffer);
+
 /*
  * Returns the SecureDataHeader stored in an 802.11 data frame.
  */
@@ -66,13 +66,13 @@ const std::array<ServiceModuleInfo, 40> service_module_map{
      {"AC", 0x00040130'00002402, AC::InstallInterfaces},
      {"ACT", 0x00040130'00003802, ACT::InstallInterfaces},
      {"AM", 0x00040130'00001502, AM::InstallInterfaces},
-     {"BOSS", 0x00040130'00003402, BOSS::InstallInterfaces},
+     {"BOSS", 0x00040130'00003402, BOSS::InstallInterfaces, {"boss:P", "boss:U"}},
      {"CAM", 0x00040130'00001602,
       [](Core::System& system) {
           CAM::InstallInterfaces(system);
           Y2R::InstallInterfaces(system);
       }},
-     {"CECD", 0x00040130'00002602, CECD::InstallInterfaces},
+     {"CECD", 0x00040130'00002602, CECD::InstallInterfaces, {"cecd:ndm", "cecd:s", "cecd:u"}},
      {"CFG", 0x00040130'00001702, CFG::InstallInterfaces},
      {"DLP", 0x00040130'00002802, DLP::InstallInterfaces},
      {"DSP", 0x00040130'00001A02, DSP::InstallInterfaces},
@@ -95,7 +95,7 @@ const std::array<ServiceModuleInfo, 40> service_module_map{
      {"PTM", 0x00040130'00002202, PTM::InstallInterfaces},
      {"QTM", 0x00040130'00004202, QTM::InstallInterfaces},
      {"CSND", 0x00040130'00002702, CSND::InstallInterfaces},
-     {"HTTP", 0x00040130'00002902, HTTP::InstallInterfaces},
+     {"HTTP", 0x00040130'00002902, HTTP::InstallInterfaces, {"http:C"}},
      {"SOC", 0x00040130'00002E02, SOC::InstallInterfaces},
      {"SSL", 0x00040130'00002F02, SSL::InstallInterfaces},
      // no HLE implementation
@@ -126,7 +126,8 @@ const std::array<ServiceModuleInfo, 40> service_module_map{
 
 ServiceFrameworkBase::ServiceFrameworkBase(const char* service_name, u32 max_sessions,
                                            InvokerFn* handler_invoker)
-    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {}
+    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker),
+      request_counter("IPC/" + this->service_name) {}
 
 ServiceFrameworkBase::~ServiceFrameworkBase() = default;
 
@@ -169,6 +170,25 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const Funct
     cmd_buf[1] = 0;
 }
 
+std::unique_ptr<Kernel::HLERequestContext> ServiceFrameworkBase::AcquireContext(
+    Kernel::SharedPtr<Kernel::ServerSession> server_session) {
+    if (context_pool.empty()) {
+        return std::make_unique<Kernel::HLERequestContext>(std::move(server_session));
+    }
+
+    std::unique_ptr<Kernel::HLERequestContext> context = std::move(context_pool.back());
+    context_pool.pop_back();
+    context->Reset(std::move(server_session));
+    return context;
+}
+
+void ServiceFrameworkBase::ReleaseContext(std::unique_ptr<Kernel::HLERequestContext> context) {
+    // Drop the references to the session and the translated objects right away instead of
+    // holding them until the context is reused
+    context->Reset(nullptr);
+    context_pool.push_back(std::move(context));
+}
+
 void ServiceFrameworkBase::HandleSyncRequest(
     Kernel::SharedPtr<Kernel::ServerSession> server_session) {
     Kernel::KernelSystem& kernel = Core::System::GetInstance().Kernel();
@@ -177,6 +197,8 @@ void ServiceFrameworkBase::HandleSyncRequest(
     u32* cmd_buf = reinterpret_cast<u32*>(
         Core::System::GetInstance().Memory().GetPointer(thread->GetCommandBufferAddress()));
 
+    request_counter.Add();
+
     u32 header_code = cmd_buf[0];
     auto itr = handlers.find(header_code);
     const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
@@ -188,11 +210,11 @@ void ServiceFrameworkBase::HandleSyncRequest(
 
     // TODO(yuriks): The kernel should be the one handling this as part of translation after
     // everything else is migrated
-    Kernel::HLERequestContext context(std::move(server_session));
-    context.PopulateFromIncomingCommandBuffer(cmd_buf, *current_process);
+    auto context = AcquireContext(std::move(server_session));
+    context->PopulateFromIncomingCommandBuffer(cmd_buf, *current_process);
 
     LOG_TRACE(Service, "{}", MakeFunctionString(info->name, GetServiceName().c_str(), cmd_buf));
-    handler_invoker(this, info->handler_callback, context);
+    handler_invoker(this, info->handler_callback, *context);
 
     ASSERT(thread->status == Kernel::ThreadStatus::Running ||
            thread->status == Kernel::ThreadStatus::WaitHleEvent);
@@ -200,8 +222,9 @@ void ServiceFrameworkBase::HandleSyncRequest(
     // the thread to sleep then the writing of the command buffer will be deferred to the wakeup
     // callback.
     if (thread->status == Kernel::ThreadStatus::Running) {
-        context.WriteToOutgoingCommandBuffer(cmd_buf, *current_process);
+        context->WriteToOutgoingCommandBuffer(cmd_buf, *current_process);
     }
+    ReleaseContext(std::move(context));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -229,8 +252,15 @@ void Init(Core::System& core) {
     SM::ServiceManager::InstallInterfaces(core);
 
     for (const auto& service_module : service_module_map) {
-        if (!AttemptLLE(service_module) && service_module.init_function != nullptr)
+        if (AttemptLLE(service_module) || service_module.init_function == nullptr)
+            continue;
+        if (service_module.lazy_services.empty()) {
             service_module.init_function(core);
+        } else {
+            core.ServiceManager().RegisterLazyServices(
+                service_module.lazy_services,
+                [&core, &service_module] { service_module.init_function(core); });
+        }
     }
     LOG_DEBUG(Service, "initialized OK");
 }
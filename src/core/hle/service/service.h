@@ -7,9 +7,12 @@
 #include <array>
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/common_types.h"
+#include "common/frame_counters.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/service/sm/sm.h"
@@ -87,6 +90,12 @@ private:
     void RegisterHandlersBase(const FunctionInfoBase* functions, std::size_t n);
     void ReportUnimplementedFunction(u32* cmd_buf, const FunctionInfoBase* info);
 
+    /// Takes a request context from the pool, or creates one if all of them are in use.
+    std::unique_ptr<Kernel::HLERequestContext> AcquireContext(
+        Kernel::SharedPtr<Kernel::ServerSession> server_session);
+    /// Returns a context to the pool once the request it was used for has been answered.
+    void ReleaseContext(std::unique_ptr<Kernel::HLERequestContext> context);
+
     /// Identifier string used to connect to the service.
     std::string service_name;
     /// Maximum number of concurrent sessions that this service can handle.
@@ -101,6 +110,15 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+
+    /// Counts the requests received by this service
+    Common::FrameCounter request_counter;
+
+    /**
+     * Request contexts that are not in use. They keep the storage of their static buffers and
+     * handle lists, so that most requests are translated without allocating.
+     */
+    std::vector<std::unique_ptr<Kernel::HLERequestContext>> context_pool;
 };
 
 /**
@@ -190,6 +208,9 @@ struct ServiceModuleInfo {
     std::string name;
     u64 title_id;
     std::function<void(Core::System&)> init_function;
+    /// Services of the module, which is then only initialized once a session connects to one of
+    /// them. Empty for the modules initialized at boot, which other parts of the emulator use.
+    std::vector<std::string> lazy_services;
 };
 
 extern const std::array<ServiceModuleInfo, 40> service_module_map;
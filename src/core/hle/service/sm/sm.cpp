@@ -37,7 +37,8 @@ ResultVal<Kernel::SharedPtr<Kernel::ServerPort>> ServiceManager::RegisterService
 
     CASCADE_CODE(ValidateServiceName(name));
 
-    if (registered_services.find(name) != registered_services.end())
+    if (registered_services.find(name) != registered_services.end() ||
+        lazy_services.find(name) != lazy_services.end())
         return ERR_ALREADY_REGISTERED;
 
     auto [server_port, client_port] = system.Kernel().CreatePortPair(max_sessions, name);
@@ -46,13 +47,38 @@ ResultVal<Kernel::SharedPtr<Kernel::ServerPort>> ServiceManager::RegisterService
     return MakeResult(std::move(server_port));
 }
 
+void ServiceManager::RegisterLazyServices(const std::vector<std::string>& names,
+                                          std::function<void()> install) {
+    const auto shared_install = std::make_shared<std::function<void()>>(std::move(install));
+    for (const std::string& name : names) {
+        ASSERT(registered_services.find(name) == registered_services.end());
+        lazy_services.emplace(name, shared_install);
+    }
+}
+
 ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> ServiceManager::GetServicePort(
     const std::string& name) {
 
     CASCADE_CODE(ValidateServiceName(name));
     auto it = registered_services.find(name);
     if (it == registered_services.end()) {
-        return ERR_SERVICE_NOT_REGISTERED;
+        const auto lazy_it = lazy_services.find(name);
+        if (lazy_it == lazy_services.end()) {
+            return ERR_SERVICE_NOT_REGISTERED;
+        }
+
+        // The install function registers every service of the module, none of them stays lazy
+        const auto install = lazy_it->second;
+        for (auto service = lazy_services.begin(); service != lazy_services.end();) {
+            service = service->second == install ? lazy_services.erase(service) : ++service;
+        }
+        LOG_DEBUG(Service, "Creating the services of {} on first use", name);
+        (*install)();
+
+        it = registered_services.find(name);
+        if (it == registered_services.end()) {
+            return ERR_SERVICE_NOT_REGISTERED;
+        }
     }
 
     return MakeResult(it->second);
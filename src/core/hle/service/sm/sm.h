@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/server_port.h"
@@ -49,6 +51,11 @@ public:
 
     ResultVal<Kernel::SharedPtr<Kernel::ServerPort>> RegisterService(std::string name,
                                                                      unsigned int max_sessions);
+    /**
+     * Makes services available without creating them. The install function is called the first
+     * time one of them is looked up, and has to register all of them.
+     */
+    void RegisterLazyServices(const std::vector<std::string>& names, std::function<void()> install);
     ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> GetServicePort(const std::string& name);
     ResultVal<Kernel::SharedPtr<Kernel::ClientSession>> ConnectToService(const std::string& name);
 
@@ -74,6 +81,9 @@ private:
 
     /// Map of registered services, retrieved using GetServicePort or ConnectToService.
     std::unordered_map<std::string, Kernel::SharedPtr<Kernel::ClientPort>> registered_services;
+
+    /// Install functions of the services not created yet, shared by the services of a module
+    std::unordered_map<std::string, std::shared_ptr<std::function<void()>>> lazy_services;
 };
 
 } // namespace Service::SM
@@ -4,13 +4,18 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
+#include "common/thread.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/result.h"
@@ -320,6 +325,144 @@ union CTRSockAddr {
     }
 };
 
+/**
+ * Polls, on a host thread, the sockets that guest threads are waiting on, so that blocking guest
+ * calls don't block the emulation thread.
+ */
+class SocketPoller {
+public:
+    /// Called on the poller thread when a wait is over
+    using ReadyCallback = std::function<void(u64 id)>;
+
+    explicit SocketPoller(ReadyCallback ready_callback_)
+        : ready_callback(std::move(ready_callback_)) {
+        // A socket connected to itself wakes the thread when the waits change
+        wake_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addr_len = sizeof(addr);
+        if (wake_socket == static_cast<decltype(wake_socket)>(SOCKET_ERROR_VALUE) ||
+            ::bind(wake_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::getsockname(wake_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0 ||
+            ::connect(wake_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            LOG_ERROR(Service_SOC, "Failed to create the socket poller wake socket");
+            can_wake = false;
+        }
+        thread = std::thread(&SocketPoller::Loop, this);
+    }
+
+    ~SocketPoller() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        Wake();
+        thread.join();
+        closesocket(wake_socket);
+    }
+
+    /// Waits until one of the sockets is ready
+    void Add(u64 id, std::vector<pollfd> fds) {
+        {
+            std::lock_guard lock{mutex};
+            waits.emplace(id, std::move(fds));
+        }
+        Wake();
+    }
+
+    void Remove(u64 id) {
+        std::lock_guard lock{mutex};
+        waits.erase(id);
+    }
+
+private:
+    void Wake() {
+        const char byte = 0;
+        ::send(wake_socket, &byte, 1, 0);
+    }
+
+    void Loop() {
+        Common::SetCurrentThreadName("SocketPoller");
+
+        std::vector<pollfd> fds;
+        // The wait of each socket in fds, after the wake socket
+        std::vector<u64> ids;
+        while (true) {
+            fds.clear();
+            ids.clear();
+            {
+                std::lock_guard lock{mutex};
+                if (stop) {
+                    return;
+                }
+                pollfd& wake_fd = fds.emplace_back();
+                wake_fd.fd = wake_socket;
+                wake_fd.events = POLLIN;
+                for (const auto& [id, wait_fds] : waits) {
+                    fds.insert(fds.end(), wait_fds.begin(), wait_fds.end());
+                    ids.insert(ids.end(), wait_fds.size(), id);
+                }
+            }
+
+            // Without the wake socket, new waits are picked up periodically
+            s32 ret = ::poll(fds.data(), static_cast<u32>(fds.size()), can_wake ? -1 : 10);
+            if (ret <= 0) {
+                continue;
+            }
+            if (fds[0].revents != 0) {
+                char byte;
+                ::recv(wake_socket, &byte, 1, 0);
+            }
+
+            std::lock_guard lock{mutex};
+            for (std::size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents != 0 && waits.erase(ids[i - 1]) != 0) {
+                    ready_callback(ids[i - 1]);
+                }
+            }
+        }
+    }
+
+    ReadyCallback ready_callback;
+    decltype(pollfd::fd) wake_socket;
+    bool can_wake = true;
+
+    std::mutex mutex;
+    std::unordered_map<u64, std::vector<pollfd>> waits;
+    bool stop = false;
+    std::thread thread;
+};
+
+bool SOC_U::WouldBlock(u32 socket_handle, short events) {
+    auto iter = open_sockets.find(socket_handle);
+    if (resuming_wait || iter == open_sockets.end() || !iter->second.blocking) {
+        return false;
+    }
+    pollfd fd{};
+    fd.fd = socket_handle;
+    fd.events = events;
+    s32 ret = ::poll(&fd, 1, 0);
+    return ret == 0;
+}
+
+void SOC_U::WaitForSockets(Kernel::HLERequestContext& ctx, std::vector<pollfd> fds,
+                           s64 timeout_ms, void (SOC_U::*handler)(Kernel::HLERequestContext& ctx)) {
+    const u64 id = next_wait_id++;
+    socket_waits[id] = ctx.SleepClientThread(
+        system.Kernel().GetThreadManager().GetCurrentThread(), "soc:U::WaitForSockets",
+        std::chrono::milliseconds(timeout_ms),
+        [this, id, handler](Kernel::SharedPtr<Kernel::Thread> thread,
+                            Kernel::HLERequestContext& ctx, Kernel::ThreadWakeupReason reason) {
+            poller->Remove(id);
+            socket_waits.erase(id);
+            resuming_wait = true;
+            (this->*handler)(ctx);
+            resuming_wait = false;
+        });
+    poller->Add(id, std::move(fds));
+}
+
 void SOC_U::CleanupSockets() {
     for (auto sock : open_sockets)
         closesocket(sock.second.socket_fd);
@@ -445,6 +588,9 @@ void SOC_U::Fcntl(Kernel::HLERequestContext& ctx) {
             posix_ret = TranslateError(GET_ERRNO);
             return;
         }
+        auto iter = open_sockets.find(socket_handle);
+        if (iter != open_sockets.end())
+            iter->second.blocking = (ctr_arg & 4) == 0;
 #endif
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command ({}) in fcntl call", ctr_cmd);
@@ -469,13 +615,18 @@ void SOC_U::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x04, 2, 2);
     u32 socket_handle = rp.Pop<u32>();
     socklen_t max_addr_len = static_cast<socklen_t>(rp.Pop<u32>());
     rp.PopPID();
+
+    if (WouldBlock(socket_handle, POLLIN)) {
+        pollfd fd{};
+        fd.fd = socket_handle;
+        fd.events = POLLIN;
+        WaitForSockets(ctx, {fd}, -1, &SOC_U::Accept);
+        return;
+    }
     sockaddr addr;
     socklen_t addr_len = sizeof(addr);
     u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
@@ -574,6 +725,14 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
     rp.PopPID();
     auto& buffer = rp.PopMappedBuffer();
 
+    if (WouldBlock(socket_handle, POLLIN)) {
+        pollfd fd{};
+        fd.fd = socket_handle;
+        fd.events = POLLIN;
+        WaitForSockets(ctx, {fd}, -1, &SOC_U::RecvFromOther);
+        return;
+    }
+
     CTRSockAddr ctr_src_addr;
     std::vector<u8> output_buff(len);
     std::vector<u8> addr_buff(sizeof(ctr_src_addr));
@@ -608,9 +767,6 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x08, 4, 2);
     u32 socket_handle = rp.Pop<u32>();
     u32 len = rp.Pop<u32>();
@@ -618,6 +774,14 @@ void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
 
+    if (WouldBlock(socket_handle, POLLIN)) {
+        pollfd fd{};
+        fd.fd = socket_handle;
+        fd.events = POLLIN;
+        WaitForSockets(ctx, {fd}, -1, &SOC_U::RecvFrom);
+        return;
+    }
+
     CTRSockAddr ctr_src_addr;
     std::vector<u8> output_buff(len);
     std::vector<u8> addr_buff(sizeof(ctr_src_addr));
@@ -672,7 +836,12 @@ void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
     std::vector<pollfd> platform_pollfd(nfds);
     std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
 
-    s32 ret = ::poll(platform_pollfd.data(), nfds, timeout);
+    // The guest thread waits for the timeout instead of the emulation thread
+    s32 ret = ::poll(platform_pollfd.data(), nfds, 0);
+    if (ret == 0 && timeout != 0 && !resuming_wait) {
+        WaitForSockets(ctx, std::move(platform_pollfd), timeout, &SOC_U::Poll);
+        return;
+    }
 
     // Now update the output pollfd structure
     std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
@@ -858,7 +1027,7 @@ void SOC_U::SetSockOpt(Kernel::HLERequestContext& ctx) {
     rb.Push(err);
 }
 
-SOC_U::SOC_U() : ServiceFramework("soc:U") {
+SOC_U::SOC_U(Core::System& system) : ServiceFramework("soc:U"), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010044, &SOC_U::InitializeSockets, "InitializeSockets"},
         {0x000200C2, &SOC_U::Socket, "Socket"},
@@ -901,9 +1070,24 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
 #endif
+
+    // Resumes the guest thread of a wait, on the emulation thread
+    socket_ready_event =
+        system.CoreTiming().RegisterEvent("SOC_U::SocketReady", [this](u64 id, s64) {
+            auto iter = socket_waits.find(id);
+            if (iter != socket_waits.end()) {
+                Kernel::SharedPtr<Kernel::Event> event = std::move(iter->second);
+                socket_waits.erase(iter);
+                event->Signal();
+            }
+        });
+    poller = std::make_unique<SocketPoller>([this](u64 id) {
+        this->system.CoreTiming().ScheduleEventThreadsafe(0, socket_ready_event, id);
+    });
 }
 
 SOC_U::~SOC_U() {
+    poller.reset();
     CleanupSockets();
 #ifdef _WIN32
     WSACleanup();
@@ -912,7 +1096,7 @@ SOC_U::~SOC_U() {
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<SOC_U>()->InstallAsService(service_manager);
+    std::make_shared<SOC_U>(system)->InstallAsService(service_manager);
 }
 
 } // namespace Service::SOC
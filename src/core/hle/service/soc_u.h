@@ -4,24 +4,32 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
+#include "core/hle/kernel/event.h"
 #include "core/hle/service/service.h"
 
+struct pollfd;
+
 namespace Core {
 class System;
-}
+struct TimingEventType;
+} // namespace Core
 
 namespace Service::SOC {
 
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    bool blocking; ///< Whether the socket is blocking or not
 };
 
+class SocketPoller;
+
 class SOC_U final : public ServiceFramework<SOC_U> {
 public:
-    SOC_U();
+    explicit SOC_U(Core::System& system);
     ~SOC_U();
 
 private:
@@ -48,8 +56,30 @@ private:
     /// Close all open sockets
     void CleanupSockets();
 
+    /// Whether a call on a blocking socket would wait for the events to happen
+    bool WouldBlock(u32 socket_handle, short events);
+
+    /**
+     * Suspends the calling guest thread until one of the sockets is ready or the timeout expires,
+     * instead of blocking the emulation thread. The handler is then called again for the request,
+     * and must not wait a second time.
+     * @param timeout_ms timeout in emulated milliseconds, negative to wait forever
+     */
+    void WaitForSockets(Kernel::HLERequestContext& ctx, std::vector<pollfd> fds, s64 timeout_ms,
+                        void (SOC_U::*handler)(Kernel::HLERequestContext& ctx));
+
+    Core::System& system;
+
     /// Holds info about the currently open sockets
     std::unordered_map<u32, SocketHolder> open_sockets;
+
+    std::unique_ptr<SocketPoller> poller;
+    Core::TimingEventType* socket_ready_event;
+    /// Events resuming the guest threads waiting on sockets, by wait id
+    std::unordered_map<u64, Kernel::SharedPtr<Kernel::Event>> socket_waits;
+    u64 next_wait_id = 0;
+    /// Whether a handler is called again after WaitForSockets
+    bool resuming_wait = false;
 };
 
 void InstallInterfaces(Core::System& system);
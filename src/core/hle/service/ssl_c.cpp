@@ -7,6 +7,7 @@
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/service/ssl_c.h"
+#include "core/settings.h"
 
 namespace Service::SSL {
 
@@ -15,8 +16,12 @@ void SSL_C::Initialize(Kernel::HLERequestContext& ctx) {
     rp.PopPID();
 
     // Seed random number generator when the SSL service is initialized
-    std::random_device rand_device;
-    rand_gen.seed(rand_device());
+    if (Settings::values.deterministic) {
+        rand_gen.seed();
+    } else {
+        std::random_device rand_device;
+        rand_gen.seed(rand_device());
+    }
 
     // Stub, return success
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
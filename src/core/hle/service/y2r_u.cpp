@@ -11,6 +11,11 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
+#include "core/memory.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 namespace Service::Y2R {
 
@@ -501,13 +506,24 @@ void Y2R_U::GetDitheringWeightParams(Kernel::HLERequestContext& ctx) {
 void Y2R_U::StartConversion(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x26, 0, 0);
 
-    // dst_image_size would seem to be perfect for this, but it doesn't include the gap :(
-    u32 total_output_size =
-        conversion.input_lines * (conversion.dst.transfer_unit + conversion.dst.gap);
-    Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
-                                         Memory::FlushMode::FlushAndInvalidate);
+    // Conversions done by the rasterizer leave their output in its cache, so that images used as
+    // textures, like video frames, are neither read back nor uploaded again
+    bool accelerated = false;
+    if (VideoCore::g_renderer != nullptr) {
+        VideoCore::RunOnGPUThreadSync([this, &accelerated] {
+            accelerated = VideoCore::g_renderer->Rasterizer()->AccelerateY2RConversion(conversion);
+        });
+    }
+
+    if (!accelerated) {
+        // dst_image_size would seem to be perfect for this, but it doesn't include the gap :(
+        u32 total_output_size =
+            conversion.input_lines * (conversion.dst.transfer_unit + conversion.dst.gap);
+        Memory::RasterizerFlushVirtualRegion(conversion.dst.address, total_output_size,
+                                             Memory::FlushMode::FlushAndInvalidate);
 
-    HW::Y2R::PerformConversion(conversion);
+        HW::Y2R::PerformConversion(conversion);
+    }
 
     completion_event->Signal();
 
@@ -17,6 +17,7 @@
 #include "core/hle/service/fs/archive.h"
 #include "core/hw/aes/arithmetic128.h"
 #include "core/hw/aes/key.h"
+#include "core/hw/aes/stream.h"
 
 namespace HW {
 namespace AES {
@@ -448,6 +449,7 @@ void InitKeys() {
     LoadNativeFirmKeysOld3DS();
     LoadNativeFirmKeysNew3DS();
     LoadPresetKeys();
+    LOG_INFO(HW_AES, "Using the {} AES implementation", GetImplementationName());
     initialized = true;
 }
 
@@ -0,0 +1,88 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include "core/hw/aes/stream.h"
+
+namespace HW {
+namespace AES {
+
+struct CTRDecryptor::Impl {
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption cipher;
+};
+
+CTRDecryptor::CTRDecryptor(const AESKey& key, const AESKey& ctr) : impl(std::make_unique<Impl>()) {
+    impl->cipher.SetKeyWithIV(key.data(), key.size(), ctr.data());
+}
+
+CTRDecryptor::~CTRDecryptor() = default;
+CTRDecryptor::CTRDecryptor(CTRDecryptor&&) noexcept = default;
+CTRDecryptor& CTRDecryptor::operator=(CTRDecryptor&&) noexcept = default;
+
+void CTRDecryptor::Seek(u64 offset) {
+    impl->cipher.Seek(offset);
+}
+
+void CTRDecryptor::Process(u8* data, std::size_t size) {
+    if (size == 0)
+        return; // Crypto++ does not like zero size buffer
+    impl->cipher.ProcessData(data, data, size);
+}
+
+struct CBCDecryptor::Impl {
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption cipher;
+    std::array<u8, AES_BLOCK_SIZE> partial_block;
+    std::size_t partial_size = 0;
+};
+
+CBCDecryptor::CBCDecryptor(const AESKey& key, const AESKey& iv) : impl(std::make_unique<Impl>()) {
+    impl->cipher.SetKeyWithIV(key.data(), key.size(), iv.data());
+}
+
+CBCDecryptor::~CBCDecryptor() = default;
+CBCDecryptor::CBCDecryptor(CBCDecryptor&&) noexcept = default;
+CBCDecryptor& CBCDecryptor::operator=(CBCDecryptor&&) noexcept = default;
+
+std::size_t CBCDecryptor::Process(const u8* in, u8* out, std::size_t size) {
+    std::size_t written = 0;
+    if (impl->partial_size != 0) {
+        const std::size_t fill = std::min(size, AES_BLOCK_SIZE - impl->partial_size);
+        std::memcpy(impl->partial_block.data() + impl->partial_size, in, fill);
+        impl->partial_size += fill;
+        in += fill;
+        size -= fill;
+        if (impl->partial_size < AES_BLOCK_SIZE)
+            return 0;
+
+        // The completed block goes first in out, which pushes the rest of the data one block
+        // further. Move it there before decrypting, as out may be the same buffer as in.
+        std::memmove(out + AES_BLOCK_SIZE, in, size);
+        in = out + AES_BLOCK_SIZE;
+        impl->cipher.ProcessData(out, impl->partial_block.data(), AES_BLOCK_SIZE);
+        impl->partial_size = 0;
+        out += AES_BLOCK_SIZE;
+        written += AES_BLOCK_SIZE;
+    }
+
+    const std::size_t whole_size = size - size % AES_BLOCK_SIZE;
+    impl->partial_size = size - whole_size;
+    std::memcpy(impl->partial_block.data(), in + whole_size, impl->partial_size);
+    if (whole_size != 0) {
+        impl->cipher.ProcessData(out, in, whole_size);
+        written += whole_size;
+    }
+    return written;
+}
+
+std::string GetImplementationName() {
+    // Crypto++ picks AES-NI or the ARMv8 crypto extensions at runtime when the CPU has them
+    return CryptoPP::AES::Encryption().AlgorithmProvider();
+}
+
+} // namespace AES
+} // namespace HW
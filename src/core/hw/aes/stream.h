@@ -0,0 +1,71 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "common/common_types.h"
+#include "core/hw/aes/key.h"
+
+namespace HW {
+namespace AES {
+
+/**
+ * AES-128-CTR decryption of a stream of data, such as an NCCH section or a RomFS. The key schedule
+ * is computed once, so a stream that is read piece by piece should keep one instance and seek it
+ * instead of setting up a new cipher for every piece.
+ */
+class CTRDecryptor {
+public:
+    CTRDecryptor(const AESKey& key, const AESKey& ctr);
+    ~CTRDecryptor();
+
+    CTRDecryptor(CTRDecryptor&&) noexcept;
+    CTRDecryptor& operator=(CTRDecryptor&&) noexcept;
+
+    /// Moves the keystream to the given byte offset from the start of the stream
+    void Seek(u64 offset);
+
+    /// Decrypts the next size bytes of the stream in place
+    void Process(u8* data, std::size_t size);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/**
+ * AES-128-CBC decryption of a stream of data that arrives in pieces, such as a CIA content being
+ * installed. The chaining state carries over from one call of Process to the next, and so do the
+ * bytes of a block that was split between two calls.
+ */
+class CBCDecryptor {
+public:
+    CBCDecryptor(const AESKey& key, const AESKey& iv);
+    ~CBCDecryptor();
+
+    CBCDecryptor(CBCDecryptor&&) noexcept;
+    CBCDecryptor& operator=(CBCDecryptor&&) noexcept;
+
+    /**
+     * Decrypts the next size bytes of the stream. Only whole blocks are decrypted, the bytes of a
+     * trailing partial block are kept until the next call completes it.
+     * @param out buffer of at least size bytes, plus AES_BLOCK_SIZE - 1 if the previous call left a
+     * partial block. May be the same as in.
+     * @returns the number of bytes written to out
+     */
+    std::size_t Process(const u8* in, u8* out, std::size_t size);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/// Name of the AES implementation Crypto++ selected for this CPU, e.g. "AESNI", "ARMv8" or "C++"
+std::string GetImplementationName();
+
+} // namespace AES
+} // namespace HW
@@ -2,23 +2,40 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <numeric>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+#include "audio_core/dsp_interface.h"
 #include "common/alignment.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/swap.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "core/hle/service/hid/hid.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
+#include "core/hw/lcd.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -33,6 +50,7 @@ Memory::MemorySystem* g_memory;
 const u64 frame_ticks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_RATE);
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+static FrameHashCallback frame_hash_callback;
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -48,32 +66,24 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Math::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
+MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
+MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
-    case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
+/// Writes a repeating pattern of bytes to [start, start + size), a pattern block at a time
+static void FillMemory(u8* start, std::size_t size, const u8* pattern, std::size_t pattern_size) {
+    // Large enough for wide stores, and a multiple of the 2, 3 and 4 byte fill patterns
+    constexpr std::size_t block_size = 192;
+    std::array<u8, block_size> block;
+    for (std::size_t i = 0; i < block_size; i += pattern_size) {
+        std::memcpy(&block[i], pattern, pattern_size);
+    }
 
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", static_cast<u32>(input_format));
-        return {0, 0, 0, 0};
+    for (; size >= block_size; size -= block_size, start += block_size) {
+        std::memcpy(start, block.data(), block_size);
     }
+    std::memcpy(start, block.data(), size);
 }
 
-MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
-MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
-
 static void MemoryFill(const Regs::MemoryFillConfig& config) {
     const PAddr start_addr = config.GetStartAddress();
     const PAddr end_addr = config.GetEndAddress();
@@ -104,26 +114,298 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
+    const std::size_t size = end - start;
     if (config.fill_24bit) {
-        // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
-        }
+        // fill with 24-bit values, the last one is written whole even if it crosses the end
+        const std::array<u8, 3> value{static_cast<u8>(config.value_24bit_r),
+                                      static_cast<u8>(config.value_24bit_g),
+                                      static_cast<u8>(config.value_24bit_b)};
+        FillMemory(start, Common::AlignUp(size, 3), value.data(), value.size());
     } else if (config.fill_32bit) {
         // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-        }
+        const u32 value = config.value_32bit;
+        FillMemory(start, Common::AlignDown(size, sizeof(u32)), reinterpret_cast<const u8*>(&value),
+                   sizeof(u32));
     } else {
         // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            memcpy(ptr, &value_16bit, sizeof(u16));
+        const u16 value_16bit = config.value_16bit.Value();
+        FillMemory(start, Common::AlignUp(size, sizeof(u16)),
+                   reinterpret_cast<const u8*>(&value_16bit), sizeof(u16));
+    }
+}
+
+/**
+ * Display transfers convert pixels through an intermediate RGBA8 value, packed as
+ * (r << 24) | (g << 16) | (b << 8) | a like the RGBA8 format in memory. The conversions are
+ * equivalent to the Color::Decode and Color::Encode functions, written with masks and shifts so
+ * that compilers can vectorize them.
+ */
+template <Regs::PixelFormat format>
+static u32 DecodePixel(const u8* src) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
+        u32_le pixel;
+        std::memcpy(&pixel, src, sizeof(pixel));
+        return pixel;
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
+        return (static_cast<u32>(src[2]) << 24) | (static_cast<u32>(src[1]) << 16) |
+               (static_cast<u32>(src[0]) << 8) | 0xFF;
+    } else {
+        u16_le stored;
+        std::memcpy(&stored, src, sizeof(stored));
+        const u32 pixel = stored;
+        u32 r, g, b, a;
+        if constexpr (format == Regs::PixelFormat::RGB565) {
+            r = Color::Convert5To8((pixel >> 11) & 0x1F);
+            g = Color::Convert6To8((pixel >> 5) & 0x3F);
+            b = Color::Convert5To8(pixel & 0x1F);
+            a = 255;
+        } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
+            r = Color::Convert5To8((pixel >> 11) & 0x1F);
+            g = Color::Convert5To8((pixel >> 6) & 0x1F);
+            b = Color::Convert5To8((pixel >> 1) & 0x1F);
+            a = Color::Convert1To8(pixel & 0x1);
+        } else {
+            r = Color::Convert4To8((pixel >> 12) & 0xF);
+            g = Color::Convert4To8((pixel >> 8) & 0xF);
+            b = Color::Convert4To8((pixel >> 4) & 0xF);
+            a = Color::Convert4To8(pixel & 0xF);
+        }
+        return (r << 24) | (g << 16) | (b << 8) | a;
+    }
+}
+
+template <Regs::PixelFormat format>
+static void EncodePixel(u32 color, u8* dst) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
+        const u32_le pixel = color;
+        std::memcpy(dst, &pixel, sizeof(pixel));
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
+        dst[0] = static_cast<u8>(color >> 8);
+        dst[1] = static_cast<u8>(color >> 16);
+        dst[2] = static_cast<u8>(color >> 24);
+    } else {
+        u16_le pixel;
+        if constexpr (format == Regs::PixelFormat::RGB565) {
+            pixel = static_cast<u16>(((color >> 16) & 0xF800) | ((color >> 13) & 0x07E0) |
+                                     ((color >> 11) & 0x001F));
+        } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
+            pixel = static_cast<u16>(((color >> 16) & 0xF800) | ((color >> 13) & 0x07C0) |
+                                     ((color >> 10) & 0x003E) | ((color >> 7) & 0x0001));
+        } else {
+            pixel = static_cast<u16>(((color >> 16) & 0xF000) | ((color >> 12) & 0x0F00) |
+                                     ((color >> 8) & 0x00F0) | ((color >> 4) & 0x000F));
+        }
+        std::memcpy(dst, &pixel, sizeof(pixel));
+    }
+}
+
+/// Position in its tile of each pixel of an 8x8 tile, in the Morton order they are stored in
+struct TilePixel {
+    u8 x;
+    u8 y;
+};
+
+static const std::array<TilePixel, 64> tile_pixels = [] {
+    std::array<TilePixel, 64> pixels{};
+    for (u8 y = 0; y < 8; ++y) {
+        for (u8 x = 0; x < 8; ++x) {
+            pixels[VideoCore::MortonInterleave(x, y)] = {x, y};
+        }
+    }
+    return pixels;
+}();
+
+/**
+ * Decodes the lines [first_line, first_line + num_lines) of an image into RGBA8 values, stored
+ * line by line. Tiled images are read a whole tile at a time, in the order they are stored in.
+ * @param image pointer to the image in memory
+ * @param stride width of the image in memory, in pixels
+ * @param width number of pixels decoded from each line
+ */
+template <Regs::PixelFormat format>
+static void DecodeLines(const u8* image, bool tiled, u32 stride, u32 width, u32 first_line,
+                        u32 num_lines, u32* output) {
+    constexpr u32 bpp = static_cast<u32>(Regs::BytesPerPixel(format));
+    const u32 end_line = first_line + num_lines;
+    if (!tiled) {
+        for (u32 y = first_line; y < end_line; ++y) {
+            const u8* line = image + y * stride * bpp;
+            for (u32 x = 0; x < width; ++x) {
+                output[x] = DecodePixel<format>(line + x * bpp);
+            }
+            output += width;
+        }
+        return;
+    }
+
+    for (u32 tile_y = first_line & ~7; tile_y < end_line; tile_y += 8) {
+        const bool whole_lines = tile_y >= first_line && tile_y + 8 <= end_line;
+        const u8* tile = image + tile_y * stride * bpp;
+        for (u32 tile_x = 0; tile_x < width; tile_x += 8, tile += 64 * bpp) {
+            if (whole_lines && tile_x + 8 <= width) {
+                u32* tile_output = output + (tile_y - first_line) * width + tile_x;
+                for (u32 i = 0; i < 64; ++i) {
+                    tile_output[tile_pixels[i].y * width + tile_pixels[i].x] =
+                        DecodePixel<format>(tile + i * bpp);
+                }
+                continue;
+            }
+            for (u32 i = 0; i < 64; ++i) {
+                const u32 x = tile_x + tile_pixels[i].x;
+                const u32 y = tile_y + tile_pixels[i].y;
+                if (x < width && y >= first_line && y < end_line) {
+                    output[(y - first_line) * width + x] = DecodePixel<format>(tile + i * bpp);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Encodes RGBA8 values into the lines [first_line, first_line + num_lines) of an image, whose
+ * width is its stride. Tiled images are written a whole tile at a time.
+ * @param lines the values to encode to each line, num_lines pointers to width values
+ */
+template <Regs::PixelFormat format>
+static void EncodeLines(const u32* const* lines, u8* image, bool tiled, u32 width, u32 first_line,
+                        u32 num_lines) {
+    constexpr u32 bpp = static_cast<u32>(Regs::BytesPerPixel(format));
+    const u32 end_line = first_line + num_lines;
+    if (!tiled) {
+        for (u32 y = first_line; y < end_line; ++y) {
+            const u32* input = lines[y - first_line];
+            u8* line = image + y * width * bpp;
+            for (u32 x = 0; x < width; ++x) {
+                EncodePixel<format>(input[x], line + x * bpp);
+            }
+        }
+        return;
+    }
+
+    for (u32 tile_y = first_line & ~7; tile_y < end_line; tile_y += 8) {
+        const bool whole_lines = tile_y >= first_line && tile_y + 8 <= end_line;
+        u8* tile = image + tile_y * width * bpp;
+        for (u32 tile_x = 0; tile_x < width; tile_x += 8, tile += 64 * bpp) {
+            if (whole_lines && tile_x + 8 <= width) {
+                const u32* const* tile_lines = lines + (tile_y - first_line);
+                for (u32 i = 0; i < 64; ++i) {
+                    EncodePixel<format>(tile_lines[tile_pixels[i].y][tile_x + tile_pixels[i].x],
+                                        tile + i * bpp);
+                }
+                continue;
+            }
+            for (u32 i = 0; i < 64; ++i) {
+                const u32 x = tile_x + tile_pixels[i].x;
+                const u32 y = tile_y + tile_pixels[i].y;
+                if (x < width && y >= first_line && y < end_line) {
+                    EncodePixel<format>(lines[y - first_line][x], tile + i * bpp);
+                }
+            }
+        }
+    }
+}
+
+using DecodeLinesFunc = void (*)(const u8*, bool, u32, u32, u32, u32, u32*);
+using EncodeLinesFunc = void (*)(const u32* const*, u8*, bool, u32, u32, u32);
+
+static DecodeLinesFunc GetDecodeLinesFunc(Regs::PixelFormat format) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        return DecodeLines<Regs::PixelFormat::RGBA8>;
+    case Regs::PixelFormat::RGB8:
+        return DecodeLines<Regs::PixelFormat::RGB8>;
+    case Regs::PixelFormat::RGB565:
+        return DecodeLines<Regs::PixelFormat::RGB565>;
+    case Regs::PixelFormat::RGB5A1:
+        return DecodeLines<Regs::PixelFormat::RGB5A1>;
+    case Regs::PixelFormat::RGBA4:
+        return DecodeLines<Regs::PixelFormat::RGBA4>;
+    }
+    return nullptr;
+}
+
+static EncodeLinesFunc GetEncodeLinesFunc(Regs::PixelFormat format) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        return EncodeLines<Regs::PixelFormat::RGBA8>;
+    case Regs::PixelFormat::RGB8:
+        return EncodeLines<Regs::PixelFormat::RGB8>;
+    case Regs::PixelFormat::RGB565:
+        return EncodeLines<Regs::PixelFormat::RGB565>;
+    case Regs::PixelFormat::RGB5A1:
+        return EncodeLines<Regs::PixelFormat::RGB5A1>;
+    case Regs::PixelFormat::RGBA4:
+        return EncodeLines<Regs::PixelFormat::RGBA4>;
+    }
+    return nullptr;
+}
+
+/**
+ * Downscales RGBA8 lines by averaging each pair of pixels, or each 2x2 block when a second line
+ * is given. The averages are truncated like the hardware does.
+ * @param width number of output pixels
+ */
+static void DownscaleLine(const u32* line0, const u32* line1, u32* output, u32 width) {
+    u32 x = 0;
+#if defined(ARCHITECTURE_x86_64)
+    const __m128i zero = _mm_setzero_si128();
+    // Sums of the pixel pairs of 4 input pixels, as 16-bit components
+    const auto sum_pairs = [zero](const u32* input) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        const __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        const __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        return _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+    };
+    for (; x + 4 <= width; x += 4) {
+        __m128i sum_low = sum_pairs(line0 + x * 2);
+        __m128i sum_high = sum_pairs(line0 + x * 2 + 4);
+        if (line1 != nullptr) {
+            sum_low = _mm_srli_epi16(_mm_add_epi16(sum_low, sum_pairs(line1 + x * 2)), 2);
+            sum_high = _mm_srli_epi16(_mm_add_epi16(sum_high, sum_pairs(line1 + x * 2 + 4)), 2);
+        } else {
+            sum_low = _mm_srli_epi16(sum_low, 1);
+            sum_high = _mm_srli_epi16(sum_high, 1);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x),
+                         _mm_packus_epi16(sum_low, sum_high));
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    for (; x + 4 <= width; x += 4) {
+        // Even and odd pixels of 8 input pixels
+        const uint32x4x2_t pixels0 = vld2q_u32(line0 + x * 2);
+        const uint8x16_t even0 = vreinterpretq_u8_u32(pixels0.val[0]);
+        const uint8x16_t odd0 = vreinterpretq_u8_u32(pixels0.val[1]);
+        uint8x16_t average;
+        if (line1 != nullptr) {
+            const uint32x4x2_t pixels1 = vld2q_u32(line1 + x * 2);
+            const uint8x16_t even1 = vreinterpretq_u8_u32(pixels1.val[0]);
+            const uint8x16_t odd1 = vreinterpretq_u8_u32(pixels1.val[1]);
+            const uint16x8_t sum_low =
+                vaddq_u16(vaddl_u8(vget_low_u8(even0), vget_low_u8(odd0)),
+                          vaddl_u8(vget_low_u8(even1), vget_low_u8(odd1)));
+            const uint16x8_t sum_high =
+                vaddq_u16(vaddl_u8(vget_high_u8(even0), vget_high_u8(odd0)),
+                          vaddl_u8(vget_high_u8(even1), vget_high_u8(odd1)));
+            average = vcombine_u8(vshrn_n_u16(sum_low, 2), vshrn_n_u16(sum_high, 2));
+        } else {
+            average = vhaddq_u8(even0, odd0);
+        }
+        vst1q_u32(output + x, vreinterpretq_u32_u8(average));
+    }
+#endif
+    for (; x < width; ++x) {
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            u32 sum = ((line0[x * 2] >> shift) & 0xFF) + ((line0[x * 2 + 1] >> shift) & 0xFF);
+            if (line1 != nullptr) {
+                sum += ((line1[x * 2] >> shift) & 0xFF) + ((line1[x * 2 + 1] >> shift) & 0xFF);
+                sum /= 4;
+            } else {
+                sum /= 2;
+            }
+            result |= sum << shift;
+        }
+        output[x] = result;
     }
 }
 
@@ -181,6 +463,20 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
         return;
     }
 
+    const DecodeLinesFunc decode_lines = GetDecodeLinesFunc(config.input_format);
+    if (decode_lines == nullptr) {
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}",
+                  static_cast<u32>(config.input_format.Value()));
+        return;
+    }
+
+    const EncodeLinesFunc encode_lines = GetEncodeLinesFunc(config.output_format);
+    if (encode_lines == nullptr) {
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                  static_cast<u32>(config.output_format.Value()));
+        return;
+    }
+
     int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
     int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
 
@@ -194,112 +490,53 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Math::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+    const bool flip = config.flip_vertically;
+
+    // Linear copies to the same format are plain copies of each line
+    if (!input_tiled && !output_tiled && config.input_format == config.output_format) {
+        const u32 bpp = GPU::Regs::BytesPerPixel(config.input_format);
+        for (u32 y = 0; y < output_height; ++y) {
+            const u32 output_y = flip ? output_height - y - 1 : y;
+            std::memcpy(dst_pointer + output_y * output_width * bpp,
+                        src_pointer + y * config.input_width * bpp, output_width * bpp);
+        }
+        return;
+    }
 
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Math::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Math::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Math::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Math::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+    // The output is converted a row of tiles at a time, from the input lines that make it up.
+    // Downscaling reads each tiled 2x1 or 2x2 block of input pixels from consecutive lines.
+    const u32 input_width = output_width << horizontal_scale;
+    std::vector<u32> input_lines(input_width * (8 << vertical_scale));
+    std::vector<u32> scaled_lines(config.scaling != config.NoScale ? output_width * 8 : 0);
+    std::array<const u32*, 8> output_lines;
+
+    for (u32 first_line = 0; first_line < output_height; first_line += 8) {
+        const u32 num_lines = std::min(output_height - first_line, 8u);
+
+        // Lines of the output before flipping
+        const u32 first_y = flip ? output_height - first_line - num_lines : first_line;
+        const u32 first_input_y = first_y << vertical_scale;
+        const u32 num_input_lines = num_lines << vertical_scale;
+        decode_lines(src_pointer, input_tiled, config.input_width, input_width, first_input_y,
+                     num_input_lines, input_lines.data());
+
+        for (u32 i = 0; i < num_lines; ++i) {
+            const u32 y = flip ? output_height - (first_line + i) - 1 : first_line + i;
+            const u32* line = &input_lines[((y << vertical_scale) - first_input_y) * input_width];
+            if (config.scaling == config.NoScale) {
+                output_lines[i] = line;
+                continue;
             }
 
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
+            u32* scaled_line = &scaled_lines[i * output_width];
+            DownscaleLine(line, config.scaling == config.ScaleXY ? line + input_width : nullptr,
+                          scaled_line, output_width);
+            output_lines[i] = scaled_line;
         }
+        encode_lines(output_lines.data(), dst_pointer, output_tiled, output_width, first_line,
+                     num_lines);
     }
 }
 
@@ -385,6 +622,13 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/// Signals a GSP interrupt, unless there is no running system, e.g. when replaying a CiTrace
+static void SignalGSPInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (Core::System::GetInstance().IsPoweredOn()) {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -407,7 +651,11 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
+            {
+                Core::PerfStats::ScopedPhase phase(Core::System::GetInstance().perf_stats,
+                                                   Core::FramePhase::GPU);
+                VideoCore::RunOnGPUThreadSync([&config] { MemoryFill(config); });
+            }
             LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
                       config.GetEndAddress());
 
@@ -415,9 +663,9 @@ inline void Write(u32 addr, const T data) {
             // TODO: hwtest this
             if (config.GetStartAddress() != 0) {
                 if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    SignalGSPInterrupt(Service::GSP::InterruptId::PSC0);
                 } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    SignalGSPInterrupt(Service::GSP::InterruptId::PSC1);
                 }
             }
 
@@ -439,8 +687,11 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
+            Core::PerfStats::ScopedPhase phase(Core::System::GetInstance().perf_stats,
+                                               Core::FramePhase::GPU);
+
             if (config.is_texture_copy) {
-                TextureCopy(config);
+                VideoCore::RunOnGPUThreadSync([&config] { TextureCopy(config); });
                 LOG_TRACE(HW_GPU,
                           "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
                           "{:#010X}({}+{}), flags {:#010X}",
@@ -449,7 +700,7 @@ inline void Write(u32 addr, const T data) {
                           config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
                           config.texture_copy.output_gap * 16, config.flags);
             } else {
-                DisplayTransfer(config);
+                VideoCore::RunOnGPUThreadSync([&config] { DisplayTransfer(config); });
                 LOG_TRACE(HW_GPU,
                           "DisplayTransfer: {:#010X}({}x{})-> "
                           "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
@@ -460,7 +711,7 @@ inline void Write(u32 addr, const T data) {
             }
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            SignalGSPInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -478,7 +729,17 @@ inline void Write(u32 addr, const T data) {
                                                                 config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            if (VideoCore::g_gpu_thread) {
+                // The guest is free to reuse the buffer once the list has been submitted, so the
+                // GPU thread works on a copy
+                std::vector<u32> list(buffer, buffer + config.size / sizeof(u32));
+                VideoCore::g_gpu_thread->Push([list = std::move(list)] {
+                    Pica::CommandProcessor::ProcessCommandList(
+                        list.data(), static_cast<u32>(list.size() * sizeof(u32)));
+                });
+            } else {
+                Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            }
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -510,9 +771,95 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
+DisplayedFramebuffer GetDisplayedFramebuffer(std::size_t screen) {
+    const auto& framebuffer = g_regs.framebuffer_config[screen];
+    const PAddr address =
+        framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const u32 size = framebuffer.stride * framebuffer.height;
+    if (size == 0 || !g_memory->IsValidPhysicalAddress(address) ||
+        !g_memory->IsValidPhysicalAddress(address + size - 1)) {
+        return {address, 0};
+    }
+    return {address, size};
+}
+
+/// Flushes what the screens display from the rasterizer to guest memory
+static void FlushFramebuffers() {
+    for (std::size_t i = 0; i < 2; ++i) {
+        const DisplayedFramebuffer framebuffer = GetDisplayedFramebuffer(i);
+        if (framebuffer.size != 0) {
+            Memory::RasterizerFlushRegion(framebuffer.address, framebuffer.size);
+        }
+    }
+}
+
+/// Hashes what the screens display, flushing it from the rasterizer to guest memory first
+static u64 HashFramebuffers() {
+    FlushFramebuffers();
+
+    // The content hash, format and size of each screen
+    std::array<u64, 4> screens{};
+    for (std::size_t i = 0; i < screens.size() / 2; ++i) {
+        const DisplayedFramebuffer displayed = GetDisplayedFramebuffer(i);
+        if (displayed.size != 0) {
+            screens[i * 2] = Common::ComputeHash64(g_memory->GetPhysicalPointer(displayed.address),
+                                                   displayed.size);
+        }
+        const auto& framebuffer = g_regs.framebuffer_config[i];
+        screens[i * 2 + 1] = static_cast<u64>(framebuffer.format) << 32 | framebuffer.size;
+    }
+    return Common::ComputeHash64(screens.data(), sizeof(screens));
+}
+
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    auto& system = Core::System::GetInstance();
+    system.perf_stats.SetAudioLatency(system.DSP().GetOutputLatency());
+    system.perf_stats.EndSystemFrame();
+
+    // The GPU thread is disabled in deterministic mode, the rendering is done at this point
+    if (frame_hash_callback && Settings::values.deterministic) {
+        frame_hash_callback(HashFramebuffers());
+    }
+
+    RendererBase::ScreenConfig screen_config;
+    std::copy(std::begin(g_regs.framebuffer_config), std::end(g_regs.framebuffer_config),
+              screen_config.framebuffers.begin());
+    screen_config.color_fills = {LCD::g_regs.color_fill_top, LCD::g_regs.color_fill_bottom};
+    // All the guest visible GPU work was submitted already, so only the presentation is skipped
+    screen_config.skip = system.frame_limiter.ShouldSkipFrame(Settings::values.max_frame_skip);
+    if (screen_config.skip) {
+        system.perf_stats.AddSkippedFrame();
+    }
+    const auto present = [screen_config] { VideoCore::g_renderer->SwapBuffers(screen_config); };
+
+    // Presenting reads the rendered frame, it is queued after all the submitted command lists.
+    // When asynchronous, the GPU thread is kept from falling more than a few frames behind.
+    // Frame advancing presents each frame before emulating the next one.
+    if (VideoCore::g_gpu_thread && Settings::values.use_async_present &&
+        !system.frame_limiter.IsFrameAdvancing()) {
+        VideoCore::g_gpu_thread->PushFrame(present);
+    } else {
+        VideoCore::RunOnGPUThreadSync(present);
+    }
+
+    // While emulation is held, the displayed frame can be read from guest memory, e.g. through RPC
+    if (system.frame_limiter.IsFrameAdvancing()) {
+        VideoCore::RunOnGPUThreadSync(FlushFramebuffers);
+    }
+
+    {
+        Core::PerfStats::ScopedPhase limiter_phase(system.perf_stats,
+                                                   Core::FramePhase::FrameLimiter);
+        system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    }
+    system.perf_stats.BeginSystemFrame();
+
+    // Titles usually read the input when woken by the VBlank interrupt, make it as recent as
+    // possible after the frame limiter slept
+    if (const auto hid = Service::HID::GetModule(system)) {
+        hid->LatchInput();
+    }
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -523,7 +870,7 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC1);
 
     // Reschedule recurrent event
-    Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
+    system.CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
 /// Initialize hardware
@@ -557,16 +904,25 @@ void Init(Memory::MemorySystem& memory) {
     framebuffer_sub.color_format.Assign(Regs::PixelFormat::RGB8);
     framebuffer_sub.active_fb = 0;
 
-    Core::Timing& timing = Core::System::GetInstance().CoreTiming();
-    vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
-    timing.ScheduleEvent(frame_ticks, vblank_event);
+    // The CiTrace player presents the frames itself
+    auto& system = Core::System::GetInstance();
+    if (system.IsPoweredOn()) {
+        Core::Timing& timing = system.CoreTiming();
+        vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
+        timing.ScheduleEvent(frame_ticks, vblank_event);
+    }
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
 void Shutdown() {
+    frame_hash_callback = nullptr;
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
+void SetFrameHashCallback(FrameHashCallback callback) {
+    frame_hash_callback = std::move(callback);
+}
+
 } // namespace GPU
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <type_traits>
 #include "common/assert.h"
 #include "common/bit_field.h"
@@ -68,7 +69,7 @@ struct Regs {
     /**
      * Returns the number of bytes per pixel.
      */
-    static int BytesPerPixel(PixelFormat format) {
+    static constexpr int BytesPerPixel(PixelFormat format) {
         switch (format) {
         case PixelFormat::RGBA8:
             return 4;
@@ -335,4 +336,22 @@ void Init(Memory::MemorySystem& memory);
 /// Shutdown hardware
 void Shutdown();
 
+/// Guest memory a screen displays, from its left framebuffer
+struct DisplayedFramebuffer {
+    PAddr address;
+    u32 size;
+};
+
+/**
+ * Gets the framebuffer displayed on screen 0 (top) or 1 (bottom).
+ * @returns the region, with a size of 0 if it isn't valid physical memory
+ */
+DisplayedFramebuffer GetDisplayedFramebuffer(std::size_t screen);
+
+/// Called every frame with a hash of the guest framebuffers displayed, in deterministic mode
+using FrameHashCallback = std::function<void(u64 hash)>;
+
+/// Sets the callback receiving the frame hashes, until the hardware is shut down
+void SetFrameHashCallback(FrameHashCallback callback);
+
 } // namespace GPU
@@ -5,7 +5,14 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <utility>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -24,56 +31,212 @@ static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
-                            unsigned int height, const CoefficientSet& coefficients) {
+/**
+ * Decodes a line of the source YUV format into one Y, U and V value per pixel, 8 pixels at a time.
+ * The chroma of pixel pairs (and line pairs for 4:2:0) is repeated.
+ */
+template <InputFormat input_format>
+static void DecodeYUVLine(const u8* input_Y, const u8* input_U, const u8* input_V, s16* Y, s16* U,
+                          s16* V, unsigned int width, unsigned int y) {
+    constexpr bool interleaved = input_format == InputFormat::YUYV422_Interleaved;
+    constexpr bool yuv420 = input_format == InputFormat::YUV420_Indiv8 ||
+                            input_format == InputFormat::YUV420_Indiv16;
+    const u8* line_Y = input_Y + y * width * (interleaved ? 2 : 1);
+    const std::size_t chroma_offset = (yuv420 ? y / 2 : y) * width / 2;
+    const u8* line_U = interleaved ? nullptr : input_U + chroma_offset;
+    const u8* line_V = interleaved ? nullptr : input_V + chroma_offset;
+
+#if defined(ARCHITECTURE_x86_64)
+    const __m128i zero = _mm_setzero_si128();
+    for (unsigned int x = 0; x < width; x += 8) {
+        __m128i y_values, u_values, v_values;
+        if constexpr (interleaved) {
+            const __m128i yuyv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line_Y + x * 2));
+            y_values = _mm_and_si128(yuyv, _mm_set1_epi16(0xFF));
+            const __m128i uv = _mm_srli_epi16(yuyv, 8);
+            u_values = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+                                           _MM_SHUFFLE(2, 2, 0, 0));
+            v_values = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+                                           _MM_SHUFFLE(3, 3, 1, 1));
+        } else {
+            u32 u, v;
+            std::memcpy(&u, line_U + x / 2, sizeof(u));
+            std::memcpy(&v, line_V + x / 2, sizeof(v));
+            const __m128i u_pairs = _mm_cvtsi32_si128(u);
+            const __m128i v_pairs = _mm_cvtsi32_si128(v);
+            y_values = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(line_Y + x)), zero);
+            u_values = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u_pairs, u_pairs), zero);
+            v_values = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v_pairs, v_pairs), zero);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Y + x), y_values);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(U + x), u_values);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(V + x), v_values);
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    for (unsigned int x = 0; x < width; x += 8) {
+        uint16x8_t y_values, u_values, v_values;
+        if constexpr (interleaved) {
+            const uint16x8_t yuyv = vreinterpretq_u16_u8(vld1q_u8(line_Y + x * 2));
+            y_values = vandq_u16(yuyv, vdupq_n_u16(0xFF));
+            const uint16x8_t uv = vshrq_n_u16(yuyv, 8);
+            u_values = vtrn1q_u16(uv, uv);
+            v_values = vtrn2q_u16(uv, uv);
+        } else {
+            u32 u, v;
+            std::memcpy(&u, line_U + x / 2, sizeof(u));
+            std::memcpy(&v, line_V + x / 2, sizeof(v));
+            const uint8x8_t u_pairs = vreinterpret_u8_u32(vdup_n_u32(u));
+            const uint8x8_t v_pairs = vreinterpret_u8_u32(vdup_n_u32(v));
+            y_values = vmovl_u8(vld1_u8(line_Y + x));
+            u_values = vmovl_u8(vzip1_u8(u_pairs, u_pairs));
+            v_values = vmovl_u8(vzip1_u8(v_pairs, v_pairs));
+        }
+        vst1q_s16(Y + x, vreinterpretq_s16_u16(y_values));
+        vst1q_s16(U + x, vreinterpretq_s16_u16(u_values));
+        vst1q_s16(V + x, vreinterpretq_s16_u16(v_values));
+    }
+#else
+    for (unsigned int x = 0; x < width; ++x) {
+        if constexpr (interleaved) {
+            Y[x] = line_Y[x * 2];
+            U[x] = line_Y[(x / 2) * 4 + 1];
+            V[x] = line_Y[(x / 2) * 4 + 3];
+        } else {
+            Y[x] = line_Y[x];
+            U[x] = line_U[x / 2];
+            V[x] = line_V[x / 2];
+        }
+    }
+#endif
+}
 
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+/**
+ * Converts a line of YUV values to RGB32, 8 pixels at a time. This conversion process is bit-exact
+ * with hardware, as far as could be tested, and the vectorized versions are bit-exact with the
+ * scalar one: the products and sums fit in 32 bits without saturating, and saturating packs clamp
+ * like std::clamp.
+ */
+static void ConvertYUVLineToRGB(const s16* Y, const s16* U, const s16* V, u32* output,
+                                unsigned int width, const CoefficientSet& c) {
+    constexpr s32 rounding_offset = 0x18;
+#if defined(ARCHITECTURE_x86_64)
+    const __m128i zero = _mm_setzero_si128();
+    // Pairs of coefficients for _mm_madd_epi16, which multiplies and adds neighbouring values
+    const __m128i coef_Y = _mm_setr_epi16(c[0], 0, c[0], 0, c[0], 0, c[0], 0);
+    const __m128i coef_RV = _mm_setr_epi16(c[1], 0, c[1], 0, c[1], 0, c[1], 0);
+    const __m128i coef_GVU = _mm_setr_epi16(c[2], c[3], c[2], c[3], c[2], c[3], c[2], c[3]);
+    const __m128i coef_BU = _mm_setr_epi16(c[4], 0, c[4], 0, c[4], 0, c[4], 0);
+    const __m128i offset_R = _mm_set1_epi32(c[5] + rounding_offset);
+    const __m128i offset_G = _mm_set1_epi32(c[6] + rounding_offset);
+    const __m128i offset_B = _mm_set1_epi32(c[7] + rounding_offset);
+
+    const auto finish = [](__m128i low, __m128i high, __m128i offset) {
+        low = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(low, 3), offset), 5);
+        high = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(high, 3), offset), 5);
+        const __m128i packed = _mm_packs_epi32(low, high);
+        return _mm_packus_epi16(packed, packed);
+    };
+
+    for (unsigned int x = 0; x < width; x += 8) {
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Y + x));
+        const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(U + x));
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(V + x));
+
+        const __m128i cY_low = _mm_madd_epi16(_mm_unpacklo_epi16(y, zero), coef_Y);
+        const __m128i cY_high = _mm_madd_epi16(_mm_unpackhi_epi16(y, zero), coef_Y);
+        const __m128i r_low =
+            _mm_add_epi32(cY_low, _mm_madd_epi16(_mm_unpacklo_epi16(v, zero), coef_RV));
+        const __m128i r_high =
+            _mm_add_epi32(cY_high, _mm_madd_epi16(_mm_unpackhi_epi16(v, zero), coef_RV));
+        const __m128i g_low =
+            _mm_sub_epi32(cY_low, _mm_madd_epi16(_mm_unpacklo_epi16(v, u), coef_GVU));
+        const __m128i g_high =
+            _mm_sub_epi32(cY_high, _mm_madd_epi16(_mm_unpackhi_epi16(v, u), coef_GVU));
+        const __m128i b_low =
+            _mm_add_epi32(cY_low, _mm_madd_epi16(_mm_unpacklo_epi16(u, zero), coef_BU));
+        const __m128i b_high =
+            _mm_add_epi32(cY_high, _mm_madd_epi16(_mm_unpackhi_epi16(u, zero), coef_BU));
+
+        const __m128i r = finish(r_low, r_high, offset_R);
+        const __m128i g = finish(g_low, g_high, offset_G);
+        const __m128i b = finish(b_low, b_high, offset_B);
+
+        // Interleaved into (r << 24) | (g << 16) | (b << 8)
+        const __m128i low_halves = _mm_unpacklo_epi8(zero, b);
+        const __m128i high_halves = _mm_unpacklo_epi8(g, r);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x),
+                         _mm_unpacklo_epi16(low_halves, high_halves));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x + 4),
+                         _mm_unpackhi_epi16(low_halves, high_halves));
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    const int32x4_t offset_R = vdupq_n_s32(c[5] + rounding_offset);
+    const int32x4_t offset_G = vdupq_n_s32(c[6] + rounding_offset);
+    const int32x4_t offset_B = vdupq_n_s32(c[7] + rounding_offset);
+
+    const auto finish = [](int32x4_t low, int32x4_t high, int32x4_t offset) {
+        low = vshrq_n_s32(vaddq_s32(vshrq_n_s32(low, 3), offset), 5);
+        high = vshrq_n_s32(vaddq_s32(vshrq_n_s32(high, 3), offset), 5);
+        return vqmovun_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    };
+
+    for (unsigned int x = 0; x < width; x += 8) {
+        const int16x8_t y = vld1q_s16(Y + x);
+        const int16x8_t u = vld1q_s16(U + x);
+        const int16x8_t v = vld1q_s16(V + x);
+
+        const int32x4_t cY_low = vmull_n_s16(vget_low_s16(y), c[0]);
+        const int32x4_t cY_high = vmull_n_s16(vget_high_s16(y), c[0]);
+        const int32x4_t r_low = vmlal_n_s16(cY_low, vget_low_s16(v), c[1]);
+        const int32x4_t r_high = vmlal_n_s16(cY_high, vget_high_s16(v), c[1]);
+        const int32x4_t g_low =
+            vmlsl_n_s16(vmlsl_n_s16(cY_low, vget_low_s16(v), c[2]), vget_low_s16(u), c[3]);
+        const int32x4_t g_high =
+            vmlsl_n_s16(vmlsl_n_s16(cY_high, vget_high_s16(v), c[2]), vget_high_s16(u), c[3]);
+        const int32x4_t b_low = vmlal_n_s16(cY_low, vget_low_s16(u), c[4]);
+        const int32x4_t b_high = vmlal_n_s16(cY_high, vget_high_s16(u), c[4]);
+
+        // Stored interleaved as the bytes of (r << 24) | (g << 16) | (b << 8)
+        uint8x8x4_t rgb;
+        rgb.val[0] = vdup_n_u8(0);
+        rgb.val[1] = finish(b_low, b_high, offset_B);
+        rgb.val[2] = finish(g_low, g_high, offset_G);
+        rgb.val[3] = finish(r_low, r_high, offset_R);
+        vst4_u8(reinterpret_cast<u8*>(output + x), rgb);
+    }
+#else
+    for (unsigned int x = 0; x < width; ++x) {
+        s32 cY = c[0] * Y[x];
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
-        }
+        s32 r = cY + c[1] * V[x];
+        s32 g = cY - c[2] * V[x] - c[3] * U[x];
+        s32 b = cY + c[4] * U[x];
+
+        r = (r >> 3) + c[5] + rounding_offset;
+        g = (g >> 3) + c[6] + rounding_offset;
+        b = (b >> 3) + c[7] + rounding_offset;
+
+        output[x] = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
+                    ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+                    ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+    }
+#endif
+}
+
+/// Converts a image strip from the source YUV format into a RGB32 strip, stored line by line.
+template <InputFormat input_format>
+static void ConvertYUVToRGB(const u8* input_Y, const u8* input_U, const u8* input_V, u32* output,
+                            unsigned int width, unsigned int height,
+                            const CoefficientSet& coefficients) {
+    std::array<s16, MAX_TILES * 8> Y;
+    std::array<s16, MAX_TILES * 8> U;
+    std::array<s16, MAX_TILES * 8> V;
+    for (unsigned int y = 0; y < height; ++y) {
+        DecodeYUVLine<input_format>(input_Y, input_U, input_V, Y.data(), U.data(), V.data(),
+                                    width, y);
+        ConvertYUVLineToRGB(Y.data(), U.data(), V.data(), output + y * width, width,
+                            coefficients);
     }
 }
 
@@ -87,8 +250,27 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, std::size_t amount_of
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (std::size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if constexpr (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            std::size_t i = 0;
+#if defined(ARCHITECTURE_x86_64)
+            // Keeps the low byte of each 16-bit value, 8 at a time
+            for (; i + 8 <= output_unit; i += 8) {
+                const __m128i values =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * N));
+                const __m128i low_bytes = _mm_and_si128(values, _mm_set1_epi16(0xFF));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i),
+                                 _mm_packus_epi16(low_bytes, low_bytes));
+            }
+#elif defined(ARCHITECTURE_ARM64)
+            for (; i + 8 <= output_unit; i += 8) {
+                vst1_u8(output + i, vld2_u8(input + i * N).val[0]);
+            }
+#endif
+            for (; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -100,38 +282,89 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, std::size_t amount_of
     }
 }
 
+/// Size in bytes of a pixel of each output format
+template <OutputFormat output_format>
+constexpr std::size_t OutputPixelSize() {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    }
+    return 0;
+}
+
+/**
+ * Converts pixels from the intermediate RGB32 format to the output format. The components are
+ * moved with masks and shifts, which are equivalent to the Color::Encode functions and simple
+ * enough for compilers to vectorize.
+ */
+template <OutputFormat output_format>
+static void EncodePixels(const u32* input, u8* output, std::size_t count, u8 alpha) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const u32 color = input[i];
+        switch (output_format) {
+        case OutputFormat::RGBA8: {
+            const u32_le data = color | alpha;
+            std::memcpy(output + i * 4, &data, sizeof(data));
+            break;
+        }
+        case OutputFormat::RGB8:
+            output[i * 3] = static_cast<u8>(color >> 8);
+            output[i * 3 + 1] = static_cast<u8>(color >> 16);
+            output[i * 3 + 2] = static_cast<u8>(color >> 24);
+            break;
+        case OutputFormat::RGB5A1: {
+            const u16_le data = static_cast<u16>(((color >> 16) & 0xF800) |
+                                                 ((color >> 13) & 0x07C0) |
+                                                 ((color >> 10) & 0x003E) | (alpha >> 7));
+            std::memcpy(output + i * 2, &data, sizeof(data));
+            break;
+        }
+        case OutputFormat::RGB565: {
+            const u16_le data = static_cast<u16>(((color >> 16) & 0xF800) |
+                                                 ((color >> 13) & 0x07E0) |
+                                                 ((color >> 11) & 0x001F));
+            std::memcpy(output + i * 2, &data, sizeof(data));
+            break;
+        }
+        }
+    }
+}
+
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
-                     OutputFormat output_format, u8 alpha) {
+template <OutputFormat output_format>
+static void SendData(const u32* input, u8* encode_buffer, ConversionBuffer& buf,
+                     int amount_of_data, u8 alpha) {
+    constexpr std::size_t pixel_size = OutputPixelSize<output_format>();
 
     u8* output = Core::System::GetInstance().Memory().GetPointer(buf.address);
 
+    if (buf.transfer_unit != 0 && buf.transfer_unit % pixel_size == 0 &&
+        (amount_of_data * pixel_size) % buf.transfer_unit == 0) {
+        // Transfers hold whole pixels, so the strip is encoded at once and then copied out
+        EncodePixels<output_format>(input, encode_buffer, amount_of_data, alpha);
+        const u8* encoded = encode_buffer;
+        for (std::size_t left = amount_of_data * pixel_size; left > 0;
+             left -= buf.transfer_unit) {
+            std::memcpy(output, encoded, buf.transfer_unit);
+            encoded += buf.transfer_unit;
+            output += buf.transfer_unit + buf.gap;
+            buf.address += buf.transfer_unit + buf.gap;
+            buf.image_size -= buf.transfer_unit;
+        }
+        return;
+    }
+
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
         while (output < unit_end) {
-            u32 color = *input++;
-            Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            switch (output_format) {
-            case OutputFormat::RGBA8:
-                Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-                break;
-            case OutputFormat::RGB8:
-                Color::EncodeRGB8(col_vec, output);
-                output += 3;
-                break;
-            case OutputFormat::RGB5A1:
-                Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-                break;
-            case OutputFormat::RGB565:
-                Color::EncodeRGB565(col_vec, output);
-                output += 2;
-                break;
-            }
-
+            EncodePixels<output_format>(input++, output, 1, alpha);
+            output += pixel_size;
             amount_of_data -= 1;
         }
 
@@ -167,46 +400,46 @@ static const u8 morton_lut[TILE_SIZE] = {
     // clang-format on
 };
 
-static void RotateTile0(const ImageTile& input, ImageTile& output, int height,
+// The rotations read a tile from the RGB32 strip, where its lines are input_stride pixels apart.
+
+static void RotateTile0(const u32* input, std::size_t input_stride, u32* output, int height,
                         const u8 out_map[64]) {
     for (int i = 0; i < height * 8; ++i) {
-        output[out_map[i]] = input[i];
+        output[out_map[i]] = input[(i / 8) * input_stride + i % 8];
     }
 }
 
-static void RotateTile90(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile90(const u32* input, std::size_t input_stride, u32* output, int height,
                          const u8 out_map[64]) {
     int out_i = 0;
     for (int x = 0; x < 8; ++x) {
         for (int y = height - 1; y >= 0; --y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
+            output[out_map[out_i++]] = input[y * input_stride + x];
         }
     }
 }
 
-static void RotateTile180(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile180(const u32* input, std::size_t input_stride, u32* output, int height,
                           const u8 out_map[64]) {
     int out_i = 0;
     for (int i = height * 8 - 1; i >= 0; --i) {
-        output[out_map[out_i++]] = input[i];
+        output[out_map[out_i++]] = input[(i / 8) * input_stride + i % 8];
     }
 }
 
-static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
+static void RotateTile270(const u32* input, std::size_t input_stride, u32* output, int height,
                           const u8 out_map[64]) {
     int out_i = 0;
     for (int x = 8 - 1; x >= 0; --x) {
         for (int y = 0; y < height; ++y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
+            output[out_map[out_i++]] = input[y * input_stride + x];
         }
     }
 }
 
 static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
     for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            output[y * line_stride + x] = tile[y * 8 + x];
-        }
+        std::memcpy(output + y * line_stride, tile.data() + y * 8, 8 * sizeof(u32));
     }
 }
 
@@ -246,7 +479,10 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  * In this implementation, to avoid the combinatorial explosion of parameter combinations, common
  * intermediate formats are used and where possible tables or parameters are used instead of
  * diverging code paths to keep the amount of branches in check. Some steps are also merged to
- * increase efficiency.
+ * increase efficiency. The input and output formats are template parameters of the decoding and
+ * encoding steps, and decoding and colorspace conversion are vectorized on x86-64 and ARM64, 8
+ * pixels at a time. Unrotated linear output skips the tile stage, and 8x8 tiles are rotated
+ * straight into the output.
  *
  * Output for all valid settings combinations matches hardware, however output in some edge-cases
  * differs:
@@ -269,8 +505,10 @@ void PerformConversion(ConversionConfiguration& cvt) {
 
     // Buffer used as a CDMA source/target.
     std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
+    // Intermediate storage for the decoded strip. Always stored as RGB32, line by line.
+    std::unique_ptr<u32[]> strip(new u32[cvt.input_line_width * 8]);
+    // The strip in the output format, before it is CDMAed out.
+    std::unique_ptr<u8[]> encode_buffer(new u8[cvt.input_line_width * 8 * 4]);
     ImageTile tmp_tile;
 
     // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
@@ -300,82 +538,210 @@ void PerformConversion(ConversionConfiguration& cvt) {
             ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
             ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
             ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
+            ConvertYUVToRGB<InputFormat::YUV422_Indiv8>(input_Y, input_U, input_V, strip.get(),
+                                                        cvt.input_line_width, row_height,
+                                                        cvt.coefficients);
             break;
         case InputFormat::YUV420_Indiv8:
             ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
             ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
             ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
+            ConvertYUVToRGB<InputFormat::YUV420_Indiv8>(input_Y, input_U, input_V, strip.get(),
+                                                        cvt.input_line_width, row_height,
+                                                        cvt.coefficients);
             break;
         case InputFormat::YUV422_Indiv16:
             ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
             ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
             ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
+            ConvertYUVToRGB<InputFormat::YUV422_Indiv16>(input_Y, input_U, input_V, strip.get(),
+                                                         cvt.input_line_width, row_height,
+                                                         cvt.coefficients);
             break;
         case InputFormat::YUV420_Indiv16:
             ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
             ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
             ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
+            ConvertYUVToRGB<InputFormat::YUV420_Indiv16>(input_Y, input_U, input_V, strip.get(),
+                                                         cvt.input_line_width, row_height,
+                                                         cvt.coefficients);
             break;
         case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
             ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
+            ConvertYUVToRGB<InputFormat::YUYV422_Interleaved>(input_Y, nullptr, nullptr,
+                                                              strip.get(), cvt.input_line_width,
+                                                              row_height, cvt.coefficients);
             break;
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (std::size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
+        // Without rotation, linear output is the strip itself
+        const u32* rgb_output = strip.get();
+        if (cvt.rotation != Rotation::None || cvt.block_alignment != BlockAlignment::Linear) {
+            u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
+            rgb_output = output_buffer;
+
+            for (std::size_t i = 0; i < num_tiles; ++i) {
+                int image_strip_width = 0;
+                int output_stride = 0;
+
+                // Tiles in the 8x8 block format are rotated straight into the output
+                u32* tile_output = cvt.block_alignment == BlockAlignment::Block8x8
+                                       ? output_buffer
+                                       : tmp_tile.data();
+                const auto tile_input = [&](std::size_t tile) {
+                    return strip.get() + tile * 8;
+                };
+
+                switch (cvt.rotation) {
+                case Rotation::None:
+                    RotateTile0(tile_input(i), cvt.input_line_width, tile_output, row_height,
+                                tile_remap);
+                    image_strip_width = cvt.input_line_width;
+                    output_stride = 8;
+                    break;
+                case Rotation::Clockwise_90:
+                    RotateTile90(tile_input(i), cvt.input_line_width, tile_output, row_height,
+                                 tile_remap);
+                    image_strip_width = 8;
+                    output_stride = 8 * row_height;
+                    break;
+                case Rotation::Clockwise_180:
+                    // For 180 and 270 degree rotations we also invert the order of tiles in the
+                    // strip, since the rotates are done individually on each tile.
+                    RotateTile180(tile_input(num_tiles - i - 1), cvt.input_line_width,
+                                  tile_output, row_height, tile_remap);
+                    image_strip_width = cvt.input_line_width;
+                    output_stride = 8;
+                    break;
+                case Rotation::Clockwise_270:
+                    RotateTile270(tile_input(num_tiles - i - 1), cvt.input_line_width,
+                                  tile_output, row_height, tile_remap);
+                    image_strip_width = 8;
+                    output_stride = 8 * row_height;
+                    break;
+                }
+
+                switch (cvt.block_alignment) {
+                case BlockAlignment::Linear:
+                    WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+                    output_buffer += output_stride;
+                    break;
+                case BlockAlignment::Block8x8:
+                    output_buffer += TILE_SIZE;
+                    break;
+                }
             }
+        }
 
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+        switch (cvt.output_format) {
+        case OutputFormat::RGBA8:
+            SendData<OutputFormat::RGBA8>(rgb_output, encode_buffer.get(), cvt.dst,
+                                          (int)row_data_size, (u8)cvt.alpha);
+            break;
+        case OutputFormat::RGB8:
+            SendData<OutputFormat::RGB8>(rgb_output, encode_buffer.get(), cvt.dst,
+                                         (int)row_data_size, (u8)cvt.alpha);
+            break;
+        case OutputFormat::RGB5A1:
+            SendData<OutputFormat::RGB5A1>(rgb_output, encode_buffer.get(), cvt.dst,
+                                           (int)row_data_size, (u8)cvt.alpha);
+            break;
+        case OutputFormat::RGB565:
+            SendData<OutputFormat::RGB565>(rgb_output, encode_buffer.get(), cvt.dst,
+                                           (int)row_data_size, (u8)cvt.alpha);
+            break;
         }
+    }
+}
+
+/// Sizes in bytes of the luma (or YUYV) plane and of each chroma plane of a conversion input
+static std::pair<u32, u32> GetInputPlaneSizes(const ConversionConfiguration& cvt) {
+    const bool interleaved = cvt.input_format == InputFormat::YUYV422_Interleaved;
+    const bool yuv420 = cvt.input_format == InputFormat::YUV420_Indiv8 ||
+                        cvt.input_format == InputFormat::YUV420_Indiv16;
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+    // Summed over strips like PerformConversion reads them, the 4:2:0 sizes of odd strips round
+    u32 luma_size = 0;
+    u32 chroma_size = 0;
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
+        const u32 row_data_size = std::min(cvt.input_lines - y, 8u) * cvt.input_line_width;
+        luma_size += interleaved ? row_data_size * 2 : row_data_size;
+        chroma_size += interleaved ? 0 : row_data_size / (yuv420 ? 4 : 2);
     }
+    return {luma_size, chroma_size};
+}
+
+u32 GetInputSize(const ConversionConfiguration& cvt) {
+    const auto [luma_size, chroma_size] = GetInputPlaneSizes(cvt);
+    return luma_size + chroma_size * 2;
+}
+
+void ReceiveInput(ConversionConfiguration& cvt, u8* input) {
+    const bool interleaved = cvt.input_format == InputFormat::YUYV422_Interleaved;
+    const bool yuv420 = cvt.input_format == InputFormat::YUV420_Indiv8 ||
+                        cvt.input_format == InputFormat::YUV420_Indiv16;
+    const bool indiv16 = cvt.input_format == InputFormat::YUV422_Indiv16 ||
+                         cvt.input_format == InputFormat::YUV420_Indiv16;
+
+    const auto [luma_size, chroma_size] = GetInputPlaneSizes(cvt);
+    u8* input_Y = input;
+    u8* input_U = input_Y + luma_size;
+    u8* input_V = input_U + chroma_size;
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
+        const std::size_t row_data_size = std::min(cvt.input_lines - y, 8u) * cvt.input_line_width;
+        if (interleaved) {
+            ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
+            input_Y += row_data_size * 2;
+            continue;
+        }
+
+        const std::size_t row_chroma_size = row_data_size / (yuv420 ? 4 : 2);
+        if (indiv16) {
+            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(input_U, cvt.src_U, row_chroma_size);
+            ReceiveData<2>(input_V, cvt.src_V, row_chroma_size);
+        } else {
+            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(input_U, cvt.src_U, row_chroma_size);
+            ReceiveData<1>(input_V, cvt.src_V, row_chroma_size);
+        }
+        input_Y += row_data_size;
+        input_U += row_chroma_size;
+        input_V += row_chroma_size;
+    }
+}
+
+static u32 GetOutputPixelSize(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return OutputPixelSize<OutputFormat::RGBA8>();
+    case OutputFormat::RGB8:
+        return OutputPixelSize<OutputFormat::RGB8>();
+    case OutputFormat::RGB5A1:
+        return OutputPixelSize<OutputFormat::RGB5A1>();
+    case OutputFormat::RGB565:
+        return OutputPixelSize<OutputFormat::RGB565>();
+    }
+    return 0;
+}
+
+u32 GetOutputSize(const ConversionConfiguration& cvt) {
+    return cvt.input_line_width * cvt.input_lines * GetOutputPixelSize(cvt.output_format);
+}
+
+bool IsOutputContiguous(const ConversionConfiguration& cvt) {
+    // Every strip has to be made of whole transfers for SendData to write it in one piece
+    const u32 strip_size = cvt.input_line_width * 8 * GetOutputPixelSize(cvt.output_format);
+    const u32 last_strip_size = GetOutputSize(cvt) - (cvt.input_lines - 1) / 8 * strip_size;
+    return cvt.dst.gap == 0 && cvt.dst.transfer_unit != 0 &&
+           strip_size % cvt.dst.transfer_unit == 0 && last_strip_size % cvt.dst.transfer_unit == 0;
+}
+
+void SkipOutput(ConversionConfiguration& cvt) {
+    ASSERT(IsOutputContiguous(cvt));
+    const u32 output_size = GetOutputSize(cvt);
+    cvt.dst.address += output_size;
+    cvt.dst.image_size -= output_size;
 }
 } // namespace Y2R
 } // namespace HW
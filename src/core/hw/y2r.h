@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "common/common_types.h"
+
 namespace Service {
 namespace Y2R {
 struct ConversionConfiguration;
@@ -13,5 +15,28 @@ struct ConversionConfiguration;
 namespace HW {
 namespace Y2R {
 void PerformConversion(Service::Y2R::ConversionConfiguration& cvt);
-}
+
+/// Size in bytes of the buffer ReceiveInput needs for the input of a conversion
+u32 GetInputSize(const Service::Y2R::ConversionConfiguration& cvt);
+
+/**
+ * Reads the whole input of a conversion into one buffer, for conversions done elsewhere than in
+ * PerformConversion. The Y, U and V planes are stored one after the other (or the YUYV data
+ * alone), with 16-bit formats narrowed to 8 bits. The source buffers are advanced like
+ * PerformConversion does.
+ */
+void ReceiveInput(Service::Y2R::ConversionConfiguration& cvt, u8* input);
+
+/// Size in bytes of the output of a whole conversion, without the gaps between transfers
+u32 GetOutputSize(const Service::Y2R::ConversionConfiguration& cvt);
+
+/**
+ * Whether the output of a conversion is one contiguous region of GetOutputSize bytes, written as
+ * whole transfers, which is required by SkipOutput.
+ */
+bool IsOutputContiguous(const Service::Y2R::ConversionConfiguration& cvt);
+
+/// Advances the destination buffer past the output of a whole conversion, as if it was written
+void SkipOutput(Service::Y2R::ConversionConfiguration& cvt);
+} // namespace Y2R
 } // namespace HW
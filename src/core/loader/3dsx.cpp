@@ -37,7 +37,6 @@ namespace Loader {
 
 enum THREEDSX_Error { ERROR_NONE = 0, ERROR_READ = 1, ERROR_FILE = 2, ERROR_ALLOC = 3 };
 
-static const u32 RELOCBUFSIZE = 512;
 static const unsigned int NUM_SEGMENTS = 3;
 
 // File header
@@ -91,6 +90,50 @@ static u32 TranslateAddr(u32 addr, const THREEloadinfo* loadinfo, u32* offsets)
     return loadinfo->seg_addrs[2] + addr - offsets[1];
 }
 
+/**
+ * Applies a relocation table to a segment: absolute relocations for table 0, relative ones for
+ * table 1. The table is a template parameter so that patching a word doesn't branch on it.
+ * @return false if a relocation has an unknown sub type
+ */
+template <unsigned int table>
+static bool ApplyRelocations(const std::vector<THREEDSX_Reloc>& relocs, unsigned int segment,
+                             const THREEloadinfo* loadinfo, u32* offsets) {
+    u32* const words = reinterpret_cast<u32*>(loadinfo->seg_ptrs[segment]);
+    const u32 segment_addr = loadinfo->seg_addrs[segment];
+    const std::size_t num_words = loadinfo->seg_sizes[segment] / 4;
+
+    std::size_t index = 0;
+    for (const THREEDSX_Reloc& reloc : relocs) {
+        if (index >= num_words)
+            break;
+        index += reloc.skip;
+        const std::size_t end = std::min<std::size_t>(index + reloc.patch, num_words);
+        for (; index < end; ++index) {
+            const u32 orig_data = words[index];
+            const u32 sub_type = orig_data >> (32 - 4);
+            const u32 addr = TranslateAddr(orig_data & ~0xF0000000, loadinfo, offsets);
+            if constexpr (table == 0) {
+                if (sub_type != 0)
+                    return false;
+                words[index] = addr;
+            } else {
+                const u32 data = addr - (segment_addr + static_cast<u32>(index * 4));
+                switch (sub_type) {
+                case 0: // 32-bit signed offset
+                    words[index] = data;
+                    break;
+                case 1: // 31-bit signed offset
+                    words[index] = data & ~(1U << 31);
+                    break;
+                default:
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
 using Kernel::CodeSet;
 using Kernel::SharedPtr;
 
@@ -146,7 +189,8 @@ static THREEDSX_Error Load3DSXFile(FileUtil::IOFile& file, u32 base_addr,
     // BSS clear
     memset((char*)loadinfo.seg_ptrs[2] + hdr.data_seg_size - hdr.bss_size, 0, hdr.bss_size);
 
-    // Relocate the segments
+    // Relocate the segments, each relocation table is read whole
+    std::vector<THREEDSX_Reloc> reloc_table;
     for (unsigned int current_segment = 0; current_segment < NUM_SEGMENTS; ++current_segment) {
         for (unsigned current_segment_reloc_table = 0; current_segment_reloc_table < n_reloc_tables;
              current_segment_reloc_table++) {
@@ -156,63 +200,18 @@ static THREEDSX_Error Load3DSXFile(FileUtil::IOFile& file, u32 base_addr,
                 file.Seek(n_relocs * sizeof(THREEDSX_Reloc), SEEK_CUR);
                 continue;
             }
-            THREEDSX_Reloc reloc_table[RELOCBUFSIZE];
-
-            u32* pos = (u32*)loadinfo.seg_ptrs[current_segment];
-            const u32* end_pos = pos + (loadinfo.seg_sizes[current_segment] / 4);
-
-            while (n_relocs) {
-                u32 remaining = std::min(RELOCBUFSIZE, n_relocs);
-                n_relocs -= remaining;
-
-                if (file.ReadBytes(reloc_table, remaining * sizeof(THREEDSX_Reloc)) !=
-                    remaining * sizeof(THREEDSX_Reloc))
-                    return ERROR_READ;
-
-                for (unsigned current_inprogress = 0;
-                     current_inprogress < remaining && pos < end_pos; current_inprogress++) {
-                    const auto& table = reloc_table[current_inprogress];
-                    LOG_TRACE(Loader, "(t={},skip={},patch={})", current_segment_reloc_table,
-                              static_cast<u32>(table.skip), static_cast<u32>(table.patch));
-                    pos += table.skip;
-                    s32 num_patches = table.patch;
-                    while (0 < num_patches && pos < end_pos) {
-                        u32 in_addr = base_addr + static_cast<u32>(reinterpret_cast<u8*>(pos) -
-                                                                   program_image.data());
-                        u32 orig_data = *pos;
-                        u32 sub_type = orig_data >> (32 - 4);
-                        u32 addr = TranslateAddr(orig_data & ~0xF0000000, &loadinfo, offsets);
-                        LOG_TRACE(Loader, "Patching {:08X} <-- rel({:08X},{}) ({:08X})", in_addr,
-                                  addr, current_segment_reloc_table, *pos);
-                        switch (current_segment_reloc_table) {
-                        case 0: {
-                            if (sub_type != 0)
-                                return ERROR_READ;
-                            *pos = addr;
-                            break;
-                        }
-                        case 1: {
-                            u32 data = addr - in_addr;
-                            switch (sub_type) {
-                            case 0: // 32-bit signed offset
-                                *pos = data;
-                                break;
-                            case 1: // 31-bit signed offset
-                                *pos = data & ~(1U << 31);
-                                break;
-                            default:
-                                return ERROR_READ;
-                            }
-                            break;
-                        }
-                        default:
-                            break; // this should never happen
-                        }
-                        pos++;
-                        num_patches--;
-                    }
-                }
-            }
+
+            reloc_table.resize(n_relocs);
+            const std::size_t table_size = n_relocs * sizeof(THREEDSX_Reloc);
+            if (file.ReadBytes(reloc_table.data(), table_size) != table_size)
+                return ERROR_READ;
+
+            const bool applied =
+                current_segment_reloc_table == 0
+                    ? ApplyRelocations<0>(reloc_table, current_segment, &loadinfo, offsets)
+                    : ApplyRelocations<1>(reloc_table, current_segment, &loadinfo, offsets);
+            if (!applied)
+                return ERROR_READ;
         }
     }
 
@@ -306,7 +305,7 @@ ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileSys::RomFSReader>
         LOG_DEBUG(Loader, "RomFS size:             {:#010X}", romfs_size);
 
         // We reopen the file, to allow its position to be independent from file's
-        FileUtil::IOFile romfs_file_inner(filepath, "rb");
+        FileSys::ROMFile romfs_file_inner(filepath);
         if (!romfs_file_inner.IsOpen())
             return ResultStatus::Error;
 
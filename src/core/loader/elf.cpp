@@ -5,6 +5,7 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -190,7 +191,13 @@ private:
     u32 entryPoint;
 
 public:
-    explicit ElfReader(void* ptr);
+    /**
+     * @param ptr the beginning of the file, which must at least hold the file header and the
+     * program headers
+     * @param size the number of bytes at ptr, the section accessors are only usable if the section
+     * headers are among them
+     */
+    ElfReader(void* ptr, std::size_t size);
 
     u32 Read32(int off) const {
         return base32[off >> 2];
@@ -209,7 +216,8 @@ public:
     u32 GetFlags() const {
         return (u32)(header->e_flags);
     }
-    SharedPtr<CodeSet> LoadInto(u32 vaddr);
+    /// Reads the loadable segments from the file straight into the image of a new CodeSet
+    SharedPtr<CodeSet> LoadInto(u32 vaddr, FileUtil::IOFile& file);
 
     int GetNumSegments() const {
         return (int)(header->e_phnum);
@@ -222,7 +230,7 @@ public:
     }
     const char* GetSectionName(int section) const;
     const u8* GetSectionDataPtr(int section) const {
-        if (section < 0 || section >= header->e_shnum)
+        if (sections == nullptr || section < 0 || section >= header->e_shnum)
             return nullptr;
         if (sections[section].sh_type != SHT_NOBITS)
             return GetPtr(sections[section].sh_offset);
@@ -232,9 +240,6 @@ public:
     bool IsCodeSection(int section) const {
         return sections[section].sh_type == SHT_PROGBITS;
     }
-    const u8* GetSegmentPtr(int segment) {
-        return GetPtr(segments[segment].p_offset);
-    }
     u32 GetSectionAddr(SectionID section) const {
         return sectionAddrs[section];
     }
@@ -248,19 +253,21 @@ public:
     }
 };
 
-ElfReader::ElfReader(void* ptr) {
+ElfReader::ElfReader(void* ptr, std::size_t size) {
     base = (char*)ptr;
     base32 = (u32*)ptr;
     header = (Elf32_Ehdr*)ptr;
 
     segments = (Elf32_Phdr*)(base + header->e_phoff);
-    sections = (Elf32_Shdr*)(base + header->e_shoff);
+    const bool has_sections =
+        header->e_shoff + u64{header->e_shnum} * sizeof(Elf32_Shdr) <= size;
+    sections = has_sections ? (Elf32_Shdr*)(base + header->e_shoff) : nullptr;
 
     entryPoint = header->e_entry;
 }
 
 const char* ElfReader::GetSectionName(int section) const {
-    if (sections[section].sh_type == SHT_NULL)
+    if (sections == nullptr || sections[section].sh_type == SHT_NULL)
         return nullptr;
 
     int name_offset = sections[section].sh_name;
@@ -272,7 +279,7 @@ const char* ElfReader::GetSectionName(int section) const {
     return nullptr;
 }
 
-SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
+SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr, FileUtil::IOFile& file) {
     LOG_DEBUG(Loader, "String section: {}", header->e_shstrndx);
 
     // Should we relocate?
@@ -333,11 +340,20 @@ SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
             u32 segment_addr = base_addr + p->p_vaddr;
             u32 aligned_size = (p->p_memsz + 0xFFF) & ~0xFFF;
 
+            if (p->p_filesz > p->p_memsz) {
+                LOG_ERROR(Loader, "ELF segment id {} is larger in the file than in memory", i);
+                return nullptr;
+            }
+
             codeset_segment->offset = current_image_position;
             codeset_segment->addr = segment_addr;
             codeset_segment->size = aligned_size;
 
-            memcpy(&program_image[current_image_position], GetSegmentPtr(i), p->p_filesz);
+            if (file.ReadAt(&program_image[current_image_position], p->p_filesz, p->p_offset) !=
+                p->p_filesz) {
+                LOG_ERROR(Loader, "Could not read ELF segment id {}", i);
+                return nullptr;
+            }
             current_image_position += aligned_size;
         }
     }
@@ -384,16 +400,21 @@ ResultStatus AppLoader_ELF::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     if (!file.IsOpen())
         return ResultStatus::Error;
 
-    // Reset read pointer in case this file has been read before.
-    file.Seek(0, SEEK_SET);
+    // Only the headers are read here, the segments are read into the process image by LoadInto.
+    // Homebrew ELFs often carry large debug sections that loading never needs.
+    Elf32_Ehdr header;
+    if (file.ReadAt(&header, sizeof(header), 0) != sizeof(header))
+        return ResultStatus::Error;
 
-    std::size_t size = file.GetSize();
-    std::unique_ptr<u8[]> buffer(new u8[size]);
-    if (file.ReadBytes(&buffer[0], size) != size)
+    std::vector<u8> headers(header.e_phoff + u64{header.e_phnum} * sizeof(Elf32_Phdr));
+    if (headers.size() < sizeof(header) ||
+        file.ReadAt(headers.data(), headers.size(), 0) != headers.size())
         return ResultStatus::Error;
 
-    ElfReader elf_reader(&buffer[0]);
-    SharedPtr<CodeSet> codeset = elf_reader.LoadInto(Memory::PROCESS_IMAGE_VADDR);
+    ElfReader elf_reader(headers.data(), headers.size());
+    SharedPtr<CodeSet> codeset = elf_reader.LoadInto(Memory::PROCESS_IMAGE_VADDR, file);
+    if (!codeset)
+        return ResultStatus::Error;
     codeset->name = filename;
 
     process = Core::System::GetInstance().Kernel().CreateProcess(std::move(codeset));
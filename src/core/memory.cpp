@@ -4,10 +4,15 @@
 
 #include <array>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
 #include "audio_core/dsp_interface.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
+#include "common/memory_util.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -15,6 +20,8 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -54,13 +61,94 @@ private:
     std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
 };
 
+/**
+ * CPU writes to rasterizer cached memory that the rasterizer hasn't invalidated yet, with a bit
+ * per byte for each written page. Writes come from the emulation thread while the rasterizer may
+ * consume them from the GPU thread.
+ */
+class RasterizerWriteTracker {
+public:
+    void Mark(PAddr start, u32 size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (PAddr addr = start; addr != start + size; ++addr) {
+            const u32 offset = addr & PAGE_MASK;
+            pages[addr >> PAGE_BITS][offset / 64] |= u64{1} << (offset % 64);
+        }
+    }
+
+    void Consume(const std::function<void(PAddr, u32)>& callback) {
+        std::map<u32, Page> written;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written.swap(pages);
+        }
+
+        // Merge the written bytes into ranges, which may span consecutive pages
+        PAddr range_start = 0;
+        u32 range_size = 0;
+        for (const auto& [page_index, page] : written) {
+            for (u32 word = 0; word < page.size(); ++word) {
+                if (page[word] == 0) {
+                    continue;
+                }
+                for (u32 bit = 0; bit < 64; ++bit) {
+                    if ((page[word] & (u64{1} << bit)) == 0) {
+                        continue;
+                    }
+                    const PAddr addr = (page_index << PAGE_BITS) + word * 64 + bit;
+                    if (range_size != 0 && addr == range_start + range_size) {
+                        ++range_size;
+                        continue;
+                    }
+                    if (range_size != 0) {
+                        callback(range_start, range_size);
+                    }
+                    range_start = addr;
+                    range_size = 1;
+                }
+            }
+        }
+        if (range_size != 0) {
+            callback(range_start, range_size);
+        }
+    }
+
+private:
+    using Page = std::array<u64, PAGE_SIZE / 64>;
+
+    std::mutex mutex;
+    std::map<u32, Page> pages;
+};
+
+static RasterizerWriteTracker rasterizer_write_tracker;
+
+/// Physical address of a virtual address in one of the regions the rasterizer caches
+static std::optional<PAddr> RasterizerVirtualToPhysical(VAddr addr) {
+    if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
+        return VRAM_PADDR + (addr - VRAM_VADDR);
+    }
+    if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
+        return FCRAM_PADDR + (addr - LINEAR_HEAP_VADDR);
+    }
+    if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
+        return FCRAM_PADDR + (addr - NEW_LINEAR_HEAP_VADDR);
+    }
+    return {};
+}
+
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // Allocated from the OS rather than zeroed up front, so that each page is backed on the NUMA
+    // node of the thread touching it first, which for most of them is the emulation thread
+    Common::MemoryPages fcram =
+        Common::AllocateMemoryPages(Memory::FCRAM_N3DS_SIZE, Settings::values.use_large_pages);
+    Common::MemoryPages vram =
+        Common::AllocateMemoryPages(Memory::VRAM_SIZE, Settings::values.use_large_pages);
+    Common::MemoryPages n3ds_extra_ram = Common::AllocateMemoryPages(
+        Memory::N3DS_EXTRA_RAM_SIZE, Settings::values.use_large_pages);
+    Common::ScopedMemoryUsage guest_memory_usage{
+        Common::MemoryCategory::GuestMemory,
+        Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE + Memory::N3DS_EXTRA_RAM_SIZE};
 
     PageTable* current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
@@ -226,7 +314,11 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        // Invalidated by the rasterizer before it next uses its cache, instead of synchronizing
+        // with it on every write
+        if (const auto paddr = RasterizerVirtualToPhysical(vaddr)) {
+            rasterizer_write_tracker.Mark(*paddr, sizeof(T));
+        }
         std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
         break;
     }
@@ -278,6 +370,62 @@ u8* MemorySystem::GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* MemorySystem::GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr,
+                                       const std::size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    const u64 end = static_cast<u64>(vaddr) + size;
+    if (end > (static_cast<u64>(PAGE_TABLE_NUM_ENTRIES) << PAGE_BITS)) {
+        return nullptr;
+    }
+
+    const auto& page_table = process.vm_manager.page_table;
+    const std::size_t first_page = vaddr >> PAGE_BITS;
+    const std::size_t last_page = static_cast<std::size_t>((end - 1) >> PAGE_BITS);
+
+    u8* const base = page_table.pointers[first_page];
+    for (std::size_t page = first_page; page <= last_page; ++page) {
+        // Cached and MMIO pages need the slow path, and neighbouring virtual pages don't have
+        // to be backed by neighbouring host memory
+        if (page_table.attributes[page] != PageType::Memory ||
+            page_table.pointers[page] != base + ((page - first_page) << PAGE_BITS)) {
+            return nullptr;
+        }
+    }
+
+    return base + (vaddr & PAGE_MASK);
+}
+
+u8* MemorySystem::GetFlushedContiguousPointer(const Kernel::Process& process, const VAddr vaddr,
+                                              const std::size_t size) {
+    if (u8* pointer = GetContiguousPointer(process, vaddr, size)) {
+        return pointer;
+    }
+
+    // The linear heap and VRAM are each contiguous on the host, whatever their pages are marked as
+    const u64 end = static_cast<u64>(vaddr) + size;
+    const auto InRegion = [vaddr, end](VAddr region_start, VAddr region_end) {
+        return vaddr >= region_start && end <= region_end;
+    };
+    if (size == 0 || !(InRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END) ||
+                       InRegion(NEW_LINEAR_HEAP_VADDR, NEW_LINEAR_HEAP_VADDR_END) ||
+                       InRegion(VRAM_VADDR, VRAM_VADDR_END))) {
+        return nullptr;
+    }
+
+    const auto& page_table = process.vm_manager.page_table;
+    for (std::size_t page = vaddr >> PAGE_BITS; page <= ((end - 1) >> PAGE_BITS); ++page) {
+        const PageType type = page_table.attributes[page];
+        if (type != PageType::Memory && type != PageType::RasterizerCachedMemory) {
+            return nullptr;
+        }
+    }
+
+    return GetPointerForRasterizerCache(vaddr);
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -414,7 +562,8 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    VideoCore::RunOnGPUThreadSync(
+        [start, size] { VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size); });
 }
 
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
@@ -422,7 +571,8 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    VideoCore::RunOnGPUThreadSync(
+        [start, size] { VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size); });
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
@@ -432,7 +582,9 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    VideoCore::RunOnGPUThreadSync([start, size] {
+        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
@@ -469,9 +621,15 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         }
     };
 
-    CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
-    CheckRegion(NEW_LINEAR_HEAP_VADDR, NEW_LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
-    CheckRegion(VRAM_VADDR, VRAM_VADDR_END, VRAM_PADDR);
+    VideoCore::RunOnGPUThreadSync([&CheckRegion] {
+        CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
+        CheckRegion(NEW_LINEAR_HEAP_VADDR, NEW_LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
+        CheckRegion(VRAM_VADDR, VRAM_VADDR_END, VRAM_PADDR);
+    });
+}
+
+void RasterizerConsumeCPUWrites(const std::function<void(PAddr start, u32 size)>& callback) {
+    rasterizer_write_tracker.Consume(callback);
 }
 
 u8 MemorySystem::Read8(const VAddr addr) {
@@ -492,6 +650,11 @@ u64 MemorySystem::Read64(const VAddr addr) {
 
 void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_addr,
                              void* dest_buffer, const std::size_t size) {
+    if (const u8* src_ptr = GetContiguousPointer(process, src_addr, size)) {
+        std::memcpy(dest_buffer, src_ptr, size);
+        return;
+    }
+
     auto& page_table = process.vm_manager.page_table;
 
     std::size_t remaining_size = size;
@@ -558,6 +721,11 @@ void MemorySystem::Write64(const VAddr addr, const u64 data) {
 
 void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_addr,
                               const void* src_buffer, const std::size_t size) {
+    if (u8* dest_ptr = GetContiguousPointer(process, dest_addr, size)) {
+        std::memcpy(dest_ptr, src_buffer, size);
+        return;
+    }
+
     auto& page_table = process.vm_manager.page_table;
     std::size_t remaining_size = size;
     std::size_t page_index = dest_addr >> PAGE_BITS;
@@ -606,6 +774,11 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
 
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
+    if (u8* dest_ptr = GetContiguousPointer(process, dest_addr, size)) {
+        std::memset(dest_ptr, 0, size);
+        return;
+    }
+
     auto& page_table = process.vm_manager.page_table;
     std::size_t remaining_size = size;
     std::size_t page_index = dest_addr >> PAGE_BITS;
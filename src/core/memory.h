@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -209,6 +210,13 @@ enum class FlushMode {
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
+/**
+ * Passes the physical ranges of rasterizer cached memory that the CPU wrote since the last call to
+ * the callback, which must invalidate them. CPU writes to cached pages are only recorded, so the
+ * rasterizer has to call this before each use of its cache.
+ */
+void RasterizerConsumeCPUWrites(const std::function<void(PAddr start, u32 size)>& callback);
+
 class MemorySystem {
 public:
     MemorySystem();
@@ -268,6 +276,22 @@ public:
 
     u8* GetPointer(VAddr vaddr);
 
+    /**
+     * Gets a host pointer to a whole range of a process' memory, so that HLE code can access it
+     * with a single memcpy or in place instead of walking it page by page.
+     * @returns nullptr if the range is not entirely plain memory that is contiguous on the host,
+     * in which case ReadBlock/WriteBlock must be used.
+     */
+    u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, std::size_t size);
+
+    /**
+     * Like GetContiguousPointer, but also accepts rasterizer cached pages of the linear heap or
+     * VRAM. The range has to be flushed from the rasterizer cache before reading through the
+     * pointer, and invalidated before writing through it.
+     * @returns nullptr if the range has to be accessed page by page
+     */
+    u8* GetFlushedContiguousPointer(const Kernel::Process& process, VAddr vaddr, std::size_t size);
+
     bool IsValidPhysicalAddress(PAddr paddr);
 
     /// Gets offset in FCRAM from a pointer inside FCRAM range
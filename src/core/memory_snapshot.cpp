@@ -0,0 +1,202 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/assert.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/memory_snapshot.h"
+
+namespace Memory {
+
+namespace {
+
+struct SnapshotRegion {
+    PAddr paddr_base;
+    u32 size;
+};
+
+/// The regions captured by a snapshot, in the order their pages are stored
+constexpr SnapshotRegion snapshot_regions[] = {
+    {FCRAM_PADDR, FCRAM_N3DS_SIZE},
+    {VRAM_PADDR, VRAM_SIZE},
+    {N3DS_EXTRA_RAM_PADDR, N3DS_EXTRA_RAM_SIZE},
+};
+
+constexpr std::size_t GetSnapshotPageCount() {
+    std::size_t count = 0;
+    for (const auto& region : snapshot_regions) {
+        count += region.size / PAGE_SIZE;
+    }
+    return count;
+}
+
+/// Calls func(page_index, host_pointer) for each page captured by a snapshot
+template <typename Func>
+void ForEachSnapshotPage(MemorySystem& memory, Func&& func) {
+    std::size_t page_index = 0;
+    for (const auto& region : snapshot_regions) {
+        u8* const base = memory.GetPhysicalPointer(region.paddr_base);
+        for (u32 offset = 0; offset < region.size; offset += PAGE_SIZE) {
+            func(page_index++, base + offset);
+        }
+    }
+}
+
+// "CMSS" - Citra Memory SnapShot
+constexpr u32 SNAPSHOT_MAGIC = 0x53534D43;
+constexpr u32 SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    u32 magic;
+    u32 version;
+    u32 page_count;
+    u32 has_base;
+};
+static_assert(sizeof(SnapshotHeader) == 16, "SnapshotHeader has incorrect size");
+
+/// How a page is stored in a snapshot file
+enum class PageEncoding : u8 {
+    Zero = 0,
+    Data = 1,
+    /// Same as the page of the base snapshot
+    Base = 2,
+};
+
+bool IsZeroPage(const u8* page) {
+    static const std::array<u8, PAGE_SIZE> zero_page{};
+    return std::memcmp(page, zero_page.data(), PAGE_SIZE) == 0;
+}
+
+} // Anonymous namespace
+
+MemorySnapshot MemorySnapshot::Capture(MemorySystem& memory, const MemorySnapshot* previous) {
+    MemorySnapshot snapshot;
+    snapshot.pages.resize(GetSnapshotPageCount());
+    if (previous != nullptr) {
+        ASSERT(previous->pages.size() == snapshot.pages.size());
+    }
+
+    ForEachSnapshotPage(memory, [&](std::size_t index, const u8* data) {
+        if (previous != nullptr) {
+            const auto& previous_page = previous->pages[index];
+            const bool unchanged = previous_page == nullptr
+                                       ? IsZeroPage(data)
+                                       : std::memcmp(previous_page->data(), data, PAGE_SIZE) == 0;
+            if (unchanged) {
+                snapshot.pages[index] = previous_page;
+                snapshot.stored_pages += previous_page != nullptr ? 1 : 0;
+                return;
+            }
+        }
+        if (IsZeroPage(data)) {
+            return;
+        }
+
+        auto page = std::make_shared<Page>();
+        std::memcpy(page->data(), data, PAGE_SIZE);
+        snapshot.pages[index] = std::move(page);
+        ++snapshot.new_pages;
+        ++snapshot.stored_pages;
+    });
+
+    return snapshot;
+}
+
+void MemorySnapshot::Restore(MemorySystem& memory) const {
+    ASSERT(pages.size() == GetSnapshotPageCount());
+    ForEachSnapshotPage(memory, [&](std::size_t index, u8* data) {
+        if (pages[index] == nullptr) {
+            std::memset(data, 0, PAGE_SIZE);
+        } else {
+            std::memcpy(data, pages[index]->data(), PAGE_SIZE);
+        }
+    });
+}
+
+bool MemorySnapshot::Save(FileUtil::IOFile& file, const MemorySnapshot* base) const {
+    SnapshotHeader header{};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.page_count = static_cast<u32>(pages.size());
+    header.has_base = base != nullptr ? 1 : 0;
+    if (file.WriteObject(header) != 1) {
+        return false;
+    }
+
+    // The encoding of all the pages comes first, followed by the data of the Data pages
+    std::vector<PageEncoding> encodings(pages.size());
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+        if (base != nullptr && base->pages[i] == pages[i]) {
+            encodings[i] = PageEncoding::Base;
+        } else {
+            encodings[i] = pages[i] == nullptr ? PageEncoding::Zero : PageEncoding::Data;
+        }
+    }
+    if (file.WriteArray(encodings.data(), encodings.size()) != encodings.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+        if (encodings[i] == PageEncoding::Data &&
+            file.WriteBytes(pages[i]->data(), PAGE_SIZE) != PAGE_SIZE) {
+            return false;
+        }
+    }
+    return file.IsGood();
+}
+
+std::optional<MemorySnapshot> MemorySnapshot::Load(FileUtil::IOFile& file,
+                                                   const MemorySnapshot* base) {
+    SnapshotHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.page_count != GetSnapshotPageCount()) {
+        LOG_ERROR(Core, "Invalid memory snapshot");
+        return std::nullopt;
+    }
+    if (header.has_base != 0 && base == nullptr) {
+        LOG_ERROR(Core, "Memory snapshot is a delta but no base snapshot was given");
+        return std::nullopt;
+    }
+
+    std::vector<PageEncoding> encodings(header.page_count);
+    if (file.ReadArray(encodings.data(), encodings.size()) != encodings.size()) {
+        return std::nullopt;
+    }
+
+    MemorySnapshot snapshot;
+    snapshot.pages.resize(header.page_count);
+    for (std::size_t i = 0; i < encodings.size(); ++i) {
+        switch (encodings[i]) {
+        case PageEncoding::Zero:
+            break;
+        case PageEncoding::Base:
+            if (header.has_base == 0) {
+                return std::nullopt;
+            }
+            snapshot.pages[i] = base->pages[i];
+            snapshot.stored_pages += snapshot.pages[i] != nullptr ? 1 : 0;
+            break;
+        case PageEncoding::Data: {
+            auto page = std::make_shared<Page>();
+            if (file.ReadBytes(page->data(), PAGE_SIZE) != PAGE_SIZE) {
+                return std::nullopt;
+            }
+            snapshot.pages[i] = std::move(page);
+            ++snapshot.new_pages;
+            ++snapshot.stored_pages;
+            break;
+        }
+        default:
+            LOG_ERROR(Core, "Invalid page encoding {} in memory snapshot",
+                      static_cast<u32>(encodings[i]));
+            return std::nullopt;
+        }
+    }
+
+    return snapshot;
+}
+
+} // namespace Memory
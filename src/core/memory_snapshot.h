@@ -0,0 +1,75 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+
+namespace FileUtil {
+class IOFile;
+}
+
+namespace Memory {
+
+/**
+ * A copy of the physical memory owned by MemorySystem (FCRAM, VRAM and the New 3DS extra RAM),
+ * stored page by page. Each page is immutable once captured, so pages that did not change since
+ * the snapshot a capture was taken against are shared with it instead of being copied. Pages that
+ * only contain zeroes take no space at all.
+ */
+class MemorySnapshot {
+public:
+    /**
+     * Captures the current contents of memory.
+     * @param memory the memory to capture
+     * @param previous an earlier snapshot of the same memory, to share the unchanged pages with
+     */
+    static MemorySnapshot Capture(MemorySystem& memory, const MemorySnapshot* previous = nullptr);
+
+    /// Writes the captured contents back into memory
+    void Restore(MemorySystem& memory) const;
+
+    /// Number of bytes of page data that were copied when this snapshot was captured or loaded
+    std::size_t GetNewDataSize() const {
+        return new_pages * PAGE_SIZE;
+    }
+
+    /// Number of bytes of page data referenced by this snapshot, including the shared pages
+    std::size_t GetDataSize() const {
+        return stored_pages * PAGE_SIZE;
+    }
+
+    /**
+     * Writes the snapshot to a file.
+     * @param base if given, pages shared with this snapshot are stored as references to it, and
+     * the same snapshot must be passed to Load to read the file back
+     * @returns false if writing failed
+     */
+    bool Save(FileUtil::IOFile& file, const MemorySnapshot* base = nullptr) const;
+
+    /**
+     * Reads a snapshot written by Save.
+     * @param base the snapshot passed to Save, if any
+     * @returns the snapshot, or std::nullopt if the file is invalid or needs a base that was not
+     * given
+     */
+    static std::optional<MemorySnapshot> Load(FileUtil::IOFile& file,
+                                              const MemorySnapshot* base = nullptr);
+
+private:
+    using Page = std::array<u8, PAGE_SIZE>;
+
+    /// One entry per page of all regions, null for pages that only contain zeroes
+    std::vector<std::shared_ptr<const Page>> pages;
+    std::size_t new_pages = 0;
+    std::size_t stored_pages = 0;
+};
+
+} // namespace Memory
@@ -2,7 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <optional>
 #include <string>
 #include <vector>
 #include <boost/optional.hpp>
@@ -33,7 +36,9 @@ enum class ControllerStateType : u8 {
     Accelerometer,
     Gyroscope,
     IrRst,
-    ExtraHidResponse
+    ExtraHidResponse,
+
+    Count,
 };
 
 #pragma pack(push, 1)
@@ -123,6 +128,68 @@ struct CTMHeader {
 static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
 #pragma pack(pop)
 
+/*
+ * The input states follow the header. A byte below repeat_flag is the type of a whole
+ * ControllerState, whose remaining bytes follow. A byte repeat_flag | N stands for the N next
+ * states, each being the same as the previous state of the type that is handled, which is what
+ * most polls give while the inputs are left alone. Movies recorded before repeats were added only
+ * have whole states, and play the same.
+ */
+constexpr u8 repeat_flag = 0x80;
+constexpr u32 max_repeat_count = 0x7F;
+/// Movies are read in chunks of this size, so that playback memory doesn't grow with their length
+constexpr std::size_t read_chunk_size = 64 * 1024;
+
+struct Movie::InputStream {
+    FileUtil::IOFile file;
+    /// Previous state of each type, which repeats refer to
+    std::array<std::optional<ControllerState>, static_cast<std::size_t>(ControllerStateType::Count)>
+        last_states;
+    /// Repeats still to play, or recorded and not written yet
+    u32 repeat_count = 0;
+
+    std::vector<u8> read_buffer;
+    std::size_t read_offset = 0;
+
+    /// Reads bytes of the movie, refilling the buffer in chunks
+    bool Read(void* data, std::size_t size) {
+        u8* out = static_cast<u8*>(data);
+        while (size > 0) {
+            if (read_offset == read_buffer.size() && !Refill())
+                return false;
+            const std::size_t count = std::min(size, read_buffer.size() - read_offset);
+            std::memcpy(out, read_buffer.data() + read_offset, count);
+            read_offset += count;
+            out += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    /// Whether there are states left to play
+    bool HasInput() {
+        return repeat_count > 0 || read_offset < read_buffer.size() || Refill();
+    }
+
+    bool Refill() {
+        read_buffer.resize(read_chunk_size);
+        read_buffer.resize(file.ReadBytes(read_buffer.data(), read_buffer.size()));
+        read_offset = 0;
+        return !read_buffer.empty();
+    }
+
+    void FlushRepeats() {
+        if (repeat_count == 0)
+            return;
+        const u8 tag = static_cast<u8>(repeat_flag | repeat_count);
+        file.WriteBytes(&tag, 1);
+        repeat_count = 0;
+    }
+};
+
+Movie::Movie() = default;
+Movie::~Movie() = default;
+
 bool Movie::IsPlayingInput() const {
     return play_mode == PlayMode::Playing;
 }
@@ -130,26 +197,77 @@ bool Movie::IsRecordingInput() const {
     return play_mode == PlayMode::Recording;
 }
 
+std::size_t Movie::GetInputPosition() const {
+    return input_position;
+}
+
 void Movie::CheckInputEnd() {
-    if (current_byte + sizeof(ControllerState) > recorded_input.size()) {
+    if (!input->HasInput()) {
         LOG_INFO(Movie, "Playback finished");
         play_mode = PlayMode::None;
+        input.reset();
         init_time = 0;
         playback_completion_callback();
     }
 }
 
-void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y) {
-    ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+bool Movie::ReadState(ControllerStateType type, ControllerState& state) {
+    ++input_position;
+    auto& last_state = input->last_states[static_cast<std::size_t>(type)];
+
+    bool repeat = input->repeat_count > 0;
+    if (repeat) {
+        --input->repeat_count;
+    } else {
+        u8 tag = 0;
+        if (!input->Read(&tag, 1))
+            return false;
+        const u32 count = tag & ~repeat_flag;
+        repeat = (tag & repeat_flag) != 0;
+        bool valid;
+        if (repeat) {
+            valid = count != 0;
+        } else {
+            state.type = static_cast<ControllerStateType>(tag);
+            valid = tag < static_cast<u8>(ControllerStateType::Count) &&
+                    input->Read(reinterpret_cast<u8*>(&state) + 1, sizeof(ControllerState) - 1);
+        }
+        if (!valid) {
+            LOG_ERROR(Movie, "Movie is corrupted, ending playback");
+            input->read_buffer.clear();
+            input->read_offset = 0;
+            input->file.Close();
+            return false;
+        }
+        if (repeat) {
+            input->repeat_count = count - 1;
+        } else {
+            input->last_states[tag] = state;
+        }
+    }
 
-    if (s.type != ControllerStateType::PadAndCircle) {
+    if (repeat) {
+        if (!last_state) {
+            LOG_ERROR(Movie, "Repeated type {} has no previous state, playback will be out of sync",
+                      static_cast<int>(type));
+            return false;
+        }
+        state = *last_state;
+    }
+
+    if (state.type != type) {
         LOG_ERROR(Movie,
                   "Expected to read type {}, but found {}. Your playback will be out of sync",
-                  static_cast<int>(ControllerStateType::PadAndCircle), static_cast<int>(s.type));
-        return;
+                  static_cast<int>(type), static_cast<int>(state.type));
+        return false;
     }
+    return true;
+}
+
+void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y) {
+    ControllerState s;
+    if (!ReadState(ControllerStateType::PadAndCircle, s))
+        return;
 
     pad_state.a.Assign(s.pad_and_circle.a);
     pad_state.b.Assign(s.pad_and_circle.b);
@@ -172,15 +290,8 @@ void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circ
 
 void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
-
-    if (s.type != ControllerStateType::Touch) {
-        LOG_ERROR(Movie,
-                  "Expected to read type {}, but found {}. Your playback will be out of sync",
-                  static_cast<int>(ControllerStateType::Touch), static_cast<int>(s.type));
+    if (!ReadState(ControllerStateType::Touch, s))
         return;
-    }
 
     touch_data.x = s.touch.x;
     touch_data.y = s.touch.y;
@@ -189,15 +300,8 @@ void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
 
 void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
-
-    if (s.type != ControllerStateType::Accelerometer) {
-        LOG_ERROR(Movie,
-                  "Expected to read type {}, but found {}. Your playback will be out of sync",
-                  static_cast<int>(ControllerStateType::Accelerometer), static_cast<int>(s.type));
+    if (!ReadState(ControllerStateType::Accelerometer, s))
         return;
-    }
 
     accelerometer_data.x = s.accelerometer.x;
     accelerometer_data.y = s.accelerometer.y;
@@ -206,15 +310,8 @@ void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
 
 void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
-
-    if (s.type != ControllerStateType::Gyroscope) {
-        LOG_ERROR(Movie,
-                  "Expected to read type {}, but found {}. Your playback will be out of sync",
-                  static_cast<int>(ControllerStateType::Gyroscope), static_cast<int>(s.type));
+    if (!ReadState(ControllerStateType::Gyroscope, s))
         return;
-    }
 
     gyroscope_data.x = s.gyroscope.x;
     gyroscope_data.y = s.gyroscope.y;
@@ -223,15 +320,8 @@ void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
 
 void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_y) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
-
-    if (s.type != ControllerStateType::IrRst) {
-        LOG_ERROR(Movie,
-                  "Expected to read type {}, but found {}. Your playback will be out of sync",
-                  static_cast<int>(ControllerStateType::IrRst), static_cast<int>(s.type));
+    if (!ReadState(ControllerStateType::IrRst, s))
         return;
-    }
 
     c_stick_x = s.ir_rst.x;
     c_stick_y = s.ir_rst.y;
@@ -241,15 +331,8 @@ void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_
 
 void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
-
-    if (s.type != ControllerStateType::ExtraHidResponse) {
-        LOG_ERROR(
-            Movie, "Expected to read type {}, but found {}. Your playback will be out of sync",
-            static_cast<int>(ControllerStateType::ExtraHidResponse), static_cast<int>(s.type));
+    if (!ReadState(ControllerStateType::ExtraHidResponse, s))
         return;
-    }
 
     extra_hid_response.buttons.battery_level.Assign(
         static_cast<u8>(s.extra_hid_response.battery_level));
@@ -263,14 +346,23 @@ void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
 }
 
 void Movie::Record(const ControllerState& controller_state) {
-    recorded_input.resize(current_byte + sizeof(ControllerState));
-    std::memcpy(&recorded_input[current_byte], &controller_state, sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    ++input_position;
+    auto& last_state = input->last_states[static_cast<std::size_t>(controller_state.type)];
+    if (last_state &&
+        std::memcmp(&*last_state, &controller_state, sizeof(ControllerState)) == 0) {
+        if (++input->repeat_count == max_repeat_count)
+            input->FlushRepeats();
+        return;
+    }
+
+    input->FlushRepeats();
+    input->file.WriteBytes(&controller_state, sizeof(ControllerState));
+    last_state = controller_state;
 }
 
 void Movie::Record(const Service::HID::PadState& pad_state, const s16& circle_pad_x,
                    const s16& circle_pad_y) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::PadAndCircle;
 
     s.pad_and_circle.a.Assign(static_cast<u16>(pad_state.a));
@@ -295,7 +387,7 @@ void Movie::Record(const Service::HID::PadState& pad_state, const s16& circle_pa
 }
 
 void Movie::Record(const Service::HID::TouchDataEntry& touch_data) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::Touch;
 
     s.touch.x = touch_data.x;
@@ -306,7 +398,7 @@ void Movie::Record(const Service::HID::TouchDataEntry& touch_data) {
 }
 
 void Movie::Record(const Service::HID::AccelerometerDataEntry& accelerometer_data) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::Accelerometer;
 
     s.accelerometer.x = accelerometer_data.x;
@@ -317,7 +409,7 @@ void Movie::Record(const Service::HID::AccelerometerDataEntry& accelerometer_dat
 }
 
 void Movie::Record(const Service::HID::GyroscopeDataEntry& gyroscope_data) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::Gyroscope;
 
     s.gyroscope.x = gyroscope_data.x;
@@ -329,7 +421,7 @@ void Movie::Record(const Service::HID::GyroscopeDataEntry& gyroscope_data) {
 
 void Movie::Record(const Service::IR::PadState& pad_state, const s16& c_stick_x,
                    const s16& c_stick_y) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::IrRst;
 
     s.ir_rst.x = c_stick_x;
@@ -341,7 +433,7 @@ void Movie::Record(const Service::IR::PadState& pad_state, const s16& c_stick_x,
 }
 
 void Movie::Record(const Service::IR::ExtraHIDResponse& extra_hid_response) {
-    ControllerState s;
+    ControllerState s{};
     s.type = ControllerStateType::ExtraHidResponse;
 
     s.extra_hid_response.battery_level.Assign(extra_hid_response.buttons.battery_level);
@@ -382,15 +474,7 @@ Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 progr
     return ValidationResult::OK;
 }
 
-void Movie::SaveMovie() {
-    LOG_INFO(Movie, "Saving recorded movie to '{}'", record_movie_file);
-    FileUtil::IOFile save_record(record_movie_file, "wb");
-
-    if (!save_record.IsGood()) {
-        LOG_ERROR(Movie, "Unable to open file to save movie");
-        return;
-    }
-
+void Movie::WriteHeader() {
     CTMHeader header = {};
     header.filetype = header_magic_bytes;
     header.clock_init_time = init_time;
@@ -402,28 +486,23 @@ void Movie::SaveMovie() {
                            new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
     std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(CTMHeader::revision));
 
-    save_record.WriteBytes(&header, sizeof(CTMHeader));
-    save_record.WriteBytes(recorded_input.data(), recorded_input.size());
-
-    if (!save_record.IsGood()) {
-        LOG_ERROR(Movie, "Error saving movie");
-    }
+    input->file.WriteBytes(&header, sizeof(CTMHeader));
 }
 
 void Movie::StartPlayback(const std::string& movie_file,
                           std::function<void()> completion_callback) {
     LOG_INFO(Movie, "Loading Movie for playback");
-    FileUtil::IOFile save_record(movie_file, "rb");
-    const u64 size = save_record.GetSize();
+    auto stream = std::make_unique<InputStream>();
+    stream->file = FileUtil::IOFile(movie_file, "rb");
+    const u64 size = stream->file.GetSize();
 
-    if (save_record.IsGood() && size > sizeof(CTMHeader)) {
+    if (stream->file.IsGood() && size > sizeof(CTMHeader)) {
         CTMHeader header;
-        save_record.ReadArray(&header, 1);
+        stream->file.ReadArray(&header, 1);
         if (ValidateHeader(header) != ValidationResult::Invalid) {
             play_mode = PlayMode::Playing;
-            recorded_input.resize(size - sizeof(CTMHeader));
-            save_record.ReadArray(recorded_input.data(), recorded_input.size());
-            current_byte = 0;
+            input = std::move(stream);
+            input_position = 0;
             playback_completion_callback = completion_callback;
         }
     } else {
@@ -433,8 +512,19 @@ void Movie::StartPlayback(const std::string& movie_file,
 
 void Movie::StartRecording(const std::string& movie_file) {
     LOG_INFO(Movie, "Enabling Movie recording");
+    auto stream = std::make_unique<InputStream>();
+    stream->file = FileUtil::IOFile(movie_file, "wb");
+    if (!stream->file.IsGood()) {
+        LOG_ERROR(Movie, "Unable to open file to save movie");
+        return;
+    }
+
+    // The inputs are written as they are recorded
     play_mode = PlayMode::Recording;
     record_movie_file = movie_file;
+    input = std::move(stream);
+    input_position = 0;
+    WriteHeader();
 }
 
 static boost::optional<CTMHeader> ReadHeader(const std::string& movie_file) {
@@ -464,9 +554,10 @@ void Movie::PrepareForPlayback(const std::string& movie_file) {
 }
 
 void Movie::PrepareForRecording() {
-    init_time = (Settings::values.init_clock == Settings::InitClock::SystemTime
-                     ? Common::Timer::GetTimeSinceJan1970().count()
-                     : Settings::values.init_time);
+    const bool system_time = Settings::values.init_clock == Settings::InitClock::SystemTime &&
+                             !Settings::values.deterministic;
+    init_time = (system_time ? Common::Timer::GetTimeSinceJan1970().count()
+                             : Settings::values.init_time);
 }
 
 Movie::ValidationResult Movie::ValidateMovie(const std::string& movie_file, u64 program_id) const {
@@ -488,20 +579,23 @@ u64 Movie::GetMovieProgramID(const std::string& movie_file) const {
 
 void Movie::Shutdown() {
     if (IsRecordingInput()) {
-        SaveMovie();
+        LOG_INFO(Movie, "Saving recorded movie to '{}'", record_movie_file);
+        input->FlushRepeats();
+        if (!input->file.Flush() || !input->file.IsGood()) {
+            LOG_ERROR(Movie, "Error saving movie");
+        }
     }
 
     play_mode = PlayMode::None;
-    recorded_input.resize(0);
+    input.reset();
     record_movie_file.clear();
-    current_byte = 0;
+    input_position = 0;
     init_time = 0;
 }
 
 template <typename... Targs>
 void Movie::Handle(Targs&... Fargs) {
     if (IsPlayingInput()) {
-        ASSERT(current_byte + sizeof(ControllerState) <= recorded_input.size());
         Play(Fargs...);
         CheckInputEnd();
     } else if (IsRecordingInput()) {
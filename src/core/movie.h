@@ -5,6 +5,8 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <string>
 #include "common/common_types.h"
 
 namespace Service {
@@ -23,6 +25,7 @@ union PadState;
 namespace Core {
 struct CTMHeader;
 struct ControllerState;
+enum class ControllerStateType : u8;
 enum class PlayMode;
 
 class Movie {
@@ -41,6 +44,8 @@ public:
         return s_instance;
     }
 
+    ~Movie();
+
     void StartPlayback(const std::string& movie_file,
                        std::function<void()> completion_callback = [] {});
     void StartRecording(const std::string& movie_file);
@@ -98,9 +103,19 @@ public:
     bool IsPlayingInput() const;
     bool IsRecordingInput() const;
 
+    /**
+     * Gets the number of input states played or recorded so far, which can be stored alongside a
+     * snapshot of the emulated state to know which inputs were recorded after it.
+     */
+    std::size_t GetInputPosition() const;
+
 private:
+    struct InputStream;
+
     static Movie s_instance;
 
+    Movie();
+
     void CheckInputEnd();
 
     template <typename... Targs>
@@ -122,15 +137,22 @@ private:
     void Record(const Service::IR::PadState& pad_state, const s16& c_stick_x, const s16& c_stick_y);
     void Record(const Service::IR::ExtraHIDResponse& extra_hid_response);
 
+    /**
+     * Reads the next input state from the movie.
+     * @returns false if the state isn't of the expected type
+     */
+    bool ReadState(ControllerStateType type, ControllerState& state);
+
     ValidationResult ValidateHeader(const CTMHeader& header, u64 program_id = 0) const;
 
-    void SaveMovie();
+    void WriteHeader();
 
     PlayMode play_mode;
     std::string record_movie_file;
-    std::vector<u8> recorded_input;
+    /// The file being played or recorded
+    std::unique_ptr<InputStream> input;
     u64 init_time;
     std::function<void()> playback_completion_callback;
-    std::size_t current_byte = 0;
+    std::size_t input_position = 0;
 };
 } // namespace Core
\ No newline at end of file
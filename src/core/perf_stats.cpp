@@ -4,19 +4,94 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <mutex>
 #include <thread>
+#include "common/frame_counters.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
 
 using namespace std::chrono_literals;
 using DoubleSecs = std::chrono::duration<double, std::chrono::seconds::period>;
+using FloatMillis = std::chrono::duration<float, std::milli>;
 using std::chrono::duration_cast;
 using std::chrono::microseconds;
 
 namespace Core {
 
+const char* GetFramePhaseName(FramePhase phase) {
+    switch (phase) {
+    case FramePhase::CPU:
+        return "CPU";
+    case FramePhase::GPU:
+        return "GPU";
+    case FramePhase::Present:
+        return "Present";
+    case FramePhase::FrameLimiter:
+        return "Frame limiter";
+    default:
+        return "Unknown";
+    }
+}
+
+void DurationHistogram::Add(std::chrono::nanoseconds duration) {
+    const s64 ns = std::max<s64>(duration.count(), 0);
+    const auto bucket = std::min(static_cast<std::size_t>(ns / BUCKET_WIDTH_NS), NUM_BUCKETS - 1);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    s64 current_max = max_ns.load(std::memory_order_relaxed);
+    while (ns > current_max &&
+           !max_ns.compare_exchange_weak(current_max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+DurationDistribution DurationHistogram::GetAndReset() {
+    std::array<u32, NUM_BUCKETS> counts;
+    u64 total = 0;
+    for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+        counts[i] = buckets[i].exchange(0, std::memory_order_relaxed);
+        total += counts[i];
+    }
+    const double max_ms = max_ns.exchange(0, std::memory_order_relaxed) / 1'000'000.0;
+
+    // Reports the upper bound of the bucket holding the percentile, which can't exceed the max
+    const auto percentile = [&](double fraction) {
+        const auto rank = static_cast<u64>(std::ceil(fraction * total));
+        u64 seen = 0;
+        for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank && seen != 0) {
+                return std::min((i + 1) * BUCKET_WIDTH_NS / 1'000'000.0, max_ms);
+            }
+        }
+        return max_ms;
+    };
+
+    return {percentile(0.5), percentile(0.95), percentile(0.99), max_ms};
+}
+
+/// Innermost phase being measured on this thread
+static thread_local PerfStats::ScopedPhase* current_phase = nullptr;
+
+PerfStats::ScopedPhase::ScopedPhase(PerfStats& stats, FramePhase phase)
+    : stats(stats), phase(phase), start(Clock::now()), parent(current_phase) {
+    current_phase = this;
+}
+
+PerfStats::ScopedPhase::~ScopedPhase() {
+    const auto elapsed = Clock::now() - start;
+    current_phase = parent;
+    if (parent != nullptr) {
+        parent->nested_time += elapsed;
+    }
+
+    const auto own_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - nested_time);
+    stats.phase_time_ns[static_cast<std::size_t>(phase)].fetch_add(own_time.count(),
+                                                                   std::memory_order_relaxed);
+}
+
 void PerfStats::BeginSystemFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -29,6 +104,30 @@ void PerfStats::EndSystemFrame() {
     auto frame_end = Clock::now();
     accumulated_frametime += frame_end - frame_begin;
     system_frames += 1;
+    total_system_frames.fetch_add(1, std::memory_order_relaxed);
+
+    Common::EndCountersFrame();
+
+    FrameSample sample;
+    sample.frametime_ms = duration_cast<FloatMillis>(frame_end - frame_begin).count();
+
+    frametime_histogram.Add(frame_end - frame_begin);
+    // Presenting and frame limiting happen after the end of a frame, so their time is counted in
+    // the next one. The distributions are the same.
+    for (std::size_t i = 0; i < phase_histograms.size(); ++i) {
+        const std::chrono::nanoseconds phase_time{
+            phase_time_ns[i].exchange(0, std::memory_order_relaxed)};
+        phase_histograms[i].Add(phase_time);
+        sample.phase_ms[i] = duration_cast<FloatMillis>(phase_time).count();
+    }
+
+    sample.shader_compiles = shader_compiles.exchange(0, std::memory_order_relaxed);
+    sample.texture_cache_bytes = texture_cache_bytes;
+    sample.texture_cache_surfaces = texture_cache_surfaces;
+    sample.audio_latency_ms = audio_latency_ms.load(std::memory_order_relaxed);
+    sample.memory_usage = Common::GetMemoryUsage();
+    // Dropped if nobody reads the samples
+    frame_samples.TryPush(sample);
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
@@ -40,6 +139,47 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddPresent() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    const auto now = Clock::now();
+    if (previous_present) {
+        const auto interval = now - *previous_present;
+        present_interval_histogram.Add(interval);
+        const double interval_ms = std::chrono::duration<double, std::milli>(interval).count();
+        present_intervals += 1;
+        present_interval_sum += interval_ms;
+        present_interval_square_sum += interval_ms * interval_ms;
+    }
+    previous_present = now;
+}
+
+void PerfStats::AddSkippedFrame() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    skipped_frames += 1;
+}
+
+void PerfStats::SetTextureCacheStats(u64 cached_bytes, u32 surface_count) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    texture_cache_bytes = cached_bytes;
+    texture_cache_surfaces = surface_count;
+}
+
+void PerfStats::AddTextureCacheEvictions(u32 count) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    texture_cache_evictions += count;
+}
+
+void PerfStats::AddGLStateStats(u32 applies, u32 groups_skipped) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    gl_state_applies += applies;
+    gl_state_groups_skipped += groups_skipped;
+}
+
 PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_us) {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -55,6 +195,28 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    results.texture_cache_bytes = texture_cache_bytes;
+    results.texture_cache_surfaces = texture_cache_surfaces;
+    results.texture_cache_evictions = texture_cache_evictions;
+    results.gl_state_applies = gl_state_applies;
+    results.gl_state_groups_skipped = gl_state_groups_skipped;
+    results.accelerated_draws = accelerated_draws.exchange(0);
+    results.cpu_vertex_draws = cpu_vertex_draws.exchange(0);
+    results.vertex_cache_hits = vertex_cache_hits.exchange(0);
+    results.vertex_cache_misses = vertex_cache_misses.exchange(0);
+    results.idle_loop_cycles_skipped = idle_loop_cycles_skipped.exchange(0);
+    results.frametime_distribution = frametime_histogram.GetAndReset();
+    for (std::size_t i = 0; i < phase_histograms.size(); ++i) {
+        results.phase_distributions[i] = phase_histograms[i].GetAndReset();
+    }
+    results.present_interval_distribution = present_interval_histogram.GetAndReset();
+    if (present_intervals != 0) {
+        const double mean = present_interval_sum / present_intervals;
+        const double variance = present_interval_square_sum / present_intervals - mean * mean;
+        results.present_jitter = std::sqrt(std::max(variance, 0.0));
+    }
+    results.skipped_frames = skipped_frames;
+    results.memory_usage = Common::GetMemoryUsage();
 
     // Reset counters
     reset_point = now;
@@ -62,6 +224,13 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    texture_cache_evictions = 0;
+    gl_state_applies = 0;
+    gl_state_groups_skipped = 0;
+    present_intervals = 0;
+    present_interval_sum = 0.0;
+    present_interval_square_sum = 0.0;
+    skipped_frames = 0;
 
     return results;
 }
@@ -75,9 +244,14 @@ double PerfStats::GetLastFrameTimeScale() {
 
 void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
     if (frame_advancing_enabled) {
-        // Frame advancing is enabled: wait on event instead of doing framelimiting
-        frame_advance_event.Wait();
-        frame_advance_event.Reset();
+        // Frame advancing is enabled: wait for a frame advance instead of doing framelimiting
+        std::unique_lock lock{frame_advance_mutex};
+        frame_advance_waiting = true;
+        frame_advance_cv.notify_all();
+        frame_advance_cv.wait(lock,
+                              [this] { return frame_advance_pending || !frame_advancing_enabled; });
+        frame_advance_pending = false;
+        frame_advance_waiting = false;
         return;
     }
 
@@ -85,8 +259,19 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         return;
     }
 
+    if (fast_forward_enabled) {
+        // Limiting starts over from here when fast-forward ends, instead of sleeping off the lead
+        previous_system_time_us = current_system_time_us;
+        previous_walltime = Clock::now();
+        frame_limiting_delta_err = microseconds::zero();
+        return;
+    }
+
     auto now = Clock::now();
     double sleep_scale = Settings::values.frame_limit / 100.0;
+    if (Settings::values.low_power_mode) {
+        sleep_scale = std::min(sleep_scale, 1.0);
+    }
 
     // Max lag caused by slow frames. Shouldn't be more than the length of a frame at the current
     // speed percent or it will clamp too much and prevent this from properly limiting to that
@@ -97,11 +282,31 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         std::chrono::duration<double, std::chrono::microseconds::period>(
             (current_system_time_us - previous_system_time_us) / sleep_scale));
     frame_limiting_delta_err -= duration_cast<microseconds>(now - previous_walltime);
+    // The low power mode doesn't run faster than the target speed to catch up after slow frames,
+    // which would keep the host at its highest clocks
+    const microseconds min_delta_err =
+        Settings::values.low_power_mode ? microseconds::zero() : -max_lag_time_us;
     frame_limiting_delta_err =
-        std::clamp(frame_limiting_delta_err, -max_lag_time_us, max_lag_time_us);
+        std::clamp(frame_limiting_delta_err, min_delta_err, max_lag_time_us);
 
     if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
+        microseconds sleep_time = frame_limiting_delta_err;
+        if (sleep_scale == 1.0) {
+            std::lock_guard lock{vsync_mutex};
+            if (refresh_period != Clock::duration::zero()) {
+                // Sleeps until the refresh nearest to the target. The difference is made up by the
+                // next frames, so the frames stay at the target speed on average, and one is
+                // repeated or dropped whenever the emulated and display rates drift apart by half
+                // a refresh.
+                const Clock::time_point target = now + sleep_time;
+                const double refreshes =
+                    std::round(DoubleSecs(target - vsync_time) / refresh_period);
+                const Clock::time_point aligned =
+                    vsync_time + duration_cast<Clock::duration>(refresh_period * refreshes);
+                sleep_time = duration_cast<microseconds>(aligned - now);
+            }
+        }
+        std::this_thread::sleep_for(sleep_time);
         auto now_after_sleep = Clock::now();
         frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
         now = now_after_sleep;
@@ -111,20 +316,60 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
     previous_walltime = now;
 }
 
-void FrameLimiter::SetFrameAdvancing(bool value) {
-    const bool was_enabled = frame_advancing_enabled.exchange(value);
-    if (was_enabled && !value) {
-        // Set the event to let emulation continue
-        frame_advance_event.Set();
+bool FrameLimiter::ShouldSkipFrame(u16 max_skipped) {
+    if (fast_forward_enabled && !frame_advancing_enabled) {
+        // Presenting every frame would bound the speed, so only as many as a display shows are
+        constexpr Clock::duration present_interval =
+            duration_cast<Clock::duration>(1s) / FAST_FORWARD_PRESENT_RATE;
+        const auto now = Clock::now();
+        if (now - previous_present_walltime < present_interval) {
+            return true;
+        }
+        previous_present_walltime = now;
+        return false;
+    }
+
+    const bool behind = max_skipped != 0 && Settings::values.use_frame_limit &&
+                        !frame_advancing_enabled && frame_limiting_delta_err <= -FRAME_SKIP_LAG;
+    if (!behind || frames_skipped_in_row >= max_skipped) {
+        frames_skipped_in_row = 0;
+        return false;
     }
+    ++frames_skipped_in_row;
+    return true;
+}
+
+void FrameLimiter::SetDisplayVsync(Clock::time_point vsync_time_, Clock::duration refresh_period_) {
+    std::lock_guard lock{vsync_mutex};
+    vsync_time = vsync_time_;
+    refresh_period = refresh_period_;
+}
+
+void FrameLimiter::SetFrameAdvancing(bool value) {
+    std::lock_guard lock{frame_advance_mutex};
+    frame_advancing_enabled = value;
+    // Let emulation continue if it is held
+    frame_advance_cv.notify_all();
 }
 
 void FrameLimiter::AdvanceFrame() {
-    if (!frame_advancing_enabled) {
-        // Start frame advancing
-        frame_advancing_enabled = true;
-    }
-    frame_advance_event.Set();
+    std::lock_guard lock{frame_advance_mutex};
+    frame_advancing_enabled = true;
+    frame_advance_pending = true;
+    frame_advance_cv.notify_all();
+}
+
+bool FrameLimiter::AdvanceFrameAndWait(std::chrono::milliseconds timeout) {
+    std::unique_lock lock{frame_advance_mutex};
+    frame_advancing_enabled = true;
+    frame_advance_pending = true;
+    frame_advance_cv.notify_all();
+    // A pending advance is taken when emulation reaches the end of the current frame, so the
+    // frame is done once emulation is held again with no advance pending
+    const bool done = frame_advance_cv.wait_for(lock, timeout, [this] {
+        return (frame_advance_waiting && !frame_advance_pending) || !frame_advancing_enabled;
+    });
+    return done && frame_advancing_enabled;
 }
 
 } // namespace Core
@@ -4,14 +4,82 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <mutex>
+#include <optional>
 #include "common/common_types.h"
+#include "common/memory_usage.h"
 #include "common/thread.h"
+#include "common/threadsafe_queue.h"
 
 namespace Core {
 
+/// Parts of the work done for each system frame, whose time is tracked separately
+enum class FramePhase : std::size_t {
+    /// Emulating the guest CPU, including the HLE services it calls
+    CPU,
+    /// Processing PICA command lists, memory fills and display transfers
+    GPU,
+    /// Drawing the screens and swapping the buffers of the window
+    Present,
+    /// Sleeping in the frame limiter
+    FrameLimiter,
+
+    Count,
+};
+
+/// Gets a human readable name of a frame phase
+const char* GetFramePhaseName(FramePhase phase);
+
+/// Percentiles of a set of durations, in milliseconds
+struct DurationDistribution {
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+/// Statistics of a single system frame, for live displays like the renderer's overlay
+struct FrameSample {
+    /// Walltime of the frame excluding any waits, in milliseconds
+    float frametime_ms;
+    /// Time spent in each FramePhase during the frame, in milliseconds
+    std::array<float, static_cast<std::size_t>(FramePhase::Count)> phase_ms;
+    /// Shaders the renderer compiled during the frame
+    u32 shader_compiles;
+    /// Size of the renderer's surface cache at the end of the frame
+    u64 texture_cache_bytes;
+    u32 texture_cache_surfaces;
+    /// Latency of the audio output at the end of the frame, in milliseconds
+    float audio_latency_ms;
+    /// Host memory used by each Common::MemoryCategory at the end of the frame, in bytes
+    Common::MemoryUsage memory_usage;
+};
+
+/**
+ * Histogram of the durations of a recurring event. Durations are added lock-free, so it can be
+ * updated from any thread without contending with the readers.
+ */
+class DurationHistogram {
+public:
+    void Add(std::chrono::nanoseconds duration);
+
+    /// Computes the percentiles of the durations added since the last reset and resets them
+    DurationDistribution GetAndReset();
+
+private:
+    /// Durations are counted in buckets of 100us, the last bucket also counts longer ones
+    static constexpr s64 BUCKET_WIDTH_NS = 100'000;
+    static constexpr std::size_t NUM_BUCKETS = 1000;
+
+    std::array<std::atomic<u32>, NUM_BUCKETS> buckets{};
+    std::atomic<s64> max_ns{0};
+};
+
 /**
  * Class to manage and query performance/timing statistics. All public functions of this class are
  * thread-safe unless stated otherwise.
@@ -29,20 +97,132 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Video memory used by the textures of the renderer's surface cache, in bytes
+        u64 texture_cache_bytes;
+        /// Number of surfaces in the renderer's surface cache
+        u32 texture_cache_surfaces;
+        /// Surfaces evicted from the surface cache to stay within its budget since last reset
+        u32 texture_cache_evictions;
+        /// Renderer state applications since last reset
+        u32 gl_state_applies;
+        /// Groups of renderer state left untouched by those applications since last reset
+        u32 gl_state_groups_skipped;
+        /// PICA draws that ran the vertex shader on the GPU since last reset
+        u32 accelerated_draws;
+        /// PICA draws that fell back to the CPU vertex pipeline with hardware shaders enabled
+        u32 cpu_vertex_draws;
+        /// Indexed vertices of the CPU vertex pipeline reused from the post-transform cache
+        u32 vertex_cache_hits;
+        /// Indexed vertices of the CPU vertex pipeline that ran the vertex shader
+        u32 vertex_cache_misses;
+        /// CPU cycles skipped because the guest was spinning in an idle loop
+        u64 idle_loop_cycles_skipped;
+        /// Distribution of the walltime per system frame, excluding any waits
+        DurationDistribution frametime_distribution;
+        /// Distribution of the time spent in each FramePhase per system frame
+        std::array<DurationDistribution, static_cast<std::size_t>(FramePhase::Count)>
+            phase_distributions;
+        /// Distribution of the walltime between consecutive presents of the screens
+        DurationDistribution present_interval_distribution;
+        /// Standard deviation of the walltime between consecutive presents, in milliseconds
+        double present_jitter;
+        /// System frames whose presentation was skipped to catch up since last reset
+        u32 skipped_frames;
+        /// Host memory currently used by each Common::MemoryCategory, in bytes
+        Common::MemoryUsage memory_usage;
+    };
+
+    /**
+     * Measures the time spent in a frame phase for as long as it exists. Phases can be nested on
+     * the same thread, for example GPU work run from the CPU thread, in which case the time of the
+     * inner phase is not counted for the outer one.
+     */
+    class ScopedPhase {
+    public:
+        ScopedPhase(PerfStats& stats, FramePhase phase);
+        ~ScopedPhase();
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        PerfStats& stats;
+        FramePhase phase;
+        Clock::time_point start;
+        /// Time spent in the phases nested inside of this one
+        Clock::duration nested_time = Clock::duration::zero();
+        ScopedPhase* parent;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
+    /// Records that the screens were presented, which may happen on another thread than the
+    /// system frames when the GPU thread presents asynchronously
+    void AddPresent();
+    /// Records that the presentation of a system frame was skipped by the frame limiter
+    void AddSkippedFrame();
+
+    /// Updates the current size of the renderer's surface cache
+    void SetTextureCacheStats(u64 cached_bytes, u32 surface_count);
+    void AddTextureCacheEvictions(u32 count);
+
+    /// Accumulates the counters of the renderer's state tracker
+    void AddGLStateStats(u32 applies, u32 groups_skipped);
+
+    /// Counts a PICA draw processed with hardware shaders enabled. This is called for every draw,
+    /// so it is lock-free unlike the other functions.
+    void AddPicaDraw(bool accelerated) {
+        auto& counter = accelerated ? accelerated_draws : cpu_vertex_draws;
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Accumulates the post-transform vertex cache counters of an indexed CPU draw, lock-free
+    void AddVertexCacheStats(u32 hits, u32 misses) {
+        vertex_cache_hits.fetch_add(hits, std::memory_order_relaxed);
+        vertex_cache_misses.fetch_add(misses, std::memory_order_relaxed);
+    }
+
+    /// Accumulates the cycles skipped by idle loop detection, lock-free
+    void AddIdleLoopCycles(u64 cycles) {
+        idle_loop_cycles_skipped.fetch_add(cycles, std::memory_order_relaxed);
+    }
+
+    /// Counts a shader compiled by the renderer, lock-free
+    void AddShaderCompile() {
+        shader_compiles.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Updates the latency of the audio output reported in the frame samples, lock-free
+    void SetAudioLatency(double latency_ms) {
+        audio_latency_ms.store(static_cast<float>(latency_ms), std::memory_order_relaxed);
+    }
+
+    /**
+     * Pops the oldest statistics of a system frame that weren't popped yet, lock-free. The most
+     * recent FRAME_SAMPLE_CAPACITY frames are kept, newer ones are dropped until some are popped.
+     * Only one thread may pop samples.
+     * @returns false if there is no new sample
+     */
+    bool PopFrameSample(FrameSample& sample) {
+        return frame_samples.Pop(sample);
+    }
 
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
+    /// Gets the total number of system frames presented, which is never reset, lock-free
+    u64 GetTotalSystemFrames() const {
+        return total_system_frames.load(std::memory_order_relaxed);
+    }
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
      */
     double GetLastFrameTimeScale();
 
+    static constexpr std::size_t FRAME_SAMPLE_CAPACITY = 256;
+
 private:
     std::mutex object_mutex;
 
@@ -57,6 +237,48 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative number of surfaces evicted from the texture cache since last reset
+    u32 texture_cache_evictions = 0;
+    /// Cumulative number of renderer state applications since last reset
+    u32 gl_state_applies = 0;
+    /// Cumulative number of state groups skipped by those applications since last reset
+    u32 gl_state_groups_skipped = 0;
+    /// Cumulative number of system frames not presented by frame skipping since last reset
+    u32 skipped_frames = 0;
+    /// Cumulative number of PICA draws with and without vertex acceleration since last reset
+    std::atomic<u32> accelerated_draws{0};
+    std::atomic<u32> cpu_vertex_draws{0};
+    /// Cumulative post-transform vertex cache hits and misses since last reset
+    std::atomic<u32> vertex_cache_hits{0};
+    std::atomic<u32> vertex_cache_misses{0};
+    /// Cumulative number of CPU cycles skipped in idle loops since last reset
+    std::atomic<u64> idle_loop_cycles_skipped{0};
+    /// Total number of system frames presented, never reset
+    std::atomic<u64> total_system_frames{0};
+
+    /// Number of shaders compiled during the current system frame
+    std::atomic<u32> shader_compiles{0};
+    /// Latest latency of the audio output, in milliseconds
+    std::atomic<float> audio_latency_ms{0.0f};
+    /// Statistics of the frames ended by EndSystemFrame, which is only called by one thread
+    Common::BoundedSPSCQueue<FrameSample, FRAME_SAMPLE_CAPACITY> frame_samples;
+
+    /// Time spent in each phase during the current system frame, in nanoseconds
+    std::array<std::atomic<s64>, static_cast<std::size_t>(FramePhase::Count)> phase_time_ns{};
+    DurationHistogram frametime_histogram;
+    std::array<DurationHistogram, static_cast<std::size_t>(FramePhase::Count)> phase_histograms;
+
+    /// Point when the screens were last presented
+    std::optional<Clock::time_point> previous_present;
+    DurationHistogram present_interval_histogram;
+    /// Number, sum and sum of squares of the present intervals since last reset, in milliseconds
+    u32 present_intervals = 0;
+    double present_interval_sum = 0.0;
+    double present_interval_square_sum = 0.0;
+
+    /// Current size of the renderer's surface cache
+    u64 texture_cache_bytes = 0;
+    u32 texture_cache_surfaces = 0;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -80,7 +302,54 @@ public:
     void SetFrameAdvancing(bool value);
     void AdvanceFrame();
 
+    /**
+     * Advances a frame and waits until it has been emulated and presented, and emulation is held
+     * before the next one.
+     * @returns false if that didn't happen before the timeout, e.g. while emulation is paused
+     */
+    bool AdvanceFrameAndWait(std::chrono::milliseconds timeout);
+
+    bool IsFrameAdvancing() const {
+        return frame_advancing_enabled;
+    }
+
+    /**
+     * Sets whether to fast-forward, which ignores the frame limit and presents frames only up to
+     * FAST_FORWARD_PRESENT_RATE per second of walltime. Use System::SetFastForward, which also
+     * changes the audio output and the thread priorities.
+     */
+    void SetFastForward(bool value) {
+        fast_forward_enabled = value;
+    }
+
+    bool IsFastForwarding() const {
+        return fast_forward_enabled;
+    }
+
+    /**
+     * Aligns frame limiting to the refresh of the display, so that emulating each frame starts
+     * right after a refresh instead of at a phase that drifts, and the frames are delivered
+     * evenly. Frontends with a vsync source call this from it, e.g. from an AChoreographer
+     * callback on Android. Only done at 100% speed.
+     * @param vsync_time time of the latest refresh
+     * @param refresh_period time between two refreshes, zero to stop aligning
+     */
+    void SetDisplayVsync(Clock::time_point vsync_time, Clock::duration refresh_period);
+
+    /**
+     * Decides whether to skip presenting the current system frame, which is the case while the
+     * last frame limiting found emulation behind the target speed. Never skips more than
+     * max_skipped frames in a row, nor while frame advancing or without a frame limit. While
+     * fast-forwarding, skips the frames that would exceed the display rate instead.
+     */
+    bool ShouldSkipFrame(u16 max_skipped);
+
 private:
+    /// Lag behind the target speed from which frames are skipped
+    static constexpr std::chrono::microseconds FRAME_SKIP_LAG{8000};
+    /// Frames presented per second while fast-forwarding, the others are skipped
+    static constexpr int FAST_FORWARD_PRESENT_RATE = 60;
+
     /// Emulated system time (in microseconds) at the last limiter invocation
     std::chrono::microseconds previous_system_time_us{0};
     /// Walltime at the last limiter invocation
@@ -88,12 +357,28 @@ private:
 
     /// Accumulated difference between walltime and emulated time
     std::chrono::microseconds frame_limiting_delta_err{0};
+    /// Number of frames skipped since the last presented one
+    u16 frames_skipped_in_row = 0;
+    /// Walltime at which the last frame was presented while fast-forwarding
+    Clock::time_point previous_present_walltime{};
+
+    std::mutex vsync_mutex;
+    /// Time of the latest display refresh reported by the frontend
+    Clock::time_point vsync_time{};
+    /// Time between display refreshes, zero when not aligning to them
+    Clock::duration refresh_period{};
+
+    std::atomic_bool fast_forward_enabled{false};
 
     /// Whether to use frame advancing (i.e. frame by frame)
     std::atomic_bool frame_advancing_enabled;
 
-    /// Event to advance the frame when frame advancing is enabled
-    Common::Event frame_advance_event;
+    std::mutex frame_advance_mutex;
+    std::condition_variable frame_advance_cv;
+    /// Whether a frame should be emulated when frame advancing is enabled
+    bool frame_advance_pending = false;
+    /// Whether emulation is held by frame advancing
+    bool frame_advance_waiting = false;
 };
 
 } // namespace Core
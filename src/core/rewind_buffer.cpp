@@ -0,0 +1,48 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "core/rewind_buffer.h"
+
+namespace Core {
+
+RewindBuffer::RewindBuffer(std::size_t max_data_size) : max_data_size(max_data_size) {}
+
+void RewindBuffer::Capture(Memory::MemorySystem& memory, u64 ticks, std::size_t input_position) {
+    const Memory::MemorySnapshot* previous = entries.empty() ? nullptr : &entries.back().memory;
+    Memory::MemorySnapshot snapshot = Memory::MemorySnapshot::Capture(memory, previous);
+    const std::size_t new_data_size = snapshot.GetNewDataSize();
+    entries.push_back({ticks, input_position, std::move(snapshot), new_data_size});
+    data_size += new_data_size;
+
+    // Always keep the snapshot that was just captured, even if it is over the budget on its own
+    while (data_size > max_data_size && entries.size() > 1) {
+        data_size -= entries.front().data_size;
+        entries.pop_front();
+
+        // The pages the new oldest entry shared with the dropped one are now its own
+        Entry& oldest = entries.front();
+        data_size = data_size - oldest.data_size + oldest.memory.GetDataSize();
+        oldest.data_size = oldest.memory.GetDataSize();
+    }
+}
+
+const RewindBuffer::Entry& RewindBuffer::GetEntry(std::size_t index) const {
+    ASSERT(index < entries.size());
+    return entries[entries.size() - 1 - index];
+}
+
+u64 RewindBuffer::GetDurationTicks() const {
+    if (entries.empty()) {
+        return 0;
+    }
+    return entries.back().ticks - entries.front().ticks;
+}
+
+void RewindBuffer::Clear() {
+    entries.clear();
+    data_size = 0;
+}
+
+} // namespace Core
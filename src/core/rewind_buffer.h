@@ -0,0 +1,65 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include "common/common_types.h"
+#include "core/memory_snapshot.h"
+
+namespace Core {
+
+/**
+ * Keeps the most recent snapshots of the emulated memory within a memory budget. Every snapshot is
+ * captured against the previous one, so a snapshot only costs the pages that changed since then.
+ * When the budget is exceeded, the oldest snapshots are dropped first.
+ */
+class RewindBuffer {
+public:
+    struct Entry {
+        /// Value of Core::Timing::GetTicks when the snapshot was captured
+        u64 ticks;
+        /// Value of Movie::GetInputPosition when the snapshot was captured
+        std::size_t input_position;
+        Memory::MemorySnapshot memory;
+        /// Bytes of page data kept alive only by this entry
+        std::size_t data_size;
+    };
+
+    /// @param max_data_size maximum number of bytes of page data held by the buffer
+    explicit RewindBuffer(std::size_t max_data_size);
+
+    /// Captures a new snapshot, dropping the oldest ones if the buffer goes over its budget
+    void Capture(Memory::MemorySystem& memory, u64 ticks, std::size_t input_position);
+
+    /**
+     * Gets an entry of the buffer.
+     * @param index 0 for the most recent snapshot, up to GetEntryCount() - 1 for the oldest one
+     */
+    const Entry& GetEntry(std::size_t index) const;
+
+    std::size_t GetEntryCount() const {
+        return entries.size();
+    }
+
+    /// Number of bytes of page data held by the buffer
+    std::size_t GetDataSize() const {
+        return data_size;
+    }
+
+    /// Number of ticks between the oldest and the most recent snapshot
+    u64 GetDurationTicks() const;
+
+    /// Drops all the snapshots, for example after the emulated state was replaced
+    void Clear();
+
+private:
+    std::size_t max_data_size;
+    std::size_t data_size = 0;
+    /// The most recent snapshot is at the back
+    std::deque<Entry> entries;
+};
+
+} // namespace Core
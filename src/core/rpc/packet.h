@@ -14,6 +14,49 @@ enum class PacketType {
     Undefined = 0,
     ReadMemory,
     WriteMemory,
+    /// Reads the values of Common::FrameCounter during the last frame, as u64 each. The address is
+    /// the index of the first counter.
+    ReadFrameCounters,
+    /// Reads the name of the Common::FrameCounter at the index given as the address
+    ReadFrameCounterName,
+    /// Reads several ranges in one request. The data is a list of address/data_size pairs, the
+    /// reply holds the content of the ranges one after the other.
+    ReadMemoryBatch,
+    /// Writes several ranges in one request. The data is a list of address/data_size pairs, each
+    /// followed by the data_size bytes to write.
+    WriteMemoryBatch,
+    /// Emulates the number of frames given as the address, holding emulation after them, or
+    /// resumes emulation when it is 0. The reply holds the number of frames done, as u32.
+    AdvanceFrames,
+    /// Replaces the input of the emulated console, the data is an InputState
+    SetInput,
+    /// Reads the physical address, format, width, height and stride of the framebuffer displayed
+    /// on the screen given as the address (0 for the top screen), as u32 each
+    ReadFramebufferInfo,
+    /// Reads data_size bytes of the framebuffer displayed on the screen given as the address,
+    /// from the u32 offset following data_size. The content is up to date while frames are
+    /// advanced.
+    ReadFramebuffer,
+    /// Reads the host memory used by each Common::MemoryCategory, in bytes as u64 each. The
+    /// address is the index of the first category.
+    ReadMemoryUsage,
+    /// Reads the name of the Common::MemoryCategory at the index given as the address
+    ReadMemoryCategoryName,
+    /// Starts fast-forwarding when the address is 1, stops it when it is 0
+    SetFastForward,
+};
+
+/// Data of a SetInput request
+struct InputState {
+    /// Bit 0 replaces the input, the input devices are used again when it is clear. Bit 1 sets
+    /// the touch screen as pressed.
+    u32 flags;
+    /// The buttons, as Service::HID::PadState
+    u32 pad;
+    s16 circle_pad_x;
+    s16 circle_pad_y;
+    u16 touch_x;
+    u16 touch_y;
 };
 
 struct PacketHeader {
@@ -25,7 +68,7 @@ struct PacketHeader {
 
 constexpr u32 CURRENT_VERSION = 1;
 constexpr u32 MIN_PACKET_SIZE = sizeof(PacketHeader);
-constexpr u32 MAX_PACKET_DATA_SIZE = 32;
+constexpr u32 MAX_PACKET_DATA_SIZE = 0x8000;
 constexpr u32 MAX_PACKET_SIZE = MIN_PACKET_SIZE + MAX_PACKET_DATA_SIZE;
 constexpr u32 MAX_READ_SIZE = MAX_PACKET_DATA_SIZE;
 
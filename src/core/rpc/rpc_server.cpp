@@ -1,7 +1,17 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common/frame_counters.h"
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/service/hid/hid.h"
+#include "core/hw/gpu.h"
 #include "core/memory.h"
 #include "core/rpc/packet.h"
 #include "core/rpc/rpc_server.h"
@@ -37,7 +47,7 @@ void RPCServer::HandleReadMemory(Packet& packet, u32 address, u32 data_size) {
     packet.SendReply();
 }
 
-void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size) {
+static void WriteMemory(u32 address, const u8* data, u32 data_size) {
     // Only allow writing to certain memory regions
     if ((address >= Memory::PROCESS_IMAGE_VADDR && address <= Memory::PROCESS_IMAGE_VADDR_END) ||
         (address >= Memory::HEAP_VADDR && address <= Memory::HEAP_VADDR_END) ||
@@ -48,19 +58,231 @@ void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u
         // If the memory happens to be executable code, make sure the changes become visible
         Core::CPU().InvalidateCacheRange(address, data_size);
     }
+}
+
+void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size) {
+    WriteMemory(address, data, data_size);
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadMemoryBatch(Packet& packet) {
+    // The ranges are read before the reply overwrites them
+    std::vector<u32> ranges(packet.GetPacketDataSize() / sizeof(u32));
+    std::memcpy(ranges.data(), packet.GetPacketData().data(), ranges.size() * sizeof(u32));
+
+    auto& memory = Core::System::GetInstance().Memory();
+    const auto& process = *Core::System::GetInstance().Kernel().GetCurrentProcess();
+    u32 reply_size = 0;
+    for (std::size_t i = 0; i < ranges.size(); i += 2) {
+        memory.ReadBlock(process, ranges[i], packet.GetPacketData().data() + reply_size,
+                         ranges[i + 1]);
+        reply_size += ranges[i + 1];
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
+void RPCServer::HandleWriteMemoryBatch(Packet& packet) {
+    const u8* data = packet.GetPacketData().data();
+    for (u32 offset = 0; offset < packet.GetPacketDataSize();) {
+        u32 address;
+        u32 data_size;
+        std::memcpy(&address, data + offset, sizeof(address));
+        std::memcpy(&data_size, data + offset + sizeof(address), sizeof(data_size));
+        WriteMemory(address, data + offset + sizeof(u32) * 2, data_size);
+        offset += sizeof(u32) * 2 + data_size;
+    }
     packet.SetPacketDataSize(0);
     packet.SendReply();
 }
 
+/// Whether a ReadMemoryBatch request is well formed and its reply fits in a packet
+static bool ValidateReadMemoryBatch(Packet& packet) {
+    const u32 size = packet.GetPacketDataSize();
+    if (size % (sizeof(u32) * 2) != 0) {
+        return false;
+    }
+
+    u64 reply_size = 0;
+    for (u32 offset = 0; offset < size; offset += sizeof(u32) * 2) {
+        u32 data_size;
+        std::memcpy(&data_size, packet.GetPacketData().data() + offset + sizeof(u32),
+                    sizeof(data_size));
+        if (data_size == 0) {
+            return false;
+        }
+        reply_size += data_size;
+    }
+    return reply_size <= MAX_READ_SIZE;
+}
+
+/// Whether the records of a WriteMemoryBatch request all fit in the packet
+static bool ValidateWriteMemoryBatch(Packet& packet) {
+    const u32 size = packet.GetPacketDataSize();
+    for (u64 offset = 0; offset < size;) {
+        if (size - offset < sizeof(u32) * 2) {
+            return false;
+        }
+        u32 data_size;
+        std::memcpy(&data_size, packet.GetPacketData().data() + offset + sizeof(u32),
+                    sizeof(data_size));
+        offset += sizeof(u32) * 2 + static_cast<u64>(data_size);
+        if (data_size == 0 || offset > size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RPCServer::HandleReadFrameCounters(Packet& packet, u32 first_index, u32 data_size) {
+    const auto counters = Common::GetLastFrameCounters();
+    u32 reply_size = 0;
+    for (std::size_t i = first_index; i < counters.size() && reply_size + sizeof(u64) <= data_size;
+         ++i) {
+        std::memcpy(packet.GetPacketData().data() + reply_size, &counters[i].value, sizeof(u64));
+        reply_size += sizeof(u64);
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadFrameCounterName(Packet& packet, u32 index, u32 data_size) {
+    const auto counters = Common::GetLastFrameCounters();
+    u32 reply_size = 0;
+    if (index < counters.size()) {
+        const std::string& name = counters[index].name;
+        reply_size = std::min(static_cast<u32>(name.size()), data_size);
+        std::memcpy(packet.GetPacketData().data(), name.data(), reply_size);
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadMemoryUsage(Packet& packet, u32 first_index, u32 data_size) {
+    const Common::MemoryUsage usage = Common::GetMemoryUsage();
+    u32 reply_size = 0;
+    for (std::size_t i = first_index; i < usage.size() && reply_size + sizeof(u64) <= data_size;
+         ++i) {
+        std::memcpy(packet.GetPacketData().data() + reply_size, &usage[i], sizeof(u64));
+        reply_size += sizeof(u64);
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadMemoryCategoryName(Packet& packet, u32 index, u32 data_size) {
+    u32 reply_size = 0;
+    if (index < Common::NumMemoryCategories) {
+        const std::string name =
+            Common::GetMemoryCategoryName(static_cast<Common::MemoryCategory>(index));
+        reply_size = std::min(static_cast<u32>(name.size()), data_size);
+        std::memcpy(packet.GetPacketData().data(), name.data(), reply_size);
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
+void RPCServer::HandleAdvanceFrames(Packet& packet, u32 frame_count) {
+    // Long enough for the slowest frames, such as while a title boots
+    constexpr std::chrono::seconds FRAME_TIMEOUT{10};
+
+    auto& frame_limiter = Core::System::GetInstance().frame_limiter;
+    u32 frames_done = 0;
+    if (frame_count == 0) {
+        frame_limiter.SetFrameAdvancing(false);
+    }
+    while (frames_done < frame_count && frame_limiter.AdvanceFrameAndWait(FRAME_TIMEOUT)) {
+        ++frames_done;
+    }
+
+    std::memcpy(packet.GetPacketData().data(), &frames_done, sizeof(frames_done));
+    packet.SetPacketDataSize(sizeof(frames_done));
+    packet.SendReply();
+}
+
+void RPCServer::HandleSetInput(Packet& packet) {
+    InputState input_state;
+    std::memcpy(&input_state, packet.GetPacketData().data(), sizeof(input_state));
+
+    const auto hid = Service::HID::GetModule(Core::System::GetInstance());
+    if (hid) {
+        if (input_state.flags & 1) {
+            Service::HID::Module::InputOverride input;
+            input.pad.hex = input_state.pad;
+            input.circle_pad_x = input_state.circle_pad_x;
+            input.circle_pad_y = input_state.circle_pad_y;
+            input.touch_pressed = (input_state.flags & 2) != 0;
+            input.touch_x = input_state.touch_x;
+            input.touch_y = input_state.touch_y;
+            hid->SetInputOverride(input);
+        } else {
+            hid->SetInputOverride(std::nullopt);
+        }
+    }
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleSetFastForward(Packet& packet, bool enable) {
+    Core::System::GetInstance().SetFastForward(enable);
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadFramebufferInfo(Packet& packet, u32 screen) {
+    const auto& config = GPU::g_regs.framebuffer_config[screen];
+    const std::array<u32, 5> info{
+        GPU::GetDisplayedFramebuffer(screen).address, static_cast<u32>(config.color_format.Value()),
+        config.width, config.height, config.stride};
+    std::memcpy(packet.GetPacketData().data(), info.data(), sizeof(info));
+    packet.SetPacketDataSize(sizeof(info));
+    packet.SendReply();
+}
+
+void RPCServer::HandleReadFramebuffer(Packet& packet, u32 screen, u32 offset, u32 data_size) {
+    const GPU::DisplayedFramebuffer framebuffer = GPU::GetDisplayedFramebuffer(screen);
+    u32 reply_size = 0;
+    if (offset < framebuffer.size) {
+        // Note: Like memory reads, this occurs asynchronously from the state of the emulator
+        reply_size = std::min(data_size, framebuffer.size - offset);
+        std::memcpy(packet.GetPacketData().data(),
+                    Core::System::GetInstance().Memory().GetPhysicalPointer(framebuffer.address) +
+                        offset,
+                    reply_size);
+    }
+    packet.SetPacketDataSize(reply_size);
+    packet.SendReply();
+}
+
 bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     if (packet_header.version <= CURRENT_VERSION) {
         switch (packet_header.packet_type) {
         case PacketType::ReadMemory:
         case PacketType::WriteMemory:
+        case PacketType::ReadFrameCounters:
+        case PacketType::ReadFrameCounterName:
+        case PacketType::ReadMemoryBatch:
+        case PacketType::WriteMemoryBatch:
+        case PacketType::AdvanceFrames:
+        case PacketType::ReadFramebufferInfo:
+        case PacketType::ReadMemoryUsage:
+        case PacketType::ReadMemoryCategoryName:
+        case PacketType::SetFastForward:
             if (packet_header.packet_size >= (sizeof(u32) * 2)) {
                 return true;
             }
             break;
+        case PacketType::SetInput:
+            if (packet_header.packet_size == sizeof(InputState)) {
+                return true;
+            }
+            break;
+        case PacketType::ReadFramebuffer:
+            if (packet_header.packet_size == (sizeof(u32) * 3)) {
+                return true;
+            }
+            break;
         default:
             break;
         }
@@ -72,7 +294,7 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
     bool success = false;
 
     if (ValidatePacket(request_packet->GetHeader())) {
-        // Currently, all request types use the address/data_size wire format
+        // All request types start with the address/data_size wire format
         u32 address = 0;
         u32 data_size = 0;
         std::memcpy(&address, request_packet->GetPacketData().data(), sizeof(address));
@@ -93,6 +315,71 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
                 success = true;
             }
             break;
+        case PacketType::ReadFrameCounters:
+            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
+                HandleReadFrameCounters(*request_packet, address, data_size);
+                success = true;
+            }
+            break;
+        case PacketType::ReadFrameCounterName:
+            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
+                HandleReadFrameCounterName(*request_packet, address, data_size);
+                success = true;
+            }
+            break;
+        case PacketType::ReadMemoryBatch:
+            if (ValidateReadMemoryBatch(*request_packet)) {
+                HandleReadMemoryBatch(*request_packet);
+                success = true;
+            }
+            break;
+        case PacketType::WriteMemoryBatch:
+            if (ValidateWriteMemoryBatch(*request_packet)) {
+                HandleWriteMemoryBatch(*request_packet);
+                success = true;
+            }
+            break;
+        case PacketType::AdvanceFrames:
+            HandleAdvanceFrames(*request_packet, address);
+            success = true;
+            break;
+        case PacketType::SetInput:
+            HandleSetInput(*request_packet);
+            success = true;
+            break;
+        case PacketType::SetFastForward:
+            if (address <= 1) {
+                HandleSetFastForward(*request_packet, address != 0);
+                success = true;
+            }
+            break;
+        case PacketType::ReadFramebufferInfo:
+            if (address < 2) {
+                HandleReadFramebufferInfo(*request_packet, address);
+                success = true;
+            }
+            break;
+        case PacketType::ReadFramebuffer:
+            if (address < 2 && data_size > 0 && data_size <= MAX_READ_SIZE) {
+                u32 offset;
+                std::memcpy(&offset, request_packet->GetPacketData().data() + sizeof(u32) * 2,
+                            sizeof(offset));
+                HandleReadFramebuffer(*request_packet, address, offset, data_size);
+                success = true;
+            }
+            break;
+        case PacketType::ReadMemoryUsage:
+            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
+                HandleReadMemoryUsage(*request_packet, address, data_size);
+                success = true;
+            }
+            break;
+        case PacketType::ReadMemoryCategoryName:
+            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
+                HandleReadMemoryCategoryName(*request_packet, address, data_size);
+                success = true;
+            }
+            break;
         default:
             break;
         }
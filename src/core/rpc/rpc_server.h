@@ -25,12 +25,26 @@ private:
     void Stop();
     void HandleReadMemory(Packet& packet, u32 address, u32 data_size);
     void HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size);
+    void HandleReadMemoryBatch(Packet& packet);
+    void HandleWriteMemoryBatch(Packet& packet);
+    void HandleReadFrameCounters(Packet& packet, u32 first_index, u32 data_size);
+    void HandleReadFrameCounterName(Packet& packet, u32 index, u32 data_size);
+    void HandleReadMemoryUsage(Packet& packet, u32 first_index, u32 data_size);
+    void HandleReadMemoryCategoryName(Packet& packet, u32 index, u32 data_size);
+    void HandleAdvanceFrames(Packet& packet, u32 frame_count);
+    void HandleSetInput(Packet& packet);
+    void HandleSetFastForward(Packet& packet, bool enable);
+    void HandleReadFramebufferInfo(Packet& packet, u32 screen);
+    void HandleReadFramebuffer(Packet& packet, u32 screen, u32 offset, u32 data_size);
     bool ValidatePacket(const PacketHeader& packet_header);
     void HandleSingleRequest(std::unique_ptr<Packet> request);
     void HandleRequestsLoop();
 
+    /// Requests are pushed by the server thread, which waits if the handler is this far behind
+    static constexpr std::size_t MAX_QUEUED_REQUESTS = 64;
+
     Server server;
-    Common::SPSCQueue<std::unique_ptr<Packet>> request_queue;
+    Common::BoundedSPSCQueue<std::unique_ptr<Packet>, MAX_QUEUED_REQUESTS> request_queue;
     std::thread request_handler_thread;
 };
 
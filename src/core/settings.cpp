@@ -2,7 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
 #include <utility>
+#include <fmt/format.h>
 #include "audio_core/dsp_interface.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
@@ -17,27 +24,141 @@ namespace Settings {
 
 Values values = {};
 
+namespace {
+
+const Snapshot initial_snapshot{};
+std::atomic<const Snapshot*> current_snapshot{&initial_snapshot};
+
+/// Guards the members below, which only Apply and the callback registration use
+std::mutex snapshot_mutex;
+/// Every published snapshot, as readers may still hold any of them. Apply only runs when the
+/// user changes settings, so these stay small.
+std::vector<std::unique_ptr<const Snapshot>> published_snapshots;
+struct SnapshotListener {
+    std::size_t id;
+    u32 changes;
+    SnapshotCallback callback;
+};
+std::vector<SnapshotListener> snapshot_listeners;
+std::size_t next_listener_id = 0;
+
+std::unique_ptr<const Snapshot> TakeSnapshot() {
+    auto snapshot = std::make_unique<Snapshot>();
+    snapshot->use_hw_renderer = values.use_hw_renderer;
+    snapshot->use_hw_shader = values.use_hw_shader;
+    snapshot->shaders_accurate_gs = values.shaders_accurate_gs;
+    snapshot->shaders_accurate_mul = values.shaders_accurate_mul;
+    snapshot->use_shader_jit = values.use_shader_jit;
+    snapshot->use_async_shader_compilation = values.use_async_shader_compilation;
+    snapshot->use_fragment_ubershader = values.use_fragment_ubershader;
+    snapshot->use_shadow_depth_buffer = values.use_shadow_depth_buffer;
+    snapshot->use_disk_shader_cache = values.use_disk_shader_cache;
+    snapshot->vertex_shader_threads = values.vertex_shader_threads;
+    snapshot->use_compute_texture_decoding = values.use_compute_texture_decoding;
+    snapshot->texture_cache_budget = values.texture_cache_budget;
+    snapshot->custom_textures = values.custom_textures;
+    snapshot->dump_textures = values.dump_textures;
+    snapshot->texture_filter = values.texture_filter;
+    snapshot->resolution_factor = values.resolution_factor;
+    snapshot->resolution_fill_budget = values.resolution_fill_budget;
+    snapshot->bg_red = values.bg_red;
+    snapshot->bg_green = values.bg_green;
+    snapshot->bg_blue = values.bg_blue;
+    snapshot->toggle_3d = values.toggle_3d;
+    snapshot->show_perf_overlay = values.show_perf_overlay;
+    snapshot->deterministic = values.deterministic;
+    return snapshot;
+}
+
+u32 GetSnapshotChanges(const Snapshot& old, const Snapshot& new_) {
+    u32 changes = 0;
+    if (old.use_hw_renderer != new_.use_hw_renderer)
+        changes |= SnapshotChange::Renderer;
+    if (std::tie(old.use_hw_shader, old.shaders_accurate_gs, old.shaders_accurate_mul,
+                 old.use_shader_jit, old.use_async_shader_compilation,
+                 old.use_fragment_ubershader, old.use_shadow_depth_buffer,
+                 old.use_disk_shader_cache, old.vertex_shader_threads) !=
+        std::tie(new_.use_hw_shader, new_.shaders_accurate_gs, new_.shaders_accurate_mul,
+                 new_.use_shader_jit, new_.use_async_shader_compilation,
+                 new_.use_fragment_ubershader, new_.use_shadow_depth_buffer,
+                 new_.use_disk_shader_cache, new_.vertex_shader_threads))
+        changes |= SnapshotChange::Shaders;
+    if (std::tie(old.use_compute_texture_decoding, old.texture_cache_budget, old.custom_textures,
+                 old.dump_textures, old.texture_filter) !=
+        std::tie(new_.use_compute_texture_decoding, new_.texture_cache_budget,
+                 new_.custom_textures, new_.dump_textures, new_.texture_filter))
+        changes |= SnapshotChange::Textures;
+    if (std::tie(old.resolution_factor, old.resolution_fill_budget) !=
+        std::tie(new_.resolution_factor, new_.resolution_fill_budget))
+        changes |= SnapshotChange::Resolution;
+    if (std::tie(old.bg_red, old.bg_green, old.bg_blue, old.toggle_3d, old.show_perf_overlay) !=
+        std::tie(new_.bg_red, new_.bg_green, new_.bg_blue, new_.toggle_3d, new_.show_perf_overlay))
+        changes |= SnapshotChange::Display;
+    if (old.deterministic != new_.deterministic)
+        changes |= SnapshotChange::Deterministic;
+    return changes;
+}
+
+void PublishSnapshot() {
+    std::lock_guard lock{snapshot_mutex};
+    auto snapshot = TakeSnapshot();
+    const u32 changes = GetSnapshotChanges(GetSnapshot(), *snapshot);
+    if (changes == 0)
+        return;
+
+    current_snapshot.store(snapshot.get(), std::memory_order_release);
+    published_snapshots.push_back(std::move(snapshot));
+    for (const auto& listener : snapshot_listeners) {
+        if (listener.changes & changes) {
+            listener.callback(changes, GetSnapshot());
+        }
+    }
+}
+
+} // Anonymous namespace
+
+const Snapshot& GetSnapshot() {
+    return *current_snapshot.load(std::memory_order_acquire);
+}
+
+std::size_t AddSnapshotCallback(u32 changes, SnapshotCallback callback) {
+    std::lock_guard lock{snapshot_mutex};
+    const std::size_t id = next_listener_id++;
+    snapshot_listeners.push_back({id, changes, std::move(callback)});
+    return id;
+}
+
+void RemoveSnapshotCallback(std::size_t id) {
+    std::lock_guard lock{snapshot_mutex};
+    const auto is_removed = [id](const SnapshotListener& listener) { return listener.id == id; };
+    snapshot_listeners.erase(
+        std::remove_if(snapshot_listeners.begin(), snapshot_listeners.end(), is_removed),
+        snapshot_listeners.end());
+}
+
 void Apply() {
+    PublishSnapshot();
 
     GDBStub::SetServerPort(values.gdbstub_port);
     GDBStub::ToggleServer(values.use_gdbstub);
 
-    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
-    VideoCore::g_shader_jit_enabled = values.use_shader_jit;
-    VideoCore::g_hw_shader_enabled = values.use_hw_shader;
-    VideoCore::g_hw_shader_accurate_gs = values.shaders_accurate_gs;
-    VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
+    for (std::size_t i = 0; i < Common::NUM_THREAD_ROLES; ++i) {
+        Common::SetThreadRoleConfig(static_cast<Common::ThreadRole>(i), values.thread_roles[i]);
+    }
+    if (Core::System::GetInstance().IsFastForwarding()) {
+        // Raises the priorities configured above again
+        Core::System::GetInstance().SetFastForward(true);
+    }
 
     if (VideoCore::g_renderer) {
         VideoCore::g_renderer->UpdateCurrentFramebufferLayout();
     }
 
-    VideoCore::g_renderer_bg_color_update_requested = true;
-
     auto& system = Core::System::GetInstance();
     if (system.IsPoweredOn()) {
         Core::DSP().SetSink(values.sink_id, values.audio_device_id);
         Core::DSP().EnableStretching(values.enable_audio_stretching);
+        Core::DSP().EnableLowLatency(values.enable_low_latency_audio);
 
         auto hid = Service::HID::GetModule(system);
         if (hid) {
@@ -67,23 +188,50 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_CPUClockPercentage", Settings::values.cpu_clock_percentage);
+    LogSetting("Core_SkipIdleLoops", Settings::values.skip_idle_loops);
+    LogSetting("Core_SkipIdleLoopsExclusions", Settings::values.skip_idle_loops_exclusions);
+    LogSetting("Core_Deterministic", Settings::values.deterministic);
+    LogSetting("Core_UseLargePages", Settings::values.use_large_pages);
+    LogSetting("Core_UseTitleSettings", Settings::values.use_title_settings);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
     LogSetting("Renderer_ShadersAccurateGs", Settings::values.shaders_accurate_gs);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
+    LogSetting("Renderer_UseDiskShaderCache", Settings::values.use_disk_shader_cache);
+    LogSetting("Renderer_UseAsyncShaderCompilation",
+               Settings::values.use_async_shader_compilation);
+    LogSetting("Renderer_UseFragmentUbershader", Settings::values.use_fragment_ubershader);
+    LogSetting("Renderer_UseShadowDepthBuffer", Settings::values.use_shadow_depth_buffer);
+    LogSetting("Renderer_SwRasterizerThreads", Settings::values.sw_rasterizer_threads);
+    LogSetting("Renderer_VertexShaderThreads", Settings::values.vertex_shader_threads);
+    LogSetting("Renderer_UseGpuThread", Settings::values.use_gpu_thread);
+    LogSetting("Renderer_UseAsyncPresent", Settings::values.use_async_present);
+    LogSetting("Renderer_UseComputeTextureDecoding",
+               Settings::values.use_compute_texture_decoding);
+    LogSetting("Renderer_TextureCacheBudget", Settings::values.texture_cache_budget);
+    LogSetting("Renderer_CustomTextures", Settings::values.custom_textures);
+    LogSetting("Renderer_DumpTextures", Settings::values.dump_textures);
+    LogSetting("Renderer_TextureFilter", static_cast<int>(Settings::values.texture_filter));
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
+    LogSetting("Renderer_ResolutionFillBudget", Settings::values.resolution_fill_budget);
     LogSetting("Renderer_VsyncEnabled", Settings::values.vsync_enabled);
     LogSetting("Renderer_UseFrameLimit", Settings::values.use_frame_limit);
     LogSetting("Renderer_FrameLimit", Settings::values.frame_limit);
+    LogSetting("Renderer_LowPowerMode", Settings::values.low_power_mode);
+    LogSetting("Renderer_MaxFrameSkip", Settings::values.max_frame_skip);
+    LogSetting("Renderer_ShowPerfOverlay", Settings::values.show_perf_overlay);
     LogSetting("Layout_Toggle3d", Settings::values.toggle_3d);
     LogSetting("Layout_Factor3d", Settings::values.factor_3d);
     LogSetting("Layout_LayoutOption", static_cast<int>(Settings::values.layout_option));
     LogSetting("Layout_SwapScreen", Settings::values.swap_screen);
     LogSetting("Audio_EnableDspLle", Settings::values.enable_dsp_lle);
     LogSetting("Audio_EnableDspLleMultithread", Settings::values.enable_dsp_lle_multithread);
+    LogSetting("Audio_EnableDspHleMultithread", Settings::values.enable_dsp_hle_multithread);
     LogSetting("Audio_OutputEngine", Settings::values.sink_id);
     LogSetting("Audio_EnableAudioStretching", Settings::values.enable_audio_stretching);
+    LogSetting("Audio_EnableLowLatencyAudio", Settings::values.enable_low_latency_audio);
     LogSetting("Audio_OutputDevice", Settings::values.audio_device_id);
     using namespace Service::CAM;
     LogSetting("Camera_OuterRightName", Settings::values.camera_name[OuterRightCamera]);
@@ -96,10 +244,33 @@ void LogSettings() {
     LogSetting("Camera_OuterLeftConfig", Settings::values.camera_config[OuterLeftCamera]);
     LogSetting("Camera_OuterLeftFlip", Settings::values.camera_flip[OuterLeftCamera]);
     LogSetting("DataStorage_UseVirtualSd", Settings::values.use_virtual_sd);
+    LogSetting("DataStorage_RomFSAccessTrace", Settings::values.romfs_access_trace);
     LogSetting("System_IsNew3ds", Settings::values.is_new_3ds);
     LogSetting("System_RegionValue", Settings::values.region_value);
     LogSetting("Debugging_UseGdbstub", Settings::values.use_gdbstub);
     LogSetting("Debugging_GdbstubPort", Settings::values.gdbstub_port);
+    for (std::size_t i = 0; i < Common::NUM_THREAD_ROLES; ++i) {
+        const auto& role = Settings::values.thread_roles[i];
+        LogSetting(fmt::format("Threads_{}_thread_affinity", thread_role_names[i]),
+                   fmt::format("{:#x}", role.affinity_mask));
+        LogSetting(fmt::format("Threads_{}_thread_priority", thread_role_names[i]),
+                   static_cast<u32>(role.priority));
+    }
+}
+
+bool ShouldSkipIdleLoops(u64 title_id) {
+    if (!values.skip_idle_loops) {
+        return false;
+    }
+
+    // Some titles measure how long their busy-waits take, let them opt out
+    std::stringstream exclusions(values.skip_idle_loops_exclusions);
+    for (std::string entry; std::getline(exclusions, entry, ',');) {
+        if (!entry.empty() && std::strtoull(entry.c_str(), nullptr, 16) == title_id) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void LoadProfile(int index) {
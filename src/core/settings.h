@@ -6,10 +6,13 @@
 
 #include <array>
 #include <atomic>
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
+#include "common/thread.h"
 #include "core/hle/service/cam/cam.h"
 
 namespace Settings {
@@ -19,6 +22,12 @@ enum class InitClock {
     FixedTime = 1,
 };
 
+enum class TextureFilter {
+    None,
+    /// Edge preserving Scale2x (EPX) rules, applied at any resolution scale
+    Scale2x,
+};
+
 enum class LayoutOption {
     Default,
     SingleScreen,
@@ -109,6 +118,15 @@ struct InputProfile {
     u8 udp_pad_index;
 };
 
+/// Names of the thread roles in the configuration files, in the order of Common::ThreadRole
+static const std::array<const char*, Common::NUM_THREAD_ROLES> thread_role_names = {{
+    "cpu",
+    "gpu",
+    "audio",
+    "io",
+    "ui",
+}};
+
 struct Values {
     // CheckNew3DS
     bool is_new_3ds;
@@ -120,9 +138,16 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    int cpu_clock_percentage;
+    bool skip_idle_loops;
+    std::string skip_idle_loops_exclusions; ///< Comma separated title IDs to not skip idle loops in
+    bool deterministic;                     ///< Overrides settings breaking reproducibility
+    bool use_large_pages;                   ///< Backs the emulated RAM with 2 MiB pages
+    bool use_title_settings;                ///< Applies the settings stored for each title
 
     // Data Storage
     bool use_virtual_sd;
+    bool romfs_access_trace;
 
     // System
     int region_value;
@@ -135,10 +160,26 @@ struct Values {
     bool shaders_accurate_gs;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_disk_shader_cache;
+    bool use_async_shader_compilation;
+    bool use_fragment_ubershader;
+    bool use_shadow_depth_buffer;
+    u16 sw_rasterizer_threads;
+    u16 vertex_shader_threads;
+    bool use_gpu_thread;
+    bool use_async_present;
+    bool use_compute_texture_decoding;
+    u16 texture_cache_budget;
+    bool custom_textures;
+    bool dump_textures;
+    TextureFilter texture_filter;
     u16 resolution_factor;
+    u16 resolution_fill_budget;
     bool vsync_enabled;
     bool use_frame_limit;
     u16 frame_limit;
+    u16 max_frame_skip;
+    bool low_power_mode;
 
     LayoutOption layout_option;
     bool swap_screen;
@@ -159,11 +200,15 @@ struct Values {
     bool toggle_3d;
     std::atomic<u8> factor_3d;
 
+    bool show_perf_overlay;
+
     // Audio
     bool enable_dsp_lle;
     bool enable_dsp_lle_multithread;
+    bool enable_dsp_hle_multithread;
     std::string sink_id;
     bool enable_audio_stretching;
+    bool enable_low_latency_audio;
     std::string audio_device_id;
     float volume;
 
@@ -176,8 +221,12 @@ struct Values {
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string log_filter;
+    bool log_binary;
     std::unordered_map<std::string, bool> lle_modules;
 
+    // Threads
+    std::array<Common::ThreadRoleConfig, Common::NUM_THREAD_ROLES> thread_roles;
+
     // WebService
     bool enable_telemetry;
     std::string web_api_url;
@@ -189,9 +238,78 @@ struct Values {
 // value to fit the region lockout info of the game
 static constexpr int REGION_VALUE_AUTO_SELECT = -1;
 
+/**
+ * The settings read by hot paths, as of the last Apply. Apply publishes a new snapshot as a whole
+ * instead of changing it, so a reader on another thread sees either the old or the new settings
+ * and never a mix of them.
+ */
+struct Snapshot {
+    bool use_hw_renderer = false;
+    bool use_hw_shader = false;
+    bool shaders_accurate_gs = false;
+    bool shaders_accurate_mul = false;
+    bool use_shader_jit = false;
+    bool use_async_shader_compilation = false;
+    bool use_fragment_ubershader = false;
+    bool use_shadow_depth_buffer = false;
+    bool use_disk_shader_cache = false;
+    u16 vertex_shader_threads = 0;
+    bool use_compute_texture_decoding = false;
+    u16 texture_cache_budget = 0;
+    bool custom_textures = false;
+    bool dump_textures = false;
+    TextureFilter texture_filter = TextureFilter::None;
+    u16 resolution_factor = 0;
+    u16 resolution_fill_budget = 0;
+    float bg_red = 0.0f;
+    float bg_green = 0.0f;
+    float bg_blue = 0.0f;
+    bool toggle_3d = false;
+    bool show_perf_overlay = false;
+    bool deterministic = false;
+};
+
+/// Groups of settings of the snapshot, so that consumers only react to the changes affecting them
+namespace SnapshotChange {
+enum : u32 {
+    /// use_hw_renderer
+    Renderer = 1 << 0,
+    /// The shader settings and vertex_shader_threads
+    Shaders = 1 << 1,
+    /// The texture settings
+    Textures = 1 << 2,
+    /// resolution_factor and resolution_fill_budget
+    Resolution = 1 << 3,
+    /// The background color, toggle_3d and show_perf_overlay
+    Display = 1 << 4,
+    /// deterministic
+    Deterministic = 1 << 5,
+};
+} // namespace SnapshotChange
+
+/**
+ * The current snapshot. This is a single atomic load, fit for hot paths. Snapshots stay valid
+ * until exit, but a reader should only hold one for the duration of an operation to see changes.
+ */
+const Snapshot& GetSnapshot();
+
+/// Called with the groups of settings that changed and the new snapshot
+using SnapshotCallback = std::function<void(u32 changes, const Snapshot& snapshot)>;
+
+/**
+ * Registers a callback the thread calling Apply runs, after publishing a snapshot in which one of
+ * the given groups of settings changed. Callbacks must not add or remove callbacks.
+ * @returns an identifier for RemoveSnapshotCallback
+ */
+std::size_t AddSnapshotCallback(u32 changes, SnapshotCallback callback);
+void RemoveSnapshotCallback(std::size_t id);
+
 void Apply();
 void LogSettings();
 
+/// Whether the CPU should skip idle loops for the given title
+bool ShouldSkipIdleLoops(u64 title_id);
+
 // Input profiles
 void LoadProfile(int index);
 void SaveProfile(int index);
@@ -0,0 +1,219 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/settings.h"
+#include "core/title_settings.h"
+
+namespace Settings {
+
+namespace {
+
+/// Title whose settings are applied, the settings and the values they replaced
+std::optional<u64> applied_title;
+TitleSettings applied_settings;
+TitleSettings replaced_settings;
+
+std::string GetTitleSettingsPath(u64 title_id) {
+    return fmt::format("{}title_settings" DIR_SEP "{:016X}.ini",
+                       FileUtil::GetUserPath(FileUtil::UserPath::ConfigDir), title_id);
+}
+
+/// Calls func with the name of each overridable setting, its field in each of the given
+/// TitleSettings and its field in Settings::values
+template <typename Func>
+void ForEachSetting(TitleSettings& a, TitleSettings& b, Func&& func) {
+    func("use_hw_shader", a.use_hw_shader, b.use_hw_shader, values.use_hw_shader);
+    func("shaders_accurate_mul", a.shaders_accurate_mul, b.shaders_accurate_mul,
+         values.shaders_accurate_mul);
+    func("resolution_factor", a.resolution_factor, b.resolution_factor, values.resolution_factor);
+    func("cpu_clock_percentage", a.cpu_clock_percentage, b.cpu_clock_percentage,
+         values.cpu_clock_percentage);
+    func("use_gpu_thread", a.use_gpu_thread, b.use_gpu_thread, values.use_gpu_thread);
+    func("max_frame_skip", a.max_frame_skip, b.max_frame_skip, values.max_frame_skip);
+}
+
+template <typename T>
+bool ParseValue(const std::string& text, std::optional<T>& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        if (text == "true" || text == "1") {
+            value = true;
+        } else if (text == "false" || text == "0") {
+            value = false;
+        } else {
+            return false;
+        }
+        return true;
+    } else {
+        std::istringstream stream(text);
+        T parsed;
+        if (!(stream >> parsed) || !stream.eof()) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+}
+
+template <typename T>
+std::string FormatValue(const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return value ? "true" : "false";
+    } else {
+        return fmt::format("{}", value);
+    }
+}
+
+} // Anonymous namespace
+
+std::optional<TitleSettings> LoadTitleSettings(u64 title_id) {
+    std::string text;
+    if (FileUtil::ReadFileToString(true, GetTitleSettingsPath(title_id).c_str(), text) == 0) {
+        return std::nullopt;
+    }
+
+    TitleSettings settings;
+    TitleSettings unused;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        line = Common::StripSpaces(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        const std::size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            LOG_WARNING(Config, "Ignoring invalid line in the settings of {:016X}: {}", title_id,
+                        line);
+            continue;
+        }
+        const std::string name = Common::StripSpaces(line.substr(0, equals));
+        const std::string value = Common::StripSpaces(line.substr(equals + 1));
+
+        bool known = false;
+        bool valid = true;
+        if (name == "benchmark_speed") {
+            known = true;
+            valid = ParseValue(value, settings.benchmark_speed);
+        }
+        ForEachSetting(settings, unused, [&](const char* setting_name, auto& field, auto&, auto&) {
+            if (name == setting_name) {
+                known = true;
+                valid = ParseValue(value, field);
+            }
+        });
+        if (!known || !valid) {
+            LOG_WARNING(Config, "Ignoring invalid setting for {:016X}: {} = {}", title_id, name,
+                        value);
+        }
+    }
+    return settings;
+}
+
+bool SaveTitleSettings(u64 title_id, const TitleSettings& settings) {
+    TitleSettings copy = settings;
+    TitleSettings unused;
+    std::string text = fmt::format("# Settings overriding the configuration for {:016X}\n",
+                                   title_id);
+    ForEachSetting(copy, unused, [&text](const char* name, auto& field, auto&, auto&) {
+        if (field) {
+            text += fmt::format("{} = {}\n", name, FormatValue(*field));
+        }
+    });
+    if (settings.benchmark_speed) {
+        text += fmt::format("benchmark_speed = {}\n", *settings.benchmark_speed);
+    }
+
+    const std::string path = GetTitleSettingsPath(title_id);
+    if (!FileUtil::CreateFullPath(path) ||
+        FileUtil::WriteStringToFile(true, text, path.c_str()) != text.size()) {
+        LOG_ERROR(Config, "Failed to write the settings of {:016X} to {}", title_id, path);
+        return false;
+    }
+    return true;
+}
+
+TitleSettings GetCurrentTitleSettings() {
+    TitleSettings settings;
+    TitleSettings unused;
+    ForEachSetting(settings, unused,
+                   [](const char*, auto& field, auto&, auto& value) { field = value; });
+    return settings;
+}
+
+void ApplyTitleSettings(u64 title_id) {
+    RestoreTitleSettings();
+    if (!values.use_title_settings)
+        return;
+
+    std::optional<TitleSettings> settings = LoadTitleSettings(title_id);
+    if (!settings)
+        return;
+
+    applied_title = title_id;
+    applied_settings = *settings;
+    replaced_settings = {};
+    ForEachSetting(applied_settings, replaced_settings,
+                   [title_id](const char* name, auto& field, auto& replaced, auto& value) {
+                       if (!field)
+                           return;
+                       LOG_INFO(Config, "Title {:016X} sets {} to {}", title_id, name,
+                                FormatValue(*field));
+                       replaced = value;
+                       value = *field;
+                   });
+}
+
+std::optional<u64> RestoreTitleSettings() {
+    const std::optional<u64> title_id = std::exchange(applied_title, std::nullopt);
+    if (!title_id)
+        return std::nullopt;
+
+    ForEachSetting(applied_settings, replaced_settings,
+                   [](const char*, auto& field, auto& replaced, auto& value) {
+                       // A setting changed while the title ran keeps its new value
+                       if (field && value == *field) {
+                           value = *replaced;
+                       }
+                   });
+    return title_id;
+}
+
+void WithoutTitleSettings(const std::function<void()>& func) {
+    if (!applied_title) {
+        func();
+        return;
+    }
+
+    // Swaps the overrides still in effect with the values they replaced, and back afterwards
+    u32 swapped = 0;
+    u32 bit = 1;
+    ForEachSetting(applied_settings, replaced_settings,
+                   [&](const char*, auto& field, auto& replaced, auto& value) {
+                       if (field && value == *field) {
+                           value = *replaced;
+                           swapped |= bit;
+                       }
+                       bit <<= 1;
+                   });
+    func();
+    bit = 1;
+    ForEachSetting(applied_settings, replaced_settings,
+                   [&](const char*, auto& field, auto& replaced, auto& value) {
+                       if (swapped & bit) {
+                           value = *field;
+                       }
+                       bit <<= 1;
+                   });
+}
+
+} // namespace Settings
@@ -0,0 +1,54 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include "common/common_types.h"
+
+namespace Settings {
+
+/**
+ * Settings overriding the configuration for a single title, for the trade-offs between speed and
+ * accuracy that depend on the title. They are stored as `name = value` lines in the
+ * title_settings directory of the configuration, the unset ones follow the configuration.
+ */
+struct TitleSettings {
+    std::optional<bool> use_hw_shader;
+    std::optional<bool> shaders_accurate_mul;
+    std::optional<u16> resolution_factor;
+    std::optional<int> cpu_clock_percentage;
+    std::optional<bool> use_gpu_thread;
+    std::optional<u16> max_frame_skip;
+
+    /// Mean emulation speed of the benchmark run that stored the settings
+    std::optional<double> benchmark_speed;
+};
+
+/// Reads the settings stored for a title, nullopt if there are none
+std::optional<TitleSettings> LoadTitleSettings(u64 title_id);
+
+bool SaveTitleSettings(u64 title_id, const TitleSettings& settings);
+
+/// Returns the values of the settings a title can override
+TitleSettings GetCurrentTitleSettings();
+
+/**
+ * Applies the settings stored for a title on top of Settings::values, when use_title_settings is
+ * enabled. Settings::Apply has to be called afterwards.
+ */
+void ApplyTitleSettings(u64 title_id);
+
+/**
+ * Puts back the values replaced by ApplyTitleSettings, except for the settings that were changed
+ * since. Settings::Apply has to be called afterwards.
+ * @returns the title whose settings were applied, if any
+ */
+std::optional<u64> RestoreTitleSettings();
+
+/// Runs func with the values replaced by ApplyTitleSettings put back, for saving the configuration
+void WithoutTitleSettings(const std::function<void()>& func);
+
+} // namespace Settings
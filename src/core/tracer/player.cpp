@@ -0,0 +1,215 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace CiTrace {
+
+Player::Player(Memory::MemorySystem& memory) : memory(memory) {}
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile trace(filename, "rb");
+    file.resize(trace.GetSize());
+    if (!trace.IsOpen() || trace.ReadBytes(file.data(), file.size()) != file.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read the CiTrace {}", filename);
+        return false;
+    }
+
+    if (file.size() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "{} is too small to be a CiTrace", filename);
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), sizeof(header.magic)) != 0 ||
+        header.version != CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "{} is not a CiTrace of version {}", filename,
+                  CTHeader::ExpectedVersion());
+        return false;
+    }
+
+    const auto in_file = [this](u64 offset, u64 size) { return offset + size <= file.size(); };
+    const auto& initial = header.initial_state_offsets;
+    const std::pair<u32, u32> initial_state[] = {
+        {initial.gpu_registers, initial.gpu_registers_size},
+        {initial.lcd_registers, initial.lcd_registers_size},
+        {initial.pica_registers, initial.pica_registers_size},
+        {initial.default_attributes, initial.default_attributes_size},
+        {initial.vs_program_binary, initial.vs_program_binary_size},
+        {initial.vs_swizzle_data, initial.vs_swizzle_data_size},
+        {initial.vs_float_uniforms, initial.vs_float_uniforms_size},
+        {initial.gs_program_binary, initial.gs_program_binary_size},
+        {initial.gs_swizzle_data, initial.gs_swizzle_data_size},
+        {initial.gs_float_uniforms, initial.gs_float_uniforms_size},
+    };
+    for (const auto& [offset, size] : initial_state) {
+        if (!in_file(offset, static_cast<u64>(size) * sizeof(u32))) {
+            LOG_ERROR(HW_GPU, "The initial state of {} is truncated", filename);
+            return false;
+        }
+    }
+    if (!in_file(header.stream_offset,
+                 static_cast<u64>(header.stream_size) * sizeof(CTStreamElement))) {
+        LOG_ERROR(HW_GPU, "The stream of {} is truncated", filename);
+        return false;
+    }
+
+    num_frames = 0;
+    for (u32 i = 0; i < header.stream_size; ++i) {
+        CTStreamElementType type;
+        std::memcpy(&type, file.data() + header.stream_offset + i * sizeof(CTStreamElement),
+                    sizeof(type));
+        if (type == FrameMarker)
+            ++num_frames;
+    }
+
+    LOG_INFO(HW_GPU, "Loaded the CiTrace {}, {} frames", filename, num_frames);
+    return true;
+}
+
+void Player::Reset() {
+    const auto& initial = header.initial_state_offsets;
+    auto& state = Pica::g_state;
+
+    ReadInitialState(&GPU::g_regs, sizeof(GPU::g_regs), initial.gpu_registers,
+                     initial.gpu_registers_size);
+    ReadInitialState(&LCD::g_regs, sizeof(LCD::g_regs), initial.lcd_registers,
+                     initial.lcd_registers_size);
+    ReadInitialState(state.regs.reg_array.data(), sizeof(state.regs.reg_array),
+                     initial.pica_registers, initial.pica_registers_size);
+
+    // Attributes and uniforms are stored as raw float24 values
+    const auto read_float24 = [this](Math::Vec4<Pica::float24>* dest, std::size_t count,
+                                     u32 offset, u32 size) {
+        std::vector<u32> raw(count * 4);
+        ReadInitialState(raw.data(), raw.size() * sizeof(u32), offset, size);
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            dest[i / 4][i % 4] = Pica::float24::FromRaw(raw[i]);
+        }
+    };
+    auto& default_attributes = state.input_default_attributes.attr;
+    read_float24(default_attributes, std::size(default_attributes), initial.default_attributes,
+                 initial.default_attributes_size);
+
+    for (const bool geometry : {false, true}) {
+        Pica::Shader::ShaderSetup& setup = geometry ? state.gs : state.vs;
+        const u32 program = geometry ? initial.gs_program_binary : initial.vs_program_binary;
+        const u32 program_size =
+            geometry ? initial.gs_program_binary_size : initial.vs_program_binary_size;
+        const u32 swizzle = geometry ? initial.gs_swizzle_data : initial.vs_swizzle_data;
+        const u32 swizzle_size =
+            geometry ? initial.gs_swizzle_data_size : initial.vs_swizzle_data_size;
+        const u32 uniforms = geometry ? initial.gs_float_uniforms : initial.vs_float_uniforms;
+        const u32 uniforms_size =
+            geometry ? initial.gs_float_uniforms_size : initial.vs_float_uniforms_size;
+
+        ReadInitialState(setup.program_code.data(), sizeof(setup.program_code), program,
+                         program_size);
+        ReadInitialState(setup.swizzle_data.data(), sizeof(setup.swizzle_data), swizzle,
+                         swizzle_size);
+        setup.MarkProgramCodeDirty();
+        setup.MarkSwizzleDataDirty();
+        read_float24(setup.uniforms.f, std::size(setup.uniforms.f), uniforms, uniforms_size);
+    }
+
+    // The rasterizer only keeps its state in sync with the registers as they are written
+    for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+
+    position = 0;
+}
+
+bool Player::ReplayFrame() {
+    while (position < header.stream_size) {
+        CTStreamElement element;
+        std::memcpy(&element,
+                    file.data() + header.stream_offset + position * sizeof(CTStreamElement),
+                    sizeof(element));
+        ++position;
+
+        switch (element.type) {
+        case FrameMarker:
+            Present();
+            return true;
+        case MemoryLoad:
+            LoadMemory(element.memory_load);
+            break;
+        case RegisterWrite:
+            WriteRegister(element.register_write);
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown CiTrace stream element type {:#X}",
+                      static_cast<u32>(element.type));
+            break;
+        }
+    }
+    return false;
+}
+
+void Player::LoadMemory(const CTMemoryLoad& load) {
+    if (load.size == 0)
+        return;
+    if (static_cast<u64>(load.file_offset) + load.size > file.size() ||
+        !memory.IsValidPhysicalAddress(load.physical_address) ||
+        !memory.IsValidPhysicalAddress(load.physical_address + load.size - 1)) {
+        LOG_ERROR(HW_GPU, "Invalid memory load of {:#X} bytes to {:#010X}", load.size,
+                  load.physical_address);
+        return;
+    }
+
+    // The guest wrote this memory, what the rasterizer has cached of it is outdated
+    Memory::RasterizerFlushAndInvalidateRegion(load.physical_address, load.size);
+    std::memcpy(memory.GetPhysicalPointer(load.physical_address),
+                file.data() + load.file_offset, load.size);
+}
+
+void Player::WriteRegister(const CTRegisterWrite& write) {
+    const u32 address = write.physical_address - Memory::IO_AREA_PADDR + Memory::IO_AREA_VADDR;
+    switch (write.size) {
+    case CTRegisterWrite::SIZE_8:
+        HW::Write<u8>(address, static_cast<u8>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_16:
+        HW::Write<u16>(address, static_cast<u16>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_32:
+        HW::Write<u32>(address, static_cast<u32>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_64:
+        HW::Write<u64>(address, write.value);
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown CiTrace register write size {:#X}",
+                  static_cast<u32>(write.size));
+        break;
+    }
+}
+
+void Player::Present() {
+    RendererBase::ScreenConfig screen_config;
+    std::copy(std::begin(GPU::g_regs.framebuffer_config), std::end(GPU::g_regs.framebuffer_config),
+              screen_config.framebuffers.begin());
+    screen_config.color_fills = {LCD::g_regs.color_fill_top, LCD::g_regs.color_fill_bottom};
+    VideoCore::g_renderer->SwapBuffers(screen_config);
+}
+
+void Player::ReadInitialState(void* dest, std::size_t dest_size, u32 offset, u32 size) const {
+    std::memcpy(dest, file.data() + offset, std::min<std::size_t>(dest_size, size * sizeof(u32)));
+}
+
+} // namespace CiTrace
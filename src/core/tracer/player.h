@@ -0,0 +1,68 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace CiTrace {
+
+/**
+ * Replays a CiTrace recorded by Recorder, without a running system. Memory loads are copied to
+ * guest memory and register writes go through the GPU and LCD hardware, so command lists, memory
+ * fills and display transfers are processed as they were while recording, and each frame marker
+ * presents a frame through VideoCore::g_renderer, which must be initialized.
+ *
+ * The whole trace is read into memory when loaded, so that the replay doesn't wait on the disk.
+ */
+class Player {
+public:
+    explicit Player(Memory::MemorySystem& memory);
+
+    /**
+     * Reads a trace file.
+     * @returns false if the file can't be read or isn't a valid trace
+     */
+    bool Load(const std::string& filename);
+
+    /// Sets the registers and shaders to the state the trace starts with and rewinds the stream
+    void Reset();
+
+    /**
+     * Replays the stream up to the next frame marker and presents the frame.
+     * @returns false if the end of the stream was reached before a frame marker
+     */
+    bool ReplayFrame();
+
+    /// Number of frame markers in the stream
+    u32 GetNumFrames() const {
+        return num_frames;
+    }
+
+private:
+    void LoadMemory(const CTMemoryLoad& load);
+    void WriteRegister(const CTRegisterWrite& write);
+    void Present();
+
+    /// Copies a part of the initial state, keeping the rest of the destination unchanged
+    void ReadInitialState(void* dest, std::size_t dest_size, u32 offset, u32 size) const;
+
+    Memory::MemorySystem& memory;
+
+    std::vector<u8> file;
+    CTHeader header;
+    u32 num_frames = 0;
+    /// Index of the next stream element to replay
+    u32 position = 0;
+};
+
+} // namespace CiTrace
@@ -3,16 +3,61 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <limits>
 #include "common/assert.h"
+#include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/lz4_compression.h"
+#include "common/thread.h"
 #include "core/tracer/recorder.h"
 
 namespace CiTrace {
 
-Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {}
+Recorder::Recorder(const InitialState& initial_state)
+    : initial_state(initial_state), stored_memory(STORED_MEMORY_TABLE_SIZE) {
+    std::size_t initial_state_size = 0;
+    for (const auto* part :
+         {&initial_state.gpu_registers, &initial_state.lcd_registers,
+          &initial_state.pica_registers, &initial_state.default_attributes,
+          &initial_state.vs_program_binary, &initial_state.vs_swizzle_data,
+          &initial_state.vs_float_uniforms, &initial_state.gs_program_binary,
+          &initial_state.gs_swizzle_data, &initial_state.gs_float_uniforms}) {
+        initial_state_size += part->size() * sizeof(u32);
+    }
+    data_offset = static_cast<u32>(sizeof(CTHeader) + initial_state_size);
+
+    chunk.data.reserve(CHUNK_DATA_SIZE);
+    chunk.elements.reserve(CHUNK_ELEMENTS);
+    memory_usage.Set(stored_memory.size() * sizeof(StoredMemory) + CHUNK_MEMORY_SIZE);
+
+    const std::string& cache_dir = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir);
+    FileUtil::CreateFullPath(cache_dir);
+    spool_path = cache_dir + "citrace.spool";
+    spool = FileUtil::IOFile(spool_path, "wb");
+    if (!spool.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to create the CiTrace spool file {}", spool_path);
+        spool_failed = true;
+    }
+
+    write_thread = std::thread(&Recorder::WriteThread, this);
+}
+
+Recorder::~Recorder() {
+    // An aborted recording only leaves the spool behind
+    if (write_thread.joinable()) {
+        StopWriting();
+        spool.Close();
+        FileUtil::Delete(spool_path);
+    }
+}
 
 void Recorder::Finish(const std::string& filename) {
+    QueueChunk();
+    StopWriting();
+    spool.Close();
+
     // Setup CiTrace header
     CTHeader header;
     std::memcpy(header.magic, CTHeader::ExpectedMagicWord(), 4);
@@ -32,7 +77,7 @@ void Recorder::Finish(const std::string& filename) {
     initial.gs_program_binary_size = static_cast<u32>(initial_state.gs_program_binary.size());
     initial.gs_swizzle_data_size = static_cast<u32>(initial_state.gs_swizzle_data.size());
     initial.gs_float_uniforms_size = static_cast<u32>(initial_state.gs_float_uniforms.size());
-    header.stream_size = static_cast<u32>(stream.size());
+    header.stream_size = stream_size;
 
     initial.gpu_registers = sizeof(header);
     initial.lcd_registers = initial.gpu_registers + initial.gpu_registers_size * sizeof(u32);
@@ -53,25 +98,9 @@ void Recorder::Finish(const std::string& filename) {
         initial.gs_swizzle_data + initial.gs_swizzle_data_size * sizeof(u32);
     header.stream_offset = initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
 
-    // Iterate through stream elements, update relevant stream element data
-    for (auto& stream_element : stream) {
-        switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
-            break;
-        }
-
-        default:
-            // Other commands don't use any extra data
-            DEBUG_ASSERT(stream_element.extra_data.size() == 0);
-            break;
-        }
-        header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
-    }
+    // The memory contents follow, their file offsets were assigned as they were recorded
+    ASSERT(header.stream_offset == data_offset);
+    header.stream_offset += static_cast<u32>(data_size);
 
     try {
         // Open file and write header
@@ -139,66 +168,178 @@ void Recorder::Finish(const std::string& filename) {
             file.Tell() != initial.gs_float_uniforms + sizeof(u32) * initial.gs_float_uniforms_size)
             throw "Failed to write geometry shader float uniforms";
 
-        // Iterate through stream elements, write "extra data"
-        for (const auto& stream_element : stream) {
-            if (stream_element.extra_data.size() == 0)
-                continue;
-
-            written =
-                file.WriteBytes(stream_element.extra_data.data(), stream_element.extra_data.size());
-            if (written != stream_element.extra_data.size())
-                throw "Failed to write extra data";
-        }
-
-        if (file.Tell() != header.stream_offset)
-            throw "Unexpected end of extra data";
+        if (spool_failed)
+            throw "Failed to write the spool file";
+
+        // Copy the memory contents of every chunk, then their stream elements
+        FileUtil::IOFile spool_file(spool_path, "rb");
+        std::vector<u8> compressed;
+        std::vector<u8> data;
+        for (const bool elements : {false, true}) {
+            for (const SpooledChunk& spooled : spooled_chunks) {
+                const u32 size = elements
+                                     ? static_cast<u32>(spooled.num_elements *
+                                                        sizeof(CTStreamElement))
+                                     : spooled.data_size;
+                const u32 compressed_size =
+                    elements ? spooled.compressed_elements_size : spooled.compressed_data_size;
+                if (size == 0)
+                    continue;
+
+                compressed.resize(compressed_size);
+                data.resize(size);
+                const u64 offset =
+                    spooled.offset + (elements ? spooled.compressed_data_size : 0);
+                if (!spool_file.Seek(static_cast<s64>(offset), SEEK_SET) ||
+                    spool_file.ReadBytes(compressed.data(), compressed.size()) !=
+                        compressed.size() ||
+                    !Common::LZ4::DecompressBlock(compressed.data(), compressed.size(),
+                                                  data.data(), data.size()))
+                    throw "Failed to read the spool file";
+
+                if (file.WriteBytes(data.data(), data.size()) != data.size()) {
+                    throw elements ? "Failed to write stream elements"
+                                   : "Failed to write extra data";
+                }
+            }
 
-        // Write actual stream elements
-        for (const auto& stream_element : stream) {
-            if (1 != file.WriteObject(stream_element.data))
-                throw "Failed to write stream element";
+            if (!elements && file.Tell() != header.stream_offset)
+                throw "Unexpected end of extra data";
         }
     } catch (const char* str) {
         LOG_ERROR(HW_GPU, "Writing CiTrace file failed: {}", str);
     }
+
+    FileUtil::Delete(spool_path);
 }
 
 void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+    CTStreamElement element{FrameMarker};
+    Record(element);
 }
 
 void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
-    StreamElement element = {{MemoryLoad}};
-    element.data.memory_load.size = size;
-    element.data.memory_load.physical_address = physical_address;
-
-    // Compute hash over given memory region to check if the contents are already stored internally
-    boost::crc_32_type result;
-    result.process_bytes(data, size);
-    element.hash = result.checksum();
-
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
+    CTStreamElement element{MemoryLoad};
+    element.memory_load.size = size;
+    element.memory_load.physical_address = physical_address;
+
+    // Check if the contents are already stored, comparing hashes over the given memory region
+    const u64 hash = Common::ComputeHash64(data, size);
+    StoredMemory& stored = stored_memory[hash % stored_memory.size()];
+    if (stored.hash == hash && stored.size == size) {
+        element.memory_load.file_offset = stored.file_offset;
+    } else {
+        // The file offsets in the trace are 32-bit
+        if (data_offset + data_size + size > std::numeric_limits<u32>::max()) {
+            if (!data_full) {
+                LOG_ERROR(HW_GPU, "CiTrace reached 4 GiB, memory loads are no longer recorded");
+                data_full = true;
+            }
+            return;
+        }
+
+        element.memory_load.file_offset = static_cast<u32>(data_offset + data_size);
+        stored = {hash, size, element.memory_load.file_offset};
+        chunk.data.insert(chunk.data.end(), data, data + size);
+        data_size += size;
+    }
+
+    Record(element);
+}
+
+void Recorder::Record(const CTStreamElement& element) {
+    chunk.elements.push_back(element);
+    ++stream_size;
+    if (chunk.elements.size() >= CHUNK_ELEMENTS || chunk.data.size() >= CHUNK_DATA_SIZE)
+        QueueChunk();
+}
+
+void Recorder::QueueChunk() {
+    if (chunk.elements.empty())
+        return;
+
+    {
+        std::unique_lock lock{mutex};
+        free_cv.wait(lock, [this] { return queued_chunks.size() < MAX_QUEUED_CHUNKS; });
+        queued_chunks.push_back(std::move(chunk));
+        if (free_chunks.empty()) {
+            chunk = {};
+            memory_usage.Add(CHUNK_MEMORY_SIZE);
+        } else {
+            chunk = std::move(free_chunks.back());
+            free_chunks.pop_back();
+        }
     }
+    queue_cv.notify_one();
 
-    stream.push_back(element);
+    chunk.data.reserve(CHUNK_DATA_SIZE);
+    chunk.elements.reserve(CHUNK_ELEMENTS);
+}
+
+void Recorder::StopWriting() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    queue_cv.notify_one();
+    write_thread.join();
+}
+
+void Recorder::WriteThread() {
+    Common::SetCurrentThreadName("CiTraceWriter");
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        queue_cv.wait(lock, [this] { return stop || !queued_chunks.empty(); });
+        // Everything queued is still written when stopping
+        if (queued_chunks.empty())
+            return;
+        Chunk queued = std::move(queued_chunks.front());
+        queued_chunks.pop_front();
+        lock.unlock();
+        free_cv.notify_one();
+
+        if (!spool_failed) {
+            const auto compressed_data =
+                Common::LZ4::CompressBlock(queued.data.data(), queued.data.size());
+            const auto compressed_elements = Common::LZ4::CompressBlock(
+                reinterpret_cast<const u8*>(queued.elements.data()),
+                queued.elements.size() * sizeof(CTStreamElement));
+
+            SpooledChunk spooled{static_cast<u64>(spool.Tell()),
+                                 static_cast<u32>(queued.data.size()),
+                                 static_cast<u32>(compressed_data.size()),
+                                 static_cast<u32>(queued.elements.size()),
+                                 static_cast<u32>(compressed_elements.size())};
+            if (spool.WriteBytes(compressed_data.data(), compressed_data.size()) !=
+                    compressed_data.size() ||
+                spool.WriteBytes(compressed_elements.data(), compressed_elements.size()) !=
+                    compressed_elements.size()) {
+                LOG_ERROR(HW_GPU, "Failed to write the CiTrace spool file {}", spool_path);
+                spool_failed = true;
+            }
+            spooled_chunks.push_back(spooled);
+        }
+
+        queued.data.clear();
+        queued.elements.clear();
+        lock.lock();
+        free_chunks.push_back(std::move(queued));
+    }
 }
 
 template <typename T>
 void Recorder::RegisterWritten(u32 physical_address, T value) {
-    StreamElement element = {{RegisterWrite}};
-    element.data.register_write.size =
+    CTStreamElement element{RegisterWrite};
+    element.register_write.size =
         (sizeof(T) == 1) ? CTRegisterWrite::SIZE_8
                          : (sizeof(T) == 2) ? CTRegisterWrite::SIZE_16
                                             : (sizeof(T) == 4) ? CTRegisterWrite::SIZE_32
                                                                : CTRegisterWrite::SIZE_64;
-    element.data.register_write.physical_address = physical_address;
-    element.data.register_write.value = value;
+    element.register_write.physical_address = physical_address;
+    element.register_write.value = value;
 
-    stream.push_back(element);
+    Record(element);
 }
 
 template void Recorder::RegisterWritten(u32, u8);
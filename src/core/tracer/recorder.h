@@ -4,15 +4,25 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <thread>
 #include <vector>
-#include <boost/crc.hpp>
 #include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/memory_usage.h"
 #include "core/tracer/citrace.h"
 
 namespace CiTrace {
 
+/**
+ * Records a CiTrace. The recorded stream is compressed and spooled to a file in the cache
+ * directory as it is recorded, by a background thread, so that the memory used doesn't grow with
+ * the length of the recording. Finish then writes the trace file from the spool.
+ */
 class Recorder {
 public:
     struct InitialState {
@@ -33,6 +43,7 @@ public:
      * @param initial_state Initial recorder state
      */
     explicit Recorder(const InitialState& initial_state);
+    ~Recorder();
 
     /// Finish recording of this Citrace and save it using the given filename.
     void Finish(const std::string& filename);
@@ -55,33 +66,75 @@ public:
     void RegisterWritten(u32 physical_address, T value);
 
 private:
-    // Initial state of recording start
-    InitialState initial_state;
-
-    // Command stream
-    struct StreamElement {
-        CTStreamElement data;
-
-        /**
-         * Extra data to store along "core" data.
-         * This is e.g. used for data used in MemoryUpdates.
-         */
-        std::vector<u8> extra_data;
+    /// Recorded data is handed to the writer thread in chunks of about this size
+    static constexpr std::size_t CHUNK_DATA_SIZE = 4 * 1024 * 1024;
+    static constexpr std::size_t CHUNK_ELEMENTS = 64 * 1024;
+    /// Recording waits for the writer thread when this many chunks are queued
+    static constexpr std::size_t MAX_QUEUED_CHUNKS = 4;
+    /// Memory contents already stored are looked up in a table of this many entries, indexed by
+    /// their hash, older contents are stored again once their entry is reused
+    static constexpr std::size_t STORED_MEMORY_TABLE_SIZE = 64 * 1024;
+
+    /// Memory reserved by each chunk
+    static constexpr std::size_t CHUNK_MEMORY_SIZE =
+        CHUNK_DATA_SIZE + CHUNK_ELEMENTS * sizeof(CTStreamElement);
+
+    struct Chunk {
+        /// Memory contents, stored in the trace in this order
+        std::vector<u8> data;
+        std::vector<CTStreamElement> elements;
+    };
 
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
+    /// Location of a chunk in the spool file, its data then its elements, each compressed
+    struct SpooledChunk {
+        u64 offset;
+        u32 data_size;
+        u32 compressed_data_size;
+        u32 num_elements;
+        u32 compressed_elements_size;
+    };
 
-        /// If true, refer to data already written to the output file instead of extra_data
-        bool uses_existing_data;
+    struct StoredMemory {
+        u64 hash;
+        u32 size;
+        u32 file_offset;
     };
 
-    std::vector<StreamElement> stream;
+    void Record(const CTStreamElement& element);
+    void QueueChunk();
+    void StopWriting();
+    void WriteThread();
 
-    /**
-     * Internal cache which maps hashes of memory contents to file offsets at which those memory
-     * contents are stored.
-     */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    // Initial state of recording start
+    InitialState initial_state;
+
+    /// Offset in the trace file of the memory contents, which follow the initial state
+    u32 data_offset;
+    /// Size of the memory contents recorded so far
+    u64 data_size = 0;
+    u32 stream_size = 0;
+    /// Whether memory loads are dropped because the trace reached the 4 GiB offset limit
+    bool data_full = false;
+
+    std::vector<StoredMemory> stored_memory;
+    Chunk chunk;
+
+    std::string spool_path;
+    FileUtil::IOFile spool;
+    std::vector<SpooledChunk> spooled_chunks;
+    bool spool_failed = false;
+
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::condition_variable free_cv;
+    std::deque<Chunk> queued_chunks;
+    /// Chunks the writer thread is done with, reused to avoid allocating new buffers
+    std::vector<Chunk> free_chunks;
+    bool stop = false;
+    std::thread write_thread;
+
+    /// Accounts the chunks and the table of stored memory contents
+    Common::ScopedMemoryUsage memory_usage{Common::MemoryCategory::TraceBuffers};
 };
 
 } // namespace CiTrace
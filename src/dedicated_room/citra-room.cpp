@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -9,6 +11,7 @@
 #include <regex>
 #include <string>
 #include <thread>
+#include <vector>
 #include <glad/glad.h>
 
 #ifdef _MSC_VER
@@ -46,6 +49,8 @@ static void PrintHelp(const char* argv0) {
                  "--room-name         The name of the room\n"
                  "--room-description  The room description\n"
                  "--port              The port used for the room\n"
+                 "--room-count        The number of rooms to host, on consecutive ports\n"
+                 "--threads           The number of threads handling the rooms\n"
                  "--max_members       The maximum number of players for this room\n"
                  "--password          The password for the room\n"
                  "--preferred-game    The preferred game for this room\n"
@@ -55,6 +60,8 @@ static void PrintHelp(const char* argv0) {
                  "--web-api-url       Citra Web API url\n"
                  "--ban-list-file     The file for storing the room ban list\n"
                  "--enable-citra-mods Allow Citra Community Moderators to moderate on your room\n"
+                 "--direct-connections Let the members send their local wireless traffic to each\n"
+                 "                    other directly, the room only relays it when that fails\n"
                  "-h, --help          Display this help and exit\n"
                  "-v, --version       Output version information and exit\n";
 }
@@ -129,6 +136,38 @@ static void SaveBanList(const Network::Room::BanList& ban_list, const std::strin
     file.flush();
 }
 
+/// Merges the ban lists of several rooms, keeping each entry once
+static Network::Room::BanList MergeBanLists(
+    const std::vector<std::shared_ptr<Network::Room>>& rooms) {
+    Network::Room::BanList merged;
+    const auto append_unique = [](std::vector<std::string>& list,
+                                  const std::vector<std::string>& entries) {
+        for (const auto& entry : entries) {
+            if (std::find(list.begin(), list.end(), entry) == list.end()) {
+                list.push_back(entry);
+            }
+        }
+    };
+    for (const auto& room : rooms) {
+        const Network::Room::BanList ban_list = room->GetBanList();
+        append_unique(merged.first, ban_list.first);
+        append_unique(merged.second, ban_list.second);
+    }
+    return merged;
+}
+
+static void PrintStatistics(const std::vector<std::shared_ptr<Network::Room>>& rooms) {
+    for (const auto& room : rooms) {
+        const Network::RoomInformation info = room->GetRoomInformation();
+        const Network::Room::Statistics stats = room->GetStatistics();
+        std::cout << info.name << " (port " << info.port << "): " << stats.member_count << "/"
+                  << info.member_slots << " members, " << stats.forwarded_packets
+                  << " packets (" << stats.forwarded_bytes << " bytes) forwarded, "
+                  << stats.dropped_packets << " dropped\n";
+    }
+    std::cout << std::endl;
+}
+
 /// Application entry point
 int main(int argc, char** argv) {
     Common::DetachedTasks detached_tasks;
@@ -149,12 +188,17 @@ int main(int argc, char** argv) {
     u64 preferred_game_id = 0;
     u32 port = Network::DefaultRoomPort;
     u32 max_members = 16;
+    u32 room_count = 1;
+    u32 thread_count = 0;
     bool enable_citra_mods = false;
+    bool allow_direct_connections = false;
 
     static struct option long_options[] = {
         {"room-name", required_argument, 0, 'n'},
         {"room-description", required_argument, 0, 'd'},
         {"port", required_argument, 0, 'p'},
+        {"room-count", required_argument, 0, 'c'},
+        {"threads", required_argument, 0, 'r'},
         {"max_members", required_argument, 0, 'm'},
         {"password", required_argument, 0, 'w'},
         {"preferred-game", required_argument, 0, 'g'},
@@ -164,13 +208,15 @@ int main(int argc, char** argv) {
         {"web-api-url", required_argument, 0, 'a'},
         {"ban-list-file", required_argument, 0, 'b'},
         {"enable-citra-mods", no_argument, 0, 'e'},
+        {"direct-connections", no_argument, 0, 'x'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "n:d:p:m:w:g:u:t:a:i:hv", long_options, &option_index);
+        char arg =
+            getopt_long(argc, argv, "n:d:p:c:r:m:w:g:u:t:a:i:hv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'n':
@@ -182,6 +228,12 @@ int main(int argc, char** argv) {
             case 'p':
                 port = strtoul(optarg, &endarg, 0);
                 break;
+            case 'c':
+                room_count = strtoul(optarg, &endarg, 0);
+                break;
+            case 'r':
+                thread_count = strtoul(optarg, &endarg, 0);
+                break;
             case 'm':
                 max_members = strtoul(optarg, &endarg, 0);
                 break;
@@ -209,6 +261,9 @@ int main(int argc, char** argv) {
             case 'e':
                 enable_citra_mods = true;
                 break;
+            case 'x':
+                allow_direct_connections = true;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -239,11 +294,15 @@ int main(int argc, char** argv) {
         PrintHelp(argv[0]);
         return -1;
     }
-    if (port > 65535) {
-        std::cout << "port needs to be in the range 0 - 65535!\n\n";
+    if (room_count < 1 || port + room_count - 1 > 65535) {
+        std::cout << "the ports of all rooms need to be in the range 0 - 65535!\n\n";
         PrintHelp(argv[0]);
         return -1;
     }
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::min(room_count, std::thread::hardware_concurrency()));
+    }
+    thread_count = std::min(thread_count, room_count);
     if (ban_list_file.empty()) {
         std::cout << "Ban list file not set!\nThis should get set to load and save room ban "
                      "list.\nSet with --ban-list-file <file>\n\n";
@@ -278,58 +337,91 @@ int main(int argc, char** argv) {
         ban_list = LoadBanList(ban_list_file);
     }
 
-    std::unique_ptr<Network::VerifyUser::Backend> verify_backend;
-    if (announce) {
+    const auto make_verify_backend = [announce]() -> std::unique_ptr<Network::VerifyUser::Backend> {
+        if (announce) {
 #ifdef ENABLE_WEB_SERVICE
-        verify_backend = std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
+            return std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
 #else
+            return std::make_unique<Network::VerifyUser::NullBackend>();
+#endif
+        }
+        return std::make_unique<Network::VerifyUser::NullBackend>();
+    };
+#ifndef ENABLE_WEB_SERVICE
+    if (announce) {
         std::cout
             << "Citra Web Services is not available with this build: validation is disabled.\n\n";
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
-#endif
-    } else {
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
     }
+#endif
 
     Network::Init();
-    if (std::shared_ptr<Network::Room> room = Network::GetRoom().lock()) {
-        if (!room->Create(room_name, room_description, "", port, password, max_members, username,
-                          preferred_game, preferred_game_id, std::move(verify_backend), ban_list,
-                          enable_citra_mods)) {
-            std::cout << "Failed to create room: \n\n";
+
+    // Rooms are handled by a few threads rather than one each, so that a process can host many
+    std::vector<std::shared_ptr<Network::Room>> rooms;
+    for (u32 i = 0; i < room_count; ++i) {
+        const std::string name =
+            room_count > 1 ? room_name + " #" + std::to_string(i + 1) : room_name;
+        auto room = std::make_shared<Network::Room>();
+        if (!room->Create(name, room_description, "", static_cast<u16>(port + i), password,
+                          max_members, username, preferred_game, preferred_game_id,
+                          make_verify_backend(), ban_list, enable_citra_mods, false,
+                          allow_direct_connections)) {
+            std::cout << "Failed to create room on port " << port + i << "\n\n";
+            for (const auto& created_room : rooms) {
+                created_room->Destroy();
+            }
+            Network::Shutdown();
             return -1;
         }
-        std::cout << "Room is open. Close with Q+Enter...\n\n";
-        auto announce_session = std::make_unique<Core::AnnounceMultiplayerSession>();
-        if (announce) {
-            announce_session->Start();
+        rooms.push_back(std::move(room));
+    }
+
+    std::atomic_bool stop_workers = false;
+    std::vector<std::thread> workers;
+    for (u32 t = 0; t < thread_count; ++t) {
+        std::vector<std::shared_ptr<Network::Room>> shard;
+        for (u32 i = t; i < room_count; i += thread_count) {
+            shard.push_back(rooms[i]);
         }
-        while (room->GetState() == Network::Room::State::Open) {
-            std::string in;
-            std::cin >> in;
-            if (in.size() > 0) {
-                if (announce) {
-                    announce_session->Stop();
-                }
-                announce_session.reset();
-                // Save the ban list
-                if (!ban_list_file.empty()) {
-                    SaveBanList(room->GetBanList(), ban_list_file);
-                }
-                room->Destroy();
-                Network::Shutdown();
-                return 0;
+        workers.emplace_back([shard = std::move(shard), &stop_workers] {
+            while (!stop_workers) {
+                Network::Room::HandleEvents(shard, 50);
             }
+        });
+    }
+
+    std::cout << (room_count > 1 ? "Rooms are" : "Room is")
+              << " open. Print statistics with S+Enter, close with Q+Enter...\n\n";
+    auto announce_session = std::make_unique<Core::AnnounceMultiplayerSession>(rooms);
+    if (announce) {
+        announce_session->Start();
+    }
+    while (true) {
+        std::string in;
+        if (!(std::cin >> in)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
         }
-        if (announce) {
-            announce_session->Stop();
-        }
-        announce_session.reset();
-        // Save the ban list
-        if (!ban_list_file.empty()) {
-            SaveBanList(room->GetBanList(), ban_list_file);
+        if (in == "s" || in == "S" || in == "stats") {
+            PrintStatistics(rooms);
+            continue;
         }
+        break;
+    }
+
+    if (announce) {
+        announce_session->Stop();
+    }
+    announce_session.reset();
+    stop_workers = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // Save the ban list, bans made in any of the rooms apply to all of them on the next start
+    if (!ban_list_file.empty()) {
+        SaveBanList(MergeBanLists(rooms), ban_list_file);
+    }
+    for (const auto& room : rooms) {
         room->Destroy();
     }
     Network::Shutdown();
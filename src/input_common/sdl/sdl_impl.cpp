@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cmath>
 #include <functional>
@@ -19,6 +20,7 @@
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/param_package.h"
+#include "common/thread.h"
 #include "common/threadsafe_queue.h"
 #include "core/frontend/input.h"
 #include "input_common/sdl/sdl_impl.h"
@@ -37,6 +39,9 @@ static std::string GetGUID(SDL_Joystick* joystick) {
 /// Creates a ParamPackage from an SDL_Event that can directly be used to create a ButtonDevice
 static Common::ParamPackage SDLEventToButtonParamPackage(SDLState& state, const SDL_Event& event);
 
+/// Longest time the poll thread waits for events before checking whether it should stop
+constexpr int POLL_THREAD_WAIT_TIMEOUT_MS = 100;
+
 static int SDLEventWatcher(void* userdata, SDL_Event* event) {
     SDLState* sdl_state = reinterpret_cast<SDLState*>(userdata);
     // Don't handle the event if we are configuring
@@ -54,24 +59,29 @@ public:
                 decltype(&SDL_JoystickClose) deleter = &SDL_JoystickClose)
         : guid{std::move(guid_)}, port{port_}, sdl_joystick{joystick, deleter} {}
 
+    // The state is written by the SDL event thread and read by the emulation thread without
+    // locking, each value being independent
+
     void SetButton(int button, bool value) {
-        std::lock_guard<std::mutex> lock(mutex);
-        state.buttons[button] = value;
+        if (IsValidIndex(state.buttons, button))
+            state.buttons[button].store(value, std::memory_order_relaxed);
     }
 
     bool GetButton(int button) const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return state.buttons.at(button);
+        if (!IsValidIndex(state.buttons, button))
+            return false;
+        return state.buttons[button].load(std::memory_order_relaxed);
     }
 
     void SetAxis(int axis, Sint16 value) {
-        std::lock_guard<std::mutex> lock(mutex);
-        state.axes[axis] = value;
+        if (IsValidIndex(state.axes, axis))
+            state.axes[axis].store(value, std::memory_order_relaxed);
     }
 
     float GetAxis(int axis) const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return state.axes.at(axis) / 32767.0f;
+        if (!IsValidIndex(state.axes, axis))
+            return 0.0f;
+        return state.axes[axis].load(std::memory_order_relaxed) / 32767.0f;
     }
 
     std::tuple<float, float> GetAnalog(int axis_x, int axis_y) const {
@@ -92,13 +102,14 @@ public:
     }
 
     void SetHat(int hat, Uint8 direction) {
-        std::lock_guard<std::mutex> lock(mutex);
-        state.hats[hat] = direction;
+        if (IsValidIndex(state.hats, hat))
+            state.hats[hat].store(direction, std::memory_order_relaxed);
     }
 
     bool GetHatDirection(int hat, Uint8 direction) const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return (state.hats.at(hat) & direction) != 0;
+        if (!IsValidIndex(state.hats, hat))
+            return false;
+        return (state.hats[hat].load(std::memory_order_relaxed) & direction) != 0;
     }
     /**
      * The guid of the joystick
@@ -125,15 +136,24 @@ public:
     }
 
 private:
+    /// Numbers of the buttons, axes and hats tracked, higher ones are ignored
+    static constexpr std::size_t MAX_BUTTONS = 64;
+    static constexpr std::size_t MAX_AXES = 32;
+    static constexpr std::size_t MAX_HATS = 8;
+
+    template <typename T, std::size_t N>
+    static bool IsValidIndex(const std::array<T, N>&, int index) {
+        return index >= 0 && static_cast<std::size_t>(index) < N;
+    }
+
     struct State {
-        std::unordered_map<int, bool> buttons;
-        std::unordered_map<int, Sint16> axes;
-        std::unordered_map<int, Uint8> hats;
+        std::array<std::atomic<bool>, MAX_BUTTONS> buttons{};
+        std::array<std::atomic<Sint16>, MAX_AXES> axes{};
+        std::array<std::atomic<Uint8>, MAX_HATS> hats{};
     } state;
     std::string guid;
     int port;
     std::unique_ptr<SDL_Joystick, decltype(&SDL_JoystickClose)> sdl_joystick;
-    mutable std::mutex mutex;
 };
 
 /**
@@ -476,11 +496,17 @@ SDLState::SDLState() {
     initialized = true;
     if (start_thread) {
         poll_thread = std::thread([&] {
-            using namespace std::chrono_literals;
+            Common::ScopedThreadRole thread_role{Common::ThreadRole::IO};
+            // Sleeps until SDL has events instead of pumping them at a fixed interval, which
+            // delayed input by up to 10 ms. SDL still polls the joysticks that can't wake it up.
+            // The event watcher has handled the events by the time they are queued, so they are
+            // only dequeued here to keep the queue from filling up.
             SDL_Event event;
             while (initialized) {
-                SDL_PumpEvents();
-                std::this_thread::sleep_for(std::chrono::duration(10ms));
+                if (SDL_WaitEventTimeout(&event, POLL_THREAD_WAIT_TIMEOUT_MS)) {
+                    while (SDL_PollEvent(&event)) {
+                    }
+                }
             }
         });
     }
@@ -501,6 +527,10 @@ SDLState::~SDLState() {
 
     initialized = false;
     if (start_thread) {
+        // Wakes the poll thread up
+        SDL_Event event{};
+        event.type = SDL_USEREVENT;
+        SDL_PushEvent(&event);
         poll_thread.join();
         SDL_QuitSubSystem(SDL_INIT_JOYSTICK);
     }
@@ -39,9 +39,9 @@ public:
         InputCommon::Polling::DeviceType type,
         std::vector<std::unique_ptr<InputCommon::Polling::DevicePoller>>& pollers) override;
 
-    /// Used by the Pollers during config
+    /// Used by the Pollers during config. Any thread pumping SDL events pushes to the queue.
     std::atomic<bool> polling = false;
-    Common::SPSCQueue<SDL_Event> event_queue;
+    Common::MPSCQueue<SDL_Event> event_queue;
 
 private:
     void InitJoystick(int joystick_index);
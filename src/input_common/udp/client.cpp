@@ -7,10 +7,12 @@
 #include <chrono>
 #include <cstring>
 #include <functional>
+#include <optional>
 #include <thread>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "input_common/udp/client.h"
 #include "input_common/udp/protocol.h"
 
@@ -45,7 +47,7 @@ public:
     }
 
     void StartSend(const clock::time_point& from) {
-        timer.expires_at(from + std::chrono::seconds(3));
+        timer.expires_at(from);
         timer.async_wait([this](const boost::system::error_code& error) { HandleSend(error); });
     }
 
@@ -59,6 +61,26 @@ public:
 
 private:
     void HandleReceive(const boost::system::error_code& error, std::size_t bytes_transferred) {
+        std::optional<Response::PadData> pad_data;
+        Dispatch(bytes_transferred, pad_data);
+
+        // Only the newest of the pad data packets that queued up in the meantime is of interest,
+        // so they are all read before handing it over
+        boost::system::error_code receive_error;
+        while (socket.available(receive_error) != 0 && !receive_error) {
+            const std::size_t size = socket.receive_from(boost::asio::buffer(receive_buffer),
+                                                         receive_endpoint, 0, receive_error);
+            if (receive_error)
+                break;
+            Dispatch(size, pad_data);
+        }
+        if (pad_data) {
+            callback.pad_data(std::move(*pad_data));
+        }
+        StartReceive();
+    }
+
+    void Dispatch(std::size_t bytes_transferred, std::optional<Response::PadData>& pad_data) {
         if (auto type = Response::Validate(receive_buffer.data(), bytes_transferred)) {
             switch (*type) {
             case Type::Version: {
@@ -75,14 +97,15 @@ private:
                 break;
             }
             case Type::PadData: {
-                Response::PadData pad_data;
-                std::memcpy(&pad_data, &receive_buffer[sizeof(Header)], sizeof(Response::PadData));
-                callback.pad_data(std::move(pad_data));
+                Response::PadData data;
+                std::memcpy(&data, &receive_buffer[sizeof(Header)], sizeof(Response::PadData));
+                if (!pad_data || data.packet_counter > pad_data->packet_counter) {
+                    pad_data = data;
+                }
                 break;
             }
             }
         }
-        StartReceive();
     }
 
     void HandleSend(const boost::system::error_code& error) {
@@ -97,7 +120,10 @@ private:
         auto pad_message = Request::Create(pad_data, client_id);
         std::memcpy(send_buffer2.data(), &pad_message, PAD_DATA_SIZE);
         std::size_t len2 = socket.send_to(boost::asio::buffer(send_buffer2), send_endpoint);
-        StartSend(timer.expiry());
+
+        // The server streams pad data for a few seconds after each request, the subscription is
+        // renewed before it runs out
+        StartSend(timer.expiry() + std::chrono::seconds(3));
     }
 
     SocketCallback callback;
@@ -118,7 +144,70 @@ private:
     udp::endpoint receive_endpoint;
 };
 
+/// Motion is extrapolated by at most one packet interval, and not at all across longer gaps
+constexpr s64 MAX_MOTION_INTERVAL_US = 50000;
+
+static s64 GetHostTime() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+DeviceStatus::State DeviceStatus::GetState() const {
+    State result;
+    u32 begin;
+    do {
+        begin = sequence.load(std::memory_order_acquire);
+        result = state;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((begin & 1) != 0 || begin != sequence.load(std::memory_order_relaxed));
+    return result;
+}
+
+void DeviceStatus::SetState(const State& new_state) {
+    const u32 begin = sequence.load(std::memory_order_relaxed);
+    sequence.store(begin + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    state = new_state;
+    sequence.store(begin + 2, std::memory_order_release);
+}
+
+std::tuple<Math::Vec3<float>, Math::Vec3<float>> DeviceStatus::GetMotionStatus() const {
+    const State current = GetState();
+    const MotionSample& previous = current.motion[0];
+    const MotionSample& latest = current.motion[1];
+
+    // Servers that don't timestamp their samples send zero, the receive times are used instead
+    s64 interval = static_cast<s64>(latest.device_time - previous.device_time);
+    if (latest.device_time == 0 || latest.device_time <= previous.device_time) {
+        interval = latest.host_time - previous.host_time;
+    }
+    if (previous.host_time == 0 || interval <= 0 || interval > MAX_MOTION_INTERVAL_US) {
+        return {latest.accel, latest.gyro};
+    }
+
+    const float t = std::clamp(static_cast<float>(GetHostTime() - latest.host_time) / interval,
+                               0.0f, 1.0f);
+    return {latest.accel + (latest.accel - previous.accel) * t,
+            latest.gyro + (latest.gyro - previous.gyro) * t};
+}
+
+std::optional<DeviceStatus::CalibrationData> DeviceStatus::GetTouchCalibration() const {
+    const u64 packed = touch_calibration.load(std::memory_order_relaxed);
+    if (packed == 0)
+        return std::nullopt;
+    return CalibrationData{static_cast<u16>(packed), static_cast<u16>(packed >> 16),
+                           static_cast<u16>(packed >> 32), static_cast<u16>(packed >> 48)};
+}
+
+void DeviceStatus::SetTouchCalibration(const CalibrationData& calibration) {
+    touch_calibration.store(u64{calibration.min_x} | u64{calibration.min_y} << 16 |
+                                u64{calibration.max_x} << 32 | u64{calibration.max_y} << 48,
+                            std::memory_order_relaxed);
+}
+
 static void SocketLoop(Socket* socket) {
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::IO};
     socket->StartReceive();
     socket->StartSend(Socket::clock::now());
     socket->Loop();
@@ -159,37 +248,41 @@ void Client::OnPadData(Response::PadData data) {
         return;
     }
     packet_sequence = data.packet_counter;
+
+    // The socket thread is the only writer, so the state can't change while it is updated
+    DeviceStatus::State state = status->GetState();
+    state.motion[0] = state.motion[1];
+
     // Due to differences between the 3ds and cemuhookudp motion directions, we need to invert
     // accel.x and accel.z and also invert pitch and yaw. See
     // https://github.com/citra-emu/citra/pull/4049 for more details on gyro/accel
-    Math::Vec3f accel = Math::MakeVec<float>(-data.accel.x, data.accel.y, -data.accel.z);
-    Math::Vec3f gyro = Math::MakeVec<float>(-data.gyro.pitch, -data.gyro.yaw, data.gyro.roll);
-    {
-        std::lock_guard<std::mutex> guard(status->update_mutex);
-
-        status->motion_status = {accel, gyro};
-
-        // TODO: add a setting for "click" touch. Click touch refers to a device that differentiates
-        // between a simple "tap" and a hard press that causes the touch screen to click.
-        bool is_active = data.touch_1.is_active != 0;
-
-        float x = 0;
-        float y = 0;
-
-        if (is_active && status->touch_calibration) {
-            u16 min_x = status->touch_calibration->min_x;
-            u16 max_x = status->touch_calibration->max_x;
-            u16 min_y = status->touch_calibration->min_y;
-            u16 max_y = status->touch_calibration->max_y;
-
-            x = (std::clamp(static_cast<u16>(data.touch_1.x), min_x, max_x) - min_x) /
-                static_cast<float>(max_x - min_x);
-            y = (std::clamp(static_cast<u16>(data.touch_1.y), min_y, max_y) - min_y) /
-                static_cast<float>(max_y - min_y);
-        }
-
-        status->touch_status = {x, y, is_active};
+    state.motion[1].accel = Math::MakeVec<float>(-data.accel.x, data.accel.y, -data.accel.z);
+    state.motion[1].gyro = Math::MakeVec<float>(-data.gyro.pitch, -data.gyro.yaw, data.gyro.roll);
+    state.motion[1].device_time = data.motion_timestamp;
+    state.motion[1].host_time = GetHostTime();
+
+    // TODO: add a setting for "click" touch. Click touch refers to a device that differentiates
+    // between a simple "tap" and a hard press that causes the touch screen to click.
+    bool is_active = data.touch_1.is_active != 0;
+
+    float x = 0;
+    float y = 0;
+
+    const auto calibration = status->GetTouchCalibration();
+    if (is_active && calibration) {
+        u16 min_x = calibration->min_x;
+        u16 max_x = calibration->max_x;
+        u16 min_y = calibration->min_y;
+        u16 max_y = calibration->max_y;
+
+        x = (std::clamp(static_cast<u16>(data.touch_1.x), min_x, max_x) - min_x) /
+            static_cast<float>(max_x - min_x);
+        y = (std::clamp(static_cast<u16>(data.touch_1.y), min_y, max_y) - min_y) /
+            static_cast<float>(max_y - min_y);
     }
+
+    state.touch = {x, y, is_active};
+    status->SetState(state);
 }
 
 void Client::StartCommunication(const std::string& host, u16 port, u8 pad_index, u32 client_id) {
@@ -4,9 +4,10 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
@@ -29,10 +30,28 @@ struct PortInfo;
 struct Version;
 } // namespace Response
 
-struct DeviceStatus {
-    std::mutex update_mutex;
-    std::tuple<Math::Vec3<float>, Math::Vec3<float>> motion_status;
-    std::tuple<float, float, bool> touch_status;
+/**
+ * State of the pad, written by the socket thread for every pad data packet and read by the
+ * emulated HID on every sample. The state is handed over with a sequence lock, so that neither
+ * side ever blocks the other: a reader retries in the rare case where a packet was written while
+ * it was copying the state.
+ */
+class DeviceStatus {
+public:
+    struct MotionSample {
+        Math::Vec3<float> accel;
+        Math::Vec3<float> gyro;
+        /// Time at which the device took the sample, in microseconds of the device's clock
+        u64 device_time;
+        /// Time at which the sample was received, in microseconds of the host's steady clock
+        s64 host_time;
+    };
+
+    struct State {
+        /// The two most recent motion samples, the latest last
+        std::array<MotionSample, 2> motion{};
+        std::tuple<float, float, bool> touch{};
+    };
 
     // calibration data for scaling the device's touch area to 3ds
     struct CalibrationData {
@@ -41,7 +60,30 @@ struct DeviceStatus {
         u16 max_x;
         u16 max_y;
     };
-    std::optional<CalibrationData> touch_calibration;
+
+    /// Returns the current state. Never blocks.
+    State GetState() const;
+
+    /// Replaces the state. Socket thread only.
+    void SetState(const State& new_state);
+
+    /**
+     * Returns the motion status at the current time, extrapolated from the two latest samples over
+     * the time elapsed since the latest one was received, so that the emulated sensors don't lag
+     * one packet behind the device.
+     */
+    std::tuple<Math::Vec3<float>, Math::Vec3<float>> GetMotionStatus() const;
+
+    std::optional<CalibrationData> GetTouchCalibration() const;
+    void SetTouchCalibration(const CalibrationData& calibration);
+
+private:
+    /// Odd while the state is being written
+    std::atomic<u32> sequence{0};
+    State state;
+
+    /// Calibration packed as min_x, min_y, max_x, max_y from the low bits, zero when unset
+    std::atomic<u64> touch_calibration{0};
 };
 
 class Client {
@@ -15,8 +15,7 @@ class UDPTouchDevice final : public Input::TouchDevice {
 public:
     explicit UDPTouchDevice(std::shared_ptr<DeviceStatus> status_) : status(std::move(status_)) {}
     std::tuple<float, float, bool> GetStatus() const {
-        std::lock_guard<std::mutex> guard(status->update_mutex);
-        return status->touch_status;
+        return status->GetState().touch;
     }
 
 private:
@@ -27,8 +26,7 @@ class UDPMotionDevice final : public Input::MotionDevice {
 public:
     explicit UDPMotionDevice(std::shared_ptr<DeviceStatus> status_) : status(std::move(status_)) {}
     std::tuple<Math::Vec3<float>, Math::Vec3<float>> GetStatus() const {
-        std::lock_guard<std::mutex> guard(status->update_mutex);
-        return status->motion_status;
+        return status->GetMotionStatus();
     }
 
 private:
@@ -40,15 +38,11 @@ public:
     explicit UDPTouchFactory(std::shared_ptr<DeviceStatus> status_) : status(std::move(status_)) {}
 
     std::unique_ptr<Input::TouchDevice> Create(const Common::ParamPackage& params) override {
-        {
-            std::lock_guard<std::mutex> guard(status->update_mutex);
-            status->touch_calibration.emplace();
-            // These default values work well for DS4 but probably not other touch inputs
-            status->touch_calibration->min_x = params.Get("min_x", 100);
-            status->touch_calibration->min_y = params.Get("min_y", 50);
-            status->touch_calibration->max_x = params.Get("max_x", 1800);
-            status->touch_calibration->max_y = params.Get("max_y", 850);
-        }
+        // These default values work well for DS4 but probably not other touch inputs
+        status->SetTouchCalibration({static_cast<u16>(params.Get("min_x", 100)),
+                                     static_cast<u16>(params.Get("min_y", 50)),
+                                     static_cast<u16>(params.Get("max_x", 1800)),
+                                     static_cast<u16>(params.Get("max_y", 850))});
         return std::make_unique<UDPTouchDevice>(status);
     }
 
@@ -25,6 +25,10 @@ u64 ntohll(u64 x) {
 }
 #endif
 
+Packet::Packet(std::size_t capacity) {
+    data.reserve(capacity);
+}
+
 void Packet::Append(const void* in_data, std::size_t size_in_bytes) {
     if (in_data && (size_in_bytes > 0)) {
         std::size_t start = data.size();
@@ -46,6 +50,14 @@ void Packet::Clear() {
     is_valid = true;
 }
 
+void Packet::Reserve(std::size_t capacity) {
+    data.reserve(capacity);
+}
+
+std::size_t Packet::GetCapacity() const {
+    return data.capacity();
+}
+
 const void* Packet::GetData() const {
     return !data.empty() ? &data[0] : nullptr;
 }
@@ -170,6 +182,20 @@ Packet& Packet::operator>>(std::string& out_data) {
     return *this;
 }
 
+Packet& Packet::operator>>(std::vector<u8>& out_data) {
+    u32 size = 0;
+    *this >> size;
+
+    // Checked before resizing, so that a bogus size doesn't allocate
+    out_data.clear();
+    if (size > 0 && CheckSize(size)) {
+        out_data.resize(size);
+        std::memcpy(out_data.data(), &data[read_pos], size);
+        read_pos += size;
+    }
+    return *this;
+}
+
 Packet& Packet::operator<<(bool in_data) {
     *this << static_cast<u8>(in_data);
     return *this;
@@ -254,10 +280,38 @@ Packet& Packet::operator<<(const std::string& in_data) {
     return *this;
 }
 
+Packet& Packet::operator<<(const std::vector<u8>& in_data) {
+    *this << static_cast<u32>(in_data.size());
+    Append(in_data.data(), in_data.size());
+    return *this;
+}
+
 bool Packet::CheckSize(std::size_t size) {
     is_valid = is_valid && (read_pos + size <= data.size());
 
     return is_valid;
 }
 
+PacketPool::PacketPool(std::size_t capacity) : capacity(capacity) {}
+
+Packet PacketPool::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!packets.empty()) {
+            Packet packet = std::move(packets.back());
+            packets.pop_back();
+            return packet;
+        }
+    }
+    return Packet(capacity);
+}
+
+void PacketPool::Release(Packet&& packet) {
+    packet.Clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (packets.size() < MaxPooledPackets) {
+        packets.push_back(std::move(packet));
+    }
+}
+
 } // namespace Network
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <mutex>
 #include <vector>
 #include "common/common_types.h"
 
@@ -14,8 +15,15 @@ namespace Network {
 class Packet {
 public:
     Packet() = default;
+    /// Creates an empty packet that can hold capacity bytes without allocating
+    explicit Packet(std::size_t capacity);
     ~Packet() = default;
 
+    Packet(Packet&&) = default;
+    Packet& operator=(Packet&&) = default;
+    Packet(const Packet&) = default;
+    Packet& operator=(const Packet&) = default;
+
     /**
      * Append data to the end of the packet
      * @param data        Pointer to the sequence of bytes to append
@@ -32,10 +40,19 @@ public:
 
     /**
      * Clear the packet
-     * After calling Clear, the packet is empty.
+     * After calling Clear, the packet is empty. Its capacity is kept.
      */
     void Clear();
 
+    /**
+     * Makes the packet able to hold a number of bytes without allocating
+     * @param capacity The number of bytes
+     */
+    void Reserve(std::size_t capacity);
+
+    /// Returns the number of bytes the packet can hold without allocating
+    std::size_t GetCapacity() const;
+
     /**
      * Ignores bytes while reading
      * @param length THe number of bytes to ignore
@@ -78,6 +95,8 @@ public:
     Packet& operator>>(double& out_data);
     Packet& operator>>(char* out_data);
     Packet& operator>>(std::string& out_data);
+    /// Same format as the generic vector overload, but read at once
+    Packet& operator>>(std::vector<u8>& out_data);
     template <typename T>
     Packet& operator>>(std::vector<T>& out_data);
     template <typename T, std::size_t S>
@@ -97,6 +116,8 @@ public:
     Packet& operator<<(double in_data);
     Packet& operator<<(const char* in_data);
     Packet& operator<<(const std::string& in_data);
+    /// Same format as the generic vector overload, but written at once
+    Packet& operator<<(const std::vector<u8>& in_data);
     template <typename T>
     Packet& operator<<(const std::vector<T>& in_data);
     template <typename T, std::size_t S>
@@ -117,6 +138,30 @@ private:
     bool is_valid = true;     ///< Reading state of the packet
 };
 
+/**
+ * Keeps packets that have been sent, so that the buffers of the next ones are reused instead of
+ * allocated for every message. This is thread-safe.
+ */
+class PacketPool {
+public:
+    /// @param capacity The number of bytes newly created packets can hold without allocating
+    explicit PacketPool(std::size_t capacity);
+
+    /// Returns an empty packet, reusing a released one if there is any
+    Packet Acquire();
+
+    /// Gives back a packet that isn't needed anymore
+    void Release(Packet&& packet);
+
+private:
+    /// Maximum number of packets kept, as a burst of messages shouldn't pin memory forever
+    static constexpr std::size_t MaxPooledPackets = 64;
+
+    std::size_t capacity;
+    std::mutex mutex;
+    std::vector<Packet> packets;
+};
+
 template <typename T>
 Packet& Packet::operator>>(std::vector<T>& out_data) {
     // First extract the size
@@ -5,12 +5,16 @@
 #include <algorithm>
 #include <atomic>
 #include <iomanip>
+#include <iterator>
 #include <mutex>
 #include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include "common/logging/log.h"
+#include "common/thread_pool.h"
+#include "common/threadsafe_queue.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room.h"
@@ -34,6 +38,9 @@ public:
 
     std::string password; ///< The password required to connect to this room.
 
+    /// Whether the members may exchange their endpoints to send WifiPackets directly
+    bool allow_direct_connections = false;
+
     struct Member {
         std::string nickname;        ///< The nickname of the member.
         std::string console_id_hash; ///< A hash of the console ID of the member.
@@ -42,12 +49,23 @@ public:
         /// Data of the user, often including authenticated forum username.
         VerifyUser::UserData user_data;
         ENetPeer* peer; ///< The remote peer.
+        /// Whether the member asked for the endpoints of the others, to connect to them directly
+        bool direct_connections = false;
     };
     using MemberList = std::vector<Member>;
     MemberList members;              ///< Information about the members of this room
     mutable std::mutex member_mutex; ///< Mutex for locking the members list
     /// This should be a std::shared_mutex as soon as C++17 is supported
 
+    /// Indices of the members, used to forward packets without scanning or locking the members
+    /// list. Only the room thread uses them, as it is the only one modifying the list.
+    std::unordered_map<u64, ENetPeer*> peers_by_mac; ///< Peers of the members by MAC address
+    std::vector<ENetPeer*> member_peers;             ///< Peers of all the members
+
+    std::atomic<u64> forwarded_packets{0}; ///< Number of WifiPackets sent to members
+    std::atomic<u64> forwarded_bytes{0};   ///< Size of the WifiPackets sent to members
+    std::atomic<u64> dropped_packets{0};   ///< Number of WifiPackets sent to unknown addresses
+
     UsernameBanList username_ban_list; ///< List of banned usernames
     IPBanList ip_ban_list;             ///< List of banned IP addresses
     mutable std::mutex ban_list_mutex; ///< Mutex for the ban lists
@@ -61,10 +79,34 @@ public:
     /// Verification backend of the room
     std::unique_ptr<VerifyUser::Backend> verify_backend;
 
+    /// Verifies the tokens of joining clients, so that the room thread doesn't wait for it
+    std::unique_ptr<Common::ThreadPool> verify_pool;
+
+    /// A join request waiting for the verification of its token
+    struct VerifiedJoin {
+        u64 id;
+        Member member;
+    };
+    /// Joins whose token was verified, pushed by verify_pool and finished by the room thread
+    Common::SPSCQueue<VerifiedJoin> verified_joins;
+    /// Peers of the joins being verified by id, a join is dropped if its peer disconnects first.
+    /// Only the room thread uses it.
+    std::unordered_map<u64, ENetPeer*> pending_joins;
+    u64 next_join_id = 0;
+
     /// Thread function that will receive and dispatch messages until the room is destroyed.
     void ServerLoop();
     void StartLoop();
 
+    /// Handles the events that arrived, waiting up to timeout_ms for the first one.
+    void ServeEvents(u32 timeout_ms);
+
+    /// Dispatches a network event to its handler.
+    void HandleEvent(ENetEvent& event);
+
+    /// Rebuilds the member indices, must be called with member_mutex held after changing members.
+    void UpdateMemberIndices();
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the username and assigns the MAC address
@@ -72,6 +114,15 @@ public:
      */
     void HandleJoinRequest(const ENetEvent* event);
 
+    /// Adds the clients whose token was verified since the last call to the room.
+    void FinishJoinRequests();
+
+    /**
+     * Adds a verified client to the room. The room may have changed during the verification, so
+     * the checks of HandleJoinRequest are done again.
+     */
+    void FinishJoinRequest(Member member);
+
     /**
      * Parses and answers a kick request from a client.
      * Validates the permissions and that the given user exists and then kicks the member.
@@ -216,6 +267,24 @@ public:
      */
     void BroadcastRoomInformation();
 
+    /**
+     * Sends the endpoints of the members that asked for direct connections to each of them.
+     * The packet has the structure:
+     * <MessageID>IdMemberEndpoints
+     * <u32> num_members: the number of members listed
+     * This is followed by the following three values for each member:
+     * <MacAddress> mac_address of that member
+     * <u32> host of that member, as seen by the room, in network byte order
+     * <u16> port of that member, as seen by the room
+     */
+    void BroadcastMemberEndpoints();
+
+    /**
+     * Lists a member in the endpoints sent for direct connections, if the room allows them.
+     * @param event The ENet event that was received.
+     */
+    void HandleDirectConnectRequest(const ENetEvent* event);
+
     /**
      * Generates a free MAC address to assign to a new client.
      * The first 3 bytes are the NintendoOUI 0x00, 0x1F, 0x32
@@ -223,7 +292,8 @@ public:
     MacAddress GenerateMacAddress();
 
     /**
-     * Broadcasts this packet to all members except the sender.
+     * Forwards a WifiPacket, or a batch of them, to its destination, or broadcasts it to all
+     * members except the sender.
      * @param event The ENet event containing the data
      */
     void HandleWifiPacket(const ENetEvent* event);
@@ -250,52 +320,92 @@ public:
 // RoomImpl
 void Room::RoomImpl::ServerLoop() {
     while (state != State::Closed) {
-        ENetEvent event;
-        if (enet_host_service(server, &event, 50) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetGameInfo:
-                    HandleGameNamePacket(&event);
-                    break;
-                case IdWifiPacket:
-                    HandleWifiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                // Moderation
-                case IdModKick:
-                    HandleModKickPacket(&event);
-                    break;
-                case IdModBan:
-                    HandleModBanPacket(&event);
-                    break;
-                case IdModUnban:
-                    HandleModUnbanPacket(&event);
-                    break;
-                case IdModGetBanList:
-                    HandleModGetBanListPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
-                break;
-            case ENET_EVENT_TYPE_NONE:
-            case ENET_EVENT_TYPE_CONNECT:
-                break;
-            }
-        }
+        ServeEvents(50);
     }
     // Close the connection to all members:
     SendCloseMessage();
 }
 
+void Room::RoomImpl::ServeEvents(u32 timeout_ms) {
+    FinishJoinRequests();
+
+    ENetEvent event;
+    if (enet_host_service(server, &event, timeout_ms) <= 0) {
+        return;
+    }
+    HandleEvent(event);
+
+    // Handle everything that arrived meanwhile before sending, so that the packets for each
+    // member are sent together instead of as one datagram per forwarded packet
+    while (enet_host_check_events(server, &event) > 0) {
+        HandleEvent(event);
+    }
+    enet_host_flush(server);
+}
+
+void Room::RoomImpl::HandleEvent(ENetEvent& event) {
+    switch (event.type) {
+    case ENET_EVENT_TYPE_RECEIVE:
+        switch (event.packet->data[0]) {
+        case IdJoinRequest:
+            HandleJoinRequest(&event);
+            break;
+        case IdSetGameInfo:
+            HandleGameNamePacket(&event);
+            break;
+        case IdWifiPacket:
+        case IdWifiPacketBatch:
+            HandleWifiPacket(&event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(&event);
+            break;
+        case IdDirectConnectRequest:
+            HandleDirectConnectRequest(&event);
+            break;
+        // Moderation
+        case IdModKick:
+            HandleModKickPacket(&event);
+            break;
+        case IdModBan:
+            HandleModBanPacket(&event);
+            break;
+        case IdModUnban:
+            HandleModUnbanPacket(&event);
+            break;
+        case IdModGetBanList:
+            HandleModGetBanListPacket(&event);
+            break;
+        }
+        enet_packet_destroy(event.packet);
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleClientDisconnection(event.peer);
+        break;
+    case ENET_EVENT_TYPE_NONE:
+    case ENET_EVENT_TYPE_CONNECT:
+        break;
+    }
+}
+
+/// Packs a MAC address into the lower 48 bits of an integer, to key the member index with it.
+static u64 MacAddressKey(const MacAddress& address) {
+    u64 key = 0;
+    for (const u8 byte : address) {
+        key = (key << 8) | byte;
+    }
+    return key;
+}
+
+void Room::RoomImpl::UpdateMemberIndices() {
+    peers_by_mac.clear();
+    member_peers.clear();
+    for (const auto& member : members) {
+        peers_by_mac.emplace(MacAddressKey(member.mac_address), member.peer);
+        member_peers.push_back(member.peer);
+    }
+}
+
 void Room::RoomImpl::StartLoop() {
     room_thread = std::make_unique<std::thread>(&Room::RoomImpl::ServerLoop, this);
 }
@@ -360,7 +470,7 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
         return;
     }
 
-    // At this point the client is ready to be added to the room.
+    // At this point the client is ready to be added to the room, once its token is verified.
     Member member{};
     member.mac_address = preferred_mac;
     member.console_id_hash = console_id_hash;
@@ -372,7 +482,51 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
         std::lock_guard<std::mutex> lock(verify_UID_mutex);
         uid = verify_UID;
     }
-    member.user_data = verify_backend->LoadUserData(uid, token);
+
+    const u64 id = next_join_id++;
+    pending_joins.emplace(id, event->peer);
+    verify_pool->Submit([this, id, uid{std::move(uid)}, token{std::move(token)},
+                         member{std::move(member)}]() mutable {
+        member.user_data = verify_backend->LoadUserData(uid, token);
+        verified_joins.Push(VerifiedJoin{id, std::move(member)});
+    });
+}
+
+void Room::RoomImpl::FinishJoinRequests() {
+    VerifiedJoin join;
+    while (verified_joins.Pop(join)) {
+        const auto pending = pending_joins.find(join.id);
+        if (pending == pending_joins.end()) {
+            // The client disconnected during the verification
+            continue;
+        }
+        pending_joins.erase(pending);
+        FinishJoinRequest(std::move(join.member));
+    }
+}
+
+void Room::RoomImpl::FinishJoinRequest(Member member) {
+    ENetPeer* const peer = member.peer;
+    {
+        std::lock_guard<std::mutex> lock(member_mutex);
+        if (members.size() >= room_information.member_slots) {
+            SendRoomIsFull(peer);
+            return;
+        }
+    }
+    if (!IsValidNickname(member.nickname)) {
+        SendNameCollision(peer);
+        return;
+    }
+    if (!IsValidMacAddress(member.mac_address)) {
+        SendMacCollision(peer);
+        return;
+    }
+    if (!IsValidConsoleId(member.console_id_hash)) {
+        SendConsoleIdCollision(peer);
+        return;
+    }
+    const MacAddress preferred_mac = member.mac_address;
 
     {
         std::lock_guard<std::mutex> lock(ban_list_mutex);
@@ -382,17 +536,17 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
             std::find(username_ban_list.begin(), username_ban_list.end(),
                       member.user_data.username) != username_ban_list.end()) {
 
-            SendUserBanned(event->peer);
+            SendUserBanned(peer);
             return;
         }
 
         // Check IP ban
         char ip_raw[256];
-        enet_address_get_host_ip(&event->peer->address, ip_raw, sizeof(ip_raw) - 1);
+        enet_address_get_host_ip(&peer->address, ip_raw, sizeof(ip_raw) - 1);
         std::string ip = ip_raw;
 
         if (std::find(ip_ban_list.begin(), ip_ban_list.end(), ip) != ip_ban_list.end()) {
-            SendUserBanned(event->peer);
+            SendUserBanned(peer);
             return;
         }
     }
@@ -403,14 +557,15 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
     {
         std::lock_guard<std::mutex> lock(member_mutex);
         members.push_back(std::move(member));
+        UpdateMemberIndices();
     }
 
     // Notify everyone that the room information has changed.
     BroadcastRoomInformation();
-    if (HasModPermission(event->peer)) {
-        SendJoinSuccessAsMod(event->peer, preferred_mac);
+    if (HasModPermission(peer)) {
+        SendJoinSuccessAsMod(peer, preferred_mac);
     } else {
-        SendJoinSuccess(event->peer, preferred_mac);
+        SendJoinSuccess(peer, preferred_mac);
     }
 }
 
@@ -445,6 +600,7 @@ void Room::RoomImpl::HandleModKickPacket(const ENetEvent* event) {
 
         enet_peer_disconnect(target_member->peer, 0);
         members.erase(target_member);
+        UpdateMemberIndices();
     }
 
     // Announce the change to all clients.
@@ -490,6 +646,7 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
 
         enet_peer_disconnect(target_member->peer, 0);
         members.erase(target_member);
+        UpdateMemberIndices();
     }
 
     {
@@ -810,6 +967,63 @@ void Room::RoomImpl::BroadcastRoomInformation() {
     enet_host_flush(server);
 }
 
+void Room::RoomImpl::BroadcastMemberEndpoints() {
+    Packet packet;
+    packet << static_cast<u8>(IdMemberEndpoints);
+
+    std::lock_guard<std::mutex> lock(member_mutex);
+    const auto num_members = static_cast<u32>(
+        std::count_if(members.begin(), members.end(),
+                      [](const Member& member) { return member.direct_connections; }));
+    if (num_members == 0) {
+        return;
+    }
+    packet << num_members;
+    for (const auto& member : members) {
+        if (member.direct_connections) {
+            packet << member.mac_address;
+            packet << member.peer->address.host;
+            packet << member.peer->address.port;
+        }
+    }
+
+    ENetPacket* enet_packet =
+        enet_packet_create(packet.GetData(), packet.GetDataSize(), ENET_PACKET_FLAG_RELIABLE);
+    for (const auto& member : members) {
+        if (member.direct_connections) {
+            enet_peer_send(member.peer, 0, enet_packet);
+        }
+    }
+    enet_host_flush(server);
+}
+
+void Room::RoomImpl::HandleDirectConnectRequest(const ENetEvent* event) {
+    if (!allow_direct_connections) {
+        return;
+    }
+
+    // A member on the host of the room can't be reached by the others at the address the room
+    // sees, it keeps using the room
+    char ip_raw[256];
+    enet_address_get_host_ip(&event->peer->address, ip_raw, sizeof(ip_raw) - 1);
+    if (std::string(ip_raw).compare(0, 4, "127.") == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(member_mutex);
+        auto member =
+            std::find_if(members.begin(), members.end(), [event](const Member& member) -> bool {
+                return member.peer == event->peer;
+            });
+        if (member == members.end() || member->direct_connections) {
+            return;
+        }
+        member->direct_connections = true;
+    }
+    BroadcastMemberEndpoints();
+}
+
 MacAddress Room::RoomImpl::GenerateMacAddress() {
     MacAddress result_mac =
         NintendoOUI; // The first three bytes of each MAC address will be the NintendoOUI
@@ -823,42 +1037,42 @@ MacAddress Room::RoomImpl::GenerateMacAddress() {
 }
 
 void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MacAddress)); // WifiPacket Transmitter Address
+    // The destination follows the message type, the WifiPacket type and channel and the
+    // transmitter address. It is read in place, as this is by far the most frequent packet.
+    constexpr std::size_t destination_offset = 3 * sizeof(u8) + sizeof(MacAddress);
+    if (event->packet->dataLength < destination_offset + sizeof(MacAddress)) {
+        LOG_ERROR(Network, "Received a truncated WifiPacket");
+        return;
+    }
     MacAddress destination_address;
-    in_packet >> destination_address;
+    std::copy_n(event->packet->data + destination_offset, destination_address.size(),
+                destination_address.begin());
 
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    ENetPacket* enet_packet = enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
+    ENetPacket* enet_packet = enet_packet_create(event->packet->data, event->packet->dataLength,
                                                  ENET_PACKET_FLAG_RELIABLE);
 
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
-        std::lock_guard<std::mutex> lock(member_mutex);
-        bool sent_packet = false;
-        for (const auto& member : members) {
-            if (member.peer != event->peer) {
-                sent_packet = true;
-                enet_peer_send(member.peer, 0, enet_packet);
+        u64 sent_packets = 0;
+        for (ENetPeer* peer : member_peers) {
+            if (peer != event->peer) {
+                ++sent_packets;
+                enet_peer_send(peer, 0, enet_packet);
             }
         }
 
-        if (!sent_packet) {
+        if (sent_packets == 0) {
             enet_packet_destroy(enet_packet);
         }
+        forwarded_packets += sent_packets;
+        forwarded_bytes += sent_packets * event->packet->dataLength;
     } else { // Send the data only to the destination client
-        std::lock_guard<std::mutex> lock(member_mutex);
-        auto member = std::find_if(members.begin(), members.end(),
-                                   [destination_address](const Member& member) -> bool {
-                                       return member.mac_address == destination_address;
-                                   });
-        if (member != members.end()) {
-            enet_peer_send(member->peer, 0, enet_packet);
+        const auto peer = peers_by_mac.find(MacAddressKey(destination_address));
+        if (peer != peers_by_mac.end()) {
+            enet_peer_send(peer->second, 0, enet_packet);
+            ++forwarded_packets;
+            forwarded_bytes += event->packet->dataLength;
         } else {
+            ++dropped_packets;
             LOG_ERROR(Network,
                       "Attempting to send to unknown MAC address: "
                       "{:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
@@ -867,7 +1081,7 @@ void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
             enet_packet_destroy(enet_packet);
         }
     }
-    enet_host_flush(server);
+    // Flushed by the server loop once the pending events are handled
 }
 
 void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
@@ -936,8 +1150,13 @@ void Room::RoomImpl::HandleGameNamePacket(const ENetEvent* event) {
 }
 
 void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
+    for (auto it = pending_joins.begin(); it != pending_joins.end();) {
+        it = it->second == client ? pending_joins.erase(it) : std::next(it);
+    }
+
     // Remove the client from the members list.
     std::string nickname, username;
+    bool direct_connections = false;
     {
         std::lock_guard<std::mutex> lock(member_mutex);
         auto member = std::find_if(members.begin(), members.end(), [client](const Member& member) {
@@ -946,7 +1165,9 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
         if (member != members.end()) {
             nickname = member->nickname;
             username = member->user_data.username;
+            direct_connections = member->direct_connections;
             members.erase(member);
+            UpdateMemberIndices();
         }
     }
 
@@ -955,6 +1176,9 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
     if (!nickname.empty())
         SendStatusMessage(IdMemberLeave, nickname, username);
     BroadcastRoomInformation();
+    if (direct_connections) {
+        BroadcastMemberEndpoints();
+    }
 }
 
 // Room
@@ -967,7 +1191,8 @@ bool Room::Create(const std::string& name, const std::string& description,
                   const u32 max_connections, const std::string& host_username,
                   const std::string& preferred_game, u64 preferred_game_id,
                   std::unique_ptr<VerifyUser::Backend> verify_backend,
-                  const Room::BanList& ban_list, bool enable_citra_mods) {
+                  const Room::BanList& ban_list, bool enable_citra_mods, bool own_thread,
+                  bool allow_direct_connections) {
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     if (!server_address.empty()) {
@@ -992,14 +1217,39 @@ bool Room::Create(const std::string& name, const std::string& description,
     room_impl->room_information.host_username = host_username;
     room_impl->room_information.enable_citra_mods = enable_citra_mods;
     room_impl->password = password;
+    room_impl->allow_direct_connections = allow_direct_connections;
     room_impl->verify_backend = std::move(verify_backend);
+    room_impl->verify_pool = std::make_unique<Common::ThreadPool>(1);
     room_impl->username_ban_list = ban_list.first;
     room_impl->ip_ban_list = ban_list.second;
 
-    room_impl->StartLoop();
+    if (own_thread) {
+        room_impl->StartLoop();
+    }
     return true;
 }
 
+void Room::HandleEvents(const std::vector<std::shared_ptr<Room>>& rooms, u32 timeout_ms) {
+    // Wait on the sockets of all rooms at once, then let each room handle what it received.
+    // Rooms are handled even if nothing arrived, as ENet also resends and times out on service.
+    ENetSocketSet socket_set;
+    ENET_SOCKETSET_EMPTY(socket_set);
+    ENetSocket max_socket = 0;
+    for (const auto& room : rooms) {
+        if (room->GetState() == State::Open) {
+            ENET_SOCKETSET_ADD(socket_set, room->room_impl->server->socket);
+            max_socket = std::max(max_socket, room->room_impl->server->socket);
+        }
+    }
+    enet_socketset_select(max_socket, &socket_set, nullptr, timeout_ms);
+
+    for (const auto& room : rooms) {
+        if (room->GetState() == State::Open) {
+            room->room_impl->ServeEvents(0);
+        }
+    }
+}
+
 Room::State Room::GetState() const {
     return room_impl->state;
 }
@@ -1038,6 +1288,18 @@ bool Room::HasPassword() const {
     return !room_impl->password.empty();
 }
 
+Room::Statistics Room::GetStatistics() const {
+    Statistics statistics;
+    {
+        std::lock_guard<std::mutex> lock(room_impl->member_mutex);
+        statistics.member_count = static_cast<u32>(room_impl->members.size());
+    }
+    statistics.forwarded_packets = room_impl->forwarded_packets;
+    statistics.forwarded_bytes = room_impl->forwarded_bytes;
+    statistics.dropped_packets = room_impl->dropped_packets;
+    return statistics;
+}
+
 void Room::SetVerifyUID(const std::string& uid) {
     std::lock_guard<std::mutex> lock(room_impl->verify_UID_mutex);
     room_impl->verify_UID = uid;
@@ -1045,8 +1307,16 @@ void Room::SetVerifyUID(const std::string& uid) {
 
 void Room::Destroy() {
     room_impl->state = State::Closed;
-    room_impl->room_thread->join();
-    room_impl->room_thread.reset();
+    if (room_impl->room_thread) {
+        room_impl->room_thread->join();
+        room_impl->room_thread.reset();
+    } else if (room_impl->server) {
+        room_impl->SendCloseMessage();
+    }
+    // Finishes the verifications in progress, which use the backend
+    room_impl->verify_pool.reset();
+    room_impl->verified_joins.Clear();
+    room_impl->pending_joins.clear();
 
     if (room_impl->server) {
         enet_host_destroy(room_impl->server);
@@ -1056,6 +1326,7 @@ void Room::Destroy() {
     {
         std::lock_guard<std::mutex> lock(room_impl->member_mutex);
         room_impl->members.clear();
+        room_impl->UpdateMemberIndices();
     }
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
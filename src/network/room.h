@@ -13,7 +13,7 @@
 
 namespace Network {
 
-constexpr u32 network_version = 4; ///< The version of this Room and RoomMember
+constexpr u32 network_version = 5; ///< The version of this Room and RoomMember
 
 constexpr u16 DefaultRoomPort = 24872;
 
@@ -76,6 +76,17 @@ enum RoomMessageTypes : u8 {
     IdModPermissionDenied,
     IdModNoSuchUser,
     IdJoinSuccessAsMod,
+    /// Several WifiPackets from the same transmitter to the same destination. The header is laid
+    /// out as the one of IdWifiPacket, with its type and channel unused, and is followed by the
+    /// type, channel and data of each packet.
+    IdWifiPacketBatch,
+    /// A member asking for the endpoints of the other members, to exchange WifiPackets directly
+    IdDirectConnectRequest,
+    /// The MAC address, host and port of each member that asked for direct connections
+    IdMemberEndpoints,
+    /// Sent by both ends of a direct connection between members, with the MAC address of the
+    /// sender. Rooms never receive it.
+    IdDirectConnectHello,
 };
 
 /// Types of system status messages
@@ -104,6 +115,13 @@ public:
         MacAddress mac_address;   ///< The assigned mac address of the member.
     };
 
+    struct Statistics {
+        u32 member_count = 0;      ///< Number of members in the room.
+        u64 forwarded_packets = 0; ///< WifiPackets sent to members, once per receiving member.
+        u64 forwarded_bytes = 0;   ///< Size of the forwarded WifiPackets.
+        u64 dropped_packets = 0;   ///< WifiPackets addressed to no member of the room.
+    };
+
     Room();
     ~Room();
 
@@ -132,6 +150,11 @@ public:
      */
     bool HasPassword() const;
 
+    /**
+     * Gets the traffic statistics of the room since it was created.
+     */
+    Statistics GetStatistics() const;
+
     using UsernameBanList = std::vector<std::string>;
     using IPBanList = std::vector<std::string>;
 
@@ -140,6 +163,11 @@ public:
     /**
      * Creates the socket for this room. Will bind to default address if
      * server is empty string.
+     * @param own_thread Whether the room handles its events on a thread of its own. Otherwise,
+     *                   HandleEvents has to be called for it regularly.
+     * @param allow_direct_connections Whether the members may learn the addresses of each other
+     *                   to send their WifiPackets directly, the room then only relays the packets
+     *                   of the members that couldn't connect to each other.
      */
     bool Create(const std::string& name, const std::string& description = "",
                 const std::string& server = "", u16 server_port = DefaultRoomPort,
@@ -148,7 +176,15 @@ public:
                 const std::string& host_username = "", const std::string& preferred_game = "",
                 u64 preferred_game_id = 0,
                 std::unique_ptr<VerifyUser::Backend> verify_backend = nullptr,
-                const BanList& ban_list = {}, bool enable_citra_mods = false);
+                const BanList& ban_list = {}, bool enable_citra_mods = false,
+                bool own_thread = true, bool allow_direct_connections = false);
+
+    /**
+     * Handles the events of several rooms created without their own thread, waiting up to
+     * timeout_ms for one to arrive. This lets a few threads host many rooms. A room must not be
+     * handled by more than one thread at a time.
+     */
+    static void HandleEvents(const std::vector<std::shared_ptr<Room>>& rooms, u32 timeout_ms);
 
     /**
      * Sets the verification GUID of the room.
@@ -161,7 +197,8 @@ public:
     BanList GetBanList() const;
 
     /**
-     * Destroys the socket
+     * Destroys the socket. For rooms without their own thread, HandleEvents must not be running
+     * for the room anymore.
      */
     void Destroy();
 
@@ -2,12 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
-#include <list>
+#include <chrono>
+#include <cstring>
+#include <map>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <vector>
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room_member.h"
@@ -16,6 +21,18 @@ namespace Network {
 
 constexpr u32 ConnectionTimeoutMs = 5000;
 
+/// Size of the WifiPacket header: the message type, the packet type and channel and the addresses
+constexpr std::size_t WifiPacketHeaderSize = 3 * sizeof(u8) + 2 * sizeof(MacAddress);
+/// Packets are only coalesced into batches up to this size, which fits in a single UDP datagram
+constexpr std::size_t MaxWifiPacketBatchSize = 1200;
+/// Most UDS frames fit in this, so that packets rarely grow
+constexpr std::size_t DefaultPacketCapacity = 1536;
+/// A UDS network has up to 16 nodes, so a member connects directly to at most 15 others
+constexpr std::size_t MaxDirectPeers = 15;
+/// How long the member that waits for a direct connection keeps punching through its NAT
+constexpr std::chrono::seconds DirectPunchDuration{10};
+constexpr std::chrono::milliseconds DirectPunchInterval{250};
+
 class RoomMember::RoomMemberImpl {
 public:
     ENetHost* client = nullptr; ///< ENet network interface.
@@ -44,8 +61,27 @@ public:
     std::mutex network_mutex; ///< Mutex that controls access to the `client` variable.
     /// Thread that receives and dispatches network packets
     std::unique_ptr<std::thread> loop_thread;
-    std::mutex send_list_mutex;  ///< Mutex that controls access to the `send_list` variable.
-    std::list<Packet> send_list; ///< A list that stores all packets to send the async
+    std::mutex send_list_mutex;    ///< Mutex that controls access to the `send_list` variable.
+    std::vector<Packet> send_list; ///< A list that stores all packets to send the async
+    /// The packets being sent by the loop thread, swapped with `send_list` to keep it short locked
+    std::vector<Packet> sending_list;
+    PacketPool packet_pool{DefaultPacketCapacity}; ///< Buffers of the packets that were sent
+
+    /**
+     * A member the room listed for direct connections. Of each pair of members, the one with the
+     * lower MAC address connects to the other, which sends datagrams to the first meanwhile so
+     * that its NAT lets the connection in. WifiPackets go through the room until the connection
+     * is established, and for good if it fails. Only the loop thread uses these.
+     */
+    struct DirectPeer {
+        ENetAddress address{};     ///< Endpoint of the member as seen by the room
+        ENetPeer* peer = nullptr;  ///< Connection to the member, once it was attempted
+        bool connected = false;    ///< Whether the member said hello on the connection
+        bool failed = false;       ///< Whether the connection failed or was lost
+        std::chrono::steady_clock::time_point punch_end{};  ///< When to stop punching
+        std::chrono::steady_clock::time_point next_punch{}; ///< When to punch next
+    };
+    std::map<MacAddress, DirectPeer> direct_peers;
 
     template <typename T>
     using CallbackSet = std::set<CallbackHandle<T>>;
@@ -77,6 +113,12 @@ public:
      */
     void Send(Packet&& packet);
 
+    /**
+     * Sends the packets in the send list to the room. Consecutive small WifiPackets that are sent
+     * to the same destination are coalesced into batches, saving on ENet packets and datagrams.
+     */
+    void SendQueuedPackets();
+
     /**
      * Sends a request to the server, asking for permission to join a room with the specified
      * nickname and preferred mac.
@@ -107,6 +149,37 @@ public:
      */
     void HandleWifiPackets(const ENetEvent* event);
 
+    /**
+     * Extracts the WifiPackets of a batch from a received ENet packet.
+     * @param event The  ENet event that was received.
+     */
+    void HandleWifiPacketBatch(const ENetEvent* event);
+
+    /**
+     * Connects to the members listed by the room for direct connections that are new, and drops
+     * the connections to the members that aren't listed anymore.
+     * @param event The ENet event that was received.
+     */
+    void HandleMemberEndpointsPacket(const ENetEvent* event);
+
+    /**
+     * Handles an event of a direct connection to another member.
+     * @param event The ENet event that was received.
+     */
+    void HandleDirectPeerEvent(const ENetEvent* event);
+
+    /// Sends the datagrams opening the NAT to the members that are going to connect to us
+    void PunchDirectPeers();
+
+    /// Returns the member a direct connection belongs to, nullptr if it isn't used anymore
+    DirectPeer* FindDirectPeer(const ENetPeer* peer);
+
+    /**
+     * Sends a WifiPacket, or a batch of them, to its destination over the direct connections to
+     * the members if they were established, or to the room otherwise.
+     */
+    void SendWifiData(ENetPacket* enet_packet);
+
     /**
      * Extracts a chat entry from a received ENet packet and adds it to the chat queue.
      * @param event The ENet event that was received.
@@ -160,12 +233,20 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
         std::lock_guard<std::mutex> lock(network_mutex);
         ENetEvent event;
         if (enet_host_service(client, &event, 100) > 0) {
+            if (event.peer != server) {
+                HandleDirectPeerEvent(&event);
+                SendQueuedPackets();
+                continue;
+            }
             switch (event.type) {
             case ENET_EVENT_TYPE_RECEIVE:
                 switch (event.packet->data[0]) {
                 case IdWifiPacket:
                     HandleWifiPackets(&event);
                     break;
+                case IdWifiPacketBatch:
+                    HandleWifiPacketBatch(&event);
+                    break;
                 case IdChatMessage:
                     HandleChatPacket(&event);
                     break;
@@ -187,6 +268,15 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
                     } else {
                         SetState(State::Joined);
                     }
+                    {
+                        // Rooms that don't allow direct connections ignore this
+                        Packet request;
+                        request << static_cast<u8>(IdDirectConnectRequest);
+                        Send(std::move(request));
+                    }
+                    break;
+                case IdMemberEndpoints:
+                    HandleMemberEndpointsPacket(&event);
                     break;
                 case IdModBanListResponse:
                     HandleModBanListResponsePacket(&event);
@@ -244,16 +334,8 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
                 break;
             }
         }
-        {
-            std::lock_guard<std::mutex> lock(send_list_mutex);
-            for (const auto& packet : send_list) {
-                ENetPacket* enetPacket = enet_packet_create(packet.GetData(), packet.GetDataSize(),
-                                                            ENET_PACKET_FLAG_RELIABLE);
-                enet_peer_send(server, 0, enetPacket);
-            }
-            enet_host_flush(client);
-            send_list.clear();
-        }
+        PunchDirectPeers();
+        SendQueuedPackets();
     }
     Disconnect();
 };
@@ -267,6 +349,272 @@ void RoomMember::RoomMemberImpl::Send(Packet&& packet) {
     send_list.push_back(std::move(packet));
 }
 
+void RoomMember::RoomMemberImpl::SendQueuedPackets() {
+    {
+        std::lock_guard<std::mutex> lock(send_list_mutex);
+        sending_list.swap(send_list);
+    }
+    if (sending_list.empty()) {
+        return;
+    }
+
+    const auto is_small_wifi_packet = [](const Packet& packet) {
+        return packet.GetDataSize() > WifiPacketHeaderSize &&
+               packet.GetDataSize() <= MaxWifiPacketBatchSize / 2 &&
+               static_cast<const u8*>(packet.GetData())[0] == IdWifiPacket;
+    };
+    // Both are WifiPackets of this member, so this compares their destinations
+    const auto same_addresses = [](const Packet& a, const Packet& b) {
+        return std::memcmp(static_cast<const u8*>(a.GetData()) + 3,
+                           static_cast<const u8*>(b.GetData()) + 3, 2 * sizeof(MacAddress)) == 0;
+    };
+
+    for (std::size_t i = 0; i < sending_list.size();) {
+        const Packet& packet = sending_list[i];
+        std::size_t batch_end = i + 1;
+        if (is_small_wifi_packet(packet)) {
+            std::size_t batch_size = packet.GetDataSize() + 2 * sizeof(u8);
+            while (batch_end < sending_list.size() &&
+                   is_small_wifi_packet(sending_list[batch_end]) &&
+                   same_addresses(packet, sending_list[batch_end])) {
+                batch_size +=
+                    sending_list[batch_end].GetDataSize() - WifiPacketHeaderSize + 2 * sizeof(u8);
+                if (batch_size > MaxWifiPacketBatchSize) {
+                    break;
+                }
+                ++batch_end;
+            }
+        }
+
+        ENetPacket* enet_packet;
+        if (batch_end - i == 1) {
+            enet_packet = enet_packet_create(packet.GetData(), packet.GetDataSize(),
+                                             ENET_PACKET_FLAG_RELIABLE);
+        } else {
+            // Keeps the header of the first packet, then the type, channel and data of each one
+            Packet batch = packet_pool.Acquire();
+            const u8 id = IdWifiPacketBatch;
+            batch.Append(&id, sizeof(id));
+            batch.Append(static_cast<const u8*>(packet.GetData()) + 1, WifiPacketHeaderSize - 1);
+            for (std::size_t j = i; j < batch_end; ++j) {
+                const u8* data = static_cast<const u8*>(sending_list[j].GetData());
+                batch.Append(data + 1, 2 * sizeof(u8));
+                batch.Append(data + WifiPacketHeaderSize,
+                             sending_list[j].GetDataSize() - WifiPacketHeaderSize);
+            }
+            enet_packet = enet_packet_create(batch.GetData(), batch.GetDataSize(),
+                                             ENET_PACKET_FLAG_RELIABLE);
+            packet_pool.Release(std::move(batch));
+        }
+        if (packet.GetDataSize() >= WifiPacketHeaderSize &&
+            static_cast<const u8*>(packet.GetData())[0] == IdWifiPacket) {
+            SendWifiData(enet_packet);
+        } else {
+            enet_peer_send(server, 0, enet_packet);
+        }
+        i = batch_end;
+    }
+    enet_host_flush(client);
+
+    for (auto& packet : sending_list) {
+        packet_pool.Release(std::move(packet));
+    }
+    sending_list.clear();
+}
+
+void RoomMember::RoomMemberImpl::SendWifiData(ENetPacket* enet_packet) {
+    // The destination follows the message type, the WifiPacket type and channel and the
+    // transmitter address, in single packets and batches alike
+    MacAddress destination_address;
+    std::copy_n(enet_packet->data + 3 * sizeof(u8) + sizeof(MacAddress),
+                destination_address.size(), destination_address.begin());
+
+    if (destination_address != BroadcastMac) {
+        const auto it = direct_peers.find(destination_address);
+        if (it != direct_peers.end() && it->second.connected) {
+            enet_peer_send(it->second.peer, 0, enet_packet);
+        } else {
+            enet_peer_send(server, 0, enet_packet);
+        }
+        return;
+    }
+
+    // The room can't leave out the members that were already sent a broadcast directly, so
+    // broadcasts are only sent directly when every other member is connected
+    std::vector<ENetPeer*> peers;
+    for (const auto& member : member_information) {
+        if (member.mac_address == mac_address) {
+            continue;
+        }
+        const auto it = direct_peers.find(member.mac_address);
+        if (it == direct_peers.end() || !it->second.connected) {
+            enet_peer_send(server, 0, enet_packet);
+            return;
+        }
+        peers.push_back(it->second.peer);
+    }
+    if (peers.empty()) {
+        enet_peer_send(server, 0, enet_packet);
+        return;
+    }
+    for (ENetPeer* peer : peers) {
+        enet_peer_send(peer, 0, enet_packet);
+    }
+}
+
+RoomMember::RoomMemberImpl::DirectPeer* RoomMember::RoomMemberImpl::FindDirectPeer(
+    const ENetPeer* peer) {
+    const auto it = std::find_if(direct_peers.begin(), direct_peers.end(),
+                                 [peer](const auto& entry) { return entry.second.peer == peer; });
+    return it != direct_peers.end() ? &it->second : nullptr;
+}
+
+void RoomMember::RoomMemberImpl::HandleMemberEndpointsPacket(const ENetEvent* event) {
+    Packet packet;
+    packet.Append(event->packet->data, event->packet->dataLength);
+
+    // Ignore the first byte, which is the message id.
+    packet.IgnoreBytes(sizeof(u8));
+
+    std::map<MacAddress, ENetAddress> endpoints;
+    u32 num_members;
+    packet >> num_members;
+    for (u32 i = 0; i < num_members && packet; ++i) {
+        MacAddress member_mac;
+        ENetAddress address{};
+        packet >> member_mac;
+        packet >> address.host;
+        packet >> address.port;
+        if (member_mac != mac_address) {
+            endpoints.emplace(member_mac, address);
+        }
+    }
+    if (!packet) {
+        LOG_ERROR(Network, "Received malformed member endpoints");
+        return;
+    }
+
+    // Drops the members that left
+    for (auto it = direct_peers.begin(); it != direct_peers.end();) {
+        if (endpoints.count(it->first) != 0) {
+            ++it;
+            continue;
+        }
+        if (it->second.peer) {
+            enet_peer_disconnect(it->second.peer, 0);
+        }
+        it = direct_peers.erase(it);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto& [member_mac, address] : endpoints) {
+        if (direct_peers.count(member_mac) != 0 || direct_peers.size() >= MaxDirectPeers) {
+            continue;
+        }
+        DirectPeer& direct_peer = direct_peers[member_mac];
+        direct_peer.address = address;
+        if (mac_address < member_mac) {
+            direct_peer.peer = enet_host_connect(client, &direct_peer.address, NumChannels, 0);
+            direct_peer.failed = direct_peer.peer == nullptr;
+        } else {
+            direct_peer.punch_end = now + DirectPunchDuration;
+            direct_peer.next_punch = now;
+        }
+    }
+    PunchDirectPeers();
+}
+
+void RoomMember::RoomMemberImpl::PunchDirectPeers() {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto& [member_mac, direct_peer] : direct_peers) {
+        if (direct_peer.connected || direct_peer.failed || now >= direct_peer.punch_end ||
+            now < direct_peer.next_punch) {
+            continue;
+        }
+        // ENet drops datagrams this short, they only have to go through the NAT
+        u8 punch = 0;
+        ENetBuffer buffer;
+        buffer.data = &punch;
+        buffer.dataLength = sizeof(punch);
+        enet_socket_send(client->socket, &direct_peer.address, &buffer, 1);
+        direct_peer.next_punch = now + DirectPunchInterval;
+    }
+}
+
+void RoomMember::RoomMemberImpl::HandleDirectPeerEvent(const ENetEvent* event) {
+    DirectPeer* direct_peer = FindDirectPeer(event->peer);
+    switch (event->type) {
+    case ENET_EVENT_TYPE_CONNECT: {
+        // Both ends introduce themselves, the member connecting to us isn't known by its peer yet
+        Packet hello;
+        hello << static_cast<u8>(IdDirectConnectHello);
+        hello << mac_address;
+        enet_peer_send(event->peer, 0,
+                       enet_packet_create(hello.GetData(), hello.GetDataSize(),
+                                          ENET_PACKET_FLAG_RELIABLE));
+        break;
+    }
+    case ENET_EVENT_TYPE_RECEIVE:
+        switch (event->packet->data[0]) {
+        case IdDirectConnectHello: {
+            Packet packet;
+            packet.Append(event->packet->data, event->packet->dataLength);
+            packet.IgnoreBytes(sizeof(u8));
+            MacAddress member_mac;
+            packet >> member_mac;
+            // Only members of the room are accepted. The endpoints sent by the room may arrive
+            // after the member that connects to us, so it doesn't have to be listed yet.
+            const bool is_member =
+                member_mac != mac_address &&
+                std::any_of(member_information.begin(), member_information.end(),
+                            [&member_mac](const MemberInformation& member) {
+                                return member.mac_address == member_mac;
+                            });
+            auto it = direct_peers.find(member_mac);
+            if (packet && is_member && it == direct_peers.end() &&
+                direct_peers.size() < MaxDirectPeers) {
+                it = direct_peers.emplace(member_mac, DirectPeer{}).first;
+                it->second.address = event->peer->address;
+            }
+            if (!packet || it == direct_peers.end() || it->second.failed ||
+                (it->second.peer && it->second.peer != event->peer)) {
+                enet_peer_disconnect(event->peer, 0);
+                break;
+            }
+            it->second.peer = event->peer;
+            it->second.connected = true;
+            LOG_INFO(Network,
+                     "Connected directly to {:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
+                     member_mac[0], member_mac[1], member_mac[2], member_mac[3], member_mac[4],
+                     member_mac[5]);
+            break;
+        }
+        case IdWifiPacket:
+            if (direct_peer && direct_peer->connected) {
+                HandleWifiPackets(event);
+            }
+            break;
+        case IdWifiPacketBatch:
+            if (direct_peer && direct_peer->connected) {
+                HandleWifiPacketBatch(event);
+            }
+            break;
+        }
+        enet_packet_destroy(event->packet);
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        // Also reported when connecting timed out, the member's packets go through the room
+        if (direct_peer) {
+            direct_peer->peer = nullptr;
+            direct_peer->connected = false;
+            direct_peer->failed = true;
+        }
+        break;
+    case ENET_EVENT_TYPE_NONE:
+        break;
+    }
+}
+
 void RoomMember::RoomMemberImpl::SendJoinRequest(const std::string& nickname,
                                                  const std::string& console_id_hash,
                                                  const MacAddress& preferred_mac,
@@ -360,6 +708,30 @@ void RoomMember::RoomMemberImpl::HandleWifiPackets(const ENetEvent* event) {
     Invoke<WifiPacket>(wifi_packet);
 }
 
+void RoomMember::RoomMemberImpl::HandleWifiPacketBatch(const ENetEvent* event) {
+    Packet packet;
+    packet.Append(event->packet->data, event->packet->dataLength);
+
+    // Ignore the message id and the unused type and channel of the header
+    packet.IgnoreBytes(3 * sizeof(u8));
+
+    WifiPacket wifi_packet{};
+    packet >> wifi_packet.transmitter_address;
+    packet >> wifi_packet.destination_address;
+    while (packet && !packet.EndOfPacket()) {
+        u8 frame_type;
+        packet >> frame_type;
+        packet >> wifi_packet.channel;
+        packet >> wifi_packet.data;
+        if (!packet) {
+            LOG_ERROR(Network, "Received a malformed WifiPacket batch");
+            break;
+        }
+        wifi_packet.type = static_cast<WifiPacket::PacketType>(frame_type);
+        Invoke<WifiPacket>(wifi_packet);
+    }
+}
+
 void RoomMember::RoomMemberImpl::HandleChatPacket(const ENetEvent* event) {
     Packet packet;
     packet.Append(event->packet->data, event->packet->dataLength);
@@ -404,6 +776,12 @@ void RoomMember::RoomMemberImpl::HandleModBanListResponsePacket(const ENetEvent*
 }
 
 void RoomMember::RoomMemberImpl::Disconnect() {
+    for (auto& [member_mac, direct_peer] : direct_peers) {
+        if (direct_peer.peer) {
+            enet_peer_reset(direct_peer.peer);
+        }
+    }
+    direct_peers.clear();
     member_information.clear();
     room_information.member_slots = 0;
     room_information.name.clear();
@@ -419,6 +797,9 @@ void RoomMember::RoomMemberImpl::Disconnect() {
             enet_packet_destroy(event.packet); // Ignore all incoming data
             break;
         case ENET_EVENT_TYPE_DISCONNECT:
+            if (event.peer != server) {
+                break;
+            }
             server = nullptr;
             return;
         case ENET_EVENT_TYPE_NONE:
@@ -539,7 +920,8 @@ void RoomMember::Join(const std::string& nick, const std::string& console_id_has
     }
 
     if (!room_member_impl->client) {
-        room_member_impl->client = enet_host_create(nullptr, 1, NumChannels, 0, 0);
+        room_member_impl->client =
+            enet_host_create(nullptr, 1 + MaxDirectPeers, NumChannels, 0, 0);
         ASSERT_MSG(room_member_impl->client != nullptr, "Could not create client");
     }
 
@@ -576,7 +958,7 @@ bool RoomMember::IsConnected() const {
 }
 
 void RoomMember::SendWifiPacket(const WifiPacket& wifi_packet) {
-    Packet packet;
+    Packet packet = room_member_impl->packet_pool.Acquire();
     packet << static_cast<u8>(IdWifiPacket);
     packet << static_cast<u8>(wifi_packet.type);
     packet << wifi_packet.channel;
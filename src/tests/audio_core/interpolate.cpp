@@ -0,0 +1,103 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "audio_core/interpolate.h"
+
+namespace AudioCore::AudioInterp {
+
+using InterpolateFunction = void (*)(State&, StereoBuffer16&, float, StereoFrame16&,
+                                     std::size_t&);
+
+static StereoBuffer16 MakeSine(std::size_t length, double period) {
+    StereoBuffer16 buffer;
+    for (std::size_t i = 0; i < length; ++i) {
+        const auto value = static_cast<s16>(std::sin(i * 2 * 3.14159265358979 / period) * 20000);
+        buffer.push_back({value, static_cast<s16>(-value)});
+    }
+    return buffer;
+}
+
+/// Resamples all of input in frames, feeding it in chunks of at most chunk_size samples
+static std::vector<std::array<s16, 2>> Resample(InterpolateFunction function,
+                                                const StereoBuffer16& input, float rate,
+                                                std::size_t chunk_size) {
+    State state;
+    std::vector<std::array<s16, 2>> result;
+    StereoFrame16 frame;
+    std::size_t frame_position = 0;
+    for (std::size_t start = 0; start < input.size(); start += chunk_size) {
+        const std::size_t end = std::min(input.size(), start + chunk_size);
+        StereoBuffer16 chunk(input.begin() + start, input.begin() + end);
+        while (!chunk.empty()) {
+            function(state, chunk, rate, frame, frame_position);
+            if (frame_position == frame.size()) {
+                result.insert(result.end(), frame.begin(), frame.end());
+                frame_position = 0;
+            }
+        }
+    }
+    result.insert(result.end(), frame.begin(), frame.begin() + frame_position);
+    return result;
+}
+
+TEST_CASE("AudioInterp::Polyphase passes samples through at rate 1", "[audio_core]") {
+    const StereoBuffer16 input = MakeSine(1000, 37.5);
+    const auto output = Resample(Polyphase, input, 1.0f, input.size());
+
+    // Four samples of predelay
+    REQUIRE(output.size() == input.size());
+    for (std::size_t i = 0; i < 4; ++i) {
+        REQUIRE(output[i] == std::array<s16, 2>{});
+    }
+    for (std::size_t i = 4; i < output.size(); ++i) {
+        REQUIRE(output[i] == input[i - 4]);
+    }
+}
+
+TEST_CASE("AudioInterp::Polyphase keeps its state across buffers", "[audio_core]") {
+    const StereoBuffer16 input = MakeSine(5000, 91.0);
+    for (const float rate : {0.37f, 1.0f, 1.5f, 2.9f}) {
+        const auto expected = Resample(Polyphase, input, rate, input.size());
+        for (const std::size_t chunk_size : {1, 7, 160, 333}) {
+            REQUIRE(Resample(Polyphase, input, rate, chunk_size) == expected);
+        }
+    }
+}
+
+TEST_CASE("AudioInterp::Polyphase upsamples a sine with little error", "[audio_core]") {
+    constexpr double period = 20.0;
+    constexpr float rate = 0.3f;
+    const auto output = Resample(Polyphase, MakeSine(2000, period), rate, 2000);
+
+    double max_error = 0;
+    for (std::size_t i = 40; i < output.size(); ++i) {
+        // Undo the predelay of four input samples
+        const double position = i * static_cast<double>(rate) - 4;
+        const double expected = std::sin(position * 2 * 3.14159265358979 / period) * 20000;
+        max_error = std::max(max_error, std::abs(output[i][0] - expected));
+    }
+    // Linear interpolation is off by about 240 on the same signal
+    REQUIRE(max_error < 40);
+}
+
+TEST_CASE("AudioInterp[Throughput]", "[audio_core][.benchmark]") {
+    const StereoBuffer16 input = MakeSine(samples_per_frame * 1000, 123.0);
+    const std::pair<const char*, InterpolateFunction> modes[] = {
+        {"None", None}, {"Linear", Linear}, {"Polyphase", Polyphase}};
+
+    for (const auto& [name, function] : modes) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto output = Resample(function, input, 1.1f, 4096);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+        WARN(name << ": " << static_cast<double>(elapsed.count()) / output.size()
+                  << "ns per sample");
+    }
+}
+
+} // namespace AudioCore::AudioInterp
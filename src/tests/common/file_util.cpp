@@ -0,0 +1,64 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+
+namespace FileUtil {
+
+TEST_CASE("IOFile::ReadAt/WriteAt", "[common]") {
+    const std::string path = "./file_util_positional_test.bin";
+    std::vector<u8> data(10000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7);
+    }
+    {
+        IOFile file(path, "wb");
+        REQUIRE(file.WriteAt(data.data(), data.size(), 0) == data.size());
+    }
+
+    IOFile file(path, "r+b");
+    REQUIRE(file.GetSize() == data.size());
+
+    std::vector<u8> buffer(100);
+    REQUIRE(file.ReadAt(buffer.data(), buffer.size(), 5000) == buffer.size());
+    REQUIRE(std::memcmp(buffer.data(), data.data() + 5000, buffer.size()) == 0);
+
+    // Short read at the end of the file
+    REQUIRE(file.ReadAt(buffer.data(), buffer.size(), data.size() - 10) == 10);
+    REQUIRE(file.ReadAt(buffer.data(), buffer.size(), data.size()) == 0);
+
+    const std::vector<u8> patch = {1, 2, 3, 4};
+    REQUIRE(file.WriteAt(patch.data(), patch.size(), 42) == patch.size());
+    REQUIRE(file.ReadAt(buffer.data(), patch.size(), 42) == patch.size());
+    REQUIRE(std::memcmp(buffer.data(), patch.data(), patch.size()) == 0);
+
+    file.Close();
+    Delete(path);
+}
+
+TEST_CASE("MappedFile", "[common]") {
+    const std::string path = "./file_util_mapped_test.bin";
+    const std::string contents = "mapped file contents";
+    WriteStringToFile(false, contents, path.c_str());
+
+    MappedFile mapped(path);
+    REQUIRE(mapped.IsOpen());
+    REQUIRE(mapped.Size() == contents.size());
+    REQUIRE(std::memcmp(mapped.Data(), contents.data(), contents.size()) == 0);
+
+    MappedFile moved(std::move(mapped));
+    REQUIRE(!mapped.IsOpen());
+    REQUIRE(moved.IsOpen());
+    moved.Close();
+    REQUIRE(!moved.IsOpen());
+
+    REQUIRE(!MappedFile("./file_util_missing_test.bin").IsOpen());
+    Delete(path);
+}
+
+} // namespace FileUtil
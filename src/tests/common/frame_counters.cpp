@@ -0,0 +1,37 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "common/frame_counters.h"
+
+static u64 GetLastFrameValue(const std::string& name) {
+    const auto counters = Common::GetLastFrameCounters();
+    const auto it = std::find_if(counters.begin(), counters.end(),
+                                 [&name](const auto& counter) { return counter.name == name; });
+    REQUIRE(it != counters.end());
+    return it->value;
+}
+
+TEST_CASE("FrameCounter", "[common]") {
+    const Common::FrameCounter counter("Test/Events");
+    const Common::FrameCounter same_counter("Test/Events");
+    Common::EndCountersFrame();
+
+    counter.Add();
+    same_counter.Add(2);
+    // Counts of threads that already exited are kept
+    std::thread([&counter] { counter.Add(10); }).join();
+
+    Common::EndCountersFrame();
+    REQUIRE(GetLastFrameValue("Test/Events") == 13);
+
+    // Only what was counted since the previous frame is reported
+    counter.Add();
+    Common::EndCountersFrame();
+    REQUIRE(GetLastFrameValue("Test/Events") == 1);
+    Common::EndCountersFrame();
+    REQUIRE(GetLastFrameValue("Test/Events") == 0);
+}
@@ -0,0 +1,41 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include <catch2/catch.hpp>
+#include "common/memory_usage.h"
+
+namespace Common {
+
+static u64 GetUsage(MemoryCategory category) {
+    return GetMemoryUsage()[static_cast<std::size_t>(category)];
+}
+
+TEST_CASE("ScopedMemoryUsage accounts its size while it exists", "[common]") {
+    const u64 base = GetUsage(MemoryCategory::TraceBuffers);
+    {
+        ScopedMemoryUsage usage{MemoryCategory::TraceBuffers, 100};
+        REQUIRE(GetUsage(MemoryCategory::TraceBuffers) == base + 100);
+        usage.Set(40);
+        REQUIRE(GetUsage(MemoryCategory::TraceBuffers) == base + 40);
+        usage.Add(-10);
+        REQUIRE(usage.Get() == 30);
+        REQUIRE(GetUsage(MemoryCategory::TraceBuffers) == base + 30);
+    }
+    REQUIRE(GetUsage(MemoryCategory::TraceBuffers) == base);
+}
+
+TEST_CASE("ScopedMemoryUsage hands its size over when moved", "[common]") {
+    const u64 base = GetUsage(MemoryCategory::AudioBuffers);
+    ScopedMemoryUsage target{MemoryCategory::AudioBuffers, 8};
+    {
+        ScopedMemoryUsage source{MemoryCategory::AudioBuffers, 64};
+        target = std::move(source);
+        REQUIRE(GetUsage(MemoryCategory::AudioBuffers) == base + 64);
+    }
+    REQUIRE(target.Get() == 64);
+    REQUIRE(GetUsage(MemoryCategory::AudioBuffers) == base + 64);
+}
+
+} // namespace Common
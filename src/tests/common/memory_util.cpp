@@ -0,0 +1,20 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include "common/memory_util.h"
+
+TEST_CASE("AllocateMemoryPages", "[common]") {
+    // Not a multiple of the large page size
+    constexpr std::size_t SIZE = 3 * 1024 * 1024 + 4096;
+    for (const bool large_pages : {false, true}) {
+        const Common::MemoryPages pages = Common::AllocateMemoryPages(SIZE, large_pages);
+        REQUIRE(pages);
+        REQUIRE(std::all_of(pages.get(), pages.get() + SIZE, [](u8 value) { return value == 0; }));
+        pages[0] = 1;
+        pages[SIZE - 1] = 2;
+        REQUIRE(pages[SIZE - 1] == 2);
+    }
+}
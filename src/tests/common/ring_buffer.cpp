@@ -0,0 +1,54 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/ring_buffer.h"
+
+namespace Common {
+
+TEST_CASE("RingBuffer::Consume hands over the slots in order across the wrap", "[common]") {
+    RingBuffer<int, 8> buffer;
+    const std::array<int, 6> first{0, 1, 2, 3, 4, 5};
+    REQUIRE(buffer.Push(first.data(), first.size()) == 6);
+    REQUIRE(buffer.Pop(4).size() == 4);
+
+    // Fills slots 6, 7, 0, 1 and 2
+    const std::array<int, 5> second{6, 7, 8, 9, 10};
+    REQUIRE(buffer.Push(second.data(), second.size()) == 5);
+
+    std::vector<int> seen;
+    std::size_t runs = 0;
+    const std::size_t consumed = buffer.Consume(100, [&](const int* data, std::size_t count) {
+        ++runs;
+        seen.insert(seen.end(), data, data + count);
+        return count;
+    });
+    REQUIRE(consumed == 7);
+    REQUIRE(runs == 2);
+    REQUIRE(seen == std::vector<int>{4, 5, 6, 7, 8, 9, 10});
+    REQUIRE(buffer.Size() == 0);
+}
+
+TEST_CASE("RingBuffer::Consume only pops the slots used", "[common]") {
+    RingBuffer<int, 8> buffer;
+    const std::array<int, 8> values{0, 1, 2, 3, 4, 5, 6, 7};
+    buffer.Push(values.data(), values.size());
+    buffer.Pop(6);
+    buffer.Push(values.data(), 4);
+
+    std::size_t runs = 0;
+    const std::size_t consumed = buffer.Consume(5, [&](const int* data, std::size_t count) {
+        ++runs;
+        REQUIRE(data[0] == 6);
+        return std::size_t{1};
+    });
+    REQUIRE(consumed == 1);
+    REQUIRE(runs == 1);
+    REQUIRE(buffer.Size() == 5);
+    REQUIRE(buffer.Pop(1) == std::vector<int>{7});
+}
+
+} // namespace Common
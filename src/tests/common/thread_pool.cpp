@@ -0,0 +1,110 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool::ParallelFor runs every task once", "[common]") {
+    ThreadPool pool(3);
+    REQUIRE(pool.GetNumThreads() == 3);
+
+    for (std::size_t num_tasks : {0, 1, 3, 1000}) {
+        std::vector<std::atomic<int>> runs(num_tasks);
+        pool.ParallelFor(num_tasks, 4, [&](std::size_t task) { ++runs[task]; });
+        for (const auto& count : runs) {
+            REQUIRE(count == 1);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool runs tasks after their dependencies", "[common]") {
+    ThreadPool pool(4);
+
+    std::mutex mutex;
+    std::vector<int> order;
+    const auto record = [&](int value) {
+        return [&, value] {
+            std::lock_guard lock{mutex};
+            order.push_back(value);
+        };
+    };
+
+    const auto first = pool.Submit(record(0));
+    const auto second = pool.Submit(record(1), ThreadPool::Priority::Normal, {first});
+    const auto third = pool.Submit(record(1), ThreadPool::Priority::Normal, {first});
+    const auto last = pool.Submit(record(2), ThreadPool::Priority::Normal, {second, third});
+    pool.Wait(last);
+
+    REQUIRE(order == std::vector<int>{0, 1, 1, 2});
+}
+
+TEST_CASE("ThreadPool runs higher priority tasks first", "[common]") {
+    ThreadPool pool(1);
+
+    // Keeps the only worker busy while the other tasks are queued
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    pool.Submit([&] {
+        started = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    std::mutex mutex;
+    std::vector<ThreadPool::Priority> order;
+    std::vector<ThreadPool::TaskHandle> tasks;
+    for (const auto priority : {ThreadPool::Priority::Low, ThreadPool::Priority::Normal,
+                                ThreadPool::Priority::High}) {
+        tasks.push_back(pool.Submit(
+            [&, priority] {
+                std::lock_guard lock{mutex};
+                order.push_back(priority);
+            },
+            priority));
+    }
+    // Waiting for the tasks themselves would run them on this thread
+    const auto done = pool.Submit([] {}, ThreadPool::Priority::Normal, tasks);
+    release = true;
+    pool.Wait(done);
+
+    REQUIRE(order == std::vector<ThreadPool::Priority>{ThreadPool::Priority::High,
+                                                        ThreadPool::Priority::Normal,
+                                                        ThreadPool::Priority::Low});
+}
+
+TEST_CASE("ThreadPool::Wait runs a queued task on the calling thread", "[common]") {
+    ThreadPool pool(1);
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    const auto blocker = pool.Submit([&] {
+        started = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    std::thread::id runner;
+    const auto task = pool.Submit([&] { runner = std::this_thread::get_id(); });
+    pool.Wait(task);
+    REQUIRE(runner == std::this_thread::get_id());
+
+    release = true;
+    pool.Wait(blocker);
+}
+
+} // namespace Common
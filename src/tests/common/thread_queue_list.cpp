@@ -0,0 +1,49 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace Common {
+
+TEST_CASE("ThreadQueueList", "[common]") {
+    ThreadQueueList<int, 64> queue;
+    REQUIRE(queue.get_first() == 0);
+    REQUIRE(queue.pop_first() == 0);
+
+    queue.push_back(40, 1);
+    queue.push_back(63, 2);
+    queue.push_back(40, 3);
+    queue.push_front(0, 4);
+
+    SECTION("pops in priority order") {
+        REQUIRE(queue.get_first() == 4);
+        REQUIRE(queue.pop_first() == 4);
+        REQUIRE(queue.pop_first() == 1);
+        REQUIRE(queue.pop_first() == 3);
+        REQUIRE(queue.pop_first() == 2);
+        REQUIRE(queue.pop_first() == 0);
+        REQUIRE(queue.empty(40));
+    }
+
+    SECTION("only pops strictly better threads") {
+        REQUIRE(queue.pop_first_better(0) == 0);
+        REQUIRE(queue.pop_first_better(40) == 4);
+        REQUIRE(queue.pop_first_better(40) == 0);
+        REQUIRE(queue.pop_first_better(41) == 1);
+    }
+
+    SECTION("remove and move update the level bitmap") {
+        queue.remove(0, 4);
+        REQUIRE(queue.get_first() == 1);
+        queue.move(2, 63, 10);
+        REQUIRE(queue.contains(2) == 10);
+        REQUIRE(queue.empty(63));
+        REQUIRE(queue.pop_first() == 2);
+        queue.clear();
+        REQUIRE(queue.get_first() == 0);
+    }
+}
+
+} // namespace Common
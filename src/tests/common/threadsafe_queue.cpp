@@ -0,0 +1,79 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("BoundedSPSCQueue", "[common]") {
+    BoundedSPSCQueue<int, 4> queue;
+    int value;
+    REQUIRE(queue.Empty());
+    REQUIRE(!queue.Pop(value));
+
+    // Fill it twice so that the indices wrap around the ring
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(queue.TryPush(round * 4 + i));
+        }
+        REQUIRE(!queue.TryPush(-1));
+        REQUIRE(queue.Size() == 4);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(queue.Pop(value));
+            REQUIRE(value == round * 4 + i);
+        }
+        REQUIRE(queue.Empty());
+    }
+
+    SECTION("between threads") {
+        constexpr int COUNT = 100000;
+        std::thread producer([&queue] {
+            for (int i = 0; i < COUNT; ++i) {
+                queue.Push(i);
+            }
+        });
+        bool in_order = true;
+        for (int i = 0; i < COUNT; ++i) {
+            in_order &= queue.PopWait() == i;
+        }
+        producer.join();
+        REQUIRE(in_order);
+        REQUIRE(queue.Empty());
+    }
+}
+
+TEST_CASE("MPSCQueue", "[common]") {
+    constexpr int PRODUCERS = 4;
+    constexpr int COUNT = 25000;
+    MPSCQueue<int> queue;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < PRODUCERS; ++producer) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < COUNT; ++i) {
+                queue.Push(producer * COUNT + i);
+            }
+        });
+    }
+
+    // The elements of each producer are popped in the order it pushed them
+    std::array<int, PRODUCERS> next{};
+    bool in_order = true;
+    for (int i = 0; i < PRODUCERS * COUNT; ++i) {
+        const int value = queue.PopWait();
+        in_order &= value % COUNT == next[value / COUNT]++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    REQUIRE(in_order);
+    REQUIRE(queue.Empty());
+    REQUIRE(queue.Size() == 0);
+}
+
+} // namespace Common
@@ -0,0 +1,56 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/arm/idle_loop.h"
+#include "core/core.h"
+#include "tests/core/arm/arm_test_common.h"
+
+namespace ArmTests {
+
+TEST_CASE("IsIdleLoop: ARM", "[arm]") {
+    TestEnvironment test_env(false);
+    Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
+
+    // Polling a flag
+    test_env.SetMemory32(0x00, 0xE5910000); // ldr r0, [r1]
+    test_env.SetMemory32(0x04, 0xE3500000); // cmp r0, #0
+    test_env.SetMemory32(0x08, 0x0AFFFFFC); // beq 0x00
+    REQUIRE(IsIdleLoop(memory, 0x00, false));
+    REQUIRE(IsIdleLoop(memory, 0x04, false));
+
+    // Storing has side effects
+    test_env.SetMemory32(0x10, 0xE5810000); // str r0, [r1]
+    test_env.SetMemory32(0x14, 0xE3500000); // cmp r0, #0
+    test_env.SetMemory32(0x18, 0x0AFFFFFC); // beq 0x10
+    REQUIRE(!IsIdleLoop(memory, 0x10, false));
+
+    // Walking a linked list makes progress
+    test_env.SetMemory32(0x20, 0xE5911000); // ldr r1, [r1]
+    test_env.SetMemory32(0x24, 0xE3510000); // cmp r1, #0
+    test_env.SetMemory32(0x28, 0x1AFFFFFC); // bne 0x20
+    REQUIRE(!IsIdleLoop(memory, 0x20, false));
+
+    // Branching forwards doesn't loop
+    test_env.SetMemory32(0x30, 0xE5910000); // ldr r0, [r1]
+    test_env.SetMemory32(0x34, 0x0A000000); // beq 0x3C
+    REQUIRE(!IsIdleLoop(memory, 0x30, false));
+}
+
+TEST_CASE("IsIdleLoop: Thumb", "[arm]") {
+    TestEnvironment test_env(false);
+    Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
+
+    test_env.SetMemory16(0x100, 0x6808); // ldr r0, [r1]
+    test_env.SetMemory16(0x102, 0x2800); // cmp r0, #0
+    test_env.SetMemory16(0x104, 0xD0FC); // beq 0x100
+    REQUIRE(IsIdleLoop(memory, 0x100, true));
+
+    test_env.SetMemory16(0x110, 0x6808); // ldr r0, [r1]
+    test_env.SetMemory16(0x112, 0x3001); // adds r0, #1
+    test_env.SetMemory16(0x114, 0xD0FC); // beq 0x110
+    REQUIRE(!IsIdleLoop(memory, 0x110, true));
+}
+
+} // namespace ArmTests
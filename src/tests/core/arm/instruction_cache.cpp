@@ -0,0 +1,28 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/arm/skyeye_common/armstate.h"
+
+TEST_CASE("InstructionCache::InvalidateRange", "[arm]") {
+    InstructionCache cache;
+    REQUIRE(cache.InvalidateRange(0x100000, 0x1000) == 0);
+
+    cache.Insert(0x100000, 1);
+    cache.Insert(0x100FFE, 2);
+    cache.Insert(0x101000, 3);
+    cache.Insert(0x102000, 4);
+
+    // Both blocks of the first page go, even the one starting before the range
+    REQUIRE(cache.InvalidateRange(0x100800, 0x900) == 3);
+    REQUIRE(cache.Find(0x100000) == InstructionCache::INVALID_BLOCK);
+    REQUIRE(cache.Find(0x100FFE) == InstructionCache::INVALID_BLOCK);
+    REQUIRE(cache.Find(0x101000) == InstructionCache::INVALID_BLOCK);
+    REQUIRE(cache.Find(0x102000) == 4);
+
+    // Ranges reaching the end of the address space don't wrap around
+    cache.Insert(0xFFFFF000, 5);
+    REQUIRE(cache.InvalidateRange(0xFFFFF000, 0x2000) == 1);
+    REQUIRE(cache.Find(0x102000) == 4);
+}
@@ -6,7 +6,9 @@
 
 #include <array>
 #include <bitset>
+#include <chrono>
 #include <string>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -226,3 +228,121 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
 }
+
+TEST_CASE("CoreTiming[Unschedule]", "[core]") {
+    Core::Timing timing;
+
+    std::vector<u64> fired;
+    Core::TimingEventType* cb_a = timing.RegisterEvent(
+        "callbackA", [&fired](u64 userdata, s64 cycles_late) { fired.push_back(userdata); });
+    Core::TimingEventType* cb_b = timing.RegisterEvent(
+        "callbackB", [&fired](u64 userdata, s64 cycles_late) { fired.push_back(userdata + 100); });
+
+    // Enter slice 0
+    timing.Advance();
+
+    // Interleave two types and schedule them in a shuffled order so that the events end up all
+    // over the heap
+    for (u64 i = 0; i < 32; ++i) {
+        const u64 id = (i * 7) % 32;
+        timing.ScheduleEvent(100 + static_cast<s64>(id) * 10, cb_a, id);
+        timing.ScheduleEvent(105 + static_cast<s64>(id) * 10, cb_b, id);
+    }
+
+    // Take out every third event of A, all the events of B and an event that doesn't exist
+    for (u64 id = 0; id < 32; id += 3) {
+        timing.UnscheduleEvent(cb_a, id);
+    }
+    timing.UnscheduleEvent(cb_a, 1000);
+    timing.RemoveEvent(cb_b);
+
+    timing.AddTicks(timing.GetDowncount());
+    timing.Advance();
+    while (timing.GetDowncount() != MAX_SLICE_LENGTH) {
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+
+    std::vector<u64> expected;
+    for (u64 id = 0; id < 32; ++id) {
+        if (id % 3 != 0) {
+            expected.push_back(id);
+        }
+    }
+    REQUIRE(fired == expected);
+}
+
+TEST_CASE("CoreTiming[IdleUntilNextEvent]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    // The event is a few slices away, skipping lands right on it
+    timing.ScheduleEvent(MAX_SLICE_LENGTH * 2 + 500, cb_a, CB_IDS[0]);
+    REQUIRE(MAX_SLICE_LENGTH * 2 + 500 == timing.IdleUntilNextEvent());
+    REQUIRE(0 == timing.GetDowncount());
+
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+    REQUIRE(static_cast<u64>(MAX_SLICE_LENGTH * 2 + 500) == timing.GetTicks());
+}
+
+TEST_CASE("CoreTiming[CPUClock]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    // At twice the clock the CPU runs twice the cycles before the event
+    timing.SetCPUClockPercentage(200);
+    timing.ScheduleEvent(1000, cb_a, CB_IDS[0]);
+    REQUIRE(2000 == timing.GetCPUCyclesRemaining());
+    timing.AddCPUCycles(1999);
+    REQUIRE(1 == timing.GetDowncount());
+
+    // Leftover fractions of ticks add up instead of getting lost
+    timing.SetCPUClockPercentage(300);
+    timing.AddCPUCycles(2);
+    REQUIRE(1 == timing.GetDowncount());
+    timing.AddCPUCycles(1);
+    REQUIRE(0 == timing.GetDowncount());
+
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+}
+
+TEST_CASE("CoreTiming[Throughput]", "[core][.benchmark]") {
+    Core::Timing timing;
+
+    u64 fired = 0;
+    Core::TimingEventType* cb = timing.RegisterEvent(
+        "callback", [&fired](u64 userdata, s64 cycles_late) { ++fired; });
+
+    // Enter slice 0
+    timing.Advance();
+
+    // Mimics titles that keep many threads sleeping: every event is rescheduled or cancelled
+    // about as often as it fires
+    constexpr u64 NUM_THREADS = 64;
+    constexpr u64 NUM_ROUNDS = 20000;
+    const auto start = std::chrono::steady_clock::now();
+    for (u64 round = 0; round < NUM_ROUNDS; ++round) {
+        for (u64 thread = 0; thread < NUM_THREADS; ++thread) {
+            timing.UnscheduleEvent(cb, thread);
+            timing.ScheduleEvent(static_cast<s64>((thread * 37 + round) % 1000) + 1, cb, thread);
+        }
+        timing.ScheduleEventThreadsafe(500, cb, NUM_THREADS);
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    const u64 operations = NUM_ROUNDS * (NUM_THREADS * 2 + 1);
+    WARN(operations << " schedule/unschedule calls and " << fired << " callbacks in "
+                    << elapsed.count() << "us");
+    REQUIRE(fired > 0);
+}
@@ -0,0 +1,121 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/blob_archive.h"
+#include "core/file_sys/errors.h"
+
+namespace FileSys {
+
+static void WriteHostFile(const std::string& path, const std::string& contents) {
+    FileUtil::IOFile file(path, "wb");
+    file.WriteBytes(contents.data(), contents.size());
+}
+
+static std::string ReadArchiveFile(const ArchiveBackend& archive, const char* path) {
+    Mode mode{};
+    mode.read_flag.Assign(1);
+    auto file = archive.OpenFile(Path(path), mode);
+    REQUIRE(file.Succeeded());
+    std::string contents((*file)->GetSize(), '\0');
+    REQUIRE(*(*file)->Read(0, contents.size(), reinterpret_cast<u8*>(contents.data())) ==
+            contents.size());
+    return contents;
+}
+
+static u64 CountBlobs(const std::string& store_root) {
+    FileUtil::FSTEntry root;
+    FileUtil::ScanDirectoryTree(store_root, root, 1);
+    u64 count = 0;
+    for (const auto& prefix : root.children) {
+        count += prefix.children.size();
+    }
+    return count;
+}
+
+TEST_CASE("BlobArchive", "[core][file_sys]") {
+    const std::string test_dir = "./blob_archive_test/";
+    const std::string source_dir = test_dir + "source/";
+    const std::string store_root = test_dir + "store/";
+    const std::string first_mount_point = test_dir + "first/";
+    const std::string second_mount_point = test_dir + "second/";
+
+    FileUtil::CreateFullPath(source_dir + "dir/");
+    WriteHostFile(source_dir + "a", "save");
+    WriteHostFile(source_dir + "dir/b", "save");
+    WriteHostFile(source_dir + "dir/c", "other");
+
+    SECTION("Identical files are stored once") {
+        REQUIRE(BlobArchive::Import(source_dir, store_root, first_mount_point));
+        REQUIRE(BlobArchive::IsBlobArchive(first_mount_point));
+        REQUIRE(CountBlobs(store_root) == 2);
+
+        auto archive = BlobArchive::Open(first_mount_point, {});
+        REQUIRE(archive != nullptr);
+        REQUIRE(ReadArchiveFile(*archive, "/a") == "save");
+        REQUIRE(ReadArchiveFile(*archive, "/dir/b") == "save");
+        REQUIRE(ReadArchiveFile(*archive, "/dir/c") == "other");
+    }
+
+    SECTION("Writes are local to the archive") {
+        REQUIRE(BlobArchive::Import(source_dir, store_root, first_mount_point));
+        FileUtil::CreateFullPath(second_mount_point);
+        REQUIRE(FileUtil::Copy(first_mount_point + BlobArchive::MANIFEST_NAME,
+                               second_mount_point + BlobArchive::MANIFEST_NAME));
+        auto first = BlobArchive::Open(first_mount_point, {});
+        auto second = BlobArchive::Open(second_mount_point, {});
+        REQUIRE(first != nullptr);
+        REQUIRE(second != nullptr);
+
+        Mode mode{};
+        mode.read_flag.Assign(1);
+        mode.write_flag.Assign(1);
+        auto file = first->OpenFile(Path("/dir/b"), mode);
+        REQUIRE(file.Succeeded());
+        REQUIRE(*(*file)->Write(0, 4, true, reinterpret_cast<const u8*>("SAVE")) == 4);
+        (*file)->Close();
+
+        REQUIRE(ReadArchiveFile(*first, "/dir/b") == "SAVE");
+        REQUIRE(ReadArchiveFile(*first, "/a") == "save");
+        REQUIRE(ReadArchiveFile(*second, "/dir/b") == "save");
+        REQUIRE(CountBlobs(store_root) == 2);
+
+        // The modification is kept in the manifest
+        first = BlobArchive::Open(first_mount_point, {});
+        REQUIRE(first != nullptr);
+        REQUIRE(ReadArchiveFile(*first, "/dir/b") == "SAVE");
+    }
+
+    SECTION("Directories") {
+        REQUIRE(BlobArchive::Import(source_dir, store_root, first_mount_point));
+        auto archive = BlobArchive::Open(first_mount_point, {});
+        REQUIRE(archive != nullptr);
+
+        REQUIRE(archive->DeleteDirectory(Path("/dir")) == ERROR_DIRECTORY_NOT_EMPTY);
+        REQUIRE(archive->CreateDirectory(Path("/dir.new")) == RESULT_SUCCESS);
+        REQUIRE(archive->RenameDirectory(Path("/dir"), Path("/dir.new/moved")) ==
+                RESULT_SUCCESS);
+        REQUIRE(ReadArchiveFile(*archive, "/dir.new/moved/c") == "other");
+        Mode mode{};
+        mode.read_flag.Assign(1);
+        REQUIRE(archive->OpenFile(Path("/dir/c"), mode).Code() == ERROR_PATH_NOT_FOUND);
+
+        auto directory = archive->OpenDirectory(Path("/dir.new/moved"));
+        REQUIRE(directory.Succeeded());
+        std::vector<Entry> entries(4);
+        REQUIRE((*directory)->Read(static_cast<u32>(entries.size()), entries.data()) == 2);
+
+        REQUIRE(archive->DeleteDirectoryRecursively(Path("/dir.new")) == RESULT_SUCCESS);
+        auto root = archive->OpenDirectory(Path("/"));
+        REQUIRE(root.Succeeded());
+        REQUIRE((*root)->Read(static_cast<u32>(entries.size()), entries.data()) == 1);
+    }
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace FileSys
@@ -0,0 +1,64 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/compressed_rom.h"
+
+namespace FileSys {
+
+TEST_CASE("CompressedROM", "[core][file_sys]") {
+    const std::string plain_path = "./compressed_rom_test.cci";
+    const std::string compressed_path = "./compressed_rom_test.zcci";
+
+    // Mostly compressible, with a few incompressible blocks that are stored as they are
+    std::vector<u8> data(5 * 4096 + 123);
+    u32 seed = 1;
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = i >= 4096 && i < 8192 ? static_cast<u8>(seed >> 16) : static_cast<u8>(i / 100);
+    }
+    {
+        FileUtil::IOFile file(plain_path, "wb");
+        file.WriteBytes(data.data(), data.size());
+    }
+    REQUIRE(CompressedROM::Create(plain_path, compressed_path, 4096));
+
+    ROMFile plain(plain_path);
+    ROMFile compressed(compressed_path);
+    REQUIRE(!plain.IsCompressed());
+    REQUIRE(compressed.IsCompressed());
+    REQUIRE(compressed.GetSize() == data.size());
+    REQUIRE(FileUtil::GetSize(compressed_path) < data.size());
+
+    SECTION("Random access") {
+        for (const auto& [offset, length] : std::vector<std::pair<u64, std::size_t>>{
+                 {0, 16}, {4000, 200}, {4096, 4096}, {100, 3 * 4096}, {data.size() - 10, 20}}) {
+            std::vector<u8> expected(std::min<std::size_t>(length, data.size() - offset));
+            std::copy_n(data.begin() + offset, expected.size(), expected.begin());
+
+            std::vector<u8> read(length);
+            REQUIRE(compressed.Seek(offset, SEEK_SET));
+            read.resize(compressed.ReadBytes(read.data(), read.size()));
+            REQUIRE(read == expected);
+            REQUIRE(compressed.Tell() == offset + expected.size());
+        }
+    }
+
+    SECTION("Peek") {
+        FileUtil::IOFile file(compressed_path, "rb");
+        REQUIRE(CompressedROM::IsCompressedROM(file));
+        std::vector<u8> read(300);
+        REQUIRE(CompressedROM::Peek(file, 4000, read.size(), read.data()) == read.size());
+        REQUIRE(std::equal(read.begin(), read.end(), data.begin() + 4000));
+    }
+
+    FileUtil::Delete(plain_path);
+    FileUtil::Delete(compressed_path);
+}
+
+} // namespace FileSys
@@ -4,6 +4,7 @@
 
 #include <catch2/catch.hpp>
 #include "common/file_util.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 
 namespace FileSys {
@@ -35,4 +36,28 @@ TEST_CASE("PathParser - Host file system", "[core][file_sys]") {
     FileUtil::DeleteDirRecursively(test_dir);
 }
 
+TEST_CASE("PathParser - Cached host file system", "[core][file_sys]") {
+    std::string test_dir = "./test_cached";
+    FileUtil::CreateDir(test_dir);
+    FileUtil::CreateEmptyFile(test_dir + "/a");
+
+    HostMetadataCache cache;
+    REQUIRE(PathParser(Path("/a")).GetHostStatus(test_dir, cache) == PathParser::FileFound);
+    REQUIRE(PathParser(Path("/b")).GetHostStatus(test_dir, cache) == PathParser::NotFound);
+    REQUIRE(PathParser(Path("/a/c")).GetHostStatus(test_dir, cache) == PathParser::FileInPath);
+
+    // Changes are only seen once the path is invalidated
+    FileUtil::CreateDir(test_dir + "/b");
+    REQUIRE(PathParser(Path("/b")).GetHostStatus(test_dir, cache) == PathParser::NotFound);
+    cache.Invalidate(test_dir + "/b");
+    REQUIRE(PathParser(Path("/b")).GetHostStatus(test_dir, cache) == PathParser::DirectoryFound);
+    REQUIRE(cache.GetDirectory(test_dir).children.size() == 2);
+
+    FileUtil::CreateEmptyFile(test_dir + "/b/d");
+    cache.Invalidate(test_dir + "/b/../b/d");
+    REQUIRE(PathParser(Path("/b/d")).GetHostStatus(test_dir, cache) == PathParser::FileFound);
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
 } // namespace FileSys
@@ -0,0 +1,31 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/frontend/framebuffer_layout.h"
+
+namespace Layout {
+
+TEST_CASE("FramebufferLayout screen visibility", "[core]") {
+    const FramebufferLayout both = DefaultFrameLayout(400, 480, false);
+    REQUIRE(both.IsTopScreenVisible());
+    REQUIRE(both.IsBottomScreenVisible());
+
+    const FramebufferLayout top_only = SingleFrameLayout(400, 240, false);
+    REQUIRE(top_only.IsTopScreenVisible());
+    REQUIRE_FALSE(top_only.IsBottomScreenVisible());
+
+    const FramebufferLayout bottom_only = SingleFrameLayout(320, 240, true);
+    REQUIRE_FALSE(bottom_only.IsTopScreenVisible());
+    REQUIRE(bottom_only.IsBottomScreenVisible());
+
+    // Enabled, but placed outside of the window or without any pixels
+    FramebufferLayout custom{400, 240, true, true, {0, 0, 400, 240}, {400, 0, 720, 240}};
+    REQUIRE(custom.IsTopScreenVisible());
+    REQUIRE_FALSE(custom.IsBottomScreenVisible());
+    custom.top_screen = {0, 0, 0, 240};
+    REQUIRE_FALSE(custom.IsTopScreenVisible());
+}
+
+} // namespace Layout
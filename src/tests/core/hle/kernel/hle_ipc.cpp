@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -375,4 +376,80 @@ TEST_CASE("HLERequestContext::WriteToOutgoingCommandBuffer", "[core][kernel]") {
     }
 }
 
+TEST_CASE("HLERequestContext[Throughput]", "[core][kernel][.benchmark]") {
+    // HACK: see comments of member timing
+    Core::System::GetInstance().timing = std::make_unique<Core::Timing>();
+    auto memory = std::make_unique<Memory::MemorySystem>();
+    Kernel::KernelSystem kernel(*memory, 0);
+    auto session = std::get<SharedPtr<ServerSession>>(kernel.CreateSessionPair());
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    auto buffer = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE * 4);
+    VAddr target_address = 0x10000000;
+    auto result = process->vm_manager.MapBackingMemory(target_address, buffer->data(),
+                                                       buffer->size(), MemoryState::Private);
+    REQUIRE(result.Code() == RESULT_SUCCESS);
+    auto shared_memory = MakeObject(kernel);
+
+    // Shaped after the most frequent requests of games: FS::ReadFile (mapped output buffer),
+    // GSP::WriteHWRegs (static input buffer) and HID::GetIPCHandles (handles in the response)
+    const u32_le read_file[]{
+        IPC::MakeHeader(0x0802, 3, 2), 0, 0, Memory::PAGE_SIZE,
+        IPC::MappedBufferDesc(Memory::PAGE_SIZE, IPC::W), target_address,
+    };
+    const u32_le write_hw_regs[]{
+        IPC::MakeHeader(0x0001, 2, 2), 0x400000, 0x80,
+        IPC::StaticBufferDesc(0x80, 0), target_address + Memory::PAGE_SIZE,
+    };
+    const u32_le get_ipc_handles[]{IPC::MakeHeader(0x000A, 0, 0)};
+
+    std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> output{};
+    auto run_requests = [&](HLERequestContext& context, const u32_le* request) {
+        context.PopulateFromIncomingCommandBuffer(request, *process);
+        u32* cmd_buf = context.CommandBuffer();
+        if (request == get_ipc_handles) {
+            cmd_buf[0] = IPC::MakeHeader(0x000A, 1, 3);
+            cmd_buf[1] = RESULT_SUCCESS.raw;
+            cmd_buf[2] = IPC::CopyHandleDesc(2);
+            cmd_buf[3] = context.AddOutgoingHandle(shared_memory);
+            cmd_buf[4] = context.AddOutgoingHandle(nullptr);
+        } else {
+            cmd_buf[0] = IPC::MakeHeader(cmd_buf[0] >> 16, 1, 0);
+            cmd_buf[1] = RESULT_SUCCESS.raw;
+        }
+        context.WriteToOutgoingCommandBuffer(output.data(), *process);
+        if (request == get_ipc_handles) {
+            process->handle_table.Close(output[3]);
+        }
+    };
+
+    constexpr int NUM_ROUNDS = 100000;
+    const u32_le* requests[]{read_file, write_hw_regs, get_ipc_handles};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < NUM_ROUNDS; ++round) {
+        for (const u32_le* request : requests) {
+            HLERequestContext context(session);
+            run_requests(context, request);
+        }
+    }
+    const auto fresh = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    HLERequestContext pooled(session);
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < NUM_ROUNDS; ++round) {
+        for (const u32_le* request : requests) {
+            pooled.Reset(session);
+            run_requests(pooled, request);
+        }
+    }
+    const auto reused = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    WARN(NUM_ROUNDS * 3 << " requests: " << fresh.count() << "us with a new context each, "
+                        << reused.count() << "us with a reused context");
+    REQUIRE(process->vm_manager.UnmapRange(target_address, buffer->size()) == RESULT_SUCCESS);
+}
+
 } // namespace Kernel
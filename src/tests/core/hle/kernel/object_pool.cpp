@@ -0,0 +1,32 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include "core/hle/kernel/object_pool.h"
+
+namespace Kernel {
+
+TEST_CASE("ObjectPool", "[kernel]") {
+    ObjectPool pool{"Test", 40, alignof(u64)};
+
+    void* first = pool.Allocate(40);
+    void* second = pool.Allocate(40);
+    REQUIRE(first != second);
+    REQUIRE(pool.GetStats().live == 2);
+
+    // Freed objects are reused before the pool grows
+    pool.Free(first);
+    REQUIRE(pool.Allocate(40) == first);
+
+    const ObjectPool::Stats stats = pool.GetStats();
+    REQUIRE(stats.live == 2);
+    REQUIRE(stats.created == 3);
+    REQUIRE(stats.capacity >= 2);
+
+    const auto pools = ObjectPool::GetPools();
+    REQUIRE(std::find(pools.begin(), pools.end(), &pool) != pools.end());
+}
+
+} // namespace Kernel
@@ -0,0 +1,66 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hw/aes/stream.h"
+
+namespace HW::AES {
+
+namespace {
+
+const AESKey test_key{0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                      0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+const AESKey test_iv{0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08,
+                     0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00};
+
+std::vector<u8> MakeTestData(std::size_t size) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(i * 7 + 3);
+    }
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CTRDecryptor seeks like a continuous stream", "[core][aes]") {
+    const std::vector<u8> data = MakeTestData(0x1000);
+
+    std::vector<u8> whole = data;
+    CTRDecryptor(test_key, test_iv).Process(whole.data(), whole.size());
+    REQUIRE(whole != data);
+
+    CTRDecryptor decryptor(test_key, test_iv);
+    for (const std::size_t offset : {0x800, 0x13, 0x0, 0xFF1}) {
+        std::vector<u8> part(data.begin() + offset, data.begin() + offset + 0xF);
+        decryptor.Seek(offset);
+        decryptor.Process(part.data(), part.size());
+        REQUIRE(std::equal(part.begin(), part.end(), whole.begin() + offset));
+    }
+}
+
+TEST_CASE("CBCDecryptor carries split blocks between calls", "[core][aes]") {
+    const std::vector<u8> data = MakeTestData(0x200);
+
+    std::vector<u8> whole(data.size());
+    REQUIRE(CBCDecryptor(test_key, test_iv).Process(data.data(), whole.data(), data.size()) ==
+            data.size());
+
+    // Pieces that split blocks in every possible way, decrypted in place
+    CBCDecryptor decryptor(test_key, test_iv);
+    std::vector<u8> pieces;
+    std::size_t offset = 0;
+    for (std::size_t size = 1; offset < data.size(); size = size % 37 + 5) {
+        size = std::min(size, data.size() - offset);
+        std::vector<u8> buffer(size + AES_BLOCK_SIZE - 1);
+        std::copy_n(data.begin() + offset, size, buffer.begin());
+        buffer.resize(decryptor.Process(buffer.data(), buffer.data(), size));
+        pieces.insert(pieces.end(), buffer.begin(), buffer.end());
+        offset += size;
+    }
+    REQUIRE(pieces == whole);
+}
+
+} // namespace HW::AES
@@ -0,0 +1,45 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "core/memory_snapshot.h"
+
+namespace Memory {
+
+TEST_CASE("MemorySnapshot", "[core][memory]") {
+    auto memory = std::make_unique<MemorySystem>();
+    u8* fcram = memory->GetPhysicalPointer(FCRAM_PADDR);
+    u8* vram = memory->GetPhysicalPointer(VRAM_PADDR);
+    std::memset(fcram + PAGE_SIZE, 0xAB, PAGE_SIZE);
+    std::memset(vram, 0xCD, 16);
+
+    const MemorySnapshot base = MemorySnapshot::Capture(*memory);
+    REQUIRE(base.GetNewDataSize() == 2 * PAGE_SIZE);
+
+    SECTION("only copies the pages changed since the previous snapshot") {
+        fcram[3 * PAGE_SIZE] = 1;
+        const MemorySnapshot delta = MemorySnapshot::Capture(*memory, &base);
+        REQUIRE(delta.GetNewDataSize() == PAGE_SIZE);
+
+        fcram[3 * PAGE_SIZE] = 0;
+        const MemorySnapshot reverted = MemorySnapshot::Capture(*memory, &delta);
+        REQUIRE(reverted.GetNewDataSize() == 0);
+    }
+
+    SECTION("restores memory") {
+        std::memset(fcram + PAGE_SIZE, 0, PAGE_SIZE);
+        fcram[5 * PAGE_SIZE] = 1;
+        vram[0] = 0;
+
+        base.Restore(*memory);
+        REQUIRE(fcram[PAGE_SIZE] == 0xAB);
+        REQUIRE(fcram[2 * PAGE_SIZE - 1] == 0xAB);
+        REQUIRE(fcram[5 * PAGE_SIZE] == 0);
+        REQUIRE(vram[0] == 0xCD);
+    }
+}
+
+} // namespace Memory
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <vector>
 #include <catch2/catch.hpp>
 #include "core/hle/kernel/errors.h"
@@ -137,3 +138,76 @@ TEST_CASE("Memory Basics", "[kernel][memory]") {
         REQUIRE(code == RESULT_SUCCESS);
     }
 }
+
+TEST_CASE("MemoryRegionInfo keeps the allocation addresses", "[kernel][memory]") {
+    constexpr u32 base = 0x100000;
+    Kernel::MemoryRegionInfo region;
+    region.Reset(base, 16 * Memory::PAGE_SIZE);
+
+    // Linear allocations take the lowest hole that fits
+    REQUIRE(region.LinearAllocate(2 * Memory::PAGE_SIZE) == base);
+    REQUIRE(region.LinearAllocate(Memory::PAGE_SIZE) == base + 2 * Memory::PAGE_SIZE);
+    REQUIRE(region.LinearAllocate(2 * Memory::PAGE_SIZE) == base + 3 * Memory::PAGE_SIZE);
+    region.Free(base, 2 * Memory::PAGE_SIZE);
+    REQUIRE(region.LinearAllocate(3 * Memory::PAGE_SIZE) == base + 5 * Memory::PAGE_SIZE);
+    REQUIRE(region.LinearAllocate(Memory::PAGE_SIZE) == base);
+    REQUIRE_FALSE(region.LinearAllocate(base + 4 * Memory::PAGE_SIZE, Memory::PAGE_SIZE));
+    REQUIRE(region.LinearAllocate(base + 14 * Memory::PAGE_SIZE, Memory::PAGE_SIZE));
+
+    // Heap allocations take the free blocks from the top, the lowest one only partially
+    const auto blocks = region.HeapAllocate(4 * Memory::PAGE_SIZE);
+    Kernel::MemoryRegionInfo::IntervalSet expected;
+    expected += Kernel::MemoryRegionInfo::Interval(base + 11 * Memory::PAGE_SIZE,
+                                                   base + 14 * Memory::PAGE_SIZE);
+    expected += Kernel::MemoryRegionInfo::Interval(base + 15 * Memory::PAGE_SIZE,
+                                                   base + 16 * Memory::PAGE_SIZE);
+    REQUIRE(blocks == expected);
+    REQUIRE(region.used == 12 * Memory::PAGE_SIZE);
+
+    // Only the page at base + PAGE_SIZE and three below the heap blocks are left
+    REQUIRE(region.HeapAllocate(5 * Memory::PAGE_SIZE).empty());
+    REQUIRE_FALSE(region.LinearAllocate(4 * Memory::PAGE_SIZE));
+    REQUIRE(region.LinearAllocate(3 * Memory::PAGE_SIZE) == base + 8 * Memory::PAGE_SIZE);
+}
+
+TEST_CASE("VMManager[LinearHeapChurn]", "[kernel][memory][.benchmark]") {
+    constexpr u32 region_size = 64 * 1024 * 1024;
+    constexpr int iterations = 100000;
+    Kernel::MemoryRegionInfo region;
+    region.Reset(0, region_size);
+    Memory::MemorySystem memory;
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+    auto backing = std::make_unique<u8[]>(region_size);
+
+    // Fragments the region the way a long running title does, with a long lived allocation after
+    // every freed one
+    std::vector<u32> holes;
+    for (u32 i = 0; i < 1024; ++i) {
+        holes.push_back(*region.LinearAllocate(Memory::PAGE_SIZE));
+        region.LinearAllocate(2 * Memory::PAGE_SIZE);
+    }
+    for (const u32 offset : holes) {
+        region.Free(offset, Memory::PAGE_SIZE);
+    }
+
+    // Allocates and frees a buffer every frame, which doesn't fit in the holes
+    int failures = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        const u32 offset = *region.LinearAllocate(4 * Memory::PAGE_SIZE);
+        const VAddr target = Memory::LINEAR_HEAP_VADDR + offset;
+        if (manager
+                ->MapBackingMemory(target, backing.get() + offset, 4 * Memory::PAGE_SIZE,
+                                   Kernel::MemoryState::Continuous,
+                                   Kernel::VMAPermission::ReadWrite)
+                .Failed() ||
+            manager->UnmapRange(target, 4 * Memory::PAGE_SIZE).IsError()) {
+            ++failures;
+        }
+        region.Free(offset, 4 * Memory::PAGE_SIZE);
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    REQUIRE(failures == 0);
+    WARN(static_cast<double>(elapsed.count()) / iterations << "ns per allocation");
+}
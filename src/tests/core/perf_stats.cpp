@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch2/catch.hpp>
+#include "core/perf_stats.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("DurationHistogram", "[core]") {
+    Core::DurationHistogram histogram;
+
+    SECTION("empty") {
+        const auto distribution = histogram.GetAndReset();
+        REQUIRE(distribution.p50 == 0.0);
+        REQUIRE(distribution.max == 0.0);
+    }
+
+    SECTION("percentiles") {
+        // 90 frames of 1.05ms and 10 of 20.2ms
+        for (int i = 0; i < 90; ++i) {
+            histogram.Add(1050us);
+        }
+        for (int i = 0; i < 10; ++i) {
+            histogram.Add(20200us);
+        }
+
+        const auto distribution = histogram.GetAndReset();
+        REQUIRE(distribution.p50 == Approx(1.1));
+        REQUIRE(distribution.p95 == Approx(20.2));
+        REQUIRE(distribution.p99 == Approx(20.2));
+        REQUIRE(distribution.max == Approx(20.2));
+
+        // The durations are cleared after being read
+        REQUIRE(histogram.GetAndReset().max == 0.0);
+    }
+
+    SECTION("long durations are clamped to the last bucket") {
+        histogram.Add(1s);
+        const auto distribution = histogram.GetAndReset();
+        REQUIRE(distribution.p50 == Approx(100.0));
+        REQUIRE(distribution.max == Approx(1000.0));
+    }
+}
+
+TEST_CASE("PerfStats::PopFrameSample", "[core]") {
+    Core::PerfStats perf_stats;
+    Core::FrameSample sample;
+    REQUIRE(!perf_stats.PopFrameSample(sample));
+
+    perf_stats.BeginSystemFrame();
+    perf_stats.AddShaderCompile();
+    perf_stats.AddShaderCompile();
+    perf_stats.SetAudioLatency(12.5);
+    perf_stats.SetTextureCacheStats(4096, 3);
+    perf_stats.EndSystemFrame();
+
+    REQUIRE(perf_stats.PopFrameSample(sample));
+    REQUIRE(sample.shader_compiles == 2);
+    REQUIRE(sample.audio_latency_ms == Approx(12.5));
+    REQUIRE(sample.texture_cache_bytes == 4096);
+    REQUIRE(sample.texture_cache_surfaces == 3);
+    REQUIRE(!perf_stats.PopFrameSample(sample));
+
+    // The compile count is per frame, and samples are dropped once the ring is full
+    for (std::size_t i = 0; i < Core::PerfStats::FRAME_SAMPLE_CAPACITY + 10; ++i) {
+        perf_stats.BeginSystemFrame();
+        perf_stats.EndSystemFrame();
+    }
+    std::size_t popped = 0;
+    while (perf_stats.PopFrameSample(sample)) {
+        REQUIRE(sample.shader_compiles == 0);
+        ++popped;
+    }
+    REQUIRE(popped == Core::PerfStats::FRAME_SAMPLE_CAPACITY);
+}
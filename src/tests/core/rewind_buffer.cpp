@@ -0,0 +1,48 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "core/rewind_buffer.h"
+
+namespace Core {
+
+TEST_CASE("RewindBuffer", "[core]") {
+    auto memory = std::make_unique<Memory::MemorySystem>();
+    u8* fcram = memory->GetPhysicalPointer(Memory::FCRAM_PADDR);
+
+    // Room for four pages of data
+    RewindBuffer buffer(4 * Memory::PAGE_SIZE);
+
+    fcram[0] = 1;
+    fcram[Memory::PAGE_SIZE] = 1;
+    buffer.Capture(*memory, 100, 0);
+    REQUIRE(buffer.GetDataSize() == 2 * Memory::PAGE_SIZE);
+
+    fcram[0] = 2;
+    buffer.Capture(*memory, 200, 24);
+    REQUIRE(buffer.GetEntryCount() == 2);
+    REQUIRE(buffer.GetDataSize() == 3 * Memory::PAGE_SIZE);
+    REQUIRE(buffer.GetDurationTicks() == 100);
+    REQUIRE(buffer.GetEntry(0).input_position == 24);
+
+    // Goes over the budget, so the first snapshot is dropped. The page the second one shared with
+    // it is now accounted to the second one.
+    fcram[0] = 3;
+    fcram[2 * Memory::PAGE_SIZE] = 3;
+    buffer.Capture(*memory, 300, 48);
+    REQUIRE(buffer.GetEntryCount() == 2);
+    REQUIRE(buffer.GetDataSize() == 4 * Memory::PAGE_SIZE);
+    REQUIRE(buffer.GetEntry(1).ticks == 200);
+
+    buffer.GetEntry(1).memory.Restore(*memory);
+    REQUIRE(fcram[0] == 2);
+    REQUIRE(fcram[2 * Memory::PAGE_SIZE] == 0);
+
+    buffer.Clear();
+    REQUIRE(buffer.GetEntryCount() == 0);
+    REQUIRE(buffer.GetDataSize() == 0);
+}
+
+} // namespace Core
@@ -0,0 +1,42 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/settings.h"
+
+namespace Settings {
+
+TEST_CASE("Apply publishes a snapshot and notifies the affected groups", "[core]") {
+    const Snapshot& old_snapshot = GetSnapshot();
+
+    u32 resolution_changes = 0;
+    u32 shader_changes = 0;
+    const std::size_t resolution_id = AddSnapshotCallback(
+        SnapshotChange::Resolution, [&](u32, const Snapshot&) { resolution_changes++; });
+    const std::size_t shader_id = AddSnapshotCallback(
+        SnapshotChange::Shaders, [&](u32, const Snapshot&) { shader_changes++; });
+
+    values.resolution_factor = old_snapshot.resolution_factor + 1;
+    Apply();
+    REQUIRE(GetSnapshot().resolution_factor == values.resolution_factor);
+    REQUIRE(&GetSnapshot() != &old_snapshot);
+    // Readers holding the old snapshot still see the old settings
+    REQUIRE(old_snapshot.resolution_factor + 1 == values.resolution_factor);
+    REQUIRE(resolution_changes == 1);
+    REQUIRE(shader_changes == 0);
+
+    // Nothing changed
+    const Snapshot& current = GetSnapshot();
+    Apply();
+    REQUIRE(&GetSnapshot() == &current);
+    REQUIRE(resolution_changes == 1);
+
+    RemoveSnapshotCallback(resolution_id);
+    RemoveSnapshotCallback(shader_id);
+    values.resolution_factor = old_snapshot.resolution_factor;
+    Apply();
+    REQUIRE(resolution_changes == 1);
+}
+
+} // namespace Settings
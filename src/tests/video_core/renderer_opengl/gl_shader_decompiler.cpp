@@ -0,0 +1,75 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/renderer_opengl/gl_shader_decompiler.h"
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+namespace OpenGL::ShaderDecompiler {
+
+static std::optional<std::string> Decompile(std::initializer_list<nihstro::InlineAsm> code,
+                                            bool sanitize_mul = false) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    ProgramCode program_code{};
+    SwizzleData swizzle_data{};
+    std::transform(shbin.program.begin(), shbin.program.end(), program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(), swizzle_data.begin(),
+                   [](const auto& x) { return x.hex; });
+
+    return DecompileProgram(
+        program_code, swizzle_data, 0,
+        [](u32 index) { return "vs_in_reg" + std::to_string(index); },
+        [](u32 index) { return "vs_out_attr" + std::to_string(index); }, sanitize_mul, false);
+}
+
+TEST_CASE("DecompileProgram drops writes to temporaries that are never read",
+          "[video_core][opengl]") {
+    const auto shader = Decompile({
+        // clang-format off
+        {OpCode::Id::MOV, DestRegister::MakeTemporary(0), SourceRegister::MakeInput(0)},
+        {OpCode::Id::MOV, DestRegister::MakeTemporary(1), SourceRegister::MakeInput(0)},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(0), SourceRegister::MakeTemporary(0)},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    REQUIRE(shader);
+    REQUIRE(shader->find("reg_tmp0.xyzw = ") != std::string::npos);
+    REQUIRE(shader->find("reg_tmp1.xyzw = ") == std::string::npos);
+    REQUIRE(shader->find("vs_out_attr0.xyzw = ") != std::string::npos);
+}
+
+TEST_CASE("DecompileProgram only sanitizes the multiplications that can compute 0 * inf",
+          "[video_core][opengl]") {
+    const auto shader = Decompile(
+        {
+            // clang-format off
+            {OpCode::Id::MUL, DestRegister::MakeOutput(0), SourceRegister::MakeInput(0), SourceRegister::MakeInput(1)},
+            {OpCode::Id::MUL, DestRegister::MakeOutput(1), SourceRegister::MakeInput(0), SourceRegister::MakeInput(0)},
+            {OpCode::Id::SGE, DestRegister::MakeTemporary(0), SourceRegister::MakeInput(0), SourceRegister::MakeInput(1)},
+            {OpCode::Id::SLT, DestRegister::MakeTemporary(1), SourceRegister::MakeInput(0), SourceRegister::MakeInput(1)},
+            {OpCode::Id::MUL, DestRegister::MakeOutput(2), SourceRegister::MakeTemporary(0), SourceRegister::MakeTemporary(1)},
+            {OpCode::Id::MUL, DestRegister::MakeOutput(3), SourceRegister::MakeTemporary(0), SourceRegister::MakeInput(1)},
+            {OpCode::Id::END},
+            // clang-format on
+        },
+        true);
+
+    REQUIRE(shader);
+    REQUIRE(shader->find("sanitize_mul(vs_in_reg0.xyzw, vs_in_reg1.xyzw)") != std::string::npos);
+    REQUIRE(shader->find("sanitize_mul(vs_in_reg0.xyzw, vs_in_reg0.xyzw)") == std::string::npos);
+    REQUIRE(shader->find("sanitize_mul(reg_tmp0.xyzw, reg_tmp1.xyzw)") == std::string::npos);
+    REQUIRE(shader->find("sanitize_mul(reg_tmp0.xyzw, vs_in_reg1.xyzw)") != std::string::npos);
+}
+
+} // namespace OpenGL::ShaderDecompiler
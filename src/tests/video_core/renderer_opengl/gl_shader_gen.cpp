@@ -0,0 +1,81 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <catch2/catch.hpp>
+#include "video_core/regs.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace OpenGL {
+
+using Pica::TexturingRegs;
+using TevStageConfig = TexturingRegs::TevStageConfig;
+
+static void ClearRegs(Pica::Regs& regs) {
+    std::memset(&regs, 0, sizeof(regs));
+    regs.lighting.disable.Assign(1);
+}
+
+TEST_CASE("PicaFSConfig ignores unused TEV sources", "[video_core][opengl]") {
+    Pica::Regs regs_a;
+    Pica::Regs regs_b;
+    ClearRegs(regs_a);
+    ClearRegs(regs_b);
+
+    // Replace only reads its first source
+    regs_a.texturing.tev_stage0.color_source2.Assign(TevStageConfig::Source::Texture1);
+    regs_b.texturing.tev_stage0.color_source2.Assign(TevStageConfig::Source::Constant);
+    REQUIRE(PicaFSConfig::BuildFromRegs(regs_a) == PicaFSConfig::BuildFromRegs(regs_b));
+
+    regs_a.texturing.tev_stage0.color_op.Assign(TevStageConfig::Operation::Modulate);
+    regs_b.texturing.tev_stage0.color_op.Assign(TevStageConfig::Operation::Modulate);
+    REQUIRE(PicaFSConfig::BuildFromRegs(regs_a) != PicaFSConfig::BuildFromRegs(regs_b));
+
+    // Dot3_RGBA doesn't use the alpha combiner
+    regs_a.texturing.tev_stage0.color_source2.Assign(TevStageConfig::Source::Texture1);
+    regs_b.texturing.tev_stage0.color_source2.Assign(TevStageConfig::Source::Texture1);
+    regs_a.texturing.tev_stage0.color_op.Assign(TevStageConfig::Operation::Dot3_RGBA);
+    regs_b.texturing.tev_stage0.color_op.Assign(TevStageConfig::Operation::Dot3_RGBA);
+    regs_a.texturing.tev_stage0.alpha_op.Assign(TevStageConfig::Operation::Lerp);
+    regs_b.texturing.tev_stage0.alpha_source3.Assign(TevStageConfig::Source::Texture2);
+    REQUIRE(PicaFSConfig::BuildFromRegs(regs_a) == PicaFSConfig::BuildFromRegs(regs_b));
+}
+
+TEST_CASE("PicaFSConfig ignores disabled features", "[video_core][opengl]") {
+    Pica::Regs regs_a;
+    Pica::Regs regs_b;
+    ClearRegs(regs_a);
+    ClearRegs(regs_b);
+
+    regs_a.texturing.fog_flip.Assign(1);
+    regs_a.lighting.config0.bump_selector.Assign(2);
+    regs_a.texturing.shadow.bias.Assign(0x100);
+    REQUIRE(PicaFSConfig::BuildFromRegs(regs_a) == PicaFSConfig::BuildFromRegs(regs_b));
+
+    // Configuration 0 doesn't sample the distribution 1 LUT
+    regs_a.lighting.disable.Assign(0);
+    regs_b.lighting.disable.Assign(0);
+    regs_a.lighting.lut_input.d1.Assign(Pica::LightingRegs::LightingLutInput::NV);
+    REQUIRE(PicaFSConfig::BuildFromRegs(regs_a) == PicaFSConfig::BuildFromRegs(regs_b));
+}
+
+TEST_CASE("Shadow fragments without penumbra use the depth attachment", "[video_core][opengl]") {
+    Pica::Regs regs;
+    ClearRegs(regs);
+    regs.framebuffer.output_merger.fragment_operation_mode.Assign(
+        Pica::FramebufferRegs::FragmentOperationMode::Shadow);
+
+    PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
+    const std::string atomics_only = GenerateFragmentShader(config, false);
+    REQUIRE(atomics_only.find("imageAtomicCompSwap") != std::string::npos);
+    REQUIRE(atomics_only.find("gl_FragDepth") == std::string::npos);
+
+    config.state.shadow_depth_buffer = true;
+    const std::string depth_buffer = GenerateFragmentShader(config, false);
+    REQUIRE(depth_buffer.find("imageAtomicCompSwap") != std::string::npos);
+    REQUIRE(depth_buffer.find("gl_FragDepth") != std::string::npos);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,69 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/renderer_opengl/gl_texture_pack.h"
+
+namespace OpenGL {
+
+static void Write32(std::vector<u8>& file, std::size_t offset, u32 value) {
+    std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+TEST_CASE("ParseCustomTexture DDS", "[video_core][opengl]") {
+    // 8x8 BC7 with 2 levels: 4 blocks then 1 block of 16 bytes
+    std::vector<u8> file(128 + 20 + 5 * 16, 0);
+    Write32(file, 0, 0x20534444);
+    Write32(file, 4, 124);
+    Write32(file, 8, 0x20000);
+    Write32(file, 12, 8);
+    Write32(file, 16, 8);
+    Write32(file, 28, 2);
+    Write32(file, 80, 0x4);
+    Write32(file, 84, 0x30315844); // "DX10"
+    Write32(file, 128, 98);        // DXGI_FORMAT_BC7_UNORM
+    file.back() = 0x5A;
+
+    const auto texture = ParseCustomTexture(file);
+    REQUIRE(texture);
+    REQUIRE(texture->internal_format == GL_COMPRESSED_RGBA_BPTC_UNORM_ARB);
+    REQUIRE(texture->levels.size() == 2);
+    REQUIRE(texture->levels[1].width == 4);
+    REQUIRE(texture->levels[1].offset == 64);
+    REQUIRE(texture->data.size() == 80);
+    REQUIRE(texture->data.back() == 0x5A);
+
+    // Truncated data
+    file.pop_back();
+    REQUIRE(!ParseCustomTexture(file));
+}
+
+TEST_CASE("ParseCustomTexture KTX", "[video_core][opengl]") {
+    // 10x6 ASTC 8x8 with a single level of 2 blocks
+    std::vector<u8> file(64 + 4 + 32, 0);
+    const u8 identifier[] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31,
+                             0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    std::memcpy(file.data(), identifier, sizeof(identifier));
+    Write32(file, 12, 0x04030201);
+    Write32(file, 28, GL_COMPRESSED_RGBA_ASTC_8x8_KHR);
+    Write32(file, 36, 10);
+    Write32(file, 40, 6);
+    Write32(file, 52, 1);
+    Write32(file, 56, 1);
+    Write32(file, 64, 32);
+
+    const auto texture = ParseCustomTexture(file);
+    REQUIRE(texture);
+    REQUIRE(texture->internal_format == GL_COMPRESSED_RGBA_ASTC_8x8_KHR);
+    REQUIRE(texture->levels.size() == 1);
+    REQUIRE(texture->data.size() == 32);
+
+    // Uncompressed textures aren't uploaded as they are
+    Write32(file, 16, GL_UNSIGNED_BYTE);
+    REQUIRE(!ParseCustomTexture(file));
+}
+
+} // namespace OpenGL
@@ -89,3 +89,28 @@ TEST_CASE("EX2", "[video_core][shader][shader_jit]") {
     REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
     REQUIRE(std::isinf(shader.Run(800.f)));
 }
+
+TEST_CASE("DP4", "[video_core][shader][shader_jit]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader = ShaderTest({
+        // clang-format off
+        {OpCode::Id::DP4, sh_output, sh_input, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    const auto run = [&shader](float x, float y, float z, float w) {
+        Pica::Shader::ShaderSetup shader_setup;
+        Pica::Shader::UnitState shader_unit;
+        shader_unit.registers.input[0] = {float24::FromFloat32(x), float24::FromFloat32(y),
+                                          float24::FromFloat32(z), float24::FromFloat32(w)};
+        shader.shader->Run(shader_setup, shader_unit, 0);
+        return shader_unit.registers.output[0].x.ToFloat32();
+    };
+
+    REQUIRE(run(1.f, 2.f, 3.f, 4.f) == Approx(30.f));
+    REQUIRE(run(-1.f, 0.f, 0.f, 0.5f) == Approx(1.25f));
+    REQUIRE(std::isinf(run(INFINITY, 0.f, 0.f, 0.f)));
+}
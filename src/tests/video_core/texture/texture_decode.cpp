@@ -0,0 +1,53 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <catch2/catch.hpp>
+#include "video_core/texture/texture_decode.h"
+
+using Pica::TexturingRegs;
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+TEST_CASE("DecodeTile matches LookupTexelInTile", "[video_core][texture]") {
+    constexpr std::array<TextureFormat, 14> formats{
+        TextureFormat::RGBA8, TextureFormat::RGB8, TextureFormat::RGB5A1, TextureFormat::RGB565,
+        TextureFormat::RGBA4, TextureFormat::IA8,  TextureFormat::RG8,    TextureFormat::I8,
+        TextureFormat::A8,    TextureFormat::IA4,  TextureFormat::I4,     TextureFormat::A4,
+        TextureFormat::ETC1,  TextureFormat::ETC1A4,
+    };
+
+    std::mt19937 rng(1234);
+    std::array<u8, 8 * 8 * 4> tile;
+
+    for (const auto format : formats) {
+        for (int iteration = 0; iteration < 16; ++iteration) {
+            for (auto& byte : tile) {
+                byte = static_cast<u8>(rng());
+            }
+
+            Pica::Texture::TextureInfo info{};
+            info.width = 8;
+            info.height = 8;
+            info.format = format;
+            info.SetDefaultStride();
+
+            std::array<u8, 8 * 8 * 4> decoded{};
+            Pica::Texture::DecodeTile(tile.data(), format, decoded.data(), 8 * 4);
+
+            for (unsigned int y = 0; y < 8; ++y) {
+                for (unsigned int x = 0; x < 8; ++x) {
+                    const auto expected =
+                        Pica::Texture::LookupTexelInTile(tile.data(), x, y, info, false);
+                    const u8* texel = &decoded[(x + 8 * y) * 4];
+                    INFO("format " << static_cast<int>(format) << " texel " << x << "," << y);
+                    REQUIRE(texel[0] == expected.r());
+                    REQUIRE(texel[1] == expected.g());
+                    REQUIRE(texel[2] == expected.b());
+                    REQUIRE(texel[3] == expected.a());
+                }
+            }
+        }
+    }
+}
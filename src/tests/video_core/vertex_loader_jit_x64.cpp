@@ -0,0 +1,79 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstddef>
+#include <catch2/catch.hpp>
+#include "common/x64/cpu_detect.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+using float24 = Pica::float24;
+using Format = Pica::PipelineRegs::VertexAttributeFormat;
+using VertexLoaderJit = Pica::VertexLoaderJit;
+
+TEST_CASE("VertexLoaderJit", "[video_core][vertex_loader]") {
+    if (!Common::GetCPUCaps().sse4_1) {
+        return;
+    }
+
+    // Two vertices of: float x3, byte x3, ubyte x2, short x1
+    struct Vertex {
+        float position[3];
+        s8 normal[3];
+        u8 uv[2];
+        s16 weight;
+    };
+    const std::array<Vertex, 2> vertices{{
+        {{1.5f, -2.f, 3.25f}, {-128, 0, 127}, {255, 7}, -32768},
+        {{-0.5f, 8.f, 0.f}, {1, -1, 2}, {0, 128}, 1234},
+    }};
+    const u32 stride = static_cast<u32>(sizeof(Vertex));
+    const u8* base = reinterpret_cast<const u8*>(vertices.data());
+
+    VertexLoaderJit::Layout layout{};
+    layout.num_total_attributes = 6;
+    layout.attributes[0] = {3, Format::FLOAT, stride, false};
+    layout.attributes[1] = {3, Format::BYTE, stride, false};
+    layout.attributes[2] = {2, Format::UBYTE, stride, false};
+    layout.attributes[3] = {1, Format::SHORT, stride, false};
+    layout.attributes[4] = {0, Format::BYTE, 0, true};
+    layout.attributes[5] = {0, Format::BYTE, 0, false};
+
+    std::array<const u8*, 16> sources{};
+    sources[0] = base + offsetof(Vertex, position);
+    sources[1] = base + offsetof(Vertex, normal);
+    sources[2] = base + offsetof(Vertex, uv);
+    sources[3] = base + offsetof(Vertex, weight);
+
+    Pica::Shader::AttributeBuffer defaults{};
+    defaults.attr[4] = Math::MakeVec(float24::FromFloat32(4.f), float24::FromFloat32(3.f),
+                                     float24::FromFloat32(2.f), float24::FromFloat32(1.f));
+
+    const VertexLoaderJit loader(layout);
+    Pica::Shader::AttributeBuffer input{};
+    input.attr[5].x = float24::FromFloat32(42.f);
+
+    const auto check = [&input](int attr, float x, float y, float z, float w) {
+        REQUIRE(input.attr[attr].x.ToFloat32() == x);
+        REQUIRE(input.attr[attr].y.ToFloat32() == y);
+        REQUIRE(input.attr[attr].z.ToFloat32() == z);
+        REQUIRE(input.attr[attr].w.ToFloat32() == w);
+    };
+
+    loader.Load(sources.data(), 0, input, defaults);
+    check(0, 1.5f, -2.f, 3.25f, 1.f);
+    check(1, -128.f, 0.f, 127.f, 1.f);
+    check(2, 255.f, 7.f, 0.f, 1.f);
+    check(3, -32768.f, 0.f, 0.f, 1.f);
+    check(4, 4.f, 3.f, 2.f, 1.f);
+    // Attributes that are neither loaded nor default are left untouched
+    check(5, 42.f, 0.f, 0.f, 0.f);
+
+    loader.Load(sources.data(), 1, input, defaults);
+    check(0, -0.5f, 8.f, 0.f, 1.f);
+    check(1, 1.f, -1.f, 2.f, 1.f);
+    check(2, 0.f, 128.f, 0.f, 1.f);
+    check(3, 1234.f, 0.f, 0.f, 1.f);
+}
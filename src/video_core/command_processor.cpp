@@ -2,20 +2,28 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/primitive_assembly.h"
@@ -49,6 +57,18 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/// Vertices shaded by one task of the vertex workers, smaller draws are shaded serially
+constexpr u32 VERTEX_CHUNK_SIZE = 256;
+
+/// Threads shading the vertices of large draws, including the calling one
+static unsigned GetNumVertexThreads(const Settings::Snapshot& settings) {
+    const unsigned num_threads = settings.vertex_shader_threads;
+    if (num_threads == 0) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+    return num_threads;
+}
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -119,6 +139,52 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/// Shades the batched immediate mode vertices and sends them to the geometry pipeline
+static void FlushImmediateVertices() {
+    auto& immediate = g_state.immediate;
+    if (immediate.batch_size == 0)
+        return;
+
+    MICROPROFILE_SCOPE(GPU_Drawing);
+    const auto& regs = g_state.regs;
+
+    Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
+
+    auto* shader_engine = Shader::GetEngine();
+    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+
+    std::array<Shader::UnitState, State::ImmediateModeState::MAX_BATCH_SIZE> shader_units;
+    for (std::size_t i = 0; i < immediate.batch_size; ++i) {
+        // Send to vertex shader
+        if (g_debug_context)
+            g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                     static_cast<void*>(&immediate.batch[i]));
+        shader_units[i].LoadInput(regs.vs, immediate.batch[i]);
+    }
+    shader_engine->RunBatch(g_state.vs, shader_units.data(), immediate.batch_size);
+
+    // Send to geometry pipeline
+    if (immediate.reset_geometry_pipeline) {
+        g_state.geometry_pipeline.Reconfigure();
+        immediate.reset_geometry_pipeline = false;
+    }
+    ASSERT(!g_state.geometry_pipeline.NeedIndexInput());
+    g_state.geometry_pipeline.Setup(shader_engine);
+    for (std::size_t i = 0; i < immediate.batch_size; ++i) {
+        Shader::AttributeBuffer output{};
+        shader_units[i].WriteOutput(regs.vs, output);
+        g_state.geometry_pipeline.SubmitVertex(output);
+    }
+    immediate.batch_size = 0;
+
+    // The rasterizer batches the triangles and only draws them once a drawing config register
+    // changes
+    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+    if (g_debug_context) {
+        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
+    }
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -130,12 +196,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         return;
     }
 
+    // Batched immediate mode vertices are shaded with the register state they were submitted with
+    if (id < PICA_REG_INDEX_WORKAROUND(pipeline.vs_default_attributes_setup.set_value[0], 0x233) ||
+        id > PICA_REG_INDEX_WORKAROUND(pipeline.vs_default_attributes_setup.set_value[2], 0x235)) {
+        FlushImmediateVertices();
+    }
+
     // TODO: Figure out how register masking acts on e.g. vs.uniform_setup.set_value
     u32 old_value = regs.reg_array[id];
 
     const u32 write_mask = expand_bits_to_bytes[mask];
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
 
-    regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+    // Give the rasterizer a chance to submit draws it batched with the previous register state
+    VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanging(id, new_value);
+
+    regs.reg_array[id] = new_value;
 
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
@@ -149,7 +225,12 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        if (VideoCore::g_gpu_thread) {
+            // The kernel may only be touched from the emulation thread
+            Service::GSP::SignalInterruptThreadsafe(Service::GSP::InterruptId::P3D);
+        } else {
+            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        }
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -219,42 +300,14 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 if (immediate_attribute_id < regs.pipeline.max_input_attrib_index) {
                     immediate_attribute_id += 1;
                 } else {
-                    MICROPROFILE_SCOPE(GPU_Drawing);
                     immediate_attribute_id = 0;
 
-                    Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
-
-                    auto* shader_engine = Shader::GetEngine();
-                    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
-
-                    // Send to vertex shader
-                    if (g_debug_context)
-                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                                 static_cast<void*>(&immediate_input));
-                    Shader::UnitState shader_unit;
-                    Shader::AttributeBuffer output{};
-
-                    shader_unit.LoadInput(regs.vs, immediate_input);
-                    shader_engine->Run(g_state.vs, shader_unit);
-                    shader_unit.WriteOutput(regs.vs, output);
-
-                    // Send to geometry pipeline
-                    if (g_state.immediate.reset_geometry_pipeline) {
-                        g_state.geometry_pipeline.Reconfigure();
-                        g_state.immediate.reset_geometry_pipeline = false;
-                    }
-                    ASSERT(!g_state.geometry_pipeline.NeedIndexInput());
-                    g_state.geometry_pipeline.Setup(shader_engine);
-                    g_state.geometry_pipeline.SubmitVertex(output);
-
-                    // TODO: If drawing after every immediate mode triangle kills performance,
-                    // change it to flush triangles whenever a drawing config register changes
-                    // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-                    if (g_debug_context) {
-                        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
-                                                 nullptr);
-                    }
+                    // The vertex is shaded with the next ones, once the batch is full or another
+                    // register is written
+                    auto& immediate = g_state.immediate;
+                    immediate.batch[immediate.batch_size++] = immediate_input;
+                    if (immediate.batch_size == immediate.MAX_BATCH_SIZE)
+                        FlushImmediateVertices();
                 }
             }
         }
@@ -288,8 +341,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
         PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = g_state.primitive_assembler;
+        // The same settings for the whole draw, even if they change meanwhile
+        const Settings::Snapshot& settings = Settings::GetSnapshot();
 
-        bool accelerate_draw = VideoCore::g_hw_shader_enabled && primitive_assembler.IsEmpty();
+        bool accelerate_draw = settings.use_hw_shader && primitive_assembler.IsEmpty();
 
         if (regs.pipeline.use_gs == PipelineRegs::UseGS::No) {
             auto topology = primitive_assembler.GetTopology();
@@ -304,7 +359,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             // this, so this is left unimplemented for now. Revisit this when an issue is found in
             // games.
         } else {
-            if (VideoCore::g_hw_shader_accurate_gs) {
+            if (settings.shaders_accurate_gs) {
                 accelerate_draw = false;
             }
         }
@@ -313,12 +368,18 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         if (accelerate_draw &&
             VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed)) {
+            Core::System::GetInstance().perf_stats.AddPicaDraw(true);
             if (g_debug_context) {
                 g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
             }
             break;
         }
 
+        if (settings.use_hw_shader) {
+            // Count how often the configuration is not supported by the hardware vertex path
+            Core::System::GetInstance().perf_stats.AddPicaDraw(false);
+        }
+
         // Processes information about internal vertex attributes to figure out how a vertex is
         // loaded.
         // Later, these can be compiled and cached.
@@ -351,18 +412,27 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
+        // Direct-mapped post-transform vertex cache, indexed by the low bits of the vertex index.
+        // It only lives for one draw, the shader and its inputs may change between draws.
+        constexpr std::size_t VERTEX_CACHE_SIZE = 128;
         std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
+        std::array<unsigned int, VERTEX_CACHE_SIZE> vertex_cache_ids;
         std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
+        u32 vertex_cache_hits = 0;
+        u32 vertex_cache_misses = 0;
+
+        // Vertices are shaded in batches to amortize the cost of invoking the shader engine. The
+        // outputs of a batch are submitted in draw order once all of its vertices have run.
+        constexpr std::size_t VS_BATCH_SIZE = 8;
+        constexpr std::size_t NO_INVOCATION = VS_BATCH_SIZE;
+        std::array<Shader::UnitState, VS_BATCH_SIZE> shader_units;
+        std::array<Shader::AttributeBuffer, VS_BATCH_SIZE> shader_outputs;
+        std::array<unsigned int, VS_BATCH_SIZE> shader_vertices;
+        // Invocation that produces each submitted vertex, NO_INVOCATION for vertex cache hits
+        std::array<std::size_t, VS_BATCH_SIZE> submit_invocations;
+        std::array<const Shader::AttributeBuffer*, VS_BATCH_SIZE> submit_cached_outputs;
 
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
@@ -371,36 +441,136 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
-
-            bool vertex_cache_hit = false;
+        unsigned int index = 0;
+
+        // Large draws are split into chunks shaded on the vertex workers, each with its own loader
+        // and vertex cache, and the outputs are submitted in draw order afterwards. The debugger
+        // sees every vertex and memory access, so its draws are always shaded serially.
+        const unsigned num_vertex_threads = GetNumVertexThreads(settings);
+        if (num_vertex_threads > 1 && !g_debug_context &&
+            regs.pipeline.num_vertices >= 2 * VERTEX_CHUNK_SIZE &&
+            !g_state.geometry_pipeline.NeedIndexInput()) {
+            const u32 num_vertices = regs.pipeline.num_vertices;
+            static std::vector<Shader::AttributeBuffer> outputs;
+            outputs.resize(num_vertices);
+            std::atomic<u32> chunk_cache_hits{0};
+            std::atomic<u32> chunk_cache_misses{0};
+
+            const std::size_t num_chunks =
+                (num_vertices + VERTEX_CHUNK_SIZE - 1) / VERTEX_CHUNK_SIZE;
+            auto& thread_pool = Common::GetThreadPool();
+            thread_pool.ParallelFor(num_chunks, num_vertex_threads, [&](std::size_t chunk) {
+                VertexLoader chunk_loader = loader;
+                DebugUtils::MemoryAccessTracker chunk_accesses;
+                std::array<Shader::UnitState, VS_BATCH_SIZE> units;
+                std::array<u32, VS_BATCH_SIZE> unit_indices;
+                std::size_t num_units = 0;
+                // Direct-mapped cache of the indices in outputs holding each shaded vertex
+                std::array<bool, VERTEX_CACHE_SIZE> cache_valid{};
+                std::array<unsigned int, VERTEX_CACHE_SIZE> cache_ids;
+                std::array<u32, VERTEX_CACHE_SIZE> cache_indices;
+                u32 hits = 0;
+
+                const auto run_units = [&] {
+                    shader_engine->RunBatch(g_state.vs, units.data(), num_units);
+                    for (std::size_t i = 0; i < num_units; ++i) {
+                        const u32 output = unit_indices[i];
+                        units[i].WriteOutput(regs.vs, outputs[output]);
+                        if (is_indexed) {
+                            const unsigned int vertex = index_u16 ? index_address_16[output]
+                                                                  : index_address_8[output];
+                            const std::size_t slot = vertex % VERTEX_CACHE_SIZE;
+                            cache_valid[slot] = true;
+                            cache_ids[slot] = vertex;
+                            cache_indices[slot] = output;
+                        }
+                    }
+                    num_units = 0;
+                };
+
+                const u32 begin = static_cast<u32>(chunk * VERTEX_CHUNK_SIZE);
+                const u32 end = std::min(begin + VERTEX_CHUNK_SIZE, num_vertices);
+                for (u32 i = begin; i < end; ++i) {
+                    const unsigned int vertex =
+                        is_indexed ? (index_u16 ? index_address_16[i] : index_address_8[i])
+                                   : (i + regs.pipeline.vertex_offset);
+
+                    if (is_indexed) {
+                        const std::size_t slot = vertex % VERTEX_CACHE_SIZE;
+                        if (cache_valid[slot] && cache_ids[slot] == vertex) {
+                            ++hits;
+                            outputs[i] = outputs[cache_indices[slot]];
+                            continue;
+                        }
+                    }
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+                    Shader::AttributeBuffer input;
+                    chunk_loader.LoadVertex(base_address, i, vertex, input, chunk_accesses);
+                    units[num_units].LoadInput(regs.vs, input);
+                    unit_indices[num_units++] = i;
+                    if (num_units == VS_BATCH_SIZE)
+                        run_units();
                 }
+                run_units();
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                chunk_cache_hits += hits;
+                chunk_cache_misses += (end - begin) - hits;
+            });
+
+            for (u32 i = 0; i < num_vertices; ++i) {
+                g_state.geometry_pipeline.SubmitVertex(outputs[i]);
+            }
+            vertex_cache_hits = chunk_cache_hits;
+            vertex_cache_misses = chunk_cache_misses;
+
+            // Nothing is left for the serial loop
+            index = num_vertices;
+        }
+
+        while (index < regs.pipeline.num_vertices) {
+            std::size_t num_invocations = 0;
+            std::size_t num_submits = 0;
+
+            for (; index < regs.pipeline.num_vertices && num_submits < VS_BATCH_SIZE; ++index) {
+                // Indexed rendering doesn't use the start offset
+                unsigned int vertex =
+                    is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                               : (index + regs.pipeline.vertex_offset);
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
+
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
+
+                    const std::size_t slot = vertex % VERTEX_CACHE_SIZE;
+                    if (vertex_cache_valid[slot] && vertex_cache_ids[slot] == vertex) {
+                        ++vertex_cache_hits;
+                        submit_cached_outputs[num_submits] = &vertex_cache[slot];
+                        submit_invocations[num_submits++] = NO_INVOCATION;
+                        continue;
+                    }
+
+                    // A vertex repeated within the batch is only shaded once
+                    const auto repeated =
+                        std::find(shader_vertices.begin(),
+                                  shader_vertices.begin() + num_invocations, vertex);
+                    if (repeated != shader_vertices.begin() + num_invocations) {
+                        ++vertex_cache_hits;
+                        submit_invocations[num_submits++] =
+                            static_cast<std::size_t>(repeated - shader_vertices.begin());
+                        continue;
                     }
+
+                    ++vertex_cache_misses;
                 }
-            }
 
-            if (!vertex_cache_hit) {
                 // Initialize data for the current vertex
                 Shader::AttributeBuffer input;
                 loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
@@ -409,20 +579,40 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 if (g_debug_context)
                     g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
                                              (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                shader_units[num_invocations].LoadInput(regs.vs, input);
+                shader_vertices[num_invocations] = vertex;
+                submit_invocations[num_submits++] = num_invocations++;
+            }
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
-                }
+            shader_engine->RunBatch(g_state.vs, shader_units.data(), num_invocations);
+
+            for (std::size_t i = 0; i < num_invocations; ++i) {
+                shader_units[i].WriteOutput(regs.vs, shader_outputs[i]);
             }
 
             // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            for (std::size_t i = 0; i < num_submits; ++i) {
+                const std::size_t invocation = submit_invocations[i];
+                g_state.geometry_pipeline.SubmitVertex(invocation == NO_INVOCATION
+                                                           ? *submit_cached_outputs[i]
+                                                           : shader_outputs[invocation]);
+            }
+
+            // Only fill the cache once the batch is submitted, an invocation may evict an entry
+            // that an earlier vertex of the batch hit
+            if (is_indexed) {
+                for (std::size_t i = 0; i < num_invocations; ++i) {
+                    const std::size_t slot = shader_vertices[i] % VERTEX_CACHE_SIZE;
+                    vertex_cache[slot] = shader_outputs[i];
+                    vertex_cache_valid[slot] = true;
+                    vertex_cache_ids[slot] = shader_vertices[i];
+                }
+            }
+        }
+
+        if (is_indexed) {
+            Core::System::GetInstance().perf_stats.AddVertexCacheStats(vertex_cache_hits,
+                                                                       vertex_cache_misses);
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -653,7 +843,129 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                                  reinterpret_cast<void*>(&id));
 }
 
+/**
+ * Writes a run of values to one of the data port registers, which store each value they are
+ * written at an index that advances with every write. This does what a WritePicaReg call per value
+ * would, but without the register switch, and the rasterizer is notified and the shader data is
+ * marked dirty once for the whole run.
+ * @param first,rest the values of the run, the first one then count more
+ * @returns false if the register isn't a data port handled here, the caller writes it then
+ */
+static bool WriteDataPort(u32 id, u32 first, const u32* rest, u32 count) {
+    auto& regs = g_state.regs;
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+
+    // The debugger and the tracer see each register write
+    if (g_debug_context || DebugUtils::IsPicaTracing())
+        return false;
+
+    FlushImmediateVertices();
+
+    const auto in_range = [id](u32 begin, u32 end) { return id >= begin && id <= end; };
+    const u32 last = count != 0 ? rest[count - 1] : first;
+
+    if (in_range(PICA_REG_INDEX_WORKAROUND(lighting.lut_data[0], 0x1c8),
+                 PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf))) {
+        auto& lut_config = regs.lighting.lut_config;
+        auto& lut = g_state.lighting.luts[lut_config.type];
+        // The rasterizer tracks the written entries as a range, which is covered by marking the
+        // first and last one as long as the index doesn't wrap around
+        if (lut_config.index + count >= lut.size())
+            return false;
+
+        rasterizer->NotifyPicaRegisterChanging(id, first);
+        regs.reg_array[id] = first;
+        lut[lut_config.index].raw = first;
+        lut_config.index.Assign(lut_config.index + 1);
+        rasterizer->NotifyPicaRegisterChanged(id);
+        if (count != 0) {
+            regs.reg_array[id] = last;
+            for (u32 i = 0; i < count; ++i)
+                lut[lut_config.index + i].raw = rest[i];
+            lut_config.index.Assign(lut_config.index + count);
+            rasterizer->NotifyPicaRegisterChanged(id);
+        }
+        return true;
+    }
+
+    using ShaderData = std::array<u32, Shader::MAX_PROGRAM_CODE_LENGTH>;
+    const auto write_data = [&](ShaderData& data, ShaderData* shared, u32& offset, u32 size,
+                                const char* name) {
+        for (u32 i = 0; i <= count; ++i) {
+            if (offset >= size) {
+                LOG_ERROR(HW_GPU, "Invalid {} offset {}", name, offset);
+                return;
+            }
+            const u32 value = i == 0 ? first : rest[i - 1];
+            data[offset] = value;
+            if (shared)
+                (*shared)[offset] = value;
+            offset++;
+        }
+    };
+
+    const auto write_uniforms = [&](ShaderRegs& config, Shader::ShaderSetup& setup,
+                                    int& float_regs_counter, u32 uniform_write_buffer[4]) {
+        WriteUniformFloatReg(config, setup, float_regs_counter, uniform_write_buffer, first);
+        for (u32 i = 0; i < count; ++i) {
+            WriteUniformFloatReg(config, setup, float_regs_counter, uniform_write_buffer, rest[i]);
+        }
+    };
+
+    // Unless the GS unit is configured separately, it gets the VS program and swizzle data too
+    const bool vs_shared = !regs.pipeline.gs_unit_exclusive_configuration;
+
+    // The registers themselves only hold the last value written
+    if (in_range(PICA_REG_INDEX_WORKAROUND(vs.program.set_word[0], 0x2cc),
+                 PICA_REG_INDEX_WORKAROUND(vs.program.set_word[7], 0x2d3))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_data(g_state.vs.program_code, vs_shared ? &g_state.gs.program_code : nullptr,
+                   regs.vs.program.offset, 512, "VS program");
+        g_state.vs.MarkProgramCodeDirty();
+        if (vs_shared)
+            g_state.gs.MarkProgramCodeDirty();
+    } else if (in_range(PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[0], 0x2d6),
+                        PICA_REG_INDEX_WORKAROUND(vs.swizzle_patterns.set_word[7], 0x2dd))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_data(g_state.vs.swizzle_data, vs_shared ? &g_state.gs.swizzle_data : nullptr,
+                   regs.vs.swizzle_patterns.offset, Shader::MAX_SWIZZLE_DATA_LENGTH,
+                   "VS swizzle pattern");
+        g_state.vs.MarkSwizzleDataDirty();
+        if (vs_shared)
+            g_state.gs.MarkSwizzleDataDirty();
+    } else if (in_range(PICA_REG_INDEX_WORKAROUND(gs.program.set_word[0], 0x29c),
+                        PICA_REG_INDEX_WORKAROUND(gs.program.set_word[7], 0x2a3))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_data(g_state.gs.program_code, nullptr, regs.gs.program.offset,
+                   Shader::MAX_PROGRAM_CODE_LENGTH, "GS program");
+        g_state.gs.MarkProgramCodeDirty();
+    } else if (in_range(PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[0], 0x2a6),
+                        PICA_REG_INDEX_WORKAROUND(gs.swizzle_patterns.set_word[7], 0x2ad))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_data(g_state.gs.swizzle_data, nullptr, regs.gs.swizzle_patterns.offset,
+                   Shader::MAX_SWIZZLE_DATA_LENGTH, "GS swizzle pattern");
+        g_state.gs.MarkSwizzleDataDirty();
+    } else if (in_range(PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[0], 0x2c1),
+                        PICA_REG_INDEX_WORKAROUND(vs.uniform_setup.set_value[7], 0x2c8))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_uniforms(regs.vs, g_state.vs, vs_float_regs_counter, vs_uniform_write_buffer);
+    } else if (in_range(PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[0], 0x291),
+                        PICA_REG_INDEX_WORKAROUND(gs.uniform_setup.set_value[7], 0x298))) {
+        rasterizer->NotifyPicaRegisterChanging(id, last);
+        write_uniforms(regs.gs, g_state.gs, gs_float_regs_counter, gs_uniform_write_buffer);
+    } else {
+        return false;
+    }
+
+    regs.reg_array[id] = last;
+    rasterizer->NotifyPicaRegisterChanged(id);
+    return true;
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
+    Core::PerfStats::ScopedPhase phase(Core::System::GetInstance().perf_stats,
+                                       Core::FramePhase::GPU);
+
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
 
@@ -666,6 +978,14 @@ void ProcessCommandList(const u32* list, u32 size) {
         u32 value = *g_state.cmd_list.current_ptr++;
         const CommandHeader header = {*g_state.cmd_list.current_ptr++};
 
+        // Shader code, uniforms and LUTs are uploaded by writing the same register repeatedly
+        if (!header.group_commands && header.parameter_mask == 0xF &&
+            WriteDataPort(header.cmd_id, value, g_state.cmd_list.current_ptr,
+                          header.extra_data_length)) {
+            g_state.cmd_list.current_ptr += header.extra_data_length;
+            continue;
+        }
+
         WritePicaReg(header.cmd_id, value, header.parameter_mask);
 
         for (unsigned i = 0; i < header.extra_data_length; ++i) {
@@ -673,6 +993,9 @@ void ProcessCommandList(const u32* list, u32 size) {
             WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
         }
     }
+
+    // The vertices are drawn before the list finishes, the next one may only come a frame later
+    FlushImmediateVertices();
 }
 
 } // namespace CommandProcessor
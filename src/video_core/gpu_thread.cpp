@@ -0,0 +1,133 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+std::unique_ptr<GPUThread> g_gpu_thread;
+
+GPUThread::GPUThread(EmuWindow& emu_window) : emu_window(emu_window) {
+    // Hand the context over to the GPU thread
+    emu_window.DoneCurrent();
+    thread = std::thread(&GPUThread::ThreadLoop, this);
+    LOG_INFO(Render, "GPU thread started");
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_cv.notify_one();
+    thread.join();
+
+    // Take the context back so that the renderer can be shut down on this thread
+    emu_window.MakeCurrent();
+}
+
+void GPUThread::Push(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(work));
+        ++pushed_count;
+    }
+    work_cv.notify_one();
+}
+
+void GPUThread::PushSync(std::function<void()> work) {
+    if (IsGPUThread()) {
+        work();
+        return;
+    }
+
+    Push(std::move(work));
+    WaitIdle();
+}
+
+void GPUThread::PushFrame(std::function<void()> present) {
+    if (IsGPUThread()) {
+        present();
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return pending_frames < MAX_PENDING_FRAMES; });
+        ++pending_frames;
+    }
+    // done_cv is notified once the work is completed, after the frame is no longer pending
+    Push([this, present = std::move(present)] {
+        present();
+        std::lock_guard<std::mutex> lock(mutex);
+        --pending_frames;
+    });
+}
+
+void GPUThread::WaitIdle() {
+    if (IsGPUThread()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const u64 target = pushed_count;
+    done_cv.wait(lock, [this, target] { return completed_count >= target; });
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+void GPUThread::ThreadLoop() {
+    MicroProfileOnThreadCreate("GPUThread");
+    Common::ScopedThreadRole thread_role{Common::ThreadRole::GPU};
+    emu_window.MakeCurrent();
+
+    while (true) {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [this] { return stop || !queue.empty(); });
+            // Drain the queue before stopping so that no submitted work is lost
+            if (queue.empty()) {
+                break;
+            }
+            work = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        work();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++completed_count;
+        }
+        done_cv.notify_all();
+    }
+
+    emu_window.DoneCurrent();
+}
+
+void RunOnGPUThreadSync(const std::function<void()>& work) {
+    if (g_gpu_thread) {
+        g_gpu_thread->PushSync(work);
+    } else {
+        work();
+    }
+}
+
+void RunOnGPUThread(std::function<void()> work) {
+    if (g_gpu_thread) {
+        g_gpu_thread->Push(std::move(work));
+    } else {
+        work();
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,84 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "common/common_types.h"
+
+class EmuWindow;
+
+namespace VideoCore {
+
+/**
+ * Executes PICA command lists and all other work that needs the renderer on a dedicated thread,
+ * so that ARM emulation and GPU emulation can overlap. The thread owns the render window's GL
+ * context for as long as it is running.
+ *
+ * Work is executed in submission order. Anything that observes the results of the GPU (memory
+ * flushes, display transfers, buffer swaps) has to go through PushSync so that it waits for the
+ * previously queued command lists.
+ */
+class GPUThread {
+public:
+    explicit GPUThread(EmuWindow& emu_window);
+    ~GPUThread();
+
+    /// Queues work for the GPU thread and returns right away
+    void Push(std::function<void()> work);
+
+    /// Executes work on the GPU thread after all previously queued work and waits for it
+    void PushSync(std::function<void()> work);
+
+    /**
+     * Queues the presentation of a frame and returns right away, unless MAX_PENDING_FRAMES frames
+     * are already waiting to be presented, in which case this waits for the oldest one. Together
+     * with the frame being emulated this buffers up to three frames, so that emulation doesn't
+     * wait for buffer swaps and v-sync unless it runs ahead of the screen.
+     */
+    void PushFrame(std::function<void()> present);
+
+    /// Blocks until all the queued work has been executed
+    void WaitIdle();
+
+    /// Returns whether the calling thread is the GPU thread
+    bool IsGPUThread() const;
+
+private:
+    static constexpr u32 MAX_PENDING_FRAMES = 2;
+
+    void ThreadLoop();
+
+    EmuWindow& emu_window;
+
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    u64 pushed_count = 0;
+    u64 completed_count = 0;
+    /// Frames queued with PushFrame that haven't been presented yet
+    u32 pending_frames = 0;
+    bool stop = false;
+
+    std::thread thread;
+};
+
+extern std::unique_ptr<GPUThread> g_gpu_thread;
+
+/**
+ * Runs work on the GPU thread and waits for it if the GPU thread is enabled, otherwise runs it
+ * right away. Work that is already running on the GPU thread is executed inline.
+ */
+void RunOnGPUThreadSync(const std::function<void()>& work);
+
+/// Queues work on the GPU thread if it is enabled, otherwise runs it right away
+void RunOnGPUThread(std::function<void()> work);
+
+} // namespace VideoCore
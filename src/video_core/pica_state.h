@@ -141,6 +141,11 @@ struct State {
         u32 current_attribute = 0;
         // Indicates the immediate mode just started and the geometry pipeline needs to reconfigure
         bool reset_geometry_pipeline = true;
+        // Complete vertices waiting to be shaded together, in submission order. They are run
+        // before any other register write, so the shader setup they see doesn't change.
+        static constexpr std::size_t MAX_BATCH_SIZE = 16;
+        std::array<Shader::AttributeBuffer, MAX_BATCH_SIZE> batch;
+        std::size_t batch_size = 0;
     } immediate;
 
     // the geometry shader needs to be kept in the global state because some shaders relie on
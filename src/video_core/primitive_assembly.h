@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <functional>
+#include "common/logging/log.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -15,9 +15,6 @@ namespace Pica {
  */
 template <typename VertexType>
 struct PrimitiveAssembler {
-    using TriangleHandler =
-        std::function<void(const VertexType& v0, const VertexType& v1, const VertexType& v2)>;
-
     PrimitiveAssembler(
         PipelineRegs::TriangleTopology topology = PipelineRegs::TriangleTopology::List);
 
@@ -25,9 +22,47 @@ struct PrimitiveAssembler {
      * Queues a vertex, builds primitives from the vertex queue according to the given
      * triangle topology, and calls triangle_handler for each generated primitive.
      * NOTE: We could specify the triangle handler in the constructor, but this way we can
-     * keep event and handler code next to each other.
+     * keep event and handler code next to each other. It is taken as a template parameter rather
+     * than a std::function, as one is created for every vertex.
      */
-    void SubmitVertex(const VertexType& vtx, TriangleHandler triangle_handler);
+    template <typename TriangleHandler>
+    void SubmitVertex(const VertexType& vtx, const TriangleHandler& triangle_handler) {
+        switch (topology) {
+        case PipelineRegs::TriangleTopology::List:
+        case PipelineRegs::TriangleTopology::Shader:
+            if (buffer_index < 2) {
+                buffer[buffer_index++] = vtx;
+            } else {
+                buffer_index = 0;
+                if (topology == PipelineRegs::TriangleTopology::Shader && winding) {
+                    triangle_handler(buffer[1], buffer[0], vtx);
+                    winding = false;
+                } else {
+                    triangle_handler(buffer[0], buffer[1], vtx);
+                }
+            }
+            break;
+
+        case PipelineRegs::TriangleTopology::Strip:
+        case PipelineRegs::TriangleTopology::Fan:
+            if (strip_ready)
+                triangle_handler(buffer[0], buffer[1], vtx);
+
+            buffer[buffer_index] = vtx;
+
+            strip_ready |= (buffer_index == 1);
+
+            if (topology == PipelineRegs::TriangleTopology::Strip)
+                buffer_index = !buffer_index;
+            else if (topology == PipelineRegs::TriangleTopology::Fan)
+                buffer_index = 1;
+            break;
+
+        default:
+            LOG_ERROR(HW_GPU, "Unknown triangle topology {:x}:", (int)topology);
+            break;
+        }
+    }
 
     /**
      * Invert the vertex order of the next triangle. Called by geometry shader emitter.
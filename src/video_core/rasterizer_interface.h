@@ -17,6 +17,10 @@ struct OutputVertex;
 }
 } // namespace Pica
 
+namespace Service::Y2R {
+struct ConversionConfiguration;
+}
+
 namespace VideoCore {
 
 class RasterizerInterface {
@@ -31,6 +35,9 @@ public:
     /// Draw the current batch of triangles
     virtual void DrawTriangles() = 0;
 
+    /// Notify rasterizer that the specified PICA register is about to be written with a value
+    virtual void NotifyPicaRegisterChanging(u32 id, u32 value) {}
+
     /// Notify rasterizer that the specified PICA register has been changed
     virtual void NotifyPicaRegisterChanged(u32 id) = 0;
 
@@ -62,6 +69,18 @@ public:
         return false;
     }
 
+    /// Attempt to use a faster method to perform a Y2R conversion, advancing its buffers like
+    /// HW::Y2R::PerformConversion does when it succeeds
+    virtual bool AccelerateY2RConversion(Service::Y2R::ConversionConfiguration& config) {
+        return false;
+    }
+
+    /// Attempt to use a faster method to perform a GSP DMA request, the addresses are virtual
+    /// addresses of the current process
+    virtual bool AccelerateDma(VAddr src_addr, VAddr dst_addr, u32 size) {
+        return false;
+    }
+
     /// Attempt to use a faster method to display the framebuffer to screen
     virtual bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config,
                                    PAddr framebuffer_addr, u32 pixel_stride,
@@ -73,5 +92,11 @@ public:
     virtual bool AccelerateDrawBatch(bool is_indexed) {
         return false;
     }
+
+    /// Notify rasterizer that a frame has been presented
+    virtual void NotifyFramePresented() {}
+
+    /// Load resources cached on disk for the given title, such as generated shaders
+    virtual void LoadDiskResources(u64 title_id) {}
 };
 } // namespace VideoCore
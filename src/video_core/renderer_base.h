@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include "common/common_types.h"
 #include "core/core.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
 #include "video_core/rasterizer_interface.h"
 
 class EmuWindow;
@@ -16,11 +19,23 @@ public:
     /// Used to reference a framebuffer
     enum kFramebuffer { kFramebuffer_VirtualXFB = 0, kFramebuffer_EFB, kFramebuffer_Texture };
 
+    /**
+     * Registers of the top and bottom screens a frame is presented with. They are captured at the
+     * VBlank, as the frame may be presented later while the registers change for the next one.
+     */
+    struct ScreenConfig {
+        std::array<GPU::Regs::FramebufferConfig, 2> framebuffers;
+        std::array<LCD::Regs::ColorFill, 2> color_fills;
+        /// Set when frame skipping drops the frame. The screens are then neither loaded nor
+        /// drawn, only the renderer's per-frame bookkeeping runs.
+        bool skip = false;
+    };
+
     explicit RendererBase(EmuWindow& window);
     virtual ~RendererBase();
 
     /// Swap buffers (render frame)
-    virtual void SwapBuffers() = 0;
+    virtual void SwapBuffers(const ScreenConfig& config) = 0;
 
     /// Initialize the renderer
     virtual Core::System::ResultStatus Init() = 0;
@@ -0,0 +1,139 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "video_core/renderer_opengl/gl_frame_mailbox.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+namespace OpenGL {
+
+OGLFrameMailbox::OGLFrameMailbox() {
+    for (auto& frame : frames) {
+        free_frames.push_back(&frame);
+    }
+}
+
+OGLFrameMailbox::~OGLFrameMailbox() {
+    for (auto& frame : frames) {
+        if (frame.present_fbo != 0) {
+            glDeleteFramebuffers(1, &frame.present_fbo);
+        }
+        // The renderer's framebuffers went away with its context if they weren't released
+        frame.render_fbo.handle = 0;
+    }
+}
+
+OGLFrameMailbox::Frame* OGLFrameMailbox::GetRenderFrame(u32 width, u32 height) {
+    Frame* frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!free_frames.empty()) {
+            frame = free_frames.front();
+            free_frames.pop_front();
+        } else {
+            // Running ahead of presentation, drop the frame that is waiting to be presented
+            frame = ready_frame;
+            ready_frame = nullptr;
+        }
+    }
+    ASSERT(frame != nullptr);
+
+    // A frame that was dropped still has the fence of its rendering
+    frame->render_fence.Release();
+    if (frame->present_fence.handle != nullptr) {
+        // Have the GPU finish the last blit of the frame before drawing over it
+        glWaitSync(frame->present_fence.handle, 0, GL_TIMEOUT_IGNORED);
+        frame->present_fence.Release();
+    }
+
+    const bool new_fbo = frame->render_fbo.handle == 0;
+    if (new_fbo || frame->width != width || frame->height != height) {
+        OpenGLState state = OpenGLState::GetCurState();
+        const GLuint old_draw_fb = state.draw.draw_framebuffer;
+        frame->render_fbo.Create();
+        state.draw.draw_framebuffer = frame->render_fbo.handle;
+        state.Apply();
+
+        if (frame->width != width || frame->height != height || frame->color.handle == 0) {
+            frame->color.Create();
+            glBindRenderbuffer(GL_RENDERBUFFER, frame->color.handle);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            frame->width = width;
+            frame->height = height;
+            frame->color_reloaded = true;
+        }
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                  frame->color.handle);
+
+        state.draw.draw_framebuffer = old_draw_fb;
+        state.Apply();
+    }
+
+    return frame;
+}
+
+void OGLFrameMailbox::ReleaseRenderFrame(Frame* frame) {
+    frame->render_fence.Create();
+    // Fences only become visible to other contexts once they are flushed
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready_frame != nullptr) {
+        free_frames.push_back(ready_frame);
+    }
+    ready_frame = frame;
+}
+
+void OGLFrameMailbox::ReleaseRenderResources() {
+    for (auto& frame : frames) {
+        frame.render_fbo.Release();
+    }
+}
+
+bool OGLFrameMailbox::TryPresent() {
+    Frame* frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ready_frame != nullptr) {
+            if (presented_frame != nullptr) {
+                free_frames.push_back(presented_frame);
+            }
+            presented_frame = ready_frame;
+            ready_frame = nullptr;
+        }
+        // Without a new frame the last one is presented again, e.g. after the window was exposed
+        frame = presented_frame;
+    }
+    if (frame == nullptr) {
+        return false;
+    }
+
+    if (frame->render_fence.handle != nullptr) {
+        glWaitSync(frame->render_fence.handle, 0, GL_TIMEOUT_IGNORED);
+        frame->render_fence.Release();
+    }
+
+    if (frame->present_fbo == 0) {
+        glGenFramebuffers(1, &frame->present_fbo);
+        frame->color_reloaded = true;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame->present_fbo);
+    if (frame->color_reloaded) {
+        glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                  frame->color.handle);
+        frame->color_reloaded = false;
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, frame->width, frame->height, 0, 0, frame->width, frame->height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    frame->present_fence.Release();
+    frame->present_fence.Create();
+    glFlush();
+    return true;
+}
+
+} // namespace OpenGL
@@ -0,0 +1,78 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Triple buffered frames shared between the renderer's context and the context the frontend
+ * presents with. The renderer draws into a frame's renderbuffer and the presenting thread blits it
+ * to its default framebuffer. The two sides synchronize with fences waited on by the GPU, so that
+ * neither thread ever waits for the other: the renderer reuses the oldest frame that wasn't
+ * presented yet when it runs ahead of presentation.
+ *
+ * Framebuffer objects can't be shared between contexts, so each frame has one for each side. The
+ * presenting side doesn't use OpenGLState, which only tracks the renderer's context.
+ */
+class OGLFrameMailbox : public Frontend::FrameMailbox {
+public:
+    struct Frame {
+        OGLRenderbuffer color;
+        u32 width = 0;
+        u32 height = 0;
+
+        /// Framebuffer of the renderer's context
+        OGLFramebuffer render_fbo;
+        /// Signaled once the frame was rendered
+        OGLSync render_fence;
+
+        /// Framebuffer of the presenting context, created by it
+        GLuint present_fbo = 0;
+        /// Signaled once the frame was blitted by the presenting context
+        OGLSync present_fence;
+        /// Set when the renderbuffer storage was reallocated and has to be attached again
+        bool color_reloaded = false;
+    };
+
+    OGLFrameMailbox();
+
+    /// Deletes the presenting side's objects, call with the presenting context current
+    ~OGLFrameMailbox() override;
+
+    /**
+     * Returns a frame of the given size to render into through its render_fbo. Never waits for the
+     * presenting thread. Renderer's thread only.
+     */
+    Frame* GetRenderFrame(u32 width, u32 height);
+
+    /// Makes a frame returned by GetRenderFrame the next one to present. Renderer's thread only.
+    void ReleaseRenderFrame(Frame* frame);
+
+    /// Deletes the renderer side's objects, call with the renderer's context current
+    void ReleaseRenderResources();
+
+    bool TryPresent() override;
+
+private:
+    std::array<Frame, 3> frames;
+
+    std::mutex mutex;
+    /// Frames neither rendered into nor presented
+    std::deque<Frame*> free_frames;
+    /// The most recently rendered frame, if it wasn't presented yet
+    Frame* ready_frame = nullptr;
+    /// The frame the presenting thread last presented
+    Frame* presented_frame = nullptr;
+};
+
+} // namespace OpenGL
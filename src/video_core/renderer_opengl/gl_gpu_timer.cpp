@@ -0,0 +1,115 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_gpu_timer.h"
+
+namespace OpenGL {
+
+GPUTimer* GPUTimer::current = nullptr;
+
+static const char* GetGPUPassName(GPUPass pass) {
+    switch (pass) {
+    case GPUPass::DrawBatch:
+        return "Draw Batch";
+    case GPUPass::SurfaceBlit:
+        return "Surface Blit";
+    case GPUPass::DisplayTransfer:
+        return "Display Transfer";
+    case GPUPass::TextureUpload:
+        return "Texture Upload";
+    case GPUPass::Present:
+        return "Present";
+    default:
+        UNREACHABLE();
+    }
+}
+
+GPUTimer::GPUTimer() {
+    ASSERT(current == nullptr);
+    current = this;
+}
+
+GPUTimer::~GPUTimer() {
+    for (auto& frame : frames) {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+    current = nullptr;
+}
+
+u32 GPUTimer::Begin(GPUPass pass) {
+    if (!enabled) {
+        return INVALID_SCOPE;
+    }
+    Frame& frame = frames[current_frame];
+    frame.scopes.push_back({pass, IssueQuery(), 0});
+    return static_cast<u32>(frame.scopes.size() - 1);
+}
+
+void GPUTimer::End(u32 scope) {
+    if (scope == INVALID_SCOPE) {
+        return;
+    }
+    frames[current_frame].scopes[scope].end_query = IssueQuery();
+}
+
+u32 GPUTimer::IssueQuery() {
+    Frame& frame = frames[current_frame];
+    if (frame.used_queries == frame.queries.size()) {
+        // Grows the pool by a few queries at a time until it fits the busiest frames
+        constexpr std::size_t QUERIES_PER_ALLOCATION = 64;
+        frame.queries.resize(frame.queries.size() + QUERIES_PER_ALLOCATION);
+        glGenQueries(QUERIES_PER_ALLOCATION,
+                     &frame.queries[frame.queries.size() - QUERIES_PER_ALLOCATION]);
+    }
+    glQueryCounter(frame.queries[frame.used_queries], GL_TIMESTAMP);
+    return frame.used_queries++;
+}
+
+void GPUTimer::ReadFrame(Frame& frame) {
+    if (frame.scopes.empty()) {
+        frame.used_queries = 0;
+        return;
+    }
+
+    // Queries complete in order, the last one of the frame being available means all are
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.queries[frame.used_queries - 1], GL_QUERY_RESULT_AVAILABLE,
+                        &available);
+    if (available == GL_TRUE) {
+        std::vector<GLuint64> timestamps(frame.used_queries);
+        for (u32 i = 0; i < frame.used_queries; ++i) {
+            glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+        }
+
+        results.clear();
+        for (const Scope& scope : frame.scopes) {
+            results.push_back({GetGPUPassName(scope.pass),
+                               static_cast<s64>(timestamps[scope.begin_query]),
+                               static_cast<s64>(timestamps[scope.end_query])});
+        }
+        GLint64 gpu_now = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+        Common::Profiling::AddGPUScopes(results, gpu_now);
+    } else {
+        LOG_DEBUG(Render_OpenGL, "GPU timestamps of a frame weren't ready in time, dropping them");
+    }
+
+    frame.scopes.clear();
+    frame.used_queries = 0;
+}
+
+void GPUTimer::EndFrame() {
+    current_frame = (current_frame + 1) % frames.size();
+    // The frame that is reused is the oldest one, which was issued FRAME_LATENCY frames ago
+    ReadFrame(frames[current_frame]);
+
+    // Only checked once per frame, scopes of an unfinished frame are kept until they are read
+    enabled = Common::Profiling::IsTraceCaptureActive();
+}
+
+} // namespace OpenGL
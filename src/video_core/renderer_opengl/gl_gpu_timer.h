@@ -0,0 +1,98 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/microprofile.h"
+
+namespace OpenGL {
+
+/// Kinds of GPU work whose execution time is measured
+enum class GPUPass : u32 {
+    DrawBatch,
+    SurfaceBlit,
+    DisplayTransfer,
+    TextureUpload,
+    Present,
+
+    Count,
+};
+
+/**
+ * Measures how long the GPU takes to execute passes with GL_TIMESTAMP queries. The results of a
+ * frame are read FRAME_LATENCY frames later without waiting for the GPU, and written to the
+ * running profile trace capture on a GPU track. Queries are only issued while a capture runs.
+ * All functions must be called on the thread owning the renderer's context.
+ */
+class GPUTimer : NonCopyable {
+public:
+    GPUTimer();
+    ~GPUTimer();
+
+    /// Returns the timer of the renderer, or nullptr if there is none
+    static GPUTimer* GetCurrent() {
+        return current;
+    }
+
+    /// Starts measuring a pass, returns an identifier for End
+    u32 Begin(GPUPass pass);
+    void End(u32 scope);
+
+    /// Reads the results of an older frame and starts measuring the next one
+    void EndFrame();
+
+    static constexpr u32 INVALID_SCOPE = 0xFFFFFFFF;
+
+private:
+    static constexpr std::size_t FRAME_LATENCY = 3;
+
+    struct Scope {
+        GPUPass pass;
+        u32 begin_query;
+        u32 end_query;
+    };
+
+    struct Frame {
+        /// Query objects, only ever added to
+        std::vector<GLuint> queries;
+        u32 used_queries = 0;
+        std::vector<Scope> scopes;
+    };
+
+    u32 IssueQuery();
+    void ReadFrame(Frame& frame);
+
+    static GPUTimer* current;
+
+    bool enabled = false;
+    std::array<Frame, FRAME_LATENCY + 1> frames;
+    std::size_t current_frame = 0;
+    std::vector<Common::Profiling::GPUScope> results;
+};
+
+/// Measures a pass for as long as it exists, if there is a timer
+class ScopedGPUTimer : NonCopyable {
+public:
+    explicit ScopedGPUTimer(GPUPass pass) : timer(GPUTimer::GetCurrent()) {
+        if (timer) {
+            scope = timer->Begin(pass);
+        }
+    }
+
+    ~ScopedGPUTimer() {
+        if (timer) {
+            timer->End(scope);
+        }
+    }
+
+private:
+    GPUTimer* timer;
+    u32 scope = GPUTimer::INVALID_SCOPE;
+};
+
+} // namespace OpenGL
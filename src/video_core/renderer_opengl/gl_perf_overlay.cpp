@@ -0,0 +1,207 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include "core/frontend/framebuffer_layout.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_perf_overlay.h"
+
+namespace OpenGL {
+
+static const char vertex_shader[] = R"(
+#version 150 core
+
+in vec2 vert_position;
+in vec4 vert_color;
+out vec4 frag_color;
+
+// Positions are in pixels, with (0,0) on the top-left corner
+uniform vec2 viewport_size;
+
+void main() {
+    vec2 position = vert_position / viewport_size * vec2(2.0, -2.0) + vec2(-1.0, 1.0);
+    gl_Position = vec4(position, 0.0, 1.0);
+    frag_color = vert_color;
+}
+)";
+
+static const char fragment_shader[] = R"(
+#version 150 core
+
+in vec4 frag_color;
+out vec4 color;
+
+void main() {
+    color = frag_color;
+}
+)";
+
+/// Frame time at the top of the graph, two frames at 60 Hz
+constexpr float GRAPH_MAX_MS = 1000.0f / 30.0f;
+/// Audio latency filling its bar
+constexpr float AUDIO_MAX_MS = 100.0f;
+/// Surface cache size filling its bar when the cache has no budget
+constexpr u64 TEXTURE_CACHE_MAX_BYTES = 1024ull * 1024 * 1024;
+/// Accounted host memory filling its bar
+constexpr u64 MEMORY_MAX_BYTES = 2048ull * 1024 * 1024;
+
+constexpr std::array<GLfloat, 4> BACKGROUND_COLOR = {0.0f, 0.0f, 0.0f, 0.6f};
+constexpr std::array<GLfloat, 4> TARGET_LINE_COLOR = {1.0f, 1.0f, 1.0f, 0.5f};
+constexpr std::array<GLfloat, 4> SHADER_COMPILE_COLOR = {1.0f, 0.2f, 0.2f, 1.0f};
+constexpr std::array<GLfloat, 4> TEXTURE_CACHE_COLOR = {0.7f, 0.3f, 1.0f, 1.0f};
+constexpr std::array<GLfloat, 4> AUDIO_COLOR = {0.2f, 0.9f, 0.9f, 1.0f};
+/// Colors of the phases stacked in each column of the graph
+constexpr std::array<std::pair<Core::FramePhase, std::array<GLfloat, 4>>, 3> PHASE_COLORS = {{
+    {Core::FramePhase::CPU, {0.2f, 0.8f, 0.2f, 1.0f}},
+    {Core::FramePhase::GPU, {0.2f, 0.4f, 1.0f, 1.0f}},
+    {Core::FramePhase::Present, {1.0f, 0.85f, 0.2f, 1.0f}},
+}};
+/// Colors of the memory categories stacked in the memory bar, from the bottom
+constexpr std::array<std::array<GLfloat, 4>, Common::NumMemoryCategories> MEMORY_COLORS = {{
+    {0.6f, 0.6f, 0.6f, 1.0f}, // GuestMemory
+    {0.9f, 0.5f, 0.9f, 1.0f}, // SurfaceStaging
+    {0.7f, 0.3f, 1.0f, 1.0f}, // SurfaceVRAM
+    {1.0f, 0.2f, 0.2f, 1.0f}, // ShaderCache
+    {0.2f, 0.8f, 0.2f, 1.0f}, // JitCodeCache
+    {1.0f, 0.55f, 0.1f, 1.0f}, // TraceBuffers
+    {0.2f, 0.9f, 0.9f, 1.0f}, // AudioBuffers
+    {1.0f, 0.85f, 0.2f, 1.0f}, // KernelObjects
+}};
+
+PerfOverlay::PerfOverlay() {
+    program.Create(vertex_shader, fragment_shader);
+    uniform_viewport_size = glGetUniformLocation(program.handle, "viewport_size");
+    const GLint attrib_position = glGetAttribLocation(program.handle, "vert_position");
+    const GLint attrib_color = glGetAttribLocation(program.handle, "vert_color");
+
+    vertex_buffer.Create();
+    vertex_array.Create();
+
+    state.draw.shader_program = program.handle;
+    state.draw.vertex_array = vertex_array.handle;
+    state.draw.vertex_buffer = vertex_buffer.handle;
+    state.blend.enabled = true;
+    state.blend.src_rgb_func = GL_SRC_ALPHA;
+    state.blend.dst_rgb_func = GL_ONE_MINUS_SRC_ALPHA;
+    state.blend.src_a_func = GL_ONE;
+    state.blend.dst_a_func = GL_ZERO;
+
+    const OpenGLState prev_state = OpenGLState::GetCurState();
+    state.Apply();
+    glVertexAttribPointer(attrib_position, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (GLvoid*)offsetof(Vertex, position));
+    glVertexAttribPointer(attrib_color, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (GLvoid*)offsetof(Vertex, color));
+    glEnableVertexAttribArray(attrib_position);
+    glEnableVertexAttribArray(attrib_color);
+    prev_state.Apply();
+
+    // Background, target line, three bars, the memory categories and up to five rectangles per
+    // frame
+    vertices.reserve((5 + Common::NumMemoryCategories + HISTORY_SIZE * 5) * 6);
+}
+
+PerfOverlay::~PerfOverlay() = default;
+
+void PerfOverlay::Update(Core::PerfStats& perf_stats) {
+    Core::FrameSample sample;
+    while (perf_stats.PopFrameSample(sample)) {
+        history[history_next] = sample;
+        history_next = (history_next + 1) % HISTORY_SIZE;
+    }
+}
+
+void PerfOverlay::AddRect(float x, float y, float w, float h,
+                          const std::array<GLfloat, 4>& color) {
+    const auto vertex = [&color](float vx, float vy) {
+        return Vertex{{vx, vy}, {color[0], color[1], color[2], color[3]}};
+    };
+    vertices.push_back(vertex(x, y));
+    vertices.push_back(vertex(x + w, y));
+    vertices.push_back(vertex(x, y + h));
+    vertices.push_back(vertex(x + w, y));
+    vertices.push_back(vertex(x + w, y + h));
+    vertices.push_back(vertex(x, y + h));
+}
+
+void PerfOverlay::Draw(const Layout::FramebufferLayout& layout) {
+    // Keeps the overlay readable on high resolution windows
+    const float unit = std::max(1.0f, static_cast<float>(layout.height) / 480.0f);
+    const float margin = 8.0f * unit;
+    const float column_width = 2.0f * unit;
+    const float graph_width = column_width * HISTORY_SIZE;
+    const float graph_height = 96.0f * unit;
+    const float bar_width = 8.0f * unit;
+    const float x0 = margin;
+    const float y0 = margin;
+    const float bottom = y0 + graph_height;
+    const auto to_height = [graph_height](float ms) {
+        return std::min(ms, GRAPH_MAX_MS) / GRAPH_MAX_MS * graph_height;
+    };
+
+    vertices.clear();
+    AddRect(x0 - 4.0f * unit, y0 - 4.0f * unit, graph_width + 3.0f * bar_width + 20.0f * unit,
+            graph_height + 8.0f * unit, BACKGROUND_COLOR);
+
+    // Oldest frame on the left
+    for (std::size_t i = 0; i < HISTORY_SIZE; ++i) {
+        const Core::FrameSample& sample = history[(history_next + i) % HISTORY_SIZE];
+        const float x = x0 + column_width * i;
+        float y = bottom;
+        for (const auto& [phase, color] : PHASE_COLORS) {
+            const float h = std::min(to_height(sample.phase_ms[static_cast<std::size_t>(phase)]),
+                                     y - y0);
+            if (h > 0.0f) {
+                y -= h;
+                AddRect(x, y, column_width, h, color);
+            }
+        }
+        if (sample.shader_compiles != 0) {
+            AddRect(x, y0, column_width, 4.0f * unit, SHADER_COMPILE_COLOR);
+        }
+    }
+    AddRect(x0, bottom - to_height(1000.0f / 60.0f), graph_width, unit, TARGET_LINE_COLOR);
+
+    const Core::FrameSample& latest = history[(history_next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+    const u16 budget_mib = Settings::GetSnapshot().texture_cache_budget;
+    const u64 cache_max =
+        budget_mib != 0 ? u64{budget_mib} * 1024 * 1024 : TEXTURE_CACHE_MAX_BYTES;
+    const float cache_fill =
+        std::min(1.0f, static_cast<float>(latest.texture_cache_bytes) / cache_max);
+    const float audio_fill = std::min(1.0f, latest.audio_latency_ms / AUDIO_MAX_MS);
+    const float bars_x = x0 + graph_width + 4.0f * unit;
+    AddRect(bars_x, bottom - graph_height * cache_fill, bar_width, graph_height * cache_fill,
+            TEXTURE_CACHE_COLOR);
+    AddRect(bars_x + bar_width + 4.0f * unit, bottom - graph_height * audio_fill, bar_width,
+            graph_height * audio_fill, AUDIO_COLOR);
+
+    const float memory_x = bars_x + 2.0f * (bar_width + 4.0f * unit);
+    float memory_y = bottom;
+    for (std::size_t i = 0; i < Common::NumMemoryCategories; ++i) {
+        const float h = std::min(graph_height * static_cast<float>(latest.memory_usage[i]) /
+                                     MEMORY_MAX_BYTES,
+                                 memory_y - y0);
+        if (h > 0.0f) {
+            memory_y -= h;
+            AddRect(memory_x, memory_y, bar_width, h, MEMORY_COLORS[i]);
+        }
+    }
+
+    const OpenGLState prev_state = OpenGLState::GetCurState();
+    state.draw.draw_framebuffer = prev_state.draw.draw_framebuffer;
+    state.Apply();
+
+    glUniform2f(uniform_viewport_size, static_cast<GLfloat>(layout.width),
+                static_cast<GLfloat>(layout.height));
+    // Orphans the previous frame's vertices, so that this doesn't wait for them to be drawn
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+
+    prev_state.Apply();
+}
+
+} // namespace OpenGL
@@ -0,0 +1,64 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "core/perf_stats.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+namespace Layout {
+struct FramebufferLayout;
+}
+
+namespace OpenGL {
+
+/**
+ * Draws a graph of the recent frame times and the state of the caches over the screens. The
+ * statistics are popped from PerfStats' lock-free ring of frame samples, and everything is drawn
+ * from a single stream of colored vertices with one draw call.
+ */
+class PerfOverlay : NonCopyable {
+public:
+    PerfOverlay();
+    ~PerfOverlay();
+
+    /// Pops the new frame samples. Called every frame, so that the ring doesn't fill up.
+    void Update(Core::PerfStats& perf_stats);
+
+    /**
+     * Draws the overlay in the top left corner of the bound framebuffer. The caller's state must
+     * be current, it is current again afterwards.
+     */
+    void Draw(const Layout::FramebufferLayout& layout);
+
+private:
+    struct Vertex {
+        GLfloat position[2];
+        GLfloat color[4];
+    };
+
+    /// Number of frames shown by the graph
+    static constexpr std::size_t HISTORY_SIZE = 128;
+
+    void AddRect(float x, float y, float w, float h, const std::array<GLfloat, 4>& color);
+
+    std::array<Core::FrameSample, HISTORY_SIZE> history{};
+    /// Index of the next sample in history
+    std::size_t history_next = 0;
+
+    std::vector<Vertex> vertices;
+
+    OpenGLState state;
+    OGLProgram program;
+    OGLVertexArray vertex_array;
+    OGLBuffer vertex_buffer;
+    GLint uniform_viewport_size;
+};
+
+} // namespace OpenGL
@@ -10,16 +10,24 @@
 #include <glad/glad.h>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/frame_counters.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
+#include "core/hle/service/y2r_u.h"
 #include "core/hw/gpu.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/renderer_opengl/gl_gpu_timer.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
@@ -35,9 +43,15 @@ MICROPROFILE_DEFINE(OpenGL_VAO, "OpenGL", "Vertex Array Setup", MP_RGB(255, 128,
 MICROPROFILE_DEFINE(OpenGL_VS, "OpenGL", "Vertex Shader Setup", MP_RGB(192, 128, 128));
 MICROPROFILE_DEFINE(OpenGL_GS, "OpenGL", "Geometry Shader Setup", MP_RGB(128, 192, 128));
 MICROPROFILE_DEFINE(OpenGL_Drawing, "OpenGL", "Drawing", MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(OpenGL_DrawBatch, "OpenGL", "Batched Drawing", MP_RGB(160, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_Blits, "OpenGL", "Blits", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(OpenGL_CacheManagement, "OpenGL", "Cache Mgmt", MP_RGB(100, 255, 100));
 
+static const Common::FrameCounter draw_counter("OpenGL/Draws");
+static const Common::FrameCounter draw_vertex_counter("OpenGL/Draw Vertices");
+static const Common::FrameCounter stereo_pair_counter("OpenGL/Stereo Pass Pairs");
+static const Common::FrameCounter stereo_pair_draw_counter("OpenGL/Stereo Pass Pair Draws");
+
 static bool IsVendorAmd() {
     std::string gpu_vendor{reinterpret_cast<char const*>(glGetString(GL_VENDOR))};
     return gpu_vendor == "ATI Technologies Inc." || gpu_vendor == "Advanced Micro Devices, Inc.";
@@ -46,15 +60,17 @@ static bool IsVendorAmd() {
 RasterizerOpenGL::RasterizerOpenGL(EmuWindow& window)
     : is_amd(IsVendorAmd()), shader_dirty(true),
       vertex_buffer(GL_ARRAY_BUFFER, VERTEX_BUFFER_SIZE, is_amd),
-      uniform_buffer(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_SIZE, false),
+      uniform_buffer(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_SIZE, false, true),
       index_buffer(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, false),
-      texture_buffer(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_SIZE, false), emu_window{window} {
+      texture_buffer(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_SIZE, false, true), emu_window{window} {
 
     allow_shadow = GLAD_GL_ARB_shader_image_load_store && GLAD_GL_ARB_shader_image_size &&
                    GLAD_GL_ARB_framebuffer_no_attachments;
     if (!allow_shadow) {
         LOG_WARNING(Render_OpenGL,
                     "Shadow might not be able to render because of unsupported OpenGL extensions.");
+    } else if (ShadowDepthResolver::IsSupported()) {
+        shadow_resolver = std::make_unique<ShadowDepthResolver>();
     }
 
     if (!GLAD_GL_ARB_texture_barrier) {
@@ -81,16 +97,22 @@ RasterizerOpenGL::RasterizerOpenGL(EmuWindow& window)
 
     uniform_block_data.dirty = true;
 
-    uniform_block_data.lighting_lut_dirty.fill(true);
+    for (auto& range : uniform_block_data.lighting_lut_dirty) {
+        range.MarkAll(static_cast<u32>(lighting_lut_data[0].size()));
+    }
     uniform_block_data.lighting_lut_dirty_any = true;
 
-    uniform_block_data.fog_lut_dirty = true;
+    uniform_block_data.fog_lut_dirty.MarkAll(static_cast<u32>(fog_lut_data.size()));
 
-    uniform_block_data.proctex_noise_lut_dirty = true;
-    uniform_block_data.proctex_color_map_dirty = true;
-    uniform_block_data.proctex_alpha_map_dirty = true;
-    uniform_block_data.proctex_lut_dirty = true;
-    uniform_block_data.proctex_diff_lut_dirty = true;
+    uniform_block_data.proctex_noise_lut_dirty.MarkAll(
+        static_cast<u32>(proctex_noise_lut_data.size()));
+    uniform_block_data.proctex_color_map_dirty.MarkAll(
+        static_cast<u32>(proctex_color_map_data.size()));
+    uniform_block_data.proctex_alpha_map_dirty.MarkAll(
+        static_cast<u32>(proctex_alpha_map_data.size()));
+    uniform_block_data.proctex_lut_dirty.MarkAll(static_cast<u32>(proctex_lut_data.size()));
+    uniform_block_data.proctex_diff_lut_dirty.MarkAll(
+        static_cast<u32>(proctex_diff_lut_data.size()));
 
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
     uniform_size_aligned_vs =
@@ -154,8 +176,24 @@ RasterizerOpenGL::RasterizerOpenGL(EmuWindow& window)
     state.Apply();
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
 
+    const bool separable = GLAD_GL_ARB_separate_shader_objects;
+    bool async_shaders = false;
+    // Draws are skipped while their shaders compile, depending on how fast the host is
+    const Settings::Snapshot& settings = Settings::GetSnapshot();
+    if (settings.use_async_shader_compilation && !settings.deterministic) {
+        if (separable && GLAD_GL_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            async_shaders = true;
+        } else if (separable && GLAD_GL_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            async_shaders = true;
+        } else {
+            LOG_WARNING(Render_OpenGL, "Asynchronous shader compilation requested, but "
+                                       "ARB_parallel_shader_compile is not supported.");
+        }
+    }
     shader_program_manager =
-        std::make_unique<ShaderProgramManager>(GLAD_GL_ARB_separate_shader_objects, is_amd);
+        std::make_unique<ShaderProgramManager>(separable, is_amd, async_shaders);
 
     glEnable(GL_BLEND);
 
@@ -379,14 +417,24 @@ bool RasterizerOpenGL::SetupGeometryShader() {
     const auto& regs = Pica::g_state.regs;
     if (regs.pipeline.use_gs == Pica::PipelineRegs::UseGS::No) {
         PicaFixedGSConfig gs_config(regs);
-        shader_program_manager->UseFixedGeometryShader(gs_config);
-        return true;
+        return shader_program_manager->UseFixedGeometryShader(gs_config);
     } else {
         PicaGSConfig gs_config(regs, Pica::g_state.gs);
         return shader_program_manager->UseProgrammableGeometryShader(gs_config, Pica::g_state.gs);
     }
 }
 
+void RasterizerOpenGL::NotifyFramePresented() {
+    res_cache.NotifyFramePresented();
+    shader_program_manager->NotifyFramePresented();
+}
+
+void RasterizerOpenGL::LoadDiskResources(u64 title_id) {
+    shader_program_manager->LoadDiskCache(title_id);
+    res_cache.LoadTexturePack(title_id);
+    res_cache.StartTextureDump(title_id);
+}
+
 bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
     const auto& regs = Pica::g_state.regs;
     if (regs.pipeline.use_gs != Pica::PipelineRegs::UseGS::No) {
@@ -398,6 +446,8 @@ bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
         }
     }
 
+    FlushBatchedDraws();
+
     if (!SetupVertexShader())
         return false;
 
@@ -490,17 +540,116 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed, bool use_gs)
 }
 
 void RasterizerOpenGL::DrawTriangles() {
+    if (vertex_batch.size() == batched_vertices)
+        return;
+    batched_vertices = vertex_batch.size();
+    ++batched_draws;
+
+    // Consecutive draws are merged into one until a register that affects the draw changes or the
+    // framebuffers are accessed. The debugger needs to see the result of every draw.
+    constexpr std::size_t max_batched_vertices = VERTEX_BUFFER_SIZE / sizeof(HardwareVertex);
+    if (batched_vertices < max_batched_vertices && !Pica::g_debug_context)
+        return;
+
+    FlushBatchedDraws();
+}
+
+void RasterizerOpenGL::FlushBatchedDraws() {
     if (vertex_batch.empty())
         return;
+
+    MICROPROFILE_SCOPE(OpenGL_DrawBatch);
+    MICROPROFILE_META_CPU("PICA draws", batched_draws);
+    ScopedGPUTimer gpu_timer(GPUPass::DrawBatch);
     Draw(false, false);
+    batched_draws = 0;
+    batched_vertices = 0;
+}
+
+void RasterizerOpenGL::TrackStereoPass(bool accelerate) {
+    const auto& regs = Pica::g_state.regs;
+    const PAddr color_addr = regs.framebuffer.framebuffer.GetColorBufferPhysicalAddress();
+    if (color_addr != current_pass.color_addr) {
+        // The software vertex path transforms the vertices on the CPU, so only its vertex counts
+        // match between the eyes, which is still enough to tell the passes apart
+        if (current_pass.draws != 0 && current_pass.draws == previous_pass.draws &&
+            current_pass.signature == previous_pass.signature &&
+            current_pass.color_addr != previous_pass.color_addr) {
+            stereo_pair_counter.Add();
+            stereo_pair_draw_counter.Add(current_pass.draws);
+            // A pass is only paired once
+            current_pass = {};
+        }
+        previous_pass = current_pass;
+        current_pass = {color_addr, 0, 0};
+    }
+
+    const auto textures = regs.texturing.GetTextures();
+    const std::array<u64, 8> draw{
+        current_pass.signature,
+        accelerate ? regs.pipeline.num_vertices : vertex_batch.size(),
+        accelerate ? regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() : 0,
+        accelerate ? regs.pipeline.index_array.offset : 0,
+        textures[0].enabled ? textures[0].config.GetPhysicalAddress() : 0,
+        textures[1].enabled ? textures[1].config.GetPhysicalAddress() : 0,
+        textures[2].enabled ? textures[2].config.GetPhysicalAddress() : 0,
+        static_cast<u64>(regs.framebuffer.framebuffer.color_format.Value()) |
+            static_cast<u64>(regs.framebuffer.framebuffer.depth_format.Value()) << 32,
+    };
+    current_pass.signature = Common::ComputeStructHash64(draw);
+    ++current_pass.draws;
+}
+
+static bool IsLUTDataRegister(u32 id) {
+    return (id >= PICA_REG_INDEX_WORKAROUND(lighting.lut_data[0], 0x1c8) &&
+            id <= PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf)) ||
+           (id >= PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[0], 0xe8) &&
+            id <= PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[7], 0xef)) ||
+           (id >= PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[0], 0xb0) &&
+            id <= PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[7], 0xb7));
+}
+
+void RasterizerOpenGL::InvalidateCPUWrites() {
+    Memory::RasterizerConsumeCPUWrites(
+        [this](PAddr addr, u32 size) { res_cache.InvalidateRegion(addr, size, nullptr); });
+}
+
+void RasterizerOpenGL::NotifyPicaRegisterChanging(u32 id, u32 value) {
+    if (vertex_batch.empty())
+        return;
+
+    // The batched triangles went through the vertex pipeline already, so the pipeline and shader
+    // registers no longer matter for them
+    if (id >= PICA_REG_INDEX(pipeline))
+        return;
+
+    // Writing the LUT data registers changes an entry even when the register value is unchanged
+    if (Pica::g_state.regs.reg_array[id] == value && !IsLUTDataRegister(id))
+        return;
+
+    FlushBatchedDraws();
 }
 
 bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     MICROPROFILE_SCOPE(OpenGL_Drawing);
+    InvalidateCPUWrites();
     const auto& regs = Pica::g_state.regs;
 
+    // Sync and bind the shader. If it is still being compiled in the background, skip the draw
+    // instead of waiting for the driver.
+    if (shader_dirty) {
+        if (!SetShader()) {
+            vertex_batch.clear();
+            return true;
+        }
+        // The generated shader replaces the ubershader as soon as it is ready
+        shader_dirty = shader_program_manager->IsFragmentUbershaderActive();
+    }
+
     bool shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
                             Pica::FramebufferRegs::FragmentOperationMode::Shadow;
+    // Follows the bound fragment shader, which can lag behind the setting
+    const bool shadow_depth_buffer = shadow_rendering && shader_uses_shadow_depth_buffer;
 
     const bool has_stencil =
         regs.framebuffer.framebuffer.depth_format == Pica::FramebufferRegs::DepthFormat::D24S8;
@@ -570,8 +719,18 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         glFramebufferParameteri(GL_DRAW_FRAMEBUFFER, GL_FRAMEBUFFER_DEFAULT_HEIGHT,
                                 color_surface->height * color_surface->res_scale);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
-                               0);
+        if (shadow_depth_buffer) {
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                                   shadow_resolver->GetDepthTexture(
+                                       color_surface->width * color_surface->res_scale,
+                                       color_surface->height * color_surface->res_scale),
+                                   0);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                                   0);
+        } else {
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
+                                   0, 0);
+        }
         state.image_shadow_buffer = color_surface->texture.handle;
     } else {
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
@@ -751,7 +910,7 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
             Surface surface = res_cache.GetTextureSurface(texture);
             if (surface != nullptr) {
                 CheckBarrier(state.texture_units[texture_index].texture_2d =
-                                 surface->texture.handle);
+                                 surface->GetSampledTexture());
             } else {
                 // Can occur when texture addr is null or its memory is unmapped/invalid
                 state.texture_units[texture_index].texture_2d = 0;
@@ -761,12 +920,6 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         }
     }
 
-    // Sync and bind the shader
-    if (shader_dirty) {
-        SetShader();
-        shader_dirty = false;
-    }
-
     // Sync the LUTs within the texture buffer
     SyncAndUploadLUTs();
 
@@ -785,6 +938,25 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     state.scissor.height = draw_rect.GetHeight();
     state.Apply();
 
+    // The depth state of the shadow draw, the PICA's own depth test doesn't apply to shadow
+    // rendering. Restored after the draw, the member state is only synced when the registers change.
+    const auto pica_depth = state.depth;
+    const auto pica_stencil_enabled = state.stencil.test_enabled;
+    if (shadow_depth_buffer) {
+        shadow_resolver->Clear(draw_rect);
+        state.depth.test_enabled = true;
+        state.depth.test_func = GL_LESS;
+        state.depth.write_mask = GL_TRUE;
+        state.stencil.test_enabled = false;
+        state.Apply();
+    }
+
+    draw_counter.Add();
+    draw_vertex_counter.Add(accelerate ? regs.pipeline.num_vertices : vertex_batch.size());
+    if (Settings::GetSnapshot().toggle_3d) {
+        TrackStereoPass(accelerate);
+    }
+
     // Draw the vertex batch
     bool succeeded = true;
     if (accelerate) {
@@ -814,6 +986,15 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
 
     vertex_batch.clear();
 
+    if (shadow_depth_buffer) {
+        state.depth = pica_depth;
+        state.stencil.test_enabled = pica_stencil_enabled;
+        state.Apply();
+        // The depth texture is sampled by the resolve pass
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+        shadow_resolver->Resolve(draw_rect);
+    }
+
     // Reset textures in rasterizer state context because the rasterizer cache might delete them
     for (unsigned texture_index = 0; texture_index < pica_textures.size(); ++texture_index) {
         state.texture_units[texture_index].texture_2d = 0;
@@ -843,6 +1024,7 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     MathUtil::Rectangle<u32> draw_rect_unscaled{
         draw_rect.left / res_scale, draw_rect.top / res_scale, draw_rect.right / res_scale,
         draw_rect.bottom / res_scale};
+    res_cache.AddDrawnPixels(draw_rect_unscaled.GetWidth() * draw_rect_unscaled.GetHeight());
 
     if (color_surface != nullptr && write_color_fb) {
         auto interval = color_surface->GetSubRectInterval(draw_rect_unscaled);
@@ -915,7 +1097,9 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[5], 0xed):
     case PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[6], 0xee):
     case PICA_REG_INDEX_WORKAROUND(texturing.fog_lut_data[7], 0xef):
-        uniform_block_data.fog_lut_dirty = true;
+        // The index was already advanced past the written entry
+        uniform_block_data.fog_lut_dirty.Mark((regs.texturing.fog_lut_offset - 1) %
+                                              static_cast<u32>(fog_lut_data.size()));
         break;
 
     // ProcTex state
@@ -939,26 +1123,34 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[4], 0xb4):
     case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[5], 0xb5):
     case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[6], 0xb6):
-    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[7], 0xb7):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[7], 0xb7): {
         using Pica::TexturingRegs;
+        // The index was already advanced past the written entry
+        const u32 index = regs.texturing.proctex_lut_config.index - 1;
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
-            uniform_block_data.proctex_noise_lut_dirty = true;
+            uniform_block_data.proctex_noise_lut_dirty.Mark(
+                index % static_cast<u32>(proctex_noise_lut_data.size()));
             break;
         case TexturingRegs::ProcTexLutTable::ColorMap:
-            uniform_block_data.proctex_color_map_dirty = true;
+            uniform_block_data.proctex_color_map_dirty.Mark(
+                index % static_cast<u32>(proctex_color_map_data.size()));
             break;
         case TexturingRegs::ProcTexLutTable::AlphaMap:
-            uniform_block_data.proctex_alpha_map_dirty = true;
+            uniform_block_data.proctex_alpha_map_dirty.Mark(
+                index % static_cast<u32>(proctex_alpha_map_data.size()));
             break;
         case TexturingRegs::ProcTexLutTable::Color:
-            uniform_block_data.proctex_lut_dirty = true;
+            uniform_block_data.proctex_lut_dirty.Mark(
+                index % static_cast<u32>(proctex_lut_data.size()));
             break;
         case TexturingRegs::ProcTexLutTable::ColorDiff:
-            uniform_block_data.proctex_diff_lut_dirty = true;
+            uniform_block_data.proctex_diff_lut_dirty.Mark(
+                index % static_cast<u32>(proctex_diff_lut_data.size()));
             break;
         }
         break;
+    }
 
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
@@ -1336,7 +1528,9 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[6], 0x1ce):
     case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf): {
         auto& lut_config = regs.lighting.lut_config;
-        uniform_block_data.lighting_lut_dirty[lut_config.type] = true;
+        // The index was already advanced past the written entry
+        uniform_block_data.lighting_lut_dirty[lut_config.type].Mark(
+            (lut_config.index - 1) % static_cast<u32>(lighting_lut_data[0].size()));
         uniform_block_data.lighting_lut_dirty_any = true;
         break;
     }
@@ -1345,27 +1539,38 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
 
 void RasterizerOpenGL::FlushAll() {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
     res_cache.FlushAll();
 }
 
 void RasterizerOpenGL::FlushRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
     res_cache.FlushRegion(addr, size);
 }
 
 void RasterizerOpenGL::InvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
     res_cache.InvalidateRegion(addr, size, nullptr);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
     res_cache.FlushRegion(addr, size);
     res_cache.InvalidateRegion(addr, size, nullptr);
 }
 
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
     MICROPROFILE_SCOPE(OpenGL_Blits);
+    FlushBatchedDraws();
+    ScopedGPUTimer gpu_timer(GPUPass::DisplayTransfer);
+    InvalidateCPUWrites();
 
     SurfaceParams src_params;
     src_params.addr = config.GetPhysicalInputAddress();
@@ -1412,10 +1617,18 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
         return false;
 
     res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+
+    // The transfer marks the end of rendering to the source, start reading both back early if
+    // the CPU has accessed them before
+    res_cache.ResolveSurface(src_surface);
+    res_cache.ResolveSurface(dst_surface);
     return true;
 }
 
 bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferConfig& config) {
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
+
     u32 copy_size = Common::AlignDown(config.texture_copy.size, 16);
     if (copy_size == 0) {
         return false;
@@ -1455,6 +1668,12 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferCon
     src_params.size = ((src_params.height - 1) * src_params.stride) + src_params.width;
     src_params.end = src_params.addr + src_params.size;
 
+    return AccelerateSurfaceCopy(src_params, config.GetPhysicalOutputAddress(), output_width,
+                                 output_gap);
+}
+
+bool RasterizerOpenGL::AccelerateSurfaceCopy(const SurfaceParams& src_params, PAddr dst_addr,
+                                             u32 output_width, u32 output_gap) {
     MathUtil::Rectangle<u32> src_rect;
     Surface src_surface;
     std::tie(src_surface, src_rect) = res_cache.GetTexCopySurface(src_params);
@@ -1470,7 +1689,7 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferCon
     }
 
     SurfaceParams dst_params = *src_surface;
-    dst_params.addr = config.GetPhysicalOutputAddress();
+    dst_params.addr = dst_addr;
     dst_params.width = src_rect.GetWidth() / src_surface->res_scale;
     dst_params.stride = dst_params.width + src_surface->PixelsInBytes(
                                                src_surface->is_tiled ? output_gap / 8 : output_gap);
@@ -1501,6 +1720,9 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferCon
 }
 
 bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config) {
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
+
     Surface dst_surface = res_cache.GetFillSurface(config);
     if (dst_surface == nullptr)
         return false;
@@ -1509,9 +1731,91 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
     return true;
 }
 
+/// Physical address of a virtual region of the linear heaps or VRAM, or 0 for other regions
+static PAddr GetLinearPhysicalAddress(VAddr addr, u32 size) {
+    const auto in_region = [addr, size](VAddr region_start, VAddr region_end) {
+        return addr >= region_start && addr < region_end && size <= region_end - addr;
+    };
+    if (in_region(Memory::LINEAR_HEAP_VADDR, Memory::LINEAR_HEAP_VADDR_END))
+        return Memory::FCRAM_PADDR + (addr - Memory::LINEAR_HEAP_VADDR);
+    if (in_region(Memory::NEW_LINEAR_HEAP_VADDR, Memory::NEW_LINEAR_HEAP_VADDR_END))
+        return Memory::FCRAM_PADDR + (addr - Memory::NEW_LINEAR_HEAP_VADDR);
+    if (in_region(Memory::VRAM_VADDR, Memory::VRAM_VADDR_END))
+        return Memory::VRAM_PADDR + (addr - Memory::VRAM_VADDR);
+    return 0;
+}
+
+bool RasterizerOpenGL::AccelerateY2RConversion(Service::Y2R::ConversionConfiguration& config) {
+    if (!y2r_converter.IsValid() || !Y2RConverter::CanConvert(config))
+        return false;
+
+    const PAddr dst_addr =
+        GetLinearPhysicalAddress(config.dst.address, HW::Y2R::GetOutputSize(config));
+    if (dst_addr == 0)
+        return false;
+
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
+
+    SurfaceParams dst_params;
+    dst_params.addr = dst_addr;
+    dst_params.width = config.input_line_width;
+    dst_params.height = config.input_lines;
+    dst_params.is_tiled = config.block_alignment == Service::Y2R::BlockAlignment::Block8x8;
+    // The output formats have the values of the color formats
+    dst_params.pixel_format = static_cast<SurfaceParams::PixelFormat>(config.output_format);
+    dst_params.UpdateParams();
+
+    MathUtil::Rectangle<u32> dst_rect;
+    Surface dst_surface;
+    std::tie(dst_surface, dst_rect) =
+        res_cache.GetSurfaceSubRect(dst_params, ScaleMatch::Ignore, false);
+    if (dst_surface == nullptr)
+        return false;
+
+    dst_surface->InvalidateAllWatcher();
+    y2r_converter.Convert(config, dst_surface->texture.handle, dst_rect, dst_surface->res_scale,
+                          dst_surface->is_tiled);
+    res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+    res_cache.ResolveSurface(dst_surface);
+    return true;
+}
+
+bool RasterizerOpenGL::AccelerateDma(VAddr src_vaddr, VAddr dst_vaddr, u32 size) {
+    const PAddr src_addr = GetLinearPhysicalAddress(src_vaddr, size);
+    const PAddr dst_addr = GetLinearPhysicalAddress(dst_vaddr, size);
+    if (size == 0 || src_addr == 0 || dst_addr == 0)
+        return false;
+
+    // A blit can't read and write overlapping parts of the same texture
+    if (src_addr < dst_addr + size && dst_addr < src_addr + size)
+        return false;
+
+    // Only copies between surfaces stay on the GPU, data the CPU will read next is copied by it
+    if (!res_cache.IsRegionCached(dst_addr, size))
+        return false;
+
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
+
+    // A DMA request is a texture copy without gaps
+    SurfaceParams src_params;
+    src_params.addr = src_addr;
+    src_params.stride = size;
+    src_params.width = size;
+    src_params.height = 1;
+    src_params.size = size;
+    src_params.end = src_addr + size;
+
+    return AccelerateSurfaceCopy(src_params, dst_addr, size, 0);
+}
+
 bool RasterizerOpenGL::AccelerateDisplay(const GPU::Regs::FramebufferConfig& config,
                                          PAddr framebuffer_addr, u32 pixel_stride,
                                          ScreenInfo& screen_info) {
+    FlushBatchedDraws();
+    InvalidateCPUWrites();
+
     if (framebuffer_addr == 0) {
         return false;
     }
@@ -1590,9 +1894,12 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
     }
 }
 
-void RasterizerOpenGL::SetShader() {
+bool RasterizerOpenGL::SetShader() {
     auto config = PicaFSConfig::BuildFromRegs(Pica::g_state.regs);
-    shader_program_manager->UseFragmentShader(config);
+    config.state.shadow_depth_buffer = config.state.shadow_rendering && shadow_resolver &&
+                                       Settings::GetSnapshot().use_shadow_depth_buffer;
+    shader_uses_shadow_depth_buffer = config.state.shadow_depth_buffer;
+    return shader_program_manager->UseFragmentShader(config);
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
@@ -1913,11 +2220,12 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
                                      sizeof(GLvec4) * 256 +     // proctex
                                      sizeof(GLvec4) * 256;      // proctex diff
 
-    if (!uniform_block_data.lighting_lut_dirty_any && !uniform_block_data.fog_lut_dirty &&
-        !uniform_block_data.proctex_noise_lut_dirty &&
-        !uniform_block_data.proctex_color_map_dirty &&
-        !uniform_block_data.proctex_alpha_map_dirty && !uniform_block_data.proctex_lut_dirty &&
-        !uniform_block_data.proctex_diff_lut_dirty) {
+    if (!uniform_block_data.lighting_lut_dirty_any && uniform_block_data.fog_lut_dirty.Empty() &&
+        uniform_block_data.proctex_noise_lut_dirty.Empty() &&
+        uniform_block_data.proctex_color_map_dirty.Empty() &&
+        uniform_block_data.proctex_alpha_map_dirty.Empty() &&
+        uniform_block_data.proctex_lut_dirty.Empty() &&
+        uniform_block_data.proctex_diff_lut_dirty.Empty()) {
         return;
     }
 
@@ -1928,132 +2236,70 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
     glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.GetHandle());
     std::tie(buffer, offset, invalidate) = texture_buffer.Map(max_size, sizeof(GLvec4));
 
-    // Sync the lighting luts
-    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
-        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
-            if (uniform_block_data.lighting_lut_dirty[index] || invalidate) {
-                std::array<GLvec2, 256> new_data;
-                const auto& source_lut = Pica::g_state.lighting.luts[index];
-                std::transform(source_lut.begin(), source_lut.end(), new_data.begin(),
-                               [](const auto& entry) {
-                                   return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                               });
-
-                if (new_data != lighting_lut_data[index] || invalidate) {
-                    lighting_lut_data[index] = new_data;
-                    std::memcpy(buffer + bytes_used, new_data.data(),
-                                new_data.size() * sizeof(GLvec2));
-                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4] =
-                        (offset + bytes_used) / sizeof(GLvec2);
-                    uniform_block_data.dirty = true;
-                    bytes_used += new_data.size() * sizeof(GLvec2);
-                }
-                uniform_block_data.lighting_lut_dirty[index] = false;
+    // Converts the written entries of a LUT and uploads the whole table if any of them changed.
+    // The previous copies may have been overwritten when the buffer wrapped around, so then all
+    // the tables are uploaded again.
+    auto SyncLUT = [this, buffer, offset, invalidate, &bytes_used](
+                       const auto& lut, auto& lut_data, LUTDirtyRange& dirty_range,
+                       auto& lut_offset, auto convert) {
+        bool changed = invalidate;
+        for (u32 i = dirty_range.begin; i < dirty_range.end; ++i) {
+            const auto new_entry = convert(lut[i]);
+            if (new_entry != lut_data[i]) {
+                lut_data[i] = new_entry;
+                changed = true;
             }
         }
-    }
-    uniform_block_data.lighting_lut_dirty_any = false;
+        dirty_range.Clear();
 
-    // Sync the fog lut
-    if (uniform_block_data.fog_lut_dirty || invalidate) {
-        std::array<GLvec2, 128> new_data;
-
-        std::transform(Pica::g_state.fog.lut.begin(), Pica::g_state.fog.lut.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                       });
-
-        if (new_data != fog_lut_data || invalidate) {
-            fog_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            uniform_block_data.data.fog_lut_offset = (offset + bytes_used) / sizeof(GLvec2);
+        if (changed) {
+            constexpr std::size_t entry_size = sizeof(lut_data[0]);
+            std::memcpy(buffer + bytes_used, lut_data.data(), lut_data.size() * entry_size);
+            lut_offset = static_cast<GLint>((offset + bytes_used) / entry_size);
             uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
-        }
-        uniform_block_data.fog_lut_dirty = false;
-    }
-
-    // helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
-    auto SyncProcTexValueLUT = [this, buffer, offset, invalidate, &bytes_used](
-                                   const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
-                                   std::array<GLvec2, 128>& lut_data, GLint& lut_offset) {
-        std::array<GLvec2, 128> new_data;
-        std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-            return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-        });
-
-        if (new_data != lut_data || invalidate) {
-            lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
+            bytes_used += lut_data.size() * entry_size;
         }
     };
 
-    // Sync the proctex noise lut
-    if (uniform_block_data.proctex_noise_lut_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
-                            uniform_block_data.data.proctex_noise_lut_offset);
-        uniform_block_data.proctex_noise_lut_dirty = false;
-    }
-
-    // Sync the proctex color map
-    if (uniform_block_data.proctex_color_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
-                            uniform_block_data.data.proctex_color_map_offset);
-        uniform_block_data.proctex_color_map_dirty = false;
-    }
-
-    // Sync the proctex alpha map
-    if (uniform_block_data.proctex_alpha_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
-                            uniform_block_data.data.proctex_alpha_map_offset);
-        uniform_block_data.proctex_alpha_map_dirty = false;
-    }
-
-    // Sync the proctex lut
-    if (uniform_block_data.proctex_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
-
-        std::transform(Pica::g_state.proctex.color_table.begin(),
-                       Pica::g_state.proctex.color_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
+    const auto ValueEntryToGL = [](const auto& entry) {
+        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
+    };
+    const auto ColorEntryToGL = [](const auto& entry) {
+        auto rgba = entry.ToVector() / 255.0f;
+        return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
+    };
 
-        if (new_data != proctex_lut_data || invalidate) {
-            proctex_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_lut_offset = (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
+    // Sync the lighting luts
+    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
+        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
+            SyncLUT(Pica::g_state.lighting.luts[index], lighting_lut_data[index],
+                    uniform_block_data.lighting_lut_dirty[index],
+                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4],
+                    ValueEntryToGL);
         }
-        uniform_block_data.proctex_lut_dirty = false;
     }
+    uniform_block_data.lighting_lut_dirty_any = false;
 
-    // Sync the proctex difference lut
-    if (uniform_block_data.proctex_diff_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
-
-        std::transform(Pica::g_state.proctex.color_diff_table.begin(),
-                       Pica::g_state.proctex.color_diff_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
-
-        if (new_data != proctex_diff_lut_data || invalidate) {
-            proctex_diff_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_diff_lut_offset =
-                (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
-        }
-        uniform_block_data.proctex_diff_lut_dirty = false;
-    }
+    // Sync the fog lut
+    SyncLUT(Pica::g_state.fog.lut, fog_lut_data, uniform_block_data.fog_lut_dirty,
+            uniform_block_data.data.fog_lut_offset, ValueEntryToGL);
+
+    // Sync the proctex luts
+    SyncLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
+            uniform_block_data.proctex_noise_lut_dirty,
+            uniform_block_data.data.proctex_noise_lut_offset, ValueEntryToGL);
+    SyncLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
+            uniform_block_data.proctex_color_map_dirty,
+            uniform_block_data.data.proctex_color_map_offset, ValueEntryToGL);
+    SyncLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
+            uniform_block_data.proctex_alpha_map_dirty,
+            uniform_block_data.data.proctex_alpha_map_offset, ValueEntryToGL);
+    SyncLUT(Pica::g_state.proctex.color_table, proctex_lut_data,
+            uniform_block_data.proctex_lut_dirty, uniform_block_data.data.proctex_lut_offset,
+            ColorEntryToGL);
+    SyncLUT(Pica::g_state.proctex.color_diff_table, proctex_diff_lut_data,
+            uniform_block_data.proctex_diff_lut_dirty,
+            uniform_block_data.data.proctex_diff_lut_offset, ColorEntryToGL);
 
     texture_buffer.Unmap(bytes_used);
 }
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
@@ -24,8 +25,10 @@
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
+#include "video_core/renderer_opengl/gl_shadow_resolver.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_y2r_converter.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 #include "video_core/shader/shader.h"
 
@@ -42,6 +45,7 @@ public:
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
     void DrawTriangles() override;
+    void NotifyPicaRegisterChanging(u32 id, u32 value) override;
     void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override;
     void FlushRegion(PAddr addr, u32 size) override;
@@ -50,9 +54,13 @@ public:
     bool AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) override;
     bool AccelerateTextureCopy(const GPU::Regs::DisplayTransferConfig& config) override;
     bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config) override;
+    bool AccelerateY2RConversion(Service::Y2R::ConversionConfiguration& config) override;
+    bool AccelerateDma(VAddr src_addr, VAddr dst_addr, u32 size) override;
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    void NotifyFramePresented() override;
+    void LoadDiskResources(u64 title_id) override;
 
 private:
     struct SamplerInfo {
@@ -128,7 +136,8 @@ private:
     void SyncClipCoef();
 
     /// Sets the OpenGL shader in accordance with the current PICA register state
-    void SetShader();
+    /// @returns false if the shader is still being compiled in the background
+    bool SetShader();
 
     /// Syncs the cull mode to match the PICA register
     void SyncCullMode();
@@ -220,9 +229,25 @@ private:
     /// Upload the uniform blocks to the uniform buffer object
     void UploadUniforms(bool accelerate_draw, bool use_gs);
 
+    /// Draws the triangles that DrawTriangles merged into the vertex batch
+    void FlushBatchedDraws();
+
+    /// Invalidates the cached surfaces written by the CPU since the cache was last used
+    void InvalidateCPUWrites();
+
+    /// Copies the bytes of a surface described by src_params to dst_addr on the GPU, for
+    /// AccelerateTextureCopy and AccelerateDma. Each row of output_width bytes is followed by
+    /// output_gap bytes that are left as they are.
+    bool AccelerateSurfaceCopy(const SurfaceParams& src_params, PAddr dst_addr, u32 output_width,
+                               u32 output_gap);
+
     /// Generic draw function for DrawTriangles and AccelerateDrawBatch
     bool Draw(bool accelerate, bool is_indexed);
 
+    /// Adds a draw to the render pass it belongs to, ending the previous pass when the color
+    /// buffer changes
+    void TrackStereoPass(bool accelerate);
+
     /// Internal implementation for AccelerateDrawBatch
     bool AccelerateDrawBatchInternal(bool is_indexed, bool use_gs);
 
@@ -250,23 +275,71 @@ private:
     OpenGLState state;
 
     RasterizerCacheOpenGL res_cache;
+    Y2RConverter y2r_converter;
 
     EmuWindow& emu_window;
 
     std::vector<HardwareVertex> vertex_batch;
+    /// Number of PICA draws whose triangles are in vertex_batch
+    u32 batched_draws = 0;
+    std::size_t batched_vertices = 0;
+
+    /**
+     * Draws made to one color buffer in a row. Stereoscopic titles render the right eye with the
+     * same draws as the left one, only the projection and the color buffer differ, so two passes
+     * with the same signature to different buffers are one eye each. Only counted for now, the
+     * draws are submitted as they come and can't be merged into one layered pass after the fact.
+     */
+    struct StereoPass {
+        PAddr color_addr = 0;
+        /// Hash of the draws' vertex counts, sources, textures and buffer formats
+        u64 signature = 0;
+        u32 draws = 0;
+    };
+    StereoPass current_pass;
+    StereoPass previous_pass;
 
     bool shader_dirty;
 
+    /// Range of the entries of a LUT that were written since it was last synced
+    struct LUTDirtyRange {
+        u32 begin = 0;
+        u32 end = 0;
+
+        void Mark(u32 index) {
+            if (Empty()) {
+                begin = index;
+                end = index + 1;
+            } else {
+                begin = std::min(begin, index);
+                end = std::max(end, index + 1);
+            }
+        }
+
+        void MarkAll(u32 size) {
+            begin = 0;
+            end = size;
+        }
+
+        void Clear() {
+            begin = end = 0;
+        }
+
+        bool Empty() const {
+            return begin == end;
+        }
+    };
+
     struct {
         UniformData data;
-        std::array<bool, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
+        std::array<LUTDirtyRange, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
         bool lighting_lut_dirty_any;
-        bool fog_lut_dirty;
-        bool proctex_noise_lut_dirty;
-        bool proctex_color_map_dirty;
-        bool proctex_alpha_map_dirty;
-        bool proctex_lut_dirty;
-        bool proctex_diff_lut_dirty;
+        LUTDirtyRange fog_lut_dirty;
+        LUTDirtyRange proctex_noise_lut_dirty;
+        LUTDirtyRange proctex_color_map_dirty;
+        LUTDirtyRange proctex_alpha_map_dirty;
+        LUTDirtyRange proctex_lut_dirty;
+        LUTDirtyRange proctex_diff_lut_dirty;
         bool dirty;
     } uniform_block_data = {};
 
@@ -307,6 +380,10 @@ private:
     std::array<GLvec4, 256> proctex_diff_lut_data{};
 
     bool allow_shadow;
+    /// Present when shadow draws can use a depth attachment for the fragments without penumbra
+    std::unique_ptr<ShadowDepthResolver> shadow_resolver;
+    /// Whether the last fragment shader set writes the depth attachment of shadow draws
+    bool shader_uses_shadow_depth_buffer = false;
 };
 
 } // namespace OpenGL
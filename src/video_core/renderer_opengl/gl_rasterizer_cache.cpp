@@ -5,10 +5,12 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -17,17 +19,27 @@
 #include "common/alignment.h"
 #include "common/bit_field.h"
 #include "common/color.h"
+#include "common/frame_counters.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/frontend/emu_window.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_gpu_timer.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
+#include "video_core/renderer_opengl/gl_texture_filterer.h"
+#include "video_core/renderer_opengl/gl_texture_pack.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
@@ -59,6 +71,9 @@ static constexpr std::array<FormatTuple, 4> depth_format_tuples = {{
 
 static constexpr FormatTuple tex_tuple = {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
 
+/// Size of the texture upload ring, larger uploads are passed to the driver directly
+constexpr GLsizeiptr UPLOAD_BUFFER_SIZE = 32 * 1024 * 1024;
+
 static const FormatTuple& GetFormatTuple(PixelFormat pixel_format) {
     const SurfaceType type = SurfaceParams::GetFormatType(pixel_format);
     if (type == SurfaceType::Color) {
@@ -222,8 +237,13 @@ static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tup
     cur_state.Apply();
     glActiveTexture(GL_TEXTURE0);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format_tuple.internal_format, width, height, 0,
-                 format_tuple.format, format_tuple.type, nullptr);
+    if (GLAD_GL_ARB_texture_storage) {
+        // Immutable storage, the texture may be recycled for another surface of the same format
+        glTexStorage2D(GL_TEXTURE_2D, 1, format_tuple.internal_format, width, height);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, format_tuple.internal_format, width, height, 0,
+                     format_tuple.format, format_tuple.type, nullptr);
+    }
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -235,6 +255,34 @@ static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tup
     cur_state.Apply();
 }
 
+static void UploadCustomTexture(GLuint texture, const CustomTexture& custom) {
+    OpenGLState cur_state = OpenGLState::GetCurState();
+
+    // Keep track of previous texture bindings
+    GLuint old_tex = cur_state.texture_units[0].texture_2d;
+    cur_state.texture_units[0].texture_2d = texture;
+    cur_state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    // Compressed data is copied as it is, the driver doesn't decode it
+    for (std::size_t level = 0; level < custom.levels.size(); ++level) {
+        const CustomTexture::Level& info = custom.levels[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), custom.internal_format,
+                               info.width, info.height, 0, static_cast<GLsizei>(info.size),
+                               custom.data.data() + info.offset);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(custom.levels.size() - 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Restore previous texture bindings
+    cur_state.texture_units[0].texture_2d = old_tex;
+    cur_state.Apply();
+}
+
 static void AllocateTextureCube(GLuint texture, const FormatTuple& format_tuple, u32 width) {
     OpenGLState cur_state = OpenGLState::GetCurState();
 
@@ -261,6 +309,23 @@ static void AllocateTextureCube(GLuint texture, const FormatTuple& format_tuple,
     cur_state.Apply();
 }
 
+/// Attaches a texture to the bound read framebuffer, in the attachment matching its type
+static void AttachToReadFramebuffer(GLuint tex, SurfaceType type) {
+    if (type == SurfaceType::Color || type == SurfaceType::Texture) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                               0);
+    } else if (type == SurfaceType::Depth) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, tex, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    } else {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, tex,
+                               0);
+    }
+}
+
 static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rect, GLuint dst_tex,
                          const MathUtil::Rectangle<u32>& dst_rect, SurfaceType type,
                          GLuint read_fb_handle, GLuint draw_fb_handle) {
@@ -273,6 +338,7 @@ static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rec
     state.Apply();
 
     u32 buffers = 0;
+    GLenum dst_attachment = GL_COLOR_ATTACHMENT0;
 
     if (type == SurfaceType::Color || type == SurfaceType::Texture) {
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src_tex,
@@ -296,6 +362,7 @@ static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rec
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
 
         buffers = GL_DEPTH_BUFFER_BIT;
+        dst_attachment = GL_DEPTH_ATTACHMENT;
     } else if (type == SurfaceType::DepthStencil) {
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
@@ -306,6 +373,17 @@ static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rec
                                dst_tex, 0);
 
         buffers = GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+        dst_attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+    }
+
+    // The blit overwrites the whole destination rectangle, so its old contents don't have to be
+    // loaded. Tile-based GPUs otherwise read them back into the tile memory first.
+    if (GLAD_GL_ARB_invalidate_subdata) {
+        glInvalidateSubFramebuffer(GL_DRAW_FRAMEBUFFER, 1, &dst_attachment,
+                                   static_cast<GLint>(dst_rect.left),
+                                   static_cast<GLint>(dst_rect.bottom),
+                                   static_cast<GLsizei>(dst_rect.GetWidth()),
+                                   static_cast<GLsizei>(dst_rect.GetHeight()));
     }
 
     // TODO (wwylele): use GL_NEAREST for shadow map texture
@@ -514,6 +592,10 @@ bool SurfaceParams::CanTexCopy(const SurfaceParams& texcopy_params) const {
     return FromInterval(texcopy_params.GetInterval()).GetInterval() == texcopy_params.GetInterval();
 }
 
+CachedSurface::~CachedSurface() {
+    owner.RecycleTexture(pixel_format, GetScaledWidth(), GetScaledHeight(), std::move(texture));
+}
+
 bool CachedSurface::CanFill(const SurfaceParams& dest_surface,
                             SurfaceInterval fill_interval) const {
     if (type == SurfaceType::Fill && IsRegionValid(fill_interval) &&
@@ -630,19 +712,70 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
     UNREACHABLE();
 }
 
+void CachedSurface::LoadGLTexture(const SurfaceParams& params, GLuint read_fb_handle,
+                                  GLuint draw_fb_handle) {
+    const auto rect = GetSubRect(params);
+    const std::size_t bytes_per_pixel = GetGLBytesPerPixel(pixel_format);
+    // The decoders write whole rows of the stride
+    const std::size_t rows_offset = rect.bottom * stride * bytes_per_pixel;
+    const std::size_t rows_size = rect.GetHeight() * stride * bytes_per_pixel;
+    const std::size_t left_offset = rect.left * bytes_per_pixel;
+
+    OGLStreamBuffer* const upload_buffer = owner.upload_buffer.get();
+    if (upload_buffer != nullptr && rows_size <= static_cast<std::size_t>(UPLOAD_BUFFER_SIZE)) {
+        // Decode straight into the upload ring, so that the driver transfers the rows to the
+        // texture asynchronously without any other copy
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_buffer->GetHandle());
+        u8* ring_ptr;
+        GLintptr ring_offset;
+        std::tie(ring_ptr, ring_offset, std::ignore) = upload_buffer->Map(rows_size, 4);
+        // Only the rows of the rectangle are written through the buffer
+        LoadGLBuffer(params.addr, params.end, ring_ptr - rows_offset);
+        upload_buffer->Unmap(rows_size);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        UploadGLTexture(rect, reinterpret_cast<const void*>(ring_offset + left_offset),
+                        upload_buffer->GetHandle(), read_fb_handle, draw_fb_handle);
+        return;
+    }
+
+    u8* const buffer = owner.GetStagingBuffer(rows_offset + rows_size);
+    LoadGLBuffer(params.addr, params.end, buffer);
+    UploadGLTexture(rect, buffer + rows_offset + left_offset, 0, read_fb_handle, draw_fb_handle);
+}
+
+void CachedSurface::FlushGLTexture(SurfaceInterval interval, GLuint read_fb_handle,
+                                   GLuint draw_fb_handle) {
+    const PAddr flush_start = boost::icl::first(interval);
+    const PAddr flush_end = boost::icl::last_next(interval);
+    if (type == SurfaceType::Fill) {
+        FlushGLBuffer(flush_start, flush_end, nullptr);
+        return;
+    }
+
+    const SurfaceParams params = FromInterval(interval);
+    const auto rect = GetSubRect(params);
+    const std::size_t bytes_per_pixel = GetGLBytesPerPixel(pixel_format);
+    u8* const buffer = owner.GetStagingBuffer(stride * rect.top * bytes_per_pixel);
+    if (width != stride) {
+        // The pixels past the width of the rows are flushed as well, they have to keep the
+        // content of 3DS memory
+        LoadGLBuffer(params.addr, params.end, buffer);
+    }
+    if (!FinishDownload(interval, buffer)) {
+        DownloadGLTexture(rect, buffer, read_fb_handle, draw_fb_handle);
+    }
+    FlushGLBuffer(flush_start, flush_end, buffer);
+}
+
 MICROPROFILE_DEFINE(OpenGL_SurfaceLoad, "OpenGL", "Surface Load", MP_RGB(128, 192, 64));
-void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
+void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end, u8* buffer) {
     ASSERT(type != SurfaceType::Fill);
 
     const u8* const texture_src_data = VideoCore::g_memory->GetPhysicalPointer(addr);
     if (texture_src_data == nullptr)
         return;
 
-    if (gl_buffer == nullptr) {
-        gl_buffer_size = width * height * GetGLBytesPerPixel(pixel_format);
-        gl_buffer.reset(new u8[gl_buffer_size]);
-    }
-
     // TODO: Should probably be done in ::Memory:: and check for other regions too
     if (load_start < Memory::VRAM_VADDR_END && load_end > Memory::VRAM_VADDR_END)
         load_end = Memory::VRAM_VADDR_END;
@@ -657,8 +790,7 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
 
     if (!is_tiled) {
         ASSERT(type == SurfaceType::Color);
-        std::memcpy(&gl_buffer[start_offset], texture_src_data + start_offset,
-                    load_end - load_start);
+        std::memcpy(buffer + start_offset, texture_src_data + start_offset, load_end - load_start);
     } else {
         if (type == SurfaceType::Texture) {
             Pica::Texture::TextureInfo tex_info{};
@@ -672,29 +804,20 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
-                }
-            }
+            Pica::Texture::DecodeTexture(texture_src_data, tex_info, buffer, rect);
         } else {
-            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                     addr, load_start, load_end);
+            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, buffer, addr,
+                                                                     load_start, load_end);
         }
     }
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceFlush, "OpenGL", "Surface Flush", MP_RGB(128, 192, 64));
-void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
+void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end, u8* buffer) {
     u8* const dst_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
     if (dst_buffer == nullptr)
         return;
 
-    ASSERT(gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format));
-
     // TODO: Should probably be done in ::Memory:: and check for other regions too
     // same as loadglbuffer()
     if (flush_start < Memory::VRAM_VADDR_END && flush_end > Memory::VRAM_VADDR_END)
@@ -725,27 +848,26 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
             std::memcpy(&dst_buffer[coarse_start_offset], &backup_data[0], backup_bytes);
     } else if (!is_tiled) {
         ASSERT(type == SurfaceType::Color);
-        std::memcpy(dst_buffer + start_offset, &gl_buffer[start_offset], flush_end - flush_start);
+        std::memcpy(dst_buffer + start_offset, buffer + start_offset, flush_end - flush_start);
     } else {
-        gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                 addr, flush_start, flush_end);
+        gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](stride, height, buffer, addr,
+                                                                 flush_start, flush_end);
     }
 }
 
 MICROPROFILE_DEFINE(OpenGL_TextureUL, "OpenGL", "Texture Upload", MP_RGB(128, 192, 64));
-void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
+void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, const void* pixels,
+                                    GLuint unpack_buffer, GLuint read_fb_handle,
                                     GLuint draw_fb_handle) {
     if (type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureUL);
-
-    ASSERT(gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format));
+    ScopedGPUTimer gpu_timer(GPUPass::TextureUpload);
 
     // Load data from memory to the surface
     GLint x0 = static_cast<GLint>(rect.left);
     GLint y0 = static_cast<GLint>(rect.bottom);
-    std::size_t buffer_offset = (y0 * stride + x0) * GetGLBytesPerPixel(pixel_format);
 
     const FormatTuple& tuple = GetFormatTuple(pixel_format);
     GLuint target_tex = texture.handle;
@@ -753,12 +875,15 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
     // If not 1x scale, create 1x texture that we will blit from to replace texture subrect in
     // surface
     OGLTexture unscaled_tex;
+    SCOPE_EXIT({
+        owner.RecycleTexture(pixel_format, rect.GetWidth(), rect.GetHeight(),
+                             std::move(unscaled_tex));
+    });
     if (res_scale != 1) {
         x0 = 0;
         y0 = 0;
 
-        unscaled_tex.Create();
-        AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth(), rect.GetHeight());
+        unscaled_tex = owner.AllocateTexture(pixel_format, rect.GetWidth(), rect.GetHeight());
         target_tex = unscaled_tex.handle;
     }
 
@@ -772,11 +897,15 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
     ASSERT(stride * GetGLBytesPerPixel(pixel_format) % 4 == 0);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride));
 
+    if (unpack_buffer != 0) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+    }
     glActiveTexture(GL_TEXTURE0);
     glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, static_cast<GLsizei>(rect.GetWidth()),
-                    static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type,
-                    &gl_buffer[buffer_offset]);
-
+                    static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type, pixels);
+    if (unpack_buffer != 0) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
     cur_state.texture_units[0].texture_2d = old_tex;
@@ -789,26 +918,32 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
 
-        BlitTextures(unscaled_tex.handle, {0, rect.GetHeight(), rect.GetWidth(), 0}, texture.handle,
-                     scaled_rect, type, read_fb_handle, draw_fb_handle);
+        if (owner.texture_filterer != nullptr && TextureFilterer::CanFilter(*this)) {
+            owner.texture_filterer->Filter(unscaled_tex.handle,
+                                           {0, rect.GetHeight(), rect.GetWidth(), 0},
+                                           texture.handle, scaled_rect);
+        } else {
+            BlitTextures(unscaled_tex.handle, {0, rect.GetHeight(), rect.GetWidth(), 0},
+                         texture.handle, scaled_rect, type, read_fb_handle, draw_fb_handle);
+        }
     }
 
     InvalidateAllWatcher();
 }
 
 MICROPROFILE_DEFINE(OpenGL_TextureDL, "OpenGL", "Texture Download", MP_RGB(128, 192, 64));
-void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                                      GLuint draw_fb_handle) {
+void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, u8* buffer,
+                                      GLuint read_fb_handle, GLuint draw_fb_handle) {
     if (type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureDL);
 
-    if (gl_buffer == nullptr) {
-        gl_buffer_size = width * height * GetGLBytesPerPixel(pixel_format);
-        gl_buffer.reset(new u8[gl_buffer_size]);
-    }
+    ReadGLTexture(rect, read_fb_handle, draw_fb_handle, buffer);
+}
 
+void CachedSurface::ReadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
+                                  GLuint draw_fb_handle, u8* dest) {
     OpenGLState state = OpenGLState::GetCurState();
     OpenGLState prev_state = state;
     SCOPE_EXIT({ prev_state.Apply(); });
@@ -818,8 +953,10 @@ void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLui
     // Ensure no bad interactions with GL_PACK_ALIGNMENT
     ASSERT(stride * GetGLBytesPerPixel(pixel_format) % 4 == 0);
     glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<GLint>(stride));
-    std::size_t buffer_offset =
-        (rect.bottom * stride + rect.left) * GetGLBytesPerPixel(pixel_format);
+    // dest is null when a pixel pack buffer is bound, the address is then an offset in it
+    GLvoid* const pixels = reinterpret_cast<GLvoid*>(
+        reinterpret_cast<std::uintptr_t>(dest) +
+        (rect.bottom * stride + rect.left) * GetGLBytesPerPixel(pixel_format));
 
     // If not 1x scale, blit scaled texture to a new 1x texture and use that to flush
     if (res_scale != 1) {
@@ -829,47 +966,209 @@ void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLui
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
 
-        OGLTexture unscaled_tex;
-        unscaled_tex.Create();
+        OGLTexture unscaled_tex =
+            owner.AllocateTexture(pixel_format, rect.GetWidth(), rect.GetHeight());
+        SCOPE_EXIT({
+            owner.RecycleTexture(pixel_format, rect.GetWidth(), rect.GetHeight(),
+                                 std::move(unscaled_tex));
+        });
 
         MathUtil::Rectangle<u32> unscaled_tex_rect{0, rect.GetHeight(), rect.GetWidth(), 0};
-        AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth(), rect.GetHeight());
         BlitTextures(texture.handle, scaled_rect, unscaled_tex.handle, unscaled_tex_rect, type,
                      read_fb_handle, draw_fb_handle);
 
-        state.texture_units[0].texture_2d = unscaled_tex.handle;
+        // Reads through the framebuffer like the 1x path, glGetTexImage is missing from GLES and
+        // stalls more on the mobile drivers that emulate it
+        state.draw.read_framebuffer = read_fb_handle;
         state.Apply();
-
-        glActiveTexture(GL_TEXTURE0);
-        glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+        AttachToReadFramebuffer(unscaled_tex.handle, type);
+        glReadPixels(0, 0, static_cast<GLsizei>(rect.GetWidth()),
+                     static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type, pixels);
     } else {
         state.ResetTexture(texture.handle);
         state.draw.read_framebuffer = read_fb_handle;
         state.Apply();
-
-        if (type == SurfaceType::Color || type == SurfaceType::Texture) {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                                   0, 0);
-        } else if (type == SurfaceType::Depth) {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
-        } else {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-        }
+        AttachToReadFramebuffer(texture.handle, type);
         glReadPixels(static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom),
                      static_cast<GLsizei>(rect.GetWidth()), static_cast<GLsizei>(rect.GetHeight()),
-                     tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+                     tuple.format, tuple.type, pixels);
     }
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
 
+MICROPROFILE_DEFINE(OpenGL_TextureDLAsync, "OpenGL", "Texture Download Async",
+                    MP_RGB(128, 192, 64));
+void CachedSurface::StartDownload(SurfaceInterval interval, GLuint read_fb_handle,
+                                  GLuint draw_fb_handle) {
+    ASSERT(type != SurfaceType::Fill);
+
+    MICROPROFILE_SCOPE(OpenGL_TextureDLAsync);
+
+    // The pixel buffer has the layout of the unscaled texture. It keeps the readback until the
+    // region is written to, so that later flushes of the region don't have to touch the GPU.
+    const bool create_pbo = download_pbo.handle == 0;
+    download_pbo.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download_pbo.handle);
+    if (create_pbo) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, stride * height * GetGLBytesPerPixel(pixel_format),
+                     nullptr, GL_STREAM_READ);
+    }
+
+    const SurfaceParams params = FromInterval(interval);
+    ReadGLTexture(GetSubRect(params), read_fb_handle, draw_fb_handle, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    download_fence.Release();
+    download_fence.Create();
+    download_interval = params.GetInterval();
+}
+
+bool CachedSurface::FinishDownload(SurfaceInterval interval, u8* buffer) {
+    if (!boost::icl::contains(download_interval, interval))
+        return false;
+
+    if (download_fence.handle != nullptr) {
+        MICROPROFILE_SCOPE(OpenGL_TextureDLAsync);
+
+        // Only stalls if the GPU hasn't caught up with the readback yet
+        GLenum result;
+        do {
+            result = glClientWaitSync(download_fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      1000000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        download_fence.Release();
+
+        if (result == GL_WAIT_FAILED) {
+            download_interval = SurfaceInterval();
+            return false;
+        }
+    }
+
+    // Only the pixels of the rectangle were read back, the rest of the rows is left untouched
+    const auto rect = GetSubRect(FromInterval(interval));
+    const std::size_t bytes_per_pixel = GetGLBytesPerPixel(pixel_format);
+    const std::size_t begin = (rect.bottom * stride + rect.left) * bytes_per_pixel;
+    const std::size_t end = ((rect.top - 1) * stride + rect.right) * bytes_per_pixel;
+    const std::size_t row_size = rect.GetWidth() * bytes_per_pixel;
+    const std::size_t row_stride = stride * bytes_per_pixel;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download_pbo.handle);
+    const u8* const pixels = static_cast<const u8*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, begin, end - begin, GL_MAP_READ_BIT));
+    if (pixels != nullptr) {
+        for (std::size_t offset = 0; offset < end - begin; offset += row_stride) {
+            std::memcpy(buffer + begin + offset, pixels + offset, row_size);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return pixels != nullptr;
+}
+
+void CachedSurface::InvalidateDownload(SurfaceInterval interval) {
+    if (boost::icl::intersects(download_interval, interval)) {
+        download_fence.Release();
+        download_interval = SurfaceInterval();
+    }
+}
+
+bool CachedSurface::DecodeGLTexture(ComputeTextureDecoder& decoder,
+                                    const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
+                                    GLuint draw_fb_handle) {
+    if (!ComputeTextureDecoder::CanDecode(*this))
+        return false;
+
+    MICROPROFILE_SCOPE(OpenGL_TextureUL);
+    ScopedGPUTimer gpu_timer(GPUPass::TextureUpload);
+
+    const FormatTuple& tuple = GetFormatTuple(pixel_format);
+
+    // Same as UploadGLTexture, decode to a 1x texture and blit it when scaled
+    if (res_scale == 1) {
+        if (!decoder.Decode(*this, rect, texture.handle, static_cast<GLint>(rect.left),
+                            static_cast<GLint>(rect.bottom)))
+            return false;
+    } else {
+        OGLTexture unscaled_tex =
+            owner.AllocateTexture(pixel_format, rect.GetWidth(), rect.GetHeight());
+        SCOPE_EXIT({
+            owner.RecycleTexture(pixel_format, rect.GetWidth(), rect.GetHeight(),
+                                 std::move(unscaled_tex));
+        });
+        if (!decoder.Decode(*this, rect, unscaled_tex.handle, 0, 0))
+            return false;
+
+        auto scaled_rect = rect;
+        scaled_rect.left *= res_scale;
+        scaled_rect.top *= res_scale;
+        scaled_rect.right *= res_scale;
+        scaled_rect.bottom *= res_scale;
+
+        if (owner.texture_filterer != nullptr && TextureFilterer::CanFilter(*this)) {
+            owner.texture_filterer->Filter(unscaled_tex.handle,
+                                           {0, rect.GetHeight(), rect.GetWidth(), 0},
+                                           texture.handle, scaled_rect);
+        } else {
+            BlitTextures(unscaled_tex.handle, {0, rect.GetHeight(), rect.GetWidth(), 0},
+                         texture.handle, scaled_rect, type, read_fb_handle, draw_fb_handle);
+        }
+    }
+
+    InvalidateAllWatcher();
+    return true;
+}
+
+bool CachedSurface::EncodeGLTexture(ComputeTextureDecoder& decoder, PAddr flush_start,
+                                    PAddr flush_end, GLuint read_fb_handle,
+                                    GLuint draw_fb_handle) {
+    if (!ComputeTextureDecoder::CanEncode(*this))
+        return false;
+
+    u8* const dst_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
+    if (dst_buffer == nullptr)
+        return false;
+
+    // Same clamping as FlushGLBuffer
+    if (flush_start < Memory::VRAM_VADDR_END && flush_end > Memory::VRAM_VADDR_END)
+        flush_end = Memory::VRAM_VADDR_END;
+
+    if (flush_start < Memory::VRAM_VADDR && flush_end > Memory::VRAM_VADDR)
+        flush_start = Memory::VRAM_VADDR;
+
+    if (flush_start >= flush_end)
+        return true;
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceFlush);
+
+    const SurfaceInterval flush_interval(flush_start, flush_end);
+    const auto rect = GetSubRect(FromInterval(flush_interval));
+    u8* const dest = dst_buffer + (flush_start - addr);
+
+    if (res_scale == 1) {
+        return decoder.Encode(*this, rect, texture.handle, static_cast<GLint>(rect.left),
+                              static_cast<GLint>(rect.bottom), flush_start, flush_end, dest);
+    }
+
+    // Encode from a 1x copy of the rectangle, like DownloadGLTexture
+    auto scaled_rect = rect;
+    scaled_rect.left *= res_scale;
+    scaled_rect.top *= res_scale;
+    scaled_rect.right *= res_scale;
+    scaled_rect.bottom *= res_scale;
+
+    OGLTexture unscaled_tex =
+        owner.AllocateTexture(pixel_format, rect.GetWidth(), rect.GetHeight());
+    SCOPE_EXIT({
+        owner.RecycleTexture(pixel_format, rect.GetWidth(), rect.GetHeight(),
+                             std::move(unscaled_tex));
+    });
+    BlitTextures(texture.handle, scaled_rect, unscaled_tex.handle,
+                 {0, rect.GetHeight(), rect.GetWidth(), 0}, type, read_fb_handle, draw_fb_handle);
+
+    return decoder.Encode(*this, rect, unscaled_tex.handle, 0, 0, flush_start, flush_end, dest);
+}
+
 enum MatchFlags {
     Invalid = 1,      // Flag that can be applied to other match types, invalid matches require
                       // validation before they can be used
@@ -886,7 +1185,7 @@ constexpr MatchFlags operator|(MatchFlags lhs, MatchFlags rhs) {
 
 /// Get the best surface match (and its match type) for the given flags
 template <MatchFlags find_flags>
-Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params,
+Surface FindMatch(const SurfacePageIndex& surface_cache, const SurfaceParams& params,
                   ScaleMatch match_scale_type,
                   std::optional<SurfaceInterval> validate_interval = {}) {
     Surface match_surface = nullptr;
@@ -894,86 +1193,87 @@ Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params
     u32 match_scale = 0;
     SurfaceInterval match_interval{};
 
-    for (auto& pair : RangeFromInterval(surface_cache, params.GetInterval())) {
-        for (auto& surface : pair.second) {
-            bool res_scale_matched = match_scale_type == ScaleMatch::Exact
-                                         ? (params.res_scale == surface->res_scale)
-                                         : (params.res_scale <= surface->res_scale);
-            // validity will be checked in GetCopyableInterval
-            bool is_valid =
-                find_flags & MatchFlags::Copy
-                    ? true
-                    : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
-
-            if (!(find_flags & MatchFlags::Invalid) && !is_valid)
-                continue;
+    surface_cache.ForEachOverlapping(params.GetInterval(), [&](const Surface& surface) {
+        bool res_scale_matched = match_scale_type == ScaleMatch::Exact
+                                     ? (params.res_scale == surface->res_scale)
+                                     : (params.res_scale <= surface->res_scale);
+        // validity will be checked in GetCopyableInterval
+        bool is_valid =
+            find_flags & MatchFlags::Copy
+                ? true
+                : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
+
+        if (!(find_flags & MatchFlags::Invalid) && !is_valid)
+            return;
+
+        auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
+            if (!(find_flags & check_type))
+                return;
+
+            bool matched;
+            SurfaceInterval surface_interval;
+            std::tie(matched, surface_interval) = match_fn();
+            if (!matched)
+                return;
+
+            if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
+                surface->type != SurfaceType::Fill)
+                return;
+
+            // Found a match, update only if this is better than the previous one
+            auto UpdateMatch = [&] {
+                match_surface = surface;
+                match_valid = is_valid;
+                match_scale = surface->res_scale;
+                match_interval = surface_interval;
+            };
 
-            auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
-                if (!(find_flags & check_type))
-                    return;
-
-                bool matched;
-                SurfaceInterval surface_interval;
-                std::tie(matched, surface_interval) = match_fn();
-                if (!matched)
-                    return;
-
-                if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
-                    surface->type != SurfaceType::Fill)
-                    return;
-
-                // Found a match, update only if this is better than the previous one
-                auto UpdateMatch = [&] {
-                    match_surface = surface;
-                    match_valid = is_valid;
-                    match_scale = surface->res_scale;
-                    match_interval = surface_interval;
-                };
-
-                if (surface->res_scale > match_scale) {
-                    UpdateMatch();
-                    return;
-                } else if (surface->res_scale < match_scale) {
-                    return;
-                }
+            if (surface->res_scale > match_scale) {
+                UpdateMatch();
+                return;
+            } else if (surface->res_scale < match_scale) {
+                return;
+            }
 
-                if (is_valid && !match_valid) {
-                    UpdateMatch();
-                    return;
-                } else if (is_valid != match_valid) {
-                    return;
-                }
+            if (is_valid && !match_valid) {
+                UpdateMatch();
+                return;
+            } else if (is_valid != match_valid) {
+                return;
+            }
 
-                if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
-                    UpdateMatch();
-                }
-            };
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
-                return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
-                return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
-                ASSERT(validate_interval);
-                auto copy_interval =
-                    params.FromInterval(*validate_interval).GetCopyableInterval(surface);
-                bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
-                               surface->CanCopy(params, copy_interval);
-                return std::make_pair(matched, copy_interval);
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
-                return std::make_pair(surface->CanExpand(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
-                return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
-            });
-        }
-    }
+            if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
+                UpdateMatch();
+            }
+        };
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
+            return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
+            return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
+            ASSERT(validate_interval);
+            auto copy_interval =
+                params.FromInterval(*validate_interval).GetCopyableInterval(surface);
+            bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
+                           surface->CanCopy(params, copy_interval);
+            return std::make_pair(matched, copy_interval);
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
+            return std::make_pair(surface->CanExpand(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
+            return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
+        });
+    });
     return match_surface;
 }
 
 RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
+    target_res_scale = budget_res_scale = budget_resolution_factor =
+        VideoCore::GetResolutionScaleFactor();
+
     read_framebuffer.Create();
     draw_framebuffer.Create();
 
@@ -1022,12 +1322,39 @@ void main() {
     ASSERT(d24s8_abgr_tbo_size_u_id != -1);
     d24s8_abgr_viewport_u_id = glGetUniformLocation(d24s8_abgr_shader.handle, "viewport");
     ASSERT(d24s8_abgr_viewport_u_id != -1);
+
+    if (GLAD_GL_ARB_buffer_storage) {
+        upload_buffer =
+            std::make_unique<OGLStreamBuffer>(GL_PIXEL_UNPACK_BUFFER, UPLOAD_BUFFER_SIZE, false);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    if (Settings::GetSnapshot().use_compute_texture_decoding) {
+        if (ComputeTextureDecoder::IsSupported()) {
+            texture_decoder = std::make_unique<ComputeTextureDecoder>();
+            if (!texture_decoder->IsValid())
+                texture_decoder.reset();
+        } else {
+            LOG_WARNING(Render_OpenGL, "Compute shaders are not supported, textures will be "
+                                       "decoded on the CPU");
+        }
+    }
+
+    const Settings::TextureFilter texture_filter = Settings::GetSnapshot().texture_filter;
+    if (texture_filter != Settings::TextureFilter::None) {
+        if (TextureFilterer::IsSupported()) {
+            texture_filterer = std::make_unique<TextureFilterer>(texture_filter);
+        } else {
+            LOG_WARNING(Render_OpenGL, "Compute shaders are not supported, textures will not be "
+                                       "filtered");
+        }
+    }
 }
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
-    while (!surface_cache.empty())
-        UnregisterSurface(*surface_cache.begin()->second.begin());
+    for (const Surface& surface : surface_cache.GetAll())
+        UnregisterSurface(surface);
 }
 
 MICROPROFILE_DEFINE(OpenGL_BlitSurface, "OpenGL", "BlitSurface", MP_RGB(128, 192, 64));
@@ -1036,6 +1363,7 @@ bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
                                          const Surface& dst_surface,
                                          const MathUtil::Rectangle<u32>& dst_rect) {
     MICROPROFILE_SCOPE(OpenGL_BlitSurface);
+    ScopedGPUTimer gpu_timer(GPUPass::SurfaceBlit);
 
     if (!SurfaceParams::CheckFormatsBlittable(src_surface->pixel_format, dst_surface->pixel_format))
         return false;
@@ -1105,6 +1433,14 @@ void RasterizerCacheOpenGL::ConvertD24S8toABGR(GLuint src_tex,
     glBindTexture(GL_TEXTURE_BUFFER, 0);
 }
 
+static const Common::FrameCounter surface_hit_counter("OpenGL/Surface Cache Hits");
+static const Common::FrameCounter surface_miss_counter("OpenGL/Surface Cache Misses");
+static const Common::FrameCounter surface_load_counter("OpenGL/Surface Loads");
+static const Common::FrameCounter surface_load_bytes_counter("OpenGL/Surface Bytes Uploaded");
+static const Common::FrameCounter surface_load_skip_counter("OpenGL/Surface Loads Skipped");
+static const Common::FrameCounter surface_flush_counter("OpenGL/Surface Flushes");
+static const Common::FrameCounter surface_flush_bytes_counter("OpenGL/Surface Bytes Flushed");
+
 Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatch match_res_scale,
                                           bool load_if_create) {
     if (params.addr == 0 || params.height * params.width == 0) {
@@ -1119,7 +1455,10 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
     Surface surface =
         FindMatch<MatchFlags::Exact | MatchFlags::Invalid>(surface_cache, params, match_res_scale);
 
-    if (surface == nullptr) {
+    if (surface != nullptr) {
+        surface_hit_counter.Add();
+    } else {
+        surface_miss_counter.Add();
         u16 target_res_scale = params.res_scale;
         if (match_res_scale != ScaleMatch::Exact) {
             // This surface may have a subrect of another surface with a higher res_scale, find it
@@ -1163,6 +1502,9 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
     // Attempt to find encompassing surface
     Surface surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_cache, params,
                                                                            match_res_scale);
+    if (surface != nullptr) {
+        surface_hit_counter.Add();
+    }
 
     // Check if FindMatch failed because of res scaling
     // If that's the case create a new surface with
@@ -1173,6 +1515,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
                                                                        ScaleMatch::Ignore);
         if (surface != nullptr) {
             ASSERT(surface->res_scale < params.res_scale);
+            surface_miss_counter.Add();
             SurfaceParams new_params = *surface;
             new_params.res_scale = params.res_scale;
 
@@ -1194,6 +1537,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
         surface = FindMatch<MatchFlags::Expand | MatchFlags::Invalid>(surface_cache, aligned_params,
                                                                       match_res_scale);
         if (surface != nullptr) {
+            surface_miss_counter.Add();
             aligned_params.width = aligned_params.stride;
             aligned_params.UpdateParams();
 
@@ -1264,7 +1608,22 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
         return tmp_surface;
     }
 
-    return GetSurface(params, ScaleMatch::Ignore, true);
+    // Filtered textures are loaded into surfaces at the render targets' scale
+    if (texture_filterer != nullptr)
+        params.res_scale = target_res_scale;
+
+    Surface surface = GetSurface(params, ScaleMatch::Ignore, true);
+    if (surface == nullptr)
+        return nullptr;
+
+    if (texture_pack != nullptr)
+        ApplyCustomTexture(surface);
+    if (texture_dumper != nullptr && surface->content_hash) {
+        texture_dumper->Dump(surface->texture.handle, surface->width, surface->height,
+                             surface->GetScaledWidth(), surface->GetScaledHeight(),
+                             *surface->content_hash, static_cast<u32>(surface->pixel_format));
+    }
+    return surface;
 }
 
 const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCubeConfig& config) {
@@ -1288,7 +1647,11 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
     }};
 
     for (const Face& face : faces) {
-        if (!face.watcher || !face.watcher->Get()) {
+        const Surface face_surface = face.watcher ? face.watcher->Get() : nullptr;
+        if (face_surface != nullptr) {
+            // Faces the CPU wrote to are reloaded, which only invalidates their own watcher
+            ValidateSurface(face_surface, face_surface->addr, face_surface->size);
+        } else {
             Pica::Texture::TextureInfo info;
             info.physical_address = face.address;
             info.height = info.width = config.width;
@@ -1321,6 +1684,13 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
             cube.res_scale * config.width);
     }
 
+    // Only the faces that changed are copied again, and nothing at all if none did
+    if (std::all_of(faces.begin(), faces.end(), [](const Face& face) {
+            return !face.watcher || face.watcher->IsValid();
+        })) {
+        return cube;
+    }
+
     u32 scaled_size = cube.res_scale * config.width;
 
     OpenGLState prev_state = OpenGLState::GetCurState();
@@ -1361,13 +1731,16 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     const auto& regs = Pica::g_state.regs;
     const auto& config = regs.framebuffer.framebuffer;
 
-    // update resolution_scale_factor and reset cache if changed
-    static u16 resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
-    if (resolution_scale_factor != VideoCore::GetResolutionScaleFactor()) {
-        resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
+    // No surface of the draw is held yet, so this is where the cache can shrink
+    EvictSurfaces();
+
+    // Reset the cache when the scale of the render targets changes
+    const u16 res_scale = std::min(budget_res_scale, VideoCore::GetResolutionScaleFactor());
+    if (target_res_scale != res_scale) {
+        target_res_scale = res_scale;
         FlushAll();
-        while (!surface_cache.empty())
-            UnregisterSurface(*surface_cache.begin()->second.begin());
+        for (const Surface& surface : surface_cache.GetAll())
+            UnregisterSurface(surface);
         texture_cube_cache.clear();
     }
 
@@ -1381,7 +1754,6 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     // get color and depth surfaces
     SurfaceParams color_params;
     color_params.is_tiled = true;
-    color_params.res_scale = resolution_scale_factor;
     color_params.width = config.GetWidth();
     color_params.height = config.GetHeight();
     SurfaceParams depth_params = color_params;
@@ -1394,6 +1766,10 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     depth_params.pixel_format = SurfaceParams::PixelFormatFromDepthFormat(config.depth_format);
     depth_params.UpdateParams();
 
+    // Both are drawn to with the same viewport, so they share a scale
+    color_params.res_scale = depth_params.res_scale =
+        GetTargetResScale(using_color_fb ? color_params : depth_params);
+
     auto color_vp_interval = color_params.GetSubRectInterval(viewport_clamped);
     auto depth_vp_interval = depth_params.GetSubRectInterval(viewport_clamped);
 
@@ -1444,11 +1820,21 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
         depth_surface->InvalidateAllWatcher();
     }
 
+    // Switching render targets resolves the previous ones
+    if (color_surface != last_color_surface) {
+        ResolveSurface(last_color_surface);
+        last_color_surface = color_surface;
+    }
+    if (depth_surface != last_depth_surface) {
+        ResolveSurface(last_depth_surface);
+        last_depth_surface = depth_surface;
+    }
+
     return std::make_tuple(color_surface, depth_surface, fb_rect);
 }
 
 Surface RasterizerCacheOpenGL::GetFillSurface(const GPU::Regs::MemoryFillConfig& config) {
-    Surface new_surface = std::make_shared<CachedSurface>();
+    Surface new_surface = std::make_shared<CachedSurface>(*this);
 
     new_surface->addr = config.GetStartAddress();
     new_surface->end = config.GetEndAddress();
@@ -1505,6 +1891,8 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
 
     dest_surface->invalid_regions -= src_surface->GetInterval();
     dest_surface->invalid_regions += src_surface->invalid_regions;
+    dest_surface->InvalidateDownload(src_surface->GetInterval());
+    dest_surface->content_hash.reset();
 
     SurfaceRegions regions;
     for (auto& pair : RangeFromInterval(dirty_regions, src_surface->GetInterval())) {
@@ -1518,6 +1906,9 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
 }
 
 void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr, u32 size) {
+    // Every use of a surface goes through here, which makes it the place to track recency
+    surface->last_used = ++use_counter;
+
     if (size == 0)
         return;
 
@@ -1544,6 +1935,7 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
             SurfaceInterval copy_interval = params.GetCopyableInterval(copy_surface);
             CopySurface(copy_surface, surface, copy_interval);
             surface->invalid_regions.erase(copy_interval);
+            surface->content_hash.reset();
             continue;
         }
 
@@ -1564,15 +1956,36 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
                                    surface->texture.handle, dest_rect);
 
                 surface->invalid_regions.erase(convert_interval);
+                surface->content_hash.reset();
                 continue;
             }
         }
 
         // Load data from 3DS memory
         FlushRegion(params.addr, params.size);
-        surface->LoadGLBuffer(params.addr, params.end);
-        surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                 draw_framebuffer.handle);
+
+        // Titles often write the same texture data again, which it is cheaper to hash than to
+        // decode and upload. Only whole surface loads are tracked, partial ones lose the hash.
+        std::optional<u64> load_hash;
+        if (params.GetInterval() == surface->GetInterval()) {
+            const u8* const source = VideoCore::g_memory->GetPhysicalPointer(params.addr);
+            if (source != nullptr)
+                load_hash = Common::ComputeHash64(source, params.size);
+        }
+        if (load_hash && load_hash == surface->content_hash) {
+            surface_load_skip_counter.Add();
+            surface->invalid_regions.erase(params.GetInterval());
+            continue;
+        }
+        surface->content_hash = load_hash;
+
+        surface_load_counter.Add();
+        surface_load_bytes_counter.Add(params.size);
+        if (texture_decoder == nullptr ||
+            !surface->DecodeGLTexture(*texture_decoder, surface->GetSubRect(params),
+                                      read_framebuffer.handle, draw_framebuffer.handle)) {
+            surface->LoadGLTexture(params, read_framebuffer.handle, draw_framebuffer.handle);
+        }
         surface->invalid_regions.erase(params.GetInterval());
     }
 }
@@ -1598,21 +2011,165 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
         ASSERT(surface->IsRegionValid(interval));
 
         if (surface->type != SurfaceType::Fill) {
-            SurfaceParams params = surface->FromInterval(interval);
-            surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                       draw_framebuffer.handle);
+            surface->download_on_resolve = true;
+            if (surface->res_scale > 1)
+                ++read_back_targets[surface->addr];
+        }
+
+        surface_flush_counter.Add();
+        surface_flush_bytes_counter.Add(boost::icl::length(interval));
+
+        if (texture_decoder == nullptr ||
+            !surface->EncodeGLTexture(*texture_decoder, boost::icl::first(interval),
+                                      boost::icl::last_next(interval), read_framebuffer.handle,
+                                      draw_framebuffer.handle)) {
+            surface->FlushGLTexture(interval, read_framebuffer.handle, draw_framebuffer.handle);
         }
-        surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
         flushed_intervals += interval;
     }
     // Reset dirty regions
     dirty_regions -= flushed_intervals;
 }
 
+bool RasterizerCacheOpenGL::IsRegionCached(PAddr addr, u32 size) const {
+    if (size == 0)
+        return false;
+
+    const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+    for (u32 page = addr >> Memory::PAGE_BITS; page < page_end; ++page) {
+        if (cached_pages.count(page) == 0)
+            return false;
+    }
+    return true;
+}
+
 void RasterizerCacheOpenGL::FlushAll() {
     FlushRegion(0, 0xFFFFFFFF);
 }
 
+void RasterizerCacheOpenGL::ResolveSurface(const Surface& surface) {
+    if (surface == nullptr || !surface->download_on_resolve)
+        return;
+
+    SurfaceRegions regions;
+    for (auto& pair : RangeFromInterval(dirty_regions, surface->GetInterval())) {
+        if (pair.second == surface) {
+            regions += pair.first;
+        }
+    }
+    if (regions.empty())
+        return;
+
+    const SurfaceInterval interval = boost::icl::hull(regions);
+    if (boost::icl::contains(surface->download_interval, interval))
+        return;
+
+    surface->StartDownload(interval, read_framebuffer.handle, draw_framebuffer.handle);
+}
+
+void RasterizerCacheOpenGL::LoadTexturePack(u64 title_id) {
+    texture_pack.reset();
+    // Replacements are used once loaded by the background thread
+    const Settings::Snapshot& settings = Settings::GetSnapshot();
+    if (!settings.custom_textures || settings.deterministic)
+        return;
+
+    auto pack = std::make_unique<TexturePack>(title_id);
+    if (!pack->IsEmpty())
+        texture_pack = std::move(pack);
+}
+
+void RasterizerCacheOpenGL::NotifyFramePresented() {
+    const u16 resolution_factor = VideoCore::GetResolutionScaleFactor();
+    const u64 budget = static_cast<u64>(Settings::GetSnapshot().resolution_fill_budget) * 1000000;
+    const u64 fill = std::exchange(frame_fill, 0);
+
+    // A new resolution factor applies right away
+    if (budget == 0 || resolution_factor != budget_resolution_factor) {
+        budget_resolution_factor = budget_res_scale = resolution_factor;
+        scale_down_frames = scale_up_frames = 0;
+        return;
+    }
+
+    // Highest scale the last frame would have fit the budget at
+    u16 fitting = resolution_factor;
+    while (fitting > 1 && fill * fitting * fitting > budget)
+        --fitting;
+
+    const u64 next_scale = budget_res_scale + 1;
+    if (fitting < budget_res_scale) {
+        scale_up_frames = 0;
+        if (++scale_down_frames >= SCALE_DOWN_FRAMES) {
+            budget_res_scale = fitting;
+            scale_down_frames = 0;
+        }
+    } else if (fitting > budget_res_scale && fill * next_scale * next_scale <= budget / 4 * 3) {
+        // Only with some margin, so that the scale doesn't change at every small variation
+        scale_down_frames = 0;
+        if (++scale_up_frames >= SCALE_UP_FRAMES) {
+            ++budget_res_scale;
+            scale_up_frames = 0;
+        }
+    } else {
+        scale_down_frames = scale_up_frames = 0;
+    }
+}
+
+u16 RasterizerCacheOpenGL::GetTargetResScale(const SurfaceParams& params) const {
+    if (target_res_scale == 1)
+        return 1;
+
+    // Utility buffers and shadow maps don't gain anything from the upscale
+    const auto& output_merger = Pica::g_state.regs.framebuffer.output_merger;
+    if (params.width * params.height < MIN_SCALED_TARGET_PIXELS ||
+        output_merger.fragment_operation_mode ==
+            Pica::FramebufferRegs::FragmentOperationMode::Shadow)
+        return 1;
+
+    // Targets the CPU keeps reading would be downscaled at every read back
+    const auto it = read_back_targets.find(params.addr);
+    if (it != read_back_targets.end() && it->second >= NATIVE_READ_BACKS)
+        return 1;
+
+    return target_res_scale;
+}
+
+void RasterizerCacheOpenGL::StartTextureDump(u64 title_id) {
+    texture_dumper.reset();
+    if (Settings::GetSnapshot().dump_textures)
+        texture_dumper = std::make_unique<TextureDumper>(title_id);
+}
+
+void RasterizerCacheOpenGL::ApplyCustomTexture(const Surface& surface) {
+    // Only the content of whole surface loads is hashed
+    if (!surface->content_hash || surface->custom_hash == surface->content_hash)
+        return;
+
+    std::shared_ptr<const CustomTexture> custom;
+    const TexturePack::Status status =
+        texture_pack->Find(*surface->content_hash, surface->width, surface->height,
+                           static_cast<u32>(surface->pixel_format), custom);
+    // The guest texture is used until the replacement has been read from disk
+    if (status == TexturePack::Status::Loading)
+        return;
+
+    surface->custom_hash = surface->content_hash;
+    if (status == TexturePack::Status::Missing) {
+        surface->custom_texture.Release();
+        return;
+    }
+    if (!IsCustomTextureFormatSupported(custom->internal_format)) {
+        LOG_WARNING(Render_OpenGL, "Replacement texture format {:#x} is not supported",
+                    custom->internal_format);
+        surface->custom_texture.Release();
+        return;
+    }
+
+    if (surface->custom_texture.handle == 0)
+        surface->custom_texture.Create();
+    UploadCustomTexture(surface->custom_texture.handle, *custom);
+}
+
 void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface& region_owner) {
     if (size == 0)
         return;
@@ -1625,31 +2182,31 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         // Surfaces can't have a gap
         ASSERT(region_owner->width == region_owner->stride);
         region_owner->invalid_regions.erase(invalid_interval);
+        region_owner->InvalidateDownload(invalid_interval);
+        region_owner->content_hash.reset();
     }
 
-    for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
-        for (auto& cached_surface : pair.second) {
-            if (cached_surface == region_owner)
-                continue;
+    surface_cache.ForEachOverlapping(invalid_interval, [&](const Surface& cached_surface) {
+        if (cached_surface == region_owner)
+            return;
 
-            // If cpu is invalidating this region we want to remove it
-            // to (likely) mark the memory pages as uncached
-            if (region_owner == nullptr && size <= 8) {
-                FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
-                remove_surfaces.emplace(cached_surface);
-                continue;
-            }
+        // If cpu is invalidating this region we want to remove it
+        // to (likely) mark the memory pages as uncached
+        if (region_owner == nullptr && size <= 8) {
+            FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
+            remove_surfaces.emplace(cached_surface);
+            return;
+        }
 
-            const auto interval = cached_surface->GetInterval() & invalid_interval;
-            cached_surface->invalid_regions.insert(interval);
+        const auto interval = cached_surface->GetInterval() & invalid_interval;
+        cached_surface->invalid_regions.insert(interval);
+        cached_surface->InvalidateDownload(interval);
 
-            // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
-            if (cached_surface->type == SurfaceType::Fill &&
-                cached_surface->IsSurfaceFullyInvalid()) {
-                remove_surfaces.emplace(cached_surface);
-            }
+        // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
+        if (cached_surface->type == SurfaceType::Fill && cached_surface->IsSurfaceFullyInvalid()) {
+            remove_surfaces.emplace(cached_surface);
         }
-    }
+    });
 
     if (region_owner != nullptr)
         dirty_regions.set({invalid_interval, region_owner});
@@ -1675,15 +2232,13 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
 }
 
 Surface RasterizerCacheOpenGL::CreateSurface(const SurfaceParams& params) {
-    Surface surface = std::make_shared<CachedSurface>();
+    Surface surface = std::make_shared<CachedSurface>(*this);
     static_cast<SurfaceParams&>(*surface) = params;
 
-    surface->texture.Create();
+    surface->texture = AllocateTexture(surface->pixel_format, surface->GetScaledWidth(),
+                                       surface->GetScaledHeight());
 
-    surface->gl_buffer_size = 0;
     surface->invalid_regions.insert(surface->GetInterval());
-    AllocateSurfaceTexture(surface->texture.handle, GetFormatTuple(surface->pixel_format),
-                           surface->GetScaledWidth(), surface->GetScaledHeight());
 
     return surface;
 }
@@ -1693,8 +2248,14 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = true;
-    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
+    surface->last_used = ++use_counter;
+    surface_cache.Add(surface);
     UpdatePagesCachedCount(surface->addr, surface->size, 1);
+
+    cached_bytes += surface->GetTextureMemoryUsage();
+    ++cached_surface_count;
+    Core::System::GetInstance().perf_stats.SetTextureCacheStats(cached_bytes, cached_surface_count);
+    texture_memory_usage.Set(cached_bytes + recycled_bytes);
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -1703,41 +2264,168 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
     }
     surface->registered = false;
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
-    surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Remove(surface);
+
+    cached_bytes -= surface->GetTextureMemoryUsage();
+    --cached_surface_count;
+    Core::System::GetInstance().perf_stats.SetTextureCacheStats(cached_bytes, cached_surface_count);
+    texture_memory_usage.Set(cached_bytes + recycled_bytes);
+}
+
+// Textures kept for reuse beyond this are deleted
+constexpr u64 MAX_RECYCLED_TEXTURE_BYTES = 256 * 1024 * 1024;
+
+OGLTexture RasterizerCacheOpenGL::AllocateTexture(PixelFormat format, u32 width, u32 height) {
+    const HostTextureTag tag{format, width, height, 1};
+    const auto it = texture_recycler.find(tag);
+    if (it != texture_recycler.end()) {
+        OGLTexture texture = std::move(it->second);
+        texture_recycler.erase(it);
+        recycled_bytes -= static_cast<u64>(width) * height * CachedSurface::GetGLBytesPerPixel(format);
+        texture_memory_usage.Set(cached_bytes + recycled_bytes);
+        return texture;
+    }
+
+    OGLTexture texture;
+    texture.Create();
+    AllocateSurfaceTexture(texture.handle, GetFormatTuple(format), width, height);
+    return texture;
+}
+
+void RasterizerCacheOpenGL::RecycleTexture(PixelFormat format, u32 width, u32 height,
+                                           OGLTexture&& texture) {
+    if (texture.handle == 0)
+        return;
+
+    const u64 texture_bytes =
+        static_cast<u64>(width) * height * CachedSurface::GetGLBytesPerPixel(format);
+    if (recycled_bytes + texture_bytes > MAX_RECYCLED_TEXTURE_BYTES) {
+        texture.Release();
+        return;
+    }
+
+    recycled_bytes += texture_bytes;
+    texture_memory_usage.Set(cached_bytes + recycled_bytes);
+    texture_recycler.emplace(HostTextureTag{format, width, height, 1}, std::move(texture));
+}
+
+u8* RasterizerCacheOpenGL::GetStagingBuffer(std::size_t size) {
+    if (staging_buffer.size() < size) {
+        staging_buffer.resize(size);
+        staging_buffer_usage.Set(staging_buffer.size());
+    }
+    return staging_buffer.data();
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceEviction, "OpenGL", "Surface Eviction", MP_RGB(128, 192, 64));
+void RasterizerCacheOpenGL::EvictSurfaces() {
+    const u64 budget =
+        static_cast<u64>(Settings::GetSnapshot().texture_cache_budget) * 1024 * 1024;
+    if (budget == 0 || cached_bytes <= budget)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_SurfaceEviction);
+
+    std::vector<Surface> surfaces = surface_cache.GetAll();
+    std::sort(surfaces.begin(), surfaces.end(), [](const Surface& lhs, const Surface& rhs) {
+        return lhs->last_used < rhs->last_used;
+    });
+
+    // Go some way below the budget so that this doesn't have to run again on the next draw
+    const u64 target = budget - budget / 8;
+    u32 evicted = 0;
+    for (const Surface& surface : surfaces) {
+        if (cached_bytes <= target)
+            break;
+
+        // The current render targets are in use even if no draw validated them recently
+        if (surface == last_color_surface || surface == last_depth_surface)
+            continue;
+
+        // Dirty regions only exist in the texture, write them back before dropping it
+        FlushRegion(surface->addr, surface->size, surface);
+        UnregisterSurface(surface);
+        ++evicted;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Evicted {} surfaces, {} bytes cached", evicted, cached_bytes);
+    Core::System::GetInstance().perf_stats.AddTextureCacheEvictions(evicted);
 }
 
 void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
-    const u32 num_pages =
-        ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
     const u32 page_start = addr >> Memory::PAGE_BITS;
-    const u32 page_end = page_start + num_pages;
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0)
-        cached_pages.add({pages_interval, delta});
-
-    for (auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            true);
-        else if (delta < 0 && count == -delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            false);
-        else
-            ASSERT(count >= 0);
-    }
-
-    if (delta < 0)
-        cached_pages.add({pages_interval, delta});
+    const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+
+    // Pages going from and to zero surfaces are marked in runs to keep the calls to memory few
+    u32 run_start = page_start;
+    bool in_run = false;
+    const auto EndRun = [&](u32 run_end) {
+        if (in_run) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(
+                run_start << Memory::PAGE_BITS, (run_end - run_start) << Memory::PAGE_BITS,
+                delta > 0);
+            in_run = false;
+        }
+    };
+
+    for (u32 page = page_start; page < page_end; ++page) {
+        bool changed;
+        if (delta > 0) {
+            u32& count = cached_pages[page];
+            changed = count == 0;
+            count += delta;
+        } else {
+            const auto it = cached_pages.find(page);
+            ASSERT(it != cached_pages.end() && it->second >= static_cast<u32>(-delta));
+            it->second += delta;
+            changed = it->second == 0;
+            if (changed)
+                cached_pages.erase(it);
+        }
+
+        if (changed && !in_run) {
+            run_start = page;
+            in_run = true;
+        } else if (!changed) {
+            EndRun(page);
+        }
+    }
+    EndRun(page_end);
+}
+
+void SurfacePageIndex::Add(const Surface& surface) {
+    const u32 page_start = surface->addr >> Memory::PAGE_BITS;
+    const u32 page_end = ((surface->end - 1) >> Memory::PAGE_BITS) + 1;
+    for (u32 page = page_start; page < page_end; ++page) {
+        pages[page].push_back(surface);
+    }
+}
+
+void SurfacePageIndex::Remove(const Surface& surface) {
+    const u32 page_start = surface->addr >> Memory::PAGE_BITS;
+    const u32 page_end = ((surface->end - 1) >> Memory::PAGE_BITS) + 1;
+    for (u32 page = page_start; page < page_end; ++page) {
+        const auto it = pages.find(page);
+        ASSERT(it != pages.end());
+        auto& bucket = it->second;
+        const auto surface_it = std::find(bucket.begin(), bucket.end(), surface);
+        ASSERT(surface_it != bucket.end());
+        *surface_it = std::move(bucket.back());
+        bucket.pop_back();
+        if (bucket.empty())
+            pages.erase(it);
+    }
+}
+
+std::vector<Surface> SurfacePageIndex::GetAll() const {
+    std::vector<Surface> surfaces;
+    for (const auto& [page, bucket] : pages) {
+        for (const Surface& surface : bucket) {
+            if (page == surface->addr >> Memory::PAGE_BITS)
+                surfaces.push_back(surface);
+        }
+    }
+    return surfaces;
 }
 
 } // namespace OpenGL
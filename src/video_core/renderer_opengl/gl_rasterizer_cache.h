@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <list>
 #include <memory>
+#include <optional>
 #include <set>
 #include <tuple>
+#include <vector>
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
@@ -25,7 +28,9 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "common/memory_usage.h"
 #include "core/hw/gpu.h"
+#include "core/memory.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
@@ -76,23 +81,25 @@ struct hash<OpenGL::TextureCubeConfig> {
 namespace OpenGL {
 
 struct CachedSurface;
+class ComputeTextureDecoder;
+class TextureFilterer;
+class OGLStreamBuffer;
+class TextureDumper;
+class TexturePack;
+class RasterizerCacheOpenGL;
 using Surface = std::shared_ptr<CachedSurface>;
 using SurfaceSet = std::set<Surface>;
 
 using SurfaceRegions = boost::icl::interval_set<PAddr>;
 using SurfaceMap = boost::icl::interval_map<PAddr, Surface>;
-using SurfaceCache = boost::icl::interval_map<PAddr, SurfaceSet>;
 
-using SurfaceInterval = SurfaceCache::interval_type;
-static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval_type>() &&
-                  std::is_same<SurfaceMap::interval_type, SurfaceCache::interval_type>(),
+using SurfaceInterval = SurfaceRegions::interval_type;
+static_assert(std::is_same<SurfaceMap::interval_type, SurfaceInterval>(),
               "incorrect interval types");
 
 using SurfaceRect_Tuple = std::tuple<Surface, MathUtil::Rectangle<u32>>;
 using SurfaceSurfaceRect_Tuple = std::tuple<Surface, Surface, MathUtil::Rectangle<u32>>;
 
-using PageMap = boost::icl::interval_map<u32, int>;
-
 enum class ScaleMatch {
     Exact,   // only accept same res scale
     Upscale, // only allow higher scale than params
@@ -335,7 +342,41 @@ private:
     bool valid = false;
 };
 
+/// Identifies the textures that can be recycled for a surface
+struct HostTextureTag {
+    SurfaceParams::PixelFormat format;
+    u32 width;
+    u32 height;
+    u32 levels;
+
+    bool operator==(const HostTextureTag& rhs) const {
+        return std::tie(format, width, height, levels) ==
+               std::tie(rhs.format, rhs.width, rhs.height, rhs.levels);
+    }
+};
+
+} // namespace OpenGL
+
+namespace std {
+template <>
+struct hash<OpenGL::HostTextureTag> {
+    std::size_t operator()(const OpenGL::HostTextureTag& tag) const {
+        std::size_t hash = 0;
+        boost::hash_combine(hash, static_cast<u32>(tag.format));
+        boost::hash_combine(hash, tag.width);
+        boost::hash_combine(hash, tag.height);
+        boost::hash_combine(hash, tag.levels);
+        return hash;
+    }
+};
+} // namespace std
+
+namespace OpenGL {
+
 struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface> {
+    explicit CachedSurface(RasterizerCacheOpenGL& owner) : owner{owner} {}
+    ~CachedSurface();
+
     bool CanFill(const SurfaceParams& dest_surface, SurfaceInterval fill_interval) const;
     bool CanCopy(const SurfaceParams& dest_surface, SurfaceInterval copy_interval) const;
 
@@ -364,18 +405,69 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
                          : SurfaceParams::GetFormatBpp(format) / 8;
     }
 
-    std::unique_ptr<u8[]> gl_buffer;
-    std::size_t gl_buffer_size = 0;
+    /// Approximate size of the texture in video memory
+    u64 GetTextureMemoryUsage() const {
+        return static_cast<u64>(GetScaledWidth()) * GetScaledHeight() *
+               GetGLBytesPerPixel(pixel_format);
+    }
+
+    /// Value of the cache's use counter when the surface was last validated
+    u64 last_used = 0;
+
+    /// Hash of the guest memory the whole texture was last loaded from, reset once anything else
+    /// writes to the texture. Reloading the same bytes can then skip the decode and upload.
+    std::optional<u64> content_hash;
 
-    // Read/Write data in 3DS memory to/from gl_buffer
-    void LoadGLBuffer(PAddr load_start, PAddr load_end);
-    void FlushGLBuffer(PAddr flush_start, PAddr flush_end);
+    /// Replacement from the texture pack for the content hashed to custom_hash, set once that
+    /// content has been looked up
+    OGLTexture custom_texture;
+    std::optional<u64> custom_hash;
 
-    // Upload/Download data in gl_buffer in/to this surface's texture
-    void UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                         GLuint draw_fb_handle);
-    void DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                           GLuint draw_fb_handle);
+    /// Texture to sample the surface from, its replacement while it still has the same content
+    GLuint GetSampledTexture() const {
+        return custom_texture.handle != 0 && custom_hash == content_hash ? custom_texture.handle
+                                                                         : texture.handle;
+    }
+
+    // Decode the interval of 3DS memory and upload it to this surface's texture. The pixels are
+    // staged in the upload ring, or in the cache's staging buffer when it can't hold them.
+    void LoadGLTexture(const SurfaceParams& params, GLuint read_fb_handle, GLuint draw_fb_handle);
+    // Read the interval back from this surface's texture and write it to 3DS memory
+    void FlushGLTexture(SurfaceInterval interval, GLuint read_fb_handle, GLuint draw_fb_handle);
+
+    // Read/Write data in 3DS memory to/from a buffer with the layout of the unscaled texture, of
+    // which only the rows of the interval are accessed
+    void LoadGLBuffer(PAddr load_start, PAddr load_end, u8* buffer);
+    void FlushGLBuffer(PAddr flush_start, PAddr flush_end, u8* buffer);
+
+    // Upload/Download a rectangle of such a buffer in/to this surface's texture. The pixels of an
+    // upload are an offset in unpack_buffer, unless it is 0.
+    void UploadGLTexture(const MathUtil::Rectangle<u32>& rect, const void* pixels,
+                         GLuint unpack_buffer, GLuint read_fb_handle, GLuint draw_fb_handle);
+    void DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, u8* buffer,
+                           GLuint read_fb_handle, GLuint draw_fb_handle);
+
+    // Asynchronous version of DownloadGLTexture, the texture is read back into a pixel buffer
+    // that is only waited on when the region is flushed
+    void StartDownload(SurfaceInterval interval, GLuint read_fb_handle, GLuint draw_fb_handle);
+    // Copies the interval from the readback into the buffer, waiting for it if needed. Returns
+    // false if the readback doesn't hold the interval.
+    bool FinishDownload(SurfaceInterval interval, u8* buffer);
+    // Drops the readback if the interval was written to since it started
+    void InvalidateDownload(SurfaceInterval interval);
+
+    /// Set once the surface has been flushed, readbacks are then started when it is resolved
+    bool download_on_resolve = false;
+    OGLBuffer download_pbo;
+    OGLSync download_fence;
+    SurfaceInterval download_interval;
+
+    // Load/Flush data between 3DS memory and this surface's texture on the GPU, without staging
+    // the pixels on the CPU. Return false when the surface can't be handled by the decoder.
+    bool DecodeGLTexture(ComputeTextureDecoder& decoder, const MathUtil::Rectangle<u32>& rect,
+                         GLuint read_fb_handle, GLuint draw_fb_handle);
+    bool EncodeGLTexture(ComputeTextureDecoder& decoder, PAddr flush_start, PAddr flush_end,
+                         GLuint read_fb_handle, GLuint draw_fb_handle);
 
     std::shared_ptr<SurfaceWatcher> CreateWatcher() {
         auto watcher = std::make_shared<SurfaceWatcher>(weak_from_this());
@@ -392,9 +484,68 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     }
 
 private:
+    void ReadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
+                       GLuint draw_fb_handle, u8* dest);
+
+    RasterizerCacheOpenGL& owner;
     std::list<std::weak_ptr<SurfaceWatcher>> watchers;
 };
 
+/**
+ * The registered surfaces, bucketed by the pages of 3DS memory they overlap. Looking up a range
+ * only visits the buckets of its pages and doesn't allocate.
+ */
+class SurfacePageIndex {
+public:
+    void Add(const Surface& surface);
+    void Remove(const Surface& surface);
+
+    bool Empty() const {
+        return pages.empty();
+    }
+
+    /// Returns every surface of the index, in no particular order
+    std::vector<Surface> GetAll() const;
+
+    /// Calls func once for every surface overlapping the interval
+    template <typename Func>
+    void ForEachOverlapping(SurfaceInterval interval, Func&& func) const {
+        if (boost::icl::is_empty(interval))
+            return;
+
+        const u32 first_page = boost::icl::first(interval) >> Memory::PAGE_BITS;
+        const u32 last_page = boost::icl::last(interval) >> Memory::PAGE_BITS;
+
+        const auto visit_bucket = [&](u32 page, const std::vector<Surface>& bucket) {
+            for (const Surface& surface : bucket) {
+                // Surfaces are in the bucket of every page they touch, only report them from the
+                // first page shared with the interval
+                if (page != std::max(first_page, surface->addr >> Memory::PAGE_BITS))
+                    continue;
+                if (boost::icl::intersects(surface->GetInterval(), interval))
+                    func(surface);
+            }
+        };
+
+        if (last_page - first_page >= pages.size()) {
+            // Cheaper to go through the buckets than through the pages of a huge range
+            for (const auto& [page, bucket] : pages) {
+                if (page >= first_page && page <= last_page)
+                    visit_bucket(page, bucket);
+            }
+        } else {
+            for (u32 page = first_page; page <= last_page; ++page) {
+                const auto it = pages.find(page);
+                if (it != pages.end())
+                    visit_bucket(page, it->second);
+            }
+        }
+    }
+
+private:
+    std::unordered_map<u32, std::vector<Surface>> pages;
+};
+
 struct CachedTextureCube {
     OGLTexture texture;
     u16 res_scale = 1;
@@ -454,10 +605,34 @@ public:
     /// Mark region as being invalidated by region_owner (nullptr if 3DS memory)
     void InvalidateRegion(PAddr addr, u32 size, const Surface& region_owner);
 
+    /// Whether every page touching the region is part of a cached surface
+    bool IsRegionCached(PAddr addr, u32 size) const;
+
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    /// Start reading back the dirty regions of a surface that won't be rendered to for a while,
+    /// if it has been flushed before
+    void ResolveSurface(const Surface& surface);
+
+    /// Count the native resolution pixels covered by a draw against the fill budget
+    void AddDrawnPixels(u32 pixels) {
+        frame_fill += pixels;
+    }
+
+    /// Pick the scale of the render targets for the next frames from the fill of the last one
+    void NotifyFramePresented();
+
+    /// Open the replacement textures of a title, if they are enabled
+    void LoadTexturePack(u64 title_id);
+
+    /// Start writing the textures of a title to the dump folder, if dumping is enabled
+    void StartTextureDump(u64 title_id);
+
 private:
+    /// Look up the replacement of a texture surface's content, uploading it once it is loaded
+    void ApplyCustomTexture(const Surface& surface);
+
     void DuplicateSurface(const Surface& src_surface, const Surface& dest_surface);
 
     /// Update surface's texture for given region when necessary
@@ -475,8 +650,63 @@ private:
     /// Increase/decrease the number of surface in pages touching the specified region
     void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
 
-    SurfaceCache surface_cache;
-    PageMap cached_pages;
+    /// Resolution scale to create a render target with, color and depth share the color's
+    u16 GetTargetResScale(const SurfaceParams& params) const;
+
+    /// Drop the least recently used surfaces while the cache is over its memory budget
+    void EvictSurfaces();
+
+    /// Get a texture for a surface of the format and scaled size, reusing a recycled one if
+    /// possible
+    OGLTexture AllocateTexture(SurfaceParams::PixelFormat format, u32 width, u32 height);
+
+    /// Keep a texture that is no longer used for a later AllocateTexture
+    void RecycleTexture(SurfaceParams::PixelFormat format, u32 width, u32 height,
+                        OGLTexture&& texture);
+
+    /// Get the buffer the surfaces stage the pixels they load and flush in, of at least the size.
+    /// Its content is only valid until the next call.
+    u8* GetStagingBuffer(std::size_t size);
+
+    friend struct CachedSurface;
+
+    SurfacePageIndex surface_cache;
+    /// Number of registered surfaces touching each page, pages without one are left out
+    std::unordered_map<u32, u32> cached_pages;
+
+    /// Render targets smaller than this are kept at native resolution
+    static constexpr u32 MIN_SCALED_TARGET_PIXELS = 128 * 128;
+    /// Render targets read back to memory this many times are kept at native resolution
+    static constexpr u32 NATIVE_READ_BACKS = 3;
+    /// Frames the fill has to stay over or under the budget before the scale changes. Lowering
+    /// it quickly keeps heavy scenes smooth, raising it slowly avoids recreating every render
+    /// target back and forth.
+    static constexpr u32 SCALE_DOWN_FRAMES = 10;
+    static constexpr u32 SCALE_UP_FRAMES = 120;
+
+    /// Scale the render targets use, and the one the fill budget allows
+    u16 target_res_scale;
+    u16 budget_res_scale;
+    u16 budget_resolution_factor;
+    u64 frame_fill = 0;
+    u32 scale_down_frames = 0;
+    u32 scale_up_frames = 0;
+    /// Number of times each render target address has been read back
+    std::unordered_map<PAddr, u32> read_back_targets;
+
+    /// Incremented every time a surface is used, orders the surfaces for eviction
+    u64 use_counter = 0;
+    u64 cached_bytes = 0;
+    u32 cached_surface_count = 0;
+
+    std::unordered_multimap<HostTextureTag, OGLTexture> texture_recycler;
+    u64 recycled_bytes = 0;
+    /// Accounts the textures of both the cached surfaces and the recycler
+    Common::ScopedMemoryUsage texture_memory_usage{Common::MemoryCategory::SurfaceVRAM};
+    /// Shared by all the surfaces, so that only the largest one loaded or flushed is kept on the
+    /// CPU rather than a copy of every surface
+    std::vector<u8> staging_buffer;
+    Common::ScopedMemoryUsage staging_buffer_usage{Common::MemoryCategory::SurfaceStaging};
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
@@ -490,6 +720,18 @@ private:
     GLint d24s8_abgr_tbo_size_u_id;
     GLint d24s8_abgr_viewport_u_id;
 
+    std::unique_ptr<ComputeTextureDecoder> texture_decoder;
+    /// Upscales the textures loaded into scaled surfaces, if a texture filter is enabled
+    std::unique_ptr<TextureFilterer> texture_filterer;
+    /// Persistently mapped staging ring textures are uploaded from, when buffer storage is
+    /// supported
+    std::unique_ptr<OGLStreamBuffer> upload_buffer;
+    std::unique_ptr<TexturePack> texture_pack;
+    std::unique_ptr<TextureDumper> texture_dumper;
+
+    Surface last_color_surface;
+    Surface last_depth_surface;
+
     std::unordered_map<TextureCubeConfig, CachedTextureCube> texture_cube_cache;
 };
 } // namespace OpenGL
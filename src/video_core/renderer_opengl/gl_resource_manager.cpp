@@ -133,6 +133,23 @@ void OGLBuffer::Release() {
     handle = 0;
 }
 
+void OGLSync::Create() {
+    if (handle != nullptr)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_ResourceCreation);
+    handle = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OGLSync::Release() {
+    if (handle == nullptr)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_ResourceDeletion);
+    glDeleteSync(handle);
+    handle = nullptr;
+}
+
 void OGLVertexArray::Create() {
     if (handle != 0)
         return;
@@ -169,4 +186,21 @@ void OGLFramebuffer::Release() {
     handle = 0;
 }
 
+void OGLRenderbuffer::Create() {
+    if (handle != 0)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_ResourceCreation);
+    glGenRenderbuffers(1, &handle);
+}
+
+void OGLRenderbuffer::Release() {
+    if (handle == 0)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_ResourceDeletion);
+    glDeleteRenderbuffers(1, &handle);
+    handle = 0;
+}
+
 } // namespace OpenGL
@@ -2,12 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <bitset>
 #include <exception>
 #include <map>
 #include <set>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -194,6 +196,141 @@ private:
     }
 };
 
+/**
+ * Finds the registers the reachable code reads anywhere, so that the generator can drop the writes
+ * nothing reads. This doesn't follow the control flow, a register is live for the whole program as
+ * soon as one instruction reads it, which keeps it correct across jumps and loops.
+ */
+struct RegisterUsage {
+    RegisterUsage(const std::set<Subroutine>& subroutines, const ProgramCode& program_code) {
+        std::set<u32> scanned;
+        std::vector<Instruction> instructions;
+        for (const Subroutine& subroutine : subroutines) {
+            for (u32 offset = subroutine.begin; offset != subroutine.end && offset != PROGRAM_END;
+                 ++offset) {
+                if (scanned.insert(offset).second) {
+                    instructions.push_back(Instruction{program_code[offset]});
+                    Scan(instructions.back());
+                }
+            }
+        }
+        FindFiniteTemporaries(instructions);
+    }
+
+    /// Whether a source register always holds finite values, so it can't be a factor of 0 * inf
+    bool IsFinite(const SourceRegister& source) const {
+        return source.GetRegisterType() == RegisterType::Temporary &&
+               finite_temporaries[source.GetIndex()];
+    }
+
+    /// Temporary registers read by at least one instruction
+    std::bitset<16> read_temporaries;
+    /// Temporary registers that only ever hold finite values
+    std::bitset<16> finite_temporaries;
+    /// Whether an instruction branches on the conditional code written by CMP
+    bool reads_conditional_code = false;
+    /// Whether an instruction is indexed by the address registers written by MOVA
+    bool reads_address_registers = false;
+
+private:
+    void ReadSource(const SourceRegister& source) {
+        if (source.GetRegisterType() == RegisterType::Temporary) {
+            read_temporaries.set(source.GetIndex());
+        }
+    }
+
+    void Scan(const Instruction& instr) {
+        // Every source field counts as read, even for the opcodes that ignore some of them
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic:
+            for (bool is_inverted : {false, true}) {
+                ReadSource(instr.common.GetSrc1(is_inverted));
+                ReadSource(instr.common.GetSrc2(is_inverted));
+            }
+            // Index 3 is the loop counter, which is set by LOOP and not by MOVA
+            if (instr.common.address_register_index == 1 ||
+                instr.common.address_register_index == 2) {
+                reads_address_registers = true;
+            }
+            break;
+        case OpCode::Type::MultiplyAdd:
+            for (bool is_inverted : {false, true}) {
+                ReadSource(instr.mad.GetSrc1(is_inverted));
+                ReadSource(instr.mad.GetSrc2(is_inverted));
+                ReadSource(instr.mad.GetSrc3(is_inverted));
+            }
+            if (instr.mad.address_register_index == 1 || instr.mad.address_register_index == 2) {
+                reads_address_registers = true;
+            }
+            break;
+        default:
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::JMPC:
+            case OpCode::Id::CALLC:
+            case OpCode::Id::IFC:
+                reads_conditional_code = true;
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+    }
+
+    /**
+     * Starts from every temporary being finite, as they are initialized to (0, 0, 0, 1), and drops
+     * the ones written with a value that isn't known to be finite until nothing changes. Only
+     * comparisons yield finite values from anything, the sums and products of finite values can
+     * overflow to infinity. Control flow is ignored, so every write counts.
+     */
+    void FindFiniteTemporaries(const std::vector<Instruction>& instructions) {
+        finite_temporaries.set();
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const Instruction& instr : instructions) {
+                const auto type = instr.opcode.Value().GetInfo().type;
+                if (type != OpCode::Type::Arithmetic && type != OpCode::Type::MultiplyAdd) {
+                    continue;
+                }
+                const auto dest = type == OpCode::Type::Arithmetic ? instr.common.dest.Value()
+                                                                   : instr.mad.dest.Value();
+                if (dest.GetRegisterType() != RegisterType::Temporary ||
+                    !finite_temporaries[dest.GetIndex()] || WritesFiniteValue(instr)) {
+                    continue;
+                }
+                finite_temporaries.reset(dest.GetIndex());
+                changed = true;
+            }
+        }
+    }
+
+    bool WritesFiniteValue(const Instruction& instr) const {
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        switch (instr.opcode.Value().EffectiveOpCode()) {
+        case OpCode::Id::SGE:
+        case OpCode::Id::SGEI:
+        case OpCode::Id::SLT:
+        case OpCode::Id::SLTI:
+            return true;
+        case OpCode::Id::MOV:
+        case OpCode::Id::FLR:
+            return IsFinite(instr.common.GetSrc1(is_inverted));
+        case OpCode::Id::MAX:
+        case OpCode::Id::MIN:
+            return IsFinite(instr.common.GetSrc1(is_inverted)) &&
+                   IsFinite(instr.common.GetSrc2(is_inverted));
+        case OpCode::Id::MOVA:
+        case OpCode::Id::CMP:
+            // Don't write a temporary, their destination field is unused
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
 class ShaderWriter {
 public:
     void AddLine(const std::string& text) {
@@ -252,7 +389,8 @@ public:
                   bool sanitize_mul, bool is_gs)
         : subroutines(subroutines), program_code(program_code), swizzle_data(swizzle_data),
           main_offset(main_offset), inputreg_getter(inputreg_getter),
-          outputreg_getter(outputreg_getter), sanitize_mul(sanitize_mul), is_gs(is_gs) {
+          outputreg_getter(outputreg_getter), sanitize_mul(sanitize_mul), is_gs(is_gs),
+          usage(subroutines, program_code) {
 
         Generate();
     }
@@ -325,7 +463,7 @@ private:
         }
     }
 
-    /// Generates code representing a destination register.
+    /// Generates code representing a destination register. Empty if the write can be dropped.
     std::string GetDestRegister(const DestRegister& dest_reg) const {
         u32 index = static_cast<u32>(dest_reg.GetIndex());
 
@@ -333,6 +471,9 @@ private:
         case RegisterType::Output:
             return outputreg_getter(index);
         case RegisterType::Temporary:
+            if (!usage.read_temporaries[index]) {
+                return "";
+            }
             return "reg_tmp" + std::to_string(index);
         default:
             UNREACHABLE();
@@ -406,6 +547,34 @@ private:
         shader.AddLine(dest + " = " + src + ";");
     }
 
+    /**
+     * Checks whether a multiplication has to be emitted as sanitize_mul, so that 0 * inf gives 0.
+     * That can't happen when both factors are always finite, nor when they are the same value,
+     * as then zero is only ever multiplied by zero.
+     * @param num_components number of leading components of the factors that are multiplied.
+     */
+    bool NeedsSanitizedMul(const SwizzlePattern& swizzle, const SourceRegister& src1,
+                           u32 src1_address, const SourceRegister& src2, u32 src2_address,
+                           u32 num_components) const {
+        if (!sanitize_mul) {
+            return false;
+        }
+        if (usage.IsFinite(src1) && usage.IsFinite(src2)) {
+            return false;
+        }
+        if (src1.GetRegisterType() == src2.GetRegisterType() &&
+            src1.GetIndex() == src2.GetIndex() && src1_address == src2_address) {
+            for (u32 i = 0; i < num_components; ++i) {
+                if (swizzle.GetSelectorSrc1(static_cast<int>(i)) !=
+                    swizzle.GetSelectorSrc2(static_cast<int>(i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+
     /**
      * Compiles a single instruction from PICA to GLSL.
      * @param offset the offset of the PICA shader instruction.
@@ -429,14 +598,16 @@ private:
             const bool is_inverted =
                 (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
 
+            const SourceRegister src1_reg = instr.common.GetSrc1(is_inverted);
+            const u32 src1_address = !is_inverted * instr.common.address_register_index;
             std::string src1 = swizzle.negate_src1 ? "-" : "";
-            src1 += GetSourceRegister(instr.common.GetSrc1(is_inverted),
-                                      !is_inverted * instr.common.address_register_index);
+            src1 += GetSourceRegister(src1_reg, src1_address);
             src1 += "." + GetSelectorSrc1(swizzle);
 
+            const SourceRegister src2_reg = instr.common.GetSrc2(is_inverted);
+            const u32 src2_address = is_inverted * instr.common.address_register_index;
             std::string src2 = swizzle.negate_src2 ? "-" : "";
-            src2 += GetSourceRegister(instr.common.GetSrc2(is_inverted),
-                                      is_inverted * instr.common.address_register_index);
+            src2 += GetSourceRegister(src2_reg, src2_address);
             src2 += "." + GetSelectorSrc2(swizzle);
 
             std::string dest_reg = GetDestRegister(instr.common.dest.Value());
@@ -448,7 +619,8 @@ private:
             }
 
             case OpCode::Id::MUL: {
-                if (sanitize_mul) {
+                if (NeedsSanitizedMul(swizzle, src1_reg, src1_address, src2_reg, src2_address,
+                                      4)) {
                     SetDest(swizzle, dest_reg, "sanitize_mul(" + src1 + ", " + src2 + ")", 4, 4);
                 } else {
                     SetDest(swizzle, dest_reg, src1 + " * " + src2, 4, 4);
@@ -477,8 +649,12 @@ private:
             case OpCode::Id::DPHI: {
                 OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
                 std::string dot;
+                // The w component of DPH is multiplied by 1.0, which can't be 0 or inf
+                const bool sanitize =
+                    NeedsSanitizedMul(swizzle, src1_reg, src1_address, src2_reg, src2_address,
+                                      opcode == OpCode::Id::DP4 ? 4 : 3);
                 if (opcode == OpCode::Id::DP3) {
-                    if (sanitize_mul) {
+                    if (sanitize) {
                         dot = "dot(vec3(sanitize_mul(" + src1 + ", " + src2 + ")), vec3(1.0))";
                     } else {
                         dot = "dot(vec3(" + src1 + "), vec3(" + src2 + "))";
@@ -487,7 +663,7 @@ private:
                     std::string src1_ = (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
                                             ? "vec4(" + src1 + ".xyz, 1.0)"
                                             : src1;
-                    if (sanitize_mul) {
+                    if (sanitize) {
                         dot = "dot(sanitize_mul(" + src1_ + ", " + src2 + "), vec4(1.0))";
                     } else {
                         dot = "dot(" + src1 + ", " + src2 + ")";
@@ -509,6 +685,9 @@ private:
             }
 
             case OpCode::Id::MOVA: {
+                if (!usage.reads_address_registers) {
+                    break;
+                }
                 SetDest(swizzle, "address_registers", "ivec2(" + src1 + ")", 2, 2);
                 break;
             }
@@ -532,6 +711,10 @@ private:
             }
 
             case OpCode::Id::CMP: {
+                if (!usage.reads_conditional_code) {
+                    break;
+                }
+
                 using CompareOp = Instruction::Common::CompareOpType::Op;
                 const std::map<CompareOp, std::pair<std::string, std::string>> cmp_ops{
                     {CompareOp::Equal, {"==", "equal"}},
@@ -587,13 +770,15 @@ private:
                 (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
                 bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
 
+                const SourceRegister src1_reg = instr.mad.GetSrc1(is_inverted);
                 std::string src1 = swizzle.negate_src1 ? "-" : "";
-                src1 += GetSourceRegister(instr.mad.GetSrc1(is_inverted), 0);
+                src1 += GetSourceRegister(src1_reg, 0);
                 src1 += "." + GetSelectorSrc1(swizzle);
 
+                const SourceRegister src2_reg = instr.mad.GetSrc2(is_inverted);
+                const u32 src2_address = !is_inverted * instr.mad.address_register_index;
                 std::string src2 = swizzle.negate_src2 ? "-" : "";
-                src2 += GetSourceRegister(instr.mad.GetSrc2(is_inverted),
-                                          !is_inverted * instr.mad.address_register_index);
+                src2 += GetSourceRegister(src2_reg, src2_address);
                 src2 += "." + GetSelectorSrc2(swizzle);
 
                 std::string src3 = swizzle.negate_src3 ? "-" : "";
@@ -601,14 +786,11 @@ private:
                                           is_inverted * instr.mad.address_register_index);
                 src3 += "." + GetSelectorSrc3(swizzle);
 
-                std::string dest_reg =
-                    (instr.mad.dest.Value() < 0x10)
-                        ? outputreg_getter(static_cast<u32>(instr.mad.dest.Value().GetIndex()))
-                        : (instr.mad.dest.Value() < 0x20)
-                              ? "reg_tmp" + std::to_string(instr.mad.dest.Value().GetIndex())
-                              : "";
+                std::string dest_reg = (instr.mad.dest.Value() < 0x20)
+                                           ? GetDestRegister(instr.mad.dest.Value())
+                                           : "";
 
-                if (sanitize_mul) {
+                if (NeedsSanitizedMul(swizzle, src1_reg, 0, src2_reg, src2_address, 4)) {
                     SetDest(swizzle, dest_reg, "sanitize_mul(" + src1 + ", " + src2 + ") + " + src3,
                             4, 4);
                 } else {
@@ -891,6 +1073,7 @@ private:
     const RegGetter& outputreg_getter;
     const bool sanitize_mul;
     const bool is_gs;
+    const RegisterUsage usage;
 
     ShaderWriter shader;
 };
@@ -0,0 +1,271 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL {
+
+namespace {
+
+// "CSDC" - Citra Shader Disk Cache
+constexpr u32 CACHE_MAGIC = 0x43445343;
+// Bump this whenever the layout of the file or of a cached key type changes
+constexpr u32 CACHE_VERSION = 2;
+
+// "CSUP" - Citra Shader Usage Profile
+constexpr u32 PROFILE_MAGIC = 0x50555343;
+constexpr u32 PROFILE_VERSION = 1;
+
+struct FileHeader {
+    u32 magic;
+    u32 version;
+    u64 build_hash;
+    u32 separable;
+    u32 reserved;
+};
+static_assert(sizeof(FileHeader) == 24, "FileHeader has incorrect size");
+
+struct EntryHeader {
+    ProgramType type;
+    u32 key_size;
+    u32 code_size;
+    u32 binary_format;
+    u32 binary_size;
+};
+static_assert(sizeof(EntryHeader) == 20, "EntryHeader has incorrect size");
+
+struct ProfileHeader {
+    u32 magic;
+    u32 version;
+    u32 num_entries;
+    u32 reserved;
+};
+static_assert(sizeof(ProfileHeader) == 16, "ProfileHeader has incorrect size");
+
+struct ProfileEntry {
+    u64 key_hash;
+    u32 first_use;
+    u32 reserved;
+};
+static_assert(sizeof(ProfileEntry) == 16, "ProfileEntry has incorrect size");
+
+u64 GetBuildHash() {
+    // Generated GLSL changes between builds, so a cache is only valid for the build that wrote it
+    return Common::ComputeHash64(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+}
+
+FileHeader MakeHeader(bool separable) {
+    FileHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.build_hash = GetBuildHash();
+    header.separable = separable ? 1 : 0;
+    return header;
+}
+
+} // Anonymous namespace
+
+ShaderDiskCache::ShaderDiskCache(u64 title_id, bool separable)
+    : title_id(title_id), separable(separable) {}
+
+ShaderDiskCache::~ShaderDiskCache() = default;
+
+std::string ShaderDiskCache::GetFilePath() const {
+    return fmt::format("{}opengl" DIR_SEP "{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir), title_id);
+}
+
+std::vector<ShaderDiskCacheEntry> ShaderDiskCache::Load() {
+    std::vector<ShaderDiskCacheEntry> entries;
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::Exists(path)) {
+        Recreate();
+        return entries;
+    }
+
+    FileUtil::IOFile read_file(path, "rb");
+    FileHeader header{};
+    const FileHeader expected = MakeHeader(separable);
+    if (read_file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        std::memcmp(&header, &expected, sizeof(header)) != 0) {
+        LOG_INFO(Render_OpenGL, "Shader disk cache for {:016X} is outdated, recreating it",
+                 title_id);
+        read_file.Close();
+        Recreate();
+        return entries;
+    }
+
+    const u64 file_size = read_file.GetSize();
+    while (read_file.Tell() < file_size) {
+        EntryHeader entry_header{};
+        if (read_file.ReadBytes(&entry_header, sizeof(entry_header)) != sizeof(entry_header)) {
+            break;
+        }
+
+        const u64 payload_size = static_cast<u64>(entry_header.key_size) +
+                                 entry_header.code_size + entry_header.binary_size;
+        if (read_file.Tell() + payload_size > file_size) {
+            // The last write was interrupted, drop the incomplete entry
+            LOG_WARNING(Render_OpenGL, "Shader disk cache for {:016X} has a truncated entry",
+                        title_id);
+            break;
+        }
+
+        ShaderDiskCacheEntry& entry = entries.emplace_back();
+        entry.type = entry_header.type;
+        entry.key.resize(entry_header.key_size);
+        entry.code.resize(entry_header.code_size);
+        entry.binary_format = entry_header.binary_format;
+        entry.binary.resize(entry_header.binary_size);
+        read_file.ReadBytes(entry.key.data(), entry.key.size());
+        read_file.ReadBytes(entry.code.data(), entry.code.size());
+        read_file.ReadBytes(entry.binary.data(), entry.binary.size());
+    }
+
+    LOG_INFO(Render_OpenGL, "Loaded {} entries from the shader disk cache for {:016X}",
+             entries.size(), title_id);
+    return entries;
+}
+
+void ShaderDiskCache::Save(const ShaderDiskCacheEntry& entry) {
+    if (!EnsureOpenForAppend()) {
+        return;
+    }
+
+    EntryHeader entry_header{};
+    entry_header.type = entry.type;
+    entry_header.key_size = static_cast<u32>(entry.key.size());
+    entry_header.code_size = static_cast<u32>(entry.code.size());
+    entry_header.binary_format = entry.binary_format;
+    entry_header.binary_size = static_cast<u32>(entry.binary.size());
+
+    file.WriteObject(entry_header);
+    file.WriteBytes(entry.key.data(), entry.key.size());
+    file.WriteBytes(entry.code.data(), entry.code.size());
+    file.WriteBytes(entry.binary.data(), entry.binary.size());
+    // Flush right away so that the entry survives a crash of the emulator
+    file.Flush();
+}
+
+bool ShaderDiskCache::Recreate() {
+    file.Close();
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create the shader disk cache directory {}", path);
+        return false;
+    }
+
+    if (!file.Open(path, "wb")) {
+        LOG_ERROR(Render_OpenGL, "Failed to create the shader disk cache file {}", path);
+        return false;
+    }
+
+    file.WriteObject(MakeHeader(separable));
+    file.Flush();
+    return file.IsGood();
+}
+
+bool ShaderDiskCache::EnsureOpenForAppend() {
+    if (file.IsOpen()) {
+        return file.IsGood();
+    }
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::Exists(path)) {
+        return Recreate();
+    }
+    return file.Open(path, "ab");
+}
+
+ShaderUsageProfile::ShaderUsageProfile(u64 title_id) : title_id(title_id) {}
+
+ShaderUsageProfile::~ShaderUsageProfile() = default;
+
+u64 ShaderUsageProfile::GetKeyHash(ProgramType type, const std::vector<u8>& key) {
+    // Keys of different types can have the same bytes, the type is folded into the hash
+    return Common::ComputeHash64(key.data(), key.size()) * 31 + static_cast<u64>(type) + 1;
+}
+
+std::string ShaderUsageProfile::GetFilePath() const {
+    return fmt::format("{}opengl" DIR_SEP "{:016X}.usage",
+                       FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir), title_id);
+}
+
+void ShaderUsageProfile::Load() {
+    first_uses.clear();
+    dirty = false;
+
+    FileUtil::IOFile file(GetFilePath(), "rb");
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    ProfileHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != PROFILE_MAGIC || header.version != PROFILE_VERSION) {
+        LOG_INFO(Render_OpenGL, "Ignoring outdated shader usage profile for {:016X}", title_id);
+        return;
+    }
+
+    std::vector<ProfileEntry> entries(header.num_entries);
+    const std::size_t size = entries.size() * sizeof(ProfileEntry);
+    if (file.ReadBytes(entries.data(), size) != size) {
+        LOG_WARNING(Render_OpenGL, "Shader usage profile for {:016X} is truncated", title_id);
+        return;
+    }
+    for (const ProfileEntry& entry : entries) {
+        first_uses.emplace(entry.key_hash, entry.first_use);
+    }
+}
+
+void ShaderUsageProfile::Save() {
+    if (!dirty) {
+        return;
+    }
+    dirty = false;
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create the shader usage profile directory {}", path);
+        return;
+    }
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Render_OpenGL, "Failed to write the shader usage profile {}", path);
+        return;
+    }
+
+    std::vector<ProfileEntry> entries;
+    entries.reserve(first_uses.size());
+    for (const auto& [key_hash, first_use] : first_uses) {
+        entries.push_back({key_hash, first_use, 0});
+    }
+    const ProfileHeader header{PROFILE_MAGIC, PROFILE_VERSION, static_cast<u32>(entries.size()),
+                               0};
+    file.WriteObject(header);
+    file.WriteBytes(entries.data(), entries.size() * sizeof(ProfileEntry));
+}
+
+u32 ShaderUsageProfile::GetFirstUse(u64 key_hash) const {
+    const auto it = first_uses.find(key_hash);
+    return it != first_uses.end() ? it->second : NOT_USED;
+}
+
+void ShaderUsageProfile::RecordUse(u64 key_hash, u32 frame) {
+    auto [it, inserted] = first_uses.emplace(key_hash, frame);
+    if (inserted || frame < it->second) {
+        it->second = frame;
+        dirty = true;
+    }
+}
+
+} // namespace OpenGL
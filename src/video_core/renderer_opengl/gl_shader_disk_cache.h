@@ -0,0 +1,105 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace OpenGL {
+
+/// Identifies which of the shader caches in ShaderProgramManager an entry belongs to
+enum class ProgramType : u32 {
+    VS = 0,
+    FixedGS = 1,
+    GS = 2,
+    FS = 3,
+};
+
+/// A single generated shader stage as it is stored in the disk cache
+struct ShaderDiskCacheEntry {
+    ProgramType type;
+    /// Raw bytes of the config key (PicaVSConfig, PicaFSConfig...) the shader was generated for
+    std::vector<u8> key;
+    /// Generated GLSL source code
+    std::string code;
+    /// Driver specific program binary, only available for separable programs
+    GLenum binary_format = 0;
+    std::vector<u8> binary;
+};
+
+/**
+ * A per-title, append-only store for the GLSL shaders generated by ShaderProgramManager. Entries
+ * are written as soon as a new shader is compiled and are all read back when the title boots, so
+ * that the shaders can be built before the first draw that uses them.
+ */
+class ShaderDiskCache {
+public:
+    ShaderDiskCache(u64 title_id, bool separable);
+    ~ShaderDiskCache();
+
+    /**
+     * Reads all the entries stored for the title. If the file is missing, was written by a
+     * different build or for a different shader mode, it is recreated empty.
+     * @returns the entries in the order they were written
+     */
+    std::vector<ShaderDiskCacheEntry> Load();
+
+    /// Appends an entry to the cache file
+    void Save(const ShaderDiskCacheEntry& entry);
+
+    /// Truncates the cache file and writes a fresh header
+    bool Recreate();
+
+private:
+    bool EnsureOpenForAppend();
+
+    std::string GetFilePath() const;
+
+    u64 title_id;
+    bool separable;
+    FileUtil::IOFile file;
+};
+
+/**
+ * Records the first frame of a session in which each shader of a title was used. The shaders of
+ * the disk cache are built in that order on boot, so that the ones of the first scenes are ready
+ * first while the rest keep compiling in the background.
+ */
+class ShaderUsageProfile {
+public:
+    /// First use of a shader that was never used
+    static constexpr u32 NOT_USED = 0xFFFFFFFF;
+
+    explicit ShaderUsageProfile(u64 title_id);
+    ~ShaderUsageProfile();
+
+    /// Identifies a shader by its disk cache entry type and key
+    static u64 GetKeyHash(ProgramType type, const std::vector<u8>& key);
+
+    /// Reads the profile of the title. If the file is missing or invalid, the profile stays empty.
+    void Load();
+
+    /// Writes the profile if it changed since it was loaded
+    void Save();
+
+    /// Returns the first frame the shader was used in, or NOT_USED
+    u32 GetFirstUse(u64 key_hash) const;
+
+    /// Records a use of a shader, keeping the earliest frame it was used in
+    void RecordUse(u64 key_hash, u32 frame);
+
+private:
+    std::string GetFilePath() const;
+
+    u64 title_id;
+    std::unordered_map<u64, u32> first_uses;
+    bool dirty = false;
+};
+
+} // namespace OpenGL
@@ -10,6 +10,7 @@
 #include "common/bit_set.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/settings.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_lighting.h"
 #include "video_core/regs_rasterizer.h"
@@ -18,7 +19,6 @@
 #include "video_core/renderer_opengl/gl_shader_decompiler.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
-#include "video_core/video_core.h"
 
 using Pica::FramebufferRegs;
 using Pica::LightingRegs;
@@ -107,19 +107,87 @@ out gl_PerVertex {
     return out;
 }
 
+/// Number of sources a TEV combiner operation reads
+static unsigned GetTevOperandCount(TevStageConfig::Operation operation) {
+    using Operation = TevStageConfig::Operation;
+    switch (operation) {
+    case Operation::Replace:
+        return 1;
+    case Operation::Modulate:
+    case Operation::Add:
+    case Operation::AddSigned:
+    case Operation::Subtract:
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+/**
+ * Copies the fields of a TEV stage the generated code reads. The sources and modifiers past the
+ * ones the operation uses are left cleared, as is the alpha combiner of Dot3_RGBA stages, so that
+ * stages which only differ in unused fields share a shader.
+ */
+static TevStageConfigRaw CanonicalizeTevStage(const TevStageConfig& stage) {
+    TevStageConfig result{};
+
+    const unsigned color_operands = GetTevOperandCount(stage.color_op);
+    result.color_op.Assign(stage.color_op);
+    result.color_source1.Assign(stage.color_source1);
+    result.color_modifier1.Assign(stage.color_modifier1);
+    if (color_operands > 1) {
+        result.color_source2.Assign(stage.color_source2);
+        result.color_modifier2.Assign(stage.color_modifier2);
+    }
+    if (color_operands > 2) {
+        result.color_source3.Assign(stage.color_source3);
+        result.color_modifier3.Assign(stage.color_modifier3);
+    }
+
+    // Dot3_RGBA writes its color result to the alpha component too
+    if (stage.color_op != TevStageConfig::Operation::Dot3_RGBA) {
+        const unsigned alpha_operands = GetTevOperandCount(stage.alpha_op);
+        result.alpha_op.Assign(stage.alpha_op);
+        result.alpha_source1.Assign(stage.alpha_source1);
+        result.alpha_modifier1.Assign(stage.alpha_modifier1);
+        if (alpha_operands > 1) {
+            result.alpha_source2.Assign(stage.alpha_source2);
+            result.alpha_modifier2.Assign(stage.alpha_modifier2);
+        }
+        if (alpha_operands > 2) {
+            result.alpha_source3.Assign(stage.alpha_source3);
+            result.alpha_modifier3.Assign(stage.alpha_modifier3);
+        }
+    }
+
+    // Scale 3 is reserved and multiplies by 1 like scale 0
+    result.color_scale.Assign(stage.color_scale == 3 ? 0 : stage.color_scale.Value());
+    result.alpha_scale.Assign(stage.alpha_scale == 3 ? 0 : stage.alpha_scale.Value());
+
+    return {result.sources_raw, result.modifiers_raw, result.ops_raw, result.scales_raw};
+}
+
 PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     PicaFSConfig res;
 
     auto& state = res.state;
 
-    state.scissor_test_mode = regs.rasterizer.scissor_test.mode;
-
-    state.depthmap_enable = regs.rasterizer.depthmap_enable;
-
+    // Fields the generated shader doesn't read in the current configuration are left zeroed, so
+    // that configurations which only differ by them share a shader.
     state.alpha_test_func = regs.framebuffer.output_merger.alpha_test.enable
                                 ? regs.framebuffer.output_merger.alpha_test.func.Value()
                                 : FramebufferRegs::CompareFunc::Always;
 
+    // Every fragment is discarded before anything else is computed
+    if (state.alpha_test_func == FramebufferRegs::CompareFunc::Never)
+        return res;
+
+    state.scissor_test_mode = regs.rasterizer.scissor_test.mode;
+
+    state.depthmap_enable = regs.rasterizer.depthmap_enable;
+
     state.texture0_type = regs.texturing.texture0.type;
 
     state.texture2_use_coord1 = regs.texturing.main_config.texture2_use_coord1 != 0;
@@ -130,15 +198,13 @@ PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     const auto& tev_stages = regs.texturing.GetTevStages();
     DEBUG_ASSERT(state.tev_stages.size() == tev_stages.size());
     for (std::size_t i = 0; i < tev_stages.size(); i++) {
-        const auto& tev_stage = tev_stages[i];
-        state.tev_stages[i].sources_raw = tev_stage.sources_raw;
-        state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
-        state.tev_stages[i].ops_raw = tev_stage.ops_raw;
-        state.tev_stages[i].scales_raw = tev_stage.scales_raw;
+        state.tev_stages[i] = CanonicalizeTevStage(tev_stages[i]);
     }
 
     state.fog_mode = regs.texturing.fog_mode;
-    state.fog_flip = regs.texturing.fog_flip != 0;
+    if (state.fog_mode == TexturingRegs::FogMode::Fog) {
+        state.fog_flip = regs.texturing.fog_flip != 0;
+    }
 
     state.combiner_buffer_input = regs.texturing.tev_combiner_buffer_input.update_mask_rgb.Value() |
                                   regs.texturing.tev_combiner_buffer_input.update_mask_a.Value()
@@ -147,73 +213,94 @@ PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     // Fragment lighting
 
     state.lighting.enable = !regs.lighting.disable;
-    state.lighting.src_num = regs.lighting.max_light_index + 1;
-
-    for (unsigned light_index = 0; light_index < state.lighting.src_num; ++light_index) {
-        unsigned num = regs.lighting.light_enable.GetNum(light_index);
-        const auto& light = regs.lighting.light[num];
-        state.lighting.light[light_index].num = num;
-        state.lighting.light[light_index].directional = light.config.directional != 0;
-        state.lighting.light[light_index].two_sided_diffuse = light.config.two_sided_diffuse != 0;
-        state.lighting.light[light_index].geometric_factor_0 = light.config.geometric_factor_0 != 0;
-        state.lighting.light[light_index].geometric_factor_1 = light.config.geometric_factor_1 != 0;
-        state.lighting.light[light_index].dist_atten_enable =
-            !regs.lighting.IsDistAttenDisabled(num);
-        state.lighting.light[light_index].spot_atten_enable =
-            !regs.lighting.IsSpotAttenDisabled(num);
-        state.lighting.light[light_index].shadow_enable = !regs.lighting.IsShadowDisabled(num);
-    }
-
-    state.lighting.lut_d0.enable = regs.lighting.config1.disable_lut_d0 == 0;
-    state.lighting.lut_d0.abs_input = regs.lighting.abs_lut_input.disable_d0 == 0;
-    state.lighting.lut_d0.type = regs.lighting.lut_input.d0.Value();
-    state.lighting.lut_d0.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d0);
-
-    state.lighting.lut_d1.enable = regs.lighting.config1.disable_lut_d1 == 0;
-    state.lighting.lut_d1.abs_input = regs.lighting.abs_lut_input.disable_d1 == 0;
-    state.lighting.lut_d1.type = regs.lighting.lut_input.d1.Value();
-    state.lighting.lut_d1.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d1);
-
-    // this is a dummy field due to lack of the corresponding register
-    state.lighting.lut_sp.enable = true;
-    state.lighting.lut_sp.abs_input = regs.lighting.abs_lut_input.disable_sp == 0;
-    state.lighting.lut_sp.type = regs.lighting.lut_input.sp.Value();
-    state.lighting.lut_sp.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.sp);
-
-    state.lighting.lut_fr.enable = regs.lighting.config1.disable_lut_fr == 0;
-    state.lighting.lut_fr.abs_input = regs.lighting.abs_lut_input.disable_fr == 0;
-    state.lighting.lut_fr.type = regs.lighting.lut_input.fr.Value();
-    state.lighting.lut_fr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.fr);
-
-    state.lighting.lut_rr.enable = regs.lighting.config1.disable_lut_rr == 0;
-    state.lighting.lut_rr.abs_input = regs.lighting.abs_lut_input.disable_rr == 0;
-    state.lighting.lut_rr.type = regs.lighting.lut_input.rr.Value();
-    state.lighting.lut_rr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rr);
-
-    state.lighting.lut_rg.enable = regs.lighting.config1.disable_lut_rg == 0;
-    state.lighting.lut_rg.abs_input = regs.lighting.abs_lut_input.disable_rg == 0;
-    state.lighting.lut_rg.type = regs.lighting.lut_input.rg.Value();
-    state.lighting.lut_rg.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rg);
-
-    state.lighting.lut_rb.enable = regs.lighting.config1.disable_lut_rb == 0;
-    state.lighting.lut_rb.abs_input = regs.lighting.abs_lut_input.disable_rb == 0;
-    state.lighting.lut_rb.type = regs.lighting.lut_input.rb.Value();
-    state.lighting.lut_rb.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rb);
-
-    state.lighting.config = regs.lighting.config0.config;
-    state.lighting.enable_primary_alpha = regs.lighting.config0.enable_primary_alpha;
-    state.lighting.enable_secondary_alpha = regs.lighting.config0.enable_secondary_alpha;
-    state.lighting.bump_mode = regs.lighting.config0.bump_mode;
-    state.lighting.bump_selector = regs.lighting.config0.bump_selector;
-    state.lighting.bump_renorm = regs.lighting.config0.disable_bump_renorm == 0;
-    state.lighting.clamp_highlights = regs.lighting.config0.clamp_highlights != 0;
-
-    state.lighting.enable_shadow = regs.lighting.config0.enable_shadow != 0;
-    state.lighting.shadow_primary = regs.lighting.config0.shadow_primary != 0;
-    state.lighting.shadow_secondary = regs.lighting.config0.shadow_secondary != 0;
-    state.lighting.shadow_invert = regs.lighting.config0.shadow_invert != 0;
-    state.lighting.shadow_alpha = regs.lighting.config0.shadow_alpha != 0;
-    state.lighting.shadow_selector = regs.lighting.config0.shadow_selector;
+    if (state.lighting.enable) {
+        auto& lighting = state.lighting;
+        lighting.config = regs.lighting.config0.config;
+        lighting.src_num = regs.lighting.max_light_index + 1;
+
+        const bool spot_supported = LightingRegs::IsLightingSamplerSupported(
+            lighting.config, LightingRegs::LightingSampler::SpotlightAttenuation);
+        bool spot_used = false;
+
+        lighting.enable_shadow = regs.lighting.config0.enable_shadow != 0;
+        if (lighting.enable_shadow) {
+            lighting.shadow_primary = regs.lighting.config0.shadow_primary != 0;
+            lighting.shadow_secondary = regs.lighting.config0.shadow_secondary != 0;
+            lighting.shadow_invert = regs.lighting.config0.shadow_invert != 0;
+            lighting.shadow_alpha = regs.lighting.config0.shadow_alpha != 0;
+            lighting.shadow_selector = regs.lighting.config0.shadow_selector;
+        }
+        const bool light_shadow_used = lighting.shadow_primary || lighting.shadow_secondary;
+
+        for (unsigned light_index = 0; light_index < lighting.src_num; ++light_index) {
+            unsigned num = regs.lighting.light_enable.GetNum(light_index);
+            const auto& light = regs.lighting.light[num];
+            auto& light_config = lighting.light[light_index];
+            light_config.num = num;
+            light_config.directional = light.config.directional != 0;
+            light_config.two_sided_diffuse = light.config.two_sided_diffuse != 0;
+            light_config.geometric_factor_0 = light.config.geometric_factor_0 != 0;
+            light_config.geometric_factor_1 = light.config.geometric_factor_1 != 0;
+            light_config.dist_atten_enable = !regs.lighting.IsDistAttenDisabled(num);
+            light_config.spot_atten_enable =
+                spot_supported && !regs.lighting.IsSpotAttenDisabled(num);
+            light_config.shadow_enable =
+                light_shadow_used && !regs.lighting.IsShadowDisabled(num);
+            spot_used |= light_config.spot_atten_enable;
+        }
+
+        lighting.enable_primary_alpha = regs.lighting.config0.enable_primary_alpha;
+        lighting.enable_secondary_alpha = regs.lighting.config0.enable_secondary_alpha;
+
+        // LUTs are only set when they are sampled by the lighting configuration
+        const auto set_lut = [&lighting](auto& lut, LightingRegs::LightingSampler sampler,
+                                         bool enable, u32 disable_abs,
+                                         LightingRegs::LightingLutInput type, float scale) {
+            if (!enable || !LightingRegs::IsLightingSamplerSupported(lighting.config, sampler))
+                return;
+            lut.enable = true;
+            lut.abs_input = disable_abs == 0;
+            lut.type = type;
+            lut.scale = scale;
+        };
+        const auto& config1 = regs.lighting.config1;
+        const auto& abs_input = regs.lighting.abs_lut_input;
+        const auto& input = regs.lighting.lut_input;
+        const auto& scale = regs.lighting.lut_scale;
+
+        set_lut(lighting.lut_d0, LightingRegs::LightingSampler::Distribution0,
+                config1.disable_lut_d0 == 0, abs_input.disable_d0, input.d0,
+                scale.GetScale(scale.d0));
+        set_lut(lighting.lut_d1, LightingRegs::LightingSampler::Distribution1,
+                config1.disable_lut_d1 == 0, abs_input.disable_d1, input.d1,
+                scale.GetScale(scale.d1));
+        // There is no register to disable the spotlight LUT, only the attenuation of each light
+        set_lut(lighting.lut_sp, LightingRegs::LightingSampler::SpotlightAttenuation, spot_used,
+                abs_input.disable_sp, input.sp, scale.GetScale(scale.sp));
+        // The Fresnel factor only goes to the alpha components
+        set_lut(lighting.lut_fr, LightingRegs::LightingSampler::Fresnel,
+                config1.disable_lut_fr == 0 &&
+                    (lighting.enable_primary_alpha || lighting.enable_secondary_alpha),
+                abs_input.disable_fr, input.fr, scale.GetScale(scale.fr));
+        set_lut(lighting.lut_rr, LightingRegs::LightingSampler::ReflectRed,
+                config1.disable_lut_rr == 0, abs_input.disable_rr, input.rr,
+                scale.GetScale(scale.rr));
+        set_lut(lighting.lut_rg, LightingRegs::LightingSampler::ReflectGreen,
+                config1.disable_lut_rg == 0, abs_input.disable_rg, input.rg,
+                scale.GetScale(scale.rg));
+        set_lut(lighting.lut_rb, LightingRegs::LightingSampler::ReflectBlue,
+                config1.disable_lut_rb == 0, abs_input.disable_rb, input.rb,
+                scale.GetScale(scale.rb));
+
+        lighting.bump_mode = regs.lighting.config0.bump_mode;
+        if (lighting.bump_mode != LightingRegs::LightingBumpMode::None) {
+            lighting.bump_selector = regs.lighting.config0.bump_selector;
+        }
+        if (lighting.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
+            lighting.bump_renorm = regs.lighting.config0.disable_bump_renorm == 0;
+        }
+        lighting.clamp_highlights = regs.lighting.config0.clamp_highlights != 0;
+    }
 
     state.proctex.enable = regs.texturing.main_config.texture3_enable;
     if (state.proctex.enable) {
@@ -239,8 +326,13 @@ PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     state.shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
                              FramebufferRegs::FragmentOperationMode::Shadow;
 
-    state.shadow_texture_orthographic = regs.texturing.shadow.orthographic != 0;
-    state.shadow_texture_bias = regs.texturing.shadow.bias << 1;
+    if (state.texture0_type == TexturingRegs::TextureConfig::Shadow2D) {
+        state.shadow_texture_orthographic = regs.texturing.shadow.orthographic != 0;
+    }
+    if (state.texture0_type == TexturingRegs::TextureConfig::Shadow2D ||
+        state.texture0_type == TexturingRegs::TextureConfig::ShadowCube) {
+        state.shadow_texture_bias = regs.texturing.shadow.bias << 1;
+    }
 
     return res;
 }
@@ -249,7 +341,7 @@ void PicaShaderConfigCommon::Init(const Pica::ShaderRegs& regs, Pica::Shader::Sh
     program_hash = setup.GetProgramCodeHash();
     swizzle_hash = setup.GetSwizzleDataHash();
     main_offset = regs.main_offset;
-    sanitize_mul = VideoCore::g_hw_shader_accurate_mul;
+    sanitize_mul = Settings::GetSnapshot().shaders_accurate_mul;
 
     num_outputs = 0;
     output_map.fill(16);
@@ -1246,9 +1338,8 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 }
 
-std::string GenerateFragmentShader(const PicaFSConfig& config, bool separable_shader) {
-    const auto& state = config.state;
-
+/// Writes the declarations shared by the generated fragment shaders and the ubershader
+static std::string GetFragmentShaderHeader(bool separable_shader) {
     std::string out = R"(
 #version 330 core
 #extension GL_ARB_shader_image_load_store : enable
@@ -1286,6 +1377,13 @@ layout(r32ui) uniform uimage2D shadow_buffer;
 )";
 
     out += UniformBlockDef;
+    return out;
+}
+
+std::string GenerateFragmentShader(const PicaFSConfig& config, bool separable_shader) {
+    const auto& state = config.state;
+
+    std::string out = GetFragmentShaderHeader(separable_shader);
 
     out += R"(
 // Rotate the vector v by the quaternion q
@@ -1557,6 +1655,18 @@ vec4 secondary_fragment_color = vec4(0.0);
 #if ALLOW_SHADOW
 uint d = uint(clamp(depth, 0.0, 1.0) * 0xFFFFFF);
 uint s = uint(last_tex_env_out.g * 0xFF);
+)";
+        if (state.shadow_depth_buffer) {
+            // Without a penumbra the fragment only lowers the depth, which the depth test does
+            // without atomics. The rasterizer merges the depth attachment into the buffer later.
+            out += R"(
+if (s == 0u) {
+    gl_FragDepth = float(d) / 16777215.0;
+    return;
+}
+)";
+        }
+        out += R"(
 ivec2 image_coord = ivec2(gl_FragCoord.xy);
 
 uint old = imageLoad(shadow_buffer, image_coord).x;
@@ -1577,6 +1687,12 @@ do {
     new = EncodeShadow(ref);
 
 } while ((old = imageAtomicCompSwap(shadow_buffer, image_coord, old, new)) != old2);
+)";
+        if (state.shadow_depth_buffer) {
+            out += "discard;
+";
+        }
+        out += R"(
 #endif // ALLOW_SHADOW
 )";
     } else {
@@ -1590,6 +1706,277 @@ do {
     return out;
 }
 
+bool IsFragmentUbershaderCompatible(const PicaFSConfig& config) {
+    const auto& state = config.state;
+    return !state.lighting.enable && !state.proctex.enable && !state.shadow_rendering &&
+           state.fog_mode != TexturingRegs::FogMode::Gas &&
+           state.texture0_type != TexturingRegs::TextureConfig::Shadow2D &&
+           state.texture0_type != TexturingRegs::TextureConfig::ShadowCube;
+}
+
+PicaFSUbershaderUniforms PicaFSUbershaderUniforms::Build(const PicaFSConfig& config) {
+    const auto& state = config.state;
+    PicaFSUbershaderUniforms res{};
+    for (std::size_t i = 0; i < state.tev_stages.size(); ++i) {
+        const auto& stage = state.tev_stages[i];
+        res.tev_stages[i] = {stage.sources_raw, stage.modifiers_raw, stage.ops_raw,
+                             stage.scales_raw};
+    }
+    res.config[0] = static_cast<u32>(state.alpha_test_func) |
+                    static_cast<u32>(state.scissor_test_mode) << 4 |
+                    static_cast<u32>(state.texture0_type) << 8 |
+                    static_cast<u32>(state.texture2_use_coord1) << 12 |
+                    static_cast<u32>(state.depthmap_enable) << 13 |
+                    static_cast<u32>(state.fog_mode) << 16 | static_cast<u32>(state.fog_flip) << 20;
+    res.config[1] = state.combiner_buffer_input;
+    return res;
+}
+
+std::string GenerateFragmentUbershader(bool separable_shader) {
+    std::string out = GetFragmentShaderHeader(separable_shader);
+
+    // The layout of the configuration is the one of PicaFSUbershaderUniforms, the switches follow
+    // the values of the PICA enums as the code generated by WriteTevStage does
+    out += R"(
+uniform uvec4 tev_stages[NUM_TEV_STAGES];
+uniform uvec4 fs_config;
+
+float byteround(float x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+vec3 byteround(vec3 x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+vec4 byteround(vec4 x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+uint Field(uint value, int offset, int bits) {
+    return (value >> uint(offset)) & ((1u << uint(bits)) - 1u);
+}
+
+vec4 rounded_primary_color;
+vec4 texture_color[3];
+vec4 combiner_buffer;
+vec4 last_tex_env_out;
+
+vec4 GetSource(uint source, int stage) {
+    switch (source) {
+    case 0u: return rounded_primary_color;
+    case 3u: return texture_color[0];
+    case 4u: return texture_color[1];
+    case 5u: return texture_color[2];
+    case 13u: return combiner_buffer;
+    case 14u: return const_color[stage];
+    case 15u: return last_tex_env_out;
+    // Fragment colors only come from lighting, and texture 3 from procedural textures
+    default: return vec4(0.0);
+    }
+}
+
+vec3 GetColorModifier(uint modifier, vec4 value) {
+    switch (modifier) {
+    case 0u: return value.rgb;
+    case 1u: return vec3(1.0) - value.rgb;
+    case 2u: return value.aaa;
+    case 3u: return vec3(1.0) - value.aaa;
+    case 4u: return value.rrr;
+    case 5u: return vec3(1.0) - value.rrr;
+    case 8u: return value.ggg;
+    case 9u: return vec3(1.0) - value.ggg;
+    case 12u: return value.bbb;
+    case 13u: return vec3(1.0) - value.bbb;
+    default: return vec3(0.0);
+    }
+}
+
+float GetAlphaModifier(uint modifier, vec4 value) {
+    switch (modifier) {
+    case 0u: return value.a;
+    case 1u: return 1.0 - value.a;
+    case 2u: return value.r;
+    case 3u: return 1.0 - value.r;
+    case 4u: return value.g;
+    case 5u: return 1.0 - value.g;
+    case 6u: return value.b;
+    case 7u: return 1.0 - value.b;
+    default: return 0.0;
+    }
+}
+
+vec3 CombineColor(uint operation, vec3 a0, vec3 a1, vec3 a2) {
+    vec3 result;
+    switch (operation) {
+    case 0u: result = a0; break;
+    case 1u: result = a0 * a1; break;
+    case 2u: result = a0 + a1; break;
+    case 3u: result = a0 + a1 - vec3(0.5); break;
+    case 4u: result = a0 * a2 + a1 * (vec3(1.0) - a2); break;
+    case 5u: result = a0 - a1; break;
+    case 6u:
+    case 7u: result = vec3(dot(a0 - vec3(0.5), a1 - vec3(0.5)) * 4.0); break;
+    case 8u: result = a0 * a1 + a2; break;
+    case 9u: result = min(a0 + a1, vec3(1.0)) * a2; break;
+    default: result = vec3(0.0); break;
+    }
+    return clamp(result, vec3(0.0), vec3(1.0));
+}
+
+float CombineAlpha(uint operation, float a0, float a1, float a2) {
+    float result;
+    switch (operation) {
+    case 0u: result = a0; break;
+    case 1u: result = a0 * a1; break;
+    case 2u: result = a0 + a1; break;
+    case 3u: result = a0 + a1 - 0.5; break;
+    case 4u: result = a0 * a2 + a1 * (1.0 - a2); break;
+    case 5u: result = a0 - a1; break;
+    case 8u: result = a0 * a1 + a2; break;
+    case 9u: result = min(a0 + a1, 1.0) * a2; break;
+    default: result = 0.0; break;
+    }
+    return clamp(result, 0.0, 1.0);
+}
+
+float GetMultiplier(uint scale) {
+    return scale < 3u ? float(1u << scale) : 1.0;
+}
+
+void WriteTevStage(int stage) {
+    uvec4 config = tev_stages[stage];
+    uint color_op = Field(config.z, 0, 4);
+    uint alpha_op = Field(config.z, 16, 4);
+    uint color_scale = Field(config.w, 0, 2);
+    uint alpha_scale = Field(config.w, 16, 2);
+
+    // Matches IsPassThroughTevStage
+    bool pass_through = color_op == 0u && alpha_op == 0u && Field(config.x, 0, 4) == 15u &&
+                        Field(config.x, 16, 4) == 15u && Field(config.y, 0, 4) == 0u &&
+                        Field(config.y, 12, 3) == 0u && GetMultiplier(color_scale) == 1.0 &&
+                        GetMultiplier(alpha_scale) == 1.0;
+    if (pass_through) {
+        return;
+    }
+
+    vec3 color_results[3];
+    for (int i = 0; i < 3; ++i) {
+        color_results[i] = GetColorModifier(Field(config.y, 4 * i, 4),
+                                            GetSource(Field(config.x, 4 * i, 4), stage));
+    }
+    vec3 color_output =
+        byteround(CombineColor(color_op, color_results[0], color_results[1], color_results[2]));
+
+    float alpha_output;
+    if (color_op == 7u) {
+        // Dot3_RGBA also places its result in the alpha component
+        alpha_output = color_output[0];
+    } else {
+        float alpha_results[3];
+        for (int i = 0; i < 3; ++i) {
+            alpha_results[i] = GetAlphaModifier(Field(config.y, 12 + 4 * i, 3),
+                                                GetSource(Field(config.x, 16 + 4 * i, 4), stage));
+        }
+        alpha_output = byteround(
+            CombineAlpha(alpha_op, alpha_results[0], alpha_results[1], alpha_results[2]));
+    }
+
+    last_tex_env_out =
+        vec4(clamp(color_output * GetMultiplier(color_scale), vec3(0.0), vec3(1.0)),
+             clamp(alpha_output * GetMultiplier(alpha_scale), 0.0, 1.0));
+}
+
+bool FailsAlphaTest(uint func) {
+    int alpha = int(last_tex_env_out.a * 255.0);
+    switch (func) {
+    case 0u: return true;
+    case 2u: return alpha != alphatest_ref;
+    case 3u: return alpha == alphatest_ref;
+    case 4u: return alpha >= alphatest_ref;
+    case 5u: return alpha > alphatest_ref;
+    case 6u: return alpha <= alphatest_ref;
+    case 7u: return alpha < alphatest_ref;
+    default: return false;
+    }
+}
+
+void main() {
+    uint alpha_test_func = Field(fs_config.x, 0, 3);
+    uint scissor_mode = Field(fs_config.x, 4, 2);
+    uint texture0_type = Field(fs_config.x, 8, 3);
+    bool texture2_use_coord1 = Field(fs_config.x, 12, 1) != 0u;
+    bool w_buffering = Field(fs_config.x, 13, 1) == 0u;
+    uint fog_mode = Field(fs_config.x, 16, 3);
+    bool fog_flip = Field(fs_config.x, 20, 1) != 0u;
+
+    if (alpha_test_func == 0u) {
+        discard;
+    }
+
+    if (scissor_mode != 0u) {
+        bool inside = gl_FragCoord.x >= scissor_x1 && gl_FragCoord.y >= scissor_y1 &&
+                      gl_FragCoord.x < scissor_x2 && gl_FragCoord.y < scissor_y2;
+        // Include keeps only the pixels inside the scissor box
+        if (inside != (scissor_mode == 3u)) {
+            discard;
+        }
+    }
+
+    float z_over_w = 2.0 * gl_FragCoord.z - 1.0;
+    float depth = z_over_w * depth_scale + depth_offset;
+    if (w_buffering) {
+        depth /= gl_FragCoord.w;
+    }
+
+    rounded_primary_color = byteround(primary_color);
+    switch (texture0_type) {
+    case 0u: texture_color[0] = texture(tex0, texcoord0); break;
+    case 1u: texture_color[0] = texture(tex_cube, vec3(texcoord0, texcoord0_w)); break;
+    case 3u: texture_color[0] = textureProj(tex0, vec3(texcoord0, texcoord0_w)); break;
+    default: texture_color[0] = vec4(0.0); break;
+    }
+    texture_color[1] = texture(tex1, texcoord1);
+    texture_color[2] = texture(tex2, texture2_use_coord1 ? texcoord1 : texcoord2);
+
+    combiner_buffer = vec4(0.0);
+    vec4 next_combiner_buffer = tev_combiner_buffer_color;
+    last_tex_env_out = vec4(0.0);
+    for (int stage = 0; stage < NUM_TEV_STAGES; ++stage) {
+        WriteTevStage(stage);
+
+        combiner_buffer = next_combiner_buffer;
+        if (stage < 4) {
+            if (Field(fs_config.y, stage, 1) != 0u) {
+                next_combiner_buffer.rgb = last_tex_env_out.rgb;
+            }
+            if (Field(fs_config.y, stage + 4, 1) != 0u) {
+                next_combiner_buffer.a = last_tex_env_out.a;
+            }
+        }
+    }
+
+    if (FailsAlphaTest(alpha_test_func)) {
+        discard;
+    }
+
+    if (fog_mode == 5u) {
+        float fog_index = (fog_flip ? 1.0 - depth : depth) * 128.0;
+        float fog_i = clamp(floor(fog_index), 0.0, 127.0);
+        float fog_f = fog_index - fog_i;
+        vec2 fog_lut_entry = texelFetch(texture_buffer_lut_rg, int(fog_i) + fog_lut_offset).rg;
+        float fog_factor = clamp(fog_lut_entry.r + fog_lut_entry.g * fog_f, 0.0, 1.0);
+        last_tex_env_out.rgb = mix(fog_color.rgb, last_tex_env_out.rgb, fog_factor);
+    }
+
+    gl_FragDepth = depth;
+    color = byteround(last_tex_env_out);
+}
+)";
+
+    return out;
+}
+
 std::string GenerateTrivialVertexShader(bool separable_shader) {
     std::string out = "#version 330 core\n";
     if (separable_shader) {
@@ -117,6 +117,8 @@ struct PicaFSConfigState {
     } proctex;
 
     bool shadow_rendering;
+    /// Set by the rasterizer when the shadow draw has a depth attachment, see ShadowDepthResolver
+    bool shadow_depth_buffer;
     bool shadow_texture_orthographic;
     u32 shadow_texture_bias;
 };
@@ -143,6 +145,27 @@ struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
     }
 };
 
+/**
+ * Values of the uniforms that configure the fragment ubershader for a PicaFSConfig, the ubershader
+ * interprets them at runtime instead of having a program generated for each configuration.
+ */
+struct PicaFSUbershaderUniforms {
+    static PicaFSUbershaderUniforms Build(const PicaFSConfig& config);
+
+    bool operator==(const PicaFSUbershaderUniforms& other) const {
+        return tev_stages == other.tev_stages && config == other.config;
+    }
+
+    bool operator!=(const PicaFSUbershaderUniforms& other) const {
+        return !(*this == other);
+    }
+
+    /// Raw sources, modifiers, operations and scales of each TEV stage
+    std::array<std::array<u32, 4>, 6> tev_stages;
+    /// The other fixed function state and the combiner buffer update masks
+    std::array<u32, 4> config;
+};
+
 /**
  * This struct contains common information to identify a GL vertex/geometry shader generated from
  * PICA vertex/geometry shader.
@@ -166,6 +189,7 @@ struct PicaShaderConfigCommon {
  * shader.
  */
 struct PicaVSConfig : Common::HashableStruct<PicaShaderConfigCommon> {
+    PicaVSConfig() = default;
     explicit PicaVSConfig(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup) {
         state.Init(regs.vs, setup);
     }
@@ -191,6 +215,7 @@ struct PicaGSConfigCommonRaw {
  * shader pipeline
  */
 struct PicaFixedGSConfig : Common::HashableStruct<PicaGSConfigCommonRaw> {
+    PicaFixedGSConfig() = default;
     explicit PicaFixedGSConfig(const Pica::Regs& regs) {
         state.Init(regs);
     }
@@ -211,6 +236,7 @@ struct PicaGSConfigRaw : PicaShaderConfigCommon, PicaGSConfigCommonRaw {
  * shader.
  */
 struct PicaGSConfig : Common::HashableStruct<PicaGSConfigRaw> {
+    PicaGSConfig() = default;
     explicit PicaGSConfig(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setups) {
         state.Init(regs, setups);
     }
@@ -255,6 +281,21 @@ std::optional<std::string> GenerateGeometryShader(const Pica::Shader::ShaderSetu
  */
 std::string GenerateFragmentShader(const PicaFSConfig& config, bool separable_shader);
 
+/**
+ * Whether the fragment ubershader can emulate the given configuration. It leaves out fragment
+ * lighting, procedural textures, shadows and gas.
+ */
+bool IsFragmentUbershaderCompatible(const PicaFSConfig& config);
+
+/**
+ * Generates the GLSL fragment ubershader, which emulates any configuration accepted by
+ * IsFragmentUbershaderCompatible through the uniforms of PicaFSUbershaderUniforms. It is slower
+ * than a generated program, but only has to be compiled once.
+ * @param separable_shader generates shader that can be used for separate shader object
+ * @returns String of the shader source code
+ */
+std::string GenerateFragmentUbershader(bool separable_shader);
+
 } // namespace OpenGL
 
 namespace std {
@@ -3,13 +3,24 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
+#include <optional>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/frame_counters.h"
+#include "common/logging/log.h"
+#include "common/memory_usage.h"
+#include "core/core.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 
 namespace OpenGL {
 
+static const Common::FrameCounter fs_hit_counter("OpenGL/Fragment Shader Cache Hits");
+static const Common::FrameCounter fs_miss_counter("OpenGL/Fragment Shader Cache Misses");
+
 static void SetShaderUniformBlockBinding(GLuint shader, const char* name, UniformBindings binding,
                                          std::size_t expected_size) {
     const GLuint ub_index = glGetUniformBlockIndex(shader, name);
@@ -114,6 +125,85 @@ public:
         }
     }
 
+    /// Restores a separable program from a binary previously retrieved with glGetProgramBinary
+    bool CreateFromBinary(GLenum binary_format, const std::vector<u8>& binary) {
+        if (shader_or_program.which() == 0) {
+            return false;
+        }
+        OGLProgram& program = boost::get<OGLProgram>(shader_or_program);
+        program.handle = glCreateProgram();
+        glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        glProgramBinary(program.handle, binary_format, binary.data(),
+                        static_cast<GLsizei>(binary.size()));
+
+        GLint link_status = GL_FALSE;
+        glGetProgramiv(program.handle, GL_LINK_STATUS, &link_status);
+        if (link_status != GL_TRUE) {
+            // The driver rejected the binary, usually because it has been updated
+            program.Release();
+            return false;
+        }
+
+        // Uniform block and sampler bindings are not part of the program binary
+        SetShaderUniformBlockBindings(program.handle);
+        SetShaderSamplerBindings(program.handle);
+        return true;
+    }
+
+    /**
+     * Starts building a separable program without waiting for the driver to finish compiling and
+     * linking it. Requires ARB/KHR_parallel_shader_compile, IsReady must be used before the
+     * program can be bound.
+     */
+    void CreateAsync(const char* source, GLenum type) {
+        ASSERT(shader_or_program.which() == 1);
+        OGLShader shader;
+        shader.handle = glCreateShader(type);
+        glShaderSource(shader.handle, 1, &source, nullptr);
+        glCompileShader(shader.handle);
+        Core::System::GetInstance().perf_stats.AddShaderCompile();
+
+        OGLProgram& program = boost::get<OGLProgram>(shader_or_program);
+        program.handle = glCreateProgram();
+        glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        if (GLAD_GL_ARB_get_program_binary) {
+            glProgramParameteri(program.handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(program.handle, shader.handle);
+        glLinkProgram(program.handle);
+        glDetachShader(program.handle, shader.handle);
+        pending = true;
+    }
+
+    /// Returns whether the program can be used, finishing its setup once the driver is done
+    bool IsReady() {
+        if (!pending) {
+            return true;
+        }
+
+        const GLuint handle = boost::get<OGLProgram>(shader_or_program).handle;
+        GLint completed = GL_FALSE;
+        glGetProgramiv(handle, GL_COMPLETION_STATUS_ARB, &completed);
+        if (completed != GL_TRUE) {
+            return false;
+        }
+        pending = false;
+
+        GLint link_status = GL_FALSE;
+        glGetProgramiv(handle, GL_LINK_STATUS, &link_status);
+        if (link_status != GL_TRUE) {
+            GLint info_log_length = 0;
+            glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &info_log_length);
+            std::vector<char> program_error(std::max(info_log_length, 1));
+            glGetProgramInfoLog(handle, info_log_length, nullptr, program_error.data());
+            LOG_ERROR(Render_OpenGL, "Error linking shader:\n{}", program_error.data());
+        }
+
+        SetShaderUniformBlockBindings(handle);
+        SetShaderSamplerBindings(handle);
+        return true;
+    }
+
     GLuint GetHandle() const {
         if (shader_or_program.which() == 0) {
             return boost::get<OGLShader>(shader_or_program).handle;
@@ -122,8 +212,26 @@ public:
         }
     }
 
+    /// Sets the hash identifying the shader in the usage profile
+    void SetUsageKey(u64 key) {
+        usage_key = key;
+    }
+
+    u64 GetUsageKey() const {
+        return usage_key;
+    }
+
+    /// Returns true the first time it is called
+    bool MarkUsed() {
+        return !std::exchange(used, true);
+    }
+
 private:
     boost::variant<OGLShader, OGLProgram> shader_or_program;
+    bool pending = false;
+    /// Zero while the shader isn't stored in the disk cache
+    u64 usage_key = 0;
+    bool used = false;
 };
 
 class TrivialVertexShader {
@@ -143,19 +251,60 @@ template <typename KeyConfigType, std::string (*CodeGenerator)(const KeyConfigTy
           GLenum ShaderType>
 class ShaderCache {
 public:
-    explicit ShaderCache(bool separable) : separable(separable) {}
-    GLuint Get(const KeyConfigType& config) {
+    ShaderCache(bool separable, bool async) : separable(separable), async(async) {}
+
+    /// Returns the shader stage, and the generated source code if it was newly built
+    std::pair<OGLShaderStage*, std::optional<std::string>> Get(const KeyConfigType& config) {
+        // Most lookups are for the shader of the previous one, comparing the keys is cheaper than
+        // hashing them
+        if (last_config && *last_config == config) {
+            return {last_shader, std::nullopt};
+        }
+
         auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
         OGLShaderStage& cached_shader = iter->second;
+        last_config = config;
+        last_shader = &cached_shader;
+        std::optional<std::string> result;
+        if (new_shader) {
+            result = CodeGenerator(config, separable);
+            memory_usage.Add(static_cast<s64>(result->size()));
+            if (async) {
+                cached_shader.CreateAsync(result->c_str(), ShaderType);
+            } else {
+                cached_shader.Create(result->c_str(), ShaderType);
+            }
+        }
+        return {&cached_shader, std::move(result)};
+    }
+
+    /**
+     * Reserves an entry for a shader loaded from the disk cache
+     * @param code_size size of the shader's source, which is accounted as its memory use
+     * @returns the cached stage, and whether it is new and still has to be built
+     */
+    std::pair<OGLShaderStage*, bool> Inject(const KeyConfigType& key, std::size_t code_size) {
+        auto [iter, new_shader] = shaders.emplace(key, OGLShaderStage{separable});
         if (new_shader) {
-            cached_shader.Create(CodeGenerator(config, separable).c_str(), ShaderType);
+            memory_usage.Add(static_cast<s64>(code_size));
         }
-        return cached_shader.GetHandle();
+        return {&iter->second, new_shader};
+    }
+
+    /// Number of shaders in the cache
+    std::size_t Size() const {
+        return shaders.size();
     }
 
 private:
     bool separable;
+    bool async;
+    // Node based, the stages are referred to by pointer until they are destroyed
     std::unordered_map<KeyConfigType, OGLShaderStage> shaders;
+    std::optional<KeyConfigType> last_config;
+    OGLShaderStage* last_shader = nullptr;
+    /// The driver's memory isn't known, the size of the sources stands in for it
+    Common::ScopedMemoryUsage memory_usage{Common::MemoryCategory::ShaderCache};
 };
 
 // This is a cache designed for shaders translated from PICA shaders. The first cache matches the
@@ -169,37 +318,74 @@ template <typename KeyConfigType,
           GLenum ShaderType>
 class ShaderDoubleCache {
 public:
-    explicit ShaderDoubleCache(bool separable) : separable(separable) {}
-    GLuint Get(const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
+    ShaderDoubleCache(bool separable, bool async) : separable(separable), async(async) {}
+
+    /// Returns the shader stage, and the generated source code if the key was seen for the first
+    /// time. The stage is nullptr if the PICA shader can't be translated.
+    std::pair<OGLShaderStage*, std::optional<std::string>> Get(
+        const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
+        if (last_key && *last_key == key) {
+            return {last_shader, std::nullopt};
+        }
+
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
             auto program_opt = CodeGenerator(setup, key, separable);
             if (!program_opt) {
                 shader_map[key] = nullptr;
-                return 0;
+                last_key = key;
+                last_shader = nullptr;
+                return {nullptr, std::nullopt};
             }
 
             std::string& program = *program_opt;
             auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
             OGLShaderStage& cached_shader = iter->second;
             if (new_shader) {
-                cached_shader.Create(program.c_str(), ShaderType);
+                memory_usage.Add(static_cast<s64>(program.size()));
+                if (async) {
+                    cached_shader.CreateAsync(program.c_str(), ShaderType);
+                } else {
+                    cached_shader.Create(program.c_str(), ShaderType);
+                }
             }
             shader_map[key] = &cached_shader;
-            return cached_shader.GetHandle();
+            last_key = key;
+            last_shader = &cached_shader;
+            return {&cached_shader, std::move(program_opt)};
         }
 
-        if (map_it->second == nullptr) {
-            return 0;
-        }
+        last_key = key;
+        last_shader = map_it->second;
+        return {map_it->second, std::nullopt};
+    }
 
-        return map_it->second->GetHandle();
+    /**
+     * Reserves an entry for a shader loaded from the disk cache
+     * @returns the cached stage, and whether it is new and still has to be built
+     */
+    std::pair<OGLShaderStage*, bool> Inject(const KeyConfigType& key, std::string program) {
+        auto [iter, new_shader] =
+            shader_cache.emplace(std::move(program), OGLShaderStage{separable});
+        if (new_shader) {
+            memory_usage.Add(static_cast<s64>(iter->first.size()));
+        }
+        shader_map[key] = &iter->second;
+        last_key.reset();
+        return {&iter->second, new_shader};
     }
 
 private:
     bool separable;
+    bool async;
     std::unordered_map<KeyConfigType, OGLShaderStage*> shader_map;
+    // Node based, the stages are referred to by pointer until they are destroyed
     std::unordered_map<std::string, OGLShaderStage> shader_cache;
+    /// Key of the previous lookup and its stage, which can be nullptr
+    std::optional<KeyConfigType> last_key;
+    OGLShaderStage* last_shader = nullptr;
+    /// The generated sources are kept as the keys of shader_cache
+    Common::ScopedMemoryUsage memory_usage{Common::MemoryCategory::ShaderCache};
 };
 
 using ProgrammableVertexShaders =
@@ -213,14 +399,39 @@ using FixedGeometryShaders =
 
 using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FRAGMENT_SHADER>;
 
+template <typename KeyConfigType>
+static std::vector<u8> SerializeKey(const KeyConfigType& key) {
+    std::vector<u8> data(sizeof(key.state));
+    std::memcpy(data.data(), &key.state, sizeof(key.state));
+    return data;
+}
+
+template <typename KeyConfigType>
+static std::optional<KeyConfigType> DeserializeKey(const std::vector<u8>& data) {
+    KeyConfigType key;
+    if (data.size() != sizeof(key.state)) {
+        return std::nullopt;
+    }
+    std::memcpy(&key.state, data.data(), sizeof(key.state));
+    return key;
+}
+
 class ShaderProgramManager::Impl {
 public:
-    explicit Impl(bool separable, bool is_amd)
-        : is_amd(is_amd), separable(separable), programmable_vertex_shaders(separable),
-          trivial_vertex_shader(separable), programmable_geometry_shaders(separable),
-          fixed_geometry_shaders(separable), fragment_shaders(separable) {
+    explicit Impl(bool separable, bool is_amd, bool async)
+        : is_amd(is_amd), programmable_vertex_shaders(separable, async),
+          trivial_vertex_shader(separable), programmable_geometry_shaders(separable, async),
+          fixed_geometry_shaders(separable, async), fragment_shaders(separable, async),
+          separable(separable), async(async) {
         if (separable)
             pipeline.Create();
+
+        // Compiled right away, so that it is ready by the time the first shaders are missing
+        if (async && Settings::GetSnapshot().use_fragment_ubershader) {
+            fragment_ubershader.emplace(separable);
+            fragment_ubershader->CreateAsync(GenerateFragmentUbershader(separable).c_str(),
+                                             GL_FRAGMENT_SHADER);
+        }
     }
 
     struct ShaderTuple {
@@ -250,6 +461,9 @@ public:
     bool is_amd;
 
     ShaderTuple current;
+    /// Shaders set by the last ApplyTo, and the program linked from them when not separable
+    std::optional<ShaderTuple> applied;
+    GLuint applied_program = 0;
 
     ProgrammableVertexShaders programmable_vertex_shaders;
     TrivialVertexShader trivial_vertex_shader;
@@ -258,23 +472,245 @@ public:
     FixedGeometryShaders fixed_geometry_shaders;
 
     FragmentShaders fragment_shaders;
+    /// Fragment shader lookups of the session, and how many found an existing shader
+    u64 fs_lookups = 0;
+    u64 fs_hits = 0;
+
+    /// Stands in for fragment shaders that are still being compiled, only used in async mode
+    std::optional<OGLShaderStage> fragment_ubershader;
+    /// Uniform values last set on the ubershader
+    std::optional<PicaFSUbershaderUniforms> fragment_ubershader_uniforms;
+    bool fragment_ubershader_active = false;
 
     bool separable;
+    bool async;
     std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
     OGLPipeline pipeline;
+
+    std::unique_ptr<ShaderDiskCache> disk_cache;
+    std::unique_ptr<ShaderUsageProfile> usage_profile;
+    /// Number of frames presented in this session
+    u32 frame = 0;
+
+    /// Shaders still being compiled asynchronously that are waiting to be stored on disk
+    std::vector<std::pair<ShaderDiskCacheEntry, OGLShaderStage*>> pending_saves;
+
+    /**
+     * Writes a newly generated shader to the disk cache, along with its binary when possible. If
+     * the shader is still being compiled, this is deferred until it finishes.
+     */
+    void SaveToDiskCache(ProgramType type, std::vector<u8> key, std::string code,
+                         OGLShaderStage* stage) {
+        if (!disk_cache || stage == nullptr) {
+            return;
+        }
+
+        stage->SetUsageKey(ShaderUsageProfile::GetKeyHash(type, key));
+        ShaderDiskCacheEntry entry{type, std::move(key), std::move(code)};
+        if (!stage->IsReady()) {
+            pending_saves.emplace_back(std::move(entry), stage);
+            return;
+        }
+        SaveToDiskCache(std::move(entry), stage->GetHandle());
+    }
+
+    void SaveToDiskCache(ShaderDiskCacheEntry entry, GLuint handle) {
+        if (separable && GLAD_GL_ARB_get_program_binary) {
+            GLint binary_length = 0;
+            glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+            if (binary_length > 0) {
+                entry.binary.resize(binary_length);
+                glGetProgramBinary(handle, binary_length, nullptr, &entry.binary_format,
+                                   entry.binary.data());
+            }
+        }
+        disk_cache->Save(entry);
+    }
+
+    /// Records the first use of a shader in this session in the usage profile
+    void RecordUse(OGLShaderStage& stage) {
+        if (stage.MarkUsed() && usage_profile && stage.GetUsageKey() != 0) {
+            usage_profile->RecordUse(stage.GetUsageKey(), frame);
+        }
+    }
+
+    void ProcessPendingSaves() {
+        auto it = std::remove_if(pending_saves.begin(), pending_saves.end(), [this](auto& pending) {
+            if (!pending.second->IsReady()) {
+                return false;
+            }
+            SaveToDiskCache(std::move(pending.first), pending.second->GetHandle());
+            return true;
+        });
+        pending_saves.erase(it, pending_saves.end());
+    }
+
+    /// Binds the ubershader configured for the given configuration, if it can emulate it
+    bool UseFragmentUbershader(const PicaFSConfig& config) {
+        if (!fragment_ubershader || !IsFragmentUbershaderCompatible(config) ||
+            !fragment_ubershader->IsReady()) {
+            return false;
+        }
+
+        const GLuint handle = fragment_ubershader->GetHandle();
+        const auto uniforms = PicaFSUbershaderUniforms::Build(config);
+        if (fragment_ubershader_uniforms != uniforms) {
+            glProgramUniform4uiv(handle, glGetUniformLocation(handle, "tev_stages"),
+                                 static_cast<GLsizei>(uniforms.tev_stages.size()),
+                                 uniforms.tev_stages[0].data());
+            glProgramUniform4uiv(handle, glGetUniformLocation(handle, "fs_config"), 1,
+                                 uniforms.config.data());
+            fragment_ubershader_uniforms = uniforms;
+        }
+        current.fs = handle;
+        return true;
+    }
+
+    /**
+     * Builds a shader stage loaded from the disk cache, preferring the stored program binary. In
+     * async mode, shaders without a usable binary are queued on the driver's compiler threads,
+     * which work through them in the order they were submitted.
+     * @returns false if the binary had to be discarded and the stage was compiled from source
+     */
+    bool BuildFromDiskCache(OGLShaderStage& stage, const ShaderDiskCacheEntry& entry,
+                            GLenum shader_type) {
+        if (!entry.binary.empty() && separable && GLAD_GL_ARB_get_program_binary &&
+            stage.CreateFromBinary(entry.binary_format, entry.binary)) {
+            return true;
+        }
+        if (async) {
+            stage.CreateAsync(entry.code.c_str(), shader_type);
+        } else {
+            stage.Create(entry.code.c_str(), shader_type);
+        }
+        return entry.binary.empty();
+    }
 };
 
-ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
-    : impl(std::make_unique<Impl>(separable, is_amd)) {}
+ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd, bool async)
+    : impl(std::make_unique<Impl>(separable, is_amd, async)) {}
+
+ShaderProgramManager::~ShaderProgramManager() {
+    if (impl->fs_lookups != 0) {
+        LOG_INFO(Render_OpenGL, "{} unique fragment shaders, {:.1f}% of {} lookups were hits",
+                 impl->fragment_shaders.Size(),
+                 100.0 * static_cast<double>(impl->fs_hits) / impl->fs_lookups, impl->fs_lookups);
+    }
+    if (impl->usage_profile) {
+        impl->usage_profile->Save();
+    }
+}
+
+void ShaderProgramManager::LoadDiskCache(u64 title_id) {
+    if (!Settings::GetSnapshot().use_disk_shader_cache) {
+        return;
+    }
 
-ShaderProgramManager::~ShaderProgramManager() = default;
+    impl->disk_cache = std::make_unique<ShaderDiskCache>(title_id, impl->separable);
+    std::vector<ShaderDiskCacheEntry> entries = impl->disk_cache->Load();
+    impl->usage_profile = std::make_unique<ShaderUsageProfile>(title_id);
+    impl->usage_profile->Load();
+
+    // The shaders needed soonest in the previous sessions are built first, the ones that were
+    // never used keep the order they were created in
+    std::vector<u64> usage_keys(entries.size());
+    std::vector<u32> first_uses(entries.size());
+    std::vector<std::size_t> build_order(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        usage_keys[i] = ShaderUsageProfile::GetKeyHash(entries[i].type, entries[i].key);
+        first_uses[i] = impl->usage_profile->GetFirstUse(usage_keys[i]);
+        build_order[i] = i;
+    }
+    std::stable_sort(build_order.begin(), build_order.end(),
+                     [&first_uses](std::size_t a, std::size_t b) {
+                         return first_uses[a] < first_uses[b];
+                     });
+
+    bool binaries_outdated = false;
+    std::size_t num_built = 0;
+    std::vector<OGLShaderStage*> stages(entries.size());
+    for (const std::size_t i : build_order) {
+        const ShaderDiskCacheEntry& entry = entries[i];
+        std::pair<OGLShaderStage*, bool> stage{nullptr, false};
+        GLenum shader_type = GL_NONE;
+        switch (entry.type) {
+        case ProgramType::VS:
+            if (auto key = DeserializeKey<PicaVSConfig>(entry.key)) {
+                stage = impl->programmable_vertex_shaders.Inject(*key, entry.code);
+                shader_type = GL_VERTEX_SHADER;
+            }
+            break;
+        case ProgramType::FixedGS:
+            if (auto key = DeserializeKey<PicaFixedGSConfig>(entry.key)) {
+                stage = impl->fixed_geometry_shaders.Inject(*key, entry.code.size());
+                shader_type = GL_GEOMETRY_SHADER;
+            }
+            break;
+        case ProgramType::GS:
+            if (auto key = DeserializeKey<PicaGSConfig>(entry.key)) {
+                stage = impl->programmable_geometry_shaders.Inject(*key, entry.code);
+                shader_type = GL_GEOMETRY_SHADER;
+            }
+            break;
+        case ProgramType::FS:
+            if (auto key = DeserializeKey<PicaFSConfig>(entry.key)) {
+                stage = impl->fragment_shaders.Inject(*key, entry.code.size());
+                shader_type = GL_FRAGMENT_SHADER;
+            }
+            break;
+        default:
+            LOG_ERROR(Render_OpenGL, "Unknown shader disk cache entry type {}",
+                      static_cast<u32>(entry.type));
+            break;
+        }
+
+        auto [cached_stage, new_stage] = stage;
+        if (cached_stage == nullptr) {
+            continue;
+        }
+        if (new_stage) {
+            if (!impl->BuildFromDiskCache(*cached_stage, entry, shader_type)) {
+                binaries_outdated = true;
+            }
+            cached_stage->SetUsageKey(usage_keys[i]);
+            ++num_built;
+        }
+        stages[i] = cached_stage;
+    }
+
+    LOG_INFO(Render_OpenGL, "Built {} shaders from the disk cache", num_built);
+
+    if (binaries_outdated) {
+        // Store the binaries produced by the current driver so the next boot can use them again
+        LOG_INFO(Render_OpenGL, "Driver rejected cached program binaries, rebuilding disk cache");
+        impl->disk_cache->Recreate();
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (stages[i] == nullptr) {
+                continue;
+            }
+            entries[i].binary.clear();
+            if (stages[i]->IsReady()) {
+                impl->SaveToDiskCache(std::move(entries[i]), stages[i]->GetHandle());
+            } else {
+                impl->pending_saves.emplace_back(std::move(entries[i]), stages[i]);
+            }
+        }
+    }
+}
 
 bool ShaderProgramManager::UseProgrammableVertexShader(const PicaVSConfig& config,
-                                                       const Pica::Shader::ShaderSetup setup) {
-    GLuint handle = impl->programmable_vertex_shaders.Get(config, setup);
-    if (handle == 0)
+                                                       const Pica::Shader::ShaderSetup& setup) {
+    auto [stage, code] = impl->programmable_vertex_shaders.Get(config, setup);
+    if (code) {
+        impl->SaveToDiskCache(ProgramType::VS, SerializeKey(config), std::move(*code), stage);
+    }
+    // While the shader is compiling, the caller falls back to the software vertex pipeline
+    if (stage == nullptr)
         return false;
-    impl->current.vs = handle;
+    impl->RecordUse(*stage);
+    if (!stage->IsReady())
+        return false;
+    impl->current.vs = stage->GetHandle();
     return true;
 }
 
@@ -283,51 +719,104 @@ void ShaderProgramManager::UseTrivialVertexShader() {
 }
 
 bool ShaderProgramManager::UseProgrammableGeometryShader(const PicaGSConfig& config,
-                                                         const Pica::Shader::ShaderSetup setup) {
-    GLuint handle = impl->programmable_geometry_shaders.Get(config, setup);
-    if (handle == 0)
+                                                         const Pica::Shader::ShaderSetup& setup) {
+    auto [stage, code] = impl->programmable_geometry_shaders.Get(config, setup);
+    if (code) {
+        impl->SaveToDiskCache(ProgramType::GS, SerializeKey(config), std::move(*code), stage);
+    }
+    if (stage == nullptr)
         return false;
-    impl->current.gs = handle;
+    impl->RecordUse(*stage);
+    impl->RecordUse(*stage);
+    if (!stage->IsReady())
+        return false;
+    impl->current.gs = stage->GetHandle();
     return true;
 }
 
-void ShaderProgramManager::UseFixedGeometryShader(const PicaFixedGSConfig& config) {
-    impl->current.gs = impl->fixed_geometry_shaders.Get(config);
+bool ShaderProgramManager::UseFixedGeometryShader(const PicaFixedGSConfig& config) {
+    auto [stage, code] = impl->fixed_geometry_shaders.Get(config);
+    if (code) {
+        impl->SaveToDiskCache(ProgramType::FixedGS, SerializeKey(config), std::move(*code),
+                              stage);
+    }
+    if (!stage->IsReady())
+        return false;
+    impl->current.gs = stage->GetHandle();
+    return true;
 }
 
 void ShaderProgramManager::UseTrivialGeometryShader() {
     impl->current.gs = 0;
 }
 
-void ShaderProgramManager::UseFragmentShader(const PicaFSConfig& config) {
-    impl->current.fs = impl->fragment_shaders.Get(config);
+bool ShaderProgramManager::UseFragmentShader(const PicaFSConfig& config) {
+    auto [stage, code] = impl->fragment_shaders.Get(config);
+    ++impl->fs_lookups;
+    if (code) {
+        fs_miss_counter.Add();
+        impl->SaveToDiskCache(ProgramType::FS, SerializeKey(config), std::move(*code), stage);
+    } else {
+        fs_hit_counter.Add();
+        ++impl->fs_hits;
+    }
+    impl->RecordUse(*stage);
+    if (!stage->IsReady()) {
+        impl->fragment_ubershader_active = impl->UseFragmentUbershader(config);
+        return impl->fragment_ubershader_active;
+    }
+    impl->fragment_ubershader_active = false;
+    impl->current.fs = stage->GetHandle();
+    return true;
+}
+
+void ShaderProgramManager::NotifyFramePresented() {
+    ++impl->frame;
+}
+
+bool ShaderProgramManager::IsFragmentUbershaderActive() const {
+    return impl->fragment_ubershader_active;
 }
 
 void ShaderProgramManager::ApplyTo(OpenGLState& state) {
+    if (!impl->pending_saves.empty()) {
+        impl->ProcessPendingSaves();
+    }
+
+    // Consecutive draws mostly use the same shaders, which are then already in place
+    const bool changed = !impl->applied || *impl->applied != impl->current;
+    impl->applied = impl->current;
+
     if (impl->separable) {
-        if (impl->is_amd) {
-            // Without this reseting, AMD sometimes freezes when one stage is changed but not for
-            // the others.
-            // On the other hand, including this reset seems to introduce memory leak in Intel
-            // Graphics.
-            glUseProgramStages(
-                impl->pipeline.handle,
-                GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT, 0);
-        }
-
-        glUseProgramStages(impl->pipeline.handle, GL_VERTEX_SHADER_BIT, impl->current.vs);
-        glUseProgramStages(impl->pipeline.handle, GL_GEOMETRY_SHADER_BIT, impl->current.gs);
-        glUseProgramStages(impl->pipeline.handle, GL_FRAGMENT_SHADER_BIT, impl->current.fs);
+        if (changed) {
+            if (impl->is_amd) {
+                // Without this reseting, AMD sometimes freezes when one stage is changed but not
+                // for the others.
+                // On the other hand, including this reset seems to introduce memory leak in Intel
+                // Graphics.
+                glUseProgramStages(
+                    impl->pipeline.handle,
+                    GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT, 0);
+            }
+
+            glUseProgramStages(impl->pipeline.handle, GL_VERTEX_SHADER_BIT, impl->current.vs);
+            glUseProgramStages(impl->pipeline.handle, GL_GEOMETRY_SHADER_BIT, impl->current.gs);
+            glUseProgramStages(impl->pipeline.handle, GL_FRAGMENT_SHADER_BIT, impl->current.fs);
+        }
         state.draw.shader_program = 0;
         state.draw.program_pipeline = impl->pipeline.handle;
     } else {
-        OGLProgram& cached_program = impl->program_cache[impl->current];
-        if (cached_program.handle == 0) {
-            cached_program.Create(false, {impl->current.vs, impl->current.gs, impl->current.fs});
-            SetShaderUniformBlockBindings(cached_program.handle);
-            SetShaderSamplerBindings(cached_program.handle);
+        if (changed) {
+            OGLProgram& cached_program = impl->program_cache[impl->current];
+            if (cached_program.handle == 0) {
+                cached_program.Create(false,
+                                      {impl->current.vs, impl->current.gs, impl->current.fs});
+                SetShaderUniformBlockBindings(cached_program.handle);
+                SetShaderSamplerBindings(cached_program.handle);
+            }
+            impl->applied_program = cached_program.handle;
         }
-        state.draw.shader_program = cached_program.handle;
+        state.draw.shader_program = impl->applied_program;
     }
 }
 } // namespace OpenGL
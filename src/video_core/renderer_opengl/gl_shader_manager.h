@@ -99,25 +99,43 @@ static_assert(
 static_assert(sizeof(GSUniformData) < 16384,
               "GSUniformData structure must be less than 16kb as per the OpenGL spec");
 
-/// A class that manage different shader stages and configures them with given config data.
+/**
+ * A class that manage different shader stages and configures them with given config data.
+ * In async mode, new shaders are compiled by the driver in the background, and the Use* functions
+ * return false until the shader is ready. Fragment shaders can be replaced by the ubershader in
+ * the meantime.
+ */
 class ShaderProgramManager {
 public:
-    ShaderProgramManager(bool separable, bool is_amd);
+    ShaderProgramManager(bool separable, bool is_amd, bool async);
     ~ShaderProgramManager();
 
+    /**
+     * Opens the disk shader cache of the given title and builds all the shaders stored in it, in
+     * the order the title's usage profile says they will be needed
+     */
+    void LoadDiskCache(u64 title_id);
+
+    /// Advances the frame the shader uses are recorded at in the usage profile
+    void NotifyFramePresented();
+
     bool UseProgrammableVertexShader(const PicaVSConfig& config,
-                                     const Pica::Shader::ShaderSetup setup);
+                                     const Pica::Shader::ShaderSetup& setup);
 
     void UseTrivialVertexShader();
 
     bool UseProgrammableGeometryShader(const PicaGSConfig& config,
-                                       const Pica::Shader::ShaderSetup setup);
+                                       const Pica::Shader::ShaderSetup& setup);
 
-    void UseFixedGeometryShader(const PicaFixedGSConfig& config);
+    bool UseFixedGeometryShader(const PicaFixedGSConfig& config);
 
     void UseTrivialGeometryShader();
 
-    void UseFragmentShader(const PicaFSConfig& config);
+    bool UseFragmentShader(const PicaFSConfig& config);
+
+    /// Whether the last UseFragmentShader call used the ubershader, while the shader generated for
+    /// the configuration is being compiled
+    bool IsFragmentUbershaderActive() const;
 
     void ApplyTo(OpenGLState& state);
 
@@ -12,7 +12,8 @@ namespace OpenGL {
 /**
  * Utility function to create and compile an OpenGL GLSL shader
  * @param source String of the GLSL shader program
- * @param type Type of the shader (GL_VERTEX_SHADER, GL_GEOMETRY_SHADER or GL_FRAGMENT_SHADER)
+ * @param type Type of the shader (GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER or
+ *             GL_COMPUTE_SHADER)
  */
 GLuint LoadShader(const char* source, GLenum type);
 
@@ -0,0 +1,136 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "video_core/renderer_opengl/gl_shadow_resolver.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+namespace OpenGL {
+
+namespace {
+
+// Must match the local_size declaration of the shader below
+constexpr u32 RESOLVE_GROUP_SIZE = 8;
+
+// Shadow buffer texels hold the depth in their upper 24 bits and the stencil in the lower 8. The
+// depth is written as an exact fraction of 0xFFFFFF, so rounding it back gives the integer again.
+constexpr char resolve_source[] = R"(
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D shadow_depth;
+layout(r32ui) uniform uimage2D shadow_buffer;
+
+uniform ivec2 origin;
+uniform ivec2 size;
+
+void main() {
+    ivec2 offset = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(offset, size))) {
+        return;
+    }
+
+    ivec2 coord = origin + offset;
+    uint d = uint(round(texelFetch(shadow_depth, coord, 0).r * 16777215.0));
+    uint pixel = imageLoad(shadow_buffer, coord).x;
+    if (d < (pixel >> 8)) {
+        imageStore(shadow_buffer, coord, uvec4((d << 8) | (pixel & 0xFFu)));
+    }
+}
+)";
+
+} // Anonymous namespace
+
+ShadowDepthResolver::ShadowDepthResolver() {
+    OGLShader shader;
+    shader.Create(resolve_source, GL_COMPUTE_SHADER);
+    program.Create(false, {shader.handle});
+
+    OpenGLState state = OpenGLState::GetCurState();
+    const GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+    glUniform1i(glGetUniformLocation(program.handle, "shadow_depth"), 0);
+    glUniform1i(glGetUniformLocation(program.handle, "shadow_buffer"), ImageUnits::ShadowBuffer);
+    origin_u_id = glGetUniformLocation(program.handle, "origin");
+    size_u_id = glGetUniformLocation(program.handle, "size");
+    state.draw.shader_program = old_program;
+    state.Apply();
+}
+
+ShadowDepthResolver::~ShadowDepthResolver() = default;
+
+bool ShadowDepthResolver::IsSupported() {
+    return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_image_load_store;
+}
+
+GLuint ShadowDepthResolver::GetDepthTexture(u32 width, u32 height) {
+    if (depth_texture.handle != 0 && width == depth_width && height == depth_height) {
+        return depth_texture.handle;
+    }
+
+    OpenGLState state = OpenGLState::GetCurState();
+    const GLuint old_tex = state.texture_units[0].texture_2d;
+
+    depth_texture.Release();
+    depth_texture.Create();
+    state.texture_units[0].texture_2d = depth_texture.handle;
+    state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT,
+                 GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    state.texture_units[0].texture_2d = old_tex;
+    state.Apply();
+
+    depth_width = width;
+    depth_height = height;
+    return depth_texture.handle;
+}
+
+void ShadowDepthResolver::Clear(const MathUtil::Rectangle<u32>& rect) {
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    state.scissor.enabled = true;
+    state.scissor.x = static_cast<GLint>(rect.left);
+    state.scissor.y = static_cast<GLint>(rect.bottom);
+    state.scissor.width = static_cast<GLsizei>(rect.GetWidth());
+    state.scissor.height = static_cast<GLsizei>(rect.GetHeight());
+    state.depth.write_mask = GL_TRUE;
+    state.Apply();
+
+    const GLfloat far_depth = 1.0f;
+    glClearBufferfv(GL_DEPTH, 0, &far_depth);
+}
+
+MICROPROFILE_DEFINE(OpenGL_ShadowResolve, "OpenGL", "Shadow Resolve", MP_RGB(96, 96, 160));
+void ShadowDepthResolver::Resolve(const MathUtil::Rectangle<u32>& rect) {
+    MICROPROFILE_SCOPE(OpenGL_ShadowResolve);
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    state.draw.shader_program = program.handle;
+    state.texture_units[0].texture_2d = depth_texture.handle;
+    state.texture_units[0].sampler = 0;
+    state.Apply();
+
+    glUniform2i(origin_u_id, static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom));
+    glUniform2i(size_u_id, static_cast<GLint>(rect.GetWidth()),
+                static_cast<GLint>(rect.GetHeight()));
+
+    // The penumbra fragments of the draw wrote the shadow buffer with image atomics
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glDispatchCompute((rect.GetWidth() + RESOLVE_GROUP_SIZE - 1) / RESOLVE_GROUP_SIZE,
+                      (rect.GetHeight() + RESOLVE_GROUP_SIZE - 1) / RESOLVE_GROUP_SIZE, 1);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,47 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Lets shadow rendering draws lower the depths of the shadow buffer with the depth test instead of
+ * with image atomics. The fragments that don't cast a penumbra write their depth to a depth
+ * attachment, and Resolve merges it into the shadow buffer bound to ImageUnits::ShadowBuffer once
+ * the draw is done. Only the penumbra fragments still go through the atomic loop.
+ */
+class ShadowDepthResolver : NonCopyable {
+public:
+    ShadowDepthResolver();
+    ~ShadowDepthResolver();
+
+    /// Whether the driver supports everything the resolve pass needs
+    static bool IsSupported();
+
+    /// Returns the depth texture to attach to a shadow draw, resized to the given size
+    GLuint GetDepthTexture(u32 width, u32 height);
+
+    /// Clears the given rectangle of the depth texture, which must be attached to the framebuffer
+    void Clear(const MathUtil::Rectangle<u32>& rect);
+
+    /// Lowers the depths of the rectangle of the bound shadow buffer to the ones of the depth texture
+    void Resolve(const MathUtil::Rectangle<u32>& rect);
+
+private:
+    OGLProgram program;
+    GLint origin_u_id;
+    GLint size_u_id;
+
+    OGLTexture depth_texture;
+    u32 depth_width = 0;
+    u32 depth_height = 0;
+};
+
+} // namespace OpenGL
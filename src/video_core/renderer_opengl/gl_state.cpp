@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <tuple>
 #include <glad/glad.h>
+#include "common/bit_set.h"
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "video_core/renderer_opengl/gl_state.h"
@@ -10,6 +12,132 @@
 namespace OpenGL {
 
 OpenGLState OpenGLState::cur_state;
+OpenGLState::ApplyStats OpenGLState::apply_stats;
+
+namespace {
+
+/// Groups of related state that Apply syncs together
+enum DirtyGroup : u32 {
+    DirtyCull = 1 << 0,
+    DirtyDepth = 1 << 1,
+    DirtyColorMask = 1 << 2,
+    DirtyStencil = 1 << 3,
+    DirtyBlend = 1 << 4,
+    DirtyLogicOp = 1 << 5,
+    DirtyTextureUnits = 1 << 6,
+    DirtyTextureCube = 1 << 7,
+    DirtyTextureBufferLUTs = 1 << 8,
+    DirtyShadowImages = 1 << 9,
+    DirtyFramebuffers = 1 << 10,
+    DirtyBindings = 1 << 11,
+    DirtyScissor = 1 << 12,
+    DirtyViewport = 1 << 13,
+    DirtyClipDistance = 1 << 14,
+
+    NumDirtyGroups = 15,
+};
+
+/// Compares two states and returns the groups that differ between them
+u32 GetDirtyGroups(const OpenGLState& a, const OpenGLState& b) {
+    u32 dirty = 0;
+
+    if (std::tie(a.cull.enabled, a.cull.mode, a.cull.front_face) !=
+        std::tie(b.cull.enabled, b.cull.mode, b.cull.front_face)) {
+        dirty |= DirtyCull;
+    }
+
+    if (std::tie(a.depth.test_enabled, a.depth.test_func, a.depth.write_mask) !=
+        std::tie(b.depth.test_enabled, b.depth.test_func, b.depth.write_mask)) {
+        dirty |= DirtyDepth;
+    }
+
+    if (std::tie(a.color_mask.red_enabled, a.color_mask.green_enabled, a.color_mask.blue_enabled,
+                 a.color_mask.alpha_enabled) !=
+        std::tie(b.color_mask.red_enabled, b.color_mask.green_enabled, b.color_mask.blue_enabled,
+                 b.color_mask.alpha_enabled)) {
+        dirty |= DirtyColorMask;
+    }
+
+    if (std::tie(a.stencil.test_enabled, a.stencil.test_func, a.stencil.test_ref,
+                 a.stencil.test_mask, a.stencil.write_mask, a.stencil.action_stencil_fail,
+                 a.stencil.action_depth_fail, a.stencil.action_depth_pass) !=
+        std::tie(b.stencil.test_enabled, b.stencil.test_func, b.stencil.test_ref,
+                 b.stencil.test_mask, b.stencil.write_mask, b.stencil.action_stencil_fail,
+                 b.stencil.action_depth_fail, b.stencil.action_depth_pass)) {
+        dirty |= DirtyStencil;
+    }
+
+    if (std::tie(a.blend.enabled, a.blend.rgb_equation, a.blend.a_equation, a.blend.src_rgb_func,
+                 a.blend.dst_rgb_func, a.blend.src_a_func, a.blend.dst_a_func, a.blend.color.red,
+                 a.blend.color.green, a.blend.color.blue, a.blend.color.alpha) !=
+        std::tie(b.blend.enabled, b.blend.rgb_equation, b.blend.a_equation, b.blend.src_rgb_func,
+                 b.blend.dst_rgb_func, b.blend.src_a_func, b.blend.dst_a_func, b.blend.color.red,
+                 b.blend.color.green, b.blend.color.blue, b.blend.color.alpha)) {
+        dirty |= DirtyBlend;
+    }
+
+    if (a.logic_op != b.logic_op) {
+        dirty |= DirtyLogicOp;
+    }
+
+    for (unsigned i = 0; i < ARRAY_SIZE(a.texture_units); ++i) {
+        if (a.texture_units[i].texture_2d != b.texture_units[i].texture_2d ||
+            a.texture_units[i].sampler != b.texture_units[i].sampler) {
+            dirty |= DirtyTextureUnits;
+            break;
+        }
+    }
+
+    if (a.texture_cube_unit.texture_cube != b.texture_cube_unit.texture_cube ||
+        a.texture_cube_unit.sampler != b.texture_cube_unit.sampler) {
+        dirty |= DirtyTextureCube;
+    }
+
+    if (a.texture_buffer_lut_rg.texture_buffer != b.texture_buffer_lut_rg.texture_buffer ||
+        a.texture_buffer_lut_rgba.texture_buffer != b.texture_buffer_lut_rgba.texture_buffer) {
+        dirty |= DirtyTextureBufferLUTs;
+    }
+
+    if (std::tie(a.image_shadow_buffer, a.image_shadow_texture_px, a.image_shadow_texture_nx,
+                 a.image_shadow_texture_py, a.image_shadow_texture_ny, a.image_shadow_texture_pz,
+                 a.image_shadow_texture_nz) !=
+        std::tie(b.image_shadow_buffer, b.image_shadow_texture_px, b.image_shadow_texture_nx,
+                 b.image_shadow_texture_py, b.image_shadow_texture_ny, b.image_shadow_texture_pz,
+                 b.image_shadow_texture_nz)) {
+        dirty |= DirtyShadowImages;
+    }
+
+    if (a.draw.read_framebuffer != b.draw.read_framebuffer ||
+        a.draw.draw_framebuffer != b.draw.draw_framebuffer) {
+        dirty |= DirtyFramebuffers;
+    }
+
+    if (std::tie(a.draw.vertex_array, a.draw.vertex_buffer, a.draw.uniform_buffer,
+                 a.draw.shader_program, a.draw.program_pipeline) !=
+        std::tie(b.draw.vertex_array, b.draw.vertex_buffer, b.draw.uniform_buffer,
+                 b.draw.shader_program, b.draw.program_pipeline)) {
+        dirty |= DirtyBindings;
+    }
+
+    if (std::tie(a.scissor.enabled, a.scissor.x, a.scissor.y, a.scissor.width,
+                 a.scissor.height) !=
+        std::tie(b.scissor.enabled, b.scissor.x, b.scissor.y, b.scissor.width, b.scissor.height)) {
+        dirty |= DirtyScissor;
+    }
+
+    if (std::tie(a.viewport.x, a.viewport.y, a.viewport.width, a.viewport.height) !=
+        std::tie(b.viewport.x, b.viewport.y, b.viewport.width, b.viewport.height)) {
+        dirty |= DirtyViewport;
+    }
+
+    if (a.clip_distance != b.clip_distance) {
+        dirty |= DirtyClipDistance;
+    }
+
+    return dirty;
+}
+
+} // Anonymous namespace
 
 OpenGLState::OpenGLState() {
     // These all match default OpenGL values
@@ -91,240 +219,270 @@ OpenGLState::OpenGLState() {
 }
 
 void OpenGLState::Apply() const {
+    const u32 dirty = GetDirtyGroups(*this, cur_state);
+    ++apply_stats.applies;
+    if (dirty == 0) {
+        apply_stats.groups_skipped += NumDirtyGroups;
+        return;
+    }
+    const u32 num_dirty = static_cast<u32>(Common::BitSet<u32>(dirty).Count());
+    apply_stats.groups_applied += num_dirty;
+    apply_stats.groups_skipped += NumDirtyGroups - num_dirty;
+
     // Culling
-    if (cull.enabled != cur_state.cull.enabled) {
-        if (cull.enabled) {
-            glEnable(GL_CULL_FACE);
-        } else {
-            glDisable(GL_CULL_FACE);
+    if (dirty & DirtyCull) {
+        if (cull.enabled != cur_state.cull.enabled) {
+            if (cull.enabled) {
+                glEnable(GL_CULL_FACE);
+            } else {
+                glDisable(GL_CULL_FACE);
+            }
         }
-    }
 
-    if (cull.mode != cur_state.cull.mode) {
-        glCullFace(cull.mode);
-    }
+        if (cull.mode != cur_state.cull.mode) {
+            glCullFace(cull.mode);
+        }
 
-    if (cull.front_face != cur_state.cull.front_face) {
-        glFrontFace(cull.front_face);
+        if (cull.front_face != cur_state.cull.front_face) {
+            glFrontFace(cull.front_face);
+        }
     }
 
     // Depth test
-    if (depth.test_enabled != cur_state.depth.test_enabled) {
-        if (depth.test_enabled) {
-            glEnable(GL_DEPTH_TEST);
-        } else {
-            glDisable(GL_DEPTH_TEST);
+    if (dirty & DirtyDepth) {
+        if (depth.test_enabled != cur_state.depth.test_enabled) {
+            if (depth.test_enabled) {
+                glEnable(GL_DEPTH_TEST);
+            } else {
+                glDisable(GL_DEPTH_TEST);
+            }
         }
-    }
 
-    if (depth.test_func != cur_state.depth.test_func) {
-        glDepthFunc(depth.test_func);
-    }
+        if (depth.test_func != cur_state.depth.test_func) {
+            glDepthFunc(depth.test_func);
+        }
 
-    // Depth mask
-    if (depth.write_mask != cur_state.depth.write_mask) {
-        glDepthMask(depth.write_mask);
+        // Depth mask
+        if (depth.write_mask != cur_state.depth.write_mask) {
+            glDepthMask(depth.write_mask);
+        }
     }
 
     // Color mask
-    if (color_mask.red_enabled != cur_state.color_mask.red_enabled ||
-        color_mask.green_enabled != cur_state.color_mask.green_enabled ||
-        color_mask.blue_enabled != cur_state.color_mask.blue_enabled ||
-        color_mask.alpha_enabled != cur_state.color_mask.alpha_enabled) {
+    if (dirty & DirtyColorMask) {
         glColorMask(color_mask.red_enabled, color_mask.green_enabled, color_mask.blue_enabled,
                     color_mask.alpha_enabled);
     }
 
     // Stencil test
-    if (stencil.test_enabled != cur_state.stencil.test_enabled) {
-        if (stencil.test_enabled) {
-            glEnable(GL_STENCIL_TEST);
-        } else {
-            glDisable(GL_STENCIL_TEST);
+    if (dirty & DirtyStencil) {
+        if (stencil.test_enabled != cur_state.stencil.test_enabled) {
+            if (stencil.test_enabled) {
+                glEnable(GL_STENCIL_TEST);
+            } else {
+                glDisable(GL_STENCIL_TEST);
+            }
         }
-    }
 
-    if (stencil.test_func != cur_state.stencil.test_func ||
-        stencil.test_ref != cur_state.stencil.test_ref ||
-        stencil.test_mask != cur_state.stencil.test_mask) {
-        glStencilFunc(stencil.test_func, stencil.test_ref, stencil.test_mask);
-    }
+        if (stencil.test_func != cur_state.stencil.test_func ||
+            stencil.test_ref != cur_state.stencil.test_ref ||
+            stencil.test_mask != cur_state.stencil.test_mask) {
+            glStencilFunc(stencil.test_func, stencil.test_ref, stencil.test_mask);
+        }
 
-    if (stencil.action_depth_fail != cur_state.stencil.action_depth_fail ||
-        stencil.action_depth_pass != cur_state.stencil.action_depth_pass ||
-        stencil.action_stencil_fail != cur_state.stencil.action_stencil_fail) {
-        glStencilOp(stencil.action_stencil_fail, stencil.action_depth_fail,
-                    stencil.action_depth_pass);
-    }
+        if (stencil.action_depth_fail != cur_state.stencil.action_depth_fail ||
+            stencil.action_depth_pass != cur_state.stencil.action_depth_pass ||
+            stencil.action_stencil_fail != cur_state.stencil.action_stencil_fail) {
+            glStencilOp(stencil.action_stencil_fail, stencil.action_depth_fail,
+                        stencil.action_depth_pass);
+        }
 
-    // Stencil mask
-    if (stencil.write_mask != cur_state.stencil.write_mask) {
-        glStencilMask(stencil.write_mask);
+        // Stencil mask
+        if (stencil.write_mask != cur_state.stencil.write_mask) {
+            glStencilMask(stencil.write_mask);
+        }
     }
 
     // Blending
-    if (blend.enabled != cur_state.blend.enabled) {
-        if (blend.enabled) {
-            glEnable(GL_BLEND);
-            glDisable(GL_COLOR_LOGIC_OP);
-        } else {
-            glDisable(GL_BLEND);
-            glEnable(GL_COLOR_LOGIC_OP);
+    if (dirty & DirtyBlend) {
+        if (blend.enabled != cur_state.blend.enabled) {
+            if (blend.enabled) {
+                glEnable(GL_BLEND);
+                glDisable(GL_COLOR_LOGIC_OP);
+            } else {
+                glDisable(GL_BLEND);
+                glEnable(GL_COLOR_LOGIC_OP);
+            }
         }
-    }
 
-    if (blend.color.red != cur_state.blend.color.red ||
-        blend.color.green != cur_state.blend.color.green ||
-        blend.color.blue != cur_state.blend.color.blue ||
-        blend.color.alpha != cur_state.blend.color.alpha) {
-        glBlendColor(blend.color.red, blend.color.green, blend.color.blue, blend.color.alpha);
-    }
+        if (blend.color.red != cur_state.blend.color.red ||
+            blend.color.green != cur_state.blend.color.green ||
+            blend.color.blue != cur_state.blend.color.blue ||
+            blend.color.alpha != cur_state.blend.color.alpha) {
+            glBlendColor(blend.color.red, blend.color.green, blend.color.blue, blend.color.alpha);
+        }
 
-    if (blend.src_rgb_func != cur_state.blend.src_rgb_func ||
-        blend.dst_rgb_func != cur_state.blend.dst_rgb_func ||
-        blend.src_a_func != cur_state.blend.src_a_func ||
-        blend.dst_a_func != cur_state.blend.dst_a_func) {
-        glBlendFuncSeparate(blend.src_rgb_func, blend.dst_rgb_func, blend.src_a_func,
-                            blend.dst_a_func);
-    }
+        if (blend.src_rgb_func != cur_state.blend.src_rgb_func ||
+            blend.dst_rgb_func != cur_state.blend.dst_rgb_func ||
+            blend.src_a_func != cur_state.blend.src_a_func ||
+            blend.dst_a_func != cur_state.blend.dst_a_func) {
+            glBlendFuncSeparate(blend.src_rgb_func, blend.dst_rgb_func, blend.src_a_func,
+                                blend.dst_a_func);
+        }
 
-    if (blend.rgb_equation != cur_state.blend.rgb_equation ||
-        blend.a_equation != cur_state.blend.a_equation) {
-        glBlendEquationSeparate(blend.rgb_equation, blend.a_equation);
+        if (blend.rgb_equation != cur_state.blend.rgb_equation ||
+            blend.a_equation != cur_state.blend.a_equation) {
+            glBlendEquationSeparate(blend.rgb_equation, blend.a_equation);
+        }
     }
 
-    if (logic_op != cur_state.logic_op) {
+    if (dirty & DirtyLogicOp) {
         glLogicOp(logic_op);
     }
 
     // Textures
-    for (unsigned i = 0; i < ARRAY_SIZE(texture_units); ++i) {
-        if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
-            glActiveTexture(TextureUnits::PicaTexture(i).Enum());
-            glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
-        }
-        if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
-            glBindSampler(i, texture_units[i].sampler);
+    if (dirty & DirtyTextureUnits) {
+        for (unsigned i = 0; i < ARRAY_SIZE(texture_units); ++i) {
+            if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
+                glActiveTexture(TextureUnits::PicaTexture(i).Enum());
+                glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
+            }
+            if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
+                glBindSampler(i, texture_units[i].sampler);
+            }
         }
     }
 
-    if (texture_cube_unit.texture_cube != cur_state.texture_cube_unit.texture_cube) {
-        glActiveTexture(TextureUnits::TextureCube.Enum());
-        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_cube_unit.texture_cube);
-    }
-    if (texture_cube_unit.sampler != cur_state.texture_cube_unit.sampler) {
-        glBindSampler(TextureUnits::TextureCube.id, texture_cube_unit.sampler);
+    if (dirty & DirtyTextureCube) {
+        if (texture_cube_unit.texture_cube != cur_state.texture_cube_unit.texture_cube) {
+            glActiveTexture(TextureUnits::TextureCube.Enum());
+            glBindTexture(GL_TEXTURE_CUBE_MAP, texture_cube_unit.texture_cube);
+        }
+        if (texture_cube_unit.sampler != cur_state.texture_cube_unit.sampler) {
+            glBindSampler(TextureUnits::TextureCube.id, texture_cube_unit.sampler);
+        }
     }
 
     // Texture buffer LUTs
-    if (texture_buffer_lut_rg.texture_buffer != cur_state.texture_buffer_lut_rg.texture_buffer) {
-        glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
-        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rg.texture_buffer);
-    }
+    if (dirty & DirtyTextureBufferLUTs) {
+        if (texture_buffer_lut_rg.texture_buffer !=
+            cur_state.texture_buffer_lut_rg.texture_buffer) {
+            glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
+            glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rg.texture_buffer);
+        }
 
-    // Texture buffer LUTs
-    if (texture_buffer_lut_rgba.texture_buffer !=
-        cur_state.texture_buffer_lut_rgba.texture_buffer) {
-        glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
-        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rgba.texture_buffer);
+        if (texture_buffer_lut_rgba.texture_buffer !=
+            cur_state.texture_buffer_lut_rgba.texture_buffer) {
+            glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
+            glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rgba.texture_buffer);
+        }
     }
 
     // Shadow Images
-    if (image_shadow_buffer != cur_state.image_shadow_buffer) {
-        glBindImageTexture(ImageUnits::ShadowBuffer, image_shadow_buffer, 0, GL_FALSE, 0,
-                           GL_READ_WRITE, GL_R32UI);
-    }
+    if (dirty & DirtyShadowImages) {
+        if (image_shadow_buffer != cur_state.image_shadow_buffer) {
+            glBindImageTexture(ImageUnits::ShadowBuffer, image_shadow_buffer, 0, GL_FALSE, 0,
+                               GL_READ_WRITE, GL_R32UI);
+        }
 
-    if (image_shadow_texture_px != cur_state.image_shadow_texture_px) {
-        glBindImageTexture(ImageUnits::ShadowTexturePX, image_shadow_texture_px, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
-    }
+        if (image_shadow_texture_px != cur_state.image_shadow_texture_px) {
+            glBindImageTexture(ImageUnits::ShadowTexturePX, image_shadow_texture_px, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
 
-    if (image_shadow_texture_nx != cur_state.image_shadow_texture_nx) {
-        glBindImageTexture(ImageUnits::ShadowTextureNX, image_shadow_texture_nx, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
-    }
+        if (image_shadow_texture_nx != cur_state.image_shadow_texture_nx) {
+            glBindImageTexture(ImageUnits::ShadowTextureNX, image_shadow_texture_nx, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
 
-    if (image_shadow_texture_py != cur_state.image_shadow_texture_py) {
-        glBindImageTexture(ImageUnits::ShadowTexturePY, image_shadow_texture_py, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
-    }
+        if (image_shadow_texture_py != cur_state.image_shadow_texture_py) {
+            glBindImageTexture(ImageUnits::ShadowTexturePY, image_shadow_texture_py, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
 
-    if (image_shadow_texture_ny != cur_state.image_shadow_texture_ny) {
-        glBindImageTexture(ImageUnits::ShadowTextureNY, image_shadow_texture_ny, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
-    }
+        if (image_shadow_texture_ny != cur_state.image_shadow_texture_ny) {
+            glBindImageTexture(ImageUnits::ShadowTextureNY, image_shadow_texture_ny, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
 
-    if (image_shadow_texture_pz != cur_state.image_shadow_texture_pz) {
-        glBindImageTexture(ImageUnits::ShadowTexturePZ, image_shadow_texture_pz, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
-    }
+        if (image_shadow_texture_pz != cur_state.image_shadow_texture_pz) {
+            glBindImageTexture(ImageUnits::ShadowTexturePZ, image_shadow_texture_pz, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
 
-    if (image_shadow_texture_nz != cur_state.image_shadow_texture_nz) {
-        glBindImageTexture(ImageUnits::ShadowTextureNZ, image_shadow_texture_nz, 0, GL_FALSE, 0,
-                           GL_READ_ONLY, GL_R32UI);
+        if (image_shadow_texture_nz != cur_state.image_shadow_texture_nz) {
+            glBindImageTexture(ImageUnits::ShadowTextureNZ, image_shadow_texture_nz, 0, GL_FALSE,
+                               0, GL_READ_ONLY, GL_R32UI);
+        }
     }
 
     // Framebuffer
-    if (draw.read_framebuffer != cur_state.draw.read_framebuffer) {
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, draw.read_framebuffer);
-    }
-    if (draw.draw_framebuffer != cur_state.draw.draw_framebuffer) {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw.draw_framebuffer);
+    if (dirty & DirtyFramebuffers) {
+        if (draw.read_framebuffer != cur_state.draw.read_framebuffer) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, draw.read_framebuffer);
+        }
+        if (draw.draw_framebuffer != cur_state.draw.draw_framebuffer) {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw.draw_framebuffer);
+        }
     }
 
-    // Vertex array
-    if (draw.vertex_array != cur_state.draw.vertex_array) {
-        glBindVertexArray(draw.vertex_array);
-    }
+    if (dirty & DirtyBindings) {
+        // Vertex array
+        if (draw.vertex_array != cur_state.draw.vertex_array) {
+            glBindVertexArray(draw.vertex_array);
+        }
 
-    // Vertex buffer
-    if (draw.vertex_buffer != cur_state.draw.vertex_buffer) {
-        glBindBuffer(GL_ARRAY_BUFFER, draw.vertex_buffer);
-    }
+        // Vertex buffer
+        if (draw.vertex_buffer != cur_state.draw.vertex_buffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, draw.vertex_buffer);
+        }
 
-    // Uniform buffer
-    if (draw.uniform_buffer != cur_state.draw.uniform_buffer) {
-        glBindBuffer(GL_UNIFORM_BUFFER, draw.uniform_buffer);
-    }
+        // Uniform buffer
+        if (draw.uniform_buffer != cur_state.draw.uniform_buffer) {
+            glBindBuffer(GL_UNIFORM_BUFFER, draw.uniform_buffer);
+        }
 
-    // Shader program
-    if (draw.shader_program != cur_state.draw.shader_program) {
-        glUseProgram(draw.shader_program);
-    }
+        // Shader program
+        if (draw.shader_program != cur_state.draw.shader_program) {
+            glUseProgram(draw.shader_program);
+        }
 
-    // Program pipeline
-    if (draw.program_pipeline != cur_state.draw.program_pipeline) {
-        glBindProgramPipeline(draw.program_pipeline);
+        // Program pipeline
+        if (draw.program_pipeline != cur_state.draw.program_pipeline) {
+            glBindProgramPipeline(draw.program_pipeline);
+        }
     }
 
     // Scissor test
-    if (scissor.enabled != cur_state.scissor.enabled) {
-        if (scissor.enabled) {
-            glEnable(GL_SCISSOR_TEST);
-        } else {
-            glDisable(GL_SCISSOR_TEST);
+    if (dirty & DirtyScissor) {
+        if (scissor.enabled != cur_state.scissor.enabled) {
+            if (scissor.enabled) {
+                glEnable(GL_SCISSOR_TEST);
+            } else {
+                glDisable(GL_SCISSOR_TEST);
+            }
         }
-    }
 
-    if (scissor.x != cur_state.scissor.x || scissor.y != cur_state.scissor.y ||
-        scissor.width != cur_state.scissor.width || scissor.height != cur_state.scissor.height) {
-        glScissor(scissor.x, scissor.y, scissor.width, scissor.height);
+        if (scissor.x != cur_state.scissor.x || scissor.y != cur_state.scissor.y ||
+            scissor.width != cur_state.scissor.width ||
+            scissor.height != cur_state.scissor.height) {
+            glScissor(scissor.x, scissor.y, scissor.width, scissor.height);
+        }
     }
 
-    if (viewport.x != cur_state.viewport.x || viewport.y != cur_state.viewport.y ||
-        viewport.width != cur_state.viewport.width ||
-        viewport.height != cur_state.viewport.height) {
+    if (dirty & DirtyViewport) {
         glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
     }
 
     // Clip distance
-    for (std::size_t i = 0; i < clip_distance.size(); ++i) {
-        if (clip_distance[i] != cur_state.clip_distance[i]) {
-            if (clip_distance[i]) {
-                glEnable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
-            } else {
-                glDisable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
+    if (dirty & DirtyClipDistance) {
+        for (std::size_t i = 0; i < clip_distance.size(); ++i) {
+            if (clip_distance[i] != cur_state.clip_distance[i]) {
+                if (clip_distance[i]) {
+                    glEnable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
+                } else {
+                    glDisable(GL_CLIP_DISTANCE0 + static_cast<GLenum>(i));
+                }
             }
         }
     }
@@ -332,6 +490,12 @@ void OpenGLState::Apply() const {
     cur_state = *this;
 }
 
+OpenGLState::ApplyStats OpenGLState::GetAndResetApplyStats() {
+    const ApplyStats stats = apply_stats;
+    apply_stats = {};
+    return stats;
+}
+
 OpenGLState& OpenGLState::ResetTexture(GLuint handle) {
     for (auto& unit : texture_units) {
         if (unit.texture_2d == handle) {
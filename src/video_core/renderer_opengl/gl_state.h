@@ -6,6 +6,7 @@
 
 #include <array>
 #include <glad/glad.h>
+#include "common/common_types.h"
 
 namespace OpenGL {
 
@@ -36,6 +37,7 @@ constexpr GLuint ShadowTexturePY = 3;
 constexpr GLuint ShadowTextureNY = 4;
 constexpr GLuint ShadowTexturePZ = 5;
 constexpr GLuint ShadowTextureNZ = 6;
+constexpr GLuint TextureCodec = 7;
 } // namespace ImageUnits
 
 class OpenGLState {
@@ -151,9 +153,22 @@ public:
         return cur_state;
     }
 
-    /// Apply this state as the current OpenGL state
+    /// Apply this state as the current OpenGL state. Only the groups of related state that differ
+    /// from the current one are synced.
     void Apply() const;
 
+    struct ApplyStats {
+        /// Number of Apply calls
+        u32 applies;
+        /// State groups that were synced with the driver
+        u32 groups_applied;
+        /// State groups whose GL calls were skipped because they were unchanged
+        u32 groups_skipped;
+    };
+
+    /// Gets the Apply counters accumulated since the last call
+    static ApplyStats GetAndResetApplyStats();
+
     /// Resets any references to the given resource
     OpenGLState& ResetTexture(GLuint handle);
     OpenGLState& ResetSampler(GLuint handle);
@@ -165,6 +180,7 @@ public:
 
 private:
     static OpenGLState cur_state;
+    static ApplyStats apply_stats;
 };
 
 } // namespace OpenGL
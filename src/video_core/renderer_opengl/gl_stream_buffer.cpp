@@ -2,8 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <deque>
-#include <vector>
+#include <algorithm>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/microprofile.h"
@@ -12,6 +11,8 @@
 
 MICROPROFILE_DEFINE(OpenGL_StreamBuffer, "OpenGL", "Stream Buffer Orphaning",
                     MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(OpenGL_StreamBufferWait, "OpenGL", "Stream Buffer Wait",
+                    MP_RGB(192, 128, 128));
 
 namespace OpenGL {
 
@@ -71,18 +72,21 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
 
     bool invalidate = false;
     if (buffer_pos + size > buffer_size) {
-        buffer_pos = 0;
-        invalidate = true;
-
         if (persistent) {
-            glUnmapBuffer(gl_target);
+            FenceUsedRegions(NUM_SYNC_POINTS);
+            current_sync_point = 0;
         }
+        buffer_pos = 0;
+        invalidate = true;
     }
 
-    if (invalidate || !persistent) {
+    if (persistent) {
+        // The buffer stays mapped, only make sure the GPU no longer reads the memory we reuse
+        FenceUsedRegions(GetSyncPoint(buffer_pos));
+        WaitForRegions(buffer_pos, buffer_pos + size);
+    } else {
         MICROPROFILE_SCOPE(OpenGL_StreamBuffer);
-        GLbitfield flags = GL_MAP_WRITE_BIT | (persistent ? GL_MAP_PERSISTENT_BIT : 0) |
-                           (coherent ? GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT) |
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT |
                            (invalidate ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_UNSYNCHRONIZED_BIT);
         mapped_ptr = static_cast<u8*>(
             glMapBufferRange(gl_target, buffer_pos, buffer_size - buffer_pos, flags));
@@ -92,6 +96,32 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
     return std::make_tuple(mapped_ptr + buffer_pos - mapped_offset, buffer_pos, invalidate);
 }
 
+std::size_t OGLStreamBuffer::GetSyncPoint(GLintptr pos) const {
+    const GLsizeiptr region_size = buffer_size / NUM_SYNC_POINTS;
+    return std::min<std::size_t>(pos / region_size, NUM_SYNC_POINTS - 1);
+}
+
+void OGLStreamBuffer::FenceUsedRegions(std::size_t end_sync_point) {
+    // All the commands reading the previous chunks have been issued at this point
+    for (; current_sync_point < end_sync_point; ++current_sync_point) {
+        fences[current_sync_point].Create();
+    }
+}
+
+void OGLStreamBuffer::WaitForRegions(GLintptr begin, GLintptr end) {
+    const std::size_t first = GetSyncPoint(begin);
+    const std::size_t last = GetSyncPoint(std::max<GLintptr>(begin, end - 1));
+    for (std::size_t i = first; i <= last; ++i) {
+        OGLSync& fence = fences[i];
+        if (fence.handle == nullptr)
+            continue;
+
+        MICROPROFILE_SCOPE(OpenGL_StreamBufferWait);
+        glClientWaitSync(fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        fence.Release();
+    }
+}
+
 void OGLStreamBuffer::Unmap(GLsizeiptr size) {
     ASSERT(size <= mapped_size);
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include <glad/glad.h>
 #include "common/common_types.h"
@@ -23,7 +24,9 @@ public:
     /*
      * Allocates a linear chunk of memory in the GPU buffer with at least "size" bytes
      * and the optional alignment requirement.
-     * If the buffer is full, the whole buffer is reallocated which invalidates old chunks.
+     * If the buffer is full, allocation restarts at the beginning of the buffer which invalidates
+     * old chunks. Persistently mapped buffers wait for the GPU to be done with the reused memory,
+     * other buffers are reallocated.
      * The return values are the pointer to the new chunk, the offset within the buffer,
      * and the invalidation flag for previous chunks.
      * The actual used size must be specified on unmapping the chunk.
@@ -33,6 +36,17 @@ public:
     void Unmap(GLsizeiptr size);
 
 private:
+    /// Number of fenced regions a persistently mapped buffer is split into
+    static constexpr std::size_t NUM_SYNC_POINTS = 16;
+
+    std::size_t GetSyncPoint(GLintptr pos) const;
+
+    /// Inserts fences for the regions the write position moved past
+    void FenceUsedRegions(std::size_t end_sync_point);
+
+    /// Waits for the GPU to release the regions covering [begin, end)
+    void WaitForRegions(GLintptr begin, GLintptr end);
+
     OGLBuffer gl_buffer;
     GLenum gl_target;
 
@@ -44,6 +58,9 @@ private:
     GLintptr mapped_offset = 0;
     GLsizeiptr mapped_size = 0;
     u8* mapped_ptr = nullptr;
+
+    std::array<OGLSync, NUM_SYNC_POINTS> fences;
+    std::size_t current_sync_point = 0;
 };
 
 } // namespace OpenGL
@@ -0,0 +1,494 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <tuple>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "core/memory.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+#include "video_core/video_core.h"
+
+namespace OpenGL {
+
+namespace {
+
+using PixelFormat = SurfaceParams::PixelFormat;
+using SurfaceType = SurfaceParams::SurfaceType;
+
+// Large enough for a 1024x1024 RGBA8 texture
+constexpr GLsizeiptr UPLOAD_BUFFER_SIZE = 8 * 1024 * 1024;
+
+// Work group sizes, must match the local_size declarations of the shaders below
+constexpr u32 DECODE_GROUP_SIZE = 8;
+constexpr u32 ENCODE_GROUP_SIZE = 64;
+
+// Both shaders use the PixelFormat values for the format uniform
+constexpr char decode_source[] = R"(
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform usamplerBuffer source;
+layout(rgba8) uniform writeonly image2D dest;
+
+uniform int format;
+uniform ivec2 rect_origin;
+uniform ivec2 rect_size;
+uniform ivec2 dest_origin;
+uniform int surface_height;
+uniform int row_bytes;
+uniform int tile_size;
+// Offset of the first byte of the surface in the source buffer, may be negative when only a part
+// of the surface was uploaded
+uniform int source_bias;
+
+uint ReadByte(int offset) {
+    int address = source_bias + offset;
+    uint word = texelFetch(source, address >> 2).r;
+    return (word >> ((address & 3) * 8)) & 0xFFu;
+}
+
+uint Read16(int offset) {
+    return ReadByte(offset) | (ReadByte(offset + 1) << 8);
+}
+
+uint Read32(int offset) {
+    return Read16(offset) | (Read16(offset + 2) << 16);
+}
+
+uint Convert4To8(uint value) {
+    return (value << 4) | value;
+}
+
+uint Convert5To8(uint value) {
+    // The ETC1 deltas can take the base outside of 5 bits, this wraps like the CPU decoder does
+    return ((value << 3) | (value >> 2)) & 0xFFu;
+}
+
+uint Convert6To8(uint value) {
+    return (value << 2) | (value >> 4);
+}
+
+int SignExtend3(uint value) {
+    return int(value << 29) >> 29;
+}
+
+const int etc1_modifiers[16] = int[16](2, 8, 5, 17, 9, 29, 13, 42, 18, 60, 24, 80, 33, 106, 47,
+                                       183);
+
+uvec4 DecodeETC1(int offset, int x, int y, bool has_alpha) {
+    offset += ((x >> 2) + 2 * (y >> 2)) * (has_alpha ? 16 : 8);
+    x &= 3;
+    y &= 3;
+
+    uint alpha = 255u;
+    if (has_alpha) {
+        int shift = 4 * (x * 4 + y);
+        uint packed = shift < 32 ? Read32(offset) >> shift : Read32(offset + 4) >> (shift - 32);
+        alpha = Convert4To8(packed & 0xFu);
+        offset += 8;
+    }
+
+    uint lo = Read32(offset);
+    uint hi = Read32(offset + 4);
+
+    int texel = 4 * x + y;
+    if ((hi & 1u) != 0u) {
+        int temp = x;
+        x = y;
+        y = temp;
+    }
+
+    ivec3 color;
+    if ((hi & 2u) != 0u) {
+        ivec3 base = ivec3((hi >> 27) & 0x1Fu, (hi >> 19) & 0x1Fu, (hi >> 11) & 0x1Fu);
+        if (x >= 2) {
+            base += ivec3(SignExtend3(hi >> 24), SignExtend3(hi >> 16), SignExtend3(hi >> 8));
+        }
+        color = ivec3(Convert5To8(uint(base.r) & 0xFFu), Convert5To8(uint(base.g) & 0xFFu),
+                      Convert5To8(uint(base.b) & 0xFFu));
+    } else {
+        uint shift = x < 2 ? 4u : 0u;
+        color = ivec3(Convert4To8((hi >> (24u + shift)) & 0xFu),
+                      Convert4To8((hi >> (16u + shift)) & 0xFu),
+                      Convert4To8((hi >> (8u + shift)) & 0xFu));
+    }
+
+    uint table_index = x < 2 ? (hi >> 5) & 7u : (hi >> 2) & 7u;
+    int modifier = etc1_modifiers[table_index * 2u + ((lo >> texel) & 1u)];
+    if (((lo >> (16 + texel)) & 1u) != 0u) {
+        modifier = -modifier;
+    }
+
+    return uvec4(clamp(color + modifier, 0, 255), alpha);
+}
+
+uvec4 DecodeTexel(int tile_offset, int x, int y) {
+    // Position of the texel in the Z-order curve of the tile
+    int morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) |
+                 ((y & 4) << 3);
+
+    switch (format) {
+    case 0: { // RGBA8
+        int offset = tile_offset + morton * 4;
+        return uvec4(ReadByte(offset + 3), ReadByte(offset + 2), ReadByte(offset + 1),
+                     ReadByte(offset));
+    }
+    case 1: { // RGB8
+        int offset = tile_offset + morton * 3;
+        return uvec4(ReadByte(offset + 2), ReadByte(offset + 1), ReadByte(offset), 255u);
+    }
+    case 2: { // RGB5A1
+        uint value = Read16(tile_offset + morton * 2);
+        return uvec4(Convert5To8((value >> 11) & 0x1Fu), Convert5To8((value >> 6) & 0x1Fu),
+                     Convert5To8((value >> 1) & 0x1Fu), (value & 1u) * 255u);
+    }
+    case 3: { // RGB565
+        uint value = Read16(tile_offset + morton * 2);
+        return uvec4(Convert5To8((value >> 11) & 0x1Fu), Convert6To8((value >> 5) & 0x3Fu),
+                     Convert5To8(value & 0x1Fu), 255u);
+    }
+    case 4: { // RGBA4
+        uint value = Read16(tile_offset + morton * 2);
+        return uvec4(Convert4To8((value >> 12) & 0xFu), Convert4To8((value >> 8) & 0xFu),
+                     Convert4To8((value >> 4) & 0xFu), Convert4To8(value & 0xFu));
+    }
+    case 5: { // IA8
+        int offset = tile_offset + morton * 2;
+        uint i = ReadByte(offset + 1);
+        return uvec4(i, i, i, ReadByte(offset));
+    }
+    case 6: { // RG8
+        int offset = tile_offset + morton * 2;
+        return uvec4(ReadByte(offset + 1), ReadByte(offset), 0u, 255u);
+    }
+    case 7: { // I8
+        uint i = ReadByte(tile_offset + morton);
+        return uvec4(i, i, i, 255u);
+    }
+    case 8: // A8
+        return uvec4(0u, 0u, 0u, ReadByte(tile_offset + morton));
+    case 9: { // IA4
+        uint value = ReadByte(tile_offset + morton);
+        uint i = Convert4To8(value >> 4);
+        return uvec4(i, i, i, Convert4To8(value & 0xFu));
+    }
+    case 10: { // I4
+        uint value = ReadByte(tile_offset + morton / 2);
+        uint i = Convert4To8((morton & 1) != 0 ? value >> 4 : value & 0xFu);
+        return uvec4(i, i, i, 255u);
+    }
+    case 11: { // A4
+        uint value = ReadByte(tile_offset + morton / 2);
+        return uvec4(0u, 0u, 0u, Convert4To8((morton & 1) != 0 ? value >> 4 : value & 0xFu));
+    }
+    case 12: // ETC1
+        return DecodeETC1(tile_offset, x, y, false);
+    case 13: // ETC1A4
+        return DecodeETC1(tile_offset, x, y, true);
+    }
+    return uvec4(0u);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, rect_size))) {
+        return;
+    }
+
+    // Textures are stored upside down in OpenGL
+    ivec2 surface_pos = rect_origin + texel;
+    int pica_y = surface_height - 1 - surface_pos.y;
+    int tile_offset = (pica_y >> 3) * row_bytes + (surface_pos.x >> 3) * tile_size;
+
+    uvec4 color = DecodeTexel(tile_offset, surface_pos.x & 7, pica_y & 7);
+    imageStore(dest, dest_origin + texel, vec4(color) / 255.0);
+}
+)";
+
+constexpr char encode_source[] = R"(
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+uniform sampler2D source;
+layout(r32ui) uniform writeonly uimageBuffer dest;
+
+uniform int format;
+// Subtracted from the surface coordinates of a texel to get its position in source
+uniform ivec2 source_origin;
+uniform int surface_height;
+uniform int tiles_per_row;
+uniform int bytes_per_pixel;
+uniform int first_word;
+uniform int num_words;
+
+uint EncodeByte(int offset) {
+    int tile_size = bytes_per_pixel * 64;
+    int tile = offset / tile_size;
+    int morton = (offset % tile_size) / bytes_per_pixel;
+    int component = offset % bytes_per_pixel;
+
+    int x = (tile % tiles_per_row) * 8 + ((morton & 1) | ((morton >> 1) & 2) | ((morton >> 2) & 4));
+    int pica_y = (tile / tiles_per_row) * 8 +
+                 (((morton >> 1) & 1) | ((morton >> 2) & 2) | ((morton >> 3) & 4));
+    ivec2 pos = ivec2(x, surface_height - 1 - pica_y) - source_origin;
+    vec4 color = texelFetch(source, pos, 0);
+
+    uint value;
+    switch (format) {
+    case 0: { // RGBA8
+        uvec4 c = uvec4(round(color * 255.0));
+        value = (c.r << 24) | (c.g << 16) | (c.b << 8) | c.a;
+        break;
+    }
+    case 1: { // RGB8
+        uvec3 c = uvec3(round(color.rgb * 255.0));
+        value = (c.r << 16) | (c.g << 8) | c.b;
+        break;
+    }
+    case 2: { // RGB5A1
+        uvec4 c = uvec4(round(color * vec4(31.0, 31.0, 31.0, 1.0)));
+        value = (c.r << 11) | (c.g << 6) | (c.b << 1) | c.a;
+        break;
+    }
+    case 3: { // RGB565
+        uvec3 c = uvec3(round(color.rgb * vec3(31.0, 63.0, 31.0)));
+        value = (c.r << 11) | (c.g << 5) | c.b;
+        break;
+    }
+    case 4: { // RGBA4
+        uvec4 c = uvec4(round(color * 15.0));
+        value = (c.r << 12) | (c.g << 8) | (c.b << 4) | c.a;
+        break;
+    }
+    default:
+        value = 0u;
+        break;
+    }
+    return (value >> (component * 8)) & 0xFFu;
+}
+
+void main() {
+    int word = int(gl_GlobalInvocationID.x);
+    if (word >= num_words) {
+        return;
+    }
+
+    int offset = (first_word + word) * 4;
+    uint value = EncodeByte(offset) | (EncodeByte(offset + 1) << 8) |
+                 (EncodeByte(offset + 2) << 16) | (EncodeByte(offset + 3) << 24);
+    imageStore(dest, word, uvec4(value));
+}
+)";
+
+void CreateComputeProgram(OGLProgram& program, const char* source) {
+    OGLShader shader;
+    shader.Create(source, GL_COMPUTE_SHADER);
+    program.Create(false, {shader.handle});
+}
+
+} // Anonymous namespace
+
+ComputeTextureDecoder::ComputeTextureDecoder()
+    : upload_buffer(GL_TEXTURE_BUFFER, UPLOAD_BUFFER_SIZE, false) {
+    GLint max_texture_buffer_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_size);
+    if (max_texture_buffer_size < UPLOAD_BUFFER_SIZE / 4) {
+        LOG_WARNING(Render_OpenGL, "Texture buffers are too small for the compute texture decoder");
+        return;
+    }
+
+    CreateComputeProgram(decode_program, decode_source);
+    CreateComputeProgram(encode_program, encode_source);
+
+    upload_tbo.Create();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, upload_tbo.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, upload_buffer.GetHandle());
+
+    encode_buffer.Create();
+    encode_tbo.Create();
+    glBindTexture(GL_TEXTURE_BUFFER, encode_tbo.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, encode_buffer.handle);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_program = state.draw.shader_program;
+
+    state.draw.shader_program = decode_program.handle;
+    state.Apply();
+    glUniform1i(glGetUniformLocation(decode_program.handle, "source"), 0);
+    glUniform1i(glGetUniformLocation(decode_program.handle, "dest"), ImageUnits::TextureCodec);
+    decode_format_u_id = glGetUniformLocation(decode_program.handle, "format");
+    decode_rect_origin_u_id = glGetUniformLocation(decode_program.handle, "rect_origin");
+    decode_rect_size_u_id = glGetUniformLocation(decode_program.handle, "rect_size");
+    decode_dest_origin_u_id = glGetUniformLocation(decode_program.handle, "dest_origin");
+    decode_surface_height_u_id = glGetUniformLocation(decode_program.handle, "surface_height");
+    decode_row_bytes_u_id = glGetUniformLocation(decode_program.handle, "row_bytes");
+    decode_tile_size_u_id = glGetUniformLocation(decode_program.handle, "tile_size");
+    decode_source_bias_u_id = glGetUniformLocation(decode_program.handle, "source_bias");
+
+    state.draw.shader_program = encode_program.handle;
+    state.Apply();
+    glUniform1i(glGetUniformLocation(encode_program.handle, "source"), 0);
+    glUniform1i(glGetUniformLocation(encode_program.handle, "dest"), ImageUnits::TextureCodec);
+    encode_format_u_id = glGetUniformLocation(encode_program.handle, "format");
+    encode_source_origin_u_id = glGetUniformLocation(encode_program.handle, "source_origin");
+    encode_surface_height_u_id = glGetUniformLocation(encode_program.handle, "surface_height");
+    encode_tiles_per_row_u_id = glGetUniformLocation(encode_program.handle, "tiles_per_row");
+    encode_bytes_per_pixel_u_id = glGetUniformLocation(encode_program.handle, "bytes_per_pixel");
+    encode_first_word_u_id = glGetUniformLocation(encode_program.handle, "first_word");
+    encode_num_words_u_id = glGetUniformLocation(encode_program.handle, "num_words");
+
+    state.draw.shader_program = old_program;
+    state.Apply();
+
+    valid = true;
+}
+
+ComputeTextureDecoder::~ComputeTextureDecoder() = default;
+
+bool ComputeTextureDecoder::IsSupported() {
+    return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_image_load_store;
+}
+
+bool ComputeTextureDecoder::CanDecode(const SurfaceParams& surface) {
+    // imageStore can only write the RGBA8 textures used for texture formats and RGBA8 color
+    // buffers, the other color formats are stored with their own packed OpenGL formats
+    return surface.is_tiled && (surface.type == SurfaceType::Texture ||
+                                surface.pixel_format == PixelFormat::RGBA8);
+}
+
+bool ComputeTextureDecoder::CanEncode(const SurfaceParams& surface) {
+    return surface.is_tiled && surface.type == SurfaceType::Color;
+}
+
+MICROPROFILE_DEFINE(OpenGL_ComputeDecode, "OpenGL", "Compute Texture Decode", MP_RGB(64, 192, 128));
+bool ComputeTextureDecoder::Decode(const SurfaceParams& surface,
+                                   const MathUtil::Rectangle<u32>& rect, GLuint dst_tex, GLint x0,
+                                   GLint y0) {
+    ASSERT(CanDecode(surface));
+    ASSERT(rect.bottom % 8 == 0 && rect.top % 8 == 0);
+
+    const u8* const source = VideoCore::g_memory->GetPhysicalPointer(surface.addr);
+    if (source == nullptr)
+        return false;
+
+    MICROPROFILE_SCOPE(OpenGL_ComputeDecode);
+
+    // Only upload the tile rows covered by the rectangle, the top of the OpenGL texture is the
+    // first row in memory
+    const u32 row_bytes = surface.stride * SurfaceParams::GetFormatBpp(surface.pixel_format);
+    const u32 begin_offset = (surface.height - rect.top) / 8 * row_bytes;
+    const u32 end_offset = (surface.height - rect.bottom) / 8 * row_bytes;
+    const u32 upload_size = end_offset - begin_offset;
+    if (upload_size > UPLOAD_BUFFER_SIZE)
+        return false;
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    glBindBuffer(GL_TEXTURE_BUFFER, upload_buffer.GetHandle());
+    u8* buffer_ptr;
+    GLintptr buffer_offset;
+    std::tie(buffer_ptr, buffer_offset, std::ignore) = upload_buffer.Map(upload_size, 4);
+    std::memcpy(buffer_ptr, source + begin_offset, upload_size);
+    upload_buffer.Unmap(upload_size);
+
+    state.draw.shader_program = decode_program.handle;
+    state.Apply();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, upload_tbo.handle);
+    glBindImageTexture(ImageUnits::TextureCodec, dst_tex, 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_RGBA8);
+
+    glUniform1i(decode_format_u_id, static_cast<GLint>(surface.pixel_format));
+    glUniform2i(decode_rect_origin_u_id, static_cast<GLint>(rect.left),
+                static_cast<GLint>(rect.bottom));
+    glUniform2i(decode_rect_size_u_id, static_cast<GLint>(rect.GetWidth()),
+                static_cast<GLint>(rect.GetHeight()));
+    glUniform2i(decode_dest_origin_u_id, x0, y0);
+    glUniform1i(decode_surface_height_u_id, static_cast<GLint>(surface.height));
+    glUniform1i(decode_row_bytes_u_id, static_cast<GLint>(row_bytes));
+    glUniform1i(decode_tile_size_u_id,
+                static_cast<GLint>(SurfaceParams::GetFormatBpp(surface.pixel_format) * 8));
+    glUniform1i(decode_source_bias_u_id,
+                static_cast<GLint>(buffer_offset) - static_cast<GLint>(begin_offset));
+
+    glDispatchCompute((rect.GetWidth() + DECODE_GROUP_SIZE - 1) / DECODE_GROUP_SIZE,
+                      (rect.GetHeight() + DECODE_GROUP_SIZE - 1) / DECODE_GROUP_SIZE, 1);
+
+    // The texture is sampled, blitted or rendered to afterwards
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glBindImageTexture(ImageUnits::TextureCodec, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return true;
+}
+
+MICROPROFILE_DEFINE(OpenGL_ComputeEncode, "OpenGL", "Compute Texture Encode", MP_RGB(64, 192, 128));
+bool ComputeTextureDecoder::Encode(const SurfaceParams& surface,
+                                   const MathUtil::Rectangle<u32>& rect, GLuint src_tex, GLint x0,
+                                   GLint y0, PAddr start, PAddr end, u8* dest) {
+    ASSERT(CanEncode(surface));
+    ASSERT(start >= surface.addr && end <= surface.end && start < end);
+
+    MICROPROFILE_SCOPE(OpenGL_ComputeEncode);
+
+    // The shader writes whole words, the unaligned bytes at both ends are skipped on readback
+    const u32 start_offset = start - surface.addr;
+    const u32 end_offset = end - surface.addr;
+    const u32 first_word = start_offset / 4;
+    const u32 num_words = Common::AlignUp(end_offset, 4) / 4 - first_word;
+    const GLsizeiptr encode_size = static_cast<GLsizeiptr>(num_words) * 4;
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    glBindBuffer(GL_TEXTURE_BUFFER, encode_buffer.handle);
+    if (encode_size > encode_buffer_size) {
+        encode_buffer_size = encode_size * 2;
+        glBufferData(GL_TEXTURE_BUFFER, encode_buffer_size, nullptr, GL_STREAM_READ);
+    }
+
+    state.draw.shader_program = encode_program.handle;
+    state.texture_units[0].texture_2d = src_tex;
+    state.texture_units[0].sampler = 0;
+    state.Apply();
+
+    glBindImageTexture(ImageUnits::TextureCodec, encode_tbo.handle, 0, GL_FALSE, 0,
+                       GL_WRITE_ONLY, GL_R32UI);
+
+    glUniform1i(encode_format_u_id, static_cast<GLint>(surface.pixel_format));
+    glUniform2i(encode_source_origin_u_id, static_cast<GLint>(rect.left) - x0,
+                static_cast<GLint>(rect.bottom) - y0);
+    glUniform1i(encode_surface_height_u_id, static_cast<GLint>(surface.height));
+    glUniform1i(encode_tiles_per_row_u_id, static_cast<GLint>(surface.stride / 8));
+    glUniform1i(encode_bytes_per_pixel_u_id,
+                static_cast<GLint>(SurfaceParams::GetFormatBpp(surface.pixel_format) / 8));
+    glUniform1i(encode_first_word_u_id, static_cast<GLint>(first_word));
+    glUniform1i(encode_num_words_u_id, static_cast<GLint>(num_words));
+
+    glDispatchCompute((num_words + ENCODE_GROUP_SIZE - 1) / ENCODE_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindImageTexture(ImageUnits::TextureCodec, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, encode_buffer.handle);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, start_offset - first_word * 4, end - start, dest);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return true;
+}
+
+} // namespace OpenGL
@@ -0,0 +1,96 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+
+namespace OpenGL {
+
+/**
+ * Converts tiled surfaces between their 3DS memory layout and OpenGL textures with compute
+ * shaders, replacing the Morton (un)swizzle and texel decoding done on the CPU by
+ * LoadGLBuffer/FlushGLBuffer. The raw guest data is streamed to the GPU as is and decoded
+ * straight into the surface texture; flushes encode the texture into a buffer that is read back
+ * into guest memory.
+ */
+class ComputeTextureDecoder : NonCopyable {
+public:
+    ComputeTextureDecoder();
+    ~ComputeTextureDecoder();
+
+    /// Whether the driver supports everything the decoder needs
+    static bool IsSupported();
+
+    /// Whether the decoder could be set up with the limits of the driver
+    bool IsValid() const {
+        return valid;
+    }
+
+    /// Whether the surface can be loaded with Decode
+    static bool CanDecode(const SurfaceParams& surface);
+
+    /// Whether the surface can be flushed with Encode
+    static bool CanEncode(const SurfaceParams& surface);
+
+    /**
+     * Decodes a rectangle of a tiled surface from 3DS memory into a texture
+     * @param surface the surface to read, CanDecode must be true for it
+     * @param rect unscaled rectangle of the surface to decode, aligned to tiles
+     * @param dst_tex RGBA8 texture that receives the texels
+     * @param x0, y0 position of the bottom left corner of rect in dst_tex
+     * @returns false if the data could not be decoded on the GPU
+     */
+    bool Decode(const SurfaceParams& surface, const MathUtil::Rectangle<u32>& rect, GLuint dst_tex,
+                GLint x0, GLint y0);
+
+    /**
+     * Encodes a rectangle of a tiled color surface into its 3DS memory layout
+     * @param surface the surface to write, CanEncode must be true for it
+     * @param rect unscaled rectangle of the surface covering [start, end)
+     * @param src_tex unscaled texture holding the texels of rect
+     * @param x0, y0 position of the bottom left corner of rect in src_tex
+     * @param start, end range of the surface to write back
+     * @param dest pointer to the 3DS memory at start
+     * @returns false if the data could not be encoded on the GPU
+     */
+    bool Encode(const SurfaceParams& surface, const MathUtil::Rectangle<u32>& rect,
+                GLuint src_tex, GLint x0, GLint y0, PAddr start, PAddr end, u8* dest);
+
+private:
+    bool valid = false;
+
+    OGLStreamBuffer upload_buffer;
+    OGLTexture upload_tbo;
+
+    OGLBuffer encode_buffer;
+    GLsizeiptr encode_buffer_size = 0;
+    OGLTexture encode_tbo;
+
+    OGLProgram decode_program;
+    GLint decode_format_u_id;
+    GLint decode_rect_origin_u_id;
+    GLint decode_rect_size_u_id;
+    GLint decode_dest_origin_u_id;
+    GLint decode_surface_height_u_id;
+    GLint decode_row_bytes_u_id;
+    GLint decode_tile_size_u_id;
+    GLint decode_source_bias_u_id;
+
+    OGLProgram encode_program;
+    GLint encode_format_u_id;
+    GLint encode_source_origin_u_id;
+    GLint encode_surface_height_u_id;
+    GLint encode_tiles_per_row_u_id;
+    GLint encode_bytes_per_pixel_u_id;
+    GLint encode_first_word_u_id;
+    GLint encode_num_words_u_id;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,165 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
+
+namespace OpenGL {
+
+namespace {
+
+constexpr std::size_t DDS_HEADER_WORDS = 32;
+
+/// Header of an uncompressed DDS file with the byte order of GL_RGBA and GL_UNSIGNED_BYTE
+std::array<u32_le, DDS_HEADER_WORDS> MakeDDSHeader(u32 width, u32 height) {
+    std::array<u32_le, DDS_HEADER_WORDS> header{};
+    header[0] = 0x20534444; // "DDS "
+    header[1] = 124;
+    // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT
+    header[2] = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000;
+    header[3] = height;
+    header[4] = width;
+    header[5] = width * 4;
+    header[19] = 32;
+    // DDPF_RGB | DDPF_ALPHAPIXELS
+    header[20] = 0x40 | 0x1;
+    header[22] = 32;
+    header[23] = 0x000000FF;
+    header[24] = 0x0000FF00;
+    header[25] = 0x00FF0000;
+    header[26] = 0xFF000000;
+    // DDSCAPS_TEXTURE
+    header[27] = 0x1000;
+    return header;
+}
+
+} // Anonymous namespace
+
+TextureDumper::TextureDumper(u64 title_id)
+    : directory(fmt::format("{}textures" DIR_SEP "{:016X}" DIR_SEP,
+                            FileUtil::GetUserPath(FileUtil::UserPath::DumpDir), title_id)) {
+    if (!FileUtil::CreateFullPath(directory)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create the texture dump directory {}", directory);
+    }
+
+    // Textures dumped by earlier sessions are skipped too
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, directory,
+        [this](u64*, const std::string&, const std::string& virtual_name) {
+            u32 width;
+            u32 height;
+            u64 hash;
+            if (std::sscanf(virtual_name.c_str(), "tex1_%ux%u_%" SCNx64, &width, &height,
+                            &hash) == 3) {
+                dumped.insert(hash);
+            }
+            return true;
+        });
+
+    write_thread = std::thread(&TextureDumper::WriteThread, this);
+}
+
+TextureDumper::~TextureDumper() {
+    // Wait for the textures already read back, they are unique
+    for (PendingRead& read : pending_reads) {
+        glClientWaitSync(read.fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        FinishRead(read);
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    queue_cv.notify_one();
+    write_thread.join();
+}
+
+void TextureDumper::Dump(GLuint texture, u32 width, u32 height, u32 scaled_width,
+                         u32 scaled_height, u64 hash, u32 format) {
+    Poll();
+    if (pending_reads.size() >= MAX_PENDING_READS || !dumped.insert(hash).second)
+        return;
+
+    PendingRead& read = pending_reads.emplace_back();
+    read.path = fmt::format("{}tex1_{}x{}_{:016X}_{}.dds", directory, width, height, hash, format);
+    read.width = scaled_width;
+    read.height = scaled_height;
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_tex = state.texture_units[0].texture_2d;
+    state.texture_units[0].texture_2d = texture;
+    state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+
+    read.pbo.Create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pbo.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, scaled_width * scaled_height * 4, nullptr, GL_STREAM_READ);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    read.fence.Create();
+
+    state.texture_units[0].texture_2d = old_tex;
+    state.Apply();
+}
+
+void TextureDumper::Poll() {
+    while (!pending_reads.empty()) {
+        PendingRead& read = pending_reads.front();
+        const GLenum result = glClientWaitSync(read.fence.handle, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+            return;
+        if (result != GL_WAIT_FAILED)
+            FinishRead(read);
+        pending_reads.pop_front();
+    }
+}
+
+void TextureDumper::FinishRead(PendingRead& read) {
+    PendingWrite write{std::move(read.path), read.width, read.height};
+    write.pixels.resize(static_cast<std::size_t>(read.width) * read.height * 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pbo.handle);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, write.pixels.size(), write.pixels.data());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard lock{mutex};
+        pending_writes.push_back(std::move(write));
+    }
+    queue_cv.notify_one();
+}
+
+void TextureDumper::WriteThread() {
+    Common::SetCurrentThreadName("TextureDumper");
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        queue_cv.wait(lock, [this] { return stop || !pending_writes.empty(); });
+        // Everything queued is still written when stopping
+        if (pending_writes.empty())
+            return;
+        PendingWrite write = std::move(pending_writes.front());
+        pending_writes.pop_front();
+        lock.unlock();
+
+        const auto header = MakeDDSHeader(write.width, write.height);
+        FileUtil::IOFile file(write.path, "wb");
+        if (!file.IsOpen() || file.WriteArray(header.data(), header.size()) != header.size() ||
+            file.WriteBytes(write.pixels.data(), write.pixels.size()) != write.pixels.size()) {
+            LOG_ERROR(Render_OpenGL, "Failed to write the texture dump {}", write.path);
+        }
+
+        lock.lock();
+    }
+}
+
+} // namespace OpenGL
@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Writes every unique texture of a title to dump/textures/<title id>/ as uncompressed RGBA8 DDS
+ * files, named the way TexturePack expects its replacements. Textures are read back into pixel
+ * buffers that are only mapped once the GPU is done with them, and the files are written by a
+ * background thread, so dumping never waits on the GPU or the disk. Rows are written in the
+ * order of the guest data, from the bottom of the image.
+ */
+class TextureDumper {
+public:
+    explicit TextureDumper(u64 title_id);
+    ~TextureDumper();
+
+    /**
+     * Starts reading back a texture if its content hasn't been dumped yet.
+     * @param width,height size of the guest texture, used in the file name
+     * @param scaled_width,scaled_height size of the OpenGL texture, which is what gets dumped
+     */
+    void Dump(GLuint texture, u32 width, u32 height, u32 scaled_width, u32 scaled_height,
+              u64 hash, u32 format);
+
+    /// Hands the read backs the GPU has finished to the writer thread
+    void Poll();
+
+private:
+    /// Read backs in flight, newer dumps are skipped until one completes
+    static constexpr std::size_t MAX_PENDING_READS = 32;
+
+    struct PendingRead {
+        OGLBuffer pbo;
+        OGLSync fence;
+        std::string path;
+        u32 width;
+        u32 height;
+    };
+
+    struct PendingWrite {
+        std::string path;
+        u32 width;
+        u32 height;
+        std::vector<u8> pixels;
+    };
+
+    void FinishRead(PendingRead& read);
+    void WriteThread();
+
+    std::string directory;
+    /// Hashes of the textures dumped, including by earlier sessions
+    std::unordered_set<u64> dumped;
+    std::deque<PendingRead> pending_reads;
+
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::deque<PendingWrite> pending_writes;
+    bool stop = false;
+    std::thread write_thread;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,135 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_filterer.h"
+
+namespace OpenGL {
+
+namespace {
+
+// Must match the local_size declaration of the shader below
+constexpr u32 FILTER_GROUP_SIZE = 8;
+
+// Scale2x compares the neighbours of each source texel and rounds off the corners where two of
+// them match, which keeps the edges of pixel art and text sharp. Every output texel applies the
+// rule of the quadrant of its source texel it falls in, so it works at any scale factor.
+constexpr char scale2x_source[] = R"(
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D source;
+layout(rgba8) uniform writeonly image2D dest;
+
+uniform ivec2 src_origin;
+uniform ivec2 src_size;
+uniform ivec2 dst_origin;
+uniform ivec2 dst_size;
+
+vec4 Fetch(ivec2 pos) {
+    return texelFetch(source, src_origin + clamp(pos, ivec2(0), src_size - 1), 0);
+}
+
+void main() {
+    ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(dst, dst_size))) {
+        return;
+    }
+
+    vec2 pos = (vec2(dst) + 0.5) * vec2(src_size) / vec2(dst_size);
+    ivec2 texel = ivec2(pos);
+    vec2 quadrant = fract(pos);
+
+    vec4 result = Fetch(texel);
+    // Texture rows grow upwards
+    vec4 above = Fetch(texel + ivec2(0, 1));
+    vec4 below = Fetch(texel - ivec2(0, 1));
+    vec4 left = Fetch(texel - ivec2(1, 0));
+    vec4 right = Fetch(texel + ivec2(1, 0));
+    if (above != below && left != right) {
+        vec4 vertical = quadrant.y >= 0.5 ? above : below;
+        vec4 horizontal = quadrant.x >= 0.5 ? right : left;
+        if (vertical == horizontal) {
+            result = vertical;
+        }
+    }
+    imageStore(dest, dst_origin + dst, result);
+}
+)";
+
+} // Anonymous namespace
+
+TextureFilterer::TextureFilterer(Settings::TextureFilter filter) {
+    ASSERT(filter == Settings::TextureFilter::Scale2x);
+
+    OGLShader shader;
+    shader.Create(scale2x_source, GL_COMPUTE_SHADER);
+    program.Create(false, {shader.handle});
+
+    OpenGLState state = OpenGLState::GetCurState();
+    const GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+    glUniform1i(glGetUniformLocation(program.handle, "source"), 0);
+    glUniform1i(glGetUniformLocation(program.handle, "dest"), ImageUnits::TextureCodec);
+    src_origin_u_id = glGetUniformLocation(program.handle, "src_origin");
+    src_size_u_id = glGetUniformLocation(program.handle, "src_size");
+    dst_origin_u_id = glGetUniformLocation(program.handle, "dst_origin");
+    dst_size_u_id = glGetUniformLocation(program.handle, "dst_size");
+    state.draw.shader_program = old_program;
+    state.Apply();
+}
+
+TextureFilterer::~TextureFilterer() = default;
+
+bool TextureFilterer::IsSupported() {
+    return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_image_load_store;
+}
+
+bool TextureFilterer::CanFilter(const SurfaceParams& surface) {
+    return surface.type == SurfaceParams::SurfaceType::Texture;
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureFilter, "OpenGL", "Texture Filter", MP_RGB(64, 192, 128));
+void TextureFilterer::Filter(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rect,
+                             GLuint dst_tex, const MathUtil::Rectangle<u32>& dst_rect) {
+    MICROPROFILE_SCOPE(OpenGL_TextureFilter);
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    state.draw.shader_program = program.handle;
+    state.texture_units[0].texture_2d = src_tex;
+    state.texture_units[0].sampler = 0;
+    state.Apply();
+
+    // The texture decoder's image unit, the two never run at the same time
+    glBindImageTexture(ImageUnits::TextureCodec, dst_tex, 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_RGBA8);
+
+    glUniform2i(src_origin_u_id, static_cast<GLint>(src_rect.left),
+                static_cast<GLint>(src_rect.bottom));
+    glUniform2i(src_size_u_id, static_cast<GLint>(src_rect.GetWidth()),
+                static_cast<GLint>(src_rect.GetHeight()));
+    glUniform2i(dst_origin_u_id, static_cast<GLint>(dst_rect.left),
+                static_cast<GLint>(dst_rect.bottom));
+    glUniform2i(dst_size_u_id, static_cast<GLint>(dst_rect.GetWidth()),
+                static_cast<GLint>(dst_rect.GetHeight()));
+
+    glDispatchCompute((dst_rect.GetWidth() + FILTER_GROUP_SIZE - 1) / FILTER_GROUP_SIZE,
+                      (dst_rect.GetHeight() + FILTER_GROUP_SIZE - 1) / FILTER_GROUP_SIZE, 1);
+
+    // The texture is sampled, blitted or rendered to afterwards
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glBindImageTexture(ImageUnits::TextureCodec, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,50 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Upscales textures to the resolution scale factor with a compute shader. The rasterizer cache
+ * runs it when it loads a texture into a scaled surface, in place of the plain blit, so the filter
+ * costs once per load and the result is sampled like any other surface afterwards.
+ */
+class TextureFilterer : NonCopyable {
+public:
+    explicit TextureFilterer(Settings::TextureFilter filter);
+    ~TextureFilterer();
+
+    /// Whether the driver supports everything the filters need
+    static bool IsSupported();
+
+    /// Whether the surface can be filtered, only the RGBA8 textures of texture formats can
+    static bool CanFilter(const SurfaceParams& surface);
+
+    /**
+     * Upscales a rectangle of a texture into a larger rectangle of another one
+     * @param src_tex texture holding the unscaled texels
+     * @param src_rect rectangle of src_tex to read
+     * @param dst_tex RGBA8 texture that receives the upscaled texels
+     * @param dst_rect rectangle of dst_tex to write
+     */
+    void Filter(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rect, GLuint dst_tex,
+                const MathUtil::Rectangle<u32>& dst_rect);
+
+private:
+    OGLProgram program;
+    GLint src_origin_u_id;
+    GLint src_size_u_id;
+    GLint dst_origin_u_id;
+    GLint dst_size_u_id;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,379 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/swap.h"
+#include "common/thread.h"
+#include "video_core/renderer_opengl/gl_texture_pack.h"
+
+namespace OpenGL {
+
+namespace {
+
+struct CompressedFormat {
+    GLenum internal_format;
+    u32 block_width;
+    u32 block_height;
+    u32 block_size;
+};
+
+constexpr std::array<CompressedFormat, 19> COMPRESSED_FORMATS{{
+    {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 4, 4, 8},
+    {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 4, 4, 8},
+    {GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 4, 4, 16},
+    {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4, 4, 16},
+    {GL_COMPRESSED_RGBA_BPTC_UNORM_ARB, 4, 4, 16},
+    {GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, 16},
+    {GL_COMPRESSED_RGBA_ASTC_5x4_KHR, 5, 4, 16},
+    {GL_COMPRESSED_RGBA_ASTC_5x5_KHR, 5, 5, 16},
+    {GL_COMPRESSED_RGBA_ASTC_6x5_KHR, 6, 5, 16},
+    {GL_COMPRESSED_RGBA_ASTC_6x6_KHR, 6, 6, 16},
+    {GL_COMPRESSED_RGBA_ASTC_8x5_KHR, 8, 5, 16},
+    {GL_COMPRESSED_RGBA_ASTC_8x6_KHR, 8, 6, 16},
+    {GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 8, 8, 16},
+    {GL_COMPRESSED_RGBA_ASTC_10x5_KHR, 10, 5, 16},
+    {GL_COMPRESSED_RGBA_ASTC_10x6_KHR, 10, 6, 16},
+    {GL_COMPRESSED_RGBA_ASTC_10x8_KHR, 10, 8, 16},
+    {GL_COMPRESSED_RGBA_ASTC_10x10_KHR, 10, 10, 16},
+    {GL_COMPRESSED_RGBA_ASTC_12x10_KHR, 12, 10, 16},
+    {GL_COMPRESSED_RGBA_ASTC_12x12_KHR, 12, 12, 16},
+}};
+
+constexpr u32 MAX_TEXTURE_SIZE = 16384;
+constexpr u32 MAX_LEVELS = 15;
+
+const CompressedFormat* GetCompressedFormat(GLenum internal_format) {
+    const auto it = std::find_if(COMPRESSED_FORMATS.begin(), COMPRESSED_FORMATS.end(),
+                                 [internal_format](const CompressedFormat& format) {
+                                     return format.internal_format == internal_format;
+                                 });
+    return it != COMPRESSED_FORMATS.end() ? &*it : nullptr;
+}
+
+/// Fills in everything but the level data, which is left for the container to read
+std::optional<CustomTexture> PrepareTexture(GLenum internal_format, u32 width, u32 height,
+                                            u32 num_levels) {
+    const CompressedFormat* format = GetCompressedFormat(internal_format);
+    if (format == nullptr || width == 0 || height == 0 || width > MAX_TEXTURE_SIZE ||
+        height > MAX_TEXTURE_SIZE) {
+        return std::nullopt;
+    }
+
+    CustomTexture texture{internal_format, width, height};
+    std::size_t offset = 0;
+    for (u32 level = 0; level < std::clamp<u32>(num_levels, 1, MAX_LEVELS); ++level) {
+        const u32 level_width = std::max(width >> level, 1u);
+        const u32 level_height = std::max(height >> level, 1u);
+        const std::size_t size =
+            static_cast<std::size_t>((level_width + format->block_width - 1) /
+                                     format->block_width) *
+            ((level_height + format->block_height - 1) / format->block_height) *
+            format->block_size;
+        texture.levels.push_back({offset, size, level_width, level_height});
+        offset += size;
+        if (level_width == 1 && level_height == 1) {
+            break;
+        }
+    }
+    texture.data.resize(offset);
+    return texture;
+}
+
+u32 Read32(const std::vector<u8>& file, std::size_t offset) {
+    u32_le value;
+    std::memcpy(&value, file.data() + offset, sizeof(value));
+    return value;
+}
+
+// "DDS "
+constexpr u32 DDS_MAGIC = 0x20534444;
+constexpr u32 DDS_HEADER_SIZE = 128;
+constexpr u32 DDS_DX10_HEADER_SIZE = 20;
+constexpr u32 DDSD_MIPMAPCOUNT = 0x20000;
+constexpr u32 DDPF_FOURCC = 0x4;
+
+constexpr u32 MakeFourCC(char a, char b, char c, char d) {
+    return static_cast<u32>(a) | (static_cast<u32>(b) << 8) | (static_cast<u32>(c) << 16) |
+           (static_cast<u32>(d) << 24);
+}
+
+GLenum FormatFromFourCC(u32 four_cc) {
+    switch (four_cc) {
+    case MakeFourCC('D', 'X', 'T', '1'):
+        return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case MakeFourCC('D', 'X', 'T', '3'):
+        return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case MakeFourCC('D', 'X', 'T', '5'):
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    default:
+        return GL_NONE;
+    }
+}
+
+GLenum FormatFromDXGIFormat(u32 dxgi_format) {
+    switch (dxgi_format) {
+    case 71: // DXGI_FORMAT_BC1_UNORM
+    case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+        return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case 74: // DXGI_FORMAT_BC2_UNORM
+    case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+        return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case 77: // DXGI_FORMAT_BC3_UNORM
+    case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case 98: // DXGI_FORMAT_BC7_UNORM
+    case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+        return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+    default:
+        return GL_NONE;
+    }
+}
+
+std::optional<CustomTexture> ParseDDS(const std::vector<u8>& file) {
+    if (file.size() < DDS_HEADER_SIZE || Read32(file, 4) != DDS_HEADER_SIZE - 4) {
+        return std::nullopt;
+    }
+    const u32 flags = Read32(file, 8);
+    const u32 height = Read32(file, 12);
+    const u32 width = Read32(file, 16);
+    const u32 num_levels = flags & DDSD_MIPMAPCOUNT ? Read32(file, 28) : 1;
+    const u32 pixel_flags = Read32(file, 80);
+    const u32 four_cc = Read32(file, 84);
+    if (!(pixel_flags & DDPF_FOURCC)) {
+        return std::nullopt;
+    }
+
+    std::size_t data_offset = DDS_HEADER_SIZE;
+    GLenum internal_format = FormatFromFourCC(four_cc);
+    if (four_cc == MakeFourCC('D', 'X', '1', '0')) {
+        if (file.size() < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) {
+            return std::nullopt;
+        }
+        internal_format = FormatFromDXGIFormat(Read32(file, DDS_HEADER_SIZE));
+        data_offset += DDS_DX10_HEADER_SIZE;
+    }
+
+    std::optional<CustomTexture> texture =
+        PrepareTexture(internal_format, width, height, num_levels);
+    if (!texture || file.size() - data_offset < texture->data.size()) {
+        return std::nullopt;
+    }
+    std::memcpy(texture->data.data(), file.data() + data_offset, texture->data.size());
+    return texture;
+}
+
+constexpr std::array<u8, 12> KTX_IDENTIFIER{
+    {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A}};
+constexpr u32 KTX_HEADER_SIZE = 64;
+constexpr u32 KTX_ENDIANNESS = 0x04030201;
+
+std::optional<CustomTexture> ParseKTX(const std::vector<u8>& file) {
+    if (file.size() < KTX_HEADER_SIZE || Read32(file, 12) != KTX_ENDIANNESS) {
+        return std::nullopt;
+    }
+    const u32 gl_type = Read32(file, 16);
+    const GLenum internal_format = Read32(file, 28);
+    const u32 width = Read32(file, 36);
+    const u32 height = Read32(file, 40);
+    const u32 depth = Read32(file, 44);
+    const u32 num_array_elements = Read32(file, 48);
+    const u32 num_faces = Read32(file, 52);
+    const u32 num_levels = Read32(file, 56);
+    const u32 key_value_size = Read32(file, 60);
+    // Only compressed 2D textures
+    if (gl_type != 0 || depth != 0 || num_array_elements != 0 || num_faces != 1) {
+        return std::nullopt;
+    }
+
+    std::optional<CustomTexture> texture =
+        PrepareTexture(internal_format, width, height, num_levels);
+    if (!texture) {
+        return std::nullopt;
+    }
+
+    // Each level is preceded by its size and padded to 4 bytes
+    std::size_t offset = KTX_HEADER_SIZE + static_cast<std::size_t>(key_value_size);
+    for (const CustomTexture::Level& level : texture->levels) {
+        if (offset > file.size() || file.size() - offset < sizeof(u32) + level.size ||
+            Read32(file, offset) != level.size) {
+            return std::nullopt;
+        }
+        std::memcpy(texture->data.data() + level.offset, file.data() + offset + sizeof(u32),
+                    level.size);
+        offset += sizeof(u32) + (level.size + 3) / 4 * 4;
+    }
+    return texture;
+}
+
+} // Anonymous namespace
+
+std::optional<CustomTexture> ParseCustomTexture(const std::vector<u8>& file) {
+    if (file.size() >= sizeof(u32) && Read32(file, 0) == DDS_MAGIC) {
+        return ParseDDS(file);
+    }
+    if (file.size() >= KTX_IDENTIFIER.size() &&
+        std::equal(KTX_IDENTIFIER.begin(), KTX_IDENTIFIER.end(), file.begin())) {
+        return ParseKTX(file);
+    }
+    return std::nullopt;
+}
+
+bool IsCustomTextureFormatSupported(GLenum internal_format) {
+    switch (internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GLAD_GL_EXT_texture_compression_s3tc;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+        return GLAD_GL_ARB_texture_compression_bptc;
+    default:
+        return GetCompressedFormat(internal_format) != nullptr &&
+               GLAD_GL_KHR_texture_compression_astc_ldr;
+    }
+}
+
+TexturePack::TexturePack(u64 title_id) {
+    const std::string directory =
+        fmt::format("{}textures" DIR_SEP "{:016X}",
+                    FileUtil::GetUserPath(FileUtil::UserPath::LoadDir), title_id);
+    if (!FileUtil::IsDirectory(directory)) {
+        return;
+    }
+
+    Index(directory, 8);
+    LOG_INFO(Render_OpenGL, "Found {} replacement textures for {:016X}", entries.size(),
+             title_id);
+    if (!entries.empty()) {
+        load_thread = std::thread(&TexturePack::LoadThread, this);
+    }
+}
+
+TexturePack::~TexturePack() {
+    if (load_thread.joinable()) {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        queue_cv.notify_one();
+        load_thread.join();
+    }
+}
+
+void TexturePack::Index(const std::string& directory, unsigned int depth) {
+    const auto callback = [this, depth](u64*, const std::string& directory,
+                                        const std::string& virtual_name) {
+        const std::string path = directory + DIR_SEP + virtual_name;
+        if (FileUtil::IsDirectory(path)) {
+            if (depth > 0) {
+                Index(path, depth - 1);
+            }
+            return true;
+        }
+
+        const std::string extension = Common::ToLower(virtual_name.substr(
+            std::min(virtual_name.size(), virtual_name.find_last_of('.'))));
+        u32 width;
+        u32 height;
+        u64 hash;
+        u32 format;
+        if ((extension != ".dds" && extension != ".ktx") ||
+            std::sscanf(virtual_name.c_str(), "tex1_%ux%u_%" SCNx64 "_%u", &width, &height, &hash,
+                        &format) != 4) {
+            return true;
+        }
+
+        Entry entry{path, width, height, format};
+        if (!entries.emplace(hash, std::move(entry)).second) {
+            LOG_WARNING(Render_OpenGL, "Ignoring {}, another texture has the same hash", path);
+        }
+        return true;
+    };
+    FileUtil::ForeachDirectoryEntry(nullptr, directory, callback);
+}
+
+TexturePack::Status TexturePack::Find(u64 hash, u32 width, u32 height, u32 format,
+                                      std::shared_ptr<const CustomTexture>& texture) {
+    // The index itself doesn't change once the pack is opened
+    const auto it = entries.find(hash);
+    if (it == entries.end() || it->second.width != width || it->second.height != height ||
+        it->second.format != format) {
+        return Status::Missing;
+    }
+
+    std::lock_guard lock{mutex};
+    Entry& entry = it->second;
+    if (entry.failed) {
+        return Status::Missing;
+    }
+    if (entry.texture != nullptr) {
+        loaded.splice(loaded.begin(), loaded, entry.loaded_it);
+        texture = entry.texture;
+        return Status::Ready;
+    }
+    if (!entry.queued) {
+        entry.queued = true;
+        queue.push_back(hash);
+        queue_cv.notify_one();
+    }
+    return Status::Loading;
+}
+
+void TexturePack::LoadThread() {
+    Common::SetCurrentThreadName("TexturePack");
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        queue_cv.wait(lock, [this] { return stop || !queue.empty(); });
+        if (stop) {
+            return;
+        }
+        const u64 hash = queue.front();
+        queue.pop_front();
+        Entry& entry = entries.at(hash);
+        lock.unlock();
+
+        std::optional<CustomTexture> texture;
+        {
+            FileUtil::IOFile file(entry.path, "rb");
+            std::vector<u8> data(file.IsOpen() ? file.GetSize() : 0);
+            if (file.IsOpen() && file.ReadBytes(data.data(), data.size()) == data.size()) {
+                texture = ParseCustomTexture(data);
+            }
+        }
+
+        lock.lock();
+        entry.queued = false;
+        if (!texture) {
+            LOG_ERROR(Render_OpenGL, "{} is not a supported DDS or KTX texture", entry.path);
+            entry.failed = true;
+            continue;
+        }
+
+        loaded_bytes += texture->data.size();
+        entry.texture = std::make_shared<const CustomTexture>(std::move(*texture));
+        loaded.push_front(hash);
+        entry.loaded_it = loaded.begin();
+
+        // Textures already uploaded keep their copy in video memory, so evicting them only costs
+        // reading them again if their surface has to be created again
+        while (loaded_bytes > MEMORY_BUDGET && loaded.size() > 1) {
+            Entry& evicted = entries.at(loaded.back());
+            loaded_bytes -= evicted.texture->data.size();
+            evicted.texture.reset();
+            loaded.pop_back();
+        }
+    }
+}
+
+} // namespace OpenGL
@@ -0,0 +1,115 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+
+namespace OpenGL {
+
+/// A replacement texture in a GPU compressed format, uploaded as it is stored on disk
+struct CustomTexture {
+    struct Level {
+        std::size_t offset;
+        std::size_t size;
+        u32 width;
+        u32 height;
+    };
+
+    GLenum internal_format;
+    u32 width;
+    u32 height;
+    /// Mipmap levels, the largest first
+    std::vector<Level> levels;
+    std::vector<u8> data;
+};
+
+/**
+ * Reads a DDS or KTX file holding a BC1, BC2, BC3, BC7 or ASTC texture.
+ * @returns the texture, or std::nullopt if the file is invalid or in another format
+ */
+std::optional<CustomTexture> ParseCustomTexture(const std::vector<u8>& file);
+
+/// Whether the driver can sample textures of a compressed format ParseCustomTexture returns
+bool IsCustomTextureFormatSupported(GLenum internal_format);
+
+/**
+ * Replacement textures for a title, stored in load/textures/<title id>/ as files named
+ * tex1_<width>x<height>_<hash>_<format>.dds (or .ktx), where hash is the 16 hex digits
+ * Common::ComputeHash64 gives for the guest texture data and format is its PixelFormat. Rows
+ * are stored in the order of the guest data, from the bottom of the image, like TextureDumper
+ * writes them.
+ *
+ * Only the file names are read when the pack is opened. Textures are read from disk by a
+ * background thread the first time they are looked up, and at most MEMORY_BUDGET bytes of them
+ * are kept in memory, the least recently used ones being read again if needed.
+ */
+class TexturePack {
+public:
+    enum class Status {
+        /// The pack has no replacement for the texture
+        Missing,
+        /// The replacement is being read, the guest texture should be used meanwhile
+        Loading,
+        Ready,
+    };
+
+    explicit TexturePack(u64 title_id);
+    ~TexturePack();
+
+    /// Whether the pack has no replacements at all
+    bool IsEmpty() const {
+        return entries.empty();
+    }
+
+    /**
+     * Looks up the replacement of a guest texture, queuing it to be read if it isn't in memory.
+     * @param texture set to the replacement when the status is Ready
+     */
+    Status Find(u64 hash, u32 width, u32 height, u32 format,
+                std::shared_ptr<const CustomTexture>& texture);
+
+private:
+    static constexpr std::size_t MEMORY_BUDGET = 256 * 1024 * 1024;
+
+    struct Entry {
+        std::string path;
+        u32 width;
+        u32 height;
+        u32 format;
+        bool queued = false;
+        bool failed = false;
+        std::shared_ptr<const CustomTexture> texture;
+        /// Position in loaded, valid while texture is set
+        std::list<u64>::iterator loaded_it;
+    };
+
+    void Index(const std::string& directory, unsigned int depth);
+    void LoadThread();
+
+    std::unordered_map<u64, Entry> entries;
+
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::deque<u64> queue;
+    /// Hashes of the entries in memory, the most recently used first
+    std::list<u64> loaded;
+    std::size_t loaded_bytes = 0;
+    bool stop = false;
+    std::thread load_thread;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,234 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <tuple>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_y2r_converter.h"
+
+namespace OpenGL {
+
+namespace {
+
+using Service::Y2R::ConversionConfiguration;
+using Service::Y2R::InputFormat;
+using Service::Y2R::Rotation;
+
+// Large enough for the input of a 1024x1024 YUYV image
+constexpr GLsizeiptr UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024;
+
+constexpr char vs_source[] = R"(
+#version 330 core
+const vec2 vertices[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+void main() {
+    gl_Position = vec4(vertices[gl_VertexID], 0.0, 1.0);
+}
+)";
+
+// The format uniform uses the OutputFormat values, the result is bit-exact with the CPU conversion
+constexpr char fs_source[] = R"(
+#version 330 core
+
+uniform usamplerBuffer source;
+
+uniform ivec2 viewport_origin;
+uniform int res_scale;
+uniform int lines;
+// Tiled surfaces store the first line at the top
+uniform bool flip;
+
+// Offsets in bytes of the components of a pixel in source, for a line and column
+uniform int y_offset;
+uniform int y_step;
+uniform int y_line;
+uniform int u_offset;
+uniform int v_offset;
+uniform int chroma_step;
+uniform int chroma_line;
+uniform int chroma_shift;
+
+uniform int coefficients[8];
+uniform int format;
+uniform int alpha;
+
+out vec4 color;
+
+int ReadByte(int offset) {
+    return int(texelFetch(source, offset).r);
+}
+
+void main() {
+    ivec2 pixel = (ivec2(gl_FragCoord.xy) - viewport_origin) / res_scale;
+    int line = flip ? lines - 1 - pixel.y : pixel.y;
+
+    int Y = ReadByte(y_offset + line * y_line + pixel.x * y_step);
+    int chroma = (line >> chroma_shift) * chroma_line + (pixel.x >> 1) * chroma_step;
+    int U = ReadByte(u_offset + chroma);
+    int V = ReadByte(v_offset + chroma);
+
+    int cY = coefficients[0] * Y;
+    ivec3 rgb = ivec3(cY + coefficients[1] * V, cY - coefficients[2] * V - coefficients[3] * U,
+                      cY + coefficients[4] * U);
+    rgb = (rgb >> 3) + ivec3(coefficients[5], coefficients[6], coefficients[7]) + 0x18;
+    rgb = clamp(rgb >> 5, 0, 255);
+
+    switch (format) {
+    case 0: // RGBA8
+        color = vec4(vec3(rgb), float(alpha)) / 255.0;
+        break;
+    case 1: // RGB8
+        color = vec4(vec3(rgb) / 255.0, 1.0);
+        break;
+    case 2: // RGB5A1
+        color = vec4(vec3(rgb >> 3) / 31.0, float(alpha >> 7));
+        break;
+    default: // RGB565
+        color = vec4(vec3(rgb >> ivec3(3, 2, 3)) / vec3(31.0, 63.0, 31.0), 1.0);
+        break;
+    }
+}
+)";
+
+} // Anonymous namespace
+
+Y2RConverter::Y2RConverter() : upload_buffer(GL_TEXTURE_BUFFER, UPLOAD_BUFFER_SIZE, false) {
+    GLint max_texture_buffer_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_size);
+    if (max_texture_buffer_size < UPLOAD_BUFFER_SIZE) {
+        LOG_WARNING(Render_OpenGL, "Texture buffers are too small for the Y2R converter");
+        return;
+    }
+
+    program.Create(vs_source, fs_source);
+    attributeless_vao.Create();
+    draw_framebuffer.Create();
+
+    upload_tbo.Create();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, upload_tbo.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, upload_buffer.GetHandle());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+
+    glUniform1i(glGetUniformLocation(program.handle, "source"), 0);
+    viewport_origin_u_id = glGetUniformLocation(program.handle, "viewport_origin");
+    res_scale_u_id = glGetUniformLocation(program.handle, "res_scale");
+    lines_u_id = glGetUniformLocation(program.handle, "lines");
+    flip_u_id = glGetUniformLocation(program.handle, "flip");
+    y_offset_u_id = glGetUniformLocation(program.handle, "y_offset");
+    y_step_u_id = glGetUniformLocation(program.handle, "y_step");
+    y_line_u_id = glGetUniformLocation(program.handle, "y_line");
+    u_offset_u_id = glGetUniformLocation(program.handle, "u_offset");
+    v_offset_u_id = glGetUniformLocation(program.handle, "v_offset");
+    chroma_step_u_id = glGetUniformLocation(program.handle, "chroma_step");
+    chroma_line_u_id = glGetUniformLocation(program.handle, "chroma_line");
+    chroma_shift_u_id = glGetUniformLocation(program.handle, "chroma_shift");
+    coefficients_u_id = glGetUniformLocation(program.handle, "coefficients");
+    format_u_id = glGetUniformLocation(program.handle, "format");
+    alpha_u_id = glGetUniformLocation(program.handle, "alpha");
+
+    state.draw.shader_program = old_program;
+    state.Apply();
+
+    valid = true;
+}
+
+Y2RConverter::~Y2RConverter() = default;
+
+bool Y2RConverter::CanConvert(const ConversionConfiguration& cvt) {
+    // Rotations apply to each strip rather than the whole image, so the output of a rotated
+    // conversion isn't an image that could be used as a surface
+    return cvt.rotation == Rotation::None && cvt.input_line_width != 0 &&
+           cvt.input_line_width % 8 == 0 && cvt.input_line_width <= 1024 &&
+           cvt.input_lines != 0 && cvt.input_lines % 8 == 0 &&
+           HW::Y2R::GetInputSize(cvt) <= UPLOAD_BUFFER_SIZE && HW::Y2R::IsOutputContiguous(cvt);
+}
+
+MICROPROFILE_DEFINE(OpenGL_Y2R, "OpenGL", "Y2R Conversion", MP_RGB(192, 128, 64));
+void Y2RConverter::Convert(ConversionConfiguration& cvt, GLuint dst_tex,
+                           const MathUtil::Rectangle<u32>& dst_rect, u16 res_scale,
+                           bool is_tiled) {
+    ASSERT(CanConvert(cvt));
+    MICROPROFILE_SCOPE(OpenGL_Y2R);
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    const u32 input_size = HW::Y2R::GetInputSize(cvt);
+    glBindBuffer(GL_TEXTURE_BUFFER, upload_buffer.GetHandle());
+    u8* buffer_ptr;
+    GLintptr buffer_offset;
+    std::tie(buffer_ptr, buffer_offset, std::ignore) = upload_buffer.Map(input_size, 4);
+    HW::Y2R::ReceiveInput(cvt, buffer_ptr);
+    upload_buffer.Unmap(input_size);
+    HW::Y2R::SkipOutput(cvt);
+
+    OpenGLState state;
+    state.draw.draw_framebuffer = draw_framebuffer.handle;
+    state.draw.shader_program = program.handle;
+    state.draw.vertex_array = attributeless_vao.handle;
+    state.viewport.x = static_cast<GLint>(dst_rect.left);
+    state.viewport.y = static_cast<GLint>(dst_rect.bottom);
+    state.viewport.width = static_cast<GLsizei>(dst_rect.GetWidth());
+    state.viewport.height = static_cast<GLsizei>(dst_rect.GetHeight());
+    state.Apply();
+
+    // Layout of the planes written by ReceiveInput
+    const GLint width = cvt.input_line_width;
+    const GLint lines = cvt.input_lines;
+    const GLint base = static_cast<GLint>(buffer_offset);
+    if (cvt.input_format == InputFormat::YUYV422_Interleaved) {
+        glUniform1i(y_offset_u_id, base);
+        glUniform1i(y_step_u_id, 2);
+        glUniform1i(y_line_u_id, width * 2);
+        glUniform1i(u_offset_u_id, base + 1);
+        glUniform1i(v_offset_u_id, base + 3);
+        glUniform1i(chroma_step_u_id, 4);
+        glUniform1i(chroma_line_u_id, width * 2);
+        glUniform1i(chroma_shift_u_id, 0);
+    } else {
+        const bool yuv420 = cvt.input_format == InputFormat::YUV420_Indiv8 ||
+                            cvt.input_format == InputFormat::YUV420_Indiv16;
+        const GLint chroma_size = width * lines / (yuv420 ? 4 : 2);
+        glUniform1i(y_offset_u_id, base);
+        glUniform1i(y_step_u_id, 1);
+        glUniform1i(y_line_u_id, width);
+        glUniform1i(u_offset_u_id, base + width * lines);
+        glUniform1i(v_offset_u_id, base + width * lines + chroma_size);
+        glUniform1i(chroma_step_u_id, 1);
+        glUniform1i(chroma_line_u_id, width / 2);
+        glUniform1i(chroma_shift_u_id, yuv420 ? 1 : 0);
+    }
+
+    GLint coefficients[8];
+    std::copy(cvt.coefficients.begin(), cvt.coefficients.end(), coefficients);
+    glUniform1iv(coefficients_u_id, 8, coefficients);
+    glUniform2i(viewport_origin_u_id, state.viewport.x, state.viewport.y);
+    glUniform1i(res_scale_u_id, res_scale);
+    glUniform1i(lines_u_id, lines);
+    glUniform1i(flip_u_id, is_tiled ? GL_TRUE : GL_FALSE);
+    glUniform1i(format_u_id, static_cast<GLint>(cvt.output_format));
+    glUniform1i(alpha_u_id, cvt.alpha & 0xFF);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, upload_tbo.handle);
+
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_tex, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+} // namespace OpenGL
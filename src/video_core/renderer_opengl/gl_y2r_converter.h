@@ -0,0 +1,76 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+
+namespace Service::Y2R {
+struct ConversionConfiguration;
+}
+
+namespace OpenGL {
+
+/**
+ * Performs Y2R conversions with a fragment shader, drawing the RGB output straight into a surface
+ * texture. The YUV input is read from 3DS memory like the CPU conversion does and streamed to the
+ * GPU through a texture buffer, the colorspace conversion uses the same fixed point math as
+ * HW::Y2R::PerformConversion.
+ */
+class Y2RConverter : NonCopyable {
+public:
+    Y2RConverter();
+    ~Y2RConverter();
+
+    /// Whether the driver limits allow the conversion of the largest images
+    bool IsValid() const {
+        return valid;
+    }
+
+    /// Whether the conversion can be done by Convert, its output being a whole surface region
+    static bool CanConvert(const Service::Y2R::ConversionConfiguration& cvt);
+
+    /**
+     * Converts a whole image, advancing the buffers of the conversion like the CPU does
+     * @param cvt the conversion, CanConvert must be true for it
+     * @param dst_tex texture of the surface holding the output
+     * @param dst_rect scaled rectangle of the output in dst_tex
+     * @param res_scale resolution scale of the surface
+     * @param is_tiled whether the surface is tiled, which stores the first line at the top
+     */
+    void Convert(Service::Y2R::ConversionConfiguration& cvt, GLuint dst_tex,
+                 const MathUtil::Rectangle<u32>& dst_rect, u16 res_scale, bool is_tiled);
+
+private:
+    bool valid = false;
+
+    OGLStreamBuffer upload_buffer;
+    OGLTexture upload_tbo;
+
+    OGLVertexArray attributeless_vao;
+    OGLFramebuffer draw_framebuffer;
+
+    OGLProgram program;
+    GLint viewport_origin_u_id;
+    GLint res_scale_u_id;
+    GLint lines_u_id;
+    GLint flip_u_id;
+    GLint y_offset_u_id;
+    GLint y_step_u_id;
+    GLint y_line_u_id;
+    GLint u_offset_u_id;
+    GLint v_offset_u_id;
+    GLint chroma_step_u_id;
+    GLint chroma_line_u_id;
+    GLint chroma_shift_u_id;
+    GLint coefficients_u_id;
+    GLint format_u_id;
+    GLint alpha_u_id;
+};
+
+} // namespace OpenGL
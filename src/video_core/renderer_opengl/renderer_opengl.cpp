@@ -5,22 +5,28 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <optional>
+#include <tuple>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/swap.h"
 #include "core/core.h"
-#include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
 #include "core/hw/gpu.h"
-#include "core/hw/hw.h"
-#include "core/hw/lcd.h"
 #include "core/memory.h"
 #include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_frame_mailbox.h"
+#include "video_core/renderer_opengl/gl_gpu_timer.h"
+#include "video_core/renderer_opengl/gl_perf_overlay.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
 
@@ -84,6 +90,39 @@ struct ScreenRectVertex {
  * The projection part of the matrix is trivial, hence these operations are represented
  * by a 3x2 matrix.
  */
+/// Size of the ring the framebuffers are uploaded through, enough for a few frames of all screens
+constexpr GLsizeiptr UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024;
+
+/**
+ * Converts RGB8 pixels, stored as B, G, R bytes, to RGBA8 bytes. Drivers convert 24-bit uploads on
+ * the CPU one pixel at a time, this converts four pixels from three words at a time.
+ */
+static void ConvertBGR8ToRGBA8(const u8* source, u8* dest, std::size_t num_pixels) {
+    std::size_t i = 0;
+    for (; i + 4 <= num_pixels; i += 4) {
+        u32 in[3];
+        std::memcpy(in, source + i * 3, sizeof(in));
+        const u32 pixels[4] = {
+            in[0] & 0xFFFFFF,
+            (in[0] >> 24) | ((in[1] & 0xFFFF) << 8),
+            (in[1] >> 16) | ((in[2] & 0xFF) << 16),
+            in[2] >> 8,
+        };
+        u32 out[4];
+        for (std::size_t j = 0; j < 4; ++j) {
+            // Reverses the three color bytes and sets the alpha byte
+            out[j] = (Common::swap32(pixels[j]) >> 8) | 0xFF000000;
+        }
+        std::memcpy(dest + i * 4, out, sizeof(out));
+    }
+    for (; i < num_pixels; ++i) {
+        dest[i * 4 + 0] = source[i * 3 + 2];
+        dest[i * 4 + 1] = source[i * 3 + 1];
+        dest[i * 4 + 2] = source[i * 3 + 0];
+        dest[i * 4 + 3] = 0xFF;
+    }
+}
+
 static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, const float height) {
     std::array<GLfloat, 3 * 2> matrix; // Laid out in column-major order
 
@@ -96,29 +135,65 @@ static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, cons
     return matrix;
 }
 
-RendererOpenGL::RendererOpenGL(EmuWindow& window) : RendererBase{window} {}
-RendererOpenGL::~RendererOpenGL() = default;
+RendererOpenGL::RendererOpenGL(EmuWindow& window) : RendererBase{window} {
+    settings_callback_id = Settings::AddSnapshotCallback(
+        Settings::SnapshotChange::Display,
+        [this](u32, const Settings::Snapshot&) { bg_color_update_requested = true; });
+}
+
+RendererOpenGL::~RendererOpenGL() {
+    Settings::RemoveSnapshotCallback(settings_callback_id);
+    if (frame_mailbox) {
+        // The window owns the mailbox and deletes the rest with the presenting context
+        frame_mailbox->ReleaseRenderResources();
+    }
+}
 
 /// Swap buffers (render frame)
-void RendererOpenGL::SwapBuffers() {
+void RendererOpenGL::SwapBuffers(const ScreenConfig& config) {
+    if (config.skip) {
+        // The rasterizer still ends its frame, its resolution budget counts the work per frame
+        Rasterizer()->NotifyFramePresented();
+        RefreshRasterizerSetting();
+        if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+            Pica::g_debug_context->recorder->FrameFinished();
+        }
+        return;
+    }
+
+    auto& perf_stats = Core::System::GetInstance().perf_stats;
+    std::optional<Core::PerfStats::ScopedPhase> present_phase;
+    present_phase.emplace(perf_stats, Core::FramePhase::Present);
+
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
+    // Screens that aren't drawn aren't loaded either, which spares flushing their framebuffers
+    // from the rasterizer cache. They're loaded again on the first frame they show up in.
+    const Layout::FramebufferLayout& layout = render_window.GetFramebufferLayout();
+    bool top_visible = layout.IsTopScreenVisible();
+    bool bottom_visible = layout.IsBottomScreenVisible();
+    if (VideoCore::g_renderer_screenshot_requested) {
+        const Layout::FramebufferLayout& screenshot_layout =
+            VideoCore::g_screenshot_framebuffer_layout;
+        top_visible = top_visible || screenshot_layout.IsTopScreenVisible();
+        bottom_visible = bottom_visible || screenshot_layout.IsBottomScreenVisible();
+    }
+    const bool right_eye_visible = top_visible && Settings::GetSnapshot().toggle_3d;
+
     for (int i : {0, 1, 2}) {
-        int fb_id = i == 2 ? 1 : 0;
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
+        if (!(i == 0 ? top_visible : i == 1 ? right_eye_visible : bottom_visible))
+            continue;
 
-        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
-        u32 lcd_color_addr =
-            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill = {0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
+        int fb_id = i == 2 ? 1 : 0;
+        const auto& framebuffer = config.framebuffers[fb_id];
+        const auto& color_fill = config.color_fills[fb_id];
 
         if (color_fill.is_enabled) {
             LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
                                        screen_infos[i].texture);
+            screen_infos[i].framebuffer_hash = 0;
 
             // Resize the texture in case the framebuffer size has changed
             screen_infos[i].texture.width = 1;
@@ -131,6 +206,7 @@ void RendererOpenGL::SwapBuffers() {
                 // This is expected to not happen very often and hence should not be a
                 // performance problem.
                 ConfigureFramebufferTexture(screen_infos[i].texture, framebuffer);
+                screen_infos[i].framebuffer_hash = 0;
             }
             LoadFBToScreenInfo(framebuffer, screen_infos[i], i == 1);
 
@@ -148,19 +224,21 @@ void RendererOpenGL::SwapBuffers() {
         state.draw.read_framebuffer = state.draw.draw_framebuffer = screenshot_framebuffer.handle;
         state.Apply();
 
-        Layout::FramebufferLayout layout{VideoCore::g_screenshot_framebuffer_layout};
+        const Layout::FramebufferLayout& screenshot_layout =
+            VideoCore::g_screenshot_framebuffer_layout;
 
         GLuint renderbuffer;
         glGenRenderbuffers(1, &renderbuffer);
         glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, layout.width, layout.height);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, screenshot_layout.width,
+                              screenshot_layout.height);
         glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
                                   renderbuffer);
 
-        DrawScreens(layout);
+        DrawScreens(screenshot_layout);
 
-        glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
-                     VideoCore::g_screenshot_bits);
+        glReadPixels(0, 0, screenshot_layout.width, screenshot_layout.height, GL_BGRA,
+                     GL_UNSIGNED_INT_8_8_8_8_REV, VideoCore::g_screenshot_bits);
 
         screenshot_framebuffer.Release();
         state.draw.read_framebuffer = old_read_fb;
@@ -172,17 +250,40 @@ void RendererOpenGL::SwapBuffers() {
         VideoCore::g_renderer_screenshot_requested = false;
     }
 
-    DrawScreens(render_window.GetFramebufferLayout());
-
-    Core::System::GetInstance().perf_stats.EndSystemFrame();
+    if (frame_mailbox) {
+        // Hand the frame over to the frontend, which presents it on its own thread
+        OGLFrameMailbox::Frame* frame = frame_mailbox->GetRenderFrame(layout.width, layout.height);
+        state.draw.draw_framebuffer = frame->render_fbo.handle;
+        state.Apply();
+        {
+            ScopedGPUTimer present_timer(GPUPass::Present);
+            DrawScreens(layout);
+            DrawPerfOverlay(layout);
+        }
+        state.draw.draw_framebuffer = 0;
+        state.Apply();
+        frame_mailbox->ReleaseRenderFrame(frame);
+
+        render_window.PollEvents();
+        render_window.OnFrameReady();
+    } else {
+        {
+            ScopedGPUTimer present_timer(GPUPass::Present);
+            DrawScreens(layout);
+            DrawPerfOverlay(layout);
+        }
 
-    // Swap buffers
-    render_window.PollEvents();
-    render_window.SwapBuffers();
+        // Swap buffers
+        render_window.PollEvents();
+        render_window.SwapBuffers();
+    }
+    gpu_timer->EndFrame();
+    present_phase.reset();
+    perf_stats.AddPresent();
+    Rasterizer()->NotifyFramePresented();
 
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(
-        Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
-    Core::System::GetInstance().perf_stats.BeginSystemFrame();
+    const OpenGLState::ApplyStats state_stats = OpenGLState::GetAndResetApplyStats();
+    perf_stats.AddGLStateStats(state_stats.applies, state_stats.groups_skipped);
 
     prev_state.Apply();
     RefreshRasterizerSetting();
@@ -226,10 +327,33 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
         screen_info.display_texture = screen_info.texture.resource.handle;
         screen_info.display_texcoords = MathUtil::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
 
-        Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * framebuffer.height);
+        const std::size_t framebuffer_size = framebuffer.stride * framebuffer.height;
+        Memory::RasterizerFlushRegion(framebuffer_addr, static_cast<u32>(framebuffer_size));
 
         const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
 
+        // Frames drawn on the CPU often stay the same for many vblanks, e.g. on the screen a
+        // title doesn't animate, so the texture is only loaded when the framebuffer changed
+        const u64 hash = Common::ComputeHash64(framebuffer_data, framebuffer_size);
+        if (hash == screen_info.framebuffer_hash)
+            return;
+        screen_info.framebuffer_hash = hash;
+
+        // RGB8 is converted to RGBA8, which the drivers don't have to convert themselves
+        const bool convert = framebuffer.color_format == GPU::Regs::PixelFormat::RGB8;
+        const std::size_t upload_size =
+            convert ? pixel_stride * framebuffer.height * 4 : framebuffer_size;
+        const auto copy_pixels = [&](u8* dest) {
+            if (!convert) {
+                std::memcpy(dest, framebuffer_data, framebuffer_size);
+                return;
+            }
+            for (std::size_t y = 0; y < framebuffer.height; ++y) {
+                ConvertBGR8ToRGBA8(framebuffer_data + y * framebuffer.stride,
+                                   dest + y * pixel_stride * 4, framebuffer.width);
+            }
+        };
+
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
 
@@ -241,9 +365,29 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
         //       they differ from the LCD resolution.
         // TODO: Applications could theoretically crash Citra here by specifying too large
         //       framebuffer sizes. We should make sure that this cannot happen.
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
-                        screen_info.texture.gl_format, screen_info.texture.gl_type,
-                        framebuffer_data);
+        if (upload_buffer && upload_size <= static_cast<std::size_t>(UPLOAD_BUFFER_SIZE)) {
+            // Copied to the upload ring, so that the driver transfers the pixels to the texture
+            // asynchronously instead of before glTexSubImage2D returns
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_buffer->GetHandle());
+            u8* upload_ptr;
+            GLintptr upload_offset;
+            std::tie(upload_ptr, upload_offset, std::ignore) = upload_buffer->Map(upload_size, 4);
+            copy_pixels(upload_ptr);
+            upload_buffer->Unmap(upload_size);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
+                            screen_info.texture.gl_format, screen_info.texture.gl_type,
+                            reinterpret_cast<const void*>(upload_offset));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            const u8* pixels = framebuffer_data;
+            if (convert) {
+                upload_staging.resize(upload_size);
+                copy_pixels(upload_staging.data());
+                pixels = upload_staging.data();
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
+                            screen_info.texture.gl_format, screen_info.texture.gl_type, pixels);
+        }
 
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
@@ -275,8 +419,8 @@ void RendererOpenGL::LoadColorToActiveGLTexture(u8 color_r, u8 color_g, u8 color
  * Initializes the OpenGL state and creates persistent objects.
  */
 void RendererOpenGL::InitOpenGLObjects() {
-    glClearColor(Settings::values.bg_red, Settings::values.bg_green, Settings::values.bg_blue,
-                 0.0f);
+    const Settings::Snapshot& settings = Settings::GetSnapshot();
+    glClearColor(settings.bg_red, settings.bg_green, settings.bg_blue, 0.0f);
 
     // Link shaders and get variable locations
     shader.Create(vertex_shader, fragment_shader);
@@ -329,6 +473,15 @@ void RendererOpenGL::InitOpenGLObjects() {
 
     state.texture_units[0].texture_2d = 0;
     state.Apply();
+
+    if (GLAD_GL_ARB_buffer_storage) {
+        upload_buffer =
+            std::make_unique<OGLStreamBuffer>(GL_PIXEL_UNPACK_BUFFER, UPLOAD_BUFFER_SIZE, false);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    perf_overlay = std::make_unique<PerfOverlay>();
+    gpu_timer = std::make_unique<GPUTimer>();
 }
 
 void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
@@ -348,12 +501,13 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
         break;
 
     case GPU::Regs::PixelFormat::RGB8:
-        // This pixel format uses BGR since GL_UNSIGNED_BYTE specifies byte-order, unlike every
-        // specific OpenGL type used in this function using native-endian (that is, little-endian
-        // mostly everywhere) for words or half-words.
+        // This pixel format is stored as B, G, R bytes. LoadFBToScreenInfo converts it to R, G, B,
+        // A bytes, as GL_UNSIGNED_BYTE specifies byte-order, unlike every specific OpenGL type
+        // used in this function using native-endian (that is, little-endian mostly everywhere)
+        // for words or half-words.
         // TODO: check how those behave on big-endian processors.
         internal_format = GL_RGB;
-        texture.gl_format = GL_BGR;
+        texture.gl_format = GL_RGBA;
         texture.gl_type = GL_UNSIGNED_BYTE;
         break;
 
@@ -419,10 +573,10 @@ void RendererOpenGL::DrawSingleScreenRotated(const ScreenInfo& screen_info, floa
  * Draws the emulated screens to the emulator window.
  */
 void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
-    if (VideoCore::g_renderer_bg_color_update_requested.exchange(false)) {
+    const Settings::Snapshot& settings = Settings::GetSnapshot();
+    if (bg_color_update_requested.exchange(false)) {
         // Update background color before drawing
-        glClearColor(Settings::values.bg_red, Settings::values.bg_green, Settings::values.bg_blue,
-                     0.0f);
+        glClearColor(settings.bg_red, settings.bg_green, settings.bg_blue, 0.0f);
     }
 
     const auto& top_screen = layout.top_screen;
@@ -440,8 +594,8 @@ void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
     glActiveTexture(GL_TEXTURE0);
     glUniform1i(uniform_color_texture, 0);
 
-    if (layout.top_screen_enabled) {
-        if (!Settings::values.toggle_3d) {
+    if (layout.IsTopScreenVisible()) {
+        if (!settings.toggle_3d) {
             DrawSingleScreenRotated(screen_infos[0], (float)top_screen.left, (float)top_screen.top,
                                     (float)top_screen.GetWidth(), (float)top_screen.GetHeight());
         } else {
@@ -454,8 +608,8 @@ void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
                                     (float)top_screen.GetHeight());
         }
     }
-    if (layout.bottom_screen_enabled) {
-        if (!Settings::values.toggle_3d) {
+    if (layout.IsBottomScreenVisible()) {
+        if (!settings.toggle_3d) {
             DrawSingleScreenRotated(screen_infos[2], (float)bottom_screen.left,
                                     (float)bottom_screen.top, (float)bottom_screen.GetWidth(),
                                     (float)bottom_screen.GetHeight());
@@ -473,6 +627,17 @@ void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
     m_current_frame++;
 }
 
+/**
+ * Draws the performance overlay over the screens, if enabled. The frame samples are consumed
+ * either way, so that the overlay starts with recent ones when it gets enabled.
+ */
+void RendererOpenGL::DrawPerfOverlay(const Layout::FramebufferLayout& layout) {
+    perf_overlay->Update(Core::System::GetInstance().perf_stats);
+    if (Settings::GetSnapshot().show_perf_overlay) {
+        perf_overlay->Draw(layout);
+    }
+}
+
 /// Updates the framerate
 void RendererOpenGL::UpdateFramerate() {}
 
@@ -561,6 +726,12 @@ Core::System::ResultStatus RendererOpenGL::Init() {
 
     InitOpenGLObjects();
 
+    if (render_window.IsPresentationDecoupled()) {
+        auto mailbox = std::make_unique<OGLFrameMailbox>();
+        frame_mailbox = mailbox.get();
+        render_window.SetFrameMailbox(std::move(mailbox));
+    }
+
     RefreshRasterizerSetting();
 
     return Core::System::ResultStatus::Success;
@@ -5,6 +5,10 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
@@ -19,6 +23,11 @@ struct FramebufferLayout;
 
 namespace OpenGL {
 
+class GPUTimer;
+class OGLFrameMailbox;
+class OGLStreamBuffer;
+class PerfOverlay;
+
 /// Structure used for storing information about the textures for each 3DS screen
 struct TextureInfo {
     OGLTexture resource;
@@ -34,6 +43,8 @@ struct ScreenInfo {
     GLuint display_texture;
     MathUtil::Rectangle<float> display_texcoords;
     TextureInfo texture;
+    /// Hash of the guest framebuffer last loaded into the texture, 0 when it holds anything else
+    u64 framebuffer_hash = 0;
 };
 
 class RendererOpenGL : public RendererBase {
@@ -42,7 +53,7 @@ public:
     ~RendererOpenGL() override;
 
     /// Swap buffers (render frame)
-    void SwapBuffers() override;
+    void SwapBuffers(const ScreenConfig& config) override;
 
     /// Initialize the renderer
     Core::System::ResultStatus Init() override;
@@ -55,6 +66,7 @@ private:
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const GPU::Regs::FramebufferConfig& framebuffer);
     void DrawScreens(const Layout::FramebufferLayout& layout);
+    void DrawPerfOverlay(const Layout::FramebufferLayout& layout);
     void DrawSingleScreenRotated(const ScreenInfo& screen_info, float x, float y, float w, float h);
     void UpdateFramerate();
 
@@ -82,6 +94,21 @@ private:
     // Shader attribute input indices
     GLuint attrib_position;
     GLuint attrib_tex_coord;
+
+    std::unique_ptr<PerfOverlay> perf_overlay;
+    std::unique_ptr<GPUTimer> gpu_timer;
+
+    /// Ring the framebuffers read from guest memory are uploaded through, if supported
+    std::unique_ptr<OGLStreamBuffer> upload_buffer;
+    /// Holds the converted framebuffers without an upload ring
+    std::vector<u8> upload_staging;
+
+    /// Where frames are drawn when the frontend presents them itself, otherwise nullptr
+    OGLFrameMailbox* frame_mailbox = nullptr;
+
+    /// Set when the background color changes, which is applied on the next frame
+    std::atomic<bool> bg_color_update_requested{false};
+    std::size_t settings_callback_id;
 };
 
 } // namespace OpenGL
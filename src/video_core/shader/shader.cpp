@@ -7,15 +7,16 @@
 #include "common/bit_set.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/settings.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_shader.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_disk_cache.h"
 #include "video_core/shader/shader_interpreter.h"
 #ifdef ARCHITECTURE_x86_64
 #include "video_core/shader/shader_jit_x64.h"
 #endif // ARCHITECTURE_x86_64
-#include "video_core/video_core.h"
 
 namespace Pica {
 
@@ -140,13 +141,15 @@ MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 static std::unique_ptr<JitX64Engine> jit_engine;
 #endif // ARCHITECTURE_x86_64
 static InterpreterEngine interpreter_engine;
+static std::unique_ptr<ProgramDiskCache> program_disk_cache;
 
 ShaderEngine* GetEngine() {
 #ifdef ARCHITECTURE_x86_64
     // TODO(yuriks): Re-initialize on each change rather than being persistent
-    if (VideoCore::g_shader_jit_enabled) {
+    if (Settings::GetSnapshot().use_shader_jit) {
         if (jit_engine == nullptr) {
             jit_engine = std::make_unique<JitX64Engine>();
+            jit_engine->SetDiskCache(program_disk_cache.get());
         }
         return jit_engine.get();
     }
@@ -158,6 +161,33 @@ ShaderEngine* GetEngine() {
 void Shutdown() {
 #ifdef ARCHITECTURE_x86_64
     jit_engine = nullptr;
+#endif // ARCHITECTURE_x86_64
+    program_disk_cache = nullptr;
+}
+
+void LoadDiskCache(u64 title_id) {
+#ifdef ARCHITECTURE_x86_64
+    if (jit_engine != nullptr) {
+        jit_engine->SetDiskCache(nullptr);
+    }
+#endif // ARCHITECTURE_x86_64
+    program_disk_cache = nullptr;
+
+    if (!Settings::GetSnapshot().use_disk_shader_cache) {
+        return;
+    }
+
+    program_disk_cache = std::make_unique<ProgramDiskCache>(title_id);
+    std::vector<CachedProgram> programs = program_disk_cache->Load();
+
+#ifdef ARCHITECTURE_x86_64
+    // The programs are only recorded and precompiled for the JIT, the interpreter has no
+    // compilation step to save
+    if (Settings::GetSnapshot().use_shader_jit) {
+        auto* engine = static_cast<JitX64Engine*>(GetEngine());
+        engine->SetDiskCache(program_disk_cache.get());
+        engine->Precompile(std::move(programs));
+    }
 #endif // ARCHITECTURE_x86_64
 }
 
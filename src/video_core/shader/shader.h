@@ -256,12 +256,29 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader for several independent invocations. Engines override this
+     * to pay their per-call overhead once for the whole batch instead of once per vertex.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states of the invocations, each setup with its input data.
+     * @param count Number of invocations in states.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) {
+            Run(setup, states[i]);
+        }
+    }
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
 ShaderEngine* GetEngine();
 void Shutdown();
 
+/// Opens the stored shader programs of a title and precompiles them if the shader JIT is in use
+void LoadDiskCache(u64 title_id);
+
 } // namespace Shader
 
 } // namespace Pica
@@ -0,0 +1,157 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "video_core/shader/shader_disk_cache.h"
+
+namespace Pica {
+namespace Shader {
+
+namespace {
+
+// "CPSC" - Citra PICA Shader Cache
+constexpr u32 CACHE_MAGIC = 0x43535043;
+// Bump this whenever the layout of the file changes
+constexpr u32 CACHE_VERSION = 1;
+
+struct FileHeader {
+    u32 magic;
+    u32 version;
+};
+static_assert(sizeof(FileHeader) == 8, "FileHeader has incorrect size");
+
+struct EntryHeader {
+    u32 code_words;
+    u32 swizzle_words;
+};
+static_assert(sizeof(EntryHeader) == 8, "EntryHeader has incorrect size");
+
+FileHeader MakeHeader() {
+    return {CACHE_MAGIC, CACHE_VERSION};
+}
+
+/// Number of words up to the last non-zero one, programs rarely fill the whole code memory
+template <std::size_t N>
+u32 GetUsedWords(const std::array<u32, N>& words) {
+    const auto last = std::find_if(words.rbegin(), words.rend(), [](u32 word) { return word; });
+    return static_cast<u32>(words.rend() - last);
+}
+
+} // Anonymous namespace
+
+u64 GetProgramKey(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                  const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data) {
+    // Same key as ShaderSetup::GetProgramCodeHash() ^ ShaderSetup::GetSwizzleDataHash()
+    return Common::ComputeHash64(&program_code, sizeof(program_code)) ^
+           Common::ComputeHash64(&swizzle_data, sizeof(swizzle_data));
+}
+
+ProgramDiskCache::ProgramDiskCache(u64 title_id) : title_id(title_id) {}
+
+ProgramDiskCache::~ProgramDiskCache() = default;
+
+std::string ProgramDiskCache::GetFilePath() const {
+    return fmt::format("{}pica" DIR_SEP "{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir), title_id);
+}
+
+std::vector<CachedProgram> ProgramDiskCache::Load() {
+    std::vector<CachedProgram> programs;
+    stored_keys.clear();
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::Exists(path)) {
+        Recreate();
+        return programs;
+    }
+
+    FileUtil::IOFile read_file(path, "rb");
+    FileHeader header{};
+    if (read_file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+        LOG_INFO(HW_GPU, "PICA shader cache for {:016X} is outdated, recreating it", title_id);
+        read_file.Close();
+        Recreate();
+        return programs;
+    }
+
+    const u64 file_size = read_file.GetSize();
+    while (read_file.Tell() < file_size) {
+        EntryHeader entry_header{};
+        if (read_file.ReadBytes(&entry_header, sizeof(entry_header)) != sizeof(entry_header)) {
+            break;
+        }
+
+        const u64 payload_size =
+            (static_cast<u64>(entry_header.code_words) + entry_header.swizzle_words) * sizeof(u32);
+        if (entry_header.code_words > MAX_PROGRAM_CODE_LENGTH ||
+            entry_header.swizzle_words > MAX_SWIZZLE_DATA_LENGTH ||
+            read_file.Tell() + payload_size > file_size) {
+            // The last write was interrupted, drop the incomplete entry
+            LOG_WARNING(HW_GPU, "PICA shader cache for {:016X} has a truncated entry", title_id);
+            break;
+        }
+
+        CachedProgram& program = programs.emplace_back();
+        read_file.ReadArray(program.program_code.data(), entry_header.code_words);
+        read_file.ReadArray(program.swizzle_data.data(), entry_header.swizzle_words);
+        stored_keys.insert(GetProgramKey(program.program_code, program.swizzle_data));
+    }
+
+    LOG_INFO(HW_GPU, "Loaded {} programs from the PICA shader cache for {:016X}", programs.size(),
+             title_id);
+    return programs;
+}
+
+void ProgramDiskCache::Save(u64 key, const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                            const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data) {
+    if (!stored_keys.insert(key).second || !EnsureOpenForAppend()) {
+        return;
+    }
+
+    const EntryHeader entry_header{GetUsedWords(program_code), GetUsedWords(swizzle_data)};
+    file.WriteObject(entry_header);
+    file.WriteArray(program_code.data(), entry_header.code_words);
+    file.WriteArray(swizzle_data.data(), entry_header.swizzle_words);
+    // Flush right away so that the entry survives a crash of the emulator
+    file.Flush();
+}
+
+bool ProgramDiskCache::Recreate() {
+    file.Close();
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(HW_GPU, "Failed to create the PICA shader cache directory {}", path);
+        return false;
+    }
+
+    if (!file.Open(path, "wb")) {
+        LOG_ERROR(HW_GPU, "Failed to create the PICA shader cache file {}", path);
+        return false;
+    }
+
+    file.WriteObject(MakeHeader());
+    file.Flush();
+    return file.IsGood();
+}
+
+bool ProgramDiskCache::EnsureOpenForAppend() {
+    if (file.IsOpen()) {
+        return file.IsGood();
+    }
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::Exists(path)) {
+        return Recreate();
+    }
+    return file.Open(path, "ab");
+}
+
+} // namespace Shader
+} // namespace Pica
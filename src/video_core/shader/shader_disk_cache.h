@@ -0,0 +1,58 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+namespace Shader {
+
+/// A PICA shader program as it is stored in the disk cache
+struct CachedProgram {
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code{};
+    std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data{};
+};
+
+/// Returns the key the shader JIT caches the compiled code of a program under
+u64 GetProgramKey(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                  const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data);
+
+/**
+ * A per-title, append-only store of the PICA shader programs a title used, so that the shader JIT
+ * can compile them at boot instead of on the draw that first uses them. Unlike the generated GLSL,
+ * the programs are guest data and stay valid across builds.
+ */
+class ProgramDiskCache {
+public:
+    explicit ProgramDiskCache(u64 title_id);
+    ~ProgramDiskCache();
+
+    /// Reads all the programs stored for the title, recreating the file if it is invalid
+    std::vector<CachedProgram> Load();
+
+    /// Appends a program to the cache file unless it is already stored
+    void Save(u64 key, const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+              const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data);
+
+private:
+    bool Recreate();
+    bool EnsureOpenForAppend();
+
+    std::string GetFilePath() const;
+
+    u64 title_id;
+    FileUtil::IOFile file;
+    /// Keys of the programs in the file
+    std::unordered_set<u64> stored_keys;
+};
+
+} // namespace Shader
+} // namespace Pica
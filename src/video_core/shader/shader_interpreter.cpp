@@ -683,6 +683,17 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
 
+void InterpreterEngine::RunBatch(const ShaderSetup& setup, UnitState* states,
+                                 std::size_t count) const {
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    DebugData<false> dummy_debug_data;
+    for (std::size_t i = 0; i < count; ++i) {
+        RunInterpreter(setup, states[i], dummy_debug_data, setup.engine_data.entry_point);
+    }
+}
+
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
                                                     const AttributeBuffer& input,
                                                     const ShaderRegs& config) const {
@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_disk_cache.h"
 #include "video_core/shader/shader_jit_x64.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
 
@@ -11,7 +15,10 @@ namespace Pica {
 namespace Shader {
 
 JitX64Engine::JitX64Engine() = default;
-JitX64Engine::~JitX64Engine() = default;
+
+JitX64Engine::~JitX64Engine() {
+    StopPrecompiling();
+}
 
 void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
@@ -21,14 +28,25 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     u64 swizzle_hash = setup.GetSwizzleDataHash();
 
     u64 cache_key = code_hash ^ swizzle_hash;
+    std::unique_lock<std::mutex> lock(cache_mutex);
     auto iter = cache.find(cache_key);
     if (iter != cache.end()) {
         setup.engine_data.cached_shader = iter->second.get();
-    } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.engine_data.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
+        return;
+    }
+    lock.unlock();
+
+    auto shader = std::make_unique<JitShader>();
+    shader->Compile(&setup.program_code, &setup.swizzle_data);
+
+    lock.lock();
+    // A precompile thread may have finished the same program in the meantime, keep its copy
+    iter = cache.emplace(cache_key, std::move(shader)).first;
+    setup.engine_data.cached_shader = iter->second.get();
+    lock.unlock();
+
+    if (disk_cache != nullptr) {
+        disk_cache->Save(cache_key, setup.program_code, setup.swizzle_data);
     }
 }
 
@@ -43,5 +61,79 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+void JitX64Engine::RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const {
+    ASSERT(setup.engine_data.cached_shader != nullptr);
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    const JitShader* shader = static_cast<const JitShader*>(setup.engine_data.cached_shader);
+    for (std::size_t i = 0; i < count; ++i) {
+        shader->Run(setup, states[i], setup.engine_data.entry_point);
+    }
+}
+
+void JitX64Engine::SetDiskCache(ProgramDiskCache* cache) {
+    disk_cache = cache;
+}
+
+void JitX64Engine::Precompile(std::vector<CachedProgram> programs) {
+    StopPrecompiling();
+    if (programs.empty()) {
+        return;
+    }
+
+    struct Work {
+        std::vector<CachedProgram> programs;
+        std::atomic<std::size_t> next{0};
+    };
+    auto work = std::make_shared<Work>();
+    work->programs = std::move(programs);
+
+    // Leave workers to the draws of the emulation and GPU threads that keep running meanwhile.
+    // The tasks have a low priority, so those draws don't wait behind them either.
+    auto& thread_pool = Common::GetThreadPool();
+    const std::size_t num_threads = std::clamp<std::size_t>(thread_pool.GetNumThreads() / 2, 1, 4);
+    LOG_INFO(HW_GPU, "Precompiling {} shader programs on {} threads", work->programs.size(),
+             num_threads);
+
+    const auto compile_programs = [this, work] {
+        while (!stop_precompile) {
+            const std::size_t index = work->next++;
+            if (index >= work->programs.size()) {
+                break;
+            }
+
+            const CachedProgram& program = work->programs[index];
+            const u64 key = GetProgramKey(program.program_code, program.swizzle_data);
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                if (cache.count(key) != 0) {
+                    continue;
+                }
+            }
+
+            auto shader = std::make_unique<JitShader>();
+            shader->Compile(&program.program_code, &program.swizzle_data);
+
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            cache.emplace(key, std::move(shader));
+        }
+    };
+
+    stop_precompile = false;
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        precompile_tasks.push_back(
+            thread_pool.Submit(compile_programs, Common::ThreadPool::Priority::Low));
+    }
+}
+
+void JitX64Engine::StopPrecompiling() {
+    stop_precompile = true;
+    for (const auto& task : precompile_tasks) {
+        Common::GetThreadPool().Wait(task);
+    }
+    precompile_tasks.clear();
+}
+
 } // namespace Shader
 } // namespace Pica
@@ -4,15 +4,21 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
+#include "common/thread_pool.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
 namespace Shader {
 
 class JitShader;
+class ProgramDiskCache;
+struct CachedProgram;
 
 class JitX64Engine final : public ShaderEngine {
 public:
@@ -21,9 +27,25 @@ public:
 
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
+
+    /// Sets the store that newly compiled programs are recorded to, nullptr to stop recording
+    void SetDiskCache(ProgramDiskCache* cache);
+
+    /// Compiles programs on the shared thread pool, so that they are ready before their first use
+    void Precompile(std::vector<CachedProgram> programs);
 
 private:
+    void StopPrecompiling();
+
+    /// Guards cache, which the precompile tasks add to
+    std::mutex cache_mutex;
     std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+
+    ProgramDiskCache* disk_cache = nullptr;
+
+    std::vector<Common::ThreadPool::TaskHandle> precompile_tasks;
+    std::atomic<bool> stop_precompile{false};
 };
 
 } // namespace Shader
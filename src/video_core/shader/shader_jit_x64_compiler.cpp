@@ -213,36 +213,42 @@ void JitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRe
         address_register_index = instr.common.address_register_index;
     }
 
+    Xbyak::RegExp src_addr = src_ptr + src_offset_disp;
     if (src_num == offset_src && address_register_index != 0) {
         switch (address_register_index) {
         case 1: // address offset 1
-            movaps(dest, xword[src_ptr + ADDROFFS_REG_0 + src_offset_disp]);
+            src_addr = src_ptr + ADDROFFS_REG_0 + src_offset_disp;
             break;
         case 2: // address offset 2
-            movaps(dest, xword[src_ptr + ADDROFFS_REG_1 + src_offset_disp]);
+            src_addr = src_ptr + ADDROFFS_REG_1 + src_offset_disp;
             break;
         case 3: // address offset 3
-            movaps(dest, xword[src_ptr + LOOPCOUNT_REG.cvt64() + src_offset_disp]);
+            src_addr = src_ptr + LOOPCOUNT_REG.cvt64() + src_offset_disp;
             break;
         default:
             UNREACHABLE();
             break;
         }
-    } else {
-        // Load the source
-        movaps(dest, xword[src_ptr + src_offset_disp]);
     }
 
     SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
 
-    // Generate instructions for source register swizzling as needed
     u8 sel = swiz.GetRawSelector(src_num);
-    if (sel != NO_SRC_REG_SWIZZLE) {
+    if (sel == NO_SRC_REG_SWIZZLE) {
+        // Load the source
+        movaps(dest, xword[src_addr]);
+    } else {
         // Selector component order needs to be reversed for the SHUFPS instruction
         sel = ((sel & 0xc0) >> 6) | ((sel & 3) << 6) | ((sel & 0xc) << 2) | ((sel & 0x30) >> 2);
 
-        // Shuffle inputs for swizzle
-        shufps(dest, dest, sel);
+        if (Common::GetCPUCaps().avx) {
+            // Load and swizzle the source in a single instruction
+            vpermilps(dest, xword[src_addr], sel);
+        } else {
+            // Load the source, then shuffle it for swizzle
+            movaps(dest, xword[src_addr]);
+            shufps(dest, dest, sel);
+        }
     }
 
     // If the source register should be negated, flip the negative bit using XOR
@@ -276,13 +282,17 @@ void JitShader::Compile_DestEnable(Instruction instr, Xmm src) {
     } else {
         // Not all components are enabled, so mask the result when storing to the destination
         // register...
-        movaps(SCRATCH, xword[STATE + dest_offset_disp]);
-
-        if (Common::GetCPUCaps().sse4_1) {
-            u8 mask = ((swiz.dest_mask & 1) << 3) | ((swiz.dest_mask & 8) >> 3) |
-                      ((swiz.dest_mask & 2) << 1) | ((swiz.dest_mask & 4) >> 1);
+        const u8 mask = ((swiz.dest_mask & 1) << 3) | ((swiz.dest_mask & 8) >> 3) |
+                        ((swiz.dest_mask & 2) << 1) | ((swiz.dest_mask & 4) >> 1);
+
+        if (Common::GetCPUCaps().avx) {
+            // Blends the disabled components straight from memory instead of loading them first
+            vblendps(SCRATCH, src, xword[STATE + dest_offset_disp], ~mask & 0xf);
+        } else if (Common::GetCPUCaps().sse4_1) {
+            movaps(SCRATCH, xword[STATE + dest_offset_disp]);
             blendps(SCRATCH, src, mask);
         } else {
+            movaps(SCRATCH, xword[STATE + dest_offset_disp]);
             movaps(SCRATCH2, src);
             unpckhps(SCRATCH2, SCRATCH); // Unpack X/Y components of source and destination
             unpcklps(SCRATCH, src);      // Unpack Z/W components of source and destination
@@ -307,6 +317,16 @@ void JitShader::Compile_SanitizedMul(Xmm src1, Xmm src2, Xmm scratch) {
     // where neither source was, this NaN was generated by a 0 * inf multiplication, and so the
     // result should be transformed to 0 to match PICA fp rules.
 
+    if (Common::GetCPUCaps().avx) {
+        // Same sequence as below, with the three-operand forms sparing the copies
+        vcmpordps(scratch, src1, src2);
+        vmulps(src1, src1, src2);
+        vcmpunordps(src2, src1, src1);
+        vxorps(scratch, scratch, src2);
+        vandps(src1, src1, scratch);
+        return;
+    }
+
     // Set scratch to mask of (src1 != NaN and src2 != NaN)
     movaps(scratch, src1);
     cmpordps(scratch, src2);
@@ -322,6 +342,20 @@ void JitShader::Compile_SanitizedMul(Xmm src1, Xmm src2, Xmm scratch) {
     andps(src1, scratch);
 }
 
+void JitShader::Compile_HorizontalAdd(Xmm src, Xmm scratch) {
+    if (Common::GetCPUCaps().avx) {
+        // HADDPS decodes to three uops, two shuffles and two adds are cheaper. The components are
+        // added in the same pairs as with HADDPS, so the result is bit-identical.
+        vpermilps(scratch, src, _MM_SHUFFLE(2, 3, 0, 1));
+        vaddps(src, src, scratch);
+        vpermilps(scratch, src, _MM_SHUFFLE(1, 0, 3, 2));
+        vaddps(src, src, scratch);
+    } else {
+        haddps(src, src);
+        haddps(src, src);
+    }
+}
+
 void JitShader::Compile_EvaluateCondition(Instruction instr) {
     // Note: NXOR is used below to check for equality
     switch (instr.flow_control.op) {
@@ -375,11 +409,16 @@ void JitShader::Compile_DP3(Instruction instr) {
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
 
-    movaps(SRC2, SRC1);
-    shufps(SRC2, SRC2, _MM_SHUFFLE(1, 1, 1, 1));
+    if (Common::GetCPUCaps().avx) {
+        vpermilps(SRC2, SRC1, _MM_SHUFFLE(1, 1, 1, 1));
+        vpermilps(SRC3, SRC1, _MM_SHUFFLE(2, 2, 2, 2));
+    } else {
+        movaps(SRC2, SRC1);
+        shufps(SRC2, SRC2, _MM_SHUFFLE(1, 1, 1, 1));
 
-    movaps(SRC3, SRC1);
-    shufps(SRC3, SRC3, _MM_SHUFFLE(2, 2, 2, 2));
+        movaps(SRC3, SRC1);
+        shufps(SRC3, SRC3, _MM_SHUFFLE(2, 2, 2, 2));
+    }
 
     shufps(SRC1, SRC1, _MM_SHUFFLE(0, 0, 0, 0));
     addps(SRC1, SRC2);
@@ -393,9 +432,7 @@ void JitShader::Compile_DP4(Instruction instr) {
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
-
-    haddps(SRC1, SRC1);
-    haddps(SRC1, SRC1);
+    Compile_HorizontalAdd(SRC1, SCRATCH);
 
     Compile_DestEnable(instr, SRC1);
 }
@@ -420,9 +457,7 @@ void JitShader::Compile_DPH(Instruction instr) {
     }
 
     Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
-
-    haddps(SRC1, SRC1);
-    haddps(SRC1, SRC1);
+    Compile_HorizontalAdd(SRC1, SCRATCH);
 
     Compile_DestEnable(instr, SRC1);
 }
@@ -1022,23 +1057,34 @@ Xbyak::Label JitShader::CompilePrelude_Log2() {
     or_(edx, 0x3f800000);
     movd(SRC1, edx);
     // SRC1 now contains the mantissa of the input.
-    mulss(SCRATCH, SRC1);
     shr(eax, 23);
     sub(eax, 0x7f);
     cvtsi2ss(SCRATCH2, eax);
     // SCRATCH2 now contains the exponent of the input.
 
     // Complete computation of polynomial
-    addss(SCRATCH, xword[rip + c1]);
-    mulss(SCRATCH, SRC1);
-    addss(SCRATCH, xword[rip + c2]);
-    mulss(SCRATCH, SRC1);
-    addss(SCRATCH, xword[rip + c3]);
-    mulss(SCRATCH, SRC1);
-    subss(SRC1, ONE);
-    addss(SCRATCH, xword[rip + c4]);
-    mulss(SCRATCH, SRC1);
-    addss(SCRATCH2, SCRATCH);
+    if (Common::GetCPUCaps().fma) {
+        // The polynomial is an approximation either way, fusing its steps halves the latency of
+        // the dependency chain and rounds less.
+        vfmadd213ss(SCRATCH, SRC1, dword[rip + c1]);
+        vfmadd213ss(SCRATCH, SRC1, dword[rip + c2]);
+        vfmadd213ss(SCRATCH, SRC1, dword[rip + c3]);
+        vfmadd213ss(SCRATCH, SRC1, dword[rip + c4]);
+        subss(SRC1, ONE);
+        vfmadd231ss(SCRATCH2, SCRATCH, SRC1);
+    } else {
+        mulss(SCRATCH, SRC1);
+        addss(SCRATCH, xword[rip + c1]);
+        mulss(SCRATCH, SRC1);
+        addss(SCRATCH, xword[rip + c2]);
+        mulss(SCRATCH, SRC1);
+        addss(SCRATCH, xword[rip + c3]);
+        mulss(SCRATCH, SRC1);
+        subss(SRC1, ONE);
+        addss(SCRATCH, xword[rip + c4]);
+        mulss(SCRATCH, SRC1);
+        addss(SCRATCH2, SCRATCH);
+    }
 
     // Duplicate result across vector
     xorps(SRC1, SRC1); // break dependency chain
@@ -1099,19 +1145,26 @@ Xbyak::Label JitShader::CompilePrelude_Exp2() {
     add(eax, 0x7f);
     subss(SRC1, SCRATCH);
     // SRC1 contains input - round(input), which is in [-0.5, 0.5).
-    mulss(SCRATCH2, SRC1);
     shl(eax, 23);
     movd(SCRATCH, eax);
     // SCRATCH contains 2^(round(input)).
 
     // Complete computation of polynomial.
-    addss(SCRATCH2, xword[rip + c1]);
-    mulss(SCRATCH2, SRC1);
-    addss(SCRATCH2, xword[rip + c2]);
-    mulss(SCRATCH2, SRC1);
-    addss(SCRATCH2, xword[rip + c3]);
-    mulss(SRC1, SCRATCH2);
-    addss(SRC1, xword[rip + c4]);
+    if (Common::GetCPUCaps().fma) {
+        vfmadd213ss(SCRATCH2, SRC1, dword[rip + c1]);
+        vfmadd213ss(SCRATCH2, SRC1, dword[rip + c2]);
+        vfmadd213ss(SCRATCH2, SRC1, dword[rip + c3]);
+        vfmadd213ss(SRC1, SCRATCH2, dword[rip + c4]);
+    } else {
+        mulss(SCRATCH2, SRC1);
+        addss(SCRATCH2, xword[rip + c1]);
+        mulss(SCRATCH2, SRC1);
+        addss(SCRATCH2, xword[rip + c2]);
+        mulss(SCRATCH2, SRC1);
+        addss(SCRATCH2, xword[rip + c3]);
+        mulss(SRC1, SCRATCH2);
+        addss(SRC1, xword[rip + c4]);
+    }
     mulss(SRC1, SCRATCH);
 
     // Duplicate result across vector
@@ -85,6 +85,9 @@ private:
      */
     void Compile_SanitizedMul(Xbyak::Xmm src1, Xbyak::Xmm src2, Xbyak::Xmm scratch);
 
+    /// Sums the four components of `src` into each of its components. Clobbers `scratch`.
+    void Compile_HorizontalAdd(Xbyak::Xmm src, Xbyak::Xmm scratch);
+
     void Compile_EvaluateCondition(Instruction instr);
     void Compile_UniformCondition(Instruction instr);
 
@@ -84,7 +84,8 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     Rasterizer::BinnedRasterizer* binned_rasterizer) {
     using boost::container::static_vector;
 
     // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
@@ -147,20 +148,34 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
         }
     };
 
-    for (auto edge : clipping_edges) {
-        Clip(edge);
+    const bool clip_enable = g_state.regs.rasterizer.clip_enable != 0;
+    const ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
 
-        // Need to have at least a full triangle to continue...
-        if (output_list->size() < 3)
-            return;
-    }
+    // Clipping leaves triangles that are inside of every edge as they are, which is the case of
+    // most of them, so the buffering is skipped for those
+    const auto IsTriangleInside = [&buffer_a](const ClippingEdge& edge) {
+        return edge.IsInside(buffer_a[0]) && edge.IsInside(buffer_a[1]) &&
+               edge.IsInside(buffer_a[2]);
+    };
+    const bool trivially_accepted =
+        std::all_of(clipping_edges.begin(), clipping_edges.end(), IsTriangleInside) &&
+        (!clip_enable || IsTriangleInside(custom_edge));
 
-    if (g_state.regs.rasterizer.clip_enable) {
-        ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
-        Clip(custom_edge);
+    if (!trivially_accepted) {
+        for (const auto& edge : clipping_edges) {
+            Clip(edge);
+
+            // Need to have at least a full triangle to continue...
+            if (output_list->size() < 3)
+                return;
+        }
 
-        if (output_list->size() < 3)
-            return;
+        if (clip_enable) {
+            Clip(custom_edge);
+
+            if (output_list->size() < 3)
+                return;
+        }
     }
 
     InitScreenCoordinates((*output_list)[0]);
@@ -188,7 +203,11 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             vtx2.screenpos.x.ToFloat32(), vtx2.screenpos.y.ToFloat32(),
             vtx2.screenpos.z.ToFloat32());
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        if (binned_rasterizer) {
+            binned_rasterizer->AddTriangle(vtx0, vtx1, vtx2);
+        } else {
+            Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        }
     }
 }
 
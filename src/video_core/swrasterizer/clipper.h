@@ -9,11 +9,20 @@ namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+class BinnedRasterizer;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/**
+ * Clips a triangle against the view volume and rasterizes the resulting triangles, either right
+ * away or through the given binned rasterizer.
+ */
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     Rasterizer::BinnedRasterizer* binned_rasterizer = nullptr);
 
 } // namespace Clipper
 } // namespace Pica
@@ -20,15 +20,86 @@ static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_
     return lut_value + lut_diff * delta;
 }
 
+LightingSetup::LightingSetup(const LightingRegs& regs) {
+    const auto supported = [&regs](LightingRegs::LightingSampler sampler) {
+        return LightingRegs::IsLightingSamplerSupported(regs.config0.config, sampler);
+    };
+    const auto make_lut = [&regs](bool enable, LightingRegs::LightingLutInput input, bool abs,
+                                  LightingRegs::LightingScale scale) {
+        return Lut{enable, input, abs, regs.lut_scale.GetScale(scale)};
+    };
+    using Sampler = LightingRegs::LightingSampler;
+
+    num_lights = regs.max_light_index + 1;
+    for (std::size_t light_index = 0; light_index < num_lights; ++light_index) {
+        const unsigned num = regs.light_enable.GetNum(static_cast<unsigned>(light_index));
+        const auto& light_config = regs.light[num];
+        Light& light = lights[light_index];
+
+        light.num = num;
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        light.spot_direction = Math::Vec3<s32>{light_config.spot_x.Value(),
+                                               light_config.spot_y.Value(),
+                                               light_config.spot_z.Value()}
+                                   .Cast<float>() /
+                               2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+        light.enable_dist_atten = !regs.IsDistAttenDisabled(num);
+        light.dist_atten_scale = float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+        light.dist_atten_bias = float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        light.enable_spot_atten =
+            !regs.IsSpotAttenDisabled(num) && supported(Sampler::SpotlightAttenuation);
+        light.enable_shadow = !regs.IsShadowDisabled(num);
+    }
+
+    d0 = make_lut(regs.config1.disable_lut_d0 == 0 && supported(Sampler::Distribution0),
+                  regs.lut_input.d0, regs.abs_lut_input.disable_d0 == 0, regs.lut_scale.d0);
+    d1 = make_lut(regs.config1.disable_lut_d1 == 0 && supported(Sampler::Distribution1),
+                  regs.lut_input.d1, regs.abs_lut_input.disable_d1 == 0, regs.lut_scale.d1);
+    sp = make_lut(true, regs.lut_input.sp, regs.abs_lut_input.disable_sp == 0, regs.lut_scale.sp);
+    fr = make_lut(regs.config1.disable_lut_fr == 0 && supported(Sampler::Fresnel),
+                  regs.lut_input.fr, regs.abs_lut_input.disable_fr == 0, regs.lut_scale.fr);
+    rr = make_lut(regs.config1.disable_lut_rr == 0 && supported(Sampler::ReflectRed),
+                  regs.lut_input.rr, regs.abs_lut_input.disable_rr == 0, regs.lut_scale.rr);
+    rg = make_lut(regs.config1.disable_lut_rg == 0 && supported(Sampler::ReflectGreen),
+                  regs.lut_input.rg, regs.abs_lut_input.disable_rg == 0, regs.lut_scale.rg);
+    rb = make_lut(regs.config1.disable_lut_rb == 0 && supported(Sampler::ReflectBlue),
+                  regs.lut_input.rb, regs.abs_lut_input.disable_rb == 0, regs.lut_scale.rb);
+
+    global_ambient = regs.global_ambient.ToVec3f();
+    config = regs.config0.config;
+    bump_mode = regs.config0.bump_mode;
+    bump_selector = regs.config0.bump_selector;
+    bump_renorm = regs.config0.disable_bump_renorm == 0;
+    enable_shadow = regs.config0.enable_shadow != 0;
+    shadow_selector = regs.config0.shadow_selector;
+    shadow_invert = regs.config0.shadow_invert != 0;
+    shadow_primary = regs.config0.shadow_primary != 0;
+    shadow_secondary = regs.config0.shadow_secondary != 0;
+    shadow_alpha = regs.config0.shadow_alpha != 0;
+    clamp_highlights = regs.config0.clamp_highlights != 0;
+    enable_primary_alpha = regs.config0.enable_primary_alpha != 0;
+    enable_secondary_alpha = regs.config0.enable_secondary_alpha != 0;
+}
+
 std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const LightingSetup& setup, const Pica::State::Lighting& lighting_state,
     const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
     const Math::Vec4<u8> (&texture_color)[4]) {
 
     Math::Vec4<float> shadow;
-    if (lighting.config0.enable_shadow) {
-        shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
-        if (lighting.config0.shadow_invert) {
+    if (setup.enable_shadow) {
+        shadow = texture_color[setup.shadow_selector].Cast<float>() / 255.0f;
+        if (setup.shadow_invert) {
             shadow = Math::MakeVec(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
         }
     } else {
@@ -38,23 +109,22 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
     Math::Vec3<float> surface_normal;
     Math::Vec3<float> surface_tangent;
 
-    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
+    if (setup.bump_mode != LightingRegs::LightingBumpMode::None) {
         Math::Vec3<float> perturbation =
-            texture_color[lighting.config0.bump_selector].xyz().Cast<float>() / 127.5f -
+            texture_color[setup.bump_selector].xyz().Cast<float>() / 127.5f -
             Math::MakeVec(1.0f, 1.0f, 1.0f);
-        if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
-            if (!lighting.config0.disable_bump_renorm) {
+        if (setup.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
+            if (setup.bump_renorm) {
                 const float z_square = 1 - perturbation.xy().Length2();
                 perturbation.z = std::sqrt(std::max(z_square, 0.0f));
             }
             surface_normal = perturbation;
             surface_tangent = Math::MakeVec(1.0f, 0.0f, 0.0f);
-        } else if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
+        } else if (setup.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
             surface_normal = Math::MakeVec(0.0f, 0.0f, 1.0f);
             surface_tangent = perturbation;
         } else {
-            LOG_ERROR(HW_GPU, "Unknown bump mode {}",
-                      static_cast<u32>(lighting.config0.bump_mode.Value()));
+            LOG_ERROR(HW_GPU, "Unknown bump mode {}", static_cast<u32>(setup.bump_mode));
         }
     } else {
         surface_normal = Math::MakeVec(0.0f, 0.0f, 1.0f);
@@ -65,38 +135,37 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
     auto normal = Math::QuaternionRotate(normquat, surface_normal);
     auto tangent = Math::QuaternionRotate(normquat, surface_tangent);
 
+    const Math::Vec3<float> norm_view = view.Normalized();
+
     Math::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Math::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (std::size_t light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const auto& light = setup.lights[light_index];
 
         Math::Vec3<float> refl_value = {};
-        Math::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                      float16::FromRaw(light_config.y).ToFloat32(),
-                                      float16::FromRaw(light_config.z).ToFloat32()};
         Math::Vec3<float> light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         light_vector.Normalize();
 
-        Math::Vec3<float> norm_view = view.Normalized();
-        Math::Vec3<float> half_vector = norm_view + light_vector;
+        // Several tables usually sample the same input, so the vectors are normalized once
+        const Math::Vec3<float> half_vector = norm_view + light_vector;
+        const Math::Vec3<float> norm_half_vector = half_vector.Normalized();
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        if (light.enable_dist_atten) {
+            auto distance = (-view - light.position).Length();
             std::size_t lut =
-                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
+                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) +
+                light.num;
 
-            float sample_loc = std::clamp(scale * distance + bias, 0.0f, 1.0f);
+            float sample_loc =
+                std::clamp(light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
 
             u8 lutindex =
                 static_cast<u8>(std::clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
@@ -104,18 +173,17 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
             dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
+        auto GetLutValue = [&](const LightingSetup::Lut& lut,
                                LightingRegs::LightingSampler sampler) {
             float result = 0.0f;
 
-            switch (input) {
+            switch (lut.input) {
             case LightingRegs::LightingLutInput::NH:
-                result = Math::Dot(normal, half_vector.Normalized());
+                result = Math::Dot(normal, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::VH:
-                result = Math::Dot(norm_view, half_vector.Normalized());
+                result = Math::Dot(norm_view, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::NV:
@@ -126,15 +194,12 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 result = Math::Dot(light_vector, normal);
                 break;
 
-            case LightingRegs::LightingLutInput::SP: {
-                Math::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                         light_config.spot_z.Value()};
-                result = Math::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+            case LightingRegs::LightingLutInput::SP:
+                result = Math::Dot(light_vector, light.spot_direction);
                 break;
-            }
+
             case LightingRegs::LightingLutInput::CP:
-                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Math::Vec3<float> norm_half_vector = half_vector.Normalized();
+                if (setup.config == LightingRegs::LightingConfig::Config7) {
                     const Math::Vec3<float> half_vector_proj =
                         norm_half_vector - normal * Math::Dot(normal, norm_half_vector);
                     result = Math::Dot(half_vector_proj, tangent);
@@ -143,7 +208,7 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 }
                 break;
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(input));
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(lut.input));
                 UNIMPLEMENTED();
                 result = 0.0f;
             }
@@ -151,8 +216,8 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
             u8 index;
             float delta;
 
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
+            if (lut.abs) {
+                if (light.two_sided_diffuse)
                     result = std::abs(result);
                 else
                     result = std::max(result, 0.0f);
@@ -167,132 +232,100 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 index = static_cast<u8>(signed_index);
             }
 
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
-                                             index, delta);
+            return lut.scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
+                                                 index, delta);
         };
 
         // If enabled, compute spot light attenuation value
         float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        if (light.enable_spot_atten) {
+            const auto lut = LightingRegs::SpotlightAttenuationSampler(light.num);
+            spot_atten = GetLutValue(setup.sp, lut);
         }
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        if (setup.d0.enable) {
+            d0_lut_value = GetLutValue(setup.d0, LightingRegs::LightingSampler::Distribution0);
         }
 
-        Math::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Math::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        if (setup.rr.enable) {
+            refl_value.x = GetLutValue(setup.rr, LightingRegs::LightingSampler::ReflectRed);
         } else {
             refl_value.x = 1.0f;
         }
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        if (setup.rg.enable) {
+            refl_value.y = GetLutValue(setup.rg, LightingRegs::LightingSampler::ReflectGreen);
         } else {
             refl_value.y = refl_value.x;
         }
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        if (setup.rb.enable) {
+            refl_value.z = GetLutValue(setup.rb, LightingRegs::LightingSampler::ReflectBlue);
         } else {
             refl_value.z = refl_value.x;
         }
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        if (setup.d1.enable) {
+            d1_lut_value = GetLutValue(setup.d1, LightingRegs::LightingSampler::Distribution1);
         }
 
-        Math::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Math::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == setup.num_lights - 1 && setup.fr.enable) {
+            float lut_value = GetLutValue(setup.fr, LightingRegs::LightingSampler::Fresnel);
 
             // Enabled for diffuse lighting alpha component
-            if (lighting.config0.enable_primary_alpha) {
+            if (setup.enable_primary_alpha) {
                 diffuse_sum.a() = lut_value;
             }
 
             // Enabled for the specular lighting alpha component
-            if (lighting.config0.enable_secondary_alpha) {
+            if (setup.enable_secondary_alpha) {
                 specular_sum.a() = lut_value;
             }
         }
 
         auto dot_product = Math::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
 
         float clamp_highlights = 1.0f;
-        if (lighting.config0.clamp_highlights) {
+        if (setup.clamp_highlights) {
             clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
             float geo_factor = half_vector.Length2();
             geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (light.diffuse * dot_product + light.ambient) * dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
-            if (lighting.config0.shadow_primary) {
+        if (light.enable_shadow) {
+            if (setup.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
-            if (lighting.config0.shadow_secondary) {
+            if (setup.shadow_secondary) {
                 specular = specular * shadow.xyz();
             }
         }
@@ -301,20 +334,20 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
         specular_sum += Math::MakeVec(specular, 0.0f);
     }
 
-    if (lighting.config0.shadow_alpha) {
+    if (setup.shadow_alpha) {
         // Alpha shadow also uses the Fresnel selecotr to determine which alpha to apply
         // Enabled for diffuse lighting alpha component
-        if (lighting.config0.enable_primary_alpha) {
+        if (setup.enable_primary_alpha) {
             diffuse_sum.a() *= shadow.w;
         }
 
         // Enabled for the specular lighting alpha component
-        if (lighting.config0.enable_secondary_alpha) {
+        if (setup.enable_secondary_alpha) {
             specular_sum.a() *= shadow.w;
         }
     }
 
-    diffuse_sum += Math::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Math::MakeVec(setup.global_ambient, 0.0f);
 
     auto diffuse = Math::MakeVec<float>(std::clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
                                         std::clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
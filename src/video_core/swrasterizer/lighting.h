@@ -4,15 +4,79 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
+#include "video_core/regs_lighting.h"
 
 namespace Pica {
 
+/**
+ * Lighting configuration shared by all the fragments of a triangle, decoded once from the
+ * registers instead of for every fragment.
+ */
+struct LightingSetup {
+    /// How a lookup table is sampled, sp samples the spotlight table of each light
+    struct Lut {
+        bool enable;
+        LightingRegs::LightingLutInput input;
+        bool abs;
+        float scale;
+    };
+
+    struct Light {
+        unsigned num;
+        Math::Vec3<float> position;
+        Math::Vec3<float> spot_direction;
+        Math::Vec3<float> specular_0;
+        Math::Vec3<float> specular_1;
+        Math::Vec3<float> diffuse;
+        Math::Vec3<float> ambient;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool enable_dist_atten;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        bool enable_spot_atten;
+        bool enable_shadow;
+    };
+
+    explicit LightingSetup(const LightingRegs& regs);
+
+    std::array<Light, 8> lights;
+    std::size_t num_lights;
+
+    Lut d0;
+    Lut d1;
+    Lut sp;
+    Lut fr;
+    Lut rr;
+    Lut rg;
+    Lut rb;
+
+    Math::Vec3<float> global_ambient;
+    LightingRegs::LightingConfig config;
+    LightingRegs::LightingBumpMode bump_mode;
+    unsigned bump_selector;
+    bool bump_renorm;
+    bool enable_shadow;
+    unsigned shadow_selector;
+    bool shadow_invert;
+    bool shadow_primary;
+    bool shadow_secondary;
+    bool shadow_alpha;
+    bool clamp_highlights;
+    bool enable_primary_alpha;
+    bool enable_secondary_alpha;
+};
+
 std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const LightingSetup& setup, const Pica::State::Lighting& lighting_state,
     const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
     const Math::Vec4<u8> (&texture_color)[4]);
 
@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <vector>
 #include "common/math_util.h"
 #include "video_core/swrasterizer/proctex.h"
 
@@ -15,14 +19,115 @@ using ProcTexShift = TexturingRegs::ProcTexShift;
 using ProcTexCombiner = TexturingRegs::ProcTexCombiner;
 using ProcTexFilter = TexturingRegs::ProcTexFilter;
 
-static float LookupLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut, float coord) {
+namespace {
+
+/// The procedural texture registers, from proctex to proctex_lut_offset
+using ProcTexKey = std::array<u32, 6>;
+
+struct CachedProcTexSetup {
+    ProcTexKey key;
+    ProcTexSetup setup;
+};
+
+/// Bumped to make every thread drop its cached setups the next time it looks one up
+std::atomic<u64> proctex_setup_generation{0};
+
+struct ProcTexSetupCache {
+    u64 generation = 0;
+    /// Games rarely use more than a couple of configurations between lookup table writes
+    static constexpr std::size_t MAX_SETUPS = 4;
+    std::vector<CachedProcTexSetup> setups;
+};
+
+thread_local ProcTexSetupCache proctex_setup_cache;
+
+ProcTexKey GetProcTexKey(const TexturingRegs& regs) {
+    const auto raw = [](const auto& reg) {
+        static_assert(sizeof(reg) == sizeof(u32));
+        u32 value;
+        std::memcpy(&value, &reg, sizeof(value));
+        return value;
+    };
+    return {raw(regs.proctex),
+            raw(regs.proctex_noise_u),
+            raw(regs.proctex_noise_v),
+            raw(regs.proctex_noise_frequency),
+            raw(regs.proctex_lut),
+            raw(regs.proctex_lut_offset)};
+}
+
+ProcTexSetup::Lut ConvertLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut) {
+    ProcTexSetup::Lut result;
+    for (std::size_t i = 0; i < lut.size(); ++i) {
+        result[i] = {lut[i].ToFloat(), lut[i].DiffToFloat()};
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
+ProcTexSetup::ProcTexSetup(const TexturingRegs& regs, const State::ProcTex& state) {
+    u_clamp = regs.proctex.u_clamp;
+    v_clamp = regs.proctex.v_clamp;
+    color_combiner = regs.proctex.color_combiner;
+    alpha_combiner = regs.proctex.alpha_combiner;
+    separate_alpha = regs.proctex.separate_alpha != 0;
+    noise_enable = regs.proctex.noise_enable != 0;
+    u_shift = regs.proctex.u_shift;
+    v_shift = regs.proctex.v_shift;
+    noise_frequency = {float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32(),
+                       float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32()};
+    noise_phase = {float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32(),
+                   float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32()};
+    noise_amplitude = {static_cast<float>(regs.proctex_noise_u.amplitude),
+                       static_cast<float>(regs.proctex_noise_v.amplitude)};
+    filter = regs.proctex_lut.filter;
+    lut_offset = regs.proctex_lut_offset.level0;
+    lut_width = regs.proctex_lut.width;
+
+    noise_table = ConvertLUT(state.noise_table);
+    color_map_table = ConvertLUT(state.color_map_table);
+    alpha_map_table = ConvertLUT(state.alpha_map_table);
+    for (std::size_t i = 0; i < color_table.size(); ++i) {
+        color_table[i] = state.color_table[i].ToVector().Cast<float>();
+        color_diff_table[i] = state.color_diff_table[i].ToVector().Cast<float>();
+    }
+}
+
+const ProcTexSetup& GetProcTexSetup(const TexturingRegs& regs, const State::ProcTex& state) {
+    const u64 generation = proctex_setup_generation.load(std::memory_order_acquire);
+    if (proctex_setup_cache.generation != generation) {
+        proctex_setup_cache.setups.clear();
+        proctex_setup_cache.generation = generation;
+    }
+
+    const ProcTexKey key = GetProcTexKey(regs);
+    auto& setups = proctex_setup_cache.setups;
+    const auto it = std::find_if(setups.begin(), setups.end(),
+                                 [&key](const CachedProcTexSetup& s) { return s.key == key; });
+    if (it != setups.end()) {
+        return it->setup;
+    }
+
+    if (setups.size() == ProcTexSetupCache::MAX_SETUPS) {
+        setups.erase(setups.begin());
+    }
+    setups.push_back({key, ProcTexSetup(regs, state)});
+    return setups.back().setup;
+}
+
+void InvalidateProcTexSetups() {
+    proctex_setup_generation.fetch_add(1, std::memory_order_release);
+}
+
+static float LookupLUT(const ProcTexSetup::Lut& lut, float coord) {
     // For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
     // coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
     // value entries and difference entries.
     coord *= 128;
     const int index_int = std::min(static_cast<int>(coord), 127);
     const float frac = coord - index_int;
-    return lut[index_int].ToFloat() + frac * lut[index_int].DiffToFloat();
+    return lut[index_int].value + frac * lut[index_int].difference;
 }
 
 // These function are used to generate random noise for procedural texture. Their results are
@@ -46,13 +151,9 @@ static float NoiseRand2D(unsigned int x, unsigned int y) {
     return -1.0f + v2 * 2.0f / 15.0f;
 }
 
-static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex state) {
-    const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
-    const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
-    const float phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
-    const float phase_v = float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
-    const float x = 9 * freq_u * std::abs(u + phase_u);
-    const float y = 9 * freq_v * std::abs(v + phase_v);
+static float NoiseCoef(float u, float v, const ProcTexSetup& setup) {
+    const float x = 9 * setup.noise_frequency.x * std::abs(u + setup.noise_phase.x);
+    const float y = 9 * setup.noise_frequency.y * std::abs(v + setup.noise_phase.y);
     const int x_int = static_cast<int>(x);
     const int y_int = static_cast<int>(y);
     const float x_frac = x - x_int;
@@ -62,8 +163,8 @@ static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex stat
     const float g1 = NoiseRand2D(x_int + 1, y_int) * (x_frac + y_frac - 1);
     const float g2 = NoiseRand2D(x_int, y_int + 1) * (x_frac + y_frac - 1);
     const float g3 = NoiseRand2D(x_int + 1, y_int + 1) * (x_frac + y_frac - 2);
-    const float x_noise = LookupLUT(state.noise_table, x_frac);
-    const float y_noise = LookupLUT(state.noise_table, y_frac);
+    const float x_noise = LookupLUT(setup.noise_table, x_frac);
+    const float y_noise = LookupLUT(setup.noise_table, y_frac);
     return Math::BilinearInterp(g0, g1, g2, g3, x_noise, y_noise);
 }
 
@@ -113,8 +214,8 @@ static void ClampCoord(float& coord, ProcTexClamp mode) {
     }
 }
 
-float CombineAndMap(float u, float v, ProcTexCombiner combiner,
-                    const std::array<State::ProcTex::ValueEntry, 128>& map_table) {
+static float CombineAndMap(float u, float v, ProcTexCombiner combiner,
+                           const ProcTexSetup::Lut& map_table) {
     float f;
     switch (combiner) {
     case ProcTexCombiner::U:
@@ -155,19 +256,19 @@ float CombineAndMap(float u, float v, ProcTexCombiner combiner,
     return LookupLUT(map_table, f);
 }
 
-Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state) {
+Math::Vec4<u8> ProcTex(float u, float v, const ProcTexSetup& setup) {
     u = std::abs(u);
     v = std::abs(v);
 
     // Get shift offset before noise generation
-    const float u_shift = GetShiftOffset(v, regs.proctex.u_shift, regs.proctex.u_clamp);
-    const float v_shift = GetShiftOffset(u, regs.proctex.v_shift, regs.proctex.v_clamp);
+    const float u_shift = GetShiftOffset(v, setup.u_shift, setup.u_clamp);
+    const float v_shift = GetShiftOffset(u, setup.v_shift, setup.v_clamp);
 
     // Generate noise
-    if (regs.proctex.noise_enable) {
-        float noise = NoiseCoef(u, v, regs, state);
-        u += noise * regs.proctex_noise_u.amplitude / 4095.0f;
-        v += noise * regs.proctex_noise_v.amplitude / 4095.0f;
+    if (setup.noise_enable) {
+        float noise = NoiseCoef(u, v, setup);
+        u += noise * setup.noise_amplitude.x / 4095.0f;
+        v += noise * setup.noise_amplitude.y / 4095.0f;
         u = std::abs(u);
         v = std::abs(v);
     }
@@ -177,42 +278,38 @@ Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex stat
     v += v_shift;
 
     // Clamp
-    ClampCoord(u, regs.proctex.u_clamp);
-    ClampCoord(v, regs.proctex.v_clamp);
+    ClampCoord(u, setup.u_clamp);
+    ClampCoord(v, setup.v_clamp);
 
     // Combine and map
-    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, state.color_map_table);
+    const float lut_coord = CombineAndMap(u, v, setup.color_combiner, setup.color_map_table);
 
     // Look up the color
     // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
-    const u32 offset = regs.proctex_lut_offset.level0;
-    const u32 width = regs.proctex_lut.width;
-    const float index = offset + (lut_coord * (width - 1));
+    const float index = setup.lut_offset + (lut_coord * (setup.lut_width - 1));
     Math::Vec4<u8> final_color;
     // TODO(wwylele): implement mipmap
-    switch (regs.proctex_lut.filter) {
+    switch (setup.filter) {
     case ProcTexFilter::Linear:
     case ProcTexFilter::LinearMipmapLinear:
     case ProcTexFilter::LinearMipmapNearest: {
         const int index_int = static_cast<int>(index);
         const float frac = index - index_int;
-        const auto color_value = state.color_table[index_int].ToVector().Cast<float>();
-        const auto color_diff = state.color_diff_table[index_int].ToVector().Cast<float>();
-        final_color = (color_value + frac * color_diff).Cast<u8>();
+        final_color =
+            (setup.color_table[index_int] + frac * setup.color_diff_table[index_int]).Cast<u8>();
         break;
     }
     case ProcTexFilter::Nearest:
     case ProcTexFilter::NearestMipmapLinear:
     case ProcTexFilter::NearestMipmapNearest:
-        final_color = state.color_table[static_cast<int>(std::round(index))].ToVector();
+        final_color = setup.color_table[static_cast<int>(std::round(index))].Cast<u8>();
         break;
     }
 
-    if (regs.proctex.separate_alpha) {
+    if (setup.separate_alpha) {
         // Note: in separate alpha mode, the alpha channel skips the color LUT look up stage. It
         // uses the output of CombineAndMap directly instead.
-        const float final_alpha =
-            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.alpha_map_table);
+        const float final_alpha = CombineAndMap(u, v, setup.alpha_combiner, setup.alpha_map_table);
         return Math::MakeVec<u8>(final_color.rgb(), static_cast<u8>(final_alpha * 255));
     } else {
         return final_color;
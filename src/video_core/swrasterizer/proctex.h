@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
@@ -9,8 +12,54 @@
 namespace Pica {
 namespace Rasterizer {
 
+/**
+ * Procedural texture configuration shared by all the fragments it is sampled for, with the
+ * registers decoded and the lookup tables converted to floats once instead of for every fragment.
+ */
+struct ProcTexSetup {
+    struct LutEntry {
+        float value;
+        float difference;
+    };
+    using Lut = std::array<LutEntry, 128>;
+
+    ProcTexSetup(const TexturingRegs& regs, const State::ProcTex& state);
+
+    TexturingRegs::ProcTexClamp u_clamp;
+    TexturingRegs::ProcTexClamp v_clamp;
+    TexturingRegs::ProcTexCombiner color_combiner;
+    TexturingRegs::ProcTexCombiner alpha_combiner;
+    bool separate_alpha;
+    bool noise_enable;
+    TexturingRegs::ProcTexShift u_shift;
+    TexturingRegs::ProcTexShift v_shift;
+    Math::Vec2<float> noise_frequency;
+    Math::Vec2<float> noise_phase;
+    /// Fixed point amplitudes, not scaled yet
+    Math::Vec2<float> noise_amplitude;
+    TexturingRegs::ProcTexFilter filter;
+    u32 lut_offset;
+    u32 lut_width;
+
+    Lut noise_table;
+    Lut color_map_table;
+    Lut alpha_map_table;
+    std::array<Math::Vec4<float>, 256> color_table;
+    std::array<Math::Vec4<float>, 256> color_diff_table;
+};
+
+/**
+ * Returns the setup of the procedural texture configured by the registers. The setups are cached
+ * per thread and keyed by the procedural texture registers, so they are only rebuilt when a game
+ * switches to a configuration it didn't use since the lookup tables were last written.
+ */
+const ProcTexSetup& GetProcTexSetup(const TexturingRegs& regs, const State::ProcTex& state);
+
+/// Drops the procedural texture setups of all threads, after a lookup table was written
+void InvalidateProcTexSetups();
+
 /// Generates procedural texture color for the given coordinates
-Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+Math::Vec4<u8> ProcTex(float u, float v, const ProcTexSetup& setup);
 
 } // namespace Rasterizer
 } // namespace Pica
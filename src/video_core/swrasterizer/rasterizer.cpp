@@ -5,7 +5,14 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <optional>
 #include <tuple>
+#include <utility>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
@@ -13,6 +20,7 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/quaternion.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
@@ -118,27 +126,200 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
     return std::make_tuple(x / z * half + half, y / z * half + half, z_abs, addr);
 }
 
+/// Returns how much the value of SignedArea(vtx1, vtx2, pos) changes when pos moves by one pixel
+/// along the x axis
+static int EdgeFunctionStepX(const Math::Vec2<Fix12P4>& vtx1, const Math::Vec2<Fix12P4>& vtx2) {
+    return -static_cast<int>(static_cast<u32>(vtx2.y - vtx1.y) * 0x10);
+}
+
+/**
+ * Finds the pixels of a row that are covered by a triangle, evaluating the edge functions for
+ * four pixels at a time. Edge function values are accumulated with wrapping 32-bit arithmetic,
+ * which gives the same results as evaluating SignedArea for every pixel.
+ *
+ * @param w edge function values (including the fill rule bias) of the first pixel of the row
+ * @param step edge function increments from one pixel to the next
+ * @param num_pixels number of pixels in the row
+ * @returns index of the first and one past the index of the last covered pixel. The pixels in
+ *          between aren't necessarily covered, so the caller still needs to check them.
+ */
+static std::pair<unsigned, unsigned> FindCoveredSpan(const std::array<int, 3>& w,
+                                                     const std::array<int, 3>& step,
+                                                     unsigned num_pixels) {
+    unsigned begin = num_pixels;
+    unsigned end = 0;
+
+    auto AddCoverage = [&](unsigned first_pixel, unsigned covered_mask) {
+        if (first_pixel + 4 > num_pixels) {
+            covered_mask &= (1u << (num_pixels - first_pixel)) - 1;
+        }
+        if (covered_mask == 0) {
+            return;
+        }
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            if (covered_mask & (1u << lane)) {
+                begin = std::min(begin, first_pixel + lane);
+                end = first_pixel + lane + 1;
+            }
+        }
+    };
+
+    // Unsigned math to get well defined wrap-around
+    std::array<std::array<u32, 4>, 3> lanes;
+    for (std::size_t i = 0; i < 3; ++i) {
+        for (u32 lane = 0; lane < 4; ++lane) {
+            lanes[i][lane] = static_cast<u32>(w[i]) + lane * static_cast<u32>(step[i]);
+        }
+    }
+
+#if defined(ARCHITECTURE_x86_64)
+    __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes[0].data()));
+    __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes[1].data()));
+    __m128i w2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes[2].data()));
+    const __m128i step0 = _mm_set1_epi32(static_cast<int>(static_cast<u32>(step[0]) * 4));
+    const __m128i step1 = _mm_set1_epi32(static_cast<int>(static_cast<u32>(step[1]) * 4));
+    const __m128i step2 = _mm_set1_epi32(static_cast<int>(static_cast<u32>(step[2]) * 4));
+
+    for (unsigned pixel = 0; pixel < num_pixels; pixel += 4) {
+        // A pixel is covered when none of its edge function values has the sign bit set
+        const __m128i any_negative = _mm_or_si128(_mm_or_si128(w0, w1), w2);
+        AddCoverage(pixel, ~_mm_movemask_ps(_mm_castsi128_ps(any_negative)) & 0xF);
+
+        w0 = _mm_add_epi32(w0, step0);
+        w1 = _mm_add_epi32(w1, step1);
+        w2 = _mm_add_epi32(w2, step2);
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    uint32x4_t w0 = vld1q_u32(lanes[0].data());
+    uint32x4_t w1 = vld1q_u32(lanes[1].data());
+    uint32x4_t w2 = vld1q_u32(lanes[2].data());
+    const uint32x4_t step0 = vdupq_n_u32(static_cast<u32>(step[0]) * 4);
+    const uint32x4_t step1 = vdupq_n_u32(static_cast<u32>(step[1]) * 4);
+    const uint32x4_t step2 = vdupq_n_u32(static_cast<u32>(step[2]) * 4);
+    const uint32x4_t lane_bits = {1, 2, 4, 8};
+
+    for (unsigned pixel = 0; pixel < num_pixels; pixel += 4) {
+        // A pixel is covered when none of its edge function values has the sign bit set
+        const uint32x4_t any_negative = vorrq_u32(vorrq_u32(w0, w1), w2);
+        const uint32x4_t covered = vceqq_u32(vshrq_n_u32(any_negative, 31), vdupq_n_u32(0));
+        AddCoverage(pixel, vaddvq_u32(vandq_u32(covered, lane_bits)));
+
+        w0 = vaddq_u32(w0, step0);
+        w1 = vaddq_u32(w1, step1);
+        w2 = vaddq_u32(w2, step2);
+    }
+#else
+    for (unsigned pixel = 0; pixel < num_pixels; pixel += 4) {
+        unsigned covered_mask = 0;
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            const u32 any_negative = lanes[0][lane] | lanes[1][lane] | lanes[2][lane];
+            if ((any_negative & 0x80000000) == 0) {
+                covered_mask |= 1u << lane;
+            }
+        }
+        AddCoverage(pixel, covered_mask);
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            for (auto& value : lanes[i]) {
+                value += static_cast<u32>(step[i]) * 4;
+            }
+        }
+    }
+#endif
+
+    if (begin >= end) {
+        return {0, 0};
+    }
+    return {begin, end};
+}
+
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+MICROPROFILE_DEFINE(GPU_Binning, "GPU", "Triangle Binning", MP_RGB(90, 90, 240));
+
+static bool PassesDepthTest(FramebufferRegs::CompareFunc func, u32 z, u32 ref_z) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return z == ref_z;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return z != ref_z;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return z < ref_z;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return z <= ref_z;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return z > ref_z;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return z >= ref_z;
+    }
+    return false;
+}
+
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+/// Converts a vertex position to rasterizer coordinates
+static Math::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Math::Vec3<float24>& vec) {
+    return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
+/// A pixel aligned screen area in 12.4 fixed point rasterizer coordinates. max_x/max_y are
+/// exclusive.
+struct ClipRect {
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
+
+/// Clip area that does not restrict rasterization
+constexpr ClipRect NoClip{0, 0, 0xFFFF, 0xFFFF};
+
+/**
+ * Calculates the pixel aligned area covered by the bounding box of a triangle, cropped to the
+ * scissor box when the scissor mode is Include.
+ */
+static ClipRect GetBoundingBox(const Math::Vec3<Fix12P4> (&vtxpos)[3],
+                               const RasterizerRegs& rasterizer) {
+    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+
+    if (rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
+        // Convert the scissor box coordinates to 12.4 fixed point.
+        // x2,y2 have +1 added to cover the entire sub-pixel area
+        min_x = std::max(min_x, (u16)(rasterizer.scissor_test.x1 << 4));
+        min_y = std::max(min_y, (u16)(rasterizer.scissor_test.y1 << 4));
+        max_x = std::min(max_x, (u16)((rasterizer.scissor_test.x2 + 1) << 4));
+        max_y = std::min(max_y, (u16)((rasterizer.scissor_test.y2 + 1) << 4));
+    }
+
+    min_x &= Fix12P4::IntMask();
+    min_y &= Fix12P4::IntMask();
+    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
+    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
+
+    return {min_x, min_y, max_x, max_y};
+}
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * culling via recursion. Only the pixels inside of the clip area are processed.
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+                                    const ClipRect& clip, bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
-    static auto ScreenToRasterizerCoordinates = [](const Math::Vec3<float24>& vec) {
-        return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
-    };
-
     Math::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
                                   ScreenToRasterizerCoordinates(v1.screenpos),
                                   ScreenToRasterizerCoordinates(v2.screenpos)};
@@ -146,13 +327,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, clip, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, clip, true);
             return;
         }
 
@@ -161,10 +342,11 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             return;
     }
 
-    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
-    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    const ClipRect bounding_box = GetBoundingBox(vtxpos, regs.rasterizer);
+    const u16 min_x = std::max(bounding_box.min_x, clip.min_x);
+    const u16 min_y = std::max(bounding_box.min_y, clip.min_y);
+    const u16 max_x = std::min(bounding_box.max_x, clip.max_x);
+    const u16 max_y = std::min(bounding_box.max_y, clip.max_y);
 
     // Convert the scissor box coordinates to 12.4 fixed point
     u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
@@ -173,19 +355,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
     u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
 
-    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
-        // Calculate the new bounds
-        min_x = std::max(min_x, scissor_x1);
-        min_y = std::max(min_y, scissor_y1);
-        max_x = std::min(max_x, scissor_x2);
-        max_y = std::min(max_y, scissor_y2);
-    }
-
-    min_x &= Fix12P4::IntMask();
-    min_y &= Fix12P4::IntMask();
-    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
-    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
-
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -216,15 +385,58 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     auto textures = regs.texturing.GetTextures();
     auto tev_stages = regs.texturing.GetTevStages();
 
+    // The lighting and fog registers are decoded once for all the fragments of the triangle
+    std::optional<LightingSetup> lighting_setup;
+    if (!regs.lighting.disable) {
+        lighting_setup.emplace(regs.lighting);
+    }
+    const ProcTexSetup* proctex_setup = nullptr;
+    if (regs.texturing.main_config.texture3_enable) {
+        proctex_setup = &GetProcTexSetup(regs.texturing, g_state.proctex);
+    }
+    const bool fog_enable = regs.texturing.fog_mode == TexturingRegs::FogMode::Fog;
+    const bool fog_flip = regs.texturing.fog_flip != 0;
+    const Math::Vec3<u8> fog_color =
+        Math::MakeVec(regs.texturing.fog_color.r.Value(), regs.texturing.fog_color.g.Value(),
+                      regs.texturing.fog_color.b.Value())
+            .Cast<u8>();
+
     bool stencil_action_enable =
         g_state.regs.framebuffer.output_merger.stencil_test.enable &&
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const u32 depth_max =
+        (1u << FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format)) - 1;
+
+    // Fragments failing the depth test are rejected before they are textured and shaded, unless
+    // that has side effects on the stencil buffer. The stored depth can't change in between, as
+    // no other fragment of the triangle covers the same pixel.
+    const bool early_depth_test =
+        output_merger.depth_test_enable &&
+        output_merger.fragment_operation_mode != FramebufferRegs::FragmentOperationMode::Shadow &&
+        (!stencil_action_enable ||
+         (stencil_test.action_stencil_fail == FramebufferRegs::StencilAction::Keep &&
+          stencil_test.action_depth_fail == FramebufferRegs::StencilAction::Keep));
+
+    // Edge function increments when moving one pixel to the right
+    const std::array<int, 3> w_step{EdgeFunctionStepX(vtxpos[1].xy(), vtxpos[2].xy()),
+                                    EdgeFunctionStepX(vtxpos[2].xy(), vtxpos[0].xy()),
+                                    EdgeFunctionStepX(vtxpos[0].xy(), vtxpos[1].xy())};
+    const unsigned row_pixels = max_x > min_x ? (max_x - min_x) >> 4 : 0;
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+        // Skip the pixels at both ends of the row that are outside of the triangle
+        const u16 row_x = min_x + 8;
+        const std::array<int, 3> w_row{
+            bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {row_x, y}),
+            bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {row_x, y}),
+            bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {row_x, y})};
+        const auto [span_begin, span_end] = FindCoveredSpan(w_row, w_step, row_pixels);
+
+        for (u16 x = row_x + (span_begin << 4); x < row_x + (span_end << 4); x += 0x10) {
 
             // Do not process the pixel if it's inside the scissor box and the scissor mode is set
             // to Exclude
@@ -273,6 +485,14 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // Clamp the result
             depth = std::clamp(depth, 0.0f, 1.0f);
 
+            // Convert float to integer
+            const u32 z = static_cast<u32>(depth * depth_max);
+
+            if (early_depth_test &&
+                !PassesDepthTest(output_merger.depth_test_func, z, GetDepth(x >> 4, y >> 4))) {
+                continue;
+            }
+
             // Perspective correct attribute interpolation:
             // Attribute values cannot be calculated by simple linear interpolation since
             // they are not linear in screen space. For example, when interpolating a
@@ -409,7 +629,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                         Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
 
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    texture_color[i] = LookupCachedTexture(texture_data, s, t, info);
                 }
 
                 if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -430,10 +650,10 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             }
 
             // sample procedural texture
-            if (regs.texturing.main_config.texture3_enable) {
+            if (proctex_setup) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
                 texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                                           *proctex_setup);
             }
 
             // Texture environment - consists of 6 stages of color and alpha combining.
@@ -455,7 +675,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             Math::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
             Math::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
 
-            if (!g_state.regs.lighting.disable) {
+            if (lighting_setup) {
                 Math::Quaternion<float> normquat =
                     Math::Quaternion<float>{
                         {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
@@ -471,7 +691,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
                 };
                 std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+                    *lighting_setup, g_state.lighting, normquat, view, texture_color);
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
@@ -573,8 +793,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
             }
 
-            const auto& output_merger = regs.framebuffer.output_merger;
-
             if (output_merger.fragment_operation_mode ==
                 FramebufferRegs::FragmentOperationMode::Shadow) {
                 u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
@@ -631,15 +849,10 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // Not fully accurate. We'd have to know what data type is used to
             // store the depth etc. Using float for now until we know more
             // about Pica datatypes
-            if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
-                const Math::Vec3<u8> fog_color = Math::MakeVec(regs.texturing.fog_color.r.Value(),
-                                                               regs.texturing.fog_color.g.Value(),
-                                                               regs.texturing.fog_color.b.Value())
-                                                     .Cast<u8>();
-
+            if (fog_enable) {
                 // Get index into fog LUT
                 float fog_index;
-                if (g_state.regs.texturing.fog_flip) {
+                if (fog_flip) {
                     fog_index = (1.0f - depth) * 128.0f;
                 } else {
                     fog_index = depth * 128.0f;
@@ -717,55 +930,11 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
             }
 
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
-
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
-
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
-
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
-                }
+            if (output_merger.depth_test_enable && !early_depth_test &&
+                !PassesDepthTest(output_merger.depth_test_func, z, GetDepth(x >> 4, y >> 4))) {
+                if (stencil_action_enable)
+                    UpdateStencil(stencil_test.action_depth_fail);
+                continue;
             }
 
             if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
@@ -890,7 +1059,91 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 }
 
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    ProcessTriangleInternal(v0, v1, v2, NoClip);
+}
+
+BinnedRasterizer::BinnedRasterizer(unsigned num_threads) : num_threads(num_threads) {}
+
+void BinnedRasterizer::AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    MICROPROFILE_SCOPE(GPU_Binning);
+    const auto& regs = g_state.regs;
+
+    if (triangles.empty()) {
+        // The framebuffer registers can't change while triangles are pending, so the tile grid
+        // only needs to be set up once per batch
+        framebuffer_width = regs.framebuffer.framebuffer.GetWidth();
+        framebuffer_height = regs.framebuffer.framebuffer.GetHeight();
+        tiles_x = std::max(1u, (framebuffer_width + TILE_SIZE - 1) / TILE_SIZE);
+        tiles_y = std::max(1u, (framebuffer_height + TILE_SIZE - 1) / TILE_SIZE);
+        bins.resize(tiles_x * tiles_y);
+    }
+
+    const Math::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
+                                        ScreenToRasterizerCoordinates(v1.screenpos),
+                                        ScreenToRasterizerCoordinates(v2.screenpos)};
+    const ClipRect bounding_box = GetBoundingBox(vtxpos, regs.rasterizer);
+    if (bounding_box.min_x >= bounding_box.max_x || bounding_box.min_y >= bounding_box.max_y) {
+        // Covers no pixel centers
+        return;
+    }
+
+    if (bounding_box.max_x > (framebuffer_width << 4) ||
+        bounding_box.max_y > (framebuffer_height << 4)) {
+        // Pixels outside of the framebuffer alias memory that belongs to other tiles. Keep the
+        // order of writes intact by rasterizing the triangle on its own.
+        Flush();
+        ProcessTriangleInternal(v0, v1, v2, NoClip);
+        return;
+    }
+
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back({v0, v1, v2});
+
+    const unsigned tile_min_x = (bounding_box.min_x >> 4) / TILE_SIZE;
+    const unsigned tile_min_y = (bounding_box.min_y >> 4) / TILE_SIZE;
+    const unsigned tile_max_x = ((bounding_box.max_x >> 4) - 1) / TILE_SIZE;
+    const unsigned tile_max_y = ((bounding_box.max_y >> 4) - 1) / TILE_SIZE;
+    for (unsigned tile_y = tile_min_y; tile_y <= tile_max_y; ++tile_y) {
+        for (unsigned tile_x = tile_min_x; tile_x <= tile_max_x; ++tile_x) {
+            bins[tile_y * tiles_x + tile_x].push_back(index);
+        }
+    }
+}
+
+void BinnedRasterizer::Flush() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    // The thread calling Flush() shades tiles as well
+    Common::GetThreadPool().ParallelFor(bins.size(), num_threads,
+                                        [this](std::size_t tile) { ProcessTile(tile); });
+
+    triangles.clear();
+    for (auto& bin : bins) {
+        bin.clear();
+    }
+}
+
+void BinnedRasterizer::ProcessTile(std::size_t tile) {
+    const auto& bin = bins[tile];
+    if (bin.empty()) {
+        return;
+    }
+
+    const u16 tile_x = static_cast<u16>(tile % tiles_x);
+    const u16 tile_y = static_cast<u16>(tile / tiles_x);
+    const ClipRect clip{static_cast<u16>((tile_x * TILE_SIZE) << 4),
+                        static_cast<u16>((tile_y * TILE_SIZE) << 4),
+                        static_cast<u16>(((tile_x + 1) * TILE_SIZE) << 4),
+                        static_cast<u16>(((tile_y + 1) * TILE_SIZE) << 4)};
+
+    // Triangles were binned in submission order, which keeps the per-pixel order of depth,
+    // stencil and blending operations the same as when rasterizing them one by one
+    for (u32 index : bin) {
+        const auto& triangle = triangles[index];
+        ProcessTriangleInternal(triangle.v0, triangle.v1, triangle.v2, clip);
+    }
 }
 
 } // namespace Rasterizer
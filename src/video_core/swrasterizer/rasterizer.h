@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -40,7 +43,45 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
+/// Rasterizes a triangle right away on the calling thread
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/**
+ * Records triangles in the bins of the screen tiles they overlap and shades the tiles on the
+ * shared thread pool once the batch is flushed. Each tile processes its triangles in submission
+ * order, so the output is identical to calling ProcessTriangle for every triangle.
+ * The Pica registers must not change between AddTriangle and Flush.
+ */
+class BinnedRasterizer {
+public:
+    /// @param num_threads total number of threads shading tiles, including the flushing thread
+    explicit BinnedRasterizer(unsigned num_threads);
+
+    void AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+    /// Shades all the pending triangles and waits until they have been written to memory
+    void Flush();
+
+private:
+    /// Width and height of a tile in pixels
+    static constexpr unsigned TILE_SIZE = 32;
+
+    struct Triangle {
+        Vertex v0, v1, v2;
+    };
+
+    void ProcessTile(std::size_t tile);
+
+    std::vector<Triangle> triangles;
+    /// Indices into triangles for each tile, in row major order
+    std::vector<std::vector<u32>> bins;
+    unsigned framebuffer_width = 0;
+    unsigned framebuffer_height = 0;
+    unsigned tiles_x = 0;
+    unsigned tiles_y = 0;
+
+    unsigned num_threads;
+};
+
 } // namespace Rasterizer
 } // namespace Pica
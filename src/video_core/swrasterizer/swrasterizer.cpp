@@ -2,15 +2,77 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
+#include "common/logging/log.h"
+#include "core/settings.h"
+#include "video_core/regs.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/proctex.h"
+#include "video_core/swrasterizer/rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/texturing.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    unsigned num_threads = Settings::values.sw_rasterizer_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (num_threads > 1) {
+        LOG_INFO(Render_Software, "Using the binned rasterizer with {} threads", num_threads);
+        binned_rasterizer = std::make_unique<Pica::Rasterizer::BinnedRasterizer>(num_threads);
+    }
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, binned_rasterizer.get());
+}
+
+void SWRasterizer::DrawTriangles() {
+    FlushBinnedTriangles();
+    // The textures may be written to before the next draw, by the CPU or by this draw
+    Pica::Rasterizer::InvalidateCachedTextures();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Binned triangles read the registers when they are shaded
+    FlushBinnedTriangles();
+
+    if (id >= PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[0], 0xb0) &&
+        id <= PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[7], 0xb7)) {
+        Pica::Rasterizer::InvalidateProcTexSetups();
+    }
+}
+
+void SWRasterizer::FlushAll() {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    FlushBinnedTriangles();
+    Pica::Rasterizer::InvalidateCachedTextures();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushBinnedTriangles();
+    Pica::Rasterizer::InvalidateCachedTextures();
+}
+
+void SWRasterizer::FlushBinnedTriangles() {
+    if (binned_rasterizer) {
+        binned_rasterizer->Flush();
+    }
 }
 
 } // namespace VideoCore
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
 
@@ -11,19 +12,33 @@ namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
+namespace Rasterizer {
+class BinnedRasterizer;
+}
 } // namespace Pica
 
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+
+private:
+    /// Shades any triangles still waiting in the bins of the binned rasterizer
+    void FlushBinnedTriangles();
+
+    /// Only used with more than one rasterizer thread
+    std::unique_ptr<Pica::Rasterizer::BinnedRasterizer> binned_rasterizer;
 };
 
 } // namespace VideoCore
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/vector_math.h"
@@ -14,6 +16,62 @@ namespace Rasterizer {
 
 using TevStageConfig = TexturingRegs::TevStageConfig;
 
+namespace {
+
+struct CachedTexture {
+    const u8* source;
+    TexturingRegs::TextureFormat format;
+    unsigned int width;
+    unsigned int height;
+    /// RGBA8 texels, texel (x, y) is at y * width + x
+    std::vector<Math::Vec4<u8>> texels;
+    /// Whether each tile has been decoded, in the order the tiles are stored
+    std::vector<bool> decoded_tiles;
+};
+
+/// Bumped to make every thread drop its cached textures the next time it samples one
+std::atomic<u64> cached_texture_generation{0};
+
+struct TextureCache {
+    u64 generation = 0;
+    /// Enough for the textures of all the units, including the faces of a cube map
+    static constexpr std::size_t MAX_TEXTURES = 8;
+    std::vector<CachedTexture> textures;
+};
+
+thread_local TextureCache texture_cache;
+
+CachedTexture& GetCachedTexture(const u8* source, const Texture::TextureInfo& info) {
+    const u64 generation = cached_texture_generation.load(std::memory_order_acquire);
+    if (texture_cache.generation != generation) {
+        texture_cache.textures.clear();
+        texture_cache.generation = generation;
+    }
+
+    auto& textures = texture_cache.textures;
+    const auto it = std::find_if(textures.begin(), textures.end(), [&](const CachedTexture& t) {
+        return t.source == source && t.format == info.format && t.width == info.width &&
+               t.height == info.height;
+    });
+    if (it != textures.end()) {
+        return *it;
+    }
+
+    if (textures.size() == TextureCache::MAX_TEXTURES) {
+        textures.erase(textures.begin());
+    }
+    CachedTexture& texture = textures.emplace_back();
+    texture.source = source;
+    texture.format = info.format;
+    texture.width = info.width;
+    texture.height = info.height;
+    texture.texels.resize(static_cast<std::size_t>(info.width) * info.height);
+    texture.decoded_tiles.resize(texture.texels.size() / 64);
+    return texture;
+}
+
+} // Anonymous namespace
+
 int GetWrappedTexCoord(TexturingRegs::TextureConfig::WrapMode mode, int val, unsigned size) {
     switch (mode) {
     case TexturingRegs::TextureConfig::ClampToEdge2:
@@ -238,5 +296,28 @@ u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
     }
 };
 
+Math::Vec4<u8> LookupCachedTexture(const u8* source, unsigned int x, unsigned int y,
+                                   const Texture::TextureInfo& info) {
+    CachedTexture& texture = GetCachedTexture(source, info);
+
+    const unsigned int coarse_x = x / 8;
+    const unsigned int coarse_y = y / 8;
+    const std::size_t tile = static_cast<std::size_t>(coarse_y) * (info.width / 8) + coarse_x;
+    if (!texture.decoded_tiles[tile]) {
+        const u8* tile_source = source + coarse_y * info.stride +
+                                coarse_x * Texture::CalculateTileSize(info.format);
+        u8* dest = reinterpret_cast<u8*>(
+            &texture.texels[static_cast<std::size_t>(coarse_y * 8) * info.width + coarse_x * 8]);
+        Texture::DecodeTile(tile_source, info.format, dest,
+                            static_cast<std::ptrdiff_t>(info.width) * 4);
+        texture.decoded_tiles[tile] = true;
+    }
+    return texture.texels[static_cast<std::size_t>(y) * info.width + x];
+}
+
+void InvalidateCachedTextures() {
+    cached_texture_generation.fetch_add(1, std::memory_order_release);
+}
+
 } // namespace Rasterizer
 } // namespace Pica
@@ -7,6 +7,7 @@
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/texture/texture_decode.h"
 
 namespace Pica {
 namespace Rasterizer {
@@ -24,5 +25,20 @@ Math::Vec3<u8> ColorCombine(TexturingRegs::TevStageConfig::Operation op,
 
 u8 AlphaCombine(TexturingRegs::TevStageConfig::Operation op, const std::array<u8, 3>& input);
 
+/**
+ * Same as Texture::LookupTexture, except that the texels are read from a cache of the textures
+ * sampled by the current draw. Textures are decoded into it one 8x8 tile at a time, the first time
+ * a texel of the tile is sampled. Each thread has its own cache, so this can be called from the
+ * binned rasterizer's workers.
+ */
+Math::Vec4<u8> LookupCachedTexture(const u8* source, unsigned int x, unsigned int y,
+                                   const Texture::TextureInfo& info);
+
+/**
+ * Drops the decoded textures of all threads, which has to be done whenever the emulated memory
+ * they were decoded from may have changed. This is done after each draw.
+ */
+void InvalidateCachedTextures();
+
 } // namespace Rasterizer
 } // namespace Pica
@@ -125,5 +125,14 @@ Math::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Subtile(u64 value, std::array<Math::Vec3<u8>, 16>& texels) {
+    const ETC1Tile tile{value};
+    for (unsigned int y = 0; y < 4; ++y) {
+        for (unsigned int x = 0; x < 4; ++x) {
+            texels[x + 4 * y] = tile.GetRGB(x, y);
+        }
+    }
+}
+
 } // namespace Texture
 } // namespace Pica
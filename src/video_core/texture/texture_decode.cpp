@@ -2,11 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#endif
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/texture/etc1.h"
@@ -212,6 +221,297 @@ Math::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int
     }
 }
 
+namespace {
+
+/// Tiles of 64 RGBA8 texels, in the Morton order the texels are stored in
+using MortonTexels = std::array<u32, TILE_SIZE>;
+
+/// Surfaces with at least this many tiles are decoded on multiple threads
+constexpr std::size_t MIN_TILES_PER_THREAD = 256;
+
+u32 PackTexel(const Math::Vec4<u8>& texel) {
+    static_assert(sizeof(texel) == sizeof(u32), "Math::Vec4<u8> must consist of 4 bytes");
+    u32 packed;
+    std::memcpy(&packed, &texel, sizeof(packed));
+    return packed;
+}
+
+template <typename Decode>
+void DecodeMorton(const u8* source, std::size_t bytes_per_texel, MortonTexels& texels,
+                  Decode&& decode) {
+    for (std::size_t i = 0; i < TILE_SIZE; ++i) {
+        texels[i] = PackTexel(decode(source + i * bytes_per_texel));
+    }
+}
+
+#if defined(ARCHITECTURE_x86_64)
+__m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+__m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+__m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+
+/// Stores eight texels whose 8-bit components are held in the 16-bit lanes of r, g, b and a
+void StoreRGBA8(u32* dest, __m128i r, __m128i g, __m128i b, __m128i a) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(rg, ba));
+}
+
+/// Decodes a tile of a 16 bits per texel format, eight texels at a time
+template <typename Decode>
+void DecodeMorton16(const u8* source, MortonTexels& texels, Decode&& decode) {
+    for (std::size_t i = 0; i < TILE_SIZE; i += 8) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        decode(&texels[i], value);
+    }
+}
+#endif
+
+void DecodeRGB565Tile(const u8* source, MortonTexels& texels) {
+#if defined(ARCHITECTURE_x86_64)
+    DecodeMorton16(source, texels, [](u32* dest, __m128i value) {
+        const __m128i mask5 = _mm_set1_epi16(0x1F);
+        const __m128i mask6 = _mm_set1_epi16(0x3F);
+        const __m128i r = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 11), mask5));
+        const __m128i g = Expand6To8(_mm_and_si128(_mm_srli_epi16(value, 5), mask6));
+        const __m128i b = Expand5To8(_mm_and_si128(value, mask5));
+        StoreRGBA8(dest, r, g, b, _mm_set1_epi16(0xFF));
+    });
+#else
+    DecodeMorton(source, 2, texels, Color::DecodeRGB565);
+#endif
+}
+
+void DecodeRGB5A1Tile(const u8* source, MortonTexels& texels) {
+#if defined(ARCHITECTURE_x86_64)
+    DecodeMorton16(source, texels, [](u32* dest, __m128i value) {
+        const __m128i mask5 = _mm_set1_epi16(0x1F);
+        const __m128i r = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 11), mask5));
+        const __m128i g = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 6), mask5));
+        const __m128i b = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 1), mask5));
+        // 0 - 1 gives all bits set in the lane
+        const __m128i a = _mm_and_si128(
+            _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi16(1))),
+            _mm_set1_epi16(0xFF));
+        StoreRGBA8(dest, r, g, b, a);
+    });
+#else
+    DecodeMorton(source, 2, texels, Color::DecodeRGB5A1);
+#endif
+}
+
+void DecodeRGBA4Tile(const u8* source, MortonTexels& texels) {
+#if defined(ARCHITECTURE_x86_64)
+    DecodeMorton16(source, texels, [](u32* dest, __m128i value) {
+        const __m128i mask4 = _mm_set1_epi16(0xF);
+        const __m128i r = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 12), mask4));
+        const __m128i g = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 8), mask4));
+        const __m128i b = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 4), mask4));
+        const __m128i a = Expand4To8(_mm_and_si128(value, mask4));
+        StoreRGBA8(dest, r, g, b, a);
+    });
+#else
+    DecodeMorton(source, 2, texels, Color::DecodeRGBA4);
+#endif
+}
+
+void DecodeIA8Tile(const u8* source, MortonTexels& texels) {
+#if defined(ARCHITECTURE_x86_64)
+    DecodeMorton16(source, texels, [](u32* dest, __m128i value) {
+        // The low byte holds the alpha, the high byte the intensity
+        const __m128i i = _mm_srli_epi16(value, 8);
+        const __m128i a = _mm_and_si128(value, _mm_set1_epi16(0xFF));
+        StoreRGBA8(dest, i, i, i, a);
+    });
+#else
+    DecodeMorton(source, 2, texels, [](const u8* texel) {
+        return Math::Vec4<u8>{texel[1], texel[1], texel[1], texel[0]};
+    });
+#endif
+}
+
+/// Decodes the 4 bits per texel formats, with the first texel of each byte in the low nibble
+template <typename Decode>
+void DecodeMorton4(const u8* source, MortonTexels& texels, Decode&& decode) {
+    for (std::size_t i = 0; i < TILE_SIZE; i += 2) {
+        const u8 value = source[i / 2];
+        texels[i] = PackTexel(decode(Color::Convert4To8(value & 0xF)));
+        texels[i + 1] = PackTexel(decode(Color::Convert4To8((value & 0xF0) >> 4)));
+    }
+}
+
+/// Writes the texels of a Morton ordered tile to dest in row order
+void MortonToRows(const MortonTexels& texels, u8* dest, std::ptrdiff_t dest_stride) {
+    using VideoCore::MortonInterleave;
+
+    for (unsigned int y = 0; y < 8; ++y) {
+        u8* row = dest + y * dest_stride;
+        // Horizontally adjacent texel pairs are adjacent in Morton order as well
+#if defined(ARCHITECTURE_x86_64)
+        for (unsigned int x = 0; x < 8; x += 4) {
+            const __m128i left = _mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(&texels[MortonInterleave(x, y)]));
+            const __m128i right = _mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(&texels[MortonInterleave(x + 2, y)]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 4),
+                             _mm_unpacklo_epi64(left, right));
+        }
+#else
+        for (unsigned int x = 0; x < 8; x += 2) {
+            std::memcpy(row + x * 4, &texels[MortonInterleave(x, y)], 2 * sizeof(u32));
+        }
+#endif
+    }
+}
+
+void DecodeETC1Tile(const u8* source, bool has_alpha, u8* dest, std::ptrdiff_t dest_stride) {
+    const std::size_t subtile_size = has_alpha ? 16 : 8;
+    std::array<Math::Vec3<u8>, 16> colors;
+
+    for (unsigned int subtile_index = 0; subtile_index < ETC1_SUBTILES; ++subtile_index) {
+        const u8* subtile_ptr = source + subtile_index * subtile_size;
+
+        u64_le packed_alpha = 0;
+        if (has_alpha) {
+            std::memcpy(&packed_alpha, subtile_ptr, sizeof(u64));
+            subtile_ptr += sizeof(u64);
+        }
+
+        u64_le subtile_data;
+        std::memcpy(&subtile_data, subtile_ptr, sizeof(u64));
+        DecodeETC1Subtile(subtile_data, colors);
+
+        const unsigned int subtile_x = (subtile_index % 2) * 4;
+        const unsigned int subtile_y = (subtile_index / 2) * 4;
+        for (unsigned int y = 0; y < 4; ++y) {
+            u8* row = dest + (subtile_y + y) * dest_stride + subtile_x * 4;
+            for (unsigned int x = 0; x < 4; ++x) {
+                // Alpha values are stored column by column
+                const u8 alpha =
+                    has_alpha ? Color::Convert4To8((packed_alpha >> (4 * (x * 4 + y))) & 0xF)
+                              : 255;
+                const auto& color = colors[x + 4 * y];
+                row[x * 4 + 0] = color.r();
+                row[x * 4 + 1] = color.g();
+                row[x * 4 + 2] = color.b();
+                row[x * 4 + 3] = alpha;
+            }
+        }
+    }
+}
+
+} // Anonymous namespace
+
+void DecodeTile(const u8* source, TextureFormat format, u8* dest, std::ptrdiff_t dest_stride) {
+    if (format == TextureFormat::ETC1 || format == TextureFormat::ETC1A4) {
+        DecodeETC1Tile(source, format == TextureFormat::ETC1A4, dest, dest_stride);
+        return;
+    }
+
+    MortonTexels texels;
+    switch (format) {
+    case TextureFormat::RGBA8:
+        DecodeMorton(source, 4, texels, Color::DecodeRGBA8);
+        break;
+    case TextureFormat::RGB8:
+        DecodeMorton(source, 3, texels, Color::DecodeRGB8);
+        break;
+    case TextureFormat::RGB5A1:
+        DecodeRGB5A1Tile(source, texels);
+        break;
+    case TextureFormat::RGB565:
+        DecodeRGB565Tile(source, texels);
+        break;
+    case TextureFormat::RGBA4:
+        DecodeRGBA4Tile(source, texels);
+        break;
+    case TextureFormat::IA8:
+        DecodeIA8Tile(source, texels);
+        break;
+    case TextureFormat::RG8:
+        DecodeMorton(source, 2, texels, Color::DecodeRG8);
+        break;
+    case TextureFormat::I8:
+        DecodeMorton(source, 1, texels, [](const u8* texel) {
+            return Math::Vec4<u8>{*texel, *texel, *texel, 255};
+        });
+        break;
+    case TextureFormat::A8:
+        DecodeMorton(source, 1, texels,
+                     [](const u8* texel) { return Math::Vec4<u8>{0, 0, 0, *texel}; });
+        break;
+    case TextureFormat::IA4:
+        DecodeMorton(source, 1, texels, [](const u8* texel) {
+            const u8 i = Color::Convert4To8((*texel & 0xF0) >> 4);
+            const u8 a = Color::Convert4To8(*texel & 0xF);
+            return Math::Vec4<u8>{i, i, i, a};
+        });
+        break;
+    case TextureFormat::I4:
+        DecodeMorton4(source, texels, [](u8 i) { return Math::Vec4<u8>{i, i, i, 255}; });
+        break;
+    case TextureFormat::A4:
+        DecodeMorton4(source, texels, [](u8 a) { return Math::Vec4<u8>{0, 0, 0, a}; });
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: {:x}", (u32)format);
+        DEBUG_ASSERT(false);
+        texels.fill(0);
+        break;
+    }
+
+    MortonToRows(texels, dest, dest_stride);
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dest,
+                   const MathUtil::Rectangle<u32>& rect) {
+    DEBUG_ASSERT(rect.left % 8 == 0 && rect.right % 8 == 0);
+    DEBUG_ASSERT(rect.bottom % 8 == 0 && rect.top % 8 == 0);
+
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    const std::ptrdiff_t dest_stride = static_cast<std::ptrdiff_t>(info.width) * 4;
+
+    // dest is stored bottom to top, so row y of dest is row height - 1 - y of the texture
+    auto DecodeTileRows = [&](u32 bottom, u32 top) {
+        for (u32 y = bottom; y < top; y += 8) {
+            const u32 coarse_y = (info.height - 8 - y) / 8;
+            const u8* line = source + coarse_y * info.stride;
+            // The first row of the tile ends up in the topmost dest row covered by it
+            u8* dest_line = dest + (y + 7) * dest_stride;
+            for (u32 x = rect.left; x < rect.right; x += 8) {
+                DecodeTile(line + (x / 8) * tile_size, info.format, dest_line + x * 4,
+                           -dest_stride);
+            }
+        }
+    };
+
+    const u32 tile_rows = (rect.top - rect.bottom) / 8;
+    const std::size_t num_tiles = static_cast<std::size_t>(tile_rows) * (rect.GetWidth() / 8);
+    const std::size_t num_threads =
+        std::min<std::size_t>({std::max(1u, std::thread::hardware_concurrency()),
+                               num_tiles / MIN_TILES_PER_THREAD, tile_rows});
+    if (num_threads <= 1) {
+        DecodeTileRows(rect.bottom, rect.top);
+        return;
+    }
+
+    const u32 rows_per_thread = static_cast<u32>((tile_rows + num_threads - 1) / num_threads);
+    const std::size_t num_chunks = (tile_rows + rows_per_thread - 1) / rows_per_thread;
+    Common::GetThreadPool().ParallelFor(num_chunks, num_threads, [&](std::size_t chunk) {
+        const u32 row = static_cast<u32>(chunk) * rows_per_thread;
+        const u32 end_row = std::min(row + rows_per_thread, tile_rows);
+        DecodeTileRows(rect.bottom + row * 8, rect.bottom + end_row * 8);
+    });
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
+#include "common/math_util.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
 
@@ -56,5 +58,31 @@ Math::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Math::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                  const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole 8x8 tile to RGBA8. The results are identical to calling LookupTexelInTile for
+ * every texel of the tile.
+ *
+ * @param source Pointer to the beginning of the tile.
+ * @param format Texture format of the tile.
+ * @param dest Pointer to where texel (0, 0) of the tile is written. Texels of a row are stored
+ *             4 bytes apart.
+ * @param dest_stride Distance in bytes from a row of texels to the next row. May be negative.
+ */
+void DecodeTile(const u8* source, TexturingRegs::TextureFormat format, u8* dest,
+                std::ptrdiff_t dest_stride);
+
+/**
+ * Decodes a tile aligned rectangle of a texture to RGBA8 using DecodeTile. Large rectangles are
+ * split across multiple threads.
+ *
+ * @param source Pointer to the beginning of the texture.
+ * @param info TextureInfo describing the texture.
+ * @param dest Buffer of info.width * info.height RGBA8 texels, laid out bottom to top as OpenGL
+ *             expects, i.e. the first row of dest is the last row of the texture.
+ * @param rect Rectangle to decode, in the coordinates of dest (top > bottom).
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dest,
+                   const MathUtil::Rectangle<u32>& rect);
+
 } // namespace Texture
 } // namespace Pica
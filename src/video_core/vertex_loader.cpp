@@ -6,13 +6,20 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 #include "video_core/shader/shader.h"
 #include "video_core/vertex_loader.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif
 #include "video_core/video_core.h"
 
 namespace Pica {
@@ -68,14 +75,65 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
+    SetupJit(regs);
+
     is_setup = true;
 }
 
+void VertexLoader::SetupJit(const PipelineRegs& regs) {
+#ifdef ARCHITECTURE_x86_64
+    // The compiled loaders are tied to the shader JIT setting so that disabling it gives a fully
+    // interpreted vertex path to compare against
+    if (!Settings::GetSnapshot().use_shader_jit || !Common::GetCPUCaps().sse4_1) {
+        return;
+    }
+
+    // Recording needs every memory access of the vertices, which only the C++ path reports
+    if (g_debug_context && g_debug_context->recorder) {
+        return;
+    }
+
+    const u32 base_address = regs.vertex_attributes.GetPhysicalBaseAddress();
+
+    VertexLoaderJit::Layout layout{};
+    layout.num_total_attributes = num_total_attributes;
+    for (int i = 0; i < num_total_attributes; ++i) {
+        VertexLoaderJit::Attribute& attribute = layout.attributes[i];
+        attribute.elements = vertex_attribute_elements[i];
+        attribute.is_default = vertex_attribute_is_default[i];
+        if (attribute.elements == 0) {
+            continue;
+        }
+
+        attribute.format = vertex_attribute_formats[i];
+        attribute.stride = vertex_attribute_strides[i];
+
+        // Like the hardware accelerated path, this assumes that each vertex array is contiguous
+        // in host memory
+        jit_sources[i] =
+            VideoCore::g_memory->GetPhysicalPointer(base_address + vertex_attribute_sources[i]);
+        if (jit_sources[i] == nullptr) {
+            return;
+        }
+    }
+
+    jit = &VertexLoaderJit::Get(layout);
+#endif
+}
+
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
                               DebugUtils::MemoryAccessTracker& memory_accesses) {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+#ifdef ARCHITECTURE_x86_64
+    if (jit != nullptr) {
+        jit->Load(jit_sources.data(), static_cast<u32>(vertex), input,
+                  g_state.input_default_attributes);
+        return;
+    }
+#endif
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
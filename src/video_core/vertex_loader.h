@@ -14,6 +14,8 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+class VertexLoaderJit;
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -30,6 +32,8 @@ public:
     }
 
 private:
+    void SetupJit(const PipelineRegs& regs);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -37,6 +41,11 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    /// Compiled loader of the layout, nullptr if vertices are loaded by the C++ path
+    const VertexLoaderJit* jit = nullptr;
+    /// Host pointers to the first vertex of each loaded attribute, used by the compiled loader
+    std::array<const u8*, 16> jit_sources{};
 };
 
 } // namespace Pica
@@ -0,0 +1,184 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <unordered_map>
+#include <xmmintrin.h>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/x64/xbyak_abi.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+namespace Pica {
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Xbyak::Reg32;
+using Xbyak::Reg64;
+using Xbyak::Xmm;
+
+using Format = PipelineRegs::VertexAttributeFormat;
+
+/// Memory allocated for each compiled loader, a vertex with 16 attributes needs well below 2KiB
+constexpr std::size_t MAX_LOADER_SIZE = 4096;
+
+/// Upper bound of cached loaders, the cache is flushed when it is reached
+constexpr std::size_t MAX_CACHED_LOADERS = 1024;
+
+static const Reg64 SOURCES = Reg64(ABI_PARAM1.getIdx());
+static const Reg32 VERTEX = Reg32(ABI_PARAM2.getIdx());
+static const Reg64 INPUT = Reg64(ABI_PARAM3.getIdx());
+static const Reg64 DEFAULTS = Reg64(ABI_PARAM4.getIdx());
+/// Address of the attribute being loaded, also used as a scratch register by the integer loads
+static const Reg64 ADDRESS = rax;
+static const Reg32 OFFSET32 = r10d;
+static const Reg64 OFFSET = r10;
+static const Reg32 SCRATCH32 = r11d;
+static const Xmm VALUE = xmm0;
+static const Xmm SCRATCH = xmm1;
+/// (0, 0, 0, 1), or'ed into attributes with less than 4 components
+static const Xmm W_ONE = xmm2;
+
+u64 VertexLoaderJit::Layout::Hash() const {
+    // Hash the fields one by one so that the padding of Attribute doesn't leak into the key
+    std::array<u32, 16 * 4 + 1> key{};
+    for (std::size_t i = 0; i < attributes.size(); ++i) {
+        key[i * 4 + 0] = attributes[i].elements;
+        key[i * 4 + 1] = static_cast<u32>(attributes[i].format);
+        key[i * 4 + 2] = attributes[i].stride;
+        key[i * 4 + 3] = attributes[i].is_default;
+    }
+    key.back() = static_cast<u32>(num_total_attributes);
+    return Common::ComputeHash64(key.data(), sizeof(key));
+}
+
+VertexLoaderJit::VertexLoaderJit(const Layout& layout) : Xbyak::CodeGenerator(MAX_LOADER_SIZE) {
+    static const __m128 w_one = {0.f, 0.f, 0.f, 1.f};
+    mov(ADDRESS, reinterpret_cast<std::size_t>(&w_one));
+    movaps(W_ONE, xword[ADDRESS]);
+
+    for (int i = 0; i < layout.num_total_attributes; ++i) {
+        const Attribute& attribute = layout.attributes[i];
+        if (attribute.elements != 0) {
+            CompileAttribute(i, attribute);
+        } else if (attribute.is_default) {
+            movaps(VALUE, xword[DEFAULTS + i * sizeof(Math::Vec4<float24>)]);
+            movaps(xword[INPUT + i * sizeof(Math::Vec4<float24>)], VALUE);
+        }
+        // Attributes that are neither loaded nor default keep their value, like in VertexLoader
+    }
+    ret();
+
+    ready();
+    program = getCode<CompiledLoader*>();
+    ASSERT_MSG(getSize() <= MAX_LOADER_SIZE, "Compiled a vertex loader that exceeds the buffer");
+}
+
+void VertexLoaderJit::CompileAttribute(int index, const Attribute& attribute) {
+    const u32 elements = attribute.elements;
+
+    mov(ADDRESS, qword[SOURCES + index * sizeof(const u8*)]);
+    imul(OFFSET32, VERTEX, attribute.stride);
+    add(ADDRESS, OFFSET);
+
+    // Only the bytes of the components are read, the sources may end right after the last one
+    switch (attribute.format) {
+    case Format::FLOAT:
+        switch (elements) {
+        case 1:
+            movss(VALUE, dword[ADDRESS]);
+            break;
+        case 2:
+            movq(VALUE, qword[ADDRESS]);
+            break;
+        case 3:
+            movq(VALUE, qword[ADDRESS]);
+            movss(SCRATCH, dword[ADDRESS + 8]);
+            movlhps(VALUE, SCRATCH);
+            break;
+        default:
+            movups(VALUE, xword[ADDRESS]);
+            break;
+        }
+        break;
+
+    case Format::BYTE:
+    case Format::UBYTE:
+        switch (elements) {
+        case 1:
+            movzx(eax, byte[ADDRESS]);
+            break;
+        case 2:
+            movzx(eax, word[ADDRESS]);
+            break;
+        case 3:
+            movzx(SCRATCH32, word[ADDRESS]);
+            movzx(eax, byte[ADDRESS + 2]);
+            shl(eax, 16);
+            or_(eax, SCRATCH32);
+            break;
+        default:
+            mov(eax, dword[ADDRESS]);
+            break;
+        }
+        movd(VALUE, eax);
+        if (attribute.format == Format::BYTE) {
+            pmovsxbd(VALUE, VALUE);
+        } else {
+            pmovzxbd(VALUE, VALUE);
+        }
+        cvtdq2ps(VALUE, VALUE);
+        break;
+
+    case Format::SHORT:
+        switch (elements) {
+        case 1:
+            movzx(eax, word[ADDRESS]);
+            movd(VALUE, eax);
+            break;
+        case 2:
+            movd(VALUE, dword[ADDRESS]);
+            break;
+        case 3:
+            movd(VALUE, dword[ADDRESS]);
+            movzx(eax, word[ADDRESS + 4]);
+            movd(SCRATCH, eax);
+            punpckldq(VALUE, SCRATCH);
+            break;
+        default:
+            movq(VALUE, qword[ADDRESS]);
+            break;
+        }
+        pmovsxwd(VALUE, VALUE);
+        cvtdq2ps(VALUE, VALUE);
+        break;
+    }
+
+    // The missing components were zeroed by the loads above, turn them into (0, 0, 0, 1)
+    if (elements < 4) {
+        orps(VALUE, W_ONE);
+    }
+
+    movaps(xword[INPUT + index * sizeof(Math::Vec4<float24>)], VALUE);
+}
+
+const VertexLoaderJit& VertexLoaderJit::Get(const Layout& layout) {
+    static std::unordered_map<u64, std::unique_ptr<VertexLoaderJit>> cache;
+
+    const u64 hash = layout.Hash();
+    auto iter = cache.find(hash);
+    if (iter != cache.end()) {
+        return *iter->second;
+    }
+
+    if (cache.size() >= MAX_CACHED_LOADERS) {
+        cache.clear();
+    }
+    auto& loader = cache[hash];
+    loader = std::make_unique<VertexLoaderJit>(layout);
+    return *loader;
+}
+
+} // namespace Pica
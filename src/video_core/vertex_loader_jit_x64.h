@@ -0,0 +1,67 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <xbyak.h>
+#include "common/common_types.h"
+#include "video_core/regs_pipeline.h"
+
+namespace Pica {
+
+namespace Shader {
+struct AttributeBuffer;
+}
+
+/**
+ * This class compiles the attribute layout of a VertexLoader into x86_64 code that converts all
+ * the attributes of a vertex at once, instead of going through the per-component loops of the
+ * C++ loader. Requires SSE4.1.
+ */
+class VertexLoaderJit : public Xbyak::CodeGenerator {
+public:
+    /// How a single attribute of the shader input is filled
+    struct Attribute {
+        /// Number of components loaded from the vertex arrays, 0 if the attribute is not loaded
+        u32 elements;
+        PipelineRegs::VertexAttributeFormat format;
+        u32 stride;
+        bool is_default;
+    };
+
+    struct Layout {
+        std::array<Attribute, 16> attributes;
+        int num_total_attributes;
+
+        u64 Hash() const;
+    };
+
+    explicit VertexLoaderJit(const Layout& layout);
+
+    /**
+     * Loads a vertex into the shader input
+     * @param sources host pointers to the first vertex of each loaded attribute
+     * @param vertex index of the vertex in the arrays
+     * @param input attribute buffer that receives the vertex
+     * @param defaults default attributes, copied for attributes that are not loaded
+     */
+    void Load(const u8* const* sources, u32 vertex, Shader::AttributeBuffer& input,
+              const Shader::AttributeBuffer& defaults) const {
+        program(sources, vertex, &input, &defaults);
+    }
+
+    /// Returns the compiled loader of a layout, compiling it if it isn't cached yet
+    static const VertexLoaderJit& Get(const Layout& layout);
+
+private:
+    void CompileAttribute(int index, const Attribute& attribute);
+
+    using CompiledLoader = void(const u8* const* sources, u32 vertex,
+                                Shader::AttributeBuffer* input,
+                                const Shader::AttributeBuffer* defaults);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
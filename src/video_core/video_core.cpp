@@ -5,9 +5,11 @@
 #include <memory>
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/shader/shader.h"
 #include "video_core/video_core.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,12 +19,6 @@ namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
-std::atomic<bool> g_hw_renderer_enabled;
-std::atomic<bool> g_shader_jit_enabled;
-std::atomic<bool> g_hw_shader_enabled;
-std::atomic<bool> g_hw_shader_accurate_gs;
-std::atomic<bool> g_hw_shader_accurate_mul;
-std::atomic<bool> g_renderer_bg_color_update_requested;
 // Screenshot
 std::atomic<bool> g_renderer_screenshot_requested;
 void* g_screenshot_bits;
@@ -42,6 +38,9 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
     if (result != Core::System::ResultStatus::Success) {
         LOG_ERROR(Render, "initialization failed !");
     } else {
+        if (Settings::values.use_gpu_thread && !Settings::values.deterministic) {
+            g_gpu_thread = std::make_unique<GPUThread>(emu_window);
+        }
         LOG_DEBUG(Render, "initialized OK");
     }
 
@@ -50,6 +49,9 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
 
 /// Shutdown the video core
 void Shutdown() {
+    // Finishes the queued work and hands the GL context back to this thread
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer.reset();
@@ -57,6 +59,11 @@ void Shutdown() {
     LOG_DEBUG(Render, "shutdown OK");
 }
 
+void LoadDiskResources(u64 title_id) {
+    Pica::Shader::LoadDiskCache(title_id);
+    g_renderer->Rasterizer()->LoadDiskResources(title_id);
+}
+
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout) {
     if (g_renderer_screenshot_requested) {
@@ -70,10 +77,11 @@ void RequestScreenshot(void* data, std::function<void()> callback,
 }
 
 u16 GetResolutionScaleFactor() {
-    if (g_hw_renderer_enabled) {
-        return !Settings::values.resolution_factor
+    const Settings::Snapshot& settings = Settings::GetSnapshot();
+    if (settings.use_hw_renderer) {
+        return !settings.resolution_factor
                    ? g_renderer->GetRenderWindow().GetFramebufferLayout().GetScalingRatio()
-                   : Settings::values.resolution_factor;
+                   : settings.resolution_factor;
     } else {
         // Software renderer always render at native resolution
         return 1;
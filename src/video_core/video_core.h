@@ -23,14 +23,6 @@ namespace VideoCore {
 
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
-// TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
-// qt ui)
-extern std::atomic<bool> g_hw_renderer_enabled;
-extern std::atomic<bool> g_shader_jit_enabled;
-extern std::atomic<bool> g_hw_shader_enabled;
-extern std::atomic<bool> g_hw_shader_accurate_gs;
-extern std::atomic<bool> g_hw_shader_accurate_mul;
-extern std::atomic<bool> g_renderer_bg_color_update_requested;
 // Screenshot
 extern std::atomic<bool> g_renderer_screenshot_requested;
 extern void* g_screenshot_bits;
@@ -45,6 +37,9 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
 /// Shutdown the video core
 void Shutdown();
 
+/// Loads the per-title shader caches of the shader JIT and of the renderer
+void LoadDiskResources(u64 title_id);
+
 /// Request a screenshot of the next frame
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout);
@@ -3,9 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <json.hpp>
-#include "common/detached_tasks.h"
 #include "common/web_result.h"
 #include "web_service/telemetry_json.h"
+#include "web_service/telemetry_uploader.h"
 #include "web_service/web_backend.h"
 
 namespace WebService {
@@ -105,11 +105,7 @@ void TelemetryJson::Complete() {
     impl->SerializeSection(Telemetry::FieldType::UserConfig, "UserConfig");
     impl->SerializeSection(Telemetry::FieldType::UserSystem, "UserSystem");
 
-    auto content = impl->TopSection().dump();
-    // Send the telemetry async but don't handle the errors since they were written to the log
-    Common::DetachedTasks::AddTask([host{impl->host}, content]() {
-        Client{host, "", ""}.PostJson("/telemetry", content, true);
-    });
+    TelemetryUploader::Submit(impl->host, impl->TopSection().dump());
 }
 
 bool TelemetryJson::SubmitTestcase() {
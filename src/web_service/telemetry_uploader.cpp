@@ -0,0 +1,184 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/detached_tasks.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/lz4_compression.h"
+#include "common/web_result.h"
+#include "web_service/telemetry_uploader.h"
+#include "web_service/web_backend.h"
+
+namespace WebService::TelemetryUploader {
+
+namespace {
+
+// "CTLM" - Citra TeLeMetry
+constexpr u32 REPORT_MAGIC = 0x4D4C5443;
+/// Reports kept on disk at most, the oldest are dropped beyond it
+constexpr std::size_t MAX_QUEUED_REPORTS = 32;
+/// Short, so that a report being sent at exit delays it by seconds at most
+constexpr std::size_t UPLOAD_TIMEOUT_SECONDS = 5;
+
+struct ReportHeader {
+    u32 magic;
+    u32 size;
+};
+static_assert(sizeof(ReportHeader) == 8, "ReportHeader has incorrect size");
+
+struct Queue {
+    std::mutex mutex;
+    std::vector<std::string> pending;
+    std::string host;
+    bool uploading = false;
+};
+
+Queue& GetQueue() {
+    static Queue queue;
+    return queue;
+}
+
+std::string GetQueueDir() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "telemetry" DIR_SEP;
+}
+
+void WriteReport(const std::string& content) {
+    static std::atomic<u32> sequence{0};
+
+    const std::string dir = GetQueueDir();
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(WebService, "Failed to create the telemetry queue directory {}", dir);
+        return;
+    }
+
+    // Named after the time of the report, so that sorting the names sorts the reports
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    const std::string path = fmt::format("{}{:016X}-{:08X}.bin", dir, now, sequence++);
+
+    const std::vector<u8> compressed = Common::LZ4::CompressBlock(
+        reinterpret_cast<const u8*>(content.data()), content.size());
+    const ReportHeader header{REPORT_MAGIC, static_cast<u32>(content.size())};
+    FileUtil::IOFile file(path, "wb");
+    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
+        file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_ERROR(WebService, "Failed to write the telemetry report {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
+bool ReadReport(const std::string& path, std::string& content) {
+    FileUtil::IOFile file(path, "rb");
+    ReportHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != REPORT_MAGIC) {
+        return false;
+    }
+    std::vector<u8> compressed(file.GetSize() - sizeof(header));
+    if (file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        return false;
+    }
+    content.resize(header.size);
+    return Common::LZ4::DecompressBlock(compressed.data(), compressed.size(),
+                                        reinterpret_cast<u8*>(content.data()), content.size());
+}
+
+std::vector<std::string> ListReports() {
+    std::vector<std::string> reports;
+    const std::string dir = GetQueueDir();
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, dir,
+        [&reports](u64*, const std::string& directory, const std::string& virtual_name) {
+            if (!FileUtil::IsDirectory(directory + virtual_name)) {
+                reports.push_back(directory + virtual_name);
+            }
+            return true;
+        });
+    std::sort(reports.begin(), reports.end());
+
+    if (reports.size() > MAX_QUEUED_REPORTS) {
+        const auto excess = reports.size() - MAX_QUEUED_REPORTS;
+        LOG_WARNING(WebService, "Dropping {} telemetry reports that couldn't be sent", excess);
+        std::for_each(reports.begin(), reports.begin() + excess, FileUtil::Delete);
+        reports.erase(reports.begin(), reports.begin() + excess);
+    }
+    return reports;
+}
+
+/// Posts the queued reports until one fails to go through the network
+void UploadReports(Client& client) {
+    for (const std::string& path : ListReports()) {
+        std::string content;
+        if (!ReadReport(path, content)) {
+            LOG_ERROR(WebService, "Dropping the malformed telemetry report {}", path);
+            FileUtil::Delete(path);
+            continue;
+        }
+
+        const Common::WebResult result = client.PostJson("/telemetry", content, true);
+        switch (result.result_code) {
+        case Common::WebResult::Code::Success:
+        case Common::WebResult::Code::WrongContent:
+            // The service took the report, whatever it replied
+            FileUtil::Delete(path);
+            break;
+        case Common::WebResult::Code::HttpError:
+            // Sending it again wouldn't help, the error was written to the log
+            FileUtil::Delete(path);
+            break;
+        default:
+            // Kept for the next upload
+            return;
+        }
+    }
+}
+
+void Upload() {
+    Queue& queue = GetQueue();
+    for (;;) {
+        std::vector<std::string> pending;
+        std::string host;
+        {
+            std::lock_guard lock{queue.mutex};
+            if (queue.pending.empty()) {
+                queue.uploading = false;
+                return;
+            }
+            pending.swap(queue.pending);
+            host = queue.host;
+        }
+
+        for (const std::string& content : pending) {
+            WriteReport(content);
+        }
+
+        // Anonymous, so no JWT request precedes the reports
+        Client client{host, "", "", UPLOAD_TIMEOUT_SECONDS};
+        UploadReports(client);
+    }
+}
+
+} // Anonymous namespace
+
+void Submit(std::string host, std::string content) {
+    Queue& queue = GetQueue();
+    std::lock_guard lock{queue.mutex};
+    queue.host = std::move(host);
+    queue.pending.push_back(std::move(content));
+    if (!queue.uploading) {
+        queue.uploading = true;
+        Common::DetachedTasks::AddTask(Upload);
+    }
+}
+
+} // namespace WebService::TelemetryUploader
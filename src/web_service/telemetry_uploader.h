@@ -0,0 +1,26 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+/**
+ * Uploads the telemetry reports of finished sessions in the background. Submitted reports are
+ * compressed into a queue directory and posted oldest first by a single detached task, which
+ * deletes each of them once the web service took it. Reports that can't be sent, because the
+ * network is down or the program is exiting, stay queued on disk and are sent along with the
+ * report of a later session.
+ */
+namespace WebService::TelemetryUploader {
+
+/**
+ * Queues a report for upload. Only takes a lock, the compression, the disk and the network are
+ * left to the upload task.
+ * @param host address of the web service
+ * @param content the serialized report
+ */
+void Submit(std::string host, std::string content);
+
+} // namespace WebService::TelemetryUploader
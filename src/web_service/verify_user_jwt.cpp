@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <iterator>
+#include <mutex>
 #include <system_error>
 #include <jwt/jwt.hpp>
+#include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/web_result.h"
 #include "web_service/verify_user_jwt.h"
@@ -11,8 +15,15 @@
 
 namespace WebService {
 
+/// How long a verified token is taken without checking it again
+constexpr std::chrono::minutes VERIFIED_TOKEN_TTL{5};
+/// Verified tokens kept at most, the expired ones are dropped beyond it
+constexpr std::size_t MAX_VERIFIED_TOKENS = 256;
+
 static std::string public_key;
+static std::mutex public_key_mutex;
 std::string GetPublicKey(const std::string& host) {
+    std::lock_guard<std::mutex> lock(public_key_mutex);
     if (public_key.empty()) {
         Client client(host, "", ""); // no need for credentials here
         public_key = client.GetPlain("/jwt/external/key.pem", true).returned_data;
@@ -29,6 +40,16 @@ VerifyUserJWT::VerifyUserJWT(const std::string& host) : pub_key(GetPublicKey(hos
 
 Network::VerifyUser::UserData VerifyUserJWT::LoadUserData(const std::string& verify_UID,
                                                           const std::string& token) {
+    const auto now = std::chrono::steady_clock::now();
+    const std::string cache_key = verify_UID + ':' + token;
+    {
+        std::lock_guard<std::mutex> lock(verified_tokens_mutex);
+        const auto cached = verified_tokens.find(cache_key);
+        if (cached != verified_tokens.end() && cached->second.expiry > now) {
+            return cached->second.user_data;
+        }
+    }
+
     const std::string audience = fmt::format("external-{}", verify_UID);
     using namespace jwt::params;
     std::error_code error;
@@ -54,6 +75,25 @@ Network::VerifyUser::UserData VerifyUserJWT::LoadUserData(const std::string& ver
         auto roles = decoded.payload().get_claim_value<std::vector<std::string>>("roles");
         user_data.moderator = std::find(roles.begin(), roles.end(), "moderator") != roles.end();
     }
+
+    // Not past the expiration of the token itself
+    auto ttl = std::chrono::duration_cast<std::chrono::steady_clock::duration>(VERIFIED_TOKEN_TTL);
+    if (decoded.payload().has_claim("exp")) {
+        const auto expiration = std::chrono::system_clock::time_point{
+            std::chrono::seconds{decoded.payload().get_claim_value<u64>("exp")}};
+        ttl = std::min(ttl, std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                expiration - std::chrono::system_clock::now()));
+    }
+
+    std::lock_guard<std::mutex> lock(verified_tokens_mutex);
+    if (verified_tokens.size() >= MAX_VERIFIED_TOKENS) {
+        for (auto it = verified_tokens.begin(); it != verified_tokens.end();) {
+            it = it->second.expiry <= now ? verified_tokens.erase(it) : std::next(it);
+        }
+    }
+    if (ttl.count() > 0 && verified_tokens.size() < MAX_VERIFIED_TOKENS) {
+        verified_tokens[cache_key] = {user_data, now + ttl};
+    }
     return user_data;
 }
 
@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <fmt/format.h>
 #include "network/verify_user.h"
 #include "web_service/web_backend.h"
@@ -19,7 +23,17 @@ public:
                                                const std::string& token) override;
 
 private:
+    struct VerifiedToken {
+        Network::VerifyUser::UserData user_data;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
     std::string pub_key;
+
+    /// Tokens verified recently by verification GUID and token, so that clients reconnecting with
+    /// the same token aren't decoded and checked against the key again
+    std::unordered_map<std::string, VerifiedToken> verified_tokens;
+    std::mutex verified_tokens_mutex;
 };
 
 } // namespace WebService
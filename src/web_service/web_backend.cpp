@@ -21,11 +21,10 @@ constexpr std::array<const char, 1> API_VERSION{'1'};
 constexpr int HTTP_PORT = 80;
 constexpr int HTTPS_PORT = 443;
 
-constexpr std::size_t TIMEOUT_SECONDS = 30;
-
 struct Client::Impl {
-    Impl(std::string host, std::string username, std::string token)
-        : host{std::move(host)}, username{std::move(username)}, token{std::move(token)} {
+    Impl(std::string host, std::string username, std::string token, std::size_t timeout_seconds)
+        : host{std::move(host)}, username{std::move(username)}, token{std::move(token)},
+          timeout_seconds{timeout_seconds} {
         std::lock_guard<std::mutex> lock(jwt_cache.mutex);
         if (this->username == jwt_cache.username && this->token == jwt_cache.token) {
             jwt = jwt_cache.jwt;
@@ -74,13 +73,13 @@ struct Client::Impl {
                     port = HTTP_PORT;
                 }
                 cli = std::make_unique<httplib::Client>(parsedUrl.m_Host.c_str(), port,
-                                                        TIMEOUT_SECONDS);
+                                                        timeout_seconds);
             } else if (parsedUrl.m_Scheme == "https") {
                 if (!parsedUrl.GetPort(&port)) {
                     port = HTTPS_PORT;
                 }
                 cli = std::make_unique<httplib::SSLClient>(parsedUrl.m_Host.c_str(), port,
-                                                           TIMEOUT_SECONDS);
+                                                           timeout_seconds);
             } else {
                 LOG_ERROR(WebService, "Bad URL scheme {}", parsedUrl.m_Scheme);
                 return Common::WebResult{Common::WebResult::Code::InvalidURL, "Bad URL scheme"};
@@ -165,6 +164,7 @@ struct Client::Impl {
     std::string username;
     std::string token;
     std::string jwt;
+    std::size_t timeout_seconds;
     std::unique_ptr<httplib::Client> cli;
 
     struct JWTCache {
@@ -176,8 +176,10 @@ struct Client::Impl {
     static inline JWTCache jwt_cache;
 };
 
-Client::Client(std::string host, std::string username, std::string token)
-    : impl{std::make_unique<Impl>(std::move(host), std::move(username), std::move(token))} {}
+Client::Client(std::string host, std::string username, std::string token,
+               std::size_t timeout_seconds)
+    : impl{std::make_unique<Impl>(std::move(host), std::move(username), std::move(token),
+                                  timeout_seconds)} {}
 
 Client::~Client() = default;
 
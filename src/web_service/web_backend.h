@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -15,7 +16,11 @@ namespace WebService {
 
 class Client {
 public:
-    Client(std::string host, std::string username, std::string token);
+    /// Default timeout of the requests, in seconds
+    static constexpr std::size_t DEFAULT_TIMEOUT_SECONDS = 30;
+
+    Client(std::string host, std::string username, std::string token,
+           std::size_t timeout_seconds = DEFAULT_TIMEOUT_SECONDS);
     ~Client();
 
     /**